@@ -0,0 +1,79 @@
+# Copyright (C) 2007-2015 Hypertable, Inc.
+#
+# This file is part of Hypertable.
+#
+# Hypertable is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 3
+# of the License, or any later version.
+#
+# Hypertable is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with Hypertable. If not, see <http://www.gnu.org/licenses/>
+#
+
+# - Find Zstd
+# Find the zstd compression library and includes
+#
+#  ZSTD_INCLUDE_DIR - where to find zstd.h, etc.
+#  ZSTD_LIBRARIES   - List of libraries when using zstd.
+#  ZSTD_FOUND       - True if zstd found.
+
+find_path(ZSTD_INCLUDE_DIR zstd.h NO_DEFAULT_PATH PATHS
+  ${HT_DEPENDENCY_INCLUDE_DIR}
+  /usr/include
+  /opt/local/include
+  /usr/local/include
+)
+
+set(ZSTD_NAMES ${ZSTD_NAMES} zstd)
+find_library(ZSTD_LIBRARY NAMES ${ZSTD_NAMES} NO_DEFAULT_PATH PATHS
+    ${HT_DEPENDENCY_LIB_DIR}
+    /usr/local/lib
+    /opt/local/lib
+    /usr/lib
+    )
+
+if (ZSTD_INCLUDE_DIR AND ZSTD_LIBRARY)
+  set(ZSTD_FOUND TRUE)
+  set( ZSTD_LIBRARIES ${ZSTD_LIBRARY} )
+else ()
+  set(ZSTD_FOUND FALSE)
+  set( ZSTD_LIBRARIES )
+endif ()
+
+if (ZSTD_FOUND)
+  message(STATUS "Found Zstd: ${ZSTD_LIBRARY}")
+  try_run(ZSTD_CHECK ZSTD_CHECK_BUILD
+          ${HYPERTABLE_BINARY_DIR}${CMAKE_FILES_DIRECTORY}/CMakeTmp
+          ${HYPERTABLE_SOURCE_DIR}/cmake/CheckZstd.cc
+          CMAKE_FLAGS -DINCLUDE_DIRECTORIES=${ZSTD_INCLUDE_DIR}
+                      -DLINK_LIBRARIES=${ZSTD_LIBRARIES}
+          OUTPUT_VARIABLE ZSTD_TRY_OUT)
+  if (ZSTD_CHECK_BUILD AND NOT ZSTD_CHECK STREQUAL "0")
+    string(REGEX REPLACE ".*\n(ZSTD .*)" "\\1" ZSTD_TRY_OUT ${ZSTD_TRY_OUT})
+    message(STATUS "${ZSTD_TRY_OUT}")
+    message(FATAL_ERROR "Please fix the Zstd installation and try again.")
+    set(ZSTD_LIBRARIES)
+  endif ()
+  string(REGEX REPLACE ".*\n([0-9]+[^\n]+).*" "\\1" ZSTD_VERSION ${ZSTD_TRY_OUT})
+  if (NOT ZSTD_VERSION MATCHES "^[0-9]+.*")
+    set(ZSTD_VERSION "unknown") 
+  endif ()
+  message(STATUS "       version: ${ZSTD_VERSION}")
+else ()
+  message(STATUS "Not Found Zstd: ${ZSTD_LIBRARY}")
+  if (ZSTD_FIND_REQUIRED)
+    message(STATUS "Looked for Zstd libraries named ${ZSTD_NAMES}.")
+    message(FATAL_ERROR "Could NOT find Zstd library")
+  endif ()
+endif ()
+
+mark_as_advanced(
+  ZSTD_LIBRARY
+  ZSTD_INCLUDE_DIR
+  )
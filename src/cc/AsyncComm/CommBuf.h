@@ -41,6 +41,9 @@
 
 #include <memory>
 #include <string>
+#include <vector>
+
+#include <sys/uio.h>
 
 namespace Hypertable {
 
@@ -52,7 +55,10 @@ namespace Hypertable {
    * The CommBuf class contains a primary buffer and an extended buffer along
    * with buffer pointers to keep track of how much data has been written into
    * the buffers. These pointers are managed by the IOHandler while the buffer
-   * is being transmitted. The following example illustrates how to build a
+   * is being transmitted.  Large payloads that already live in memory owned
+   * by someone else can be appended as segments with append_segment(), in
+   * which case they are handed to <code>writev</code> without being copied.
+   * The following example illustrates how to build a
    * request message using the CommBuf.  
    *
    * <pre>
@@ -149,8 +155,41 @@ namespace Hypertable {
       header.encode(&buf);
       data_ptr = data.base;
       ext_ptr = ext.base;
+      segment_index = 0;
+      segment_offset = 0;
+    }
+
+    /** Appends a reference to externally owned memory.
+     * The memory is transmitted, without being copied, after the primary and
+     * extended buffers and any previously appended segments.  The caller must
+     * keep the memory valid until the CommBuf is destroyed, typically by
+     * registering the owner with add_hold().  The total length in the header
+     * is increased by <code>len</code>.
+     * @param base Pointer to beginning of segment
+     * @param len Length of segment
+     */
+    void append_segment(const void *base, size_t len) {
+      if (len == 0)
+        return;
+      iovec vec;
+      vec.iov_base = const_cast<void *>(base);
+      vec.iov_len = len;
+      segments.push_back(vec);
+      header.set_total_length(header.total_len + len);
+    }
+
+    /** Keeps an object alive for the lifetime of the CommBuf.
+     * Used to pin memory referenced by segments added with append_segment().
+     * @param hold Object to hold
+     */
+    void add_hold(std::shared_ptr<void> hold) {
+      holds.push_back(hold);
     }
 
+    /** Returns the number of segments added with append_segment()
+     */
+    size_t segment_count() const { return segments.size(); }
+
     /** Returns the primary buffer internal data pointer
      */
     void *get_data_ptr() { return data_ptr; }
@@ -282,6 +321,78 @@ namespace Hypertable {
       Serialization::encode_inet_addr(&data_ptr, addr);
     }
 
+    /** Fills an iovec array with the data remaining to be sent.
+     * @param vec iovec array to fill
+     * @param max Number of entries in <code>vec</code> (at least three)
+     * @param towrite Address of variable to hold number of bytes referenced
+     * by the filled entries
+     * @return Number of entries filled
+     */
+    int fill_iovec(iovec *vec, int max, ssize_t *towrite) {
+      ssize_t remaining;
+      int count = 0;
+      *towrite = 0;
+      remaining = data.size - (data_ptr - data.base);
+      if (remaining > 0) {
+        vec[count].iov_base = (void *)data_ptr;
+        vec[count].iov_len = remaining;
+        *towrite += remaining;
+        ++count;
+      }
+      if (ext.base != 0) {
+        remaining = ext.size - (ext_ptr - ext.base);
+        if (remaining > 0) {
+          vec[count].iov_base = (void *)ext_ptr;
+          vec[count].iov_len = remaining;
+          *towrite += remaining;
+          ++count;
+        }
+      }
+      for (size_t i=segment_index; i<segments.size() && count<max; i++) {
+        size_t offset = (i == segment_index) ? segment_offset : 0;
+        vec[count].iov_base = (uint8_t *)segments[i].iov_base + offset;
+        vec[count].iov_len = segments[i].iov_len - offset;
+        *towrite += vec[count].iov_len;
+        ++count;
+      }
+      return count;
+    }
+
+    /** Advances the send pointers past data that has been written.
+     * @param nwritten Number of bytes written
+     * @return <i>true</i> if the entire message has been written,
+     * <i>false</i> otherwise
+     */
+    bool advance(size_t nwritten) {
+      size_t remaining = data.size - (data_ptr - data.base);
+      if (nwritten < remaining) {
+        data_ptr += nwritten;
+        return false;
+      }
+      data_ptr += remaining;
+      nwritten -= remaining;
+      if (ext.base != 0) {
+        remaining = ext.size - (ext_ptr - ext.base);
+        if (nwritten < remaining) {
+          ext_ptr += nwritten;
+          return false;
+        }
+        ext_ptr += remaining;
+        nwritten -= remaining;
+      }
+      while (segment_index < segments.size()) {
+        remaining = segments[segment_index].iov_len - segment_offset;
+        if (nwritten < remaining) {
+          segment_offset += nwritten;
+          return false;
+        }
+        nwritten -= remaining;
+        segment_index++;
+        segment_offset = 0;
+      }
+      return true;
+    }
+
     friend class IOHandlerData;
     friend class IOHandlerDatagram;
 
@@ -299,6 +410,18 @@ namespace Hypertable {
 
     /// Smart pointer to extended buffer memory
     boost::shared_array<uint8_t> ext_shared_array;
+
+    /// Segments of externally owned memory sent after #ext
+    std::vector<iovec> segments;
+
+    /// Index of next segment to be sent
+    size_t segment_index {};
+
+    /// Offset into next segment to be sent
+    size_t segment_offset {};
+
+    /// Objects pinning memory referenced by #segments
+    std::vector<std::shared_ptr<void>> holds;
   };
 
   /// Smart pointer to CommBuf
@@ -92,6 +92,9 @@ namespace {
     return n - nleft;
   }
 
+  /// Maximum number of iovec entries passed to a single writev call
+  const int SEND_IOVEC_MAX = 64;
+
   ssize_t
   et_socket_writev(int fd, const iovec *vector, int count, int *errnop) {
     ssize_t nwritten;
@@ -788,8 +791,8 @@ IOHandlerData::send_message(CommBufPtr &cbp, uint32_t timeout_ms,
 #if defined(__linux__)
 
 int IOHandlerData::flush_send_queue() {
-  ssize_t nwritten, towrite, remaining;
-  struct iovec vec[2];
+  ssize_t nwritten, towrite;
+  struct iovec vec[SEND_IOVEC_MAX];
   int count;
   int error = 0;
 
@@ -797,24 +800,7 @@ int IOHandlerData::flush_send_queue() {
 
     CommBufPtr &cbp = m_send_queue.front();
 
-    count = 0;
-    towrite = 0;
-    remaining = cbp->data.size - (cbp->data_ptr - cbp->data.base);
-    if (remaining > 0) {
-      vec[0].iov_base = (void *)cbp->data_ptr;
-      vec[0].iov_len = remaining;
-      towrite = remaining;
-      ++count;
-    }
-    if (cbp->ext.base != 0) {
-      remaining = cbp->ext.size - (cbp->ext_ptr - cbp->ext.base);
-      if (remaining > 0) {
-        vec[count].iov_base = (void *)cbp->ext_ptr;
-        vec[count].iov_len = remaining;
-        towrite += remaining;
-        ++count;
-      }
-    }
+    count = cbp->fill_iovec(vec, SEND_IOVEC_MAX, &towrite);
 
     nwritten = et_socket_writev(m_sd, vec, count, &error);
     if (nwritten == (ssize_t)-1) {
@@ -837,29 +823,17 @@ int IOHandlerData::flush_send_queue() {
         }
         continue;
       }
-      remaining = cbp->data.size - (cbp->data_ptr - cbp->data.base);
-      if (remaining > 0) {
-        if (nwritten < remaining) {
-          cbp->data_ptr += nwritten;
-          if (error == EAGAIN)
-            break;
-          error = 0;
-          continue;
-        }
-        else {
-          nwritten -= remaining;
-          cbp->data_ptr += remaining;
-        }
-      }
-      if (cbp->ext.base != 0) {
-        cbp->ext_ptr += nwritten;
-        if (error == EAGAIN)
-          break;
-        error = 0;
-        continue;
-      }
+      cbp->advance(nwritten);
+      if (error == EAGAIN)
+        break;
+      error = 0;
+      continue;
     }
 
+    // More segments than fit in one writev call
+    if (!cbp->advance(nwritten))
+      continue;
+
     // buffer written successfully, now remove from queue (destroys buffer)
     m_send_queue.pop_front();
   }
@@ -870,32 +844,15 @@ int IOHandlerData::flush_send_queue() {
 #elif defined(__APPLE__) || defined (__sun__) || defined(__FreeBSD__)
 
 int IOHandlerData::flush_send_queue() {
-  ssize_t nwritten, towrite, remaining;
-  struct iovec vec[2];
+  ssize_t nwritten, towrite;
+  struct iovec vec[SEND_IOVEC_MAX];
   int count;
 
   while (!m_send_queue.empty()) {
 
     CommBufPtr &cbp = m_send_queue.front();
 
-    count = 0;
-    towrite = 0;
-    remaining = cbp->data.size - (cbp->data_ptr - cbp->data.base);
-    if (remaining > 0) {
-      vec[0].iov_base = (void *)cbp->data_ptr;
-      vec[0].iov_len = remaining;
-      towrite = remaining;
-      ++count;
-    }
-    if (cbp->ext.base != 0) {
-      remaining = cbp->ext.size - (cbp->ext_ptr - cbp->ext.base);
-      if (remaining > 0) {
-        vec[count].iov_base = (void *)cbp->ext_ptr;
-        vec[count].iov_len = remaining;
-        towrite += remaining;
-        ++count;
-      }
-    }
+    count = cbp->fill_iovec(vec, SEND_IOVEC_MAX, &towrite);
 
     nwritten = FileUtils::writev(m_sd, vec, count);
     if (nwritten == (ssize_t)-1) {
@@ -907,23 +864,14 @@ int IOHandlerData::flush_send_queue() {
     else if (nwritten < towrite) {
       if (nwritten == 0)
         break;
-      remaining = cbp->data.size - (cbp->data_ptr - cbp->data.base);
-      if (remaining > 0) {
-        if (nwritten < remaining) {
-          cbp->data_ptr += nwritten;
-          break;
-        }
-        else {
-          nwritten -= remaining;
-          cbp->data_ptr += remaining;
-        }
-      }
-      if (cbp->ext.base != 0) {
-        cbp->ext_ptr += nwritten;
-        break;
-      }
+      cbp->advance(nwritten);
+      break;
     }
 
+    // More segments than fit in one writev call
+    if (!cbp->advance(nwritten))
+      continue;
+
     // buffer written successfully, now remove from queue (destroys buffer)
     m_send_queue.pop_front();
   }
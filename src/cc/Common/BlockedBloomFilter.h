@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+/** @file
+ * Cache-line blocked bloom filter probing.
+ * Helpers shared by BasicBloomFilter and BasicBloomFilterWithChecksum for
+ * the blocked bit layout, in which all of a key's bits fall into a single
+ * 64-byte block selected by one 64-bit hash.
+ */
+
+#ifndef HYPERTABLE_BLOCKED_BLOOM_FILTER_H
+#define HYPERTABLE_BLOCKED_BLOOM_FILTER_H
+
+#include "Common/MurmurHash.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Hypertable {
+
+/** @addtogroup Common
+ *  @{
+ */
+
+/** Bit layout of a bloom filter. */
+enum BloomFilterLayout {
+  /** Each of the k bits is a separate MurmurHash2 modulo the whole array */
+  BLOOM_FILTER_LAYOUT_CLASSIC = 0,
+  /** All k bits fall in one cache line chosen by a single 64-bit hash */
+  BLOOM_FILTER_LAYOUT_BLOCKED = 1
+};
+
+/**
+ * Probing for the blocked bloom filter layout.
+ * The bit array is divided into 512-bit (64-byte) blocks.  The upper half of
+ * a 64-bit MurmurHash64A selects the block and the lower half seeds a
+ * double-hashing sequence that picks the k bits inside it, so a lookup
+ * costs one hash computation and touches one cache line regardless of k.
+ * Bits are addressed byte-wise, so the serialized form is independent of
+ * host endianness.
+ */
+struct BlockedBloomFilter {
+
+  /** Number of bits in a block */
+  static const size_t BLOCK_BITS = 512;
+
+  /** Rounds a bit count up to a whole number of blocks.
+   *
+   * @param num_bits Requested number of bits
+   * @return <code>num_bits</code> rounded up to a multiple of #BLOCK_BITS
+   */
+  static size_t round_bits(size_t num_bits) {
+    return ((num_bits + BLOCK_BITS - 1) / BLOCK_BITS) * BLOCK_BITS;
+  }
+
+  /** Computes the single hash used to probe a key.
+   *
+   * @param key Pointer to the key's data
+   * @param len Size of the data (in bytes)
+   * @return 64-bit hash of the key
+   */
+  static uint64_t hash(const void *key, size_t len) {
+    return murmurhash64a(key, len, len);
+  }
+
+  /** Sets the bits for a hash.
+   *
+   * @param bits Bit array
+   * @param num_bits Size of bit array in bits (multiple of #BLOCK_BITS)
+   * @param num_hashes Number of bits to set
+   * @param hash Hash computed with hash()
+   */
+  static void insert(uint8_t *bits, size_t num_bits, size_t num_hashes,
+                     uint64_t hash) {
+    uint8_t *block = bits + block_offset(num_bits, hash);
+    uint32_t h = (uint32_t)hash;
+    uint32_t delta = step(hash);
+    for (size_t i = 0; i < num_hashes; ++i, h += delta)
+      block[(h >> 23) >> 3] |= (uint8_t)(1 << ((h >> 23) & 7));
+  }
+
+  /** Checks whether all bits for a hash are set.
+   *
+   * @param bits Bit array
+   * @param num_bits Size of bit array in bits (multiple of #BLOCK_BITS)
+   * @param num_hashes Number of bits to check
+   * @param hash Hash computed with hash()
+   * @return <i>false</i> if the key is definitely not present
+   */
+  static bool may_contain(const uint8_t *bits, size_t num_bits,
+                          size_t num_hashes, uint64_t hash) {
+    const uint8_t *block = bits + block_offset(num_bits, hash);
+    uint32_t h = (uint32_t)hash;
+    uint32_t delta = step(hash);
+    for (size_t i = 0; i < num_hashes; ++i, h += delta) {
+      if ((block[(h >> 23) >> 3] & (1 << ((h >> 23) & 7))) == 0)
+        return false;
+    }
+    return true;
+  }
+
+private:
+
+  /** Byte offset of the block selected by a hash (multiply-shift range
+   * reduction of the upper 32 bits, avoiding a division). */
+  static size_t block_offset(size_t num_bits, uint64_t hash) {
+    uint64_t num_blocks = num_bits / BLOCK_BITS;
+    return (size_t)(((hash >> 32) * num_blocks) >> 32) * (BLOCK_BITS / 8);
+  }
+
+  /** Odd increment for the in-block probe sequence; each probe uses the
+   * top 9 bits of the running 32-bit value as the bit index. */
+  static uint32_t step(uint64_t hash) {
+    return ((uint32_t)(hash >> 32) * 0x9e3779b1U) | 1;
+  }
+};
+
+/** @}*/
+
+} //namespace Hypertable
+
+#endif // HYPERTABLE_BLOCKED_BLOOM_FILTER_H
@@ -31,6 +31,7 @@
 
 #include <cmath>
 #include <limits.h>
+#include "Common/BlockedBloomFilter.h"
 #include "Common/StaticBuffer.h"
 #include "Common/MurmurHash.h"
 #include "Common/Logger.h"
@@ -54,8 +55,11 @@ public:
    *
    * @param items_estimate An estimated number of items that will be inserted
    * @param false_positive_prob The probability for false positives
+   * @param layout Bit layout
    */
-  BasicBloomFilter(size_t items_estimate, float false_positive_prob) {
+  BasicBloomFilter(size_t items_estimate, float false_positive_prob,
+          BloomFilterLayout layout = BLOOM_FILTER_LAYOUT_CLASSIC) {
+    m_layout = layout;
     m_items_actual = 0;
     m_items_estimate = items_estimate;
     m_false_positive_prob = false_positive_prob;
@@ -67,6 +71,8 @@ public:
               "Num elements=%lu false_positive_prob=%.3f",
               (Lu)items_estimate, false_positive_prob);
     }
+    if (m_layout == BLOOM_FILTER_LAYOUT_BLOCKED)
+      m_num_bits = BlockedBloomFilter::round_bits(m_num_bits);
     m_num_bytes = (m_num_bits / CHAR_BIT) + (m_num_bits % CHAR_BIT ? 1 : 0);
     m_bloom_bits = new uint8_t[m_num_bytes];
 
@@ -84,9 +90,12 @@ public:
    * @param items_estimate An estimated number of items that will be inserted
    * @param bits_per_item Average bits per item
    * @param num_hashes Number of hash functions for the filter
+   * @param layout Bit layout
    */
   BasicBloomFilter(size_t items_estimate, float bits_per_item,
-          size_t num_hashes) {
+          size_t num_hashes,
+          BloomFilterLayout layout = BLOOM_FILTER_LAYOUT_CLASSIC) {
+    m_layout = layout;
     m_items_actual = 0;
     m_items_estimate = items_estimate;
     m_false_positive_prob = 0.0;
@@ -96,6 +105,8 @@ public:
       HT_THROWF(Error::EMPTY_BLOOMFILTER, "Num elements=%lu bits_per_item=%.3f",
                 (Lu)items_estimate, bits_per_item);
     }
+    if (m_layout == BLOOM_FILTER_LAYOUT_BLOCKED)
+      m_num_bits = BlockedBloomFilter::round_bits(m_num_bits);
     m_num_bytes = (m_num_bits / CHAR_BIT) + (m_num_bits % CHAR_BIT ? 1 : 0);
     m_bloom_bits = new uint8_t[m_num_bytes];
 
@@ -113,9 +124,12 @@ public:
    * @param items_actual Actual number of items
    * @param length Number of bits
    * @param num_hashes Number of hash functions for the filter
+   * @param layout Bit layout
    */
   BasicBloomFilter(size_t items_estimate, size_t items_actual,
-          int64_t length, size_t num_hashes) {
+          int64_t length, size_t num_hashes,
+          BloomFilterLayout layout = BLOOM_FILTER_LAYOUT_CLASSIC) {
+    m_layout = layout;
     m_items_actual = items_actual;
     m_items_estimate = items_estimate;
     m_false_positive_prob = 0.0;
@@ -127,6 +141,8 @@ public:
               (Lu)items_estimate, (Lu)items_actual, (Lld)length,
               (Lu)num_hashes);
     }
+    if (m_layout == BLOOM_FILTER_LAYOUT_BLOCKED)
+      m_num_bits = BlockedBloomFilter::round_bits(m_num_bits);
     m_num_bytes = (m_num_bits / CHAR_BIT) + (m_num_bits % CHAR_BIT ? 1 : 0);
     m_bloom_bits = new uint8_t[m_num_bytes];
 
@@ -157,6 +173,13 @@ public:
    * @param len Size of the data (in bytes)
    */
   void insert(const void *key, size_t len) {
+    if (m_layout == BLOOM_FILTER_LAYOUT_BLOCKED) {
+      BlockedBloomFilter::insert(m_bloom_bits, m_num_bits, m_num_hash_functions,
+                                 BlockedBloomFilter::hash(key, len));
+      m_items_actual++;
+      return;
+    }
+
     uint32_t hash = len;
 
     for (size_t i = 0; i < m_num_hash_functions; ++i) {
@@ -186,6 +209,11 @@ public:
    * @return true if the key "may" be contained, otherwise false
    */
   bool may_contain(const void *key, size_t len) const {
+    if (m_layout == BLOOM_FILTER_LAYOUT_BLOCKED)
+      return BlockedBloomFilter::may_contain(m_bloom_bits, m_num_bits,
+                                             m_num_hash_functions,
+                                             BlockedBloomFilter::hash(key, len));
+
     uint32_t hash = len;
     uint8_t byte_mask;
     uint8_t byte;
@@ -243,6 +271,12 @@ public:
    */
   size_t get_length_bits() { return m_num_bits; }
 
+  /** Getter for the bit layout
+   *
+   * @return The bit layout
+   */
+  BloomFilterLayout get_layout() { return m_layout; }
+
   /** Getter for the estimated number of items
    *
    * @return The estimated number of items
@@ -279,6 +313,9 @@ private:
 
   /** The actual bloom filter bit-array */
   uint8_t   *m_bloom_bits;
+
+  /** Bit layout */
+  BloomFilterLayout m_layout;
 };
 
 typedef BasicBloomFilter<> BloomFilter;
@@ -31,6 +31,7 @@
 
 #include <cmath>
 #include <limits.h>
+#include "Common/BlockedBloomFilter.h"
 #include "Common/Checksum.h"
 #include "Common/Filesystem.h"
 #include "Common/Logger.h"
@@ -58,9 +59,12 @@ public:
    *
    * @param items_estimate An estimated number of items that will be inserted
    * @param false_positive_prob The probability for false positives
+   * @param layout Bit layout
    */
   BasicBloomFilterWithChecksum(size_t items_estimate,
-          float false_positive_prob) {
+          float false_positive_prob,
+          BloomFilterLayout layout = BLOOM_FILTER_LAYOUT_CLASSIC) {
+    m_layout = layout;
     m_items_actual = 0;
     m_items_estimate = items_estimate;
     m_false_positive_prob = false_positive_prob;
@@ -72,10 +76,10 @@ public:
               "Num elements=%lu false_positive_prob=%.3f",
               (Lu)items_estimate, false_positive_prob);
     }
+    if (m_layout == BLOOM_FILTER_LAYOUT_BLOCKED)
+      m_num_bits = BlockedBloomFilter::round_bits(m_num_bits);
     m_num_bytes = (m_num_bits / CHAR_BIT) + (m_num_bits % CHAR_BIT ? 1 : 0);
-    m_bloom_base = new uint8_t[total_size()];
-    m_bloom_bits = m_bloom_base + 4;
-    memset(m_bloom_base, 0, total_size());
+    allocate();
 
     HT_DEBUG_OUT << "num funcs=" << m_num_hash_functions << " num bits="
         << m_num_bits << " num bytes= " << m_num_bytes << " bits per element="
@@ -88,9 +92,12 @@ public:
    * @param items_estimate An estimated number of items that will be inserted
    * @param bits_per_item Average bits per item
    * @param num_hashes Number of hash functions for the filter
+   * @param layout Bit layout
    */
   BasicBloomFilterWithChecksum(size_t items_estimate, float bits_per_item,
-          size_t num_hashes) {
+          size_t num_hashes,
+          BloomFilterLayout layout = BLOOM_FILTER_LAYOUT_CLASSIC) {
+    m_layout = layout;
     m_items_actual = 0;
     m_items_estimate = items_estimate;
     m_false_positive_prob = 0.0;
@@ -100,10 +107,10 @@ public:
       HT_THROWF(Error::EMPTY_BLOOMFILTER, "Num elements=%lu bits_per_item=%.3f",
               (Lu)items_estimate, bits_per_item);
     }
+    if (m_layout == BLOOM_FILTER_LAYOUT_BLOCKED)
+      m_num_bits = BlockedBloomFilter::round_bits(m_num_bits);
     m_num_bytes = (m_num_bits / CHAR_BIT) + (m_num_bits % CHAR_BIT ? 1 : 0);
-    m_bloom_base = new uint8_t[total_size()];
-    m_bloom_bits = m_bloom_base + 4;
-    memset(m_bloom_base, 0, total_size());
+    allocate();
 
     HT_DEBUG_OUT << "num funcs=" << m_num_hash_functions << " num bits="
         << m_num_bits << " num bytes=" << m_num_bytes << " bits per element="
@@ -117,9 +124,12 @@ public:
    * @param items_actual Actual number of items
    * @param length Number of bits
    * @param num_hashes Number of hash functions for the filter
+   * @param layout Bit layout
    */
   BasicBloomFilterWithChecksum(size_t items_estimate, size_t items_actual,
-          int64_t length, size_t num_hashes) {
+          int64_t length, size_t num_hashes,
+          BloomFilterLayout layout = BLOOM_FILTER_LAYOUT_CLASSIC) {
+    m_layout = layout;
     m_items_actual = items_actual;
     m_items_estimate = items_estimate;
     m_false_positive_prob = 0.0;
@@ -130,10 +140,10 @@ public:
               "Estimated items=%lu actual items=%lu length=%lld num hashes=%lu",
               (Lu)items_estimate, (Lu)items_actual, (Lld)length, (Lu)num_hashes);
     }
+    if (m_layout == BLOOM_FILTER_LAYOUT_BLOCKED)
+      m_num_bits = BlockedBloomFilter::round_bits(m_num_bits);
     m_num_bytes = (m_num_bits / CHAR_BIT) + (m_num_bits % CHAR_BIT ? 1 : 0);
-    m_bloom_base = new uint8_t[total_size()];
-    m_bloom_bits = m_bloom_base + 4;
-    memset(m_bloom_base, 0, total_size());
+    allocate();
 
     HT_DEBUG_OUT << "num funcs=" << m_num_hash_functions << " num bits="
         << m_num_bits << " num bytes=" << m_num_bytes << " bits per element="
@@ -142,7 +152,7 @@ public:
 
   /** Destructor; releases resources */
   ~BasicBloomFilterWithChecksum() {
-    delete[] m_bloom_base;
+    delete[] m_bloom_alloc;
   }
 
   /* XXX/review static functions to expose the bloom filter parameters, given
@@ -160,6 +170,13 @@ public:
    * @param len Size of the data (in bytes)
    */
   void insert(const void *key, size_t len) {
+    if (m_layout == BLOOM_FILTER_LAYOUT_BLOCKED) {
+      BlockedBloomFilter::insert(m_bloom_bits, m_num_bits, m_num_hash_functions,
+                                 BlockedBloomFilter::hash(key, len));
+      m_items_actual++;
+      return;
+    }
+
     uint32_t hash = len;
 
     for (size_t i = 0; i < m_num_hash_functions; ++i) {
@@ -189,6 +206,11 @@ public:
    * @return true if the key "may" be contained, otherwise false
    */
   bool may_contain(const void *key, size_t len) const {
+    if (m_layout == BLOOM_FILTER_LAYOUT_BLOCKED)
+      return BlockedBloomFilter::may_contain(m_bloom_bits, m_num_bits,
+                                             m_num_hash_functions,
+                                             BlockedBloomFilter::hash(key, len));
+
     uint32_t hash = len;
     uint8_t byte_mask;
     uint8_t byte;
@@ -274,6 +296,12 @@ public:
    */
   size_t get_length_bits() { return m_num_bits; }
 
+  /** Getter for the bit layout
+   *
+   * @return The bit layout
+   */
+  BloomFilterLayout get_layout() { return m_layout; }
+
   /** Getter for the estimated number of items
    *
    * @return The estimated number of items
@@ -287,6 +315,17 @@ public:
   size_t get_items_actual() { return m_items_actual; }
 
 private:
+  /** Allocates the zeroed serialized buffer.  The bit array that follows
+   * the 4-byte checksum is placed on a 64-byte boundary so each block of
+   * the blocked layout occupies exactly one cache line. */
+  void allocate() {
+    m_bloom_alloc = new uint8_t[total_size() + 63];
+    m_bloom_bits = (uint8_t *)(((uintptr_t)m_bloom_alloc + 4 + 63) &
+                               ~(uintptr_t)63);
+    m_bloom_base = m_bloom_bits - 4;
+    memset(m_bloom_base, 0, total_size());
+  }
+
   /** The hash function implementation */
   HasherT    m_hasher;
 
@@ -313,6 +352,12 @@ private:
 
   /** The serialized bloom filter data, including metadata and checksums */
   uint8_t   *m_bloom_base;
+
+  /** Allocated memory holding #m_bloom_base */
+  uint8_t   *m_bloom_alloc;
+
+  /** Bit layout */
+  BloomFilterLayout m_layout;
 };
 
 typedef BasicBloomFilterWithChecksum<> BloomFilterWithChecksum;
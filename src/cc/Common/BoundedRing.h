@@ -0,0 +1,200 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for BoundedRing.
+/// This file contains the type declaration for BoundedRing, a bounded,
+/// lock-free, single-producer single-consumer queue.
+
+#ifndef Common_BoundedRing_h
+#define Common_BoundedRing_h
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace Hypertable {
+
+  /// @addtogroup Common
+  /// @{
+
+  /// Bounded, lock-free, single-producer single-consumer queue.
+  /// Items are passed through a power-of-two array of slots indexed by
+  /// monotonically increasing head and tail counters, so try_push() and
+  /// try_pop() touch no locks.  The blocking push() and pop() only fall back
+  /// to a mutex and condition variable to sleep, when the ring is full or
+  /// empty, and the other side only takes the mutex to wake a thread that is
+  /// actually sleeping.  Exactly one thread may push and exactly one thread
+  /// may pop.
+  template <typename T>
+  class BoundedRing {
+  public:
+
+    /// Constructor.
+    /// @param capacity Minimum number of items the ring can hold, rounded
+    /// up to a power of two
+    explicit BoundedRing(size_t capacity) {
+      size_t size = 1;
+      while (size < capacity)
+        size <<= 1;
+      m_slots.resize(size);
+      m_mask = size - 1;
+    }
+
+    /// Adds an item if there is room.
+    /// @param item Item to add
+    /// @return <i>false</i> if the ring is full, <i>true</i> otherwise
+    bool try_push(const T &item) {
+      size_t tail = m_tail.load(std::memory_order_relaxed);
+      if (tail - m_head.load(std::memory_order_acquire) > m_mask)
+        return false;
+      m_slots[tail & m_mask] = item;
+      m_tail.store(tail + 1, std::memory_order_seq_cst);
+      if (m_consumer_waiting.load(std::memory_order_seq_cst)) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_not_empty.notify_one();
+      }
+      return true;
+    }
+
+    /// Adds an item, waiting for room if the ring is full.
+    /// @param item Item to add
+    /// @return <i>false</i> if the ring was closed, <i>true</i> otherwise
+    bool push(const T &item) {
+      while (!try_push(item)) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_producer_waiting.store(true, std::memory_order_seq_cst);
+        m_not_full.wait(lock, [this](){ return !full() || m_closed; });
+        m_producer_waiting.store(false, std::memory_order_relaxed);
+        if (m_closed)
+          return false;
+      }
+      return true;
+    }
+
+    /// Removes the oldest item if there is one.
+    /// @param item Receives the item
+    /// @return <i>false</i> if the ring is empty, <i>true</i> otherwise
+    bool try_pop(T &item) {
+      size_t head = m_head.load(std::memory_order_relaxed);
+      if (head == m_tail.load(std::memory_order_acquire))
+        return false;
+      item = m_slots[head & m_mask];
+      m_head.store(head + 1, std::memory_order_seq_cst);
+      if (m_producer_waiting.load(std::memory_order_seq_cst)) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_not_full.notify_one();
+      }
+      return true;
+    }
+
+    /// Removes the oldest item, waiting for one if the ring is empty.
+    /// @param item Receives the item
+    /// @return <i>false</i> if the ring was closed, <i>true</i> otherwise
+    bool pop(T &item) {
+      while (!m_closed) {
+        if (try_pop(item))
+          return true;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_consumer_waiting.store(true, std::memory_order_seq_cst);
+        m_not_empty.wait(lock, [this](){ return !empty() || m_closed; });
+        m_consumer_waiting.store(false, std::memory_order_relaxed);
+      }
+      return false;
+    }
+
+    /// Closes the ring.
+    /// Wakes up threads waiting in push() or pop(), which return
+    /// <i>false</i>, as do all later calls to them.
+    void close() {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_closed = true;
+      m_not_empty.notify_all();
+      m_not_full.notify_all();
+    }
+
+    /// Checks if ring is empty.
+    /// @return <i>true</i> if ring is empty, <i>false</i> otherwise
+    bool empty() const {
+      return m_head.load(std::memory_order_seq_cst) ==
+        m_tail.load(std::memory_order_seq_cst);
+    }
+
+    /// Checks if ring is full.
+    /// @return <i>true</i> if ring is full, <i>false</i> otherwise
+    bool full() const {
+      return m_tail.load(std::memory_order_seq_cst) -
+        m_head.load(std::memory_order_seq_cst) > m_mask;
+    }
+
+    /// Returns number of items in ring.
+    /// @return Number of items in ring
+    size_t size() const {
+      return m_tail.load(std::memory_order_acquire) -
+        m_head.load(std::memory_order_acquire);
+    }
+
+  private:
+
+    /// Item slots
+    std::vector<T> m_slots;
+
+    /// Slot count minus one, for masking counters into slot indexes
+    size_t m_mask {};
+
+    /// Count of items popped
+    std::atomic<size_t> m_head {0};
+
+    /// Keeps #m_head and #m_tail on separate cache lines
+    char m_head_padding[64];
+
+    /// Count of items pushed
+    std::atomic<size_t> m_tail {0};
+
+    /// Keeps #m_tail and the members below on separate cache lines
+    char m_tail_padding[64];
+
+    /// Set while the consumer sleeps on #m_not_empty
+    std::atomic<bool> m_consumer_waiting {false};
+
+    /// Set while the producer sleeps on #m_not_full
+    std::atomic<bool> m_producer_waiting {false};
+
+    /// Set by close()
+    std::atomic<bool> m_closed {false};
+
+    /// %Mutex for sleeping in push() and pop()
+    std::mutex m_mutex;
+
+    /// Signals the consumer that an item was added
+    std::condition_variable m_not_empty;
+
+    /// Signals the producer that an item was removed
+    std::condition_variable m_not_full;
+  };
+
+  /// @}
+
+}
+
+#endif // Common_BoundedRing_h
@@ -19,7 +19,7 @@
 
 /** @file
  * Implementation of checksum routines.
- * This file implements the fletcher32 checksum algorithm.
+ * This file implements the fletcher32 and CRC32C checksum algorithms.
  */
 
 #include "Compat.h"
@@ -27,6 +27,15 @@
 #include <zlib.h>
 #include "Checksum.h"
 
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HT_CRC32C_X86_64 1
+#include <immintrin.h>
+#endif
+
 namespace Hypertable {
 
 #define HT_F32_DO1(buf,i) \
@@ -83,6 +92,258 @@ fletcher32(const void *data8, size_t len8) {
   return (sum2 << 16) | sum1;
 }
 
+
+namespace {
+
+  /// CRC32C polynomial, bit reflected
+  const uint32_t Crc32cPoly = 0x82F63B78;
+
+  /// Lookup tables for slicing-by-8
+  struct Crc32cTables {
+    Crc32cTables() {
+      for (uint32_t n=0; n<256; n++) {
+        uint32_t crc = n;
+        for (int k=0; k<8; k++)
+          crc = (crc & 1) ? (crc >> 1) ^ Crc32cPoly : crc >> 1;
+        table[0][n] = crc;
+      }
+      for (uint32_t n=0; n<256; n++) {
+        for (int k=1; k<8; k++)
+          table[k][n] = (table[k-1][n] >> 8) ^ table[0][table[k-1][n] & 0xff];
+      }
+    }
+    uint32_t table[8][256];
+  };
+
+  const Crc32cTables &crc32c_tables() {
+    static Crc32cTables tables;
+    return tables;
+  }
+
+  /// Multiplies two polynomials modulo the CRC32C polynomial.  Polynomials
+  /// are bit reflected, i.e. x^0 is the most significant bit.
+  uint32_t multmodp(uint32_t a, uint32_t b) {
+    uint32_t m = 1u << 31;
+    uint32_t p = 0;
+    while (true) {
+      if (a & m) {
+        p ^= b;
+        if ((a & (m - 1)) == 0)
+          break;
+      }
+      m >>= 1;
+      b = (b & 1) ? (b >> 1) ^ Crc32cPoly : b >> 1;
+    }
+    return p;
+  }
+
+  /// Computes x^n modulo the CRC32C polynomial (bit reflected).
+  uint32_t xpowmodp(uint64_t n) {
+    uint32_t result = 1u << 31;  // x^0
+    uint32_t square = 1u << 30;  // x^1
+    while (n) {
+      if (n & 1)
+        result = multmodp(square, result);
+      square = multmodp(square, square);
+      n >>= 1;
+    }
+    return result;
+  }
+
+  /// The implementations below update and return the raw CRC register; the
+  /// initial and final inversion are done by crc32c().
+  typedef uint32_t (*Crc32cFunc)(uint32_t crc, const uint8_t *p, size_t len);
+
+  uint32_t crc32c_scalar(uint32_t crc, const uint8_t *p, size_t len) {
+    const Crc32cTables &t = crc32c_tables();
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (len >= 8) {
+      uint64_t word;
+      memcpy(&word, p, 8);
+      word ^= crc;
+      crc = t.table[7][word & 0xff] ^
+        t.table[6][(word >> 8) & 0xff] ^
+        t.table[5][(word >> 16) & 0xff] ^
+        t.table[4][(word >> 24) & 0xff] ^
+        t.table[3][(word >> 32) & 0xff] ^
+        t.table[2][(word >> 40) & 0xff] ^
+        t.table[1][(word >> 48) & 0xff] ^
+        t.table[0][word >> 56];
+      p += 8;
+      len -= 8;
+    }
+#endif
+    while (len--)
+      crc = t.table[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return crc;
+  }
+
+#if HT_CRC32C_X86_64
+
+  __attribute__((target("sse4.2")))
+  uint32_t crc32c_sse42(uint32_t crc, const uint8_t *p, size_t len) {
+    uint64_t crc64 = crc;
+    while (len >= 8) {
+      uint64_t word;
+      memcpy(&word, p, 8);
+      crc64 = _mm_crc32_u64(crc64, word);
+      p += 8;
+      len -= 8;
+    }
+    crc = (uint32_t)crc64;
+    while (len--)
+      crc = _mm_crc32_u8(crc, *p++);
+    return crc;
+  }
+
+  /// Block lengths for which three streams are interleaved.  The crc32
+  /// instruction has a latency of three cycles and a throughput of one, so
+  /// three independent streams keep it busy.
+  const size_t LongBlock = 8192;
+  const size_t ShortBlock = 256;
+
+  /// Multipliers that shift a CRC register over one and two blocks of zeros.
+  /// Multiplying by x^(8n-33) with PCLMULQDQ and reducing the 64-bit product
+  /// with a crc32 instruction (which multiplies by x^32, plus one for the
+  /// reflected product) shifts the register over n bytes.
+  struct ShiftConstants {
+    ShiftConstants() {
+      long1 = xpowmodp(8*LongBlock - 33);
+      long2 = xpowmodp(16*LongBlock - 33);
+      short1 = xpowmodp(8*ShortBlock - 33);
+      short2 = xpowmodp(16*ShortBlock - 33);
+    }
+    uint64_t long1, long2, short1, short2;
+  };
+
+  const ShiftConstants &shift_constants() {
+    static ShiftConstants constants;
+    return constants;
+  }
+
+  /// Computes the CRC over three consecutive blocks of <code>block</code>
+  /// bytes each, as three independent streams, then combines them.
+  __attribute__((target("sse4.2,pclmul")))
+  inline uint32_t crc32c_three_way(uint32_t crc, const uint8_t *p,
+                                   size_t block, uint64_t shift1,
+                                   uint64_t shift2) {
+    uint64_t crc0 = crc, crc1 = 0, crc2 = 0;
+    const uint8_t *end = p + block;
+    for (; p < end; p += 8) {
+      uint64_t w0, w1, w2;
+      memcpy(&w0, p, 8);
+      memcpy(&w1, p + block, 8);
+      memcpy(&w2, p + 2*block, 8);
+      crc0 = _mm_crc32_u64(crc0, w0);
+      crc1 = _mm_crc32_u64(crc1, w1);
+      crc2 = _mm_crc32_u64(crc2, w2);
+    }
+    __m128i a = _mm_clmulepi64_si128(_mm_cvtsi64_si128(crc0),
+                                     _mm_cvtsi64_si128(shift2), 0x00);
+    __m128i b = _mm_clmulepi64_si128(_mm_cvtsi64_si128(crc1),
+                                     _mm_cvtsi64_si128(shift1), 0x00);
+    uint64_t folded = _mm_cvtsi128_si64(_mm_xor_si128(a, b));
+    return (uint32_t)_mm_crc32_u64(0, folded) ^ (uint32_t)crc2;
+  }
+
+  __attribute__((target("sse4.2,pclmul")))
+  uint32_t crc32c_pclmul(uint32_t crc, const uint8_t *p, size_t len) {
+    const ShiftConstants &k = shift_constants();
+    while (len >= 3*LongBlock) {
+      crc = crc32c_three_way(crc, p, LongBlock, k.long1, k.long2);
+      p += 3*LongBlock;
+      len -= 3*LongBlock;
+    }
+    while (len >= 3*ShortBlock) {
+      crc = crc32c_three_way(crc, p, ShortBlock, k.short1, k.short2);
+      p += 3*ShortBlock;
+      len -= 3*ShortBlock;
+    }
+    return crc32c_sse42(crc, p, len);
+  }
+
+#endif
+
+  struct Crc32cImplementation {
+    const char *name;
+    Crc32cFunc func;
+    bool (*supported)();
+  };
+
+  bool always_supported() { return true; }
+
+#if HT_CRC32C_X86_64
+  bool pclmul_supported() {
+    return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("pclmul");
+  }
+  bool sse42_supported() { return __builtin_cpu_supports("sse4.2"); }
+#endif
+
+  /// Implementations in order of preference
+  const Crc32cImplementation crc32c_implementations[] = {
+#if HT_CRC32C_X86_64
+    { "pclmul", crc32c_pclmul, pclmul_supported },
+    { "sse42", crc32c_sse42, sse42_supported },
+#endif
+    { "scalar", crc32c_scalar, always_supported }
+  };
+
+  uint32_t crc32c_resolve(uint32_t crc, const uint8_t *p, size_t len);
+
+  /// Implementation selected for this CPU.  Starts out pointing at
+  /// crc32c_resolve() so that checksums computed by static initializers in
+  /// other translation units work.
+  std::atomic<Crc32cFunc> crc32c_func {crc32c_resolve};
+
+  /// Selects the best implementation on first use.
+  uint32_t crc32c_resolve(uint32_t crc, const uint8_t *p, size_t len) {
+#if HT_CRC32C_X86_64
+    __builtin_cpu_init();
+#endif
+    for (auto &impl : crc32c_implementations) {
+      if (impl.supported()) {
+        crc32c_func.store(impl.func, std::memory_order_relaxed);
+        break;
+      }
+    }
+    return crc32c_func.load(std::memory_order_relaxed)(crc, p, len);
+  }
+
+}
+
+uint32_t crc32c(const void *data, size_t len) {
+  Crc32cFunc func = crc32c_func.load(std::memory_order_relaxed);
+  return ~func(0xFFFFFFFF, (const uint8_t *)data, len);
+}
+
+const char *crc32c_implementation() {
+  Crc32cFunc func = crc32c_func.load(std::memory_order_relaxed);
+  if (func == crc32c_resolve) {
+    crc32c_resolve(0, 0, 0);
+    func = crc32c_func.load(std::memory_order_relaxed);
+  }
+  for (auto &impl : crc32c_implementations) {
+    if (impl.func == func)
+      return impl.name;
+  }
+  return "scalar";
+}
+
+bool set_crc32c_implementation(const char *name) {
+#if HT_CRC32C_X86_64
+  __builtin_cpu_init();
+#endif
+  for (auto &impl : crc32c_implementations) {
+    if (!strcmp(impl.name, name)) {
+      if (!impl.supported())
+        return false;
+      crc32c_func.store(impl.func, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
 } // namespace Hypertable
 
 /* vim: et sw=2
@@ -19,7 +19,7 @@
 
 /** @file
  * Implementation of checksum routines.
- * This file implements the fletcher32 checksum algorithm.
+ * This file declares the fletcher32 and CRC32C checksum algorithms.
  */
 
 #ifndef HYPERTABLE_CHECKSUM_H
@@ -41,6 +41,52 @@ namespace Hypertable {
    */
   extern uint32_t fletcher32(const void *data, size_t len);
 
+  /** Checksum algorithms.
+   * The value is persisted (e.g. in BlockHeader flags) so existing values
+   * must not change.
+   */
+  enum ChecksumType {
+    CHECKSUM_FLETCHER32 = 0, //!< fletcher32()
+    CHECKSUM_CRC32C = 1      //!< crc32c()
+  };
+
+  /** Compute CRC32C (Castagnoli) checksum for arbitrary data.
+   * The implementation is chosen at runtime: SSE4.2 <code>crc32</code>
+   * instructions over three interleaved streams combined with PCLMULQDQ, SSE4.2
+   * alone, or a portable table-driven version.  All of them return the same
+   * value.
+   *
+   * @param data Pointer to the input data
+   * @param len Input data length in bytes
+   * @return The calculated checksum
+   */
+  extern uint32_t crc32c(const void *data, size_t len);
+
+  /** Compute checksum of given type.
+   *
+   * @param type Checksum algorithm
+   * @param data Pointer to the input data
+   * @param len Input data length in bytes
+   * @return The calculated checksum
+   */
+  inline uint32_t checksum(ChecksumType type, const void *data, size_t len) {
+    return type == CHECKSUM_CRC32C ? crc32c(data, len) : fletcher32(data, len);
+  }
+
+  /** Returns name of the crc32c() implementation in use.
+   * @return One of "pclmul", "sse42" or "scalar"
+   */
+  extern const char *crc32c_implementation();
+
+  /** Selects a crc32c() implementation by name.
+   * Used by tests and benchmarks to compare implementations.
+   *
+   * @param name One of "pclmul", "sse42" or "scalar"
+   * @return <i>false</i> if the implementation is unknown or not supported by
+   * the CPU, <i>true</i> otherwise
+   */
+  extern bool set_crc32c_implementation(const char *name);
+
   /** @}*/
 
 } // namespace Hypertable
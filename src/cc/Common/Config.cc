@@ -272,6 +272,13 @@ void DefaultPolicy::init_options() {
         "Host on which the FS broker is running (read by clients only)")
     ("FsBroker.Port", i16()->default_value(15863),
         "Port number on which FS broker is listening (read by clients only)")
+    ("FsBroker.ShortCircuit", boo()->default_value(false), "Open, read, "
+        "and append to files directly under FsBroker.Local.Root instead of "
+        "through the FS broker (read by RangeServer only, requires the local "
+        "broker running on the same host)")
+    ("FsBroker.ShortCircuit.Workers", i32()->default_value(8), "Number of "
+        "threads carrying out asynchronous short-circuit file operations "
+        "(read by RangeServer only)")
     ("FsBroker.Timeout", i32(), "Length of time, "
         "in milliseconds, to wait before timing out FS Broker requests. This "
         "takes precedence over Hypertable.Request.Timeout")
@@ -287,6 +294,10 @@ void DefaultPolicy::init_options() {
         "log files after this much time")
     ("Hyperspace.LogGc.MaxUnusedLogs", i32()->default_value(200), "Number of unused BerkeleyDB "
         "to keep around in case of lagging replicas")
+    ("Hyperspace.StateStore", str()->default_value("berkeleydb"),
+        "Hyperspace state store (berkeleydb or log); the log store keeps the "
+        "namespace in memory backed by a write-ahead log with group commit "
+        "and only supports a single replica")
     ("Hyperspace.Replica.Host", strs(), "Hostname of Hyperspace replica")
     ("Hyperspace.Replica.Port", i16()->default_value(15861),
         "Port number on which Hyperspace is or should be listening for requests")
@@ -311,6 +322,12 @@ void DefaultPolicy::init_options() {
         "Hyperspace Grace period (see Chubby paper)")
     ("Hyperspace.Session.Reconnect", boo()->default_value(false),
         "Reconnect to Hyperspace on session expiry")
+    ("Hyperspace.Client.Cache.Enable", boo()->default_value(false),
+        "Cache file existence, attribute values and directory listings in "
+        "the Hyperspace client, invalidated by event notifications")
+    ("Hyperspace.Client.Cache.MaxNodes", i32()->default_value(10000),
+        "Maximum number of Hyperspace nodes watched by the client cache; "
+        "lookups of further nodes bypass the cache")
     ("Hypertable.Directory", str()->default_value("hypertable"),
         "Top-level hypertable directory name")
     ("Hypertable.Monitoring.Interval", i32()->default_value(30000),
@@ -404,6 +421,9 @@ void DefaultPolicy::init_options() {
      i32()->default_value(512*KiB), "Page size for CellCache pool allocator")
     ("Hypertable.RangeServer.AccessGroup.CellCache.ScannerCacheSize",
      i32()->default_value(1024), "CellCache scanner cache size")
+    ("Hypertable.RangeServer.AccessGroup.CellCache.DefaultType",
+     str()->default_value("map"), "Default CellCache type (map|skiplist) for "
+     "access groups that don't specify the CELLCACHE option")
     ("Hypertable.RangeServer.AccessGroup.ShadowCache",
      boo()->default_value(false), "Enable CellStore shadow caching")
     ("Hypertable.RangeServer.AccessGroup.MaxMemory", i64()->default_value(1*G),
@@ -425,10 +445,28 @@ void DefaultPolicy::init_options() {
         i32()->default_value(-1), "Default replication for data")
     ("Hypertable.RangeServer.CellStore.DefaultCompressor",
         str()->default_value("snappy"), "Default compressor for cell stores")
+    ("Hypertable.RangeServer.CellStore.Compression.Threads",
+        i32()->default_value(2), "Number of threads used to compress the "
+        "data blocks of each cell store being written (0 compresses blocks "
+        "on the writing thread)")
+    ("Hypertable.RangeServer.CellStore.Compression.MaxOutstanding",
+        i32()->default_value(8), "Maximum number of data blocks of a cell "
+        "store being written that are buffered for compression")
     ("Hypertable.RangeServer.CellStore.DefaultBloomFilter",
         str()->default_value("rows"), "Default bloom filter for cell stores")
+    ("Hypertable.RangeServer.CellStore.DefaultKeyEncoding",
+        str()->default_value("prefix"), "Default key encoding "
+        "(prefix|delta|columnar) for access groups that don't specify the KEYENCODING option")
     ("Hypertable.RangeServer.CellStore.SkipBad",
         boo()->default_value(false), "Skip over cell stores that are corrupt")
+    ("Hypertable.RangeServer.CellStore.BloomFilter.Blocked",
+        boo()->default_value(false), "Write CellStore bloom filters with the "
+        "cache-line blocked layout (only enable once every server can read "
+        "it, older servers ignore the layout and drop rows)")
+    ("Hypertable.RangeServer.CellStore.BlockSummaries",
+        boo()->default_value(true), "Write per-block column family, "
+        "timestamp and revision summaries to cell stores so that scans can "
+        "skip blocks that hold none of the cells they select")
     ("Hypertable.RangeServer.CellStore.SkipNotFound",
         boo()->default_value(false), "Skip over cell stores that are non-existent")
     ("Hypertable.RangeServer.IgnoreClockSkewErrors",
@@ -441,6 +479,9 @@ void DefaultPolicy::init_options() {
         "Minimum size of block cache")
     ("Hypertable.RangeServer.BlockCache.MaxMemory", i64()->default_value(-1),
         "Maximum (target) size of block cache")
+    ("Hypertable.RangeServer.BlockCache.Shards", i32()->default_value(16),
+        "Number of independently locked block cache shards (rounded down to "
+        "a power of two)")
     ("Hypertable.RangeServer.QueryCache.EnableMutexStatistics",
      boo()->default_value(true), "Enable query cache mutex statistics")
     ("Hypertable.RangeServer.QueryCache.MaxMemory", i64()->default_value(50*M),
@@ -479,10 +520,22 @@ void DefaultPolicy::init_options() {
     ("Hypertable.RangeServer.CommitLog.Compressor",
         str()->default_value("quicklz"),
        "Commit log compressor to use (zlib, lzo, quicklz, snappy, bmz, none)")
+    ("Hypertable.RangeServer.CommitLog.Replay.Threads", i32()->default_value(4),
+        "Number of threads adding replayed commit log cells to ranges "
+        "(0 replays on a single thread)")
+    ("Hypertable.RangeServer.CommitLog.Replay.InflateThreads",
+        i32()->default_value(2),
+        "Number of threads decompressing commit log blocks during replay")
     ("Hypertable.RangeServer.Testing.MaintenanceNeeded.PauseInterval", i32()->default_value(0),
         "TESTING:  After update, if range needs maintenance, pause for this number of milliseconds")
     ("Hypertable.RangeServer.UpdateCoalesceLimit", i64()->default_value(5*M),
         "Amount of update data to coalesce into single commit log sync")
+    ("Hypertable.RangeServer.UpdatePipeline.Threads", i32()->default_value(4),
+        "Number of threads in each update pipeline that add committed updates "
+        "to ranges (updates to a range are always added by the same thread)")
+    ("Hypertable.RangeServer.UpdatePipeline.QueueCapacity",
+        i32()->default_value(1024), "Number of update requests that can be "
+        "queued between update pipeline stages")
     ("Hypertable.RangeServer.Failover.FlushLimit.PerRange",
      i32()->default_value(10*M), "Amount of updates (bytes) accumulated for a "
         "single range to trigger a replay buffer flush")
@@ -503,10 +556,27 @@ void DefaultPolicy::init_options() {
         "Number of milliseconds of inactivity before destroying scanners")
     ("Hypertable.RangeServer.Scanner.BufferSize", i64()->default_value(1*M),
         "Size of transfer buffer for scan results")
+    ("Hypertable.RangeServer.MultiGet.MaxResponseSize", i64()->default_value(32*M),
+        "Largest multi get response a RangeServer builds; larger batches fail "
+        "with RANGESERVER_RESPONSE_TOO_LARGE and are split by the client")
+    ("Hypertable.RangeServer.Scanner.ZeroCopy.MinValueSize", i32()->default_value(4*K),
+        "Values at least this large are sent directly out of cached cell store "
+        "blocks and cell cache memory instead of being copied into the scan "
+        "result buffer (0 disables)")
+    ("Hypertable.RangeServer.Scanner.Sharing.MaxMemory", i64()->default_value(0),
+        "Maximum amount of scan block memory held by shared scans that new "
+        "scanners may still join (0, the default, disables scan sharing)")
+    ("Hypertable.RangeServer.Scanner.Sharing.ScanMaxMemory", i64()->default_value(8*M),
+        "Amount of scan block memory after which a shared scan can no longer be "
+        "joined by identical scans of the same range")
     ("Hypertable.RangeServer.Timer.Interval", i32()->default_value(20000),
         "Timer interval in milliseconds (reaping scanners, purging commit logs, etc.)")
     ("Hypertable.RangeServer.Maintenance.Interval", i32()->default_value(30000),
         "Maintenance scheduling interval in milliseconds")
+    ("Hypertable.RangeServer.Maintenance.Compaction.Partitions", i32()->default_value(1),
+        "Maximum number of row partitions a major compaction is split into and "
+        "merged in parallel, each producing a CellStore of at least "
+        "CellStore.TargetSize.Minimum (1 disables)")
     ("Hypertable.RangeServer.Maintenance.LowMemoryPrioritization", boo()->default_value(true),
         "Use low memory prioritization algorithm for freeing memory in low memory mode")
     ("Hypertable.RangeServer.Maintenance.MaxAppQueuePause", i32()->default_value(120000),
@@ -546,6 +616,13 @@ void DefaultPolicy::init_options() {
         "Maximum flush interval in milliseconds")
     ("ThriftBroker.Workers", i32()->default_value(50), "Number of "
         "worker threads for thrift broker")
+    ("ThriftBroker.Server", str()->default_value("threaded"), "Server "
+        "mode: \"threaded\" runs one thread per connection, \"nonblocking\" "
+        "serves connections from a few event-driven I/O threads and runs "
+        "requests on ThriftBroker.Workers worker threads (ThriftBroker.Timeout "
+        "is not applied in nonblocking mode)")
+    ("ThriftBroker.IOThreads", i32()->default_value(2), "Number of I/O "
+        "threads in nonblocking server mode")
     ("ThriftBroker.Hyperspace.Session.Reconnect", boo()->default_value(true),
         "ThriftBroker will reconnect to Hyperspace on session expiry")
     ("ThriftBroker.SlowQueryLog.Enable", boo()->default_value(true),
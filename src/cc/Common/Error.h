@@ -237,6 +237,7 @@ namespace Hypertable {
       RANGESERVER_RANGE_NOT_YET_ACKNOWLEDGED       = 0x00050021,
       RANGESERVER_SERVER_IN_READONLY_MODE          = 0x00050022,
       RANGESERVER_RANGE_NOT_YET_RELINQUISHED       = 0x00050023,
+      RANGESERVER_RESPONSE_TOO_LARGE               = 0x00050024,
     
       HQL_BAD_LOAD_FILE_FORMAT                     = 0x00060001,
       HQL_BAD_COMMAND                              = 0x00060002,
@@ -114,6 +114,22 @@ namespace Hypertable {
       
     };
 
+    /// %File extent
+    class Extent {
+    public:
+      /// Default constructor.
+      Extent() {}
+      /// Constructor.
+      /// @param offset_ %File offset
+      /// @param length_ Length in bytes
+      Extent(uint64_t offset_, uint32_t length_)
+        : offset(offset_), length(length_) {}
+      /// %File offset
+      uint64_t offset {};
+      /// Length in bytes
+      uint32_t length {};
+    };
+
     virtual ~Filesystem() { }
 
     /** Opens a file asynchronously.  Issues an open file request.  The caller
@@ -380,6 +396,43 @@ namespace Hypertable {
     virtual void decode_response_pread(EventPtr &event, const void **buffer,
                                        uint64_t *offset, uint32_t *length) = 0;
 
+    /** Reads several extents of a file asynchronously.  Issues a single
+     * preadv request for all of the extents.  The caller will get notified
+     * of successful completion or error via the given dispatch handler and
+     * can deserialize the returned data with decode_response_preadv().
+     * EOF is indicated by a short read of an extent.
+     *
+     * @param fd The open file descriptor
+     * @param extents The extents to read
+     * @param verify_checksum Tells filesystem to perform checksum verification
+     * @param handler The dispatch handler
+     */
+    virtual void preadv(int fd, const std::vector<Extent> &extents,
+                        bool verify_checksum, DispatchHandler *handler) = 0;
+
+    /** Reads several extents of a file.  Issues a preadv request and waits
+     * for it to complete.  The data of each extent is copied into
+     * <code>dst</code> at the sum of the lengths of the extents before it.
+     * EOF is indicated by a short read.
+     *
+     * @param fd The open file descriptor
+     * @param extents The extents to read
+     * @param dst The destination buffer for read data
+     * @param verify_checksum Tells filesystem to perform checksum verification
+     * @return The total amount of data read (in bytes)
+     */
+    virtual size_t preadv(int fd, const std::vector<Extent> &extents,
+                          void *dst, bool verify_checksum = true) = 0;
+
+    /// Decodes the response from a preadv request.
+    /// @param event A reference to the response event
+    /// @param extents Receives the extents read, with the length set to
+    /// the amount of data read for each
+    /// @param buffers Receives a pointer to the data of each extent
+    virtual void decode_response_preadv(EventPtr &event,
+                                        std::vector<Extent> &extents,
+                                        std::vector<const void *> &buffers) = 0;
+
     /** Creates a directory asynchronously.  Issues a mkdirs request which
      * creates a directory, including all its missing parents.  The caller
      * will get notified of successful completion or error via the given
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Vectorized memory comparison.
+ * Definitions of the AVX2, SSE2 and scalar memory_compare()
+ * implementations and the runtime selection between them.
+ */
+
+#include "Common/Compat.h"
+#include "Common/MemoryCompare.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HT_MEMORY_COMPARE_X86 1
+#include <immintrin.h>
+#endif
+
+namespace Hypertable {
+
+namespace {
+
+  int compare_scalar(const void *s1, const void *s2, size_t n) {
+    return memcmp(s1, s2, n);
+  }
+
+#if HT_MEMORY_COMPARE_X86
+
+  /// Compares fewer than 16 bytes, eight at a time.  Words are byte swapped
+  /// so that integer comparison matches byte order comparison.
+  inline int compare_tail(const uint8_t *p1, const uint8_t *p2, size_t n) {
+    while (n >= 8) {
+      uint64_t w1, w2;
+      memcpy(&w1, p1, 8);
+      memcpy(&w2, p2, 8);
+      if (w1 != w2) {
+        w1 = __builtin_bswap64(w1);
+        w2 = __builtin_bswap64(w2);
+        return (w1 < w2) ? -1 : 1;
+      }
+      p1 += 8;
+      p2 += 8;
+      n -= 8;
+    }
+    for (; n; n--, p1++, p2++) {
+      if (*p1 != *p2)
+        return (int)*p1 - (int)*p2;
+    }
+    return 0;
+  }
+
+  /// pcmpestri is not used, its latency makes it slower than a byte compare
+  /// and movemask for the short keys compared here
+  __attribute__((target("sse2")))
+  int compare_sse2(const void *s1, const void *s2, size_t n) {
+    const uint8_t *p1 = (const uint8_t *)s1;
+    const uint8_t *p2 = (const uint8_t *)s2;
+
+    while (n >= 16) {
+      __m128i v1 = _mm_loadu_si128((const __m128i *)p1);
+      __m128i v2 = _mm_loadu_si128((const __m128i *)p2);
+      uint32_t mask = ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v1, v2)) & 0xFFFF;
+      if (mask) {
+        int i = __builtin_ctz(mask);
+        return (int)p1[i] - (int)p2[i];
+      }
+      p1 += 16;
+      p2 += 16;
+      n -= 16;
+    }
+    return compare_tail(p1, p2, n);
+  }
+
+  __attribute__((target("avx2")))
+  int compare_avx2(const void *s1, const void *s2, size_t n) {
+    const uint8_t *p1 = (const uint8_t *)s1;
+    const uint8_t *p2 = (const uint8_t *)s2;
+
+    while (n >= 32) {
+      __m256i v1 = _mm256_loadu_si256((const __m256i *)p1);
+      __m256i v2 = _mm256_loadu_si256((const __m256i *)p2);
+      uint32_t mask = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v1, v2));
+      if (mask) {
+        int i = __builtin_ctz(mask);
+        return (int)p1[i] - (int)p2[i];
+      }
+      p1 += 32;
+      p2 += 32;
+      n -= 32;
+    }
+    if (n >= 16) {
+      __m128i v1 = _mm_loadu_si128((const __m128i *)p1);
+      __m128i v2 = _mm_loadu_si128((const __m128i *)p2);
+      uint32_t mask = ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v1, v2)) & 0xFFFF;
+      if (mask) {
+        int i = __builtin_ctz(mask);
+        return (int)p1[i] - (int)p2[i];
+      }
+      p1 += 16;
+      p2 += 16;
+      n -= 16;
+    }
+    return compare_tail(p1, p2, n);
+  }
+
+#endif
+
+  struct Implementation {
+    const char *name;
+    MemoryCompareFunc func;
+    bool (*supported)();
+  };
+
+  bool always_supported() { return true; }
+
+#if HT_MEMORY_COMPARE_X86
+  bool avx2_supported() { return __builtin_cpu_supports("avx2"); }
+  bool sse2_supported() { return __builtin_cpu_supports("sse2"); }
+#endif
+
+  /// Implementations in order of preference
+  const Implementation implementations[] = {
+#if HT_MEMORY_COMPARE_X86
+    { "avx2", compare_avx2, avx2_supported },
+    { "sse2", compare_sse2, sse2_supported },
+#endif
+    { "scalar", compare_scalar, always_supported }
+  };
+
+  /// Selects the best implementation on first use.  memory_compare_func
+  /// starts out pointing here so that comparisons made by static
+  /// initializers in other translation units work.
+  int resolve(const void *s1, const void *s2, size_t n) {
+#if HT_MEMORY_COMPARE_X86
+    __builtin_cpu_init();
+#endif
+    for (auto &impl : implementations) {
+      if (impl.supported()) {
+        memory_compare_func.store(impl.func, std::memory_order_relaxed);
+        break;
+      }
+    }
+    return memory_compare_func.load(std::memory_order_relaxed)(s1, s2, n);
+  }
+
+}
+
+std::atomic<MemoryCompareFunc> memory_compare_func {resolve};
+
+const char *memory_compare_implementation() {
+  MemoryCompareFunc func = memory_compare_func.load(std::memory_order_relaxed);
+  if (func == resolve) {
+    resolve("", "", 0);
+    func = memory_compare_func.load(std::memory_order_relaxed);
+  }
+  for (auto &impl : implementations) {
+    if (impl.func == func)
+      return impl.name;
+  }
+  return "scalar";
+}
+
+bool set_memory_compare_implementation(const char *name) {
+#if HT_MEMORY_COMPARE_X86
+  __builtin_cpu_init();
+#endif
+  for (auto &impl : implementations) {
+    if (!strcmp(impl.name, name)) {
+      if (!impl.supported())
+        return false;
+      memory_compare_func.store(impl.func, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+}
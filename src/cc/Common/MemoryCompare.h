@@ -0,0 +1,82 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Vectorized memory comparison.
+ * Provides memory_compare(), a drop-in replacement for memcmp() used on hot
+ * key comparison paths.  The implementation is chosen at runtime from the
+ * instruction sets supported by the CPU: AVX2, SSE2, or plain scalar code.
+ */
+
+#ifndef Common_MemoryCompare_h
+#define Common_MemoryCompare_h
+
+#include <atomic>
+#include <cstddef>
+
+namespace Hypertable {
+
+/** @addtogroup Common
+ *  @{
+ */
+
+/// Signature of memory comparison implementations
+typedef int (*MemoryCompareFunc)(const void *s1, const void *s2, size_t n);
+
+/// Implementation selected for this CPU
+extern std::atomic<MemoryCompareFunc> memory_compare_func;
+
+/**
+ * Compares two memory regions.
+ * Returns a value with the same sign as memcmp() would return for the same
+ * arguments.
+ *
+ * @param s1 Pointer to first region
+ * @param s2 Pointer to second region
+ * @param n Number of bytes to compare
+ * @return Less than, equal to, or greater than zero if <code>s1</code> is
+ * less than, equal to, or greater than <code>s2</code>
+ */
+inline int memory_compare(const void *s1, const void *s2, size_t n) {
+  return memory_compare_func.load(std::memory_order_relaxed)(s1, s2, n);
+}
+
+/**
+ * Returns name of the implementation in use.
+ * @return One of "avx2", "sse2" or "scalar"
+ */
+extern const char *memory_compare_implementation();
+
+/**
+ * Selects an implementation by name.
+ * Used by tests and benchmarks to compare implementations.
+ *
+ * @param name One of "avx2", "sse2" or "scalar"
+ * @return <i>false</i> if the implementation is unknown or not supported by
+ * the CPU, <i>true</i> otherwise
+ */
+extern bool set_memory_compare_implementation(const char *name);
+
+/** @} */
+
+}
+
+#endif // Common_MemoryCompare_h
@@ -325,6 +325,16 @@ class PageArena : boost::noncopyable {
     m_gappy_limit = 0;
   }
 
+  /** Calls <code>fn(begin, end)</code> with the boundaries of each page.
+   * Lets callers that hold on to the arena reference its memory without
+   * copying it.  Memory handed out from the tiny buffer is not included.
+   */
+  template <typename FnT>
+  void for_each_page(FnT fn) const {
+    for (Page *page = m_cur_page; page; page = page->next_page)
+      fn((const CharT *)page->buf, (const CharT *)page->page_end);
+  }
+
   /** Efficiently swaps the state with another allocator */
   void swap(Self &other) {
     std::swap(m_cur_page, other.m_cur_page);
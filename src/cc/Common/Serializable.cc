@@ -69,7 +69,7 @@ void Serializable::encode(uint8_t **bufp) const {
 
 void Serializable::decode(const uint8_t **bufp, size_t *remainp) {
   uint8_t version = Serialization::decode_i8(bufp, remainp);
-  if (version > encoding_version())
+  if (version > decoding_version())
     HT_THROWF(Error::PROTOCOL_ERROR, "Unsupported version %d", (int)version);
   size_t encoding_length = Serialization::decode_vi32(bufp, remainp);
   const uint8_t *end = *bufp + encoding_length;
@@ -61,7 +61,8 @@ namespace Hypertable {
   /// A change in the encoding version number means that the encoding has
   /// changed in a forward incompatible way.  The decode() function will throw
   /// an Exception with code Error::PROTOCOL_ERROR if the version being decoded
-  /// is greater than the version returned by encoding_version().
+  /// is greater than the version returned by decoding_version(), which
+  /// defaults to encoding_version().
   class Serializable {
 
   public:
@@ -85,7 +86,7 @@ namespace Hypertable {
     /// @param remainp Address of integer holding amount of remaining buffer
     /// @see encode() for encoding format
     /// @throws Exception with code Error::PROTOCOL_ERROR if version being
-    /// decoded is greater than that returned by encoding_version().
+    /// decoded is greater than that returned by decoding_version().
     virtual void decode(const uint8_t **bufp, size_t *remainp);
 
   protected:
@@ -94,6 +95,13 @@ namespace Hypertable {
     /// @return Encoding version
     virtual uint8_t encoding_version() const = 0;
 
+    /// Returns highest encoding version that can be decoded.
+    /// Objects that choose their encoding version by their state, so as to
+    /// stay readable by older decoders when they can, override this to
+    /// return the highest version they may encode.
+    /// @return Highest decodable encoding version
+    virtual uint8_t decoding_version() const { return encoding_version(); }
+
     /// Returns internal serialized length.
     /// This function is to be overridden by derived classes and should return
     /// the length of the the serialized object per-se.
@@ -172,6 +172,75 @@ struct BloomFilterTest {
 
     delete filter_with_checksum;
 
+    test_blocked<HashT>(label);
+  }
+
+  /** Exercises the cache-line blocked layout, which probes with a single
+   * 64-bit hash instead of one MurmurHash2 per bit. */
+  template <class HashT>
+  void test_blocked(const String &label) {
+    size_t nitems = items.size() / 2;
+    size_t nfalses = items.size() - nitems;
+    double false_positives = 0.;
+
+    BasicBloomFilter<HashT> filter(nitems, fp_prob,
+                                   BLOOM_FILTER_LAYOUT_BLOCKED);
+
+    cout << label << " (blocked)" << endl;
+
+    HT_ASSERT(filter.get_length_bits() % BlockedBloomFilter::BLOCK_BITS == 0);
+
+    MEASURE("  insert", for (size_t i = 0; i < nitems; ++i)
+      filter.insert(items[i].data), nitems);
+
+    MEASURE("  true positives", for (size_t i = 0; i < nitems; ++i)
+      HT_ASSERT(filter.may_contain(items[i].data)), nitems);
+
+    MEASURE("  false positives",
+      for (size_t i = nitems, n = items.size(); i < n; ++i)
+        if (filter.may_contain(items[i].data))
+          ++false_positives, nfalses);
+
+    cout << "  false positive rate: expected "<< fp_prob <<", got "
+         << false_positives / nfalses << endl;
+
+    // Blocking costs some accuracy, but not more than a small factor
+    HT_ASSERT(false_positives / nfalses < 3 * fp_prob);
+
+    BasicBloomFilterWithChecksum<HashT> *filter_with_checksum =
+      new BasicBloomFilterWithChecksum<HashT>(nitems, fp_prob,
+                                              BLOOM_FILTER_LAYOUT_BLOCKED);
+
+    for (size_t i = 0; i < nitems; ++i)
+      filter_with_checksum->insert(items[i].data);
+
+    StaticBuffer sbuf;
+    filter_with_checksum->serialize(sbuf);
+
+    StaticBuffer serialized_buf(sbuf.size);
+    memcpy(serialized_buf.base, sbuf.base, sbuf.size);
+
+    size_t items_actual = filter_with_checksum->get_items_actual();
+    int64_t length = filter_with_checksum->get_length_bits();
+    size_t num_hashes = filter_with_checksum->get_num_hashes();
+
+    delete filter_with_checksum;
+
+    filter_with_checksum = new BasicBloomFilterWithChecksum<HashT>(
+        items_actual, items_actual, length, num_hashes,
+        BLOOM_FILTER_LAYOUT_BLOCKED);
+
+    memcpy(filter_with_checksum->base(), serialized_buf.base, serialized_buf.size);
+
+    String fname = "bloom_filter_test";
+    filter_with_checksum->validate(fname);
+
+    cout << label << " (blocked with checksum deserialized)" << endl;
+
+    MEASURE("  true positives", for (size_t i = 0; i < nitems; ++i)
+      HT_ASSERT(filter_with_checksum->may_contain(items[i].data)), nitems);
+
+    delete filter_with_checksum;
   }
 
   void run() {
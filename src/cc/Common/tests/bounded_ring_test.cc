@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+#include <Common/BoundedRing.h>
+#include <Common/Logger.h>
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  void test_basic() {
+    BoundedRing<int> ring(3);
+    int item;
+
+    HT_ASSERT(ring.empty());
+    HT_ASSERT(!ring.try_pop(item));
+    for (int i=0; i<4; i++)
+      HT_ASSERT(ring.try_push(i));
+    HT_ASSERT(ring.full());
+    HT_ASSERT(ring.size() == 4);
+    HT_ASSERT(!ring.try_push(4));
+    for (int i=0; i<4; i++) {
+      HT_ASSERT(ring.try_pop(item));
+      HT_ASSERT(item == i);
+    }
+    HT_ASSERT(ring.empty());
+  }
+
+  /// Passes count items through a small ring so both sides block often
+  void test_ordering(size_t count) {
+    BoundedRing<size_t> ring(8);
+
+    thread producer([&ring, count](){
+        for (size_t i=0; i<count; i++)
+          HT_ASSERT(ring.push(i));
+      });
+
+    size_t item;
+    for (size_t i=0; i<count; i++) {
+      HT_ASSERT(ring.pop(item));
+      HT_ASSERT(item == i);
+    }
+    producer.join();
+    HT_ASSERT(ring.empty());
+  }
+
+  void test_close() {
+    BoundedRing<int> ring(1);
+    int item;
+
+    thread consumer([&ring](){
+        int item;
+        HT_ASSERT(!ring.pop(item));
+      });
+    this_thread::sleep_for(chrono::milliseconds(50));
+    ring.close();
+    consumer.join();
+
+    BoundedRing<int> full_ring(1);
+    HT_ASSERT(full_ring.try_push(1));
+    thread producer([&full_ring](){
+        HT_ASSERT(!full_ring.push(2));
+      });
+    this_thread::sleep_for(chrono::milliseconds(50));
+    full_ring.close();
+    producer.join();
+    HT_ASSERT(!full_ring.pop(item));
+  }
+
+}
+
+int main(int argc, char **argv) {
+  test_basic();
+  test_ordering(1000000);
+  test_close();
+  cout << "SUCCESS" << endl;
+  return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+#include <Common/Compat.h>
+#include <Common/Checksum.h>
+#include <Common/Stopwatch.h>
+#include <Common/Usage.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *usage[] = {
+    "usage: checksum_benchmark [options]",
+    "",
+    "  --megabytes=<n>  Amount of data to checksum per measurement (default 1024)",
+    "",
+    "  This program measures checksum throughput.  For block sizes typical of",
+    "  Comm messages, commit log blocks and CellStore blocks it reports the",
+    "  throughput of fletcher32 and of each crc32c implementation supported",
+    "  by this CPU, in MB/s.",
+    (const char *)0
+  };
+
+  typedef uint32_t (*ChecksumFunc)(const void *data, size_t len);
+
+  double measure(ChecksumFunc func, const vector<uint8_t> &buf,
+                 size_t block_size, size_t total) {
+    uint32_t sum = 0;
+    size_t iterations = total / block_size;
+    size_t offset = 0;
+    Stopwatch stopwatch;
+    for (size_t i=0; i<iterations; i++) {
+      sum ^= func(buf.data() + offset, block_size);
+      offset += block_size;
+      if (offset + block_size > buf.size())
+        offset = 0;
+    }
+    stopwatch.stop();
+    // keep the result live
+    if (sum == 0x12345678)
+      cout << "";
+    return ((double)iterations * block_size / (1024.0*1024.0)) /
+      stopwatch.elapsed();
+  }
+
+}
+
+int main(int argc, char **argv) {
+  size_t megabytes = 1024;
+
+  for (int i=1; i<argc; i++) {
+    if (!strncmp(argv[i], "--megabytes=", 12))
+      megabytes = atoi(&argv[i][12]);
+    else
+      Usage::dump_and_exit(usage);
+  }
+
+  size_t total = megabytes * 1024 * 1024;
+  vector<uint8_t> buf(8 * 1024 * 1024);
+  for (size_t i=0; i<buf.size(); i++)
+    buf[i] = (uint8_t)(i * 2654435761U >> 24);
+
+  const char *implementations[] = { "pclmul", "sse42", "scalar" };
+  size_t block_sizes[] = { 256, 4096, 65536, 1048576 };
+
+  cout << setw(12) << "block size" << setw(12) << "fletcher32";
+  for (auto name : implementations)
+    cout << setw(12) << name;
+  cout << endl;
+
+  for (auto block_size : block_sizes) {
+    cout << setw(12) << block_size << setw(12) << fixed << setprecision(0)
+         << measure(fletcher32, buf, block_size, total);
+    for (auto name : implementations) {
+      if (set_crc32c_implementation(name))
+        cout << setw(12) << measure(crc32c, buf, block_size, total);
+      else
+        cout << setw(12) << "-";
+    }
+    cout << endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+#include <Common/Compat.h>
+#include <Common/Checksum.h>
+#include <Common/Logger.h>
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *implementations[] = { "pclmul", "sse42", "scalar" };
+
+  void test_known_values() {
+    HT_ASSERT(crc32c("", 0) == 0);
+    HT_ASSERT(crc32c("123456789", 9) == 0xE3069283);
+    // RFC 3720 B.4, 32 bytes of zeros and 32 bytes of ones
+    vector<uint8_t> buf(32, 0);
+    HT_ASSERT(crc32c(buf.data(), buf.size()) == 0x8A9136AA);
+    memset(buf.data(), 0xff, buf.size());
+    HT_ASSERT(crc32c(buf.data(), buf.size()) == 0x62A8AB43);
+    HT_ASSERT(checksum(CHECKSUM_CRC32C, "123456789", 9) == 0xE3069283);
+    HT_ASSERT(checksum(CHECKSUM_FLETCHER32, "123456789", 9) ==
+              fletcher32("123456789", 9));
+  }
+
+  /// Checks every supported implementation against the scalar one, over
+  /// lengths around the interleaved block boundaries and odd alignments.
+  void test_implementations() {
+    vector<uint8_t> buf(100000);
+    uint32_t seed = 1;
+    for (auto &b : buf) {
+      seed = seed * 1103515245 + 12345;
+      b = (uint8_t)(seed >> 16);
+    }
+    size_t lengths[] = { 1, 7, 8, 9, 255, 767, 768, 769, 1000, 4096, 24575,
+                         24576, 24577, 65536, 99000 };
+    for (auto len : lengths) {
+      for (size_t offset=0; offset<4; offset++) {
+        HT_ASSERT(set_crc32c_implementation("scalar"));
+        uint32_t expected = crc32c(buf.data() + offset, len);
+        for (auto name : implementations) {
+          if (!set_crc32c_implementation(name))
+            continue;
+          HT_ASSERT(crc32c(buf.data() + offset, len) == expected);
+        }
+      }
+    }
+  }
+
+}
+
+int main(int argc, char **argv) {
+  for (auto name : implementations) {
+    if (!set_crc32c_implementation(name)) {
+      cout << name << " not supported" << endl;
+      continue;
+    }
+    test_known_values();
+  }
+  test_implementations();
+  return 0;
+}
@@ -24,6 +24,7 @@
 
 #include "OpenFileMap.h"
 #include "Response/Callback/Open.h"
+#include "Response/Callback/Preadv.h"
 #include "Response/Callback/Read.h"
 #include "Response/Callback/Append.h"
 #include "Response/Callback/Length.h"
@@ -140,6 +141,21 @@ namespace Lib {
     virtual void pread(Response::Callback::Read *cb, uint32_t fd, uint64_t offset,
                        uint32_t amount, bool verify_checksum) = 0;
 
+    /**
+     * Read several extents from file in one request.  Brokers that do not
+     * override this respond with Error::NOT_IMPLEMENTED, upon which clients
+     * fall back to one pread per extent.
+     * @param fd Open fd to read from.
+     * @param extents Extents to read.
+     * @param verify_checksum Verify checksum of data read
+     * @param cb
+     */
+    virtual void preadv(Response::Callback::Preadv *cb, uint32_t fd,
+                        const std::vector<Filesystem::Extent> &extents,
+                        bool verify_checksum) {
+      cb->error(Error::NOT_IMPLEMENTED, "preadv not supported by broker");
+    }
+
 
     /**
      * Make a directory hierarcy, If the parent dirs are not,
@@ -39,6 +39,7 @@
 #include "Request/Parameters/Mkdirs.h"
 #include "Request/Parameters/Open.h"
 #include "Request/Parameters/Pread.h"
+#include "Request/Parameters/Preadv.h"
 #include "Request/Parameters/Readdir.h"
 #include "Request/Parameters/Read.h"
 #include "Request/Parameters/Remove.h"
@@ -51,6 +52,7 @@
 #include "Response/Parameters/Exists.h"
 #include "Response/Parameters/Length.h"
 #include "Response/Parameters/Open.h"
+#include "Response/Parameters/Preadv.h"
 #include "Response/Parameters/Read.h"
 #include "Response/Parameters/Readdir.h"
 #include "Response/Parameters/Status.h"
@@ -717,6 +719,91 @@ void Client::decode_response_pread(EventPtr &event, const void **buffer,
   decode_response_read(event, buffer, offset, length);
 }
 
+
+void
+Client::preadv(int32_t fd, const vector<Extent> &extents,
+               bool verify_checksum, DispatchHandler *handler) {
+  CommHeader header(Request::Handler::Factory::FUNCTION_PREADV);
+  header.gid = fd;
+  Request::Parameters::Preadv params(fd, extents, verify_checksum);
+  CommBufPtr cbuf( new CommBuf(header, params.encoded_length()) );
+  params.encode(cbuf->get_data_ptr_address());
+
+  try { send_message(cbuf, handler); }
+  catch (Exception &e) {
+    HT_THROW2F(e.code(), e, "Error sending preadv request for %u extents "
+               "on FS fd %d", (unsigned)extents.size(), (int)fd);
+  }
+}
+
+
+size_t
+Client::preadv(int32_t fd, const vector<Extent> &extents, void *dst,
+               bool verify_checksum) {
+  DispatchHandlerSynchronizer sync_handler;
+  EventPtr event;
+  uint8_t *ptr = (uint8_t *)dst;
+  size_t total {};
+
+  try {
+    preadv(fd, extents, verify_checksum, &sync_handler);
+
+    if (!sync_handler.wait_for_reply(event)) {
+      int error = Protocol::response_code(event.get());
+      // Brokers that predate preadv reject it, so read extent by extent
+      if (error == Error::NOT_IMPLEMENTED || error == Error::PROTOCOL_ERROR) {
+        for (auto &extent : extents) {
+          total += pread(fd, ptr, extent.length, extent.offset,
+                         verify_checksum);
+          ptr += extent.length;
+        }
+        return total;
+      }
+      HT_THROW(error, Protocol::string_format_message(event).c_str());
+    }
+
+    vector<Extent> extents_read;
+    vector<const void *> buffers;
+    decode_response_preadv(event, extents_read, buffers);
+    HT_ASSERT(extents_read.size() == extents.size());
+    for (size_t i=0; i<extents.size(); i++) {
+      HT_ASSERT(extents_read[i].length <= extents[i].length);
+      memcpy(ptr, buffers[i], extents_read[i].length);
+      ptr += extents[i].length;
+      total += extents_read[i].length;
+    }
+    return total;
+  }
+  catch (Exception &e) {
+    HT_THROW2F(e.code(), e, "Error preading %u extents on FS fd %d",
+               (unsigned)extents.size(), (int)fd);
+  }
+}
+
+void Client::decode_response_preadv(EventPtr &event, vector<Extent> &extents,
+                                    vector<const void *> &buffers) {
+  int error = Protocol::response_code(event);
+  if (error != Error::OK)
+    HT_THROW(error, Protocol::string_format_message(event));
+
+  const uint8_t *ptr = event->payload + 4;
+  size_t remain = event->payload_len - 4;
+
+  Response::Parameters::Preadv params;
+  params.decode(&ptr, &remain);
+  extents = params.get_extents();
+  const vector<uint32_t> &positions = params.get_positions();
+
+  buffers.clear();
+  buffers.reserve(extents.size());
+  for (size_t i=0; i<extents.size(); i++) {
+    if (remain < (size_t)positions[i] + extents[i].length)
+      HT_THROWF(Error::RESPONSE_TRUNCATED, "%lu < %lu", (Lu)remain,
+                (Lu)positions[i] + extents[i].length);
+    buffers.push_back(ptr + positions[i]);
+  }
+}
+
 void Client::mkdirs(const String &name, DispatchHandler *handler) {
   CommHeader header(Request::Handler::Factory::FUNCTION_MKDIRS);
   Request::Parameters::Mkdirs params(name);
@@ -159,6 +159,13 @@ namespace Lib {
     void decode_response_pread(EventPtr &event, const void **buffer,
                                uint64_t *offset, uint32_t *length) override;
 
+    void preadv(int32_t fd, const std::vector<Extent> &extents,
+                bool verify_checksum, DispatchHandler *handler) override;
+    size_t preadv(int32_t fd, const std::vector<Extent> &extents, void *dst,
+                  bool verify_checksum) override;
+    void decode_response_preadv(EventPtr &event, std::vector<Extent> &extents,
+                                std::vector<const void *> &buffers) override;
+
     void mkdirs(const String &name, DispatchHandler *handler) override;
     void mkdirs(const String &name) override;
 
@@ -39,6 +39,7 @@
 #include "Mkdirs.h"
 #include "Open.h"
 #include "Pread.h"
+#include "Preadv.h"
 #include "Readdir.h"
 #include "Read.h"
 #include "Remove.h"
@@ -95,6 +96,8 @@ ApplicationHandler *Factory::create(Comm *comm, Broker *broker,
     return new Debug(comm, broker, event);
   case FUNCTION_SYNC:
     return new Sync(comm, broker, event);
+  case FUNCTION_PREADV:
+    return new Preadv(comm, broker, event);
   default:
     HT_THROWF(Error::INVALID_METHOD_IDENTIFIER,
               "%d", (int)event->header.command);
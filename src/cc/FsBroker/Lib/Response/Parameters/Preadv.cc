@@ -0,0 +1,71 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for Preadv response parameters.
+/// This file contains definitions for Preadv, a class for encoding and
+/// decoding paramters to the <i>preadv</i> file system broker function.
+
+#include <Common/Compat.h>
+
+#include "Preadv.h"
+
+#include <Common/Error.h>
+#include <Common/Logger.h>
+#include <Common/Serialization.h>
+
+using namespace Hypertable;
+using namespace Hypertable::FsBroker::Lib::Response::Parameters;
+
+uint8_t Preadv::encoding_version() const {
+  return 1;
+}
+
+size_t Preadv::encoded_length_internal() const {
+  return 4 + m_extents.size()*16;
+}
+
+void Preadv::encode_internal(uint8_t **bufp) const {
+  HT_ASSERT(m_extents.size() == m_positions.size());
+  Serialization::encode_i32(bufp, m_extents.size());
+  for (size_t i=0; i<m_extents.size(); i++) {
+    Serialization::encode_i64(bufp, m_extents[i].offset);
+    Serialization::encode_i32(bufp, m_extents[i].length);
+    Serialization::encode_i32(bufp, m_positions[i]);
+  }
+}
+
+void Preadv::decode_internal(uint8_t version, const uint8_t **bufp,
+			     size_t *remainp) {
+  (void)version;
+  uint32_t count = Serialization::decode_i32(bufp, remainp);
+  m_extents.clear();
+  m_extents.reserve(count);
+  m_positions.clear();
+  m_positions.reserve(count);
+  for (uint32_t i=0; i<count; i++) {
+    Filesystem::Extent extent;
+    extent.offset = Serialization::decode_i64(bufp, remainp);
+    extent.length = Serialization::decode_i32(bufp, remainp);
+    m_extents.push_back(extent);
+    m_positions.push_back(Serialization::decode_i32(bufp, remainp));
+  }
+}
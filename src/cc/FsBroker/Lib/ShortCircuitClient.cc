@@ -0,0 +1,566 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for ShortCircuitClient.
+/// This file contains definitions for ShortCircuitClient, a client proxy
+/// class for the local file system broker that performs file I/O directly.
+
+#include <Common/Compat.h>
+
+#include "ShortCircuitClient.h"
+
+#include "Response/Parameters/Append.h"
+#include "Response/Parameters/Open.h"
+#include "Response/Parameters/Preadv.h"
+#include "Response/Parameters/Read.h"
+
+#include <AsyncComm/ApplicationHandler.h>
+#include <AsyncComm/DispatchHandlerSynchronizer.h>
+#include <AsyncComm/Event.h>
+#include <AsyncComm/Protocol.h>
+
+#include <Common/FileUtils.h>
+#include <Common/Logger.h>
+#include <Common/Path.h>
+#include <Common/Serialization.h>
+#include <Common/StaticBuffer.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+extern "C" {
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+}
+
+using namespace Hypertable;
+using namespace Serialization;
+using namespace Hypertable::FsBroker;
+using namespace Hypertable::FsBroker::Lib;
+using namespace std;
+
+namespace {
+
+  /// Maps an <code>errno</code> value to an error code the same way the
+  /// local broker does when reporting errors.
+  int errno_to_error(int err) {
+    if (err == ENOTDIR || err == ENAMETOOLONG || err == ENOENT)
+      return Error::FSBROKER_BAD_FILENAME;
+    else if (err == EACCES || err == EPERM)
+      return Error::FSBROKER_PERMISSION_DENIED;
+    else if (err == EBADF)
+      return Error::FSBROKER_BAD_FILE_HANDLE;
+    else if (err == EINVAL)
+      return Error::FSBROKER_INVALID_ARGUMENT;
+    return Error::FSBROKER_IO_ERROR;
+  }
+
+  /// Creates a message event with an uninitialized payload.
+  EventPtr make_event(size_t payload_len) {
+    EventPtr event = make_shared<Event>(Event::MESSAGE);
+    event->payload = new uint8_t [payload_len];
+    event->payload_len = payload_len;
+    return event;
+  }
+
+  /// Application handler carrying out a queued asynchronous operation.
+  class OperationHandler : public ApplicationHandler {
+  public:
+    OperationHandler(EventPtr &event, function<void()> op)
+      : ApplicationHandler(event), m_op(op) { }
+    void run() override { m_op(); }
+  private:
+    /// Operation
+    function<void()> m_op;
+  };
+
+}
+
+
+ShortCircuitClient::ShortCircuitClient(ConnectionManagerPtr &conn_mgr,
+                                       PropertiesPtr &cfg)
+  : Client(conn_mgr, cfg) {
+  Path root;
+  if (cfg->has("DfsBroker.Local.Root"))
+    root = Path(cfg->get_str("DfsBroker.Local.Root"));
+  else if (cfg->has("FsBroker.Local.Root"))
+    root = Path(cfg->get_str("FsBroker.Local.Root"));
+  else
+    root = Path("fs/local");
+
+  if (!root.is_complete()) {
+    Path data_dir = cfg->get_str("Hypertable.DataDirectory");
+    root = data_dir / root;
+  }
+
+  m_rootdir = root.string();
+
+  if (cfg->has("DfsBroker.Local.DirectIO"))
+    m_directio = cfg->get_bool("DfsBroker.Local.DirectIO");
+  else
+    m_directio = cfg->get_bool("FsBroker.Local.DirectIO");
+
+  m_app_queue =
+    make_shared<ApplicationQueue>(cfg->get_i32("FsBroker.ShortCircuit.Workers"));
+
+  HT_INFOF("Short-circuiting FS broker file I/O under %s", m_rootdir.c_str());
+}
+
+
+void
+ShortCircuitClient::open(const String &name, uint32_t flags,
+                         DispatchHandler *handler) {
+  enqueue(-1, [this, name, flags, handler]() {
+      try {
+        Response::Parameters::Open params(open(name, flags));
+        respond(handler, &params);
+      }
+      catch (Exception &e) {
+        respond_error(handler, e);
+      }
+    });
+}
+
+
+int ShortCircuitClient::open(const String &name, uint32_t flags) {
+  String abspath = local_path(name);
+  int oflags = O_RDONLY;
+  int fd;
+
+  if (m_directio && flags & Filesystem::OPEN_FLAG_DIRECTIO) {
+#ifdef O_DIRECT
+    oflags |= O_DIRECT;
+#endif
+  }
+
+  if ((fd = ::open(abspath.c_str(), oflags)) == -1) {
+    int error = errno;
+    HT_THROWF(errno_to_error(error), "Error opening FS file: %s - %s",
+              abspath.c_str(), strerror(error));
+  }
+
+  HT_DEBUGF("open( %s ) = %d (local)", name.c_str(), fd);
+  return fd;
+}
+
+
+int
+ShortCircuitClient::open_buffered(const String &name, uint32_t flags,
+                                  uint32_t buf_size, uint32_t outstanding,
+                                  uint64_t start_offset, uint64_t end_offset) {
+  int fd = open(name, flags);
+  // The page cache takes the place of the broker's outstanding read buffers
+  if (start_offset && lseek(fd, (off_t)start_offset, SEEK_SET) == (off_t)-1) {
+    int error = errno;
+    ::close(fd);
+    HT_THROWF(errno_to_error(error), "Error seeking to %llu in FS file: %s"
+              " - %s", (Llu)start_offset, name.c_str(), strerror(error));
+  }
+#if defined(POSIX_FADV_SEQUENTIAL)
+  posix_fadvise(fd, (off_t)start_offset,
+                end_offset ? (off_t)(end_offset - start_offset) : 0,
+                POSIX_FADV_SEQUENTIAL);
+#endif
+  return fd;
+}
+
+
+void
+ShortCircuitClient::create(const String &name, uint32_t flags, int32_t bufsz,
+                           int32_t replication, int64_t blksz,
+                           DispatchHandler *handler) {
+  enqueue(-1, [this, name, flags, bufsz, replication, blksz, handler]() {
+      try {
+        Response::Parameters::Open
+          params(create(name, flags, bufsz, replication, blksz));
+        respond(handler, &params);
+      }
+      catch (Exception &e) {
+        respond_error(handler, e);
+      }
+    });
+}
+
+
+int
+ShortCircuitClient::create(const String &name, uint32_t flags, int32_t bufsz,
+                           int32_t replication, int64_t blksz) {
+  String abspath = local_path(name);
+  int oflags = O_WRONLY | O_CREAT;
+  int fd;
+
+  if (flags & Filesystem::OPEN_FLAG_OVERWRITE)
+    oflags |= O_TRUNC;
+  else
+    oflags |= O_APPEND;
+
+  if (m_directio && flags & Filesystem::OPEN_FLAG_DIRECTIO) {
+#ifdef O_DIRECT
+    oflags |= O_DIRECT;
+#endif
+  }
+
+  if ((fd = ::open(abspath.c_str(), oflags, 0644)) == -1) {
+    int error = errno;
+    HT_THROWF(errno_to_error(error), "Error creating FS file: %s - %s",
+              abspath.c_str(), strerror(error));
+  }
+
+  HT_DEBUGF("create( %s ) = %d (local)", name.c_str(), fd);
+  return fd;
+}
+
+
+void ShortCircuitClient::close(int32_t fd, DispatchHandler *handler) {
+  enqueue(fd, [this, fd, handler]() {
+      if (::close(fd) == -1) {
+        int error = errno;
+        Exception e(errno_to_error(error), format("Error closing FS fd: %d - %s",
+                                                  (int)fd, strerror(error)));
+        respond_error(handler, e);
+        return;
+      }
+      respond(handler);
+    });
+}
+
+
+void ShortCircuitClient::close(int32_t fd) {
+  DispatchHandlerSynchronizer sync_handler;
+  EventPtr event;
+  close(fd, &sync_handler);
+  if (!sync_handler.wait_for_reply(event))
+    HT_THROW(Protocol::response_code(event.get()),
+             Protocol::string_format_message(event).c_str());
+}
+
+
+void
+ShortCircuitClient::read(int32_t fd, size_t len, DispatchHandler *handler) {
+  enqueue(fd, [this, fd, len, handler]() {
+      try {
+        off_t offset = lseek(fd, 0, SEEK_CUR);
+        if (offset == (off_t)-1) {
+          int error = errno;
+          HT_THROWF(errno_to_error(error), "Error reading %u bytes from FS "
+                    "fd %d - %s", (unsigned)len, (int)fd, strerror(error));
+        }
+
+        Response::Parameters::Read params((uint64_t)offset, len);
+        size_t header_len = 4 + params.encoded_length();
+        EventPtr event = make_event(header_len + len);
+        uint8_t *ptr = (uint8_t *)event->payload;
+
+        size_t nread = read_local(fd, ptr + header_len, len, -1, false);
+
+        encode_i32(&ptr, Error::OK);
+        Response::Parameters::Read((uint64_t)offset, nread).encode(&ptr);
+        event->payload_len = header_len + nread;
+        handler->handle(event);
+      }
+      catch (Exception &e) {
+        respond_error(handler, e);
+      }
+    });
+}
+
+
+size_t ShortCircuitClient::read(int32_t fd, void *dst, size_t len) {
+  return read_local(fd, dst, len, -1, false);
+}
+
+
+void
+ShortCircuitClient::append(int32_t fd, StaticBuffer &buffer, Flags flags,
+                           DispatchHandler *handler) {
+  // Take ownership of the buffer, as Client does when it sends the request
+  auto data = make_shared<StaticBuffer>(buffer);
+  enqueue(fd, [this, fd, data, flags, handler]() {
+      try {
+        off_t offset = lseek(fd, 0, SEEK_CUR);
+        if (offset == (off_t)-1) {
+          int error = errno;
+          HT_THROWF(errno_to_error(error), "Error appending %u bytes to FS "
+                    "fd %d - %s", (unsigned)data->size, (int)fd,
+                    strerror(error));
+        }
+        size_t amount = append(fd, *data, flags);
+        Response::Parameters::Append params((uint64_t)offset, amount);
+        respond(handler, &params);
+      }
+      catch (Exception &e) {
+        respond_error(handler, e);
+      }
+    });
+}
+
+
+size_t
+ShortCircuitClient::append(int32_t fd, StaticBuffer &buffer, Flags flags) {
+  // Direct i/o needs an aligned source buffer
+  if (is_directio(fd) && (uintptr_t)buffer.base % HT_DIRECT_IO_ALIGNMENT) {
+    StaticBuffer aligned(buffer.size, (size_t)HT_DIRECT_IO_ALIGNMENT);
+    memcpy(aligned.base, buffer.base, buffer.size);
+    return append(fd, aligned, flags);
+  }
+
+  ssize_t nwritten = FileUtils::write(fd, buffer.base, buffer.size);
+  if (nwritten == -1) {
+    int error = errno;
+    HT_THROWF(errno_to_error(error), "Error appending %u bytes to FS fd %d"
+              " - %s", (unsigned)buffer.size, (int)fd, strerror(error));
+  }
+  if (flags == Flags::FLUSH || flags == Flags::SYNC)
+    sync(fd);
+  return nwritten;
+}
+
+
+void
+ShortCircuitClient::seek(int32_t fd, uint64_t offset,
+                         DispatchHandler *handler) {
+  enqueue(fd, [this, fd, offset, handler]() {
+      try {
+        seek(fd, offset);
+        respond(handler);
+      }
+      catch (Exception &e) {
+        respond_error(handler, e);
+      }
+    });
+}
+
+
+void ShortCircuitClient::seek(int32_t fd, uint64_t offset) {
+  if (lseek(fd, (off_t)offset, SEEK_SET) == (off_t)-1) {
+    int error = errno;
+    HT_THROWF(errno_to_error(error), "Error seeking to %llu on FS fd %d - %s",
+              (Llu)offset, (int)fd, strerror(error));
+  }
+}
+
+
+void
+ShortCircuitClient::pread(int32_t fd, size_t len, uint64_t offset,
+                          bool verify_checksum, DispatchHandler *handler) {
+  enqueue(fd, [this, fd, len, offset, verify_checksum, handler]() {
+      try {
+        Response::Parameters::Read params(offset, len);
+        size_t header_len = 4 + params.encoded_length();
+        EventPtr event = make_event(header_len + len);
+        uint8_t *ptr = (uint8_t *)event->payload;
+
+        // Read straight into the response payload
+        size_t nread = read_local(fd, ptr + header_len, len, (int64_t)offset,
+                                  verify_checksum);
+
+        encode_i32(&ptr, Error::OK);
+        Response::Parameters::Read(offset, nread).encode(&ptr);
+        event->payload_len = header_len + nread;
+        handler->handle(event);
+      }
+      catch (Exception &e) {
+        respond_error(handler, e);
+      }
+    });
+}
+
+
+size_t
+ShortCircuitClient::pread(int32_t fd, void *dst, size_t len, uint64_t offset,
+                          bool verify_checksum) {
+  return read_local(fd, dst, len, (int64_t)offset, verify_checksum);
+}
+
+
+void
+ShortCircuitClient::preadv(int32_t fd, const vector<Extent> &extents,
+                           bool verify_checksum, DispatchHandler *handler) {
+  enqueue(fd, [this, fd, extents, verify_checksum, handler]() {
+      try {
+        vector<Extent> extents_read(extents);
+        vector<uint32_t> positions;
+        size_t data_len {};
+
+        positions.reserve(extents.size());
+        for (auto &extent : extents) {
+          positions.push_back(data_len);
+          data_len += extent.length;
+        }
+
+        Response::Parameters::Preadv params(extents, positions);
+        size_t header_len = 4 + params.encoded_length();
+        EventPtr event = make_event(header_len + data_len);
+        uint8_t *ptr = (uint8_t *)event->payload;
+
+        // Read straight into the response payload
+        for (size_t i=0; i<extents.size(); i++)
+          extents_read[i].length =
+            read_local(fd, ptr + header_len + positions[i], extents[i].length,
+                       (int64_t)extents[i].offset, verify_checksum);
+
+        encode_i32(&ptr, Error::OK);
+        Response::Parameters::Preadv(extents_read, positions).encode(&ptr);
+        handler->handle(event);
+      }
+      catch (Exception &e) {
+        respond_error(handler, e);
+      }
+    });
+}
+
+
+size_t
+ShortCircuitClient::preadv(int32_t fd, const vector<Extent> &extents,
+                           void *dst, bool verify_checksum) {
+  uint8_t *ptr = (uint8_t *)dst;
+  size_t total {};
+  for (auto &extent : extents) {
+    total += pread(fd, ptr, extent.length, extent.offset, verify_checksum);
+    ptr += extent.length;
+  }
+  return total;
+}
+
+
+void ShortCircuitClient::flush(int32_t fd, DispatchHandler *handler) {
+  enqueue(fd, [this, fd, handler]() {
+      try {
+        flush(fd);
+        respond(handler);
+      }
+      catch (Exception &e) {
+        respond_error(handler, e);
+      }
+    });
+}
+
+
+void ShortCircuitClient::flush(int32_t fd) {
+  sync(fd);
+}
+
+
+void ShortCircuitClient::sync(int32_t fd) {
+  if (fsync(fd) != 0) {
+    int error = errno;
+    HT_THROWF(errno_to_error(error), "Error syncing FS fd %d - %s",
+              (int)fd, strerror(error));
+  }
+}
+
+
+void ShortCircuitClient::enqueue(int32_t fd, function<void()> op) {
+  // Like the broker, serialize operations on a descriptor with its group id
+  EventPtr event = make_shared<Event>(Event::MESSAGE);
+  event->group_id = fd < 0 ? 0 : (uint64_t)fd + 1;
+  m_app_queue->add(new OperationHandler(event, op));
+}
+
+
+bool ShortCircuitClient::is_directio(int32_t fd) {
+#ifdef O_DIRECT
+  if (m_directio) {
+    int oflags = fcntl(fd, F_GETFL);
+    return oflags != -1 && (oflags & O_DIRECT) != 0;
+  }
+#endif
+  return false;
+}
+
+
+size_t
+ShortCircuitClient::read_local(int32_t fd, void *dst, size_t len,
+                               int64_t offset, bool verify_checksum) {
+  ssize_t nread;
+
+#if defined(POSIX_FADV_DONTNEED)
+  if (verify_checksum && offset >= 0)
+    posix_fadvise(fd, (off_t)offset, (off_t)len, POSIX_FADV_DONTNEED);
+#endif
+
+  if (is_directio(fd) && offset < 0) {
+    StaticBuffer buf(len, (size_t)HT_DIRECT_IO_ALIGNMENT);
+    nread = FileUtils::read(fd, buf.base, len);
+    if (nread > 0)
+      memcpy(dst, buf.base, nread);
+  }
+  else if (is_directio(fd)) {
+    // Widen the read to an aligned window and copy out the requested range
+    int64_t start = offset & ~(int64_t)(HT_DIRECT_IO_ALIGNMENT - 1);
+    size_t skip = offset - start;
+    StaticBuffer buf(skip + len, (size_t)HT_DIRECT_IO_ALIGNMENT);
+    nread = FileUtils::pread(fd, buf.base, buf.aligned_size(), (off_t)start);
+    if (nread != -1) {
+      nread = nread > (ssize_t)skip ? std::min((size_t)nread - skip, len) : 0;
+      memcpy(dst, buf.base + skip, nread);
+    }
+  }
+  else if (offset < 0)
+    nread = FileUtils::read(fd, dst, len);
+  else
+    nread = FileUtils::pread(fd, dst, len, (off_t)offset);
+
+  if (nread == -1) {
+    int error = errno;
+    if (offset < 0)
+      HT_THROWF(errno_to_error(error), "Error reading %u bytes from FS fd %d"
+                " - %s", (unsigned)len, (int)fd, strerror(error));
+    HT_THROWF(errno_to_error(error), "Error preading at byte %llu on FS fd %d"
+              " - %s", (Llu)offset, (int)fd, strerror(error));
+  }
+  return nread;
+}
+
+
+String ShortCircuitClient::local_path(const String &name) const {
+  if (!name.empty() && name[0] == '/')
+    return m_rootdir + name;
+  return m_rootdir + "/" + name;
+}
+
+
+void
+ShortCircuitClient::respond(DispatchHandler *handler,
+                            const Serializable *params) {
+  EventPtr event = make_event(4 + (params ? params->encoded_length() : 0));
+  uint8_t *ptr = (uint8_t *)event->payload;
+  encode_i32(&ptr, Error::OK);
+  if (params)
+    params->encode(&ptr);
+  handler->handle(event);
+}
+
+
+void ShortCircuitClient::respond_error(DispatchHandler *handler, Exception &e) {
+  HT_ERROR_OUT << e << HT_END;
+  const char *msg = e.what();
+  EventPtr event = make_event(4 + encoded_length_str16(msg));
+  uint8_t *ptr = (uint8_t *)event->payload;
+  encode_i32(&ptr, e.code());
+  encode_str16(&ptr, msg);
+  handler->handle(event);
+}
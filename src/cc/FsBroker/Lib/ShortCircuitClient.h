@@ -0,0 +1,217 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for ShortCircuitClient.
+/// This file contains declarations for ShortCircuitClient, a client proxy
+/// class for the local file system broker that performs file I/O directly.
+
+#ifndef FsBroker_Lib_ShortCircuitClient_h
+#define FsBroker_Lib_ShortCircuitClient_h
+
+#include <FsBroker/Lib/Client.h>
+
+#include <AsyncComm/ApplicationQueue.h>
+
+#include <Common/Error.h>
+#include <Common/Properties.h>
+#include <Common/Serializable.h>
+#include <Common/String.h>
+
+#include <functional>
+
+namespace Hypertable {
+namespace FsBroker {
+namespace Lib {
+
+  /// @addtogroup FsBrokerLib
+  /// @{
+
+  /** Short-circuit proxy class for the local FS broker.  When the FS broker
+   * is the local broker running on the same host, files can be opened
+   * directly by the client process.  This class opens, reads, appends to,
+   * seeks, flushes, syncs, and closes files with local system calls on
+   * paths under the local broker's root directory, which avoids the request
+   * round trip to the broker and the copies of the data into and out of the
+   * message buffers.  Namespace operations (mkdirs, rmdir, readdir, remove,
+   * rename, exists, length, and status) are still sent to the broker.
+   * All files are opened locally, so the file descriptors returned are
+   * local descriptors and never mix with broker file handles.  The
+   * asynchronous variants of the file operations are queued on an
+   * application queue and return immediately.  A worker thread performs the
+   * system call and delivers a response event, encoded exactly as the broker
+   * would encode it, to the handler.  Like broker requests, operations on the
+   * same file descriptor are carried out one at a time in the order they
+   * were issued.  Files opened or created with
+   * Filesystem::OPEN_FLAG_DIRECTIO use direct i/o when
+   * <code>FsBroker.Local.DirectIO</code> is set, as they would with the
+   * local broker.
+   */
+  class ShortCircuitClient : public Client {
+  public:
+
+    /** Constructor.  Connects to the FS broker as Client does, determines
+     * the root directory of the local broker from the following properties:
+     * <pre>
+     * FsBroker.Local.Root
+     * Hypertable.DataDirectory
+     * </pre>
+     * and creates the application queue with
+     * <code>FsBroker.ShortCircuit.Workers</code> worker threads.
+     *
+     * @param conn_manager_ptr smart pointer to connection manager
+     * @param cfg config variables map
+     */
+    ShortCircuitClient(ConnectionManagerPtr &conn_manager_ptr,
+                       PropertiesPtr &cfg);
+
+    void open(const String &name, uint32_t flags, DispatchHandler *handler) override;
+    int open(const String &name, uint32_t flags) override;
+    int open_buffered(const String &name, uint32_t flags, uint32_t buf_size,
+                      uint32_t outstanding, uint64_t start_offset=0,
+                      uint64_t end_offset=0) override;
+
+    void create(const String &name, uint32_t flags,
+                int32_t bufsz, int32_t replication,
+                int64_t blksz, DispatchHandler *handler) override;
+    int create(const String &name, uint32_t flags, int32_t bufsz,
+               int32_t replication, int64_t blksz) override;
+
+    void close(int32_t fd, DispatchHandler *handler) override;
+
+    /** Closes a file.  Waits for the asynchronous operations queued on
+     * <code>fd</code> to complete first, so that the descriptor is not
+     * reused while they are outstanding.
+     *
+     * @param fd File descriptor
+     */
+    void close(int32_t fd) override;
+
+    void read(int32_t fd, size_t amount, DispatchHandler *handler) override;
+    size_t read(int32_t fd, void *dst, size_t amount) override;
+
+    void append(int32_t fd, StaticBuffer &buffer, Flags flags,
+                DispatchHandler *handler) override;
+    size_t append(int32_t fd, StaticBuffer &buffer,
+                  Flags flags = Flags::NONE) override;
+
+    void seek(int32_t fd, uint64_t offset, DispatchHandler *handler) override;
+    void seek(int32_t fd, uint64_t offset) override;
+
+    void pread(int32_t fd, size_t len, uint64_t offset,
+               bool verify_checksum, DispatchHandler *handler) override;
+
+    /** Reads data from a file at a given position.  Local files carry no
+     * checksums, so when <code>verify_checksum</code> is set the cached pages
+     * of the range are dropped first and the data is read from the device
+     * rather than from the page cache.  Callers set it when retrying a read
+     * that failed their own checksum check.
+     *
+     * @param fd File descriptor
+     * @param dst Destination buffer
+     * @param len Amount of data to read
+     * @param offset Starting offset of read
+     * @param verify_checksum Bypass cached data
+     * @return Amount of data read
+     */
+    size_t pread(int32_t fd, void *dst, size_t len, uint64_t offset,
+                 bool verify_checksum) override;
+
+    void preadv(int32_t fd, const std::vector<Extent> &extents,
+                bool verify_checksum, DispatchHandler *handler) override;
+    size_t preadv(int32_t fd, const std::vector<Extent> &extents, void *dst,
+                  bool verify_checksum) override;
+
+    void flush(int32_t fd, DispatchHandler *handler) override;
+    void flush(int32_t fd) override;
+
+    void sync(int32_t fd) override;
+
+    /** Gets the local root directory.
+     *
+     * @return absolute path of the local broker's root directory
+     */
+    const String &get_root() const { return m_rootdir; }
+
+  private:
+
+    /// Queues an asynchronous operation on #m_app_queue.
+    /// Operations on the same file descriptor run serially in the order they
+    /// were queued.
+    /// @param fd File descriptor, or -1 for operations not tied to one
+    /// @param op Operation, which delivers its own response event
+    void enqueue(int32_t fd, std::function<void()> op);
+
+    /// Checks if a file descriptor was opened for direct i/o.
+    /// @param fd File descriptor
+    /// @return <i>true</i> if reads and writes on <code>fd</code> must use
+    /// aligned buffers
+    bool is_directio(int32_t fd);
+
+    /// Reads data from a file.
+    /// Reads at the current file position if <code>offset</code> is
+    /// negative.  For direct i/o, reads the aligned window containing the
+    /// requested range into an aligned buffer and copies the range to
+    /// <code>dst</code>.
+    /// @param fd File descriptor
+    /// @param dst Destination buffer
+    /// @param len Amount of data to read
+    /// @param offset Starting offset of read, or -1
+    /// @param verify_checksum Drop cached pages before reading
+    /// @return Amount of data read
+    size_t read_local(int32_t fd, void *dst, size_t len, int64_t offset,
+                      bool verify_checksum);
+
+    /// Maps a file name to its local path under #m_rootdir.
+    /// @param name File name relative to the broker root
+    /// @return Absolute local path
+    String local_path(const String &name) const;
+
+    /// Delivers a response event to a handler.
+    /// Encodes the error code followed by <code>params</code>, if given,
+    /// into the payload of a message event.
+    /// @param handler Response handler
+    /// @param params Response parameters
+    void respond(DispatchHandler *handler, const Serializable *params=0);
+
+    /// Delivers an error event to a handler.
+    /// @param handler Response handler
+    /// @param e Exception describing the error
+    void respond_error(DispatchHandler *handler, Exception &e);
+
+    /// Root directory of the local broker
+    String m_rootdir;
+
+    /// <i>true</i> if files opened with Filesystem::OPEN_FLAG_DIRECTIO use
+    /// direct i/o
+    bool m_directio {};
+
+    /// Queue carrying out asynchronous operations, declared last so that
+    /// outstanding operations complete before the other members are destroyed
+    ApplicationQueuePtr m_app_queue;
+  };
+
+  /// @}
+
+}}}
+
+
+#endif // FsBroker_Lib_ShortCircuitClient_h
@@ -32,6 +32,7 @@
 
 #include <AsyncComm/ReactorFactory.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <chrono>
 #include <cstdio>
@@ -472,6 +473,93 @@ LocalBroker::pread(Response::Callback::Read *cb, uint32_t fd, uint64_t offset,
 }
 
 
+void
+LocalBroker::preadv(Response::Callback::Preadv *cb, uint32_t fd,
+                    const vector<Filesystem::Extent> &extents, bool) {
+  OpenFileDataLocalPtr fdata;
+  vector<uint32_t> positions;
+  vector<Filesystem::Extent> extents_read(extents);
+  size_t total {};
+  int error;
+
+  HT_DEBUGF("preadv fd=%d extents=%d", fd, (int)extents.size());
+
+  if (!m_open_file_map.get(fd, fdata)) {
+    char errbuf[32];
+    sprintf(errbuf, "%d", fd);
+    cb->error(Error::FSBROKER_BAD_FILE_HANDLE, errbuf);
+    m_metrics_handler->increment_error_count();
+    return;
+  }
+
+  // Give each extent an aligned slot so it can be read with direct i/o
+  positions.reserve(extents.size());
+  for (auto &extent : extents) {
+    positions.push_back(total);
+    total += (extent.length + HT_DIRECT_IO_ALIGNMENT - 1) &
+      ~(size_t)(HT_DIRECT_IO_ALIGNMENT - 1);
+  }
+
+  StaticBuffer buf(total, (size_t)HT_DIRECT_IO_ALIGNMENT);
+  total = 0;
+
+  // Read each run of contiguous extents with one preadv() call
+  size_t i = 0;
+  while (i < extents.size()) {
+    struct iovec iov[64];
+    size_t count = 0;
+    do {
+      iov[count].iov_base = buf.base + positions[i+count];
+      iov[count].iov_len = extents[i+count].length;
+      count++;
+    } while (i+count < extents.size() && count < 64 &&
+             extents[i+count].offset ==
+             extents[i+count-1].offset + extents[i+count-1].length);
+
+    ssize_t nread = ::preadv(fdata->fd, iov, count, (off_t)extents[i].offset);
+
+    // Direct i/o rejects unaligned lengths, so read extents one at a time
+    if (nread == -1 && errno == EINVAL) {
+      for (size_t j=i; j<i+count; j++) {
+        size_t aligned_length = (extents[j].length + HT_DIRECT_IO_ALIGNMENT - 1)
+          & ~(size_t)(HT_DIRECT_IO_ALIGNMENT - 1);
+        nread = FileUtils::pread(fdata->fd, buf.base + positions[j],
+                                 aligned_length, (off_t)extents[j].offset);
+        if (nread == -1)
+          break;
+        extents_read[j].length = std::min((uint32_t)nread, extents[j].length);
+        total += extents_read[j].length;
+      }
+    }
+    else if (nread != -1) {
+      size_t remaining = nread;
+      for (size_t j=i; j<i+count; j++) {
+        extents_read[j].length = std::min(remaining, (size_t)extents[j].length);
+        remaining -= extents_read[j].length;
+        total += extents_read[j].length;
+      }
+    }
+
+    if (nread == -1) {
+      error = errno;
+      report_error(cb);
+      m_status_manager.set_read_error(error);
+      HT_ERRORF("preadv failed: fd=%d extents=%d offset=%llu - %s", fdata->fd,
+                (int)count, (Llu)extents[i].offset, strerror(error));
+      return;
+    }
+    i += count;
+  }
+
+  m_metrics_handler->add_bytes_read(total);
+  m_status_manager.clear_status();
+
+  if ((error = cb->response(extents_read, positions, buf)) != Error::OK)
+    HT_ERRORF("Problem sending response for preadv(%u, %u extents) - %s",
+              (unsigned)fd, (unsigned)extents.size(), Error::get_text(error));
+}
+
+
 void LocalBroker::mkdirs(ResponseCallback *cb, const char *dname) {
   String absdir;
   int error;
@@ -81,6 +81,9 @@ namespace FsBroker {
                     bool accurate = true);
     virtual void pread(Response::Callback::Read *cb, uint32_t fd, uint64_t offset,
                        uint32_t amount, bool verify_checksum);
+    virtual void preadv(Response::Callback::Preadv *cb, uint32_t fd,
+                        const std::vector<Filesystem::Extent> &extents,
+                        bool verify_checksum);
     virtual void mkdirs(ResponseCallback *cb, const char *dname);
     virtual void rmdir(ResponseCallback *cb, const char *dname);
     virtual void readdir(Response::Callback::Readdir *cb, const char *dname);
@@ -605,12 +605,19 @@ void BerkeleyDbFilesystem::start_transaction(BDbTxn &txn) {
   return;
 }
 
+StateTxnPtr BerkeleyDbFilesystem::start_transaction() {
+  std::unique_ptr<BDbTxn> txn(new BDbTxn());
+  start_transaction(*txn);
+  return std::move(txn);
+}
+
 
 /*
  */
 bool
-BerkeleyDbFilesystem::get_xattr_i32(BDbTxn &txn, const String &fname,
+BerkeleyDbFilesystem::get_xattr_i32(StateTxn &state_txn, const String &fname,
     const String &aname, uint32_t *valuep) {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   Dbt key;
   DbtManaged data;
@@ -642,8 +649,9 @@ BerkeleyDbFilesystem::get_xattr_i32(BDbTxn &txn, const String &fname,
 /*
  */
 void
-BerkeleyDbFilesystem::set_xattr_i32(BDbTxn &txn, const String &fname,
+BerkeleyDbFilesystem::set_xattr_i32(StateTxn &state_txn, const String &fname,
                                     const String &aname, uint32_t value) {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   Dbt key, data;
   char numbuf[16];
@@ -676,8 +684,9 @@ BerkeleyDbFilesystem::set_xattr_i32(BDbTxn &txn, const String &fname,
 /*
  */
 bool
-BerkeleyDbFilesystem::get_xattr_i64(BDbTxn &txn, const String &fname,
+BerkeleyDbFilesystem::get_xattr_i64(StateTxn &state_txn, const String &fname,
     const String &aname, uint64_t *valuep) {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   Dbt key;
   DbtManaged data;
@@ -709,8 +718,9 @@ BerkeleyDbFilesystem::get_xattr_i64(BDbTxn &txn, const String &fname,
 /*
  */
 void
-BerkeleyDbFilesystem::set_xattr_i64(BDbTxn &txn, const String &fname,
+BerkeleyDbFilesystem::set_xattr_i64(StateTxn &state_txn, const String &fname,
                                     const String &aname, uint64_t value) {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   Dbt key, data;
   char numbuf[24];
@@ -742,8 +752,9 @@ BerkeleyDbFilesystem::set_xattr_i64(BDbTxn &txn, const String &fname,
 /*
  */
 bool
-BerkeleyDbFilesystem::incr_attr(BDbTxn &txn, const String &fname, const String &aname,
+BerkeleyDbFilesystem::incr_attr(StateTxn &state_txn, const String &fname, const String &aname,
                                 uint64_t *valuep) {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   Dbt key, data;
   String keystr = fname;
@@ -804,8 +815,9 @@ BerkeleyDbFilesystem::incr_attr(BDbTxn &txn, const String &fname, const String &
 /*
  */
 void
-BerkeleyDbFilesystem::set_xattr(BDbTxn &txn, const String &fname,
+BerkeleyDbFilesystem::set_xattr(StateTxn &state_txn, const String &fname,
     const String &aname, const void *value, size_t value_len) {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   Dbt key, data;
   String keystr = fname;
@@ -834,8 +846,9 @@ BerkeleyDbFilesystem::set_xattr(BDbTxn &txn, const String &fname,
 /*
  */
 bool
-BerkeleyDbFilesystem::get_xattr(BDbTxn &txn, const String &fname,
+BerkeleyDbFilesystem::get_xattr(StateTxn &state_txn, const String &fname,
                                 const String &aname, DynamicBuffer &vbuf) {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   Dbt key;
   DbtManaged data;
@@ -869,8 +882,9 @@ BerkeleyDbFilesystem::get_xattr(BDbTxn &txn, const String &fname,
 /*
  */
 bool
-BerkeleyDbFilesystem::exists_xattr(BDbTxn &txn, const String &fname, const String &aname)
+BerkeleyDbFilesystem::exists_xattr(StateTxn &state_txn, const String &fname, const String &aname)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   Dbt key;
   String keystr = fname;
@@ -900,8 +914,9 @@ BerkeleyDbFilesystem::exists_xattr(BDbTxn &txn, const String &fname, const Strin
 
 
 void
-BerkeleyDbFilesystem::del_xattr(BDbTxn &txn, const String &fname,
+BerkeleyDbFilesystem::del_xattr(StateTxn &state_txn, const String &fname,
                                 const String &aname) {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   Dbt key;
   String keystr = fname;
@@ -926,7 +941,8 @@ BerkeleyDbFilesystem::del_xattr(BDbTxn &txn, const String &fname,
 
 /*
  */
-void BerkeleyDbFilesystem::mkdir(BDbTxn &txn, const String &name) {
+void BerkeleyDbFilesystem::mkdir(StateTxn &state_txn, const String &name) {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   Dbt key;
   DbtManaged data;
@@ -981,7 +997,8 @@ void BerkeleyDbFilesystem::mkdir(BDbTxn &txn, const String &name) {
 }
 
 
-void BerkeleyDbFilesystem::unlink(BDbTxn &txn, const String &name) {
+void BerkeleyDbFilesystem::unlink(StateTxn &state_txn, const String &name) {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   std::vector<String> delkeys;
   DbtManaged keym, datam;
   Dbt key;
@@ -1048,7 +1065,8 @@ void BerkeleyDbFilesystem::unlink(BDbTxn &txn, const String &name) {
 
 
 bool
-BerkeleyDbFilesystem::exists(BDbTxn &txn, String fname, bool *is_dir_p) {
+BerkeleyDbFilesystem::exists(StateTxn &state_txn, String fname, bool *is_dir_p) {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   Dbt key;
 
@@ -1091,7 +1109,8 @@ BerkeleyDbFilesystem::exists(BDbTxn &txn, String fname, bool *is_dir_p) {
  *
  */
 void
-BerkeleyDbFilesystem::create(BDbTxn &txn, const String &fname, bool temp) {
+BerkeleyDbFilesystem::create(StateTxn &state_txn, const String &fname, bool temp) {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   Dbt key;
   DbtManaged data;
@@ -1139,8 +1158,9 @@ BerkeleyDbFilesystem::create(BDbTxn &txn, const String &fname, bool temp) {
 
 
 void
-BerkeleyDbFilesystem::get_directory_listing(BDbTxn &txn, String fname,
+BerkeleyDbFilesystem::get_directory_listing(StateTxn &state_txn, String fname,
                                             std::vector<DirEntry> &listing) {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   Dbt key;
   Dbc *cursorp = 0;
@@ -1222,10 +1242,11 @@ namespace {
 }
 
 void
-BerkeleyDbFilesystem::get_directory_attr_listing(BDbTxn &txn, String fname,
+BerkeleyDbFilesystem::get_directory_attr_listing(StateTxn &state_txn, String fname,
                                                  const String &aname,
                                                  bool include_sub_entries,
                                                  std::vector<DirEntryAttr> &listing) {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   get_directory_attr_listing(txn, fname, aname, listing);
   if (include_sub_entries) {
     if (!ends_with(fname, "/"))
@@ -1237,9 +1258,10 @@ BerkeleyDbFilesystem::get_directory_attr_listing(BDbTxn &txn, String fname,
 }
 
 void
-BerkeleyDbFilesystem::get_directory_attr_listing(BDbTxn &txn, String fname,
+BerkeleyDbFilesystem::get_directory_attr_listing(StateTxn &state_txn, String fname,
                                                  const String &aname,
                                                  std::vector<DirEntryAttr> &listing) {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   Dbt key;
   Dbc *cursorp = 0;
@@ -1325,8 +1347,9 @@ BerkeleyDbFilesystem::get_directory_attr_listing(BDbTxn &txn, String fname,
 }
 
 void
-BerkeleyDbFilesystem::get_all_names(BDbTxn &txn,
+BerkeleyDbFilesystem::get_all_names(StateTxn &state_txn,
                                     std::vector<String> &names) {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   Dbc *cursorp = 0;
   HT_ON_SCOPE_EXIT(&close_db_cursor, &cursorp);
@@ -1372,9 +1395,10 @@ BerkeleyDbFilesystem::build_attr_key(BDbTxn &txn, String &keystr,
 }
 
 bool
-BerkeleyDbFilesystem::list_xattr(BDbTxn &txn, const String& fname,
+BerkeleyDbFilesystem::list_xattr(StateTxn &state_txn, const String& fname,
                                  std::vector<String> &anames)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   Dbc *cursorp = 0;
   HT_ON_SCOPE_EXIT(&close_db_cursor, &cursorp);
@@ -1420,9 +1444,10 @@ BerkeleyDbFilesystem::list_xattr(BDbTxn &txn, const String& fname,
  *
  */
 void
-BerkeleyDbFilesystem::create_event(BDbTxn &txn, uint32_t type, uint64_t id,
+BerkeleyDbFilesystem::create_event(StateTxn &state_txn, uint32_t type, uint64_t id,
     uint32_t mask)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -1477,9 +1502,10 @@ BerkeleyDbFilesystem::create_event(BDbTxn &txn, uint32_t type, uint64_t id,
  *
  */
 void
-BerkeleyDbFilesystem::create_event(BDbTxn &txn, uint32_t type, uint64_t id,
+BerkeleyDbFilesystem::create_event(StateTxn &state_txn, uint32_t type, uint64_t id,
     uint32_t mask, const String &name)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   String key_str;
   DbtManaged keym, datam;
@@ -1508,9 +1534,10 @@ BerkeleyDbFilesystem::create_event(BDbTxn &txn, uint32_t type, uint64_t id,
  *
  */
 void
-BerkeleyDbFilesystem::create_event(BDbTxn &txn, uint32_t type, uint64_t id,
+BerkeleyDbFilesystem::create_event(StateTxn &state_txn, uint32_t type, uint64_t id,
     uint32_t mask, uint32_t mode)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged  keym, datam;
   String key_str;
@@ -1540,10 +1567,11 @@ BerkeleyDbFilesystem::create_event(BDbTxn &txn, uint32_t type, uint64_t id,
  *
  */
 void
-BerkeleyDbFilesystem::create_event(BDbTxn &txn, uint32_t type, uint64_t id,
+BerkeleyDbFilesystem::create_event(StateTxn &state_txn, uint32_t type, uint64_t id,
     uint32_t mask, uint32_t mode,
     uint64_t generation)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -1574,9 +1602,10 @@ BerkeleyDbFilesystem::create_event(BDbTxn &txn, uint32_t type, uint64_t id,
  *
  */
 void
-BerkeleyDbFilesystem::set_event_notification_handles(BDbTxn &txn, uint64_t id,
+BerkeleyDbFilesystem::set_event_notification_handles(StateTxn &state_txn, uint64_t id,
     const std::vector<uint64_t> &handles)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged  keym;
   String key_str;
@@ -1619,8 +1648,9 @@ BerkeleyDbFilesystem::set_event_notification_handles(BDbTxn &txn, uint64_t id,
  *
  */
 void
-BerkeleyDbFilesystem::delete_event(BDbTxn &txn, uint64_t id)
+BerkeleyDbFilesystem::delete_event(StateTxn &state_txn, uint64_t id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -1703,8 +1733,9 @@ BerkeleyDbFilesystem::delete_event(BDbTxn &txn, uint64_t id)
  *
  */
 bool
-BerkeleyDbFilesystem::event_exists(BDbTxn &txn, uint64_t id)
+BerkeleyDbFilesystem::event_exists(StateTxn &state_txn, uint64_t id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   Dbc *cursorp = 0;
   HT_ON_SCOPE_EXIT(&close_db_cursor, &cursorp);
@@ -1745,9 +1776,10 @@ BerkeleyDbFilesystem::event_exists(BDbTxn &txn, uint64_t id)
  *
  */
 void
-BerkeleyDbFilesystem::create_session(BDbTxn &txn, uint64_t id, const String& addr)
+BerkeleyDbFilesystem::create_session(StateTxn &state_txn, uint64_t id, const String& addr)
 
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -1805,8 +1837,9 @@ BerkeleyDbFilesystem::create_session(BDbTxn &txn, uint64_t id, const String& add
  *
  */
 void
-BerkeleyDbFilesystem::delete_session(BDbTxn &txn, uint64_t id)
+BerkeleyDbFilesystem::delete_session(StateTxn &state_txn, uint64_t id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -1877,8 +1910,9 @@ BerkeleyDbFilesystem::delete_session(BDbTxn &txn, uint64_t id)
  *
  */
 void
-BerkeleyDbFilesystem::expire_session(BDbTxn &txn, uint64_t id)
+BerkeleyDbFilesystem::expire_session(StateTxn &state_txn, uint64_t id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -1917,8 +1951,9 @@ BerkeleyDbFilesystem::expire_session(BDbTxn &txn, uint64_t id)
  *
  */
 void
-BerkeleyDbFilesystem::add_session_handle(BDbTxn &txn, uint64_t id, uint64_t handle_id)
+BerkeleyDbFilesystem::add_session_handle(StateTxn &state_txn, uint64_t id, uint64_t handle_id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged  keym, datam;
   String key_str;
@@ -1956,8 +1991,9 @@ BerkeleyDbFilesystem::add_session_handle(BDbTxn &txn, uint64_t id, uint64_t hand
  *
  */
 void
-BerkeleyDbFilesystem::get_session_handles(BDbTxn &txn, uint64_t id, std::vector<uint64_t> &handles)
+BerkeleyDbFilesystem::get_session_handles(StateTxn &state_txn, uint64_t id, std::vector<uint64_t> &handles)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged  keym, datam;
   String key_str;
@@ -1995,8 +2031,9 @@ BerkeleyDbFilesystem::get_session_handles(BDbTxn &txn, uint64_t id, std::vector<
  *
  */
 bool
-BerkeleyDbFilesystem::delete_session_handle(BDbTxn &txn, uint64_t id, uint64_t handle_id)
+BerkeleyDbFilesystem::delete_session_handle(StateTxn &state_txn, uint64_t id, uint64_t handle_id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -2044,8 +2081,9 @@ BerkeleyDbFilesystem::delete_session_handle(BDbTxn &txn, uint64_t id, uint64_t h
  *
  */
 bool
-BerkeleyDbFilesystem::session_exists(BDbTxn &txn, uint64_t id)
+BerkeleyDbFilesystem::session_exists(StateTxn &state_txn, uint64_t id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   Dbc *cursorp = 0;
   HT_ON_SCOPE_EXIT(&close_db_cursor, &cursorp);
@@ -2087,8 +2125,9 @@ BerkeleyDbFilesystem::session_exists(BDbTxn &txn, uint64_t id)
  *
  */
 void
-BerkeleyDbFilesystem::set_session_name(BDbTxn &txn, uint64_t id, const String &name)
+BerkeleyDbFilesystem::set_session_name(StateTxn &state_txn, uint64_t id, const String &name)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -2127,8 +2166,9 @@ BerkeleyDbFilesystem::set_session_name(BDbTxn &txn, uint64_t id, const String &n
  *
  */
 String
-BerkeleyDbFilesystem::get_session_name(BDbTxn &txn, uint64_t id)
+BerkeleyDbFilesystem::get_session_name(StateTxn &state_txn, uint64_t id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged  keym, datam;
   String key_str, name;
@@ -2171,10 +2211,11 @@ BerkeleyDbFilesystem::get_session_name(BDbTxn &txn, uint64_t id)
  *
  */
 void
-BerkeleyDbFilesystem::create_handle(BDbTxn &txn, uint64_t id, String node_name,
+BerkeleyDbFilesystem::create_handle(StateTxn &state_txn, uint64_t id, String node_name,
     uint32_t open_flags, uint32_t event_mask, uint64_t session_id,
     bool locked, uint32_t del_state)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -2275,8 +2316,9 @@ BerkeleyDbFilesystem::create_handle(BDbTxn &txn, uint64_t id, String node_name,
  *
  */
 void
-BerkeleyDbFilesystem::delete_handle(BDbTxn &txn, uint64_t id)
+BerkeleyDbFilesystem::delete_handle(StateTxn &state_txn, uint64_t id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -2360,8 +2402,9 @@ BerkeleyDbFilesystem::delete_handle(BDbTxn &txn, uint64_t id)
  *
  */
 void
-BerkeleyDbFilesystem::set_handle_del_state(BDbTxn &txn, uint64_t id, uint32_t del_state)
+BerkeleyDbFilesystem::set_handle_del_state(StateTxn &state_txn, uint64_t id, uint32_t del_state)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   char numbuf[17];
   int ret;
@@ -2405,8 +2448,9 @@ BerkeleyDbFilesystem::set_handle_del_state(BDbTxn &txn, uint64_t id, uint32_t de
  *
  */
 void
-BerkeleyDbFilesystem::set_handle_open_flags(BDbTxn &txn, uint64_t id, uint32_t open_flags)
+BerkeleyDbFilesystem::set_handle_open_flags(StateTxn &state_txn, uint64_t id, uint32_t open_flags)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   char numbuf[17];
   int ret;
@@ -2451,8 +2495,9 @@ BerkeleyDbFilesystem::set_handle_open_flags(BDbTxn &txn, uint64_t id, uint32_t o
  *
  */
 void
-BerkeleyDbFilesystem::set_handle_event_mask(BDbTxn &txn, uint64_t id, uint32_t event_mask)
+BerkeleyDbFilesystem::set_handle_event_mask(StateTxn &state_txn, uint64_t id, uint32_t event_mask)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   char numbuf[17];
   int ret;
@@ -2497,8 +2542,9 @@ BerkeleyDbFilesystem::set_handle_event_mask(BDbTxn &txn, uint64_t id, uint32_t e
  *
  */
 uint32_t
-BerkeleyDbFilesystem::get_handle_event_mask(BDbTxn &txn, uint64_t id)
+BerkeleyDbFilesystem::get_handle_event_mask(StateTxn &state_txn, uint64_t id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   int ret;
   Dbc *cursorp = 0;
@@ -2538,8 +2584,9 @@ BerkeleyDbFilesystem::get_handle_event_mask(BDbTxn &txn, uint64_t id)
  *
  */
 void
-BerkeleyDbFilesystem::set_handle_locked(BDbTxn &txn, uint64_t id, bool locked)
+BerkeleyDbFilesystem::set_handle_locked(StateTxn &state_txn, uint64_t id, bool locked)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   int ret;
   String buf;
@@ -2583,8 +2630,9 @@ BerkeleyDbFilesystem::set_handle_locked(BDbTxn &txn, uint64_t id, bool locked)
  *
  */
 bool
-BerkeleyDbFilesystem::handle_exists(BDbTxn &txn, uint64_t id)
+BerkeleyDbFilesystem::handle_exists(StateTxn &state_txn, uint64_t id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   Dbc *cursorp = 0;
   HT_ON_SCOPE_EXIT(&close_db_cursor, &cursorp);
@@ -2625,8 +2673,9 @@ BerkeleyDbFilesystem::handle_exists(BDbTxn &txn, uint64_t id)
  */
 
 bool
-BerkeleyDbFilesystem::handle_is_locked(BDbTxn &txn, uint64_t id)
+BerkeleyDbFilesystem::handle_is_locked(StateTxn &state_txn, uint64_t id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   int ret;
   String buf;
@@ -2673,8 +2722,9 @@ BerkeleyDbFilesystem::handle_is_locked(BDbTxn &txn, uint64_t id)
  *
  */
 void
-BerkeleyDbFilesystem::get_handle_node(BDbTxn &txn, uint64_t id, String &node_name)
+BerkeleyDbFilesystem::get_handle_node(StateTxn &state_txn, uint64_t id, String &node_name)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   int ret;
   String key_str;
@@ -2710,8 +2760,9 @@ BerkeleyDbFilesystem::get_handle_node(BDbTxn &txn, uint64_t id, String &node_nam
  *
  */
 uint32_t
-BerkeleyDbFilesystem::get_handle_del_state(BDbTxn &txn, uint64_t id)
+BerkeleyDbFilesystem::get_handle_del_state(StateTxn &state_txn, uint64_t id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   int ret;
   String key_str;
@@ -2748,8 +2799,9 @@ BerkeleyDbFilesystem::get_handle_del_state(BDbTxn &txn, uint64_t id)
  *
  */
 uint32_t
-BerkeleyDbFilesystem::get_handle_open_flags(BDbTxn &txn, uint64_t id)
+BerkeleyDbFilesystem::get_handle_open_flags(StateTxn &state_txn, uint64_t id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   int ret;
   String key_str;
@@ -2788,8 +2840,9 @@ BerkeleyDbFilesystem::get_handle_open_flags(BDbTxn &txn, uint64_t id)
  *
  */
 uint64_t
-BerkeleyDbFilesystem::get_handle_session(BDbTxn &txn, uint64_t id)
+BerkeleyDbFilesystem::get_handle_session(StateTxn &state_txn, uint64_t id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -2830,10 +2883,11 @@ BerkeleyDbFilesystem::get_handle_session(BDbTxn &txn, uint64_t id)
  *
  */
 void
-BerkeleyDbFilesystem::create_node(BDbTxn &txn, const String &name,
+BerkeleyDbFilesystem::create_node(StateTxn &state_txn, const String &name,
     bool ephemeral, uint64_t lock_generation,  uint32_t cur_lock_mode,
     uint64_t exclusive_handle)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -2918,9 +2972,10 @@ BerkeleyDbFilesystem::create_node(BDbTxn &txn, const String &name,
  *
  */
 void
-BerkeleyDbFilesystem::set_node_lock_generation(BDbTxn &txn, const String &name,
+BerkeleyDbFilesystem::set_node_lock_generation(StateTxn &state_txn, const String &name,
                                                uint64_t lock_generation)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   char numbuf[17];
   int ret;
@@ -2965,8 +3020,9 @@ BerkeleyDbFilesystem::set_node_lock_generation(BDbTxn &txn, const String &name,
  *
  */
 uint64_t
-BerkeleyDbFilesystem::incr_node_lock_generation(BDbTxn &txn, const String &name)
+BerkeleyDbFilesystem::incr_node_lock_generation(StateTxn &state_txn, const String &name)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   char numbuf[17];
   int ret;
@@ -3016,9 +3072,10 @@ BerkeleyDbFilesystem::incr_node_lock_generation(BDbTxn &txn, const String &name)
  *
  */
 void
-BerkeleyDbFilesystem::set_node_ephemeral(BDbTxn &txn, const String &name,
+BerkeleyDbFilesystem::set_node_ephemeral(StateTxn &state_txn, const String &name,
                                          bool ephemeral)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   int ret;
   String buf;
@@ -3063,8 +3120,9 @@ BerkeleyDbFilesystem::set_node_ephemeral(BDbTxn &txn, const String &name,
  *
  */
 bool
-BerkeleyDbFilesystem::node_is_ephemeral(BDbTxn &txn, const String &name)
+BerkeleyDbFilesystem::node_is_ephemeral(StateTxn &state_txn, const String &name)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   int ret;
   String buf;
@@ -3108,9 +3166,10 @@ BerkeleyDbFilesystem::node_is_ephemeral(BDbTxn &txn, const String &name)
  *
  */
 void
-BerkeleyDbFilesystem::set_node_cur_lock_mode(BDbTxn &txn, const String &name,
+BerkeleyDbFilesystem::set_node_cur_lock_mode(StateTxn &state_txn, const String &name,
     uint32_t lock_mode)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   char numbuf[16];
   int ret;
@@ -3154,8 +3213,9 @@ BerkeleyDbFilesystem::set_node_cur_lock_mode(BDbTxn &txn, const String &name,
  *
  */
 uint32_t
-BerkeleyDbFilesystem::get_node_cur_lock_mode(BDbTxn &txn, const String &name)
+BerkeleyDbFilesystem::get_node_cur_lock_mode(StateTxn &state_txn, const String &name)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   int ret;
   Dbc *cursorp = 0;
@@ -3195,9 +3255,10 @@ BerkeleyDbFilesystem::get_node_cur_lock_mode(BDbTxn &txn, const String &name)
  *
  */
 void
-BerkeleyDbFilesystem::set_node_exclusive_lock_handle(BDbTxn &txn,
+BerkeleyDbFilesystem::set_node_exclusive_lock_handle(StateTxn &state_txn,
     const String &name, uint64_t exclusive_lock_handle)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   char numbuf[17];
   int ret;
@@ -3240,8 +3301,9 @@ BerkeleyDbFilesystem::set_node_exclusive_lock_handle(BDbTxn &txn,
  *
  */
 uint64_t
-BerkeleyDbFilesystem::get_node_exclusive_lock_handle(BDbTxn &txn, const String &name)
+BerkeleyDbFilesystem::get_node_exclusive_lock_handle(StateTxn &state_txn, const String &name)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   int ret;
   Dbc *cursorp = 0;
@@ -3282,9 +3344,10 @@ BerkeleyDbFilesystem::get_node_exclusive_lock_handle(BDbTxn &txn, const String &
  *
  */
 void
-BerkeleyDbFilesystem::add_node_handle(BDbTxn &txn, const String &name,
+BerkeleyDbFilesystem::add_node_handle(StateTxn &state_txn, const String &name,
     uint64_t handle_id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged  keym, datam;
   String key_str;
@@ -3323,9 +3386,10 @@ BerkeleyDbFilesystem::add_node_handle(BDbTxn &txn, const String &name,
  *
  */
 bool
-BerkeleyDbFilesystem::get_node_event_notification_map(BDbTxn &txn, const String &name,
+BerkeleyDbFilesystem::get_node_event_notification_map(StateTxn &state_txn, const String &name,
     uint32_t event_mask, NotificationMap &handles_to_sessions)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged  keym, datam;
   String key_str;
@@ -3377,9 +3441,10 @@ BerkeleyDbFilesystem::get_node_event_notification_map(BDbTxn &txn, const String
  *
  */
 void
-BerkeleyDbFilesystem::delete_node_handle(BDbTxn &txn, const String &name,
+BerkeleyDbFilesystem::delete_node_handle(StateTxn &state_txn, const String &name,
     uint64_t handle_id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -3422,9 +3487,10 @@ BerkeleyDbFilesystem::delete_node_handle(BDbTxn &txn, const String &name,
  *
  */
 void
-BerkeleyDbFilesystem::add_node_pending_lock_request(BDbTxn &txn,
+BerkeleyDbFilesystem::add_node_pending_lock_request(StateTxn &state_txn,
                                                     const String &name,
                                                     LockRequest &request) {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -3471,8 +3537,9 @@ BerkeleyDbFilesystem::add_node_pending_lock_request(BDbTxn &txn,
  */
 
 bool
-BerkeleyDbFilesystem::node_has_pending_lock_request(BDbTxn &txn, const String &name)
+BerkeleyDbFilesystem::node_has_pending_lock_request(StateTxn &state_txn, const String &name)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -3524,9 +3591,10 @@ BerkeleyDbFilesystem::node_has_pending_lock_request(BDbTxn &txn, const String &n
  */
 
 bool
-BerkeleyDbFilesystem::get_node_pending_lock_request(BDbTxn &txn, const String &name,
+BerkeleyDbFilesystem::get_node_pending_lock_request(StateTxn &state_txn, const String &name,
     LockRequest &front_req)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -3578,9 +3646,10 @@ BerkeleyDbFilesystem::get_node_pending_lock_request(BDbTxn &txn, const String &n
  *
  */
 void
-BerkeleyDbFilesystem::delete_node_pending_lock_request(BDbTxn &txn,
+BerkeleyDbFilesystem::delete_node_pending_lock_request(StateTxn &state_txn,
     const String &name, uint64_t handle_id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -3628,9 +3697,10 @@ BerkeleyDbFilesystem::delete_node_pending_lock_request(BDbTxn &txn,
  *
  */
 void
-BerkeleyDbFilesystem::add_node_shared_lock_handle(BDbTxn &txn, const String &name,
+BerkeleyDbFilesystem::add_node_shared_lock_handle(StateTxn &state_txn, const String &name,
                                                   uint64_t handle_id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged  keym, datam;
   String key_str;
@@ -3669,8 +3739,9 @@ BerkeleyDbFilesystem::add_node_shared_lock_handle(BDbTxn &txn, const String &nam
  *
  */
 bool
-BerkeleyDbFilesystem::node_has_shared_lock_handles(BDbTxn &txn, const String &name)
+BerkeleyDbFilesystem::node_has_shared_lock_handles(StateTxn &state_txn, const String &name)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged  keym, datam;
   String key_str;
@@ -3710,9 +3781,10 @@ BerkeleyDbFilesystem::node_has_shared_lock_handles(BDbTxn &txn, const String &na
  *
  */
 void
-BerkeleyDbFilesystem::delete_node_shared_lock_handle(BDbTxn &txn, const String &name,
+BerkeleyDbFilesystem::delete_node_shared_lock_handle(StateTxn &state_txn, const String &name,
                                                      uint64_t handle_id)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -3753,8 +3825,9 @@ BerkeleyDbFilesystem::delete_node_shared_lock_handle(BDbTxn &txn, const String &
  *
  */
 bool
-BerkeleyDbFilesystem::delete_node(BDbTxn &txn, const String &name)
+BerkeleyDbFilesystem::delete_node(StateTxn &state_txn, const String &name)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -3822,8 +3895,9 @@ BerkeleyDbFilesystem::delete_node(BDbTxn &txn, const String &name)
  *
  */
 bool
-BerkeleyDbFilesystem::node_exists(BDbTxn &txn, const String &name)
+BerkeleyDbFilesystem::node_exists(StateTxn &state_txn, const String &name)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   Dbc *cursorp = 0;
   HT_ON_SCOPE_EXIT(&close_db_cursor, &cursorp);
@@ -3862,9 +3936,10 @@ BerkeleyDbFilesystem::node_exists(BDbTxn &txn, const String &name)
  *
  */
 void
-BerkeleyDbFilesystem::get_node_handles(BDbTxn &txn, const String &name,
+BerkeleyDbFilesystem::get_node_handles(StateTxn &state_txn, const String &name,
                                        std::vector<uint64_t> &handles)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -3904,8 +3979,9 @@ BerkeleyDbFilesystem::get_node_handles(BDbTxn &txn, const String &name,
  *
  */
 bool
-BerkeleyDbFilesystem::node_has_open_handles(BDbTxn &txn, const String &name)
+BerkeleyDbFilesystem::node_has_open_handles(StateTxn &state_txn, const String &name)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   int ret;
   DbtManaged keym, datam;
   String key_str;
@@ -3951,8 +4027,9 @@ BerkeleyDbFilesystem::node_has_open_handles(BDbTxn &txn, const String &name)
  *
  */
 uint64_t
-BerkeleyDbFilesystem::get_next_id_i64(BDbTxn &txn, IdentifierType id_type, bool increment)
+BerkeleyDbFilesystem::get_next_id_i64(StateTxn &state_txn, IdentifierType id_type, bool increment)
 {
+  BDbTxn &txn = static_cast<BDbTxn &>(state_txn);
   DbtManaged keym, datam;
   int ret;
   uint64_t retval=0;
@@ -4006,6 +4083,10 @@ BerkeleyDbFilesystem::get_next_id_i64(BDbTxn &txn, IdentifierType id_type, bool
   return retval;
 }
 
+void BDbTxn::display(std::ostream &out) const {
+  out << *this;
+}
+
 std::ostream& Hyperspace::operator<<(std::ostream &out, const BDbTxn &txn) {
   out << "{BDbTxn m_handle_namespace_db=" << txn.handle_namespace_db
       << ", m_handle_state_db=" << txn.handle_state_db
@@ -33,6 +33,7 @@
 #include <Hyperspace/DirEntry.h>
 #include <Hyperspace/DirEntryAttr.h>
 #include <Hyperspace/StateDbKeys.h>
+#include <Hyperspace/StateStore.h>
 
 #include <Common/DynamicBuffer.h>
 #include <Common/FileUtils.h>
@@ -60,30 +61,6 @@ namespace Hyperspace {
    * @{
    */
 
-  /// Hash map from Node handle ID to Session ID
-  typedef std::unordered_map<uint64_t, uint64_t> NotificationMap;
-
-  /** Encapsulates a lock request for a file node. */
-  class LockRequest {
-  public:
-    /** Constructor.
-     * @param h Node handle ID
-     * @param m Lock mode
-     */
-    LockRequest(uint64_t h=0, int m=0) : handle(h), mode(m) { return; }
-    /// Node handle ID
-    uint64_t handle;
-    /// Lock mode
-    uint32_t mode;
-  };
-
-  /** Enumeration for object identifier types */
-  enum IdentifierType {
-    SESSION = 0, /**< Session identifier */
-    HANDLE,      /**< Handle identifier */
-    EVENT        /**< Event identifier */
-  };
-
   /** Encapsulates replication state. */
   class ReplicationInfo {
   public:
@@ -179,7 +156,7 @@ namespace Hyperspace {
   typedef std::shared_ptr<BDbHandles> BDbHandlesPtr;
 
   /** Manages transaction state */
-  class BDbTxn {
+  class BDbTxn : public StateTxn {
   public:
     /** Constructor. */
     BDbTxn(): handle_namespace_db(0), handle_state_db(0), db_txn(0) {}
@@ -187,17 +164,19 @@ namespace Hyperspace {
     /** Commit transaction.
      * @param flag BerkeleyDB commit flags
      */
-    void commit(int flag=0) {
+    void commit(int flag=0) override {
       db_txn->commit(flag);
       db_txn = 0;
     }
 
     /** Abort transaction. */
-    void abort() {
+    void abort() override {
       db_txn->abort();
       db_txn = 0;
     }
 
+    void display(std::ostream &out) const override;
+
     /// Filesystem namespace database handle
     Db *handle_namespace_db;
 
@@ -217,7 +196,7 @@ namespace Hyperspace {
 
   /** Hyperspace filesystem implementation on top of BerkeleyDB.
    */
-  class BerkeleyDbFilesystem {
+  class BerkeleyDbFilesystem : public StateStore {
   public:
 
     /** Constructor.
@@ -243,14 +222,14 @@ namespace Hyperspace {
      * <code>m_env.log_archive</code> to obtain a list of unused log files and
      * it will remove them.
      */
-    void do_checkpoint();
+    void do_checkpoint() override;
 
     /** Check if we're the current master.
      * This method returns <i>true</i> if replication is disabled or if
      * we're the current elected master.
      * @return <i>true</i> if we're the master, <i>false</i> otherwise.
      */
-    bool is_master() {
+    bool is_master() override {
       // its the master if we're not doing replication or this is the replication master
       return (!m_replication_info.do_replication || m_replication_info.is_master);
     }
@@ -258,7 +237,7 @@ namespace Hyperspace {
     /** Returns hostname of currently elected master.
      * @return Hostname of the currently elected master.
      */
-    String get_current_master() {
+    String get_current_master() override {
       if (m_replication_info.is_master)
         return m_replication_info.localhost;
       else {
@@ -275,36 +254,38 @@ namespace Hyperspace {
      */
     void start_transaction(BDbTxn &txn);
 
-    bool get_xattr_i32(BDbTxn &txn, const String &fname,
-                       const String &aname, uint32_t *valuep);
-    void set_xattr_i32(BDbTxn &txn, const String &fname,
-                       const String &aname, uint32_t value);
-    bool get_xattr_i64(BDbTxn &txn, const String &fname,
-                       const String &aname, uint64_t *valuep);
-    void set_xattr_i64(BDbTxn &txn, const String &fname,
-                       const String &aname, uint64_t value);
-    void set_xattr(BDbTxn &txn, const String &fname,
-                   const String &aname, const void *value, size_t value_len);
-    bool get_xattr(BDbTxn &txn, const String &fname, const String &aname,
-                   Hypertable::DynamicBuffer &vbuf);
-    bool incr_attr(BDbTxn &txn, const String &fname, const String &aname,
-                       uint64_t *valuep);
-
-    bool exists_xattr(BDbTxn &txn, const String &fname, const String &aname);
-    void del_xattr(BDbTxn &txn, const String &fname, const String &aname);
-    void mkdir(BDbTxn &txn, const String &name);
-    void unlink(BDbTxn &txn, const String &name);
-    bool exists(BDbTxn &txn, String fname, bool *is_dir_p=0);
-    void create(BDbTxn &txn, const String &fname, bool temp);
-    void get_directory_listing(BDbTxn &txn, String fname,
-                               std::vector<DirEntry> &listing);
-    void get_directory_attr_listing(BDbTxn &txn, String fname, const String &aname,
+    StateTxnPtr start_transaction() override;
+
+    bool get_xattr_i32(StateTxn &txn, const String &fname,
+                       const String &aname, uint32_t *valuep) override;
+    void set_xattr_i32(StateTxn &txn, const String &fname,
+                       const String &aname, uint32_t value) override;
+    bool get_xattr_i64(StateTxn &txn, const String &fname,
+                       const String &aname, uint64_t *valuep) override;
+    void set_xattr_i64(StateTxn &txn, const String &fname,
+                       const String &aname, uint64_t value) override;
+    void set_xattr(StateTxn &txn, const String &fname,
+                   const String &aname, const void *value, size_t value_len) override;
+    bool get_xattr(StateTxn &txn, const String &fname, const String &aname,
+                   Hypertable::DynamicBuffer &vbuf) override;
+    bool incr_attr(StateTxn &txn, const String &fname, const String &aname,
+                       uint64_t *valuep) override;
+
+    bool exists_xattr(StateTxn &txn, const String &fname, const String &aname) override;
+    void del_xattr(StateTxn &txn, const String &fname, const String &aname) override;
+    void mkdir(StateTxn &txn, const String &name) override;
+    void unlink(StateTxn &txn, const String &name) override;
+    bool exists(StateTxn &txn, String fname, bool *is_dir_p=0) override;
+    void create(StateTxn &txn, const String &fname, bool temp) override;
+    void get_directory_listing(StateTxn &txn, String fname,
+                               std::vector<DirEntry> &listing) override;
+    void get_directory_attr_listing(StateTxn &txn, String fname, const String &aname,
                                     bool include_sub_entries,
-                                    std::vector<DirEntryAttr> &listing);
-    void get_directory_attr_listing(BDbTxn &txn, String fname, const String &aname,
-                                    std::vector<DirEntryAttr> &listing);
-    void get_all_names(BDbTxn &txn, std::vector<String> &names);
-    bool list_xattr(BDbTxn &txn, const String& fname, std::vector<String> &anames);
+                                    std::vector<DirEntryAttr> &listing) override;
+    void get_directory_attr_listing(StateTxn &txn, String fname, const String &aname,
+                                    std::vector<DirEntryAttr> &listing) override;
+    void get_all_names(StateTxn &txn, std::vector<String> &names) override;
+    bool list_xattr(StateTxn &txn, const String& fname, std::vector<String> &anames) override;
     /*
      * Persists a new event in the StateDB
      *
@@ -313,13 +294,13 @@ namespace Hyperspace {
      * @param id Event id
      * @param mask Event mask
      */
-    void create_event(BDbTxn &txn, uint32_t type, uint64_t id, uint32_t mask);
+    void create_event(StateTxn &txn, uint32_t type, uint64_t id, uint32_t mask) override;
     // for named event
-    void create_event(BDbTxn &txn, uint32_t type, uint64_t id, uint32_t mask,
-                      const String &name);
-    void create_event(BDbTxn &txn, uint32_t type, uint64_t id, uint32_t mask, uint32_t mode);
-    void create_event(BDbTxn &txn, uint32_t type, uint64_t id, uint32_t mask,
-                      uint32_t mode, uint64_t generation);
+    void create_event(StateTxn &txn, uint32_t type, uint64_t id, uint32_t mask,
+                      const String &name) override;
+    void create_event(StateTxn &txn, uint32_t type, uint64_t id, uint32_t mask, uint32_t mode) override;
+    void create_event(StateTxn &txn, uint32_t type, uint64_t id, uint32_t mask,
+                      uint32_t mode, uint64_t generation) override;
 
     /*
      * Remove specified event from the StateDB
@@ -327,7 +308,7 @@ namespace Hyperspace {
      * @param txn BerkeleyDB txn for this DB update
      * @param id Event id
      */
-    void delete_event(BDbTxn &txn, uint64_t id);
+    void delete_event(StateTxn &txn, uint64_t id) override;
 
     /*
      * Set the handles that are affected by this event
@@ -336,8 +317,8 @@ namespace Hyperspace {
      * @param id Event id
      * @param handles array of handles that are affected by this event
      */
-    void set_event_notification_handles(BDbTxn &txn, uint64_t id,
-                                        const std::vector<uint64_t> &handles);
+    void set_event_notification_handles(StateTxn &txn, uint64_t id,
+                                        const std::vector<uint64_t> &handles) override;
 
     /*
      * Check if the specified event is in the StateDB
@@ -346,7 +327,7 @@ namespace Hyperspace {
      * @param id Event id
      * @return true if found false ow
      */
-    bool event_exists(BDbTxn &txn, uint64_t id);
+    bool event_exists(StateTxn &txn, uint64_t id) override;
 
     /*
      * Persist a new SessionData object in the StateDB
@@ -355,7 +336,7 @@ namespace Hyperspace {
      * @param id Session id
      * @param addr Stringified remote host address
      */
-    void create_session(BDbTxn &txn, uint64_t id, const String &addr);
+    void create_session(StateTxn &txn, uint64_t id, const String &addr) override;
 
     /*
      * Delete info for specified session from StateDB
@@ -363,7 +344,7 @@ namespace Hyperspace {
      * @param txn BerkeleyDB txn for this DB update
      * @param id Session id
      */
-    void delete_session(BDbTxn &txn, uint64_t id);
+    void delete_session(StateTxn &txn, uint64_t id) override;
 
     /*
      * Delete info for specified session from StateDB
@@ -371,7 +352,7 @@ namespace Hyperspace {
      * @param txn BerkeleyDB txn for this DB update
      * @param id Session id
      */
-    void expire_session(BDbTxn &txn, uint64_t id);
+    void expire_session(StateTxn &txn, uint64_t id) override;
 
 
     /*
@@ -381,7 +362,7 @@ namespace Hyperspace {
      * @param id Session id
      * @param handle_id Handle id
      */
-    void add_session_handle(BDbTxn &txn, uint64_t id, uint64_t handle_id);
+    void add_session_handle(StateTxn &txn, uint64_t id, uint64_t handle_id) override;
 
     /*
      * return all the handles a session has open
@@ -390,7 +371,7 @@ namespace Hyperspace {
      * @param id Session id
      * @param handles vector into which open handle ids will be inserted
      */
-    void get_session_handles(BDbTxn &txn, uint64_t id, std::vector<uint64_t> &handles);
+    void get_session_handles(StateTxn &txn, uint64_t id, std::vector<uint64_t> &handles) override;
 
 
     /*
@@ -401,7 +382,7 @@ namespace Hyperspace {
      * @param handle_id Handle id
      * @return true if handle was open and has been deleted
      */
-    bool delete_session_handle(BDbTxn &txn, uint64_t id, uint64_t handle_id);
+    bool delete_session_handle(StateTxn &txn, uint64_t id, uint64_t handle_id) override;
 
 
     /*
@@ -411,7 +392,7 @@ namespace Hyperspace {
      * @param id Session id
      * @return true if session existsn StateDB, false ow
      */
-    bool session_exists(BDbTxn &txn, uint64_t id);
+    bool session_exists(StateTxn &txn, uint64_t id) override;
 
     /*
      * Get name of session executable
@@ -420,7 +401,7 @@ namespace Hyperspace {
      * @param id Session id
      * @return remote session executable
      */
-    String get_session_name(BDbTxn &txn, uint64_t id);
+    String get_session_name(StateTxn &txn, uint64_t id) override;
 
     /*
      * Set name of session executable
@@ -429,7 +410,7 @@ namespace Hyperspace {
      * @param id Session id
      * @param name of the session executable
      */
-    void set_session_name(BDbTxn &txn, uint64_t id, const String &name);
+    void set_session_name(StateTxn &txn, uint64_t id, const String &name) override;
 
 
     /*
@@ -444,9 +425,9 @@ namespace Hyperspace {
      * @param locked true if node is locked
      * @param del_state state of handle deletion operation
      */
-    void create_handle(BDbTxn &txn, uint64_t id, String node_name,
+    void create_handle(StateTxn &txn, uint64_t id, String node_name,
         uint32_t open_flags, uint32_t event_mask, uint64_t session_id,
-        bool locked, uint32_t del_state);
+        bool locked, uint32_t del_state) override;
 
     /*
      * Delete all info for this handle from StateDB
@@ -454,7 +435,7 @@ namespace Hyperspace {
      * @param txn BerkeleyDB txn for this DB update
      * @param id Handle id
      */
-    void delete_handle(BDbTxn &txn, uint64_t id);
+    void delete_handle(StateTxn &txn, uint64_t id) override;
 
     /*
      * Get open flags for handle
@@ -463,7 +444,7 @@ namespace Hyperspace {
      * @param id Handle id
      * @return open_flags for handle
      */
-    uint32_t get_handle_open_flags(BDbTxn &txn, uint64_t id);
+    uint32_t get_handle_open_flags(StateTxn &txn, uint64_t id) override;
 
     /*
      * Set deletion state for handle
@@ -472,7 +453,7 @@ namespace Hyperspace {
      * @param id Handle id
      * @param del_state new deletion state
      */
-    void set_handle_del_state(BDbTxn &txn, uint64_t id, uint32_t del_state);
+    void set_handle_del_state(StateTxn &txn, uint64_t id, uint32_t del_state) override;
 
     /*
      * Get handle deletion state for handle
@@ -481,7 +462,7 @@ namespace Hyperspace {
      * @param id Handle id
      * @return deletion state for handle
      */
-    uint32_t get_handle_del_state(BDbTxn &txn, uint64_t id);
+    uint32_t get_handle_del_state(StateTxn &txn, uint64_t id) override;
 
     /*
      * Set open flags for handle
@@ -490,7 +471,7 @@ namespace Hyperspace {
      * @param id Handle id
      * @param open_flags new flags
      */
-    void set_handle_open_flags(BDbTxn &txn, uint64_t id, uint32_t open_flags);
+    void set_handle_open_flags(StateTxn &txn, uint64_t id, uint32_t open_flags) override;
 
     /*
      * Set event mask for handle
@@ -499,7 +480,7 @@ namespace Hyperspace {
      * @param id Handle id
      * @param event_mask new event mask
      */
-    void set_handle_event_mask(BDbTxn &txn, uint64_t id, uint32_t event_mask);
+    void set_handle_event_mask(StateTxn &txn, uint64_t id, uint32_t event_mask) override;
 
     /*
      * Get event mask for handle
@@ -508,7 +489,7 @@ namespace Hyperspace {
      * @param id Handle id
      * @return event mask
      */
-    uint32_t get_handle_event_mask(BDbTxn &txn, uint64_t id);
+    uint32_t get_handle_event_mask(StateTxn &txn, uint64_t id) override;
 
     /*
      * Set the node associated with this handle
@@ -526,7 +507,7 @@ namespace Hyperspace {
      * @param id Handle id
      * @param node_name name of node assoc with this handle, if not found node_name = ""
      */
-    void get_handle_node(BDbTxn &txn, uint64_t id, String &node_name);
+    void get_handle_node(StateTxn &txn, uint64_t id, String &node_name) override;
 
     /*
      * Get the session associated with this handle
@@ -535,7 +516,7 @@ namespace Hyperspace {
      * @param id Handle id
      * @return session id for this handle
      */
-    uint64_t get_handle_session(BDbTxn &txn, uint64_t id);
+    uint64_t get_handle_session(StateTxn &txn, uint64_t id) override;
 
 
     /*
@@ -545,7 +526,7 @@ namespace Hyperspace {
      * @param id Handle id
      * @param locked
      */
-    void set_handle_locked(BDbTxn &txn, uint64_t id, bool locked);
+    void set_handle_locked(StateTxn &txn, uint64_t id, bool locked) override;
 
     /*
      * Get the locked-ness this handle
@@ -554,7 +535,7 @@ namespace Hyperspace {
      * @param id Handle id
      * @return true if handle is locked
      */
-    bool handle_is_locked(BDbTxn &txn, uint64_t id);
+    bool handle_is_locked(StateTxn &txn, uint64_t id) override;
 
     /*
      * Check if info for this handle is in the StateDb
@@ -563,7 +544,7 @@ namespace Hyperspace {
      * @param id Handle id
      * @return true if handle exists in StateDb
      */
-    bool handle_exists(BDbTxn &txn, uint64_t id);
+    bool handle_exists(StateTxn &txn, uint64_t id) override;
 
     /*
      * Persist a new node in StateDB
@@ -575,8 +556,8 @@ namespace Hyperspace {
      * @param cur_lock_mode node lock mode
      * @param exclusive_handle handle id of exclusive lock handle
      */
-    void create_node(BDbTxn &txn, const String &name, bool ephemeral=false,
-        uint64_t lock_generation=0, uint32_t cur_lock_mode=0, uint64_t exclusive_handle=0);
+    void create_node(StateTxn &txn, const String &name, bool ephemeral=false,
+        uint64_t lock_generation=0, uint32_t cur_lock_mode=0, uint64_t exclusive_handle=0) override;
 
     /*
      * Set the lock generation this node
@@ -585,7 +566,7 @@ namespace Hyperspace {
      * @param name Node name
      * @param lock_generation
      */
-    void set_node_lock_generation(BDbTxn &txn, const String &name, uint64_t lock_generation);
+    void set_node_lock_generation(StateTxn &txn, const String &name, uint64_t lock_generation) override;
 
     /*
      * Increment the lock generation this node
@@ -594,7 +575,7 @@ namespace Hyperspace {
      * @param name Node name
      * @return current lock generation (after increment)
      */
-    uint64_t incr_node_lock_generation(BDbTxn &txn, const String &name);
+    uint64_t incr_node_lock_generation(StateTxn &txn, const String &name) override;
 
 
     /*
@@ -604,7 +585,7 @@ namespace Hyperspace {
      * @param name Node name
      * @param ephemeral
      */
-    void set_node_ephemeral(BDbTxn &txn, const String &name, bool ephemeral);
+    void set_node_ephemeral(StateTxn &txn, const String &name, bool ephemeral) override;
 
     /*
      * Set the node ephemeral-ness
@@ -613,7 +594,7 @@ namespace Hyperspace {
      * @param name Node name
      * @return true if node is ephemeral
      */
-    bool node_is_ephemeral(BDbTxn &txn, const String &name);
+    bool node_is_ephemeral(StateTxn &txn, const String &name) override;
 
     /*
      * Set the node current lock mode
@@ -622,7 +603,7 @@ namespace Hyperspace {
      * @param name Node name
      * @param lock_mode
      */
-    void set_node_cur_lock_mode(BDbTxn &txn, const String &name, uint32_t lock_mode);
+    void set_node_cur_lock_mode(StateTxn &txn, const String &name, uint32_t lock_mode) override;
 
     /*
      * Get the node current lock mode
@@ -631,7 +612,7 @@ namespace Hyperspace {
      * @param name Node name
      * @return lock_mode
      */
-    uint32_t get_node_cur_lock_mode(BDbTxn &txn, const String &name);
+    uint32_t get_node_cur_lock_mode(StateTxn &txn, const String &name) override;
 
     /*
      * Set the node exclusive_lock_handle
@@ -640,8 +621,8 @@ namespace Hyperspace {
      * @param name Node name
      * @param exclusive_lock_handle
      */
-    void set_node_exclusive_lock_handle(BDbTxn &txn, const String &name,
-                                        uint64_t exclusive_lock_handle);
+    void set_node_exclusive_lock_handle(StateTxn &txn, const String &name,
+                                        uint64_t exclusive_lock_handle) override;
 
     /*
      * Get the node exclusive_lock_handle
@@ -650,7 +631,7 @@ namespace Hyperspace {
      * @param name Node name
      * @return exclusive lock handle
      */
-    uint64_t get_node_exclusive_lock_handle(BDbTxn &txn, const String &name);
+    uint64_t get_node_exclusive_lock_handle(StateTxn &txn, const String &name) override;
 
 
     /*
@@ -660,7 +641,7 @@ namespace Hyperspace {
      * @param name Node name
      * @param handle
      */
-    void add_node_handle(BDbTxn &txn, const String &name, uint64_t handle);
+    void add_node_handle(StateTxn &txn, const String &name, uint64_t handle) override;
 
     /*
      * Remove a handle from the node
@@ -669,7 +650,7 @@ namespace Hyperspace {
      * @param name Node name
      * @param handle
      */
-    void delete_node_handle(BDbTxn &txn, const String &name, uint64_t handle);
+    void delete_node_handle(StateTxn &txn, const String &name, uint64_t handle) override;
 
     /*
      * Returns whether any handles have this node open
@@ -678,7 +659,7 @@ namespace Hyperspace {
      * @param name Node name
      * @return true if at least one handle has this node open
      */
-    bool node_has_open_handles(BDbTxn &txn, const String &name);
+    bool node_has_open_handles(StateTxn &txn, const String &name) override;
 
     /*
      * Check if a node has any pending lock requests from non-expired handles
@@ -687,7 +668,7 @@ namespace Hyperspace {
      * @param name Node name
      * @return true if node has at least one pending lock request
      */
-    bool node_has_pending_lock_request(BDbTxn &txn, const String &name);
+    bool node_has_pending_lock_request(StateTxn &txn, const String &name) override;
 
     /** Check if a node has any pending lock requests from non-expired handles.
      * @param txn BerkeleyDB txn for this DB update
@@ -695,8 +676,8 @@ namespace Hyperspace {
      * @param front_req will contain the first pending request if this method returns true
      * @return true if node has at least one pending lock request
      */
-    bool get_node_pending_lock_request(BDbTxn &txn, const String &name,
-                                       LockRequest &front_req);
+    bool get_node_pending_lock_request(StateTxn &txn, const String &name,
+                                       LockRequest &front_req) override;
 
 
     /** Adds a lock request.
@@ -704,8 +685,8 @@ namespace Hyperspace {
      * @param name Node name
      * @param request Lock request
      */
-    void add_node_pending_lock_request(BDbTxn &txn, const String &name,
-                                       LockRequest &request);
+    void add_node_pending_lock_request(StateTxn &txn, const String &name,
+                                       LockRequest &request) override;
     /*
      * Remove a lock request to the node
      *
@@ -713,7 +694,7 @@ namespace Hyperspace {
      * @param name Node name
      * @param handle handle requesting lock
      */
-    void delete_node_pending_lock_request(BDbTxn &txn, const String &name, uint64_t handle);
+    void delete_node_pending_lock_request(StateTxn &txn, const String &name, uint64_t handle) override;
 
     /*
      * Add a shared lock handle
@@ -722,7 +703,7 @@ namespace Hyperspace {
      * @param name Node name
      * @param handle handle requesting lock
      */
-    void add_node_shared_lock_handle(BDbTxn &txn, const String &name, uint64_t handle);
+    void add_node_shared_lock_handle(StateTxn &txn, const String &name, uint64_t handle) override;
 
     /*
      * Get a map of(handle id,  session id) for notifications registered for a certain
@@ -734,8 +715,8 @@ namespace Hyperspace {
      * @param handles_to_sessions map specifying notifications to be sent
      * @return true if there are some notifications that need to be sent out
      */
-    bool get_node_event_notification_map(BDbTxn &txn, const String &name, uint32_t event_mask,
-        NotificationMap &handles_to_sessions);
+    bool get_node_event_notification_map(StateTxn &txn, const String &name, uint32_t event_mask,
+        NotificationMap &handles_to_sessions) override;
 
     /*
      * Get all open handles for a node
@@ -744,7 +725,7 @@ namespace Hyperspace {
      * @param name Node name
      * @param handles vector of node handles
      */
-    void get_node_handles(BDbTxn &txn, const String &name, std::vector<uint64_t> &handles);
+    void get_node_handles(StateTxn &txn, const String &name, std::vector<uint64_t> &handles) override;
 
     /*
      * Remove node shared lock handle
@@ -753,7 +734,7 @@ namespace Hyperspace {
      * @param name Node name
      * @param handle_id to be deleted
      */
-    void delete_node_shared_lock_handle(BDbTxn &txn, const String &name, uint64_t handle_id);
+    void delete_node_shared_lock_handle(StateTxn &txn, const String &name, uint64_t handle_id) override;
 
     /*
      * Delete all info for this node from StateDB
@@ -762,7 +743,7 @@ namespace Hyperspace {
      * @param name Node name
      * @return false if node doesn't exist true if node was deleted
      */
-    bool delete_node(BDbTxn &txn, const String &name);
+    bool delete_node(StateTxn &txn, const String &name) override;
 
     /*
      * Check if info for this node is in the StateDb
@@ -771,7 +752,7 @@ namespace Hyperspace {
      * @param name Node name
      * @return true if node exists in StateDb
      */
-    bool node_exists(BDbTxn &txn, const String &name);
+    bool node_exists(StateTxn &txn, const String &name) override;
 
     /*
      * Check if node has any shared lock handles
@@ -780,11 +761,9 @@ namespace Hyperspace {
      * @param name Node name
      * @return true if node has shared lock handles
      */
-    bool node_has_shared_lock_handles(BDbTxn &txn, const String &name);
-
-    uint64_t get_next_id_i64(BDbTxn &txn, IdentifierType id_type, bool increment = false);
+    bool node_has_shared_lock_handles(StateTxn &txn, const String &name) override;
 
-    static const char NODE_ATTR_DELIM = 0x01;
+    uint64_t get_next_id_i64(StateTxn &txn, IdentifierType id_type, bool increment = false) override;
 
 
   private:
@@ -0,0 +1,355 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for ClientCache.
+/// This file contains definitions for ClientCache, a client-side cache of
+/// %Hyperspace file existence, attribute values, and directory listings that
+/// is kept coherent with event notifications delivered to watch handles.
+
+#include <Common/Compat.h>
+
+#include "ClientCache.h"
+
+#include <cstring>
+
+using namespace Hyperspace;
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  /// Callback for watch handles.  Forwards events to the cache.
+  class WatchCallback : public HandleCallback {
+  public:
+    WatchCallback(ClientCache *cache, const String &name)
+      : HandleCallback(EVENT_MASK_ATTR_SET|EVENT_MASK_ATTR_DEL|
+                       EVENT_MASK_CHILD_NODE_ADDED|
+                       EVENT_MASK_CHILD_NODE_REMOVED),
+        m_cache(cache), m_name(name) { }
+
+    void attr_set(const std::string &name) override {
+      m_cache->attr_changed(m_name, this, name);
+    }
+
+    void attr_del(const std::string &name) override {
+      m_cache->attr_changed(m_name, this, name);
+    }
+
+    void child_node_added(const std::string &name) override {
+      m_cache->child_added(m_name, this, name);
+    }
+
+    void child_node_removed(const std::string &name) override {
+      m_cache->child_removed(m_name, this, name);
+    }
+
+  private:
+    ClientCache *m_cache;
+    String m_name;
+  };
+
+}
+
+
+bool ClientCache::get_exists(const String &name, bool *existsp) {
+  lock_guard<mutex> lock(m_mutex);
+  String parent, child;
+  if (!split(name, parent, child)) {
+    *existsp = true;
+    m_stats.hits++;
+    return true;
+  }
+  Node *node = find(parent);
+  if (node) {
+    auto iter = node->children.find(child);
+    if (iter != node->children.end()) {
+      *existsp = iter->second;
+      m_stats.hits++;
+      return true;
+    }
+  }
+  m_stats.misses++;
+  return false;
+}
+
+
+bool ClientCache::get_attr(const String &name, const String &attr,
+                           bool *existsp, DynamicBuffer *value) {
+  lock_guard<mutex> lock(m_mutex);
+  Node *node = find(name);
+  if (node) {
+    auto iter = node->attrs.find(attr);
+    if (iter != node->attrs.end()) {
+      *existsp = iter->second.exists;
+      if (value && iter->second.exists) {
+        const String &cached = iter->second.value;
+        value->clear();
+        value->ensure(cached.length()+1);
+        value->add_unchecked(cached.data(), cached.length());
+        // nul-terminate to make caller's lives easier
+        *value->ptr = 0;
+      }
+      m_stats.hits++;
+      return true;
+    }
+  }
+  m_stats.misses++;
+  return false;
+}
+
+
+bool ClientCache::get_listing(const String &name, const String &attr,
+                              std::vector<DirEntryAttr> &listing) {
+  lock_guard<mutex> lock(m_mutex);
+  Node *node = find(name);
+  if (node) {
+    auto iter = node->listings.find(attr);
+    if (iter != node->listings.end()) {
+      DirEntryAttr dentry;
+      listing.clear();
+      listing.reserve(iter->second.size());
+      for (const auto &entry : iter->second) {
+        dentry.name = entry.name;
+        dentry.is_dir = entry.is_dir;
+        dentry.has_attr = entry.has_attr;
+        DynamicBuffer buffer(entry.value.length()+1);
+        buffer.add_unchecked(entry.value.data(), entry.value.length());
+        // nul-terminate to match Session::decode_listing()
+        *buffer.ptr = 0;
+        buffer.size = entry.value.length()+1;
+        dentry.attr = buffer;
+        listing.push_back(dentry);
+      }
+      m_stats.hits++;
+      return true;
+    }
+  }
+  m_stats.misses++;
+  return false;
+}
+
+
+bool ClientCache::get_generation(const String &name, uint64_t *generationp) {
+  lock_guard<mutex> lock(m_mutex);
+  Node *node = find(name);
+  if (node == 0)
+    return false;
+  *generationp = node->generation;
+  return true;
+}
+
+
+bool ClientCache::full() {
+  lock_guard<mutex> lock(m_mutex);
+  return m_nodes.size() >= m_max_nodes;
+}
+
+
+HandleCallbackPtr ClientCache::create_watch_callback(const String &name) {
+  return make_shared<WatchCallback>(this, name);
+}
+
+
+bool ClientCache::add_watch(const String &name, uint64_t handle,
+                            HandleCallbackPtr &callback,
+                            uint64_t parent_generation) {
+  lock_guard<mutex> lock(m_mutex);
+  String parent, child;
+
+  if (m_nodes.count(name))
+    return false;
+
+  if (split(name, parent, child)) {
+    Node *parent_node = find(parent);
+    if (parent_node == 0 || parent_node->generation != parent_generation)
+      return false;
+  }
+
+  Node &node = m_nodes[name];
+  node.handle = handle;
+  node.watch = callback.get();
+  node.generation = m_next_generation++;
+  m_stats.watches++;
+  return true;
+}
+
+
+void ClientCache::put_exists(const String &name, uint64_t parent_generation,
+                             bool exists) {
+  lock_guard<mutex> lock(m_mutex);
+  String parent, child;
+  if (!split(name, parent, child))
+    return;
+  Node *node = find(parent);
+  if (node && node->generation == parent_generation)
+    node->children[child] = exists;
+}
+
+
+void ClientCache::put_attr(const String &name, uint64_t generation,
+                           const String &attr, bool exists, const void *value,
+                           size_t value_len) {
+  lock_guard<mutex> lock(m_mutex);
+  Node *node = find(name);
+  if (node && node->generation == generation) {
+    AttrEntry &entry = node->attrs[attr];
+    entry.exists = exists;
+    if (exists)
+      entry.value.assign((const char *)value, value_len);
+    else
+      entry.value.clear();
+  }
+}
+
+
+void ClientCache::put_listing(const String &name, uint64_t generation,
+                              const String &attr,
+                              const std::vector<DirEntryAttr> &listing) {
+  lock_guard<mutex> lock(m_mutex);
+  Node *node = find(name);
+  if (node == 0 || node->generation != generation)
+    return;
+  std::vector<ListingEntry> entries;
+  entries.reserve(listing.size());
+  for (const auto &dentry : listing) {
+    ListingEntry entry;
+    entry.name = dentry.name;
+    entry.is_dir = dentry.is_dir;
+    entry.has_attr = dentry.has_attr;
+    if (dentry.attr.size)
+      entry.value.assign((const char *)dentry.attr.base, dentry.attr.size);
+    entries.push_back(entry);
+  }
+  node->listings[attr].swap(entries);
+}
+
+
+void ClientCache::add_orphan(uint64_t handle) {
+  lock_guard<mutex> lock(m_mutex);
+  m_orphans.push_back(handle);
+}
+
+
+void ClientCache::take_orphans(std::vector<uint64_t> &handles) {
+  lock_guard<mutex> lock(m_mutex);
+  handles.clear();
+  handles.swap(m_orphans);
+}
+
+
+void ClientCache::purge() {
+  lock_guard<mutex> lock(m_mutex);
+  m_nodes.clear();
+  m_orphans.clear();
+}
+
+
+void ClientCache::get_stats(Stats &stats) {
+  lock_guard<mutex> lock(m_mutex);
+  stats = m_stats;
+  stats.nodes = m_nodes.size();
+}
+
+
+void ClientCache::attr_changed(const String &name, const void *watch,
+                               const String &attr) {
+  lock_guard<mutex> lock(m_mutex);
+  String parent, child;
+  Node *node = find(name, watch);
+  if (node == 0)
+    return;
+  m_stats.invalidations++;
+  node->attrs.erase(attr);
+  touch(node);
+  // listings of the parent directory carry this attribute
+  if (split(name, parent, child) && (node = find(parent))) {
+    node->listings.erase(attr);
+    touch(node);
+  }
+}
+
+
+void ClientCache::child_added(const String &name, const void *watch,
+                              const String &child) {
+  lock_guard<mutex> lock(m_mutex);
+  Node *node = find(name, watch);
+  if (node == 0)
+    return;
+  m_stats.invalidations++;
+  node->children.erase(child);
+  node->listings.clear();
+  touch(node);
+}
+
+
+void ClientCache::child_removed(const String &name, const void *watch,
+                                const String &child) {
+  lock_guard<mutex> lock(m_mutex);
+  Node *node = find(name, watch);
+  if (node == 0)
+    return;
+  m_stats.invalidations++;
+  node->children.erase(child);
+  node->listings.clear();
+  touch(node);
+
+  // Drop the removed node and everything beneath it.  The watch handles
+  // now refer to nodes that no longer exist and are closed by Session.
+  String path = (name == "/") ? name + child : name + "/" + child;
+  auto iter = m_nodes.find(path);
+  if (iter != m_nodes.end()) {
+    m_orphans.push_back(iter->second.handle);
+    m_nodes.erase(iter);
+  }
+  String prefix = path + "/";
+  iter = m_nodes.lower_bound(prefix);
+  while (iter != m_nodes.end() &&
+         iter->first.compare(0, prefix.length(), prefix) == 0) {
+    m_orphans.push_back(iter->second.handle);
+    iter = m_nodes.erase(iter);
+  }
+}
+
+
+ClientCache::Node *ClientCache::find(const String &name, const void *watch) {
+  auto iter = m_nodes.find(name);
+  if (iter == m_nodes.end())
+    return 0;
+  if (watch && iter->second.watch != watch)
+    return 0;
+  return &iter->second;
+}
+
+
+void ClientCache::touch(Node *node) {
+  node->generation = m_next_generation++;
+}
+
+
+bool ClientCache::split(const String &name, String &parent, String &child) {
+  if (name == "/")
+    return false;
+  size_t last_slash = name.rfind('/');
+  parent = (last_slash == 0) ? String("/") : name.substr(0, last_slash);
+  child = name.substr(last_slash+1);
+  return true;
+}
@@ -0,0 +1,261 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for ClientCache.
+/// This file contains declarations for ClientCache, a client-side cache of
+/// %Hyperspace file existence, attribute values, and directory listings that
+/// is kept coherent with event notifications delivered to watch handles.
+
+#ifndef Hyperspace_ClientCache_h
+#define Hyperspace_ClientCache_h
+
+#include <Hyperspace/DirEntryAttr.h>
+#include <Hyperspace/HandleCallback.h>
+
+#include <Common/DynamicBuffer.h>
+#include <Common/String.h>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace Hyperspace {
+
+  /// @addtogroup Hyperspace
+  /// @{
+
+  /// Client-side cache of %Hyperspace metadata.
+  /// Each cached node is covered by a <i>watch handle</i>, a handle opened
+  /// with OPEN_FLAG_WATCH whose callback receives ATTR_SET, ATTR_DEL,
+  /// CHILD_NODE_ADDED and CHILD_NODE_REMOVED events.  Watches are held on
+  /// every ancestor of a cached node so that removal of any node is observed
+  /// through the CHILD_NODE_REMOVED event on its parent.  Because the master
+  /// does not complete a modification until every notification has been
+  /// acknowledged, a cached value is invalidated before the modification
+  /// returns to the writer.
+  /// <p>
+  /// This class only holds state; Session performs the RPCs.  To avoid
+  /// caching a value that was invalidated while it was being fetched, every
+  /// node carries a generation number that is bumped on each invalidation.
+  /// A caller reads the generation before issuing the RPC and the value is
+  /// only inserted if the generation is unchanged.  Callbacks run in the
+  /// keepalive handler thread and never call back into Session; handles of
+  /// removed nodes are queued and closed later by Session (see
+  /// take_orphans()).
+  class ClientCache {
+  public:
+
+    /// Cache statistics.
+    struct Stats {
+      /// Number of lookups served from the cache
+      uint64_t hits {};
+      /// Number of lookups not found in the cache
+      uint64_t misses {};
+      /// Number of invalidation events received
+      uint64_t invalidations {};
+      /// Number of watch handles opened
+      uint64_t watches {};
+      /// Number of nodes currently cached
+      uint64_t nodes {};
+    };
+
+    /// Constructor.
+    /// @param max_nodes Maximum number of nodes to watch
+    ClientCache(size_t max_nodes) : m_max_nodes(max_nodes) { }
+
+    /// Looks up whether or not a file exists.
+    /// @param name Normalized file name
+    /// @param existsp Address of variable to hold result
+    /// @return <i>true</i> on cache hit, <i>false</i> otherwise
+    bool get_exists(const String &name, bool *existsp);
+
+    /// Looks up an attribute value.
+    /// @param name Normalized file name
+    /// @param attr Attribute name
+    /// @param existsp Address of variable set to <i>true</i> if the attribute
+    /// exists
+    /// @param value Buffer to hold (nul-terminated) value, or 0
+    /// @return <i>true</i> on cache hit, <i>false</i> otherwise
+    bool get_attr(const String &name, const String &attr, bool *existsp,
+                  DynamicBuffer *value);
+
+    /// Looks up a (non-recursive) readdir_attr listing.
+    /// @param name Normalized directory name
+    /// @param attr Attribute name
+    /// @param listing Vector to hold listing
+    /// @return <i>true</i> on cache hit, <i>false</i> otherwise
+    bool get_listing(const String &name, const String &attr,
+                     std::vector<DirEntryAttr> &listing);
+
+    /// Gets generation of watched node.
+    /// @param name Normalized node name
+    /// @param generationp Address of variable to hold generation
+    /// @return <i>true</i> if <code>name</code> is watched, <i>false</i>
+    /// otherwise
+    bool get_generation(const String &name, uint64_t *generationp);
+
+    /// Checks if cache has room for another watch.
+    /// @return <i>true</i> if number of watched nodes reached maximum
+    bool full();
+
+    /// Creates callback object for a new watch handle.
+    /// @param name Normalized node name
+    /// @return Callback to pass to Session::open()
+    HandleCallbackPtr create_watch_callback(const String &name);
+
+    /// Records a newly opened watch handle.  The watch is only recorded if
+    /// the generation of the parent node is still
+    /// <code>parent_generation</code> and <code>name</code> is not already
+    /// watched.
+    /// @param name Normalized node name
+    /// @param handle Watch handle
+    /// @param callback Callback returned by create_watch_callback()
+    /// @param parent_generation Generation of parent read before opening
+    /// the watch (ignored for "/")
+    /// @return <i>true</i> if watch was recorded, <i>false</i> if the caller
+    /// must close <code>handle</code>
+    bool add_watch(const String &name, uint64_t handle,
+                   HandleCallbackPtr &callback, uint64_t parent_generation);
+
+    /// Inserts file existence.
+    /// @param name Normalized file name
+    /// @param parent_generation Generation of parent node before fetch
+    /// @param exists <i>true</i> if file exists
+    void put_exists(const String &name, uint64_t parent_generation,
+                    bool exists);
+
+    /// Inserts attribute value.
+    /// @param name Normalized file name
+    /// @param generation Generation of node before fetch
+    /// @param attr Attribute name
+    /// @param exists <i>true</i> if attribute exists
+    /// @param value Attribute value
+    /// @param value_len Length of attribute value
+    void put_attr(const String &name, uint64_t generation, const String &attr,
+                  bool exists, const void *value, size_t value_len);
+
+    /// Inserts readdir_attr listing.
+    /// @param name Normalized directory name
+    /// @param generation Generation of directory before fetch
+    /// @param attr Attribute name
+    /// @param listing Directory listing
+    void put_listing(const String &name, uint64_t generation,
+                     const String &attr,
+                     const std::vector<DirEntryAttr> &listing);
+
+    /// Queues a handle to be closed by Session.
+    /// @param handle Handle to close
+    void add_orphan(uint64_t handle);
+
+    /// Takes handles queued for closing.
+    /// @param handles Vector to hold handles
+    void take_orphans(std::vector<uint64_t> &handles);
+
+    /// Drops all cached state.  Called when the session expires or
+    /// disconnects, at which point all watch handles are gone.
+    void purge();
+
+    /// Gets cache statistics.
+    /// @param stats Reference to statistics structure to fill in
+    void get_stats(Stats &stats);
+
+    /// @name Event handlers
+    /// Invoked by the watch callbacks.  <code>watch</code> identifies the
+    /// callback so that events for a watch that has since been replaced are
+    /// ignored.
+    /// @{
+    void attr_changed(const String &name, const void *watch,
+                      const String &attr);
+    void child_added(const String &name, const void *watch,
+                     const String &child);
+    void child_removed(const String &name, const void *watch,
+                       const String &child);
+    /// @}
+
+  private:
+
+    /// Cached attribute value.
+    struct AttrEntry {
+      bool exists {};
+      String value;
+    };
+
+    /// Cached readdir_attr entry.
+    struct ListingEntry {
+      String name;
+      bool is_dir {};
+      bool has_attr {};
+      String value;
+    };
+
+    /// Watched node.
+    struct Node {
+      uint64_t handle {};
+      const void *watch {};
+      uint64_t generation {};
+      /// Existence of children, by child name
+      std::map<String, bool> children;
+      /// Attribute values, by attribute name
+      std::map<String, AttrEntry> attrs;
+      /// readdir_attr listings, by attribute name
+      std::map<String, std::vector<ListingEntry>> listings;
+    };
+
+    typedef std::map<String, Node> NodeMap;
+
+    /// Finds watched node.
+    /// @param name Normalized node name
+    /// @param watch Callback identity, or 0 to match any watch
+    /// @return Pointer to node or 0 if not found
+    Node *find(const String &name, const void *watch=0);
+
+    /// Bumps generation of node, failing fills that are in progress.
+    void touch(Node *node);
+
+    /// Splits normalized name into parent and child.
+    static bool split(const String &name, String &parent, String &child);
+
+    /// %Mutex serializing access to members
+    std::mutex m_mutex;
+
+    /// Maximum number of watched nodes
+    size_t m_max_nodes;
+
+    /// Watched nodes, ordered by name so that subtrees are contiguous
+    NodeMap m_nodes;
+
+    /// Handles waiting to be closed
+    std::vector<uint64_t> m_orphans;
+
+    /// Statistics
+    Stats m_stats;
+
+    /// Generation source; nodes never reuse a generation
+    uint64_t m_next_generation {1};
+  };
+
+  /// @}
+
+} // namespace Hyperspace
+
+#endif // Hyperspace_ClientCache_h
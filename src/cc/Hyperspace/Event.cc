@@ -25,6 +25,6 @@
 
 namespace Hyperspace {
 
-BerkeleyDbFilesystem *Event::ms_bdb_fs=0;
+StateStore *Event::ms_fs=0;
 
 }
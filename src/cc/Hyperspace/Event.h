@@ -25,7 +25,7 @@
 #include <Common/Compat.h>
 
 #include "HandleCallback.h"
-#include "BerkeleyDbFilesystem.h"
+#include "StateStore.h"
 
 #include <AsyncComm/CommBuf.h>
 
@@ -33,6 +33,8 @@
 #include <Common/Serialization.h>
 #include <Common/System.h>
 
+#include <boost/preprocessor/facilities/empty.hpp>
+
 #include <condition_variable>
 #include <chrono>
 #include <iostream>
@@ -43,13 +45,14 @@
 
 #define HT_BDBTXN_EVT_BEGIN(parent_txn) \
   do { \
-    BDbTxn txn; \
-    ms_bdb_fs->start_transaction(txn); \
+    StateTxnPtr txn_ptr = ms_fs->start_transaction(); \
+    StateTxn &txn = *txn_ptr; \
     try
 
 #define HT_BDBTXN_EVT_END_CB(_cb_) \
     catch (Exception &e) { \
-      if (e.code() != Error::HYPERSPACE_BERKELEYDB_DEADLOCK) { \
+      if (e.code() != Error::HYPERSPACE_BERKELEYDB_DEADLOCK && \
+          e.code() != Error::HYPERSPACE_STATEDB_DEADLOCK) { \
         if (e.code() == Error::HYPERSPACE_BERKELEYDB_ERROR) \
           HT_ERROR_OUT << e << HT_END; \
         else \
@@ -58,7 +61,7 @@
         _cb_->error(e.code(), e.what()); \
         return; \
       } \
-      HT_WARN_OUT << "Berkeley DB deadlock encountered in txn "<< txn << HT_END; \
+      HT_WARN_OUT << "Deadlock encountered in txn "<< txn << HT_END; \
       txn.abort(); \
       std::this_thread::sleep_for(Random::duration_millis(3000)); \
       continue; \
@@ -68,7 +71,8 @@
 
 #define HT_BDBTXN_EVT_END(...) \
     catch (Exception &e) { \
-      if (e.code() != Error::HYPERSPACE_BERKELEYDB_DEADLOCK) { \
+      if (e.code() != Error::HYPERSPACE_BERKELEYDB_DEADLOCK && \
+          e.code() != Error::HYPERSPACE_STATEDB_DEADLOCK) { \
         if (e.code() == Error::HYPERSPACE_BERKELEYDB_ERROR) \
           HT_ERROR_OUT << e << HT_END; \
         else \
@@ -76,7 +80,7 @@
         txn.abort(); \
         return __VA_ARGS__; \
       } \
-      HT_WARN_OUT << "Berkeley DB deadlock encountered in txn "<< txn << HT_END; \
+      HT_WARN_OUT << "Deadlock encountered in txn "<< txn << HT_END; \
       txn.abort(); \
       std::this_thread::sleep_for(Random::duration_millis(3000)); \
       continue; \
@@ -111,9 +115,9 @@ namespace Hyperspace {
       std::lock_guard<std::mutex> lock(m_mutex);
       m_notification_count--;
       if (m_notification_count == 0) {
-        // all notifications received, so delete event from BDB
+        // all notifications received, so delete event from state store
         HT_BDBTXN_EVT_BEGIN() {
-          ms_bdb_fs->delete_event(txn, m_id);
+          ms_fs->delete_event(txn, m_id);
           txn.commit();
         }
         HT_BDBTXN_EVT_END(BOOST_PP_EMPTY());
@@ -129,12 +133,12 @@ namespace Hyperspace {
     virtual uint32_t encoded_length() = 0;
     virtual void encode(Hypertable::CommBuf *cbuf) = 0;
 
-    static void set_bdb_fs(BerkeleyDbFilesystem *bdb_fs) {
-      ms_bdb_fs = bdb_fs;
+    static void set_fs(StateStore *fs) {
+      ms_fs = fs;
     }
 
   protected:
-    static BerkeleyDbFilesystem *ms_bdb_fs;
+    static StateStore *ms_fs;
     std::mutex m_mutex;
     std::condition_variable m_cond;
     uint64_t m_id {};
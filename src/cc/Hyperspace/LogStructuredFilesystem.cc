@@ -0,0 +1,1605 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Definitions for LogStructuredFilesystem.
+ * This file contains the method definitions for LogStructuredFilesystem, a
+ * class that implements the Hyperspace filesystem as an in-memory tree backed
+ * by an append-only write-ahead log with group commit and periodic snapshots.
+ */
+
+#include <Common/Compat.h>
+
+#include "LogStructuredFilesystem.h"
+
+#include <Common/Checksum.h>
+#include <Common/Error.h>
+#include <Common/FileUtils.h>
+#include <Common/Logger.h>
+#include <Common/Serialization.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+extern "C" {
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+}
+
+using namespace Hyperspace;
+using namespace Hypertable;
+using namespace Error;
+using namespace std;
+
+namespace {
+
+  /// Size of frame header (payload length and checksum)
+  const size_t FRAME_HEADER_SIZE = 8;
+
+  /// Namespace record flag indicating entry was removed
+  const uint8_t RECORD_DELETED = 0;
+
+  /// Namespace record flag indicating entry was set
+  const uint8_t RECORD_SET = 1;
+
+  const char stop_chars[3] = { (char)StateStore::NODE_ATTR_DELIM, '/', 0 };
+
+  template <typename MapT, typename UndoT>
+  typename MapT::mapped_type &save(MapT &map, UndoT &undo,
+                                   const typename MapT::key_type &key) {
+    auto iter = map.find(key);
+    if (undo.find(key) == undo.end()) {
+      if (iter == map.end())
+        undo.emplace(key, make_pair(false, typename MapT::mapped_type()));
+      else
+        undo.emplace(key, make_pair(true, iter->second));
+    }
+    if (iter == map.end())
+      iter = map.emplace(key, typename MapT::mapped_type()).first;
+    return iter->second;
+  }
+
+  template <typename MapT, typename UndoT>
+  void restore(MapT &map, UndoT &undo) {
+    for (auto &entry : undo) {
+      if (entry.second.first)
+        map[entry.first] = std::move(entry.second.second);
+      else
+        map.erase(entry.first);
+    }
+    undo.clear();
+  }
+
+  bool erase_value(vector<uint64_t> &vec, uint64_t value) {
+    auto iter = find(vec.begin(), vec.end(), value);
+    if (iter == vec.end())
+      return false;
+    vec.erase(iter);
+    return true;
+  }
+
+  bool list_numbered_files(const String &dir, const char *prefix,
+                           vector<uint32_t> &numbers) {
+    DIR *dirp = opendir(dir.c_str());
+    if (dirp == 0)
+      return false;
+    size_t prefix_len = strlen(prefix);
+    struct dirent *dp;
+    while ((dp = readdir(dirp)) != 0) {
+      if (strncmp(dp->d_name, prefix, prefix_len))
+        continue;
+      const char *ptr = dp->d_name + prefix_len;
+      char *end;
+      unsigned long number = strtoul(ptr, &end, 10);
+      if (end != ptr && *end == 0)
+        numbers.push_back((uint32_t)number);
+    }
+    closedir(dirp);
+    sort(numbers.begin(), numbers.end());
+    return true;
+  }
+
+  void write_fully(int fd, const uint8_t *buf, size_t len,
+                   const String &path) {
+    if (FileUtils::write(fd, buf, len) != (ssize_t)len)
+      HT_FATALF("Problem writing %llu bytes to %s - %s", (Llu)len,
+                path.c_str(), strerror(errno));
+  }
+
+}
+
+
+LogStructuredFilesystem::Txn::~Txn() {
+  if (!m_finished)
+    m_fs->abort(*this);
+}
+
+void LogStructuredFilesystem::Txn::commit(int flag) {
+  m_fs->commit(*this);
+}
+
+void LogStructuredFilesystem::Txn::abort() {
+  m_fs->abort(*this);
+}
+
+void LogStructuredFilesystem::Txn::display(std::ostream &out) const {
+  out << "{LogStructuredFilesystem::Txn id=" << m_id << " locks="
+      << m_locks.size() << " namespace_changes=" << m_namespace_undo.size()
+      << "}";
+}
+
+
+LogStructuredFilesystem::LogStructuredFilesystem(PropertiesPtr &props,
+                                                 const String &basedir)
+  : m_log_dir(basedir + "/logstore") {
+
+  m_checkpoint_size = props->get_i32("Hyperspace.Checkpoint.Size");
+  m_max_unused_logs = props->get_i32("Hyperspace.LogGc.MaxUnusedLogs");
+  m_log_gc_interval =
+    std::chrono::milliseconds(props->get_i32("Hyperspace.LogGc.Interval"));
+  m_last_log_gc_time = std::chrono::steady_clock::now();
+
+  for (size_t i=0; i<3; i++)
+    m_next_id[i] = 1;
+
+  if (!FileUtils::mkdirs(m_log_dir))
+    HT_FATALF("Unable to create directory %s", m_log_dir.c_str());
+
+  recover();
+
+  // initialize namespace if required
+  Txn txn(this, m_next_txn_id++);
+  if (m_namespace.find("/") == m_namespace.end()) {
+    put_namespace(txn, "/", "");
+    put_namespace(txn, "/hyperspace/", "");
+    put_namespace(txn, "/hyperspace/metadata", "");
+  }
+  txn.commit();
+}
+
+LogStructuredFilesystem::~LogStructuredFilesystem() {
+  sync(m_appended_seq);
+  if (m_fd != -1)
+    ::close(m_fd);
+}
+
+void LogStructuredFilesystem::do_checkpoint() {
+  uint32_t segment;
+  DynamicBuffer state;
+
+  {
+    lock_guard<mutex> lock(m_log_mutex);
+    if (m_segment_size + m_log_buffer.fill() <= m_checkpoint_size)
+      return;
+  }
+
+  {
+    // Hold the namespace lock shared so that the snapshot includes exactly
+    // the changes logged before the new segment
+    Txn txn(this, 0);
+    {
+      unique_lock<mutex> lock(m_mutex);
+      txn.m_id = m_next_txn_id++;
+      lock_namespace(txn, LOCK_SHARED, lock);
+      for (auto &entry : m_namespace)
+        encode_record(state, entry.first, &entry.second);
+    }
+    segment = m_segment + 1;
+    roll_segment(segment);
+    txn.commit();
+  }
+
+  write_snapshot(segment, state);
+  HT_INFOF("Wrote Hyperspace snapshot %s (%llu bytes)",
+           snapshot_path(segment).c_str(), (Llu)state.fill());
+
+  auto now = std::chrono::steady_clock::now();
+  if (now - m_last_log_gc_time > m_log_gc_interval) {
+    m_last_log_gc_time = now;
+    remove_obsolete_files(segment);
+  }
+}
+
+StateTxnPtr LogStructuredFilesystem::start_transaction() {
+  lock_guard<mutex> lock(m_mutex);
+  return StateTxnPtr(new Txn(this, m_next_txn_id++));
+}
+
+bool
+LogStructuredFilesystem::get_xattr_i32(StateTxn &state_txn, const String &fname,
+                                       const String &aname, uint32_t *valuep) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_namespace(txn, LOCK_SHARED, lock);
+  auto iter = m_namespace.find(attr_key(fname, aname));
+  if (iter == m_namespace.end())
+    return false;
+  *valuep = strtoll(iter->second.c_str(), 0, 0);
+  return true;
+}
+
+void
+LogStructuredFilesystem::set_xattr_i32(StateTxn &state_txn, const String &fname,
+                                       const String &aname, uint32_t value) {
+  Txn &txn = cast(state_txn);
+  char numbuf[16];
+  unique_lock<mutex> lock(m_mutex);
+  lock_namespace(txn, LOCK_EXCLUSIVE, lock);
+  sprintf(numbuf, "%u", value);
+  put_namespace(txn, attr_key(fname, aname), numbuf);
+}
+
+bool
+LogStructuredFilesystem::get_xattr_i64(StateTxn &state_txn, const String &fname,
+                                       const String &aname, uint64_t *valuep) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_namespace(txn, LOCK_SHARED, lock);
+  auto iter = m_namespace.find(attr_key(fname, aname));
+  if (iter == m_namespace.end())
+    return false;
+  *valuep = strtoll(iter->second.c_str(), 0, 0);
+  return true;
+}
+
+void
+LogStructuredFilesystem::set_xattr_i64(StateTxn &state_txn, const String &fname,
+                                       const String &aname, uint64_t value) {
+  Txn &txn = cast(state_txn);
+  char numbuf[24];
+  unique_lock<mutex> lock(m_mutex);
+  lock_namespace(txn, LOCK_EXCLUSIVE, lock);
+  sprintf(numbuf, "%llu", (Llu)value);
+  put_namespace(txn, attr_key(fname, aname), numbuf);
+}
+
+void
+LogStructuredFilesystem::set_xattr(StateTxn &state_txn, const String &fname,
+                                   const String &aname, const void *value,
+                                   size_t value_len) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_namespace(txn, LOCK_EXCLUSIVE, lock);
+  put_namespace(txn, attr_key(fname, aname),
+                String((const char *)value, value_len));
+}
+
+bool
+LogStructuredFilesystem::get_xattr(StateTxn &state_txn, const String &fname,
+                                   const String &aname, DynamicBuffer &vbuf) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_namespace(txn, LOCK_SHARED, lock);
+  auto iter = m_namespace.find(attr_key(fname, aname));
+  if (iter == m_namespace.end())
+    return false;
+  vbuf.reserve(iter->second.length());
+  vbuf.add_unchecked(iter->second.data(), iter->second.length());
+  return true;
+}
+
+bool
+LogStructuredFilesystem::incr_attr(StateTxn &state_txn, const String &fname,
+                                   const String &aname, uint64_t *valuep) {
+  Txn &txn = cast(state_txn);
+  char numbuf[24];
+  unique_lock<mutex> lock(m_mutex);
+  lock_namespace(txn, LOCK_EXCLUSIVE, lock);
+  String key = attr_key(fname, aname);
+  auto iter = m_namespace.find(key);
+  if (iter == m_namespace.end())
+    return false;
+
+  if (iter->second.length() >= 24)
+    HT_THROWF(HYPERSPACE_BAD_ATTRIBUTE,
+              "incr attribute '%s' exceeds 24 characters", aname.c_str());
+
+  const char *value = iter->second.c_str();
+  for (const char *ptr=value; *ptr; ptr++) {
+    if (!::isdigit(*ptr))
+      HT_THROWF(HYPERSPACE_BAD_ATTRIBUTE,
+                "incr attribute '%s' contains invalid characters: %s",
+                aname.c_str(), value);
+  }
+
+  *valuep = strtoull(value, 0, 0);
+  sprintf(numbuf, "%llu", (Llu)*valuep + 1);
+  put_namespace(txn, key, numbuf);
+  return true;
+}
+
+bool
+LogStructuredFilesystem::exists_xattr(StateTxn &state_txn, const String &fname,
+                                      const String &aname) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_namespace(txn, LOCK_SHARED, lock);
+  return m_namespace.find(attr_key(fname, aname)) != m_namespace.end();
+}
+
+void
+LogStructuredFilesystem::del_xattr(StateTxn &state_txn, const String &fname,
+                                   const String &aname) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_namespace(txn, LOCK_EXCLUSIVE, lock);
+  String key = attr_key(fname, aname);
+  if (m_namespace.find(key) == m_namespace.end())
+    HT_THROW(HYPERSPACE_ATTR_NOT_FOUND, aname);
+  del_namespace(txn, key);
+}
+
+void LogStructuredFilesystem::mkdir(StateTxn &state_txn, const String &name) {
+  Txn &txn = cast(state_txn);
+  size_t lastslash = name.rfind('/', name.length()-1);
+  String dirname = name.substr(0, lastslash+1);
+
+  unique_lock<mutex> lock(m_mutex);
+  lock_namespace(txn, LOCK_EXCLUSIVE, lock);
+
+  // Make sure parent directory exists
+  if (m_namespace.find(dirname) == m_namespace.end())
+    HT_THROW(HYPERSPACE_FILE_NOT_FOUND, dirname);
+
+  dirname = name;
+  if (dirname[dirname.length()-1] != '/')
+    dirname += "/";
+
+  if (m_namespace.find(dirname) != m_namespace.end())
+    HT_THROW(HYPERSPACE_FILE_EXISTS, dirname);
+
+  put_namespace(txn, dirname, "");
+}
+
+void LogStructuredFilesystem::unlink(StateTxn &state_txn, const String &name) {
+  Txn &txn = cast(state_txn);
+  vector<String> delkeys;
+  bool looks_like_dir = false;
+  bool looks_like_file = false;
+
+  unique_lock<mutex> lock(m_mutex);
+  lock_namespace(txn, LOCK_EXCLUSIVE, lock);
+
+  for (auto iter = m_namespace.lower_bound(name);
+       iter != m_namespace.end() &&
+         !iter->first.compare(0, name.length(), name); ++iter) {
+    const String &str = iter->first;
+    if (str.length() > name.length()) {
+      if (str[name.length()] == '/') {
+        if (str.length() > name.length() + 1
+            && str[name.length() + 1] != NODE_ATTR_DELIM)
+          HT_THROW(HYPERSPACE_DIR_NOT_EMPTY, name);
+        looks_like_dir = true;
+        delkeys.push_back(str);
+      }
+      else if (str[name.length()] == NODE_ATTR_DELIM) {
+        looks_like_file = true;
+        delkeys.push_back(str);
+      }
+    }
+    else {
+      delkeys.push_back(str);
+      looks_like_file = true;
+    }
+  }
+
+  HT_ASSERT(!(looks_like_dir && looks_like_file));
+
+  if (delkeys.empty())
+    HT_THROW(HYPERSPACE_FILE_NOT_FOUND, name);
+
+  for (auto &key : delkeys)
+    del_namespace(txn, key);
+}
+
+bool LogStructuredFilesystem::exists(StateTxn &state_txn, String fname,
+                                     bool *is_dir_p) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_namespace(txn, LOCK_SHARED, lock);
+  return name_exists(fname, is_dir_p);
+}
+
+void LogStructuredFilesystem::create(StateTxn &state_txn, const String &fname,
+                                     bool temp) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_namespace(txn, LOCK_EXCLUSIVE, lock);
+
+  if (name_exists(fname, 0))
+    HT_THROW(HYPERSPACE_FILE_EXISTS, fname);
+
+  if (!fname.empty() && fname[fname.length()-1] == '/')
+    HT_THROW(HYPERSPACE_IS_DIRECTORY, fname);
+
+  size_t lastslash = fname.rfind('/', fname.length() - 1);
+  String parent_dir = fname.substr(0, lastslash + 1);
+
+  if (m_namespace.find(parent_dir) == m_namespace.end())
+    HT_THROW(HYPERSPACE_BAD_PATHNAME, fname);
+
+  put_namespace(txn, fname, "");
+
+  if (temp)
+    put_namespace(txn, fname + NODE_ATTR_DELIM + "temp", "");
+}
+
+void
+LogStructuredFilesystem::get_directory_listing(StateTxn &state_txn,
+                                               String fname,
+                                               std::vector<DirEntry> &listing) {
+  Txn &txn = cast(state_txn);
+  String str, last_str;
+  DirEntry entry;
+  size_t offset;
+
+  if (fname.empty() || fname[fname.length()-1] != '/')
+    fname += "/";
+
+  unique_lock<mutex> lock(m_mutex);
+  lock_namespace(txn, LOCK_SHARED, lock);
+
+  auto iter = m_namespace.lower_bound(fname);
+  if (iter == m_namespace.end())
+    return;
+
+  if (iter->first.compare(0, fname.length(), fname))
+    HT_THROW(HYPERSPACE_BAD_PATHNAME, fname);
+
+  for (; iter != m_namespace.end() &&
+         !iter->first.compare(0, fname.length(), fname); ++iter) {
+    if (iter->first.length() <= fname.length() ||
+        iter->first[fname.length()] == NODE_ATTR_DELIM)
+      continue;
+    str = iter->first.substr(fname.length());
+    if ((offset = str.find('/')) != String::npos) {
+      entry.name = str.substr(0, offset);
+      entry.is_dir = true;
+    }
+    else {
+      entry.name = str.substr(0, str.find(NODE_ATTR_DELIM));
+      entry.is_dir = false;
+    }
+    if (entry.name != last_str) {
+      listing.push_back(entry);
+      last_str = entry.name;
+    }
+  }
+}
+
+void
+LogStructuredFilesystem::get_directory_attr_listing(StateTxn &state_txn,
+                                                    String fname,
+                                                    const String &aname,
+                                                    bool include_sub_entries,
+                                                    std::vector<DirEntryAttr> &listing) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_namespace(txn, LOCK_SHARED, lock);
+  attr_listing(fname, aname, include_sub_entries, listing);
+}
+
+void
+LogStructuredFilesystem::get_directory_attr_listing(StateTxn &state_txn,
+                                                    String fname,
+                                                    const String &aname,
+                                                    std::vector<DirEntryAttr> &listing) {
+  get_directory_attr_listing(state_txn, fname, aname, false, listing);
+}
+
+void
+LogStructuredFilesystem::get_all_names(StateTxn &state_txn,
+                                       std::vector<String> &names) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_namespace(txn, LOCK_SHARED, lock);
+  for (auto &entry : m_namespace)
+    names.push_back(entry.first);
+}
+
+bool
+LogStructuredFilesystem::list_xattr(StateTxn &state_txn, const String& fname,
+                                    std::vector<String> &anames) {
+  Txn &txn = cast(state_txn);
+  bool isdir;
+
+  unique_lock<mutex> lock(m_mutex);
+  lock_namespace(txn, LOCK_SHARED, lock);
+
+  if (!name_exists(fname, &isdir))
+    HT_THROW(HYPERSPACE_FILE_NOT_FOUND, fname);
+
+  const String prefix(fname + (isdir ? "/" : "") + NODE_ATTR_DELIM);
+
+  for (auto iter = m_namespace.lower_bound(prefix);
+       iter != m_namespace.end() &&
+         !iter->first.compare(0, prefix.length(), prefix); ++iter)
+    anames.push_back(iter->first.substr(prefix.length()));
+
+  return true;
+}
+
+void LogStructuredFilesystem::create_event(StateTxn &state_txn, uint32_t type,
+                                           uint64_t id, uint32_t mask) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_event(txn, id, LOCK_EXCLUSIVE, lock);
+  HT_ASSERT(m_events.find(id) == m_events.end());
+  EventState &event = save_event(txn, id);
+  event.type = type;
+  event.mask = mask;
+}
+
+void LogStructuredFilesystem::create_event(StateTxn &state_txn, uint32_t type,
+                                           uint64_t id, uint32_t mask,
+                                           const String &name) {
+  Txn &txn = cast(state_txn);
+  create_event(txn, type, id, mask);
+  lock_guard<mutex> lock(m_mutex);
+  m_events[id].name = name;
+}
+
+void LogStructuredFilesystem::create_event(StateTxn &state_txn, uint32_t type,
+                                           uint64_t id, uint32_t mask,
+                                           uint32_t mode) {
+  Txn &txn = cast(state_txn);
+  create_event(txn, type, id, mask);
+  lock_guard<mutex> lock(m_mutex);
+  m_events[id].mode = mode;
+}
+
+void LogStructuredFilesystem::create_event(StateTxn &state_txn, uint32_t type,
+                                           uint64_t id, uint32_t mask,
+                                           uint32_t mode, uint64_t generation) {
+  Txn &txn = cast(state_txn);
+  create_event(txn, type, id, mask);
+  lock_guard<mutex> lock(m_mutex);
+  EventState &event = m_events[id];
+  event.mode = mode;
+  event.generation = generation;
+}
+
+void LogStructuredFilesystem::delete_event(StateTxn &state_txn, uint64_t id) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_event(txn, id, LOCK_EXCLUSIVE, lock);
+  if (m_events.find(id) == m_events.end())
+    return;
+  save_event(txn, id);
+  m_events.erase(id);
+}
+
+void
+LogStructuredFilesystem::set_event_notification_handles(StateTxn &state_txn,
+                                                        uint64_t id,
+                                                        const std::vector<uint64_t> &handles) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_event(txn, id, LOCK_EXCLUSIVE, lock);
+  HT_ASSERT(m_events.find(id) != m_events.end());
+  EventState &event = save_event(txn, id);
+  HT_ASSERT(!event.has_notification_handles);
+  event.has_notification_handles = true;
+  event.notification_handles = handles;
+}
+
+bool LogStructuredFilesystem::event_exists(StateTxn &state_txn, uint64_t id) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_event(txn, id, LOCK_SHARED, lock);
+  return m_events.find(id) != m_events.end();
+}
+
+void LogStructuredFilesystem::create_session(StateTxn &state_txn, uint64_t id,
+                                             const String &addr) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_session(txn, id, LOCK_EXCLUSIVE, lock);
+  HT_ASSERT(m_sessions.find(id) == m_sessions.end());
+  Session &session = save_session(txn, id);
+  session.addr = addr;
+}
+
+void LogStructuredFilesystem::delete_session(StateTxn &state_txn,
+                                             uint64_t id) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_session(txn, id, LOCK_EXCLUSIVE, lock);
+  HT_ASSERT(m_sessions.find(id) != m_sessions.end());
+  save_session(txn, id);
+  m_sessions.erase(id);
+}
+
+void LogStructuredFilesystem::expire_session(StateTxn &state_txn,
+                                             uint64_t id) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_session(txn, id, LOCK_EXCLUSIVE, lock);
+  HT_ASSERT(m_sessions.find(id) != m_sessions.end());
+  save_session(txn, id).expired = true;
+}
+
+void LogStructuredFilesystem::add_session_handle(StateTxn &state_txn,
+                                                 uint64_t id,
+                                                 uint64_t handle_id) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_session(txn, id, LOCK_EXCLUSIVE, lock);
+  HT_ASSERT(m_sessions.find(id) != m_sessions.end());
+  save_session(txn, id).handles.push_back(handle_id);
+}
+
+void
+LogStructuredFilesystem::get_session_handles(StateTxn &state_txn, uint64_t id,
+                                             std::vector<uint64_t> &handles) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_session(txn, id, LOCK_SHARED, lock);
+  Session &session = get_session(id);
+  handles.insert(handles.end(), session.handles.begin(),
+                 session.handles.end());
+}
+
+bool LogStructuredFilesystem::delete_session_handle(StateTxn &state_txn,
+                                                    uint64_t id,
+                                                    uint64_t handle_id) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_session(txn, id, LOCK_EXCLUSIVE, lock);
+  Session &session = get_session(id);
+  if (find(session.handles.begin(), session.handles.end(), handle_id) ==
+      session.handles.end())
+    return false;
+  return erase_value(save_session(txn, id).handles, handle_id);
+}
+
+bool LogStructuredFilesystem::session_exists(StateTxn &state_txn,
+                                             uint64_t id) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_session(txn, id, LOCK_SHARED, lock);
+  return m_sessions.find(id) != m_sessions.end();
+}
+
+String LogStructuredFilesystem::get_session_name(StateTxn &state_txn,
+                                                 uint64_t id) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_session(txn, id, LOCK_SHARED, lock);
+  auto iter = m_sessions.find(id);
+  HT_EXPECT(iter != m_sessions.end(), HYPERSPACE_STATEDB_SESSION_NOT_EXISTS);
+  return iter->second.name;
+}
+
+void LogStructuredFilesystem::set_session_name(StateTxn &state_txn,
+                                               uint64_t id,
+                                               const String &name) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_session(txn, id, LOCK_EXCLUSIVE, lock);
+  HT_ASSERT(m_sessions.find(id) != m_sessions.end());
+  save_session(txn, id).name = name;
+}
+
+void LogStructuredFilesystem::create_handle(StateTxn &state_txn, uint64_t id,
+                                            String node_name,
+                                            uint32_t open_flags,
+                                            uint32_t event_mask,
+                                            uint64_t session_id, bool locked,
+                                            uint32_t del_state) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_handle(txn, id, LOCK_EXCLUSIVE, lock);
+  HT_ASSERT(m_handles.find(id) == m_handles.end());
+  Handle &handle = save_handle(txn, id);
+  handle.node_name = node_name;
+  handle.open_flags = open_flags;
+  handle.event_mask = event_mask;
+  handle.session_id = session_id;
+  handle.locked = locked;
+  handle.del_state = del_state;
+}
+
+void LogStructuredFilesystem::delete_handle(StateTxn &state_txn, uint64_t id) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_handle(txn, id, LOCK_EXCLUSIVE, lock);
+  if (m_handles.find(id) == m_handles.end())
+    return;
+  save_handle(txn, id);
+  m_handles.erase(id);
+}
+
+uint32_t LogStructuredFilesystem::get_handle_open_flags(StateTxn &state_txn,
+                                                        uint64_t id) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_handle(txn, id, LOCK_SHARED, lock);
+  return get_handle(id).open_flags;
+}
+
+void LogStructuredFilesystem::set_handle_del_state(StateTxn &state_txn,
+                                                   uint64_t id,
+                                                   uint32_t del_state) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_handle(txn, id, LOCK_EXCLUSIVE, lock);
+  get_handle(id);
+  save_handle(txn, id).del_state = del_state;
+}
+
+uint32_t LogStructuredFilesystem::get_handle_del_state(StateTxn &state_txn,
+                                                       uint64_t id) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_handle(txn, id, LOCK_SHARED, lock);
+  return get_handle(id).del_state;
+}
+
+void LogStructuredFilesystem::set_handle_open_flags(StateTxn &state_txn,
+                                                    uint64_t id,
+                                                    uint32_t open_flags) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_handle(txn, id, LOCK_EXCLUSIVE, lock);
+  HT_EXPECT(m_handles.find(id) != m_handles.end(),
+            HYPERSPACE_STATEDB_HANDLE_NOT_EXISTS);
+  save_handle(txn, id).open_flags = open_flags;
+}
+
+void LogStructuredFilesystem::set_handle_event_mask(StateTxn &state_txn,
+                                                    uint64_t id,
+                                                    uint32_t event_mask) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_handle(txn, id, LOCK_EXCLUSIVE, lock);
+  HT_EXPECT(m_handles.find(id) != m_handles.end(),
+            HYPERSPACE_STATEDB_HANDLE_NOT_EXISTS);
+  save_handle(txn, id).event_mask = event_mask;
+}
+
+uint32_t LogStructuredFilesystem::get_handle_event_mask(StateTxn &state_txn,
+                                                        uint64_t id) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_handle(txn, id, LOCK_SHARED, lock);
+  return get_handle(id).event_mask;
+}
+
+void LogStructuredFilesystem::get_handle_node(StateTxn &state_txn, uint64_t id,
+                                              String &node_name) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_handle(txn, id, LOCK_SHARED, lock);
+  node_name = get_handle(id).node_name;
+}
+
+uint64_t LogStructuredFilesystem::get_handle_session(StateTxn &state_txn,
+                                                     uint64_t id) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_handle(txn, id, LOCK_SHARED, lock);
+  return get_handle(id).session_id;
+}
+
+void LogStructuredFilesystem::set_handle_locked(StateTxn &state_txn,
+                                                uint64_t id, bool locked) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_handle(txn, id, LOCK_EXCLUSIVE, lock);
+  get_handle(id);
+  save_handle(txn, id).locked = locked;
+}
+
+bool LogStructuredFilesystem::handle_is_locked(StateTxn &state_txn,
+                                               uint64_t id) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_handle(txn, id, LOCK_SHARED, lock);
+  return get_handle(id).locked;
+}
+
+bool LogStructuredFilesystem::handle_exists(StateTxn &state_txn, uint64_t id) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_handle(txn, id, LOCK_SHARED, lock);
+  return m_handles.find(id) != m_handles.end();
+}
+
+void LogStructuredFilesystem::create_node(StateTxn &state_txn,
+                                          const String &name, bool ephemeral,
+                                          uint64_t lock_generation,
+                                          uint32_t cur_lock_mode,
+                                          uint64_t exclusive_handle) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_EXCLUSIVE, lock);
+  HT_ASSERT(m_nodes.find(name) == m_nodes.end());
+  Node &node = save_node(txn, name);
+  node.ephemeral = ephemeral;
+  node.lock_generation = lock_generation;
+  node.lock_mode = cur_lock_mode;
+  node.exclusive_handle = exclusive_handle;
+}
+
+void LogStructuredFilesystem::set_node_lock_generation(StateTxn &state_txn,
+                                                       const String &name,
+                                                       uint64_t lock_generation) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_EXCLUSIVE, lock);
+  get_node(name);
+  save_node(txn, name).lock_generation = lock_generation;
+}
+
+uint64_t LogStructuredFilesystem::incr_node_lock_generation(StateTxn &state_txn,
+                                                            const String &name) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_EXCLUSIVE, lock);
+  get_node(name);
+  return ++save_node(txn, name).lock_generation;
+}
+
+void LogStructuredFilesystem::set_node_ephemeral(StateTxn &state_txn,
+                                                 const String &name,
+                                                 bool ephemeral) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_EXCLUSIVE, lock);
+  get_node(name);
+  save_node(txn, name).ephemeral = ephemeral;
+}
+
+bool LogStructuredFilesystem::node_is_ephemeral(StateTxn &state_txn,
+                                                const String &name) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_SHARED, lock);
+  return get_node(name).ephemeral;
+}
+
+void LogStructuredFilesystem::set_node_cur_lock_mode(StateTxn &state_txn,
+                                                     const String &name,
+                                                     uint32_t lock_mode) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_EXCLUSIVE, lock);
+  get_node(name);
+  save_node(txn, name).lock_mode = lock_mode;
+}
+
+uint32_t LogStructuredFilesystem::get_node_cur_lock_mode(StateTxn &state_txn,
+                                                         const String &name) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_SHARED, lock);
+  return get_node(name).lock_mode;
+}
+
+void
+LogStructuredFilesystem::set_node_exclusive_lock_handle(StateTxn &state_txn,
+                                                        const String &name,
+                                                        uint64_t exclusive_lock_handle) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_EXCLUSIVE, lock);
+  get_node(name);
+  save_node(txn, name).exclusive_handle = exclusive_lock_handle;
+}
+
+uint64_t
+LogStructuredFilesystem::get_node_exclusive_lock_handle(StateTxn &state_txn,
+                                                        const String &name) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_SHARED, lock);
+  return get_node(name).exclusive_handle;
+}
+
+void LogStructuredFilesystem::add_node_handle(StateTxn &state_txn,
+                                              const String &name,
+                                              uint64_t handle) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_EXCLUSIVE, lock);
+  get_node(name);
+  save_node(txn, name).handles.push_back(handle);
+}
+
+void LogStructuredFilesystem::delete_node_handle(StateTxn &state_txn,
+                                                 const String &name,
+                                                 uint64_t handle) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_EXCLUSIVE, lock);
+  get_node(name);
+  HT_ASSERT(erase_value(save_node(txn, name).handles, handle));
+}
+
+bool LogStructuredFilesystem::node_has_open_handles(StateTxn &state_txn,
+                                                    const String &name) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_SHARED, lock);
+  return !get_node(name).handles.empty();
+}
+
+bool
+LogStructuredFilesystem::node_has_pending_lock_request(StateTxn &state_txn,
+                                                       const String &name) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_SHARED, lock);
+  return !get_node(name).pending_lock_requests.empty();
+}
+
+bool
+LogStructuredFilesystem::get_node_pending_lock_request(StateTxn &state_txn,
+                                                       const String &name,
+                                                       LockRequest &front_req) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_SHARED, lock);
+  Node &node = get_node(name);
+  if (node.pending_lock_requests.empty())
+    return false;
+  front_req = node.pending_lock_requests.front();
+  return true;
+}
+
+void
+LogStructuredFilesystem::add_node_pending_lock_request(StateTxn &state_txn,
+                                                       const String &name,
+                                                       LockRequest &request) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_EXCLUSIVE, lock);
+  get_node(name);
+  save_node(txn, name).pending_lock_requests.push_back(request);
+}
+
+void
+LogStructuredFilesystem::delete_node_pending_lock_request(StateTxn &state_txn,
+                                                          const String &name,
+                                                          uint64_t handle) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_EXCLUSIVE, lock);
+  get_node(name);
+  vector<LockRequest> &requests = save_node(txn, name).pending_lock_requests;
+  auto iter = find_if(requests.begin(), requests.end(),
+                      [handle](const LockRequest &request) {
+                        return request.handle == handle; });
+  HT_ASSERT(iter != requests.end());
+  requests.erase(iter);
+}
+
+void LogStructuredFilesystem::add_node_shared_lock_handle(StateTxn &state_txn,
+                                                          const String &name,
+                                                          uint64_t handle) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_EXCLUSIVE, lock);
+  get_node(name);
+  save_node(txn, name).shared_lock_handles.push_back(handle);
+}
+
+bool
+LogStructuredFilesystem::get_node_event_notification_map(StateTxn &state_txn,
+                                                         const String &name,
+                                                         uint32_t event_mask,
+                                                         NotificationMap &handles_to_sessions) {
+  Txn &txn = cast(state_txn);
+  bool has_notifications = false;
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_SHARED, lock);
+  vector<uint64_t> handles = get_node(name).handles;
+  for (auto id : handles) {
+    lock_handle(txn, id, LOCK_SHARED, lock);
+    Handle &handle = get_handle(id);
+    if ((handle.event_mask & event_mask) != 0) {
+      handles_to_sessions[id] = handle.session_id;
+      has_notifications = true;
+    }
+  }
+  return has_notifications;
+}
+
+void LogStructuredFilesystem::get_node_handles(StateTxn &state_txn,
+                                               const String &name,
+                                               std::vector<uint64_t> &handles) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_SHARED, lock);
+  Node &node = get_node(name);
+  handles.insert(handles.end(), node.handles.begin(), node.handles.end());
+}
+
+void
+LogStructuredFilesystem::delete_node_shared_lock_handle(StateTxn &state_txn,
+                                                        const String &name,
+                                                        uint64_t handle_id) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_EXCLUSIVE, lock);
+  get_node(name);
+  HT_ASSERT(erase_value(save_node(txn, name).shared_lock_handles, handle_id));
+}
+
+bool LogStructuredFilesystem::delete_node(StateTxn &state_txn,
+                                          const String &name) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_EXCLUSIVE, lock);
+  if (m_nodes.find(name) == m_nodes.end())
+    return false;
+  save_node(txn, name);
+  m_nodes.erase(name);
+  return true;
+}
+
+bool LogStructuredFilesystem::node_exists(StateTxn &state_txn,
+                                          const String &name) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_SHARED, lock);
+  return m_nodes.find(name) != m_nodes.end();
+}
+
+bool
+LogStructuredFilesystem::node_has_shared_lock_handles(StateTxn &state_txn,
+                                                      const String &name) {
+  Txn &txn = cast(state_txn);
+  unique_lock<mutex> lock(m_mutex);
+  lock_node(txn, name, LOCK_SHARED, lock);
+  return !get_node(name).shared_lock_handles.empty();
+}
+
+uint64_t LogStructuredFilesystem::get_next_id_i64(StateTxn &state_txn,
+                                                  IdentifierType id_type,
+                                                  bool increment) {
+  Txn &txn = cast(state_txn);
+  if (id_type != SESSION && id_type != HANDLE && id_type != EVENT)
+    HT_THROWF(HYPERSPACE_STATEDB_BAD_KEY, "Unknown i64 id type:%d", id_type);
+  unique_lock<mutex> lock(m_mutex);
+  acquire(txn, String("I") + (char)('0' + id_type),
+          increment ? LOCK_EXCLUSIVE : LOCK_SHARED, lock);
+  uint64_t id = m_next_id[id_type];
+  if (increment) {
+    txn.m_next_id_undo.emplace(id_type, id);
+    m_next_id[id_type]++;
+  }
+  return id;
+}
+
+LogStructuredFilesystem::Txn &LogStructuredFilesystem::cast(StateTxn &txn) {
+  Txn &log_txn = static_cast<Txn &>(txn);
+  HT_ASSERT(log_txn.m_fs == this && !log_txn.m_finished);
+  return log_txn;
+}
+
+void LogStructuredFilesystem::acquire(Txn &txn, const String &name,
+                                      LockMode mode,
+                                      std::unique_lock<std::mutex> &lock) {
+  auto held = txn.m_locks.find(name);
+  if (held != txn.m_locks.end() &&
+      (held->second == LOCK_EXCLUSIVE || mode == LOCK_SHARED))
+    return;
+
+  auto deadline = std::chrono::steady_clock::now() + m_lock_timeout;
+  while (true) {
+    ObjectLock &object_lock = m_locks[name];
+    bool granted;
+    if (mode == LOCK_SHARED)
+      granted = object_lock.exclusive_owner == 0;
+    else
+      granted = object_lock.exclusive_owner == 0 &&
+        (object_lock.shared_owners.empty() ||
+         (object_lock.shared_owners.size() == 1 &&
+          object_lock.shared_owners.front() == txn.m_id));
+    if (granted) {
+      if (mode == LOCK_SHARED)
+        object_lock.shared_owners.push_back(txn.m_id);
+      else {
+        object_lock.shared_owners.clear();
+        object_lock.exclusive_owner = txn.m_id;
+      }
+      txn.m_locks[name] = mode;
+      return;
+    }
+    if (m_lock_cond.wait_until(lock, deadline) == cv_status::timeout &&
+        std::chrono::steady_clock::now() >= deadline) {
+      auto iter = m_locks.find(name);
+      if (iter != m_locks.end() && iter->second.exclusive_owner == 0 &&
+          iter->second.shared_owners.empty())
+        m_locks.erase(iter);
+      HT_THROWF(HYPERSPACE_STATEDB_DEADLOCK,
+                "Timed out waiting for lock on '%s'", name.c_str());
+    }
+  }
+}
+
+void LogStructuredFilesystem::lock_namespace(Txn &txn, LockMode mode,
+                                             std::unique_lock<std::mutex> &lock) {
+  static const String name("N");
+  acquire(txn, name, mode, lock);
+  txn.m_namespace_accessed = true;
+}
+
+void LogStructuredFilesystem::lock_session(Txn &txn, uint64_t id,
+                                           LockMode mode,
+                                           std::unique_lock<std::mutex> &lock) {
+  acquire(txn, format("S%llu", (Llu)id), mode, lock);
+}
+
+void LogStructuredFilesystem::lock_handle(Txn &txn, uint64_t id,
+                                          LockMode mode,
+                                          std::unique_lock<std::mutex> &lock) {
+  acquire(txn, format("H%llu", (Llu)id), mode, lock);
+}
+
+void LogStructuredFilesystem::lock_node(Txn &txn, const String &name,
+                                        LockMode mode,
+                                        std::unique_lock<std::mutex> &lock) {
+  acquire(txn, String("O") + name, mode, lock);
+}
+
+void LogStructuredFilesystem::lock_event(Txn &txn, uint64_t id,
+                                         LockMode mode,
+                                         std::unique_lock<std::mutex> &lock) {
+  acquire(txn, format("E%llu", (Llu)id), mode, lock);
+}
+
+void LogStructuredFilesystem::release_locks(Txn &txn) {
+  for (auto &held : txn.m_locks) {
+    auto iter = m_locks.find(held.first);
+    HT_ASSERT(iter != m_locks.end());
+    if (held.second == LOCK_EXCLUSIVE)
+      iter->second.exclusive_owner = 0;
+    else
+      erase_value(iter->second.shared_owners, txn.m_id);
+    if (iter->second.exclusive_owner == 0 &&
+        iter->second.shared_owners.empty())
+      m_locks.erase(iter);
+  }
+  if (!txn.m_locks.empty())
+    m_lock_cond.notify_all();
+  txn.m_locks.clear();
+}
+
+void LogStructuredFilesystem::put_namespace(Txn &txn, const String &key,
+                                            const String &value) {
+  save(m_namespace, txn.m_namespace_undo, key) = value;
+}
+
+void LogStructuredFilesystem::del_namespace(Txn &txn, const String &key) {
+  save(m_namespace, txn.m_namespace_undo, key);
+  m_namespace.erase(key);
+}
+
+String LogStructuredFilesystem::attr_key(const String &fname,
+                                         const String &aname) {
+  bool isdir;
+  if (!name_exists(fname, &isdir))
+    HT_THROW(HYPERSPACE_FILE_NOT_FOUND, fname);
+  String key = fname;
+  if (isdir)
+    key += "/";
+  key += NODE_ATTR_DELIM;
+  key += aname;
+  return key;
+}
+
+bool LogStructuredFilesystem::name_exists(String fname, bool *is_dir_p) {
+  if (is_dir_p)
+    *is_dir_p = false;
+  if (m_namespace.find(fname) != m_namespace.end())
+    return true;
+  fname += "/";
+  if (m_namespace.find(fname) == m_namespace.end())
+    return false;
+  if (is_dir_p)
+    *is_dir_p = true;
+  return true;
+}
+
+void LogStructuredFilesystem::attr_listing(String fname, const String &aname,
+                                           bool include_sub_entries,
+                                           std::vector<DirEntryAttr> &listing) {
+  String entryname, last_entryname, str;
+  DirEntryAttr entry;
+  size_t offset;
+
+  if (fname.empty() || fname[fname.length()-1] != '/')
+    fname += "/";
+
+  auto iter = m_namespace.lower_bound(fname);
+  if (iter == m_namespace.end())
+    return;
+
+  if (iter->first.compare(0, fname.length(), fname))
+    HT_THROW(HYPERSPACE_BAD_PATHNAME, fname);
+
+  for (; iter != m_namespace.end() &&
+         !iter->first.compare(0, fname.length(), fname); ++iter) {
+    if (iter->first.length() <= fname.length() ||
+        iter->first[fname.length()] == NODE_ATTR_DELIM)
+      continue;
+    str = iter->first.substr(fname.length());
+    offset = str.find_first_of(stop_chars);
+    entryname = (offset == String::npos) ? str : str.substr(0, offset);
+    if (entryname != last_entryname) {
+      if (last_entryname != "")
+        listing.push_back(entry);
+      last_entryname = entryname;
+      entry.name = entryname;
+      entry.has_attr = false;
+      entry.is_dir = false;
+      entry.attr.free();
+    }
+    if (offset == String::npos)
+      continue;
+    const char *attr = 0;
+    if (str[offset] == '/') {
+      entry.is_dir = true;
+      if (str.length() > offset+2 && str[offset+1] == NODE_ATTR_DELIM)
+        attr = str.c_str() + offset + 2;
+    }
+    else
+      attr = str.c_str() + offset + 1;
+    if (attr && aname == attr) {
+      DynamicBuffer buffer(iter->second.length());
+      buffer.add_unchecked(iter->second.data(), iter->second.length());
+      entry.attr = buffer;
+      entry.has_attr = true;
+    }
+  }
+
+  if (last_entryname != "")
+    listing.push_back(entry);
+
+  if (include_sub_entries) {
+    for (auto &sub : listing)
+      if (sub.is_dir)
+        attr_listing(fname + sub.name, aname, true, sub.sub_entries);
+  }
+}
+
+LogStructuredFilesystem::Session &
+LogStructuredFilesystem::save_session(Txn &txn, uint64_t id) {
+  return save(m_sessions, txn.m_session_undo, id);
+}
+
+LogStructuredFilesystem::Handle &
+LogStructuredFilesystem::save_handle(Txn &txn, uint64_t id) {
+  return save(m_handles, txn.m_handle_undo, id);
+}
+
+LogStructuredFilesystem::Node &
+LogStructuredFilesystem::save_node(Txn &txn, const String &name) {
+  return save(m_nodes, txn.m_node_undo, name);
+}
+
+LogStructuredFilesystem::EventState &
+LogStructuredFilesystem::save_event(Txn &txn, uint64_t id) {
+  return save(m_events, txn.m_event_undo, id);
+}
+
+LogStructuredFilesystem::Session &
+LogStructuredFilesystem::get_session(uint64_t id) {
+  auto iter = m_sessions.find(id);
+  HT_ASSERT(iter != m_sessions.end());
+  return iter->second;
+}
+
+LogStructuredFilesystem::Handle &
+LogStructuredFilesystem::get_handle(uint64_t id) {
+  auto iter = m_handles.find(id);
+  HT_ASSERT(iter != m_handles.end());
+  return iter->second;
+}
+
+LogStructuredFilesystem::Node &
+LogStructuredFilesystem::get_node(const String &name) {
+  auto iter = m_nodes.find(name);
+  HT_ASSERT(iter != m_nodes.end());
+  return iter->second;
+}
+
+void LogStructuredFilesystem::commit(Txn &txn) {
+  uint64_t wait_seq = 0;
+  {
+    lock_guard<mutex> lock(m_mutex);
+    HT_ASSERT(!txn.m_finished);
+    if (!txn.m_namespace_undo.empty()) {
+      DynamicBuffer payload;
+      for (auto &entry : txn.m_namespace_undo) {
+        auto iter = m_namespace.find(entry.first);
+        encode_record(payload, entry.first,
+                      iter == m_namespace.end() ? 0 : &iter->second);
+      }
+      // Appended while the namespace lock is still held, so frames are
+      // logged in commit order
+      m_namespace_seq = append_frame(payload);
+    }
+    if (txn.m_namespace_accessed)
+      wait_seq = m_namespace_seq;
+    txn.m_namespace_undo.clear();
+    txn.m_session_undo.clear();
+    txn.m_handle_undo.clear();
+    txn.m_node_undo.clear();
+    txn.m_event_undo.clear();
+    txn.m_next_id_undo.clear();
+    release_locks(txn);
+    txn.m_finished = true;
+  }
+  if (wait_seq)
+    sync(wait_seq);
+}
+
+void LogStructuredFilesystem::abort(Txn &txn) {
+  lock_guard<mutex> lock(m_mutex);
+  if (txn.m_finished)
+    return;
+  restore(m_namespace, txn.m_namespace_undo);
+  restore(m_sessions, txn.m_session_undo);
+  restore(m_handles, txn.m_handle_undo);
+  restore(m_nodes, txn.m_node_undo);
+  restore(m_events, txn.m_event_undo);
+  for (auto &entry : txn.m_next_id_undo)
+    m_next_id[entry.first] = entry.second;
+  txn.m_next_id_undo.clear();
+  release_locks(txn);
+  txn.m_finished = true;
+}
+
+uint64_t LogStructuredFilesystem::append_frame(DynamicBuffer &payload) {
+  lock_guard<mutex> lock(m_log_mutex);
+  m_log_buffer.ensure(FRAME_HEADER_SIZE + payload.fill());
+  Serialization::encode_i32(&m_log_buffer.ptr, payload.fill());
+  Serialization::encode_i32(&m_log_buffer.ptr,
+                            fletcher32(payload.base, payload.fill()));
+  m_log_buffer.add_unchecked(payload.base, payload.fill());
+  return ++m_appended_seq;
+}
+
+void LogStructuredFilesystem::sync(uint64_t seq) {
+  unique_lock<mutex> lock(m_log_mutex);
+  while (m_synced_seq < seq) {
+    if (m_flushing)
+      m_log_cond.wait(lock);
+    else
+      flush(lock);
+  }
+}
+
+void LogStructuredFilesystem::flush(std::unique_lock<std::mutex> &lock) {
+  HT_ASSERT(!m_flushing);
+  m_flushing = true;
+
+  // Take the frames appended so far; committers that append while we are
+  // writing will be made durable by the next flush
+  uint64_t seq = m_appended_seq;
+  size_t len;
+  uint8_t *buf = m_log_buffer.release(&len);
+  int fd = m_fd;
+  String path = segment_path(m_segment);
+
+  lock.unlock();
+  if (len)
+    write_fully(fd, buf, len, path);
+  if (fdatasync(fd) != 0)
+    HT_FATALF("Problem syncing %s - %s", path.c_str(), strerror(errno));
+  delete [] buf;
+  lock.lock();
+
+  m_segment_size += len;
+  m_synced_seq = seq;
+  m_flushing = false;
+  m_log_cond.notify_all();
+}
+
+void LogStructuredFilesystem::encode_record(DynamicBuffer &buf,
+                                            const String &key,
+                                            const String *value) {
+  buf.ensure(1 + Serialization::encoded_length_vstr(key.length()) +
+             (value ? Serialization::encoded_length_vstr(value->length()) : 0));
+  Serialization::encode_i8(&buf.ptr, value ? RECORD_SET : RECORD_DELETED);
+  Serialization::encode_vstr(&buf.ptr, key.data(), key.length());
+  if (value)
+    Serialization::encode_vstr(&buf.ptr, value->data(), value->length());
+}
+
+void LogStructuredFilesystem::apply_records(const uint8_t *buf, size_t len) {
+  uint32_t key_len, value_len;
+  while (len) {
+    uint8_t flag = Serialization::decode_i8(&buf, &len);
+    const char *key = Serialization::decode_vstr(&buf, &len, &key_len);
+    if (flag == RECORD_SET) {
+      const char *value = Serialization::decode_vstr(&buf, &len, &value_len);
+      m_namespace[String(key, key_len)] = String(value, value_len);
+    }
+    else if (flag == RECORD_DELETED)
+      m_namespace.erase(String(key, key_len));
+    else
+      HT_THROWF(Error::SERIALIZATION_INPUT_OVERRUN,
+                "Bad namespace record flag %d", (int)flag);
+  }
+}
+
+void LogStructuredFilesystem::recover() {
+  vector<uint32_t> snapshots, segments;
+
+  if (!list_numbered_files(m_log_dir, "snapshot.", snapshots) ||
+      !list_numbered_files(m_log_dir, "log.", segments))
+    HT_FATALF("Unable to read directory %s - %s", m_log_dir.c_str(),
+              strerror(errno));
+
+  // Load the latest intact snapshot
+  uint32_t start = 0;
+  while (!snapshots.empty()) {
+    String path = snapshot_path(snapshots.back());
+    if (replay_file(path)) {
+      start = snapshots.back();
+      HT_INFOF("Loaded Hyperspace snapshot %s", path.c_str());
+      break;
+    }
+    HT_WARNF("Skipping corrupt Hyperspace snapshot %s", path.c_str());
+    m_namespace.clear();
+    snapshots.pop_back();
+  }
+
+  // Replay the segments that follow it
+  for (auto segment : segments) {
+    if (segment < start)
+      continue;
+    if (!replay_file(segment_path(segment)))
+      HT_WARNF("Hyperspace log segment %s ends with a truncated frame",
+               segment_path(segment).c_str());
+  }
+
+  uint32_t next = start + 1;
+  if (!segments.empty())
+    next = std::max(next, segments.back() + 1);
+  open_segment(next);
+}
+
+bool LogStructuredFilesystem::replay_file(const String &path) {
+  off_t len;
+  char *contents = FileUtils::file_to_buffer(path, &len);
+  if (contents == 0)
+    HT_FATALF("Unable to read %s - %s", path.c_str(), strerror(errno));
+
+  const uint8_t *ptr = (const uint8_t *)contents;
+  size_t remain = len;
+  bool intact = true;
+
+  while (remain) {
+    if (remain < FRAME_HEADER_SIZE) {
+      intact = false;
+      break;
+    }
+    uint32_t payload_len = Serialization::decode_i32(&ptr, &remain);
+    uint32_t checksum = Serialization::decode_i32(&ptr, &remain);
+    if (payload_len > remain || fletcher32(ptr, payload_len) != checksum) {
+      intact = false;
+      break;
+    }
+    try {
+      apply_records(ptr, payload_len);
+    }
+    catch (Exception &e) {
+      HT_ERROR_OUT << path << ": " << e << HT_END;
+      intact = false;
+      break;
+    }
+    ptr += payload_len;
+    remain -= payload_len;
+  }
+
+  delete [] contents;
+  return intact;
+}
+
+void LogStructuredFilesystem::open_segment(uint32_t segment) {
+  String path = segment_path(segment);
+  int fd = ::open(path.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+  if (fd < 0)
+    HT_FATALF("Unable to create %s - %s", path.c_str(), strerror(errno));
+  m_fd = fd;
+  m_segment = segment;
+  m_segment_size = 0;
+}
+
+void LogStructuredFilesystem::roll_segment(uint32_t segment) {
+  unique_lock<mutex> lock(m_log_mutex);
+  while (m_flushing)
+    m_log_cond.wait(lock);
+  if (m_log_buffer.fill() || m_synced_seq < m_appended_seq)
+    flush(lock);
+  while (m_flushing)
+    m_log_cond.wait(lock);
+  ::close(m_fd);
+  open_segment(segment);
+}
+
+void LogStructuredFilesystem::write_snapshot(uint32_t segment,
+                                             DynamicBuffer &state) {
+  String path = snapshot_path(segment);
+  String tmp_path = path + ".tmp";
+  uint8_t header[FRAME_HEADER_SIZE];
+  uint8_t *ptr = header;
+
+  Serialization::encode_i32(&ptr, state.fill());
+  Serialization::encode_i32(&ptr, fletcher32(state.base, state.fill()));
+
+  int fd = ::open(tmp_path.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+  if (fd < 0)
+    HT_FATALF("Unable to create %s - %s", tmp_path.c_str(), strerror(errno));
+  write_fully(fd, header, FRAME_HEADER_SIZE, tmp_path);
+  write_fully(fd, state.base, state.fill(), tmp_path);
+  if (fsync(fd) != 0)
+    HT_FATALF("Problem syncing %s - %s", tmp_path.c_str(), strerror(errno));
+  ::close(fd);
+
+  if (!FileUtils::rename(tmp_path, path))
+    HT_FATALF("Unable to rename %s to %s", tmp_path.c_str(), path.c_str());
+}
+
+void LogStructuredFilesystem::remove_obsolete_files(uint32_t segment) {
+  vector<uint32_t> snapshots, segments;
+
+  list_numbered_files(m_log_dir, "snapshot.", snapshots);
+  for (auto snapshot : snapshots) {
+    if (snapshot < segment) {
+      FileUtils::unlink(snapshot_path(snapshot));
+      HT_INFOF("Deleted Hyperspace snapshot %s",
+               snapshot_path(snapshot).c_str());
+    }
+  }
+
+  // Keep the last m_max_unused_logs segments preceding the snapshot
+  list_numbered_files(m_log_dir, "log.", segments);
+  size_t unused = count_if(segments.begin(), segments.end(),
+                           [segment](uint32_t n) { return n < segment; });
+  for (auto n : segments) {
+    if (unused <= m_max_unused_logs || n >= segment)
+      break;
+    FileUtils::unlink(segment_path(n));
+    HT_INFOF("Deleted unused Hyperspace log %s", segment_path(n).c_str());
+    unused--;
+  }
+}
+
+String LogStructuredFilesystem::segment_path(uint32_t segment) {
+  return format("%s/log.%u", m_log_dir.c_str(), (unsigned)segment);
+}
+
+String LogStructuredFilesystem::snapshot_path(uint32_t segment) {
+  return format("%s/snapshot.%u", m_log_dir.c_str(), (unsigned)segment);
+}
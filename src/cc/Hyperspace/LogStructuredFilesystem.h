@@ -0,0 +1,595 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Declarations for LogStructuredFilesystem.
+ * This file contains declarations for LogStructuredFilesystem, a class that
+ * implements the Hyperspace filesystem as an in-memory tree backed by an
+ * append-only write-ahead log with group commit and periodic snapshots.
+ */
+
+#ifndef Hyperspace_LogStructuredFilesystem_h
+#define Hyperspace_LogStructuredFilesystem_h
+
+#include <Hyperspace/StateStore.h>
+
+#include <Common/DynamicBuffer.h>
+#include <Common/Properties.h>
+#include <Common/String.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Hyperspace {
+
+  using namespace Hypertable;
+
+  /** @addtogroup Hyperspace
+   * @{
+   */
+
+  /** Hyperspace filesystem implementation on top of a write-ahead log.
+   * All state is held in memory.  The namespace is kept in an ordered map
+   * with the same key layout as the BerkeleyDB namespace database
+   * (directories end with '/' and attributes are stored under the node name
+   * followed by StateStore::NODE_ATTR_DELIM and the attribute name), and the
+   * session, handle, node, and event state is kept in hash maps of
+   * structures.
+   *
+   * Transactions are isolated with strict two-phase locking.  The namespace
+   * is covered by a single shared/exclusive lock and every session, handle,
+   * node, event, and identifier counter has a lock of its own, so
+   * transactions on unrelated objects proceed concurrently as they do with
+   * BerkeleyDB.  A lock request that cannot be granted within one second is
+   * treated as a deadlock and fails with Error::HYPERSPACE_STATEDB_DEADLOCK,
+   * upon which the caller aborts and retries the transaction.  Modified
+   * objects are updated in place and their prior images are saved in the
+   * transaction so that abort() can restore them.
+   *
+   * Only the namespace is persistent.  On commit, the new images of the
+   * modified namespace entries are appended as one checksummed frame to the
+   * log buffer and the transaction's locks are released before the log is
+   * synced.  Syncs are grouped: the first committer to find the log idle
+   * writes and syncs everything appended so far while later committers wait
+   * for it, so a single <code>fdatasync</code> makes many transactions
+   * durable.  A transaction that read the namespace also waits until the
+   * namespace changes it may have observed are durable.  Session, handle,
+   * node, and event state is not logged, since it is discarded on restart
+   * just as the BerkeleyDB state database is.
+   *
+   * The log is a sequence of segment files named <code>log.N</code> in the
+   * <code>logstore</code> subdirectory of the base directory.  When
+   * do_checkpoint() finds that the current segment has grown past
+   * <code>Hyperspace.Checkpoint.Size</code>, it starts a new segment and
+   * writes a snapshot of the namespace as of the start of that segment to
+   * <code>snapshot.N</code>.  Segments older than the latest snapshot are
+   * retained until <code>Hyperspace.LogGc.MaxUnusedLogs</code> of them have
+   * accumulated.  Recovery loads the latest snapshot and replays the
+   * segments that follow it.  Closed segments and snapshots are immutable
+   * and self-contained, which makes them the unit of shipping to replicas;
+   * replication itself is not implemented, so this store only supports
+   * single-replica deployments.
+   */
+  class LogStructuredFilesystem : public StateStore {
+
+    /// Session state
+    struct Session {
+      String addr;
+      bool expired {};
+      String name;
+      std::vector<uint64_t> handles;
+    };
+
+    /// Handle state
+    struct Handle {
+      String node_name;
+      uint32_t open_flags {};
+      uint32_t event_mask {};
+      uint32_t del_state {};
+      uint64_t session_id {};
+      bool locked {};
+    };
+
+    /// Node state
+    struct Node {
+      bool ephemeral {};
+      uint32_t lock_mode {};
+      uint64_t lock_generation {};
+      uint64_t exclusive_handle {};
+      std::vector<uint64_t> handles;
+      std::vector<uint64_t> shared_lock_handles;
+      std::vector<LockRequest> pending_lock_requests;
+    };
+
+    /// Event state
+    struct EventState {
+      uint32_t type {};
+      uint32_t mask {};
+      String name;
+      uint32_t mode {};
+      uint64_t generation {};
+      bool has_notification_handles {};
+      std::vector<uint64_t> notification_handles;
+    };
+
+    /// Object lock held by one or more transactions
+    struct ObjectLock {
+      /// ID of transaction holding the lock exclusively, or zero
+      uint64_t exclusive_owner {};
+      /// IDs of transactions holding the lock shared
+      std::vector<uint64_t> shared_owners;
+    };
+
+    /// Lock modes
+    enum LockMode {
+      LOCK_SHARED = 1,
+      LOCK_EXCLUSIVE
+    };
+
+    typedef std::map<String, String> NamespaceMap;
+    typedef std::unordered_map<uint64_t, Session> SessionMap;
+    typedef std::unordered_map<uint64_t, Handle> HandleMap;
+    typedef std::unordered_map<String, Node> NodeMap;
+    typedef std::unordered_map<uint64_t, EventState> EventMap;
+
+    /// Prior images of objects modified by a transaction, keyed by object
+    /// key; the flag is <i>false</i> if the object did not exist
+    template <typename MapT>
+    using UndoMap = std::map<typename MapT::key_type,
+                             std::pair<bool, typename MapT::mapped_type>>;
+
+  public:
+
+    /** Transaction on a LogStructuredFilesystem. */
+    class Txn : public StateTxn {
+    public:
+
+      /** Constructor.
+       * @param fs Filesystem
+       * @param id Transaction ID
+       */
+      Txn(LogStructuredFilesystem *fs, uint64_t id) : m_fs(fs), m_id(id) { }
+
+      /** Destructor.  Aborts the transaction if it is still active. */
+      virtual ~Txn();
+
+      void commit(int flag=0) override;
+      void abort() override;
+      void display(std::ostream &out) const override;
+
+    private:
+      friend class LogStructuredFilesystem;
+
+      /// Filesystem
+      LogStructuredFilesystem *m_fs;
+
+      /// Transaction ID
+      uint64_t m_id;
+
+      /// Flag indicating transaction has been committed or aborted
+      bool m_finished {};
+
+      /// Flag indicating transaction has read or modified the namespace
+      bool m_namespace_accessed {};
+
+      /// Locks held, keyed by lock name
+      std::unordered_map<String, LockMode> m_locks;
+
+      /// Prior images of namespace entries
+      UndoMap<NamespaceMap> m_namespace_undo;
+
+      /// Prior images of sessions
+      UndoMap<SessionMap> m_session_undo;
+
+      /// Prior images of handles
+      UndoMap<HandleMap> m_handle_undo;
+
+      /// Prior images of nodes
+      UndoMap<NodeMap> m_node_undo;
+
+      /// Prior images of events
+      UndoMap<EventMap> m_event_undo;
+
+      /// Prior values of next identifiers, keyed by IdentifierType
+      std::map<int, uint64_t> m_next_id_undo;
+    };
+
+    /** Constructor.
+     * Recovers the namespace from the latest snapshot and the log segments
+     * that follow it and opens a new log segment.
+     * @param props Configuration properties
+     * @param basedir Base directory; the log and snapshots are stored in its
+     * <code>logstore</code> subdirectory
+     */
+    LogStructuredFilesystem(PropertiesPtr &props, const String &basedir);
+
+    /** Destructor.  Syncs and closes the log. */
+    virtual ~LogStructuredFilesystem();
+
+    /** Writes a snapshot and starts a new log segment if the current segment
+     * exceeds the checkpoint size, and removes unused segments.
+     */
+    void do_checkpoint() override;
+
+    bool is_master() override { return true; }
+
+    String get_current_master() override { return String(); }
+
+    StateTxnPtr start_transaction() override;
+
+    bool get_xattr_i32(StateTxn &txn, const String &fname,
+                       const String &aname, uint32_t *valuep) override;
+    void set_xattr_i32(StateTxn &txn, const String &fname,
+                       const String &aname, uint32_t value) override;
+    bool get_xattr_i64(StateTxn &txn, const String &fname,
+                       const String &aname, uint64_t *valuep) override;
+    void set_xattr_i64(StateTxn &txn, const String &fname,
+                       const String &aname, uint64_t value) override;
+    void set_xattr(StateTxn &txn, const String &fname, const String &aname,
+                   const void *value, size_t value_len) override;
+    bool get_xattr(StateTxn &txn, const String &fname, const String &aname,
+                   DynamicBuffer &vbuf) override;
+    bool incr_attr(StateTxn &txn, const String &fname, const String &aname,
+                   uint64_t *valuep) override;
+    bool exists_xattr(StateTxn &txn, const String &fname,
+                      const String &aname) override;
+    void del_xattr(StateTxn &txn, const String &fname,
+                   const String &aname) override;
+    void mkdir(StateTxn &txn, const String &name) override;
+    void unlink(StateTxn &txn, const String &name) override;
+    bool exists(StateTxn &txn, String fname, bool *is_dir_p=0) override;
+    void create(StateTxn &txn, const String &fname, bool temp) override;
+    void get_directory_listing(StateTxn &txn, String fname,
+                               std::vector<DirEntry> &listing) override;
+    void get_directory_attr_listing(StateTxn &txn, String fname,
+                                    const String &aname,
+                                    bool include_sub_entries,
+                                    std::vector<DirEntryAttr> &listing) override;
+    void get_directory_attr_listing(StateTxn &txn, String fname,
+                                    const String &aname,
+                                    std::vector<DirEntryAttr> &listing) override;
+    void get_all_names(StateTxn &txn, std::vector<String> &names) override;
+    bool list_xattr(StateTxn &txn, const String& fname,
+                    std::vector<String> &anames) override;
+
+    void create_event(StateTxn &txn, uint32_t type, uint64_t id,
+                      uint32_t mask) override;
+    void create_event(StateTxn &txn, uint32_t type, uint64_t id,
+                      uint32_t mask, const String &name) override;
+    void create_event(StateTxn &txn, uint32_t type, uint64_t id,
+                      uint32_t mask, uint32_t mode) override;
+    void create_event(StateTxn &txn, uint32_t type, uint64_t id,
+                      uint32_t mask, uint32_t mode,
+                      uint64_t generation) override;
+    void delete_event(StateTxn &txn, uint64_t id) override;
+    void set_event_notification_handles(StateTxn &txn, uint64_t id,
+                                        const std::vector<uint64_t> &handles) override;
+    bool event_exists(StateTxn &txn, uint64_t id) override;
+
+    void create_session(StateTxn &txn, uint64_t id,
+                        const String &addr) override;
+    void delete_session(StateTxn &txn, uint64_t id) override;
+    void expire_session(StateTxn &txn, uint64_t id) override;
+    void add_session_handle(StateTxn &txn, uint64_t id,
+                            uint64_t handle_id) override;
+    void get_session_handles(StateTxn &txn, uint64_t id,
+                             std::vector<uint64_t> &handles) override;
+    bool delete_session_handle(StateTxn &txn, uint64_t id,
+                               uint64_t handle_id) override;
+    bool session_exists(StateTxn &txn, uint64_t id) override;
+    String get_session_name(StateTxn &txn, uint64_t id) override;
+    void set_session_name(StateTxn &txn, uint64_t id,
+                          const String &name) override;
+
+    void create_handle(StateTxn &txn, uint64_t id, String node_name,
+                       uint32_t open_flags, uint32_t event_mask,
+                       uint64_t session_id, bool locked,
+                       uint32_t del_state) override;
+    void delete_handle(StateTxn &txn, uint64_t id) override;
+    uint32_t get_handle_open_flags(StateTxn &txn, uint64_t id) override;
+    void set_handle_del_state(StateTxn &txn, uint64_t id,
+                              uint32_t del_state) override;
+    uint32_t get_handle_del_state(StateTxn &txn, uint64_t id) override;
+    void set_handle_open_flags(StateTxn &txn, uint64_t id,
+                               uint32_t open_flags) override;
+    void set_handle_event_mask(StateTxn &txn, uint64_t id,
+                               uint32_t event_mask) override;
+    uint32_t get_handle_event_mask(StateTxn &txn, uint64_t id) override;
+    void get_handle_node(StateTxn &txn, uint64_t id,
+                         String &node_name) override;
+    uint64_t get_handle_session(StateTxn &txn, uint64_t id) override;
+    void set_handle_locked(StateTxn &txn, uint64_t id, bool locked) override;
+    bool handle_is_locked(StateTxn &txn, uint64_t id) override;
+    bool handle_exists(StateTxn &txn, uint64_t id) override;
+
+    void create_node(StateTxn &txn, const String &name, bool ephemeral=false,
+                     uint64_t lock_generation=0, uint32_t cur_lock_mode=0,
+                     uint64_t exclusive_handle=0) override;
+    void set_node_lock_generation(StateTxn &txn, const String &name,
+                                  uint64_t lock_generation) override;
+    uint64_t incr_node_lock_generation(StateTxn &txn,
+                                       const String &name) override;
+    void set_node_ephemeral(StateTxn &txn, const String &name,
+                            bool ephemeral) override;
+    bool node_is_ephemeral(StateTxn &txn, const String &name) override;
+    void set_node_cur_lock_mode(StateTxn &txn, const String &name,
+                                uint32_t lock_mode) override;
+    uint32_t get_node_cur_lock_mode(StateTxn &txn,
+                                    const String &name) override;
+    void set_node_exclusive_lock_handle(StateTxn &txn, const String &name,
+                                        uint64_t exclusive_lock_handle) override;
+    uint64_t get_node_exclusive_lock_handle(StateTxn &txn,
+                                            const String &name) override;
+    void add_node_handle(StateTxn &txn, const String &name,
+                         uint64_t handle) override;
+    void delete_node_handle(StateTxn &txn, const String &name,
+                            uint64_t handle) override;
+    bool node_has_open_handles(StateTxn &txn, const String &name) override;
+    bool node_has_pending_lock_request(StateTxn &txn,
+                                       const String &name) override;
+    bool get_node_pending_lock_request(StateTxn &txn, const String &name,
+                                       LockRequest &front_req) override;
+    void add_node_pending_lock_request(StateTxn &txn, const String &name,
+                                       LockRequest &request) override;
+    void delete_node_pending_lock_request(StateTxn &txn, const String &name,
+                                          uint64_t handle) override;
+    void add_node_shared_lock_handle(StateTxn &txn, const String &name,
+                                     uint64_t handle) override;
+    bool get_node_event_notification_map(StateTxn &txn, const String &name,
+                                         uint32_t event_mask,
+                                         NotificationMap &handles_to_sessions) override;
+    void get_node_handles(StateTxn &txn, const String &name,
+                          std::vector<uint64_t> &handles) override;
+    void delete_node_shared_lock_handle(StateTxn &txn, const String &name,
+                                        uint64_t handle_id) override;
+    bool delete_node(StateTxn &txn, const String &name) override;
+    bool node_exists(StateTxn &txn, const String &name) override;
+    bool node_has_shared_lock_handles(StateTxn &txn,
+                                      const String &name) override;
+
+    uint64_t get_next_id_i64(StateTxn &txn, IdentifierType id_type,
+                             bool increment = false) override;
+
+  private:
+
+    /// Casts a StateTxn to a Txn of this filesystem.
+    Txn &cast(StateTxn &txn);
+
+    /** Acquires a lock for a transaction.
+     * Waits for conflicting locks held by other transactions to be released.
+     * @param txn Transaction
+     * @param name Lock name
+     * @param mode Lock mode
+     * @param lock Lock on #m_mutex, released while waiting
+     * @throws Exception with code Error::HYPERSPACE_STATEDB_DEADLOCK if the
+     * lock could not be acquired within #m_lock_timeout
+     */
+    void acquire(Txn &txn, const String &name, LockMode mode,
+                 std::unique_lock<std::mutex> &lock);
+
+    /// Acquires the namespace lock.
+    void lock_namespace(Txn &txn, LockMode mode,
+                        std::unique_lock<std::mutex> &lock);
+
+    /// Acquires the lock on session <code>id</code>.
+    void lock_session(Txn &txn, uint64_t id, LockMode mode,
+                      std::unique_lock<std::mutex> &lock);
+
+    /// Acquires the lock on handle <code>id</code>.
+    void lock_handle(Txn &txn, uint64_t id, LockMode mode,
+                     std::unique_lock<std::mutex> &lock);
+
+    /// Acquires the lock on node <code>name</code>.
+    void lock_node(Txn &txn, const String &name, LockMode mode,
+                   std::unique_lock<std::mutex> &lock);
+
+    /// Acquires the lock on event <code>id</code>.
+    void lock_event(Txn &txn, uint64_t id, LockMode mode,
+                    std::unique_lock<std::mutex> &lock);
+
+    /// Releases all locks held by <code>txn</code>.
+    void release_locks(Txn &txn);
+
+    /// Sets namespace entry <code>key</code> to <code>value</code>.
+    void put_namespace(Txn &txn, const String &key, const String &value);
+
+    /// Removes namespace entry <code>key</code>.
+    void del_namespace(Txn &txn, const String &key);
+
+    /// Builds the namespace key of attribute <code>aname</code> of node
+    /// <code>fname</code>.
+    /// @throws Exception with code Error::HYPERSPACE_FILE_NOT_FOUND if the
+    /// node does not exist
+    String attr_key(const String &fname, const String &aname);
+
+    /// Checks if namespace node <code>fname</code> exists.
+    bool name_exists(String fname, bool *is_dir_p);
+
+    /// Lists the entries of directory <code>fname</code> along with
+    /// attribute <code>aname</code>.
+    void attr_listing(String fname, const String &aname,
+                      bool include_sub_entries,
+                      std::vector<DirEntryAttr> &listing);
+
+    /// Saves the prior image of session <code>id</code> and returns it.
+    Session &save_session(Txn &txn, uint64_t id);
+
+    /// Saves the prior image of handle <code>id</code> and returns it.
+    Handle &save_handle(Txn &txn, uint64_t id);
+
+    /// Saves the prior image of node <code>name</code> and returns it.
+    Node &save_node(Txn &txn, const String &name);
+
+    /// Saves the prior image of event <code>id</code> and returns it.
+    EventState &save_event(Txn &txn, uint64_t id);
+
+    /// Looks up a session that must exist.
+    Session &get_session(uint64_t id);
+
+    /// Looks up a handle that must exist.
+    Handle &get_handle(uint64_t id);
+
+    /// Looks up a node that must exist.
+    Node &get_node(const String &name);
+
+    /// Commits <code>txn</code>.
+    void commit(Txn &txn);
+
+    /// Aborts <code>txn</code>, restoring the prior images it saved.
+    void abort(Txn &txn);
+
+    /// Appends a frame holding <code>payload</code> to the log buffer and
+    /// returns its sequence number.
+    uint64_t append_frame(DynamicBuffer &payload);
+
+    /// Waits until the frame with sequence number <code>seq</code> has been
+    /// written and synced, writing and syncing the log buffer if no other
+    /// thread is doing so.
+    void sync(uint64_t seq);
+
+    /// Writes and syncs the log buffer.  Called with #m_log_mutex held by
+    /// <code>lock</code>, which is released while writing.
+    void flush(std::unique_lock<std::mutex> &lock);
+
+    /// Encodes namespace entry <code>key</code> as a log record.
+    void encode_record(DynamicBuffer &buf, const String &key,
+                       const String *value);
+
+    /// Applies the log records in <code>buf</code> to the namespace.
+    void apply_records(const uint8_t *buf, size_t len);
+
+    /// Recovers the namespace from the snapshot and log segments.
+    void recover();
+
+    /// Reads the frames of a file, calling apply_records() for each.
+    /// @return <i>false</i> if the file ends with a truncated or corrupt
+    /// frame
+    bool replay_file(const String &path);
+
+    /// Opens log segment <code>segment</code> for appending.
+    void open_segment(uint32_t segment);
+
+    /// Starts log segment <code>segment</code>, writing and syncing the log
+    /// buffer to the current segment first.
+    void roll_segment(uint32_t segment);
+
+    /// Writes snapshot <code>segment</code> holding <code>state</code>.
+    void write_snapshot(uint32_t segment, DynamicBuffer &state);
+
+    /// Removes snapshots and segments made obsolete by snapshot
+    /// <code>segment</code>.
+    void remove_obsolete_files(uint32_t segment);
+
+    /// Returns the path of log segment <code>segment</code>.
+    String segment_path(uint32_t segment);
+
+    /// Returns the path of snapshot <code>segment</code>.
+    String snapshot_path(uint32_t segment);
+
+    /// Directory holding log segments and snapshots
+    String m_log_dir;
+
+    /// %Mutex protecting the in-memory state and lock table
+    std::mutex m_mutex;
+
+    /// Condition signaled when locks are released
+    std::condition_variable m_lock_cond;
+
+    /// Object locks keyed by lock name
+    std::unordered_map<String, ObjectLock> m_locks;
+
+    /// Time to wait for a lock before reporting a deadlock
+    std::chrono::milliseconds m_lock_timeout {1000};
+
+    /// Namespace entries
+    NamespaceMap m_namespace;
+
+    /// Sessions
+    SessionMap m_sessions;
+
+    /// Handles
+    HandleMap m_handles;
+
+    /// Nodes
+    NodeMap m_nodes;
+
+    /// Events
+    EventMap m_events;
+
+    /// Next identifiers indexed by IdentifierType
+    uint64_t m_next_id[3];
+
+    /// Next transaction ID
+    uint64_t m_next_txn_id {1};
+
+    /// Sequence number of the frame holding the latest namespace change
+    uint64_t m_namespace_seq {};
+
+    /// %Mutex protecting the log buffer and file
+    std::mutex m_log_mutex;
+
+    /// Condition signaled when a sync completes
+    std::condition_variable m_log_cond;
+
+    /// Frames appended but not yet written
+    DynamicBuffer m_log_buffer;
+
+    /// Sequence number of the last appended frame
+    uint64_t m_appended_seq {};
+
+    /// Sequence number of the last synced frame
+    uint64_t m_synced_seq {};
+
+    /// Flag indicating a thread is writing the log buffer
+    bool m_flushing {};
+
+    /// File descriptor of the current log segment
+    int m_fd {-1};
+
+    /// Current log segment number
+    uint32_t m_segment {};
+
+    /// Bytes written to the current log segment
+    uint64_t m_segment_size {};
+
+    /// Segment size beyond which do_checkpoint() writes a snapshot
+    uint64_t m_checkpoint_size;
+
+    /// Number of unused log segments to keep
+    uint32_t m_max_unused_logs;
+
+    /// Interval between removals of unused log segments
+    std::chrono::steady_clock::duration m_log_gc_interval;
+
+    /// Time of the last removal of unused log segments
+    std::chrono::steady_clock::time_point m_last_log_gc_time;
+  };
+
+  /** @} */
+
+} // namespace Hyperspace
+
+#endif // Hyperspace_LogStructuredFilesystem_h
@@ -21,8 +21,10 @@
 
 #include <Common/Compat.h>
 
+#include "BerkeleyDbFilesystem.h"
 #include "Config.h"
 #include "Event.h"
+#include "LogStructuredFilesystem.h"
 #include "Notification.h"
 #include "Master.h"
 #include "Session.h"
@@ -65,17 +67,18 @@ using namespace std;
 
 #define HT_BDBTXN_BEGIN(parent_txn) \
   do { \
-    BDbTxn txn;\
-    std::stringstream txn_str;\
     HT_ASSERT(is_master());\
-    m_bdb_fs->start_transaction(txn); \
+    StateTxnPtr txn_ptr = m_fs->start_transaction(); \
+    StateTxn &txn = *txn_ptr; \
+    std::stringstream txn_str;\
     try
 
 #define HT_BDBTXN_END_CB(_cb_) \
     catch (Exception &e) { \
-      if (e.code() == Error::HYPERSPACE_BERKELEYDB_DEADLOCK) { \
+      if (e.code() == Error::HYPERSPACE_BERKELEYDB_DEADLOCK || \
+          e.code() == Error::HYPERSPACE_STATEDB_DEADLOCK) { \
         txn_str << txn; \
-        HT_INFOF("Berkeley DB deadlock encountered in txn %s", txn_str.str().c_str()); \
+        HT_INFOF("Deadlock encountered in txn %s", txn_str.str().c_str()); \
         txn.abort(); \
         this_thread::sleep_for(Random::duration_millis(3000)); \
         continue; \
@@ -100,9 +103,10 @@ using namespace std;
 
 #define HT_BDBTXN_END(...) \
     catch (Exception &e) { \
-      if (e.code() == Error::HYPERSPACE_BERKELEYDB_DEADLOCK) {\
+      if (e.code() == Error::HYPERSPACE_BERKELEYDB_DEADLOCK || \
+          e.code() == Error::HYPERSPACE_STATEDB_DEADLOCK) {\
         txn_str << txn; \
-        HT_INFOF("Berkeley DB deadlock encountered in txn %s", txn_str.str().c_str()); \
+        HT_INFOF("Deadlock encountered in txn %s", txn_str.str().c_str()); \
         txn.abort(); \
         this_thread::sleep_for(Random::duration_millis(3000)); \
         continue; \
@@ -135,7 +139,7 @@ Hyperspace::Master::Master(ConnectionManagerPtr &conn_mgr, PropertiesPtr &props,
                ApplicationQueuePtr &app_queue_ptr)
   : m_verbose(false), m_next_handle_number(1), m_next_session_id(1),
     m_maintenance_outstanding(false),
-    m_shutdown(false), m_bdb_fs(0) {
+    m_shutdown(false), m_fs(0) {
 
   m_verbose = props->get_bool("verbose");
   m_lease_interval = props->get_i32("Hyperspace.Lease.Interval");
@@ -224,8 +228,19 @@ Hyperspace::Master::Master(ConnectionManagerPtr &conn_mgr, PropertiesPtr &props,
   thread_ids.push_back(ThisThread::get_id());
 
 
-  m_bdb_fs = new BerkeleyDbFilesystem(props, m_base_dir, thread_ids);
-  Event::set_bdb_fs(m_bdb_fs);
+  String state_store = props->get_str("Hyperspace.StateStore");
+  if (state_store == "log") {
+    if (props->has("Hyperspace.Replica.Host") &&
+        props->get_strs("Hyperspace.Replica.Host").size() > 1)
+      HT_FATAL("Hyperspace.StateStore=log does not support replication");
+    m_fs = new LogStructuredFilesystem(props, m_base_dir);
+  }
+  else if (state_store == "berkeleydb")
+    m_fs = new BerkeleyDbFilesystem(props, m_base_dir, thread_ids);
+  else
+    HT_FATALF("Unrecognized Hyperspace.StateStore value '%s'",
+              state_store.c_str());
+  Event::set_fs(m_fs);
 
   /*
    * Load and increment generation number
@@ -249,7 +264,7 @@ Hyperspace::Master::Master(ConnectionManagerPtr &conn_mgr, PropertiesPtr &props,
 
 Hyperspace::Master::~Master() {
   m_metrics_handler->stop_collecting();
-  delete m_bdb_fs;
+  delete m_fs;
   ::close(m_lock_fd);
 }
 
@@ -270,8 +285,8 @@ uint64_t Hyperspace::Master::create_session(struct sockaddr_in &addr) {
 
   HT_BDBTXN_BEGIN() {
     // DB updates
-    session_id = m_bdb_fs->get_next_id_i64(txn, SESSION, true);
-    m_bdb_fs->create_session(txn, session_id, addr_str);
+    session_id = m_fs->get_next_id_i64(txn, SESSION, true);
+    m_fs->create_session(txn, session_id, addr_str);
     // in mem updates
     session_data = make_shared<SessionData>(addr, m_lease_interval, session_id);
     m_session_map[session_id] = session_data;
@@ -334,7 +349,7 @@ void Hyperspace::Master::initialize_session(uint64_t session_id, const String &n
 
   // set session name in BDB and mem
   HT_BDBTXN_BEGIN() {
-    m_bdb_fs->set_session_name(txn, session_id, name);
+    m_fs->set_session_name(txn, session_id, name);
     txn.commit();
     session_data->set_name(name);
   }
@@ -367,7 +382,7 @@ int Hyperspace::Master::renew_session_lease(uint64_t session_id) {
   if (!renewed) {
     // if renew failed then delete from BDB
     HT_BDBTXN_BEGIN() {
-      m_bdb_fs->expire_session(txn, session_id);
+      m_fs->expire_session(txn, session_id);
       txn.commit();
       commited = true;
     }
@@ -438,8 +453,8 @@ void Hyperspace::Master::remove_expired_sessions() {
     commited = false;
     // expire session_data in mem and in BDB
     HT_BDBTXN_BEGIN() {
-      m_bdb_fs->get_session_handles(txn, session_data->get_id(), handles);
-      m_bdb_fs->expire_session(txn, session_data->get_id());
+      m_fs->get_session_handles(txn, session_data->get_id(), handles);
+      m_fs->expire_session(txn, session_data->get_id());
       txn.commit();
       commited = true;
       expired_sessions.push_back(session_data->get_id());
@@ -463,7 +478,7 @@ void Hyperspace::Master::remove_expired_sessions() {
   if (expired_sessions.size() > 0) {
     HT_BDBTXN_BEGIN() {
       for (auto expired_session : expired_sessions) {
-        m_bdb_fs->delete_session(txn, expired_session);
+        m_fs->delete_session(txn, expired_session);
       }
       txn.commit();
     }
@@ -729,16 +744,16 @@ void Hyperspace::Master::close(CommandContext &ctx, uint64_t handle)
              ctx.session_data->get_name(), (Llu)handle);
 
   HT_ASSERT(ctx.txn);
-  BDbTxn &txn = *ctx.txn;
+  StateTxn &txn = *ctx.txn;
 
-  if (!m_bdb_fs->session_exists(txn, ctx.session_id)) {
+  if (!m_fs->session_exists(txn, ctx.session_id)) {
     ctx.set_error(Error::HYPERSPACE_EXPIRED_SESSION,
                   format("Session %llu (%s) does not exist",
                          (Llu)ctx.session_id, ctx.session_data->get_name()));
     return;
   }
 
-  m_bdb_fs->delete_session_handle(txn, ctx.session_id, handle);
+  m_fs->delete_session_handle(txn, ctx.session_id, handle);
 }
 
 /*
@@ -884,15 +899,19 @@ Hyperspace::Master::attr_incr(ResponseCallbackAttrIncr *cb, uint64_t session_id,
                  uint64_t handle, const char *name, const char* attr) {
 
   uint64_t attr_val;
+  bool commited = false;
   m_metrics_handler->request_increment();
   CommandContext ctx("attrincr", session_id);
   HT_BDBTXN_BEGIN() {
+    commited = false;
     ctx.reset(&txn);
     attr_incr(ctx, handle, name, attr, attr_val);
     if (ctx.aborted)
       txn.abort();
-    else
+    else {
       txn.commit();
+      commited = true;
+    }
   }
   HT_BDBTXN_END_CB(cb);
 
@@ -902,6 +921,10 @@ Hyperspace::Master::attr_incr(ResponseCallbackAttrIncr *cb, uint64_t session_id,
     return;
   }
 
+  // deliver notifications
+  if (commited)
+    deliver_event_notifications(ctx);
+
   if ((ctx.error = cb->response(attr_val)) != Error::OK)
     HT_ERRORF("Problem sending back response - %s", Error::get_text(ctx.error));
 }
@@ -1232,19 +1255,19 @@ Hyperspace::Master::lock(ResponseCallbackLock *cb, uint64_t session_id, uint64_t
     lock_status=0;
 
     // make sure session is still valid
-    if (!m_bdb_fs->session_exists(txn, session_id)) {
+    if (!m_fs->session_exists(txn, session_id)) {
       error = Error::HYPERSPACE_EXPIRED_SESSION;
       error_msg = format("session: %lld", (Lld)session_id);
       aborted = true;
       goto txn_commit;
     }
 
-    if (!m_bdb_fs->handle_exists(txn, handle)) {
+    if (!m_fs->handle_exists(txn, handle)) {
       aborted = true;
       goto txn_commit;
     }
 
-    open_flags = m_bdb_fs->get_handle_open_flags(txn, handle);
+    open_flags = m_fs->get_handle_open_flags(txn, handle);
     if (!(open_flags & OPEN_FLAG_LOCK)) {
       error = Error::HYPERSPACE_MODE_RESTRICTION;
       error_msg = "handle not open for locking";
@@ -1259,15 +1282,15 @@ Hyperspace::Master::lock(ResponseCallbackLock *cb, uint64_t session_id, uint64_t
       goto txn_commit;
     }
 
-    m_bdb_fs->get_handle_node(txn, handle, node);
-    cur_lock_mode = m_bdb_fs->get_node_cur_lock_mode(txn, node);
+    m_fs->get_handle_node(txn, handle, node);
+    cur_lock_mode = m_fs->get_node_cur_lock_mode(txn, node);
     if (cur_lock_mode == LOCK_MODE_EXCLUSIVE) {
       if (try_lock)
         lock_status = LOCK_STATUS_BUSY;
       else {
         // don't abort transaction since we need to persist pending lock req
         LockRequest lock_request(handle, mode);
-        m_bdb_fs->add_node_pending_lock_request(txn, node, lock_request);
+        m_fs->add_node_pending_lock_request(txn, node, lock_request);
         lock_status = LOCK_STATUS_PENDING;
       }
       goto txn_commit;
@@ -1279,7 +1302,7 @@ Hyperspace::Master::lock(ResponseCallbackLock *cb, uint64_t session_id, uint64_t
         else {
           // don't abort transaction since we need to persist pending lock req
           LockRequest lock_request(handle, mode);
-          m_bdb_fs->add_node_pending_lock_request(txn, node, lock_request);
+          m_fs->add_node_pending_lock_request(txn, node, lock_request);
           lock_status = LOCK_STATUS_PENDING;
         }
         goto txn_commit;
@@ -1287,13 +1310,13 @@ Hyperspace::Master::lock(ResponseCallbackLock *cb, uint64_t session_id, uint64_t
 
       HT_ASSERT(mode == LOCK_MODE_SHARED);
 
-      if (m_bdb_fs->node_has_pending_lock_request(txn, node)) {
+      if (m_fs->node_has_pending_lock_request(txn, node)) {
         if (try_lock)
           lock_status = LOCK_STATUS_BUSY;
         else {
           // don't abort transaction since we need to persist pending lock req
           LockRequest lock_request(handle, mode);
-          m_bdb_fs->add_node_pending_lock_request(txn, node, lock_request);
+          m_fs->add_node_pending_lock_request(txn, node, lock_request);
           lock_status = LOCK_STATUS_PENDING;
         }
         goto txn_commit;
@@ -1301,23 +1324,23 @@ Hyperspace::Master::lock(ResponseCallbackLock *cb, uint64_t session_id, uint64_t
     }
 
     // at this point we're OK to acquire the lock
-    if (mode == LOCK_MODE_SHARED && m_bdb_fs->node_has_shared_lock_handles(txn, node))
+    if (mode == LOCK_MODE_SHARED && m_fs->node_has_shared_lock_handles(txn, node))
       notify = false;
 
     lock_status = LOCK_STATUS_GRANTED;
-    lock_generation = m_bdb_fs->incr_node_lock_generation(txn, node);
+    lock_generation = m_fs->incr_node_lock_generation(txn, node);
 
-    m_bdb_fs->set_xattr_i64(txn, node, "lock.generation", lock_generation);
-    m_bdb_fs->set_node_cur_lock_mode(txn, node, mode);
+    m_fs->set_xattr_i64(txn, node, "lock.generation", lock_generation);
+    m_fs->set_node_cur_lock_mode(txn, node, mode);
     lock_handle(txn, handle, mode, node);
 
     // create lock acquired event & persist event notifications
     if (notify) {
-      event_id = m_bdb_fs->get_next_id_i64(txn, EVENT, true);
-      m_bdb_fs->create_event(txn, EVENT_TYPE_LOCK_ACQUIRED, event_id, EVENT_MASK_LOCK_ACQUIRED,
+      event_id = m_fs->get_next_id_i64(txn, EVENT, true);
+      m_fs->create_event(txn, EVENT_TYPE_LOCK_ACQUIRED, event_id, EVENT_MASK_LOCK_ACQUIRED,
                              mode);
       lock_acquired_event = make_shared<EventLockAcquired>(event_id, mode);
-      if (m_bdb_fs->get_node_event_notification_map(txn, node, EVENT_MASK_LOCK_ACQUIRED,
+      if (m_fs->get_node_event_notification_map(txn, node, EVENT_MASK_LOCK_ACQUIRED,
                                                     lock_acquired_notifications)) {
         persist_event_notifications(txn, event_id, lock_acquired_notifications);
         persisted_notifications = true;
@@ -1376,18 +1399,18 @@ Hyperspace::Master::lock(ResponseCallbackLock *cb, uint64_t session_id, uint64_t
  * > Set exclusive handle to acquiring handle or add acquiring handle to set of shared handles
  * > Set handle data to locked
  */
-void Hyperspace::Master::lock_handle(BDbTxn &txn, uint64_t handle, uint32_t mode, String& node) {
+void Hyperspace::Master::lock_handle(StateTxn &txn, uint64_t handle, uint32_t mode, String& node) {
 
   if (node == "")
-    m_bdb_fs->get_handle_node(txn, handle, node);
+    m_fs->get_handle_node(txn, handle, node);
 
   if (mode == LOCK_MODE_SHARED)
-    m_bdb_fs->add_node_shared_lock_handle(txn, node, handle);
+    m_fs->add_node_shared_lock_handle(txn, node, handle);
   else {
     HT_ASSERT(mode == LOCK_MODE_EXCLUSIVE);
-    m_bdb_fs->set_node_exclusive_lock_handle(txn, node, handle);
+    m_fs->set_node_exclusive_lock_handle(txn, node, handle);
   }
-  m_bdb_fs->set_handle_locked(txn, handle, true);
+  m_fs->set_handle_locked(txn, handle, true);
 }
 
 /*
@@ -1396,16 +1419,16 @@ void Hyperspace::Master::lock_handle(BDbTxn &txn, uint64_t handle, uint32_t mode
  * > Set exclusive handle to acquiring handle or add acquiring handle to set of shared handles
  * > Set handle data to locked
  */
-void Hyperspace::Master::lock_handle(BDbTxn &txn, uint64_t handle, uint32_t mode, const String& node) {
+void Hyperspace::Master::lock_handle(StateTxn &txn, uint64_t handle, uint32_t mode, const String& node) {
 
   HT_ASSERT(node != "");
   if (mode == LOCK_MODE_SHARED)
-    m_bdb_fs->add_node_shared_lock_handle(txn, node, handle);
+    m_fs->add_node_shared_lock_handle(txn, node, handle);
   else {
     HT_ASSERT(mode == LOCK_MODE_EXCLUSIVE);
-    m_bdb_fs->set_node_exclusive_lock_handle(txn, node, handle);
+    m_fs->set_node_exclusive_lock_handle(txn, node, handle);
   }
-  m_bdb_fs->set_handle_locked(txn, handle, true);
+  m_fs->set_handle_locked(txn, handle, true);
 }
 
 
@@ -1437,21 +1460,21 @@ Hyperspace::Master::release(ResponseCallback *cb, uint64_t session_id, uint64_t
   HT_BDBTXN_BEGIN() {
 
     // make sure session is still valid
-    if (!m_bdb_fs->session_exists(txn, session_id)) {
+    if (!m_fs->session_exists(txn, session_id)) {
       error = Error::HYPERSPACE_EXPIRED_SESSION;
       error_msg = format("session: %lld", (Lld)session_id);
       aborted = true;
       goto txn_commit_1;
     }
 
-    if (!m_bdb_fs->handle_exists(txn, handle)) {
+    if (!m_fs->handle_exists(txn, handle)) {
       error = Error::HYPERSPACE_INVALID_HANDLE;
       error_msg = format("handle=%lld", (Lld)handle);
       aborted = true;
       goto txn_commit_1;
     }
 
-    m_bdb_fs->get_handle_node(txn, handle, node);
+    m_fs->get_handle_node(txn, handle, node);
 
     release_lock(txn, handle, node, lock_release_event, lock_release_notifications);
 
@@ -1506,38 +1529,38 @@ Hyperspace::Master::release(ResponseCallback *cb, uint64_t session_id, uint64_t
  *   > set node to unlocked in BDB
  *
  */
-void Hyperspace::Master::release_lock(BDbTxn &txn, uint64_t handle, const String &node,
+void Hyperspace::Master::release_lock(StateTxn &txn, uint64_t handle, const String &node,
     HyperspaceEventPtr &release_event, NotificationMap &release_notifications) {
   vector<uint64_t> next_lock_handles;
   uint64_t exclusive_lock_handle=0;
 
-  if (m_bdb_fs->handle_is_locked(txn, handle)) {
-    exclusive_lock_handle = m_bdb_fs->get_node_exclusive_lock_handle(txn,node);
+  if (m_fs->handle_is_locked(txn, handle)) {
+    exclusive_lock_handle = m_fs->get_node_exclusive_lock_handle(txn,node);
     if (exclusive_lock_handle != 0) {
       HT_ASSERT(handle == exclusive_lock_handle);
-      m_bdb_fs->set_node_exclusive_lock_handle(txn, node, 0);
+      m_fs->set_node_exclusive_lock_handle(txn, node, 0);
     }
     else {
-      m_bdb_fs->delete_node_shared_lock_handle(txn, node, handle);
+      m_fs->delete_node_shared_lock_handle(txn, node, handle);
     }
-    m_bdb_fs->set_handle_locked(txn, handle, false);
+    m_fs->set_handle_locked(txn, handle, false);
   }
   else
     return;
 
   // persist LOCK_RELEASED notifications if no more locks held on node
-  if (!m_bdb_fs->node_has_shared_lock_handles(txn, node)) {
+  if (!m_fs->node_has_shared_lock_handles(txn, node)) {
     HT_INFO("Persisting lock released notifications");
-    uint64_t event_id = m_bdb_fs->get_next_id_i64(txn, EVENT, true);
+    uint64_t event_id = m_fs->get_next_id_i64(txn, EVENT, true);
     release_event = make_shared<EventLockReleased>(event_id);
-    m_bdb_fs->create_event(txn, EVENT_TYPE_LOCK_RELEASED, event_id,
+    m_fs->create_event(txn, EVENT_TYPE_LOCK_RELEASED, event_id,
                            release_event->get_mask());
-    if (m_bdb_fs->get_node_event_notification_map(txn, node, release_event->get_mask(),
+    if (m_fs->get_node_event_notification_map(txn, node, release_event->get_mask(),
                                                   release_notifications)) {
       persist_event_notifications(txn, event_id, release_notifications);
     }
 
-    m_bdb_fs->set_node_cur_lock_mode(txn, node, 0);
+    m_fs->set_node_cur_lock_mode(txn, node, 0);
     HT_INFO("Finished persisting lock released notifications");
   }
 }
@@ -1551,20 +1574,20 @@ void Hyperspace::Master::release_lock(BDbTxn &txn, uint64_t handle, const String
  * > Persist lock granted notifications
  * > Persist lock acquired notifications
  */
-void Hyperspace::Master::grant_pending_lock_reqs(BDbTxn &txn, const String &node,
+void Hyperspace::Master::grant_pending_lock_reqs(StateTxn &txn, const String &node,
     HyperspaceEventPtr &lock_granted_event, NotificationMap &lock_granted_notifications,
     HyperspaceEventPtr &lock_acquired_event, NotificationMap &lock_acquired_notifications) {
   vector<uint64_t> next_lock_handles;
   int next_mode = 0;
   LockRequest front_lock_req;
 
-  if (m_bdb_fs->get_node_pending_lock_request(txn, node, front_lock_req)) {
+  if (m_fs->get_node_pending_lock_request(txn, node, front_lock_req)) {
     next_mode = front_lock_req.mode;
 
     if (next_mode == LOCK_MODE_EXCLUSIVE) {
       // get the pending exclusive lock request
       next_lock_handles.push_back(front_lock_req.handle);
-      m_bdb_fs->delete_node_pending_lock_request(txn, node, front_lock_req.handle);
+      m_fs->delete_node_pending_lock_request(txn, node, front_lock_req.handle);
     }
     else {
       // gather up all the pending shared lock requests preceeding the next exclusive request
@@ -1574,38 +1597,38 @@ void Hyperspace::Master::grant_pending_lock_reqs(BDbTxn &txn, const String &node
         if (lockreq.mode != LOCK_MODE_SHARED)
           break;
         next_lock_handles.push_back(lockreq.handle);
-        m_bdb_fs->delete_node_pending_lock_request(txn, node, lockreq.handle);
-      } while (m_bdb_fs->get_node_pending_lock_request(txn, node, lockreq));
+        m_fs->delete_node_pending_lock_request(txn, node, lockreq.handle);
+      } while (m_fs->get_node_pending_lock_request(txn, node, lockreq));
     }
 
     if (!next_lock_handles.empty()) {
       // we have at least 1 pending lock request
       // grant lock to next pending locks and persist lock granted notifications
-      uint64_t lock_generation = m_bdb_fs->incr_node_lock_generation(txn, node);
-      uint64_t event_id = m_bdb_fs->get_next_id_i64(txn, EVENT, true);
+      uint64_t lock_generation = m_fs->incr_node_lock_generation(txn, node);
+      uint64_t event_id = m_fs->get_next_id_i64(txn, EVENT, true);
       uint64_t session;
-      m_bdb_fs->create_event(txn, EVENT_TYPE_LOCK_GRANTED, event_id, EVENT_MASK_LOCK_GRANTED,
+      m_fs->create_event(txn, EVENT_TYPE_LOCK_GRANTED, event_id, EVENT_MASK_LOCK_GRANTED,
                              next_mode, lock_generation);
-      m_bdb_fs->set_xattr_i64(txn, node, "lock.generation", lock_generation);
-      m_bdb_fs->set_node_cur_lock_mode(txn, node, next_mode);
+      m_fs->set_xattr_i64(txn, node, "lock.generation", lock_generation);
+      m_fs->set_node_cur_lock_mode(txn, node, next_mode);
 
       lock_granted_event = make_shared<EventLockGranted>(event_id, next_mode, lock_generation);
 
       for (auto handle : next_lock_handles) {
         lock_handle(txn, handle, next_mode, node);
-        session = m_bdb_fs->get_handle_session(txn, handle);
+        session = m_fs->get_handle_session(txn, handle);
         lock_granted_notifications[handle] = session;
       }
       // persist lock granted notifications
       persist_event_notifications(txn, event_id, lock_granted_notifications);
 
       // create lock acquired event
-      event_id = m_bdb_fs->get_next_id_i64(txn, EVENT, true);
-      m_bdb_fs->create_event(txn, EVENT_TYPE_LOCK_ACQUIRED, event_id, EVENT_MASK_LOCK_ACQUIRED,
+      event_id = m_fs->get_next_id_i64(txn, EVENT, true);
+      m_fs->create_event(txn, EVENT_TYPE_LOCK_ACQUIRED, event_id, EVENT_MASK_LOCK_ACQUIRED,
                              next_mode);
       lock_acquired_event = make_shared<EventLockAcquired>(event_id, next_mode);
       // persist lock acquired notifications
-      if (m_bdb_fs->get_node_event_notification_map(txn, node, EVENT_MASK_LOCK_ACQUIRED,
+      if (m_fs->get_node_event_notification_map(txn, node, EVENT_MASK_LOCK_ACQUIRED,
                                                     lock_acquired_notifications))
         persist_event_notifications(txn, event_id, lock_acquired_notifications);
     }
@@ -1618,7 +1641,7 @@ void Hyperspace::Master::grant_pending_lock_reqs(BDbTxn &txn, const String &node
  * > Store the handles affected by an event in BerkeleyDB
  */
 void
-Hyperspace::Master::persist_event_notifications(BDbTxn &txn, uint64_t event_id,
+Hyperspace::Master::persist_event_notifications(StateTxn &txn, uint64_t event_id,
                                     NotificationMap &handles_to_sessions)
 {
   if (handles_to_sessions.size() > 0) {
@@ -1627,7 +1650,7 @@ Hyperspace::Master::persist_event_notifications(BDbTxn &txn, uint64_t event_id,
          iter != handles_to_sessions.end(); iter++) {
       handles.push_back(iter->first);
     }
-    m_bdb_fs->set_event_notification_handles(txn, event_id, handles);
+    m_fs->set_event_notification_handles(txn, event_id, handles);
   }
 }
 
@@ -1637,11 +1660,11 @@ Hyperspace::Master::persist_event_notifications(BDbTxn &txn, uint64_t event_id,
  * > Store the handle addected by an event in BerkeleyDB
  */
 void
-Hyperspace::Master::persist_event_notifications(BDbTxn &txn, uint64_t event_id, uint64_t handle)
+Hyperspace::Master::persist_event_notifications(StateTxn &txn, uint64_t event_id, uint64_t handle)
 {
   vector<uint64_t> handles;
   handles.push_back(handle);
-  m_bdb_fs->set_event_notification_handles(txn, event_id, handles);
+  m_fs->set_event_notification_handles(txn, event_id, handles);
 }
 
 /*
@@ -1711,6 +1734,29 @@ Hyperspace::Master::find_parent_node(const String &normal_name,String &parent_na
   return false;
 }
 
+/*
+ * A node is referenced by any open handle other than a watch handle
+ * (OPEN_FLAG_WATCH), which only subscribes to events.
+ */
+bool
+Hyperspace::Master::node_has_references(StateTxn &txn, const String &node) {
+  std::vector<uint64_t> handles;
+  m_fs->get_node_handles(txn, node, handles);
+  for (auto handle : handles) {
+    if ((m_fs->get_handle_open_flags(txn, handle) & OPEN_FLAG_WATCH) == 0)
+      return true;
+  }
+  return false;
+}
+
+bool
+Hyperspace::Master::node_has_handle(StateTxn &txn, const String &node,
+                                    uint64_t handle) {
+  std::vector<uint64_t> handles;
+  m_fs->get_node_handles(txn, node, handles);
+  return std::find(handles.begin(), handles.end(), handle) != handles.end();
+}
+
 /*
  * destroy_handle does the following:
  * > Start BDB txn
@@ -1741,22 +1787,29 @@ Hyperspace::Master::destroy_handle(uint64_t handle, int &error, String &errmsg,
   bool node_removed = false;
   String node;
   bool aborted = false;
+  bool orphaned = false;
 
   HT_DEBUG_OUT << "destroy_handle (handle=" << handle << ")" << HT_END;
 
   // txn 1: release lock
   HT_BDBTXN_BEGIN() {
+    orphaned = false;
     // Make sure handle is valid is not being deleted by someone else
-    if (!m_bdb_fs->handle_exists(txn, handle) ||
-        m_bdb_fs->get_handle_del_state(txn, handle) != HANDLE_NOT_DEL) {
+    if (!m_fs->handle_exists(txn, handle) ||
+        m_fs->get_handle_del_state(txn, handle) != HANDLE_NOT_DEL) {
       aborted = true;
       error = Error::HYPERSPACE_INVALID_HANDLE;
       errmsg = format("Handle %lld already deleted or being deleted", (Lld)handle);
       goto txn_commit;
     }
-    m_bdb_fs->set_handle_del_state(txn, handle, HANDLE_MARKED_FOR_DEL);
-    m_bdb_fs->get_handle_node(txn, handle, node);
-    m_bdb_fs->delete_node_handle(txn, node, handle);
+    m_fs->set_handle_del_state(txn, handle, HANDLE_MARKED_FOR_DEL);
+    m_fs->get_handle_node(txn, handle, node);
+    // A watch handle outlives its node if the node was removed underneath it
+    if (!m_fs->node_exists(txn, node) || !node_has_handle(txn, node, handle)) {
+      orphaned = true;
+      goto txn_commit;
+    }
+    m_fs->delete_node_handle(txn, node, handle);
     release_lock(txn, handle, node, lock_release_event, lock_release_notifications);
 
     txn_commit:
@@ -1767,6 +1820,9 @@ Hyperspace::Master::destroy_handle(uint64_t handle, int &error, String &errmsg,
   if (aborted)
     return false;
 
+  if (orphaned)
+    goto delete_handle;
+
   // deliver lock released notifications
   deliver_event_notifications(lock_release_event, lock_release_notifications,
                               wait_for_notify);
@@ -1786,24 +1842,24 @@ Hyperspace::Master::destroy_handle(uint64_t handle, int &error, String &errmsg,
 
   // txn 3: delete node if ephemeral and no one has it open
   HT_BDBTXN_BEGIN() {
-    has_refs = m_bdb_fs->node_has_open_handles(txn, node);
-    if (!has_refs && m_bdb_fs->node_is_ephemeral(txn, node)) {
+    has_refs = node_has_references(txn, node);
+    if (!has_refs && m_fs->node_is_ephemeral(txn, node)) {
       String parent_node, child_node;
 
       if (find_parent_node(node, parent_node, child_node)) {
         // persist child node removed notifications
-        uint64_t event_id = m_bdb_fs->get_next_id_i64(txn, EVENT, true);
-        m_bdb_fs->create_event(txn, EVENT_TYPE_NAMED, event_id,
+        uint64_t event_id = m_fs->get_next_id_i64(txn, EVENT, true);
+        m_fs->create_event(txn, EVENT_TYPE_NAMED, event_id,
                                EVENT_MASK_CHILD_NODE_REMOVED, child_node);
         node_removed_event = make_shared<EventNamed>(event_id, EVENT_MASK_CHILD_NODE_REMOVED,
                                                      child_node);
-        if (m_bdb_fs->get_node_event_notification_map(txn, parent_node,
+        if (m_fs->get_node_event_notification_map(txn, parent_node,
             EVENT_MASK_CHILD_NODE_REMOVED, node_removed_notifications)) {
           persist_event_notifications(txn, event_id, node_removed_notifications);
         }
         // unlink file and delete node data from BDB
-        m_bdb_fs->unlink(txn, node);
-        m_bdb_fs->delete_node(txn, node);
+        m_fs->unlink(txn, node);
+        m_fs->delete_node(txn, node);
         node_removed = true;
       }
     }
@@ -1817,8 +1873,9 @@ Hyperspace::Master::destroy_handle(uint64_t handle, int &error, String &errmsg,
   }
 
   // txn 4: delete handle data from BDB
+ delete_handle:
   HT_BDBTXN_BEGIN() {
-    m_bdb_fs->delete_handle(txn, handle);
+    m_fs->delete_handle(txn, handle);
     txn.commit();
   }
   HT_BDBTXN_END(false);
@@ -1862,7 +1919,7 @@ void Hyperspace::Master::do_maintenance() {
     m_maintenance_outstanding = true;
   }
 
-  m_bdb_fs->do_checkpoint();
+  m_fs->do_checkpoint();
 
   {
     lock_guard<mutex> lock(m_maintenance_mutex);
@@ -1895,7 +1952,7 @@ void Hyperspace::Master::mkdir(CommandContext &ctx, const char *name) {
   }
 
   HT_ASSERT(ctx.txn);
-  BDbTxn &txn = *ctx.txn;
+  StateTxn &txn = *ctx.txn;
 
   // make sure parent node data is setup
   if (!validate_and_create_node_data(txn, parent_node)) {
@@ -1904,7 +1961,7 @@ void Hyperspace::Master::mkdir(CommandContext &ctx, const char *name) {
   }
 
   // make sure this node doesn't exist already
-  if (m_bdb_fs->exists(txn, name)) {
+  if (m_fs->exists(txn, name)) {
     ctx.set_error(Error::HYPERSPACE_FILE_EXISTS, (String)"node: '" + name + "'");
     return;
   }
@@ -1913,10 +1970,10 @@ void Hyperspace::Master::mkdir(CommandContext &ctx, const char *name) {
   create_event(ctx, parent_node, EVENT_MASK_CHILD_NODE_ADDED, child_name);
 
   // create node
-  m_bdb_fs->mkdir(txn, name);
+  m_fs->mkdir(txn, name);
 
   // create node data
-  m_bdb_fs->create_node(txn, name, false, 1);
+  m_fs->create_node(txn, name, false, 1);
 }
 
 
@@ -1959,10 +2016,10 @@ void Hyperspace::Master::open(CommandContext &ctx, const char *name,
   }
 
   HT_ASSERT(ctx.txn);
-  BDbTxn &txn = *ctx.txn;
+  StateTxn &txn = *ctx.txn;
 
   // make sure session is still valid
-  if (!m_bdb_fs->session_exists(txn, ctx.session_id)) {
+  if (!m_fs->session_exists(txn, ctx.session_id)) {
     ctx.set_error(Error::HYPERSPACE_EXPIRED_SESSION, format("Session %llu", (Llu)ctx.session_id));
     return;
   }
@@ -1973,7 +2030,7 @@ void Hyperspace::Master::open(CommandContext &ctx, const char *name,
     return;
   }
 
-  bool existed = m_bdb_fs->exists(txn, name);
+  bool existed = m_fs->exists(txn, name);
   if (existed) { // node exists in DB already
     // check flags
     if ((flags & OPEN_FLAG_CREATE) && (flags & OPEN_FLAG_EXCL)) {
@@ -1991,14 +2048,14 @@ void Hyperspace::Master::open(CommandContext &ctx, const char *name,
 
     // check for lock mode conflicts
     if (flags & (OPEN_FLAG_LOCK_SHARED|OPEN_FLAG_LOCK_EXCLUSIVE)) {
-      uint32_t cur_lock_mode = m_bdb_fs->get_node_cur_lock_mode(txn, node);
+      uint32_t cur_lock_mode = m_fs->get_node_cur_lock_mode(txn, node);
       if ((flags & OPEN_FLAG_LOCK_SHARED) == OPEN_FLAG_LOCK_SHARED) {
         if (cur_lock_mode == LOCK_MODE_EXCLUSIVE) {
           ctx.set_error(Error::HYPERSPACE_LOCK_CONFLICT, node);
           return;
         }
         lock_mode = LOCK_MODE_SHARED;
-        if (!m_bdb_fs->node_has_shared_lock_handles(txn, node))
+        if (!m_fs->node_has_shared_lock_handles(txn, node))
           lock_notify = true;
       }
       else if ((flags & OPEN_FLAG_LOCK_EXCLUSIVE) == OPEN_FLAG_LOCK_EXCLUSIVE) {
@@ -2018,50 +2075,52 @@ void Hyperspace::Master::open(CommandContext &ctx, const char *name,
     }
     // create new node
     lock_generation = 1;
-    m_bdb_fs->create(txn, name, (flags & OPEN_FLAG_TEMP) > 0);
-    m_bdb_fs->set_xattr_i64(txn, name, "lock.generation",
+    m_fs->create(txn, name, (flags & OPEN_FLAG_TEMP) > 0);
+    m_fs->set_xattr_i64(txn, name, "lock.generation",
                             lock_generation);
 
     // create a new node data object in hyperspace
-    m_bdb_fs->create_node(txn, node, (flags & OPEN_FLAG_TEMP) > 0, lock_generation);
+    m_fs->create_node(txn, node, (flags & OPEN_FLAG_TEMP) > 0, lock_generation);
 
     // Set the initial attributes
     for (size_t i=0; i<init_attrs.size(); i++)
-      m_bdb_fs->set_xattr(txn, name, init_attrs[i].name,
+      m_fs->set_xattr(txn, name, init_attrs[i].name,
                           init_attrs[i].value, init_attrs[i].value_len);
     created = true;
   } // node doesn't exist in DB
-  handle = m_bdb_fs->get_next_id_i64(txn, HANDLE, true);
-  m_bdb_fs->create_handle(txn, handle, node, flags, event_mask, ctx.session_id, false,
+  handle = m_fs->get_next_id_i64(txn, HANDLE, true);
+  m_fs->create_handle(txn, handle, node, flags, event_mask, ctx.session_id, false,
                           HANDLE_NOT_DEL);
-  m_bdb_fs->add_session_handle(txn, ctx.session_id, handle);
+  m_fs->add_session_handle(txn, ctx.session_id, handle);
 
-  // create node added event and persist notifications
-  create_event(ctx, parent_node, EVENT_MASK_CHILD_NODE_ADDED, child_name);
+  // create node added event and persist notifications; a watch on an
+  // existing node does not add anything to the parent directory
+  if (!existed || !(flags & OPEN_FLAG_WATCH))
+    create_event(ctx, parent_node, EVENT_MASK_CHILD_NODE_ADDED, child_name);
 
   /*
     * If open flags LOCK_SHARED or LOCK_EXCLUSIVE, then obtain lock
     */
   if (lock_mode != 0) {
-    lock_generation = m_bdb_fs->incr_node_lock_generation(txn, node);
-    m_bdb_fs->set_xattr_i64(txn, name, "lock.generation",
+    lock_generation = m_fs->incr_node_lock_generation(txn, node);
+    m_fs->set_xattr_i64(txn, name, "lock.generation",
                             lock_generation);
 
-    m_bdb_fs->set_node_cur_lock_mode(txn, node, lock_mode);
+    m_fs->set_node_cur_lock_mode(txn, node, lock_mode);
     lock_handle(txn, handle, lock_mode, node);
 
     // create and persist lock acquired event
     // deliver notification to handles to this same node
     if (lock_notify) {
-      uint64_t lock_acquired_event_id = m_bdb_fs->get_next_id_i64(txn, EVENT, true);
+      uint64_t lock_acquired_event_id = m_fs->get_next_id_i64(txn, EVENT, true);
 
-      m_bdb_fs->create_event(txn, EVENT_TYPE_LOCK_ACQUIRED, lock_acquired_event_id,
+      m_fs->create_event(txn, EVENT_TYPE_LOCK_ACQUIRED, lock_acquired_event_id,
                               EVENT_MASK_LOCK_ACQUIRED, lock_mode);
 
       std::vector<EventContext>::iterator it = ctx.evts.insert(ctx.evts.end(),
           EventContext(make_shared<EventLockAcquired>(lock_acquired_event_id, lock_mode)));
 
-      if (m_bdb_fs->get_node_event_notification_map(txn, node, EVENT_MASK_LOCK_ACQUIRED,
+      if (m_fs->get_node_event_notification_map(txn, node, EVENT_MASK_LOCK_ACQUIRED,
                                                 it->notifications)) {
         persist_event_notifications(txn, lock_acquired_event_id,
                                     it->notifications);
@@ -2070,7 +2129,7 @@ void Hyperspace::Master::open(CommandContext &ctx, const char *name,
     }
   }
 
-  m_bdb_fs->add_node_handle(txn, node, handle);
+  m_fs->add_node_handle(txn, node, handle);
 
   HT_INFOF("handle %llu created ('%s', session=%llu(%s), flags=0x%x, mask=0x%x)",
             (Llu)handle, node.c_str(), (Llu)ctx.session_id, ctx.session_data->get_name(),
@@ -2103,7 +2162,7 @@ void Hyperspace::Master::unlink(CommandContext &ctx, const char *name) {
   }
 
   HT_ASSERT(ctx.txn);
-  BDbTxn &txn = *ctx.txn;
+  StateTxn &txn = *ctx.txn;
 
   // make sure parent node data is setup
   if (!validate_and_create_node_data(txn, parent_node)) {
@@ -2117,7 +2176,7 @@ void Hyperspace::Master::unlink(CommandContext &ctx, const char *name) {
     return;
   }
 
-  bool has_refs = m_bdb_fs->node_has_open_handles(txn, node);
+  bool has_refs = node_has_references(txn, node);
   if (has_refs) {
     ctx.set_error(Error::HYPERSPACE_FILE_OPEN, "File is still open and referred to by some handle");
     return;
@@ -2130,16 +2189,16 @@ void Hyperspace::Master::unlink(CommandContext &ctx, const char *name) {
   create_event(ctx, parent_node, EVENT_MASK_CHILD_NODE_REMOVED, child_name);
 
   // Delete node
-  m_bdb_fs->unlink(txn, name);
+  m_fs->unlink(txn, name);
 
   // Delete node data
-  m_bdb_fs->delete_node(txn, node);
+  m_fs->delete_node(txn, node);
 }
 
 void Hyperspace::Master::attr_set(CommandContext &ctx, uint64_t handle,
                       const char *name, const std::vector<Attribute> &attrs) {
   HT_ASSERT(ctx.txn);
-  BDbTxn &txn = *ctx.txn;
+  StateTxn &txn = *ctx.txn;
 
   std::string attr_names;
   size_t total_value_len = 0;
@@ -2162,7 +2221,7 @@ void Hyperspace::Master::attr_set(CommandContext &ctx, uint64_t handle,
       return;
 
   for (const auto &attr : attrs) {
-    m_bdb_fs->set_xattr(txn, node, attr.name, attr.value, attr.value_len);
+    m_fs->set_xattr(txn, node, attr.name, attr.value, attr.value_len);
     // create event notification and persist
     create_event(ctx, node, EVENT_MASK_ATTR_SET, attr.name);
   }
@@ -2176,7 +2235,7 @@ void Hyperspace::Master::attr_set(CommandContext &ctx, uint64_t handle,
 void Hyperspace::Master::attr_get(CommandContext &ctx, uint64_t handle,
                       const char *name, const char *attr, DynamicBuffer &dbuf) {
   HT_ASSERT(ctx.txn);
-  BDbTxn &txn = *ctx.txn;
+  StateTxn &txn = *ctx.txn;
 
   String node;
   if (name && *name) {
@@ -2187,7 +2246,7 @@ void Hyperspace::Master::attr_get(CommandContext &ctx, uint64_t handle,
     if (!get_handle_node(ctx, handle, attr, node))
       return;
 
-  if (!m_bdb_fs->get_xattr(txn, node, attr, dbuf)) {
+  if (!m_fs->get_xattr(txn, node, attr, dbuf)) {
     ctx.set_error(Error::HYPERSPACE_ATTR_NOT_FOUND, attr);
     return;
   }
@@ -2198,7 +2257,7 @@ void Hyperspace::Master::attr_get(CommandContext &ctx, uint64_t handle,
                       std::vector<DynamicBufferPtr> &dbufs) {
   dbufs.clear();
   HT_ASSERT(ctx.txn);
-  BDbTxn &txn = *ctx.txn;
+  StateTxn &txn = *ctx.txn;
 
   String node;
   if (name && *name) {
@@ -2212,7 +2271,7 @@ void Hyperspace::Master::attr_get(CommandContext &ctx, uint64_t handle,
   dbufs.reserve(attrs.size());
   for (const auto &attr : attrs) {
     dbufs.push_back(make_shared<DynamicBuffer>());
-    if (!m_bdb_fs->get_xattr(txn, node, attr, *dbufs.back()))
+    if (!m_fs->get_xattr(txn, node, attr, *dbufs.back()))
       dbufs.back() = 0; // attr not found
   }
 }
@@ -2220,7 +2279,7 @@ void Hyperspace::Master::attr_get(CommandContext &ctx, uint64_t handle,
 void Hyperspace::Master::attr_incr(CommandContext &ctx, uint64_t handle,
                        const char *name, const char* attr, uint64_t& attr_val) {
   HT_ASSERT(ctx.txn);
-  BDbTxn &txn = *ctx.txn;
+  StateTxn &txn = *ctx.txn;
 
   String node;
   if (name && *name) {
@@ -2231,20 +2290,23 @@ void Hyperspace::Master::attr_incr(CommandContext &ctx, uint64_t handle,
     if (!get_handle_node(ctx, handle, attr, node))
       return;
 
-  if (!m_bdb_fs->incr_attr(txn, node, attr, &attr_val)) {
+  if (!m_fs->incr_attr(txn, node, attr, &attr_val)) {
     ctx.set_error(Error::HYPERSPACE_ATTR_NOT_FOUND, attr);
     return;
   }
+
+  // create event notification and persist
+  create_event(ctx, node, EVENT_MASK_ATTR_SET, attr);
 }
 
 void Hyperspace::Master::attr_del(CommandContext &ctx, uint64_t handle, const char *name) {
   HT_ASSERT(ctx.txn);
-  BDbTxn &txn = *ctx.txn;
+  StateTxn &txn = *ctx.txn;
 
   String node;
   if (!get_handle_node(ctx, handle, name, node))
     return;
-  m_bdb_fs->del_xattr(txn, node, name);
+  m_fs->del_xattr(txn, node, name);
 
   // create event notification and persist
   create_event(ctx, node, EVENT_MASK_ATTR_DEL, name);
@@ -2255,7 +2317,7 @@ void Hyperspace::Master::attr_exists(CommandContext& ctx, uint64_t handle,
   exists = false;
 
   HT_ASSERT(ctx.txn);
-  BDbTxn &txn = *ctx.txn;
+  StateTxn &txn = *ctx.txn;
 
   String node;
   if (name && *name) {
@@ -2266,7 +2328,7 @@ void Hyperspace::Master::attr_exists(CommandContext& ctx, uint64_t handle,
     if (!get_handle_node(ctx, handle, attr, node))
       return;
 
-  if (m_bdb_fs->exists_xattr(txn, node, attr))
+  if (m_fs->exists_xattr(txn, node, attr))
     exists = true;
 }
 
@@ -2274,13 +2336,13 @@ void Hyperspace::Master::attr_list(CommandContext& ctx, uint64_t handle, std::ve
   attributes.clear();
 
   HT_ASSERT(ctx.txn);
-  BDbTxn &txn = *ctx.txn;
+  StateTxn &txn = *ctx.txn;
 
   String node;
   if (!get_handle_node(ctx, handle, 0, node))
     return;
 
-  if (!m_bdb_fs->list_xattr(txn, node, attributes)) {
+  if (!m_fs->list_xattr(txn, node, attributes)) {
     ctx.set_error(Error::HYPERSPACE_ATTR_NOT_FOUND,
                   format("handle=%lld node=%s", (Lld)handle, node.c_str()));
     return;
@@ -2291,13 +2353,13 @@ void Hyperspace::Master::exists(CommandContext& ctx, const char *name, bool& fil
   file_exists = false;
 
   HT_ASSERT(ctx.txn);
-  BDbTxn &txn = *ctx.txn;
+  StateTxn &txn = *ctx.txn;
 
   if (m_verbose)
     HT_INFOF("exists(session_id=%llu, name=%s)", (Llu)ctx.session_id, name);
 
   HT_ASSERT(name[0] == '/' && (name[1] == '\0' || name[strlen(name)-1] != '/'));
-  file_exists = m_bdb_fs->exists(txn, name);
+  file_exists = m_fs->exists(txn, name);
 
   if (m_verbose)
     HT_INFOF("exitting exists(session_id=%llu, name=%s)", (Llu)ctx.session_id, name);
@@ -2307,13 +2369,13 @@ void Hyperspace::Master::readdir(CommandContext& ctx, uint64_t handle, std::vect
   listing.clear();
 
   HT_ASSERT(ctx.txn);
-  BDbTxn &txn = *ctx.txn;
+  StateTxn &txn = *ctx.txn;
 
   String node;
   if (!get_handle_node(ctx, handle, 0, node))
     return;
 
-  m_bdb_fs->get_directory_listing(txn, node, listing);
+  m_fs->get_directory_listing(txn, node, listing);
 }
 
 void Hyperspace::Master::readdir_attr(CommandContext& ctx, uint64_t handle, const char *name, const char *attr,
@@ -2321,7 +2383,7 @@ void Hyperspace::Master::readdir_attr(CommandContext& ctx, uint64_t handle, cons
   listing.clear();
 
   HT_ASSERT(ctx.txn);
-  BDbTxn &txn = *ctx.txn;
+  StateTxn &txn = *ctx.txn;
 
   String node;
   if (name && *name) {
@@ -2332,7 +2394,7 @@ void Hyperspace::Master::readdir_attr(CommandContext& ctx, uint64_t handle, cons
     if (!get_handle_node(ctx, handle, attr, node))
       return;
 
-  m_bdb_fs->get_directory_attr_listing(txn, node, attr, include_sub_entries, listing);
+  m_fs->get_directory_attr_listing(txn, node, attr, include_sub_entries, listing);
 }
 
 void Hyperspace::Master::readpath_attr(CommandContext& ctx, uint64_t handle, const char *name, const char *attr,
@@ -2340,7 +2402,7 @@ void Hyperspace::Master::readpath_attr(CommandContext& ctx, uint64_t handle, con
   listing.clear();
 
   HT_ASSERT(ctx.txn);
-  BDbTxn &txn = *ctx.txn;
+  StateTxn &txn = *ctx.txn;
 
   String node;
   bool node_is_dir;
@@ -2351,7 +2413,7 @@ void Hyperspace::Master::readpath_attr(CommandContext& ctx, uint64_t handle, con
   else {
     if (!get_handle_node(ctx, handle, attr, node))
       return;
-    m_bdb_fs->exists(txn, node, &node_is_dir);
+    m_fs->exists(txn, node, &node_is_dir);
   }
 
   size_t pos = 0;
@@ -2373,7 +2435,7 @@ void Hyperspace::Master::readpath_attr(CommandContext& ctx, uint64_t handle, con
     entry.name = path_component;
 
     // insert entry to result list if it has the attribute
-    if (m_bdb_fs->get_xattr(txn, path_component, attr, attr_buf)) {
+    if (m_fs->get_xattr(txn, path_component, attr, attr_buf)) {
       entry.attr = attr_buf;
       entry.has_attr = true;
     }
@@ -2406,21 +2468,21 @@ bool Hyperspace::Master::get_handle_node(CommandContext &ctx, uint64_t handle, c
   }
 
   HT_ASSERT(ctx.txn);
-  BDbTxn &txn = *ctx.txn;
+  StateTxn &txn = *ctx.txn;
 
   // make sure session is still valid
-  if (!m_bdb_fs->session_exists(txn, ctx.session_id)) {
+  if (!m_fs->session_exists(txn, ctx.session_id)) {
     ctx.set_error(Error::HYPERSPACE_EXPIRED_SESSION, format("Session %llu", (Llu)ctx.session_id));
     return false;
   }
 
-  if (!m_bdb_fs->handle_exists(txn, handle)) {
+  if (!m_fs->handle_exists(txn, handle)) {
     ctx.set_error(Error::HYPERSPACE_INVALID_HANDLE,
                   format("Session %llu, handle=%llu", (Llu)ctx.session_id, (Llu)handle));
     return false;
   }
 
-  m_bdb_fs->get_handle_node(txn, handle, node);
+  m_fs->get_handle_node(txn, handle, node);
   return true;
 }
 
@@ -2445,7 +2507,7 @@ bool Hyperspace::Master::get_named_node(CommandContext &ctx, const char *name, c
   }
 
   HT_ASSERT(ctx.txn);
-  BDbTxn &txn = *ctx.txn;
+  StateTxn &txn = *ctx.txn;
 
   node = name;
   String child_name, parent_node;
@@ -2456,13 +2518,13 @@ bool Hyperspace::Master::get_named_node(CommandContext &ctx, const char *name, c
   boost::trim_right_if(node, boost::is_any_of("/"));
 
   // make sure node exists
-  if (!m_bdb_fs->exists(txn, node, is_dir)) {
+  if (!m_fs->exists(txn, node, is_dir)) {
     ctx.set_error(Error::HYPERSPACE_FILE_NOT_FOUND, (String)"node: '" + name + "'");
     return false;
   }
 
   // make sure session is still valid
-  if (!m_bdb_fs->session_exists(txn, ctx.session_id)) {
+  if (!m_fs->session_exists(txn, ctx.session_id)) {
     ctx.set_error(Error::HYPERSPACE_EXPIRED_SESSION, format("Session %llu", (Llu)ctx.session_id));
     return false;
   }
@@ -2473,15 +2535,15 @@ bool Hyperspace::Master::get_named_node(CommandContext &ctx, const char *name, c
  */
 void Hyperspace::Master::create_event(CommandContext &ctx, const String &node, uint32_t event_mask, const String &name) {
   HT_ASSERT(ctx.txn);
-  BDbTxn &txn = *ctx.txn;
+  StateTxn &txn = *ctx.txn;
 
-  uint64_t event_id = m_bdb_fs->get_next_id_i64(txn, EVENT, true);
-  m_bdb_fs->create_event(txn, EVENT_TYPE_NAMED, event_id, event_mask, name);
+  uint64_t event_id = m_fs->get_next_id_i64(txn, EVENT, true);
+  m_fs->create_event(txn, EVENT_TYPE_NAMED, event_id, event_mask, name);
 
   std::vector<EventContext>::iterator it = ctx.evts.insert(ctx.evts.end(),
        EventContext(make_shared<EventNamed>(event_id, event_mask, name)));
 
-  if (m_bdb_fs->get_node_event_notification_map(txn, node, event_mask,
+  if (m_fs->get_node_event_notification_map(txn, node, event_mask,
                                                 it->notifications)) {
     persist_event_notifications(txn, event_id, it->notifications);
     it->persisted_notifications = true;
@@ -2507,11 +2569,11 @@ void Hyperspace::Master::deliver_event_notifications(EventContext &evt, bool wai
 void Hyperspace::Master::get_generation_number() {
 
   HT_BDBTXN_BEGIN() {
-    if (!m_bdb_fs->get_xattr_i32(txn, "/hyperspace/metadata", "generation",
+    if (!m_fs->get_xattr_i32(txn, "/hyperspace/metadata", "generation",
                                  &m_generation))
       m_generation = 0;
     m_generation++;
-    m_bdb_fs->set_xattr_i32(txn, "/hyperspace/metadata", "generation",
+    m_fs->set_xattr_i32(txn, "/hyperspace/metadata", "generation",
                             m_generation);
     txn.commit();
   }
@@ -2523,21 +2585,21 @@ void Hyperspace::Master::get_generation_number() {
  * create the node data
  */
 bool
-Hyperspace::Master::validate_and_create_node_data(BDbTxn &txn, const String &node)
+Hyperspace::Master::validate_and_create_node_data(StateTxn &txn, const String &node)
 {
   // make sure node is exists
-  if (!m_bdb_fs->exists(txn, node)) {
+  if (!m_fs->exists(txn, node)) {
     return false;
   }
 
   // create node data for this node and set its lock generation
-  if (!m_bdb_fs->node_exists(txn, node)) {
+  if (!m_fs->node_exists(txn, node)) {
     uint64_t lock_generation;
-    if (!m_bdb_fs->get_xattr_i64(txn, node, "lock.generation", &lock_generation)) {
+    if (!m_fs->get_xattr_i64(txn, node, "lock.generation", &lock_generation)) {
       lock_generation = 1;
-      m_bdb_fs->set_xattr_i64(txn, node, "lock.generation", lock_generation);
+      m_fs->set_xattr_i64(txn, node, "lock.generation", lock_generation);
     }
-    m_bdb_fs->create_node(txn, node, false, lock_generation);
+    m_fs->create_node(txn, node, false, lock_generation);
   }
 
   return true;
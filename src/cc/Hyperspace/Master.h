@@ -22,7 +22,7 @@
 #ifndef Hyperspace_Master_h
 #define Hyperspace_Master_h
 
-#include <Hyperspace/BerkeleyDbFilesystem.h>
+#include <Hyperspace/StateStore.h>
 #include <Hyperspace/MetricsHandler.h>
 #include <Hyperspace/Protocol.h>
 #include <Hyperspace/ServerKeepaliveHandler.h>
@@ -76,14 +76,14 @@ namespace Hyperspace {
            ApplicationQueuePtr &app_queue_ptr);
     ~Master();
     bool is_master() {
-      if (m_bdb_fs)
-        return m_bdb_fs->is_master();
+      if (m_fs)
+        return m_fs->is_master();
       else
         return false;
     }
     String get_current_master() {
-      if (m_bdb_fs)
-        return m_bdb_fs->get_current_master();
+      if (m_fs)
+        return m_fs->get_current_master();
       else
         return (String) "";
     };
@@ -213,7 +213,7 @@ namespace Hyperspace {
       const char* friendly_name;
       uint64_t session_id;
       SessionDataPtr session_data;
-      BDbTxn *txn;
+      StateTxn *txn;
       std::vector<EventContext> evts;
       bool aborted;
       int error;
@@ -241,7 +241,7 @@ namespace Hyperspace {
         error_msg.clear();
       }
 
-      void reset(BDbTxn *_txn) {
+      void reset(StateTxn *_txn) {
         session_data = 0;
         txn = _txn;
         evts.clear();
@@ -287,10 +287,10 @@ namespace Hyperspace {
     void normalize_name(std::string name, std::string &normal);
     void deliver_event_notifications(HyperspaceEventPtr &event_ptr,
         NotificationMap &handles_to_sessions, bool wait_for_notify = true);
-    void persist_event_notifications(BDbTxn &txn, uint64_t event_id,
+    void persist_event_notifications(StateTxn &txn, uint64_t event_id,
                                      NotificationMap &handles_to_sessions);
-    void persist_event_notifications(BDbTxn &txn, uint64_t event_id, uint64_t handle);
-    bool validate_and_create_node_data(BDbTxn &txn, const String &node);
+    void persist_event_notifications(StateTxn &txn, uint64_t event_id, uint64_t handle);
+    bool validate_and_create_node_data(StateTxn &txn, const String &node);
     /*
      * Locates the parent 'node' of the given pathname.  It determines the name
      * of the parent node by stripping off the characters incuding and after
@@ -311,13 +311,26 @@ namespace Hyperspace {
                           std::string &parent_name, std::string &child_name);
     bool destroy_handle(uint64_t handle, int &error, String &errmsg,
                         bool wait_for_notify=true);
-    void release_lock(BDbTxn &txn, uint64_t handle, const String &node,
+    /** Checks if a node is held open by any handle other than a watch handle.
+     * @param txn state store transaction
+     * @param node name of node
+     * @return <i>true</i> if a non-watch handle is open on <code>node</code>
+     */
+    bool node_has_references(StateTxn &txn, const String &node);
+    /** Checks if a handle is in a node's list of open handles.
+     * @param txn state store transaction
+     * @param node name of node
+     * @param handle handle to look for
+     * @return <i>true</i> if <code>handle</code> is open on <code>node</code>
+     */
+    bool node_has_handle(StateTxn &txn, const String &node, uint64_t handle);
+    void release_lock(StateTxn &txn, uint64_t handle, const String &node,
         HyperspaceEventPtr &release_event, NotificationMap &release_notifications);
-    void lock_handle(BDbTxn &txn, uint64_t handle, uint32_t mode, String &node);
-    void lock_handle(BDbTxn &txn, uint64_t handle, uint32_t mode, const String &node);
+    void lock_handle(StateTxn &txn, uint64_t handle, uint32_t mode, String &node);
+    void lock_handle(StateTxn &txn, uint64_t handle, uint32_t mode, const String &node);
     void lock_handle_with_notification(uint64_t handle, uint32_t mode,
                                        bool wait_for_notify=true);
-    void grant_pending_lock_reqs(BDbTxn &txn, const String &node,
+    void grant_pending_lock_reqs(StateTxn &txn, const String &node,
         HyperspaceEventPtr &lock_granted_event, NotificationMap &lock_granted_notifications,
         HyperspaceEventPtr &lock_acquired_event, NotificationMap &lock_acquired_notifications);
 
@@ -352,7 +365,7 @@ namespace Hyperspace {
     bool m_shutdown {};
 
     // BerkeleyDB state
-    BerkeleyDbFilesystem *m_bdb_fs;
+    StateStore *m_fs;
 
     /// Program status tracker
     Status m_status;
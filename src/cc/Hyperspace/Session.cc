@@ -66,6 +66,9 @@ Session::Session(Comm *comm, PropertiesPtr &cfg)
   if (m_reconnect)
     HT_INFO("Hyperspace session setup to reconnect");
 
+  if (cfg->get_bool("Hyperspace.Client.Cache.Enable"))
+    m_cache.reset(new ClientCache(cfg->get_i32("Hyperspace.Client.Cache.MaxNodes")));
+
   for (const auto &replica : cfg->get_strs("Hyperspace.Replica.Host")) {
     m_hyperspace_replicas.push_back(replica);
   }
@@ -333,12 +336,34 @@ void Session::unlink(const std::string &name, Timer *timer) {
 
 
 bool Session::exists(const std::string &name, Timer *timer) {
-  DispatchHandlerSynchronizer sync_handler;
-  Hypertable::EventPtr event_ptr;
   String normal_name;
 
   normalize_name(name, normal_name);
 
+  if (cache_usable(timer)) {
+    bool exists;
+    uint64_t generation;
+    if (m_cache->get_exists(normal_name, &exists))
+      return exists;
+    // existence is tracked by the parent's CHILD_NODE_ADDED/REMOVED events
+    size_t last_slash = normal_name.rfind('/');
+    String parent = (last_slash == 0) ? String("/") : normal_name.substr(0, last_slash);
+    if (cache_watch(parent, timer) &&
+        m_cache->get_generation(parent, &generation)) {
+      exists = exists_nocache(normal_name, timer);
+      m_cache->put_exists(normal_name, generation, exists);
+      return exists;
+    }
+  }
+
+  return exists_nocache(normal_name, timer);
+}
+
+
+bool Session::exists_nocache(const std::string &normal_name, Timer *timer) {
+  DispatchHandlerSynchronizer sync_handler;
+  Hypertable::EventPtr event_ptr;
+
   CommBufPtr cbuf_ptr(Protocol::create_exists_request(normal_name));
 
  try_again:
@@ -584,6 +609,25 @@ Session::attr_get(uint64_t handle, const std::string &attr,
 void
 Session::attr_get(const std::string &name, const std::string &attr,
                   DynamicBuffer &value, Timer *timer) {
+  String normal_name;
+  bool exists;
+
+  normalize_name(name, normal_name);
+
+  if (cache_attr_get(normal_name, attr, &exists, &value, timer)) {
+    if (!exists)
+      HT_THROWF(Error::HYPERSPACE_ATTR_NOT_FOUND,
+                "Problem getting attribute '%s' of hyperspace file '%s'",
+                attr.c_str(), name.c_str());
+    return;
+  }
+
+  attr_get_nocache(name, attr, value, timer);
+}
+
+void
+Session::attr_get_nocache(const std::string &name, const std::string &attr,
+                          DynamicBuffer &value, Timer *timer) {
   DispatchHandlerSynchronizer sync_handler;
   Hypertable::EventPtr event_ptr;
   CommBufPtr cbuf_ptr(Protocol::create_attr_get_request(0, &name, attr));
@@ -612,9 +656,16 @@ void
 Session::attr_get(const std::string &name, const std::string &attr,
                   bool& attr_exists, DynamicBuffer &value, Timer *timer)
 {
+  String normal_name;
+
   attr_exists = false;
+
+  normalize_name(name, normal_name);
+  if (cache_attr_get(normal_name, attr, &attr_exists, &value, timer))
+    return;
+
   try {
-      attr_get(name, attr, value, timer);
+      attr_get_nocache(name, attr, value, timer);
       attr_exists = true;
     }
     catch (Exception &e) {
@@ -716,6 +767,12 @@ Session::attr_exists(const std::string& name, const std::string& attr, Timer *ti
 {
   DispatchHandlerSynchronizer sync_handler;
   Hypertable::EventPtr event_ptr;
+  String normal_name;
+  bool exists;
+
+  normalize_name(name, normal_name);
+  if (cache_attr_get(normal_name, attr, &exists, 0, timer))
+    return exists;
 
   CommBufPtr cbuf_ptr(Protocol::create_attr_exists_request(name, attr));
 
@@ -889,6 +946,55 @@ Session::readdir_attr(uint64_t handle, const std::string &attr, bool include_sub
 void
 Session::readdir_attr(const std::string &name, const std::string &attr, bool include_sub_entries,
                       std::vector<DirEntryAttr> &listing, Timer *timer) {
+  String normal_name;
+
+  normalize_name(name, normal_name);
+
+  // Only the direct listing is cached.  Its entries are invalidated through
+  // the directory's child events and each entry's attribute events, so every
+  // entry must be watched before a listing is inserted.  If new entry
+  // watches had to be opened, the listing is fetched again since changes
+  // made before the watches were in place were not observed.
+  if (!include_sub_entries && cache_usable(timer)) {
+    if (m_cache->get_listing(normal_name, attr, listing))
+      return;
+    if (cache_watch(normal_name, timer)) {
+      bool fetched = false;
+      for (int pass=0; pass<2; pass++) {
+        uint64_t generation, entry_generation;
+        bool watched = true;
+        if (!m_cache->get_generation(normal_name, &generation))
+          break;
+        readdir_attr_nocache(normal_name, attr, false, listing, timer);
+        fetched = true;
+        for (auto &entry : listing) {
+          String entry_name = (normal_name == "/") ? normal_name + entry.name
+            : normal_name + "/" + entry.name;
+          if (m_cache->get_generation(entry_name, &entry_generation))
+            continue;
+          watched = false;
+          if (!cache_watch(entry_name, timer)) {
+            pass = 2;
+            break;
+          }
+        }
+        if (watched) {
+          m_cache->put_listing(normal_name, generation, attr, listing);
+          break;
+        }
+      }
+      if (fetched)
+        return;
+    }
+  }
+
+  readdir_attr_nocache(name, attr, include_sub_entries, listing, timer);
+}
+
+void
+Session::readdir_attr_nocache(const std::string &name, const std::string &attr,
+                              bool include_sub_entries,
+                              std::vector<DirEntryAttr> &listing, Timer *timer) {
   DispatchHandlerSynchronizer sync_handler;
   Hypertable::EventPtr event_ptr;
   CommBufPtr cbuf_ptr(Protocol::create_readdir_attr_request(0, &name, attr, include_sub_entries));
@@ -1201,6 +1307,9 @@ int Session::state_transition(int state) {
     }
   }
   else if (m_state == STATE_DISCONNECTED) {
+    // watch handles do not survive a new session
+    if (m_cache)
+      m_cache->purge();
     if (m_reconnect) {
       if (old_state != STATE_DISCONNECTED)
         for(CallbackMap::iterator it = m_callbacks.begin(); it != m_callbacks.end(); it++)
@@ -1210,6 +1319,8 @@ int Session::state_transition(int state) {
     }
   }
   else if (m_state == STATE_EXPIRED) {
+    if (m_cache)
+      m_cache->purge();
     if (old_state != STATE_EXPIRED) {
       for(CallbackMap::iterator it = m_callbacks.begin(); it != m_callbacks.end(); it++)
         (it->second)->expired();
@@ -1387,6 +1498,103 @@ void Session::normalize_name(const String &name, String &normal) {
     normal += name.substr(0, name.length()-1);
 }
 
+bool Session::cache_usable(Timer *timer) {
+  if (!m_cache)
+    return false;
+
+  std::vector<uint64_t> orphans;
+  m_cache->take_orphans(orphans);
+  for (auto handle : orphans) {
+    try {
+      close(handle, timer);
+    }
+    catch (Exception &e) {
+      HT_DEBUG_OUT << "Problem closing cache watch handle " << handle
+                   << " - " << e.what() << HT_END;
+    }
+  }
+
+  return get_state() == STATE_SAFE;
+}
+
+bool Session::cache_watch(const String &name, Timer *timer) {
+  uint64_t generation = 0;
+
+  if (m_cache->get_generation(name, &generation))
+    return true;
+
+  // watch ancestors first so that removal of this node is observed
+  if (name != "/") {
+    size_t last_slash = name.rfind('/');
+    String parent = (last_slash == 0) ? String("/") : name.substr(0, last_slash);
+    if (!cache_watch(parent, timer) ||
+        !m_cache->get_generation(parent, &generation))
+      return false;
+  }
+
+  if (m_cache->full())
+    return false;
+
+  HandleCallbackPtr callback = m_cache->create_watch_callback(name);
+  uint64_t handle;
+  try {
+    handle = open(name, OPEN_FLAG_READ|OPEN_FLAG_WATCH, callback, timer);
+  }
+  catch (Exception &e) {
+    if (e.code() != Error::HYPERSPACE_FILE_NOT_FOUND)
+      HT_DEBUG_OUT << "Problem opening cache watch on " << name << " - "
+                   << e.what() << HT_END;
+    return false;
+  }
+
+  if (get_state() == STATE_EXPIRED)
+    return false;
+
+  if (!m_cache->add_watch(name, handle, callback, generation)) {
+    m_cache->add_orphan(handle);
+    return false;
+  }
+  return true;
+}
+
+bool Session::cache_attr_get(const String &name, const String &attr,
+                             bool *existsp, DynamicBuffer *value,
+                             Timer *timer) {
+  uint64_t generation;
+
+  // the master updates lock.generation without an ATTR_SET event
+  if (!cache_usable(timer) || attr == "lock.generation")
+    return false;
+
+  if (m_cache->get_attr(name, attr, existsp, value))
+    return true;
+
+  if (!cache_watch(name, timer) ||
+      !m_cache->get_generation(name, &generation))
+    return false;
+
+  DynamicBuffer buffer;
+  DynamicBuffer &dbuf = value ? *value : buffer;
+  *existsp = false;
+  try {
+    attr_get_nocache(name, attr, dbuf, timer);
+    *existsp = true;
+  }
+  catch (Exception &e) {
+    if (e.code() != Error::HYPERSPACE_ATTR_NOT_FOUND)
+      throw;
+  }
+  m_cache->put_attr(name, generation, attr, *existsp, dbuf.base, dbuf.fill());
+  return true;
+}
+
+bool Session::get_cache_stats(ClientCache::Stats &stats) {
+  if (!m_cache)
+    return false;
+  m_cache->get_stats(stats);
+  return true;
+}
+
 HsCommandInterpreterPtr Session::create_hs_interpreter() {
   return make_shared<HsCommandInterpreter>(this);
 }
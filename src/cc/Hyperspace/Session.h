@@ -22,6 +22,7 @@
 #ifndef Hyperspace_Session_h
 #define Hyperspace_Session_h
 
+#include <Hyperspace/ClientCache.h>
 #include <Hyperspace/ClientKeepaliveHandler.h>
 #include <Hyperspace/DirEntry.h>
 #include <Hyperspace/DirEntryAttr.h>
@@ -82,7 +83,10 @@ namespace Hyperspace {
     /** Atomically open and lock file shared, fail if can't */
     OPEN_FLAG_LOCK_SHARED    = 0x00044,
     /** atomically open and lock file exclusive, fail if can't */
-    OPEN_FLAG_LOCK_EXCLUSIVE = 0x00084
+    OPEN_FLAG_LOCK_EXCLUSIVE = 0x00084,
+    /** Open file only to receive events, does not keep file from being
+        removed */
+    OPEN_FLAG_WATCH          = 0x00100
   };
 
   /**
@@ -144,6 +148,9 @@ namespace Hyperspace {
    * Hyperspace.KeepAlive.Interval=1000
    * Hyperspace.GracePeriod=6000
    * </pre>
+   * If Hyperspace.Client.Cache.Enable is set, the name-based #exists,
+   * #attr_get, #attr_exists and non-recursive #readdir_attr calls are served
+   * from a ClientCache while the session is in the SAFE state.
    */
   class Session {
 
@@ -687,6 +694,14 @@ namespace Hyperspace {
     /// transitions back to STATE_SAFE if current state is STATE_JEOPARDY.
     void handle_wakeup();
 
+    /** Gets client cache statistics.
+     *
+     * @param stats reference to statistics structure to fill in
+     * @return <i>false</i> if the client cache is disabled, <i>true</i>
+     * otherwise
+     */
+    bool get_cache_stats(ClientCache::Stats &stats);
+
     /** Attempts to shutdown the Hyperspace server and destroys this session.
      *
      * @param timer maximum wait timer
@@ -705,6 +720,41 @@ namespace Hyperspace {
     int send_message(CommBufPtr &, DispatchHandler *, Timer *timer);
     void normalize_name(const std::string &name, std::string &normal);
     uint64_t open(ClientHandleStatePtr &, CommBufPtr &, Timer *timer);
+    bool exists_nocache(const std::string &name, Timer *timer);
+    void attr_get_nocache(const std::string &name, const std::string &attr,
+                          DynamicBuffer &value, Timer *timer);
+    void readdir_attr_nocache(const std::string &name, const std::string &attr,
+                              bool include_sub_entries,
+                              std::vector<DirEntryAttr> &listing, Timer *timer);
+
+    /** Checks if the client cache may be used.  Closes watch handles of
+     * removed nodes queued by the cache.
+     *
+     * @param timer maximum wait timer
+     * @return <i>true</i> if the cache is enabled and the session is SAFE
+     */
+    bool cache_usable(Timer *timer);
+
+    /** Establishes cache watch handles on a node and all of its ancestors.
+     *
+     * @param name normalized name of node
+     * @param timer maximum wait timer
+     * @return <i>true</i> if <code>name</code> is watched
+     */
+    bool cache_watch(const std::string &name, Timer *timer);
+
+    /** Looks up an attribute through the client cache, fetching it on a miss.
+     *
+     * @param name normalized name of file
+     * @param attr attribute name
+     * @param existsp address of variable set to <i>true</i> if attribute
+     * exists
+     * @param value buffer to hold value, or 0
+     * @param timer maximum wait timer
+     * @return <i>false</i> if the cache could not be used
+     */
+    bool cache_attr_get(const std::string &name, const std::string &attr,
+                        bool *existsp, DynamicBuffer *value, Timer *timer);
 
     std::mutex m_mutex;
     std::condition_variable m_cond;
@@ -729,6 +779,9 @@ namespace Hyperspace {
 
     /// Delivers suspend/resume notifications (e.g. laptop close/open).
     SleepWakeNotifier *m_sleep_wake_notifier;
+
+    /// Client cache (null if disabled)
+    std::unique_ptr<ClientCache> m_cache;
   };
 
   typedef std::shared_ptr<Session> SessionPtr;
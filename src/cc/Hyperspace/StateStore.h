@@ -0,0 +1,318 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Declarations for StateStore.
+ * This file contains declarations for StateStore, the abstract interface to
+ * the storage backend holding the Hyperspace namespace (files, directories
+ * and extended attributes) and the transient session, handle, node, and
+ * event state of the Hyperspace master.
+ */
+
+#ifndef Hyperspace_StateStore_h
+#define Hyperspace_StateStore_h
+
+#include <Hyperspace/DirEntry.h>
+#include <Hyperspace/DirEntryAttr.h>
+
+#include <Common/DynamicBuffer.h>
+#include <Common/String.h>
+
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace Hyperspace {
+
+  /** @addtogroup Hyperspace
+   * @{
+   */
+
+  /// Hash map from Node handle ID to Session ID
+  typedef std::unordered_map<uint64_t, uint64_t> NotificationMap;
+
+  /** Encapsulates a lock request for a file node. */
+  class LockRequest {
+  public:
+    /** Constructor.
+     * @param h Node handle ID
+     * @param m Lock mode
+     */
+    LockRequest(uint64_t h=0, int m=0) : handle(h), mode(m) { return; }
+    /// Node handle ID
+    uint64_t handle;
+    /// Lock mode
+    uint32_t mode;
+  };
+
+  /** Enumeration for object identifier types */
+  enum IdentifierType {
+    SESSION = 0, /**< Session identifier */
+    HANDLE,      /**< Handle identifier */
+    EVENT        /**< Event identifier */
+  };
+
+  /** Transaction on a StateStore.
+   * A transaction is obtained with StateStore::start_transaction() and must
+   * be finished with either commit() or abort().
+   */
+  class StateTxn {
+  public:
+
+    /** Destructor. */
+    virtual ~StateTxn() { }
+
+    /** Commits the transaction.
+     * @param flag Backend specific commit flags
+     */
+    virtual void commit(int flag=0) = 0;
+
+    /** Aborts the transaction, discarding its changes. */
+    virtual void abort() = 0;
+
+    /** Writes human-readable representation of transaction to an ostream.
+     * @param out Output stream on which to write
+     */
+    virtual void display(std::ostream &out) const = 0;
+  };
+
+  /// Smart pointer to StateTxn
+  typedef std::unique_ptr<StateTxn> StateTxnPtr;
+
+  /** Writes human-readable version of <code>txn</code> to an ostream.
+   * @param out Output stream on which to write
+   * @param txn Transaction object to display
+   * @return <code>out</code>
+   */
+  inline std::ostream &operator<<(std::ostream &out, const StateTxn &txn) {
+    txn.display(out);
+    return out;
+  }
+
+  /** Abstract storage backend for the Hyperspace master.
+   * Holds the persistent namespace of files, directories, and extended
+   * attributes, and the transient state of sessions, handles, nodes, and
+   * events.  Every operation takes place within a transaction obtained from
+   * start_transaction().  Operations report errors by throwing Exception.
+   */
+  class StateStore {
+  public:
+
+    /** Destructor. */
+    virtual ~StateStore() { }
+
+    /** Performs periodic maintenance (checkpointing and log cleanup). */
+    virtual void do_checkpoint() = 0;
+
+    /** Check if we're the current master.
+     * @return <i>true</i> if we're the master, <i>false</i> otherwise.
+     */
+    virtual bool is_master() = 0;
+
+    /** Returns hostname of currently elected master.
+     * @return Hostname of the currently elected master.
+     */
+    virtual String get_current_master() = 0;
+
+    /** Creates a new transaction.
+     * @return Newly created transaction
+     */
+    virtual StateTxnPtr start_transaction() = 0;
+
+    /** @name Namespace operations
+     * @{
+     */
+    virtual bool get_xattr_i32(StateTxn &txn, const String &fname,
+                               const String &aname, uint32_t *valuep) = 0;
+    virtual void set_xattr_i32(StateTxn &txn, const String &fname,
+                               const String &aname, uint32_t value) = 0;
+    virtual bool get_xattr_i64(StateTxn &txn, const String &fname,
+                               const String &aname, uint64_t *valuep) = 0;
+    virtual void set_xattr_i64(StateTxn &txn, const String &fname,
+                               const String &aname, uint64_t value) = 0;
+    virtual void set_xattr(StateTxn &txn, const String &fname,
+                           const String &aname, const void *value,
+                           size_t value_len) = 0;
+    virtual bool get_xattr(StateTxn &txn, const String &fname,
+                           const String &aname,
+                           Hypertable::DynamicBuffer &vbuf) = 0;
+    virtual bool incr_attr(StateTxn &txn, const String &fname,
+                           const String &aname, uint64_t *valuep) = 0;
+    virtual bool exists_xattr(StateTxn &txn, const String &fname,
+                              const String &aname) = 0;
+    virtual void del_xattr(StateTxn &txn, const String &fname,
+                           const String &aname) = 0;
+    virtual void mkdir(StateTxn &txn, const String &name) = 0;
+    virtual void unlink(StateTxn &txn, const String &name) = 0;
+    virtual bool exists(StateTxn &txn, String fname, bool *is_dir_p=0) = 0;
+    virtual void create(StateTxn &txn, const String &fname, bool temp) = 0;
+    virtual void get_directory_listing(StateTxn &txn, String fname,
+                                       std::vector<DirEntry> &listing) = 0;
+    virtual void get_directory_attr_listing(StateTxn &txn, String fname,
+                                            const String &aname,
+                                            bool include_sub_entries,
+                                            std::vector<DirEntryAttr> &listing) = 0;
+    virtual void get_directory_attr_listing(StateTxn &txn, String fname,
+                                            const String &aname,
+                                            std::vector<DirEntryAttr> &listing) = 0;
+    virtual void get_all_names(StateTxn &txn, std::vector<String> &names) = 0;
+    virtual bool list_xattr(StateTxn &txn, const String& fname,
+                            std::vector<String> &anames) = 0;
+    /** @} */
+
+    /** @name Event state
+     * @{
+     */
+    virtual void create_event(StateTxn &txn, uint32_t type, uint64_t id,
+                              uint32_t mask) = 0;
+    virtual void create_event(StateTxn &txn, uint32_t type, uint64_t id,
+                              uint32_t mask, const String &name) = 0;
+    virtual void create_event(StateTxn &txn, uint32_t type, uint64_t id,
+                              uint32_t mask, uint32_t mode) = 0;
+    virtual void create_event(StateTxn &txn, uint32_t type, uint64_t id,
+                              uint32_t mask, uint32_t mode,
+                              uint64_t generation) = 0;
+    virtual void delete_event(StateTxn &txn, uint64_t id) = 0;
+    virtual void set_event_notification_handles(StateTxn &txn, uint64_t id,
+                                                const std::vector<uint64_t> &handles) = 0;
+    virtual bool event_exists(StateTxn &txn, uint64_t id) = 0;
+    /** @} */
+
+    /** @name Session state
+     * @{
+     */
+    virtual void create_session(StateTxn &txn, uint64_t id,
+                                const String &addr) = 0;
+    virtual void delete_session(StateTxn &txn, uint64_t id) = 0;
+    virtual void expire_session(StateTxn &txn, uint64_t id) = 0;
+    virtual void add_session_handle(StateTxn &txn, uint64_t id,
+                                    uint64_t handle_id) = 0;
+    virtual void get_session_handles(StateTxn &txn, uint64_t id,
+                                     std::vector<uint64_t> &handles) = 0;
+    virtual bool delete_session_handle(StateTxn &txn, uint64_t id,
+                                       uint64_t handle_id) = 0;
+    virtual bool session_exists(StateTxn &txn, uint64_t id) = 0;
+    virtual String get_session_name(StateTxn &txn, uint64_t id) = 0;
+    virtual void set_session_name(StateTxn &txn, uint64_t id,
+                                  const String &name) = 0;
+    /** @} */
+
+    /** @name Handle state
+     * @{
+     */
+    virtual void create_handle(StateTxn &txn, uint64_t id, String node_name,
+                               uint32_t open_flags, uint32_t event_mask,
+                               uint64_t session_id, bool locked,
+                               uint32_t del_state) = 0;
+    virtual void delete_handle(StateTxn &txn, uint64_t id) = 0;
+    virtual uint32_t get_handle_open_flags(StateTxn &txn, uint64_t id) = 0;
+    virtual void set_handle_del_state(StateTxn &txn, uint64_t id,
+                                      uint32_t del_state) = 0;
+    virtual uint32_t get_handle_del_state(StateTxn &txn, uint64_t id) = 0;
+    virtual void set_handle_open_flags(StateTxn &txn, uint64_t id,
+                                       uint32_t open_flags) = 0;
+    virtual void set_handle_event_mask(StateTxn &txn, uint64_t id,
+                                       uint32_t event_mask) = 0;
+    virtual uint32_t get_handle_event_mask(StateTxn &txn, uint64_t id) = 0;
+    virtual void get_handle_node(StateTxn &txn, uint64_t id,
+                                 String &node_name) = 0;
+    virtual uint64_t get_handle_session(StateTxn &txn, uint64_t id) = 0;
+    virtual void set_handle_locked(StateTxn &txn, uint64_t id,
+                                   bool locked) = 0;
+    virtual bool handle_is_locked(StateTxn &txn, uint64_t id) = 0;
+    virtual bool handle_exists(StateTxn &txn, uint64_t id) = 0;
+    /** @} */
+
+    /** @name Node state
+     * @{
+     */
+    virtual void create_node(StateTxn &txn, const String &name,
+                             bool ephemeral=false, uint64_t lock_generation=0,
+                             uint32_t cur_lock_mode=0,
+                             uint64_t exclusive_handle=0) = 0;
+    virtual void set_node_lock_generation(StateTxn &txn, const String &name,
+                                          uint64_t lock_generation) = 0;
+    virtual uint64_t incr_node_lock_generation(StateTxn &txn,
+                                               const String &name) = 0;
+    virtual void set_node_ephemeral(StateTxn &txn, const String &name,
+                                    bool ephemeral) = 0;
+    virtual bool node_is_ephemeral(StateTxn &txn, const String &name) = 0;
+    virtual void set_node_cur_lock_mode(StateTxn &txn, const String &name,
+                                        uint32_t lock_mode) = 0;
+    virtual uint32_t get_node_cur_lock_mode(StateTxn &txn,
+                                            const String &name) = 0;
+    virtual void set_node_exclusive_lock_handle(StateTxn &txn,
+                                                const String &name,
+                                                uint64_t exclusive_lock_handle) = 0;
+    virtual uint64_t get_node_exclusive_lock_handle(StateTxn &txn,
+                                                    const String &name) = 0;
+    virtual void add_node_handle(StateTxn &txn, const String &name,
+                                 uint64_t handle) = 0;
+    virtual void delete_node_handle(StateTxn &txn, const String &name,
+                                    uint64_t handle) = 0;
+    virtual bool node_has_open_handles(StateTxn &txn, const String &name) = 0;
+    virtual bool node_has_pending_lock_request(StateTxn &txn,
+                                               const String &name) = 0;
+    virtual bool get_node_pending_lock_request(StateTxn &txn,
+                                               const String &name,
+                                               LockRequest &front_req) = 0;
+    virtual void add_node_pending_lock_request(StateTxn &txn,
+                                               const String &name,
+                                               LockRequest &request) = 0;
+    virtual void delete_node_pending_lock_request(StateTxn &txn,
+                                                  const String &name,
+                                                  uint64_t handle) = 0;
+    virtual void add_node_shared_lock_handle(StateTxn &txn, const String &name,
+                                             uint64_t handle) = 0;
+    virtual bool get_node_event_notification_map(StateTxn &txn,
+                                                 const String &name,
+                                                 uint32_t event_mask,
+                                                 NotificationMap &handles_to_sessions) = 0;
+    virtual void get_node_handles(StateTxn &txn, const String &name,
+                                  std::vector<uint64_t> &handles) = 0;
+    virtual void delete_node_shared_lock_handle(StateTxn &txn,
+                                                const String &name,
+                                                uint64_t handle_id) = 0;
+    virtual bool delete_node(StateTxn &txn, const String &name) = 0;
+    virtual bool node_exists(StateTxn &txn, const String &name) = 0;
+    virtual bool node_has_shared_lock_handles(StateTxn &txn,
+                                              const String &name) = 0;
+    /** @} */
+
+    /** Gets the next identifier of a given type.
+     * @param txn Transaction
+     * @param id_type Identifier type
+     * @param increment Advance the identifier if <i>true</i>
+     * @return Next identifier
+     */
+    virtual uint64_t get_next_id_i64(StateTxn &txn, IdentifierType id_type,
+                                     bool increment = false) = 0;
+
+    /// Delimiter between a node name and an attribute name in namespace keys
+    static const char NODE_ATTR_DELIM = 0x01;
+  };
+
+  /** @} */
+
+} // namespace Hyperspace
+
+#endif // Hyperspace_StateStore_h
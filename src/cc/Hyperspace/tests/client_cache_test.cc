@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hyperspace/ClientCache.h>
+
+#include <Common/DynamicBuffer.h>
+#include <Common/Logger.h>
+#include <Common/String.h>
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace Hyperspace;
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  uint64_t generation(ClientCache &cache, const String &name) {
+    uint64_t generation {};
+    HT_ASSERT(cache.get_generation(name, &generation));
+    return generation;
+  }
+
+  HandleCallbackPtr watch(ClientCache &cache, const String &name,
+                          uint64_t handle, const String &parent) {
+    HandleCallbackPtr callback = cache.create_watch_callback(name);
+    uint64_t parent_generation = parent.empty() ? 0 : generation(cache, parent);
+    HT_ASSERT(cache.add_watch(name, handle, callback, parent_generation));
+    return callback;
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  ClientCache cache(5);
+  DynamicBuffer value;
+  bool exists;
+
+  HandleCallbackPtr root = watch(cache, "/", 1, "");
+  HandleCallbackPtr dir = watch(cache, "/a", 2, "/");
+  HandleCallbackPtr file = watch(cache, "/a/b", 3, "/a");
+  HandleCallbackPtr sibling = watch(cache, "/a/b-x", 4, "/a");
+  HandleCallbackPtr child = watch(cache, "/a/b/c", 5, "/a/b");
+  HT_ASSERT(cache.full());
+
+  // a watch opened while the parent changed is rejected
+  HandleCallbackPtr stale = cache.create_watch_callback("/a/d");
+  uint64_t parent_generation = generation(cache, "/a");
+  dir->child_node_added("d");
+  HT_ASSERT(!cache.add_watch("/a/d", 6, stale, parent_generation));
+
+  // attribute values
+  HT_ASSERT(!cache.get_attr("/a/b", "x", &exists, &value));
+  cache.put_attr("/a/b", generation(cache, "/a/b"), "x", true, "hello", 5);
+  HT_ASSERT(cache.get_attr("/a/b", "x", &exists, &value));
+  HT_ASSERT(exists && !strcmp((const char *)value.base, "hello"));
+  cache.put_attr("/a/b", generation(cache, "/a/b"), "y", false, 0, 0);
+  HT_ASSERT(cache.get_attr("/a/b", "y", &exists, &value) && !exists);
+
+  // an invalidation during a fetch fails the insert
+  uint64_t file_generation = generation(cache, "/a/b");
+  file->attr_set("x");
+  HT_ASSERT(!cache.get_attr("/a/b", "x", &exists, &value));
+  cache.put_attr("/a/b", file_generation, "x", true, "stale", 5);
+  HT_ASSERT(!cache.get_attr("/a/b", "x", &exists, &value));
+
+  // existence
+  cache.put_exists("/a/z", generation(cache, "/a"), false);
+  HT_ASSERT(cache.get_exists("/a/z", &exists) && !exists);
+  dir->child_node_added("z");
+  HT_ASSERT(!cache.get_exists("/a/z", &exists));
+  HT_ASSERT(cache.get_exists("/", &exists) && exists);
+
+  // listings, invalidated by attribute events on entries
+  {
+    vector<DirEntryAttr> listing(1), cached;
+    DynamicBuffer buffer(4);
+    buffer.add_unchecked("abc", 3);
+    *buffer.ptr = 0;
+    listing[0].name = "b-x";
+    listing[0].is_dir = false;
+    listing[0].has_attr = true;
+    listing[0].attr = buffer;
+    cache.put_listing("/a", generation(cache, "/a"), "x", listing);
+    HT_ASSERT(cache.get_listing("/a", "x", cached));
+    HT_ASSERT(cached.size() == 1 && cached[0].name == "b-x");
+    HT_ASSERT(cached[0].attr.size == 3 &&
+              !strcmp((const char *)cached[0].attr.base, "abc"));
+    sibling->attr_del("x");
+    HT_ASSERT(!cache.get_listing("/a", "x", cached));
+  }
+
+  // removal drops the subtree, but not nodes that share a name prefix
+  vector<uint64_t> orphans;
+  dir->child_node_removed("b");
+  HT_ASSERT(!cache.get_generation("/a/b", &file_generation));
+  HT_ASSERT(!cache.get_generation("/a/b/c", &file_generation));
+  HT_ASSERT(cache.get_generation("/a/b-x", &file_generation));
+  cache.take_orphans(orphans);
+  HT_ASSERT(orphans.size() == 2 && orphans[0] == 3 && orphans[1] == 5);
+
+  // events for a dropped watch are ignored
+  file->attr_set("x");
+  child->child_node_added("e");
+
+  ClientCache::Stats stats;
+  cache.get_stats(stats);
+  HT_ASSERT(stats.watches == 5 && stats.nodes == 3);
+  HT_ASSERT(stats.invalidations == 5);
+
+  cache.purge();
+  cache.get_stats(stats);
+  HT_ASSERT(stats.nodes == 0);
+
+  cout << "SUCCESS" << endl;
+  return 0;
+}
@@ -0,0 +1,311 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hyperspace/LogStructuredFilesystem.h>
+
+#include <Common/Error.h>
+#include <Common/FileUtils.h>
+#include <Common/Logger.h>
+#include <Common/String.h>
+#include <Common/System.h>
+#include <Common/Init.h>
+#include <Common/Properties.h>
+#include <Common/Config.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+extern "C" {
+#include <unistd.h>
+}
+
+using namespace Hyperspace;
+using namespace Hypertable;
+using namespace Config;
+using namespace std;
+
+namespace {
+
+  /// Checks that an aborted transaction leaves no trace
+  void check_abort(LogStructuredFilesystem *fs) {
+    StateTxnPtr txn = fs->start_transaction();
+    fs->mkdir(*txn, "/abort");
+    fs->set_xattr_i32(*txn, "/foo", "attr1", 1);
+    uint64_t id = fs->get_next_id_i64(*txn, SESSION, true);
+    fs->create_session(*txn, id, "localhost");
+    txn->abort();
+
+    uint32_t ival = 0;
+    txn = fs->start_transaction();
+    HT_ASSERT(!fs->exists(*txn, "/abort"));
+    HT_ASSERT(fs->get_xattr_i32(*txn, "/foo", "attr1", &ival) &&
+              ival == 1234567);
+    HT_ASSERT(fs->get_next_id_i64(*txn, SESSION) == id);
+    HT_ASSERT(!fs->session_exists(*txn, id));
+    txn->commit();
+  }
+
+  /// Checks that a conflicting lock request fails with a deadlock error
+  void check_lock_conflict(LogStructuredFilesystem *fs) {
+    StateTxnPtr holder = fs->start_transaction();
+    fs->create(*holder, "/foo/green", false);
+    StateTxnPtr waiter = fs->start_transaction();
+    try {
+      fs->exists(*waiter, "/foo/green");
+      HT_ASSERT(!"exists() did not time out");
+    }
+    catch (Exception &e) {
+      HT_ASSERT(e.code() == Error::HYPERSPACE_STATEDB_DEADLOCK);
+    }
+    waiter->abort();
+    holder->abort();
+  }
+
+  /// Creates <code>count</code> files, one per transaction
+  void create_files(LogStructuredFilesystem *fs, const String &prefix,
+                    int count, vector<String> &names) {
+    for (int i=0; i<count; i++) {
+      String fname = format("%s%d", prefix.c_str(), i);
+      StateTxnPtr txn = fs->start_transaction();
+      fs->create(*txn, fname, false);
+      txn->commit();
+      names.push_back(fname);
+    }
+  }
+
+  /// Checks that the namespace holds exactly <code>names</code>
+  void check_names(LogStructuredFilesystem *fs, const vector<String> &names) {
+    vector<String> recovered;
+    StateTxnPtr txn = fs->start_transaction();
+    fs->get_all_names(*txn, recovered);
+    txn->commit();
+    HT_ASSERT(recovered == names);
+  }
+
+}
+
+int main(int argc, char **argv) {
+  LogStructuredFilesystem *log_fs;
+  FILE *fp;
+  int ret = 0;
+  bool isdir;
+  PropertiesPtr props = make_shared<Properties>();
+  init_with_policy<DefaultPolicy>(argc, argv);
+
+  System::initialize(System::locate_install_dir(argv[0]));
+
+  fp = fopen("./log_fs_test.output", "w");
+
+  String filename = format("/tmp/log_fs_test%d", (int)getpid());
+  FileUtils::mkdirs(filename);
+
+  props->set("Hyperspace.Checkpoint.Size", 1000000);
+  props->set("Hyperspace.LogGc.Interval", 3600000);
+  props->set("Hyperspace.LogGc.MaxUnusedLogs", 200);
+
+  log_fs = new LogStructuredFilesystem(props, filename);
+
+  StateTxnPtr txn_ptr = log_fs->start_transaction();
+  StateTxn &txn = *txn_ptr;
+
+  try {
+    std::vector<String> listing;
+    std::vector<DirEntry> dir_listing;
+
+    log_fs->mkdir(txn, "/dir1");
+    log_fs->create(txn, "/dir1/foo", false);
+    log_fs->set_xattr_i32(txn, "/dir1/foo", "lock.generation", 2);
+    log_fs->unlink(txn, "/dir1/foo");
+    log_fs->get_directory_listing(txn, "/dir1", dir_listing);
+
+    if (!dir_listing.empty())
+      fprintf(fp, "/dir1 not empty\n");
+
+    try {
+      log_fs->mkdir(txn, "/foo/bar");
+    }
+    catch (Exception &e) {
+      fprintf(fp, "%s %s\n", Error::get_text(e.code()), e.what());
+    }
+
+    log_fs->mkdir(txn, "/foo");
+    log_fs->mkdir(txn, "/foo/bar");
+    log_fs->mkdir(txn, "/foo/bar1");
+
+    if (!log_fs->exists(txn, "/how", &isdir))
+      fprintf(fp, "\"/how\" does not exist\n");
+
+    if (log_fs->exists(txn, "/foo", &isdir)) {
+      fprintf(fp, "\"/foo\" exists, and is ");
+      if (!isdir)
+        fprintf(fp, "not ");
+      fprintf(fp, "a directory\n");
+    }
+
+    uint32_t ival = 1234567;
+    uint64_t lval = 1234567890L;
+
+    log_fs->set_xattr_i32(txn, "/foo", "attr1", ival);
+    log_fs->set_xattr_i64(txn, "/foo", "attr2", lval);
+
+    std::vector<std::string> anames;
+    std::vector<std::string>::const_iterator attrit;
+    log_fs->list_xattr(txn, "/foo", anames);
+
+    for (attrit = anames.begin(); attrit != anames.end(); ++attrit) {
+      fprintf(fp, "Attribute: '%s'\n", (*attrit).c_str());
+    }
+
+    String attr = "attr1";
+    String fname = "/foo";
+
+    if (!log_fs->exists_xattr(txn, fname, attr)) {
+      fprintf(fp, "Attribute: '%s' does not exist for file '%s'\n", attr.c_str(), fname.c_str());
+    }
+    else {
+      fprintf(fp, "Attribute: '%s' does exist for file '%s'\n", attr.c_str(), fname.c_str());
+    }
+
+    attr = "attrXYZ";
+    if (!log_fs->exists_xattr(txn, fname, attr)) {
+      fprintf(fp, "Attribute: '%s' does not exists for file '%s'\n", attr.c_str(), fname.c_str());
+    }
+    else {
+      fprintf(fp, "Attribute: '%s' does exist for file '%s'\n", attr.c_str(), fname.c_str());
+    }
+
+    ival = 0;
+    lval = 0;
+
+    if (log_fs->get_xattr_i32(txn, "/foo", "attr1", &ival))
+      fprintf(fp, "Attribute \"attr1\" of directory \"/foo\" is %u\n", ival);
+
+    if (log_fs->get_xattr_i64(txn, "/foo", "attr2", &lval))
+      fprintf(fp, "Attribute \"attr2\" of directory \"/foo\" is %llu\n",
+              (long long unsigned int)lval);
+
+    if (log_fs->get_xattr_i32(txn, "/foo", "attr3", &ival))
+      fprintf(fp, "Attribute \"attr3\" of directory \"/foo\" is %u\n", ival);
+
+    try {
+      log_fs->create(txn, "/green/dog", false);
+    }
+    catch (Exception &e) {
+      fprintf(fp, "%s %s\n", Error::get_text(e.code()), e.what());
+    }
+
+    log_fs->create(txn, "/foo/red", false);
+    log_fs->create(txn, "/foo/yellow", true);
+
+    log_fs->get_directory_listing(txn, "/foo", dir_listing);
+
+    for (size_t i=0; i<dir_listing.size(); i++) {
+      fprintf(fp, "%s", dir_listing[i].name.c_str());
+      if (dir_listing[i].is_dir)
+        fwrite("/", 1, 1, fp);
+      fwrite("\n", 1, 1, fp);
+    }
+
+    try {
+      log_fs->get_directory_listing(txn, "/foo/red", dir_listing);
+    }
+    catch (Exception &e) {
+      fprintf(fp, "%s %s\n", Error::get_text(e.code()), e.what());
+    }
+
+    try {
+      log_fs->unlink(txn, "/foo");
+    }
+    catch (Exception &e) {
+      fprintf(fp, "%s %s\n", Error::get_text(e.code()), e.what());
+    }
+
+    log_fs->get_all_names(txn, listing);
+
+    for (size_t i=0; i<listing.size(); i++) {
+      fwrite(listing[i].c_str(), 1, listing[i].length(), fp);
+      fwrite("\n", 1, 1, fp);
+    }
+
+    log_fs->unlink(txn, "/foo/bar");
+    log_fs->unlink(txn, "/foo/red");
+
+    for (size_t i=0; i<listing.size(); i++) {
+      fwrite(listing[i].c_str(), 1, listing[i].length(), fp);
+      fwrite("\n", 1, 1, fp);
+    }
+
+    fclose(fp);
+
+    txn.commit(0);
+
+    vector<String> names;
+    StateTxnPtr names_txn = log_fs->start_transaction();
+    log_fs->get_all_names(*names_txn, names);
+    names_txn->commit();
+
+    check_abort(log_fs);
+    check_lock_conflict(log_fs);
+    delete log_fs;
+
+    // Recover from the log alone
+    log_fs = new LogStructuredFilesystem(props, filename);
+    check_names(log_fs, names);
+
+    // Recover from a snapshot followed by more log records
+    delete log_fs;
+    props->set("Hyperspace.Checkpoint.Size", 1000);
+    log_fs = new LogStructuredFilesystem(props, filename);
+    create_files(log_fs, "/dir1/a", 50, names);
+    log_fs->do_checkpoint();
+    create_files(log_fs, "/dir1/b", 10, names);
+    sort(names.begin(), names.end());
+    delete log_fs;
+    log_fs = new LogStructuredFilesystem(props, filename);
+    check_names(log_fs, names);
+    delete log_fs;
+  }
+  catch (Exception &e) {
+    txn.abort();
+    if (e.what())
+      HT_ERRORF("Caught exception: %s - %s", Error::get_text(e.code()),
+                e.what());
+    else
+      HT_ERRORF("Caught exception: %s", Error::get_text(e.code()));
+    ret = 1;
+  }
+
+  std::string command = std::string("/bin/rm -rf ") + filename;
+
+  HT_ASSERT(system(command.c_str()) == 0);
+
+  command = "diff log_fs_test.output bdb_fs_test.golden";
+  if (system(command.c_str()) != 0)
+    ret = 1;
+
+  return ret;
+
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hyperspace/BerkeleyDbFilesystem.h>
+#include <Hyperspace/LogStructuredFilesystem.h>
+
+#include <Common/Error.h>
+#include <Common/FileUtils.h>
+#include <Common/Logger.h>
+#include <Common/Properties.h>
+#include <Common/Random.h>
+#include <Common/Stopwatch.h>
+#include <Common/String.h>
+#include <Common/Thread.h>
+#include <Common/Usage.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <unistd.h>
+}
+
+using namespace Hyperspace;
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *usage[] = {
+    "usage: state_store_benchmark [options]",
+    "",
+    "  --store=<name>        State store, berkeleydb or log (default log)",
+    "  --threads=<n>         Number of client threads (default 16)",
+    "  --files=<n>           Files created per thread (default 200)",
+    "  --dir=<path>          Base directory (default /tmp/state_store_benchmarkPID)",
+    "",
+    "  This program measures Hyperspace state store throughput.  Each thread",
+    "  replays the transactions the Hyperspace master runs for an",
+    "  HsCommandInterpreter session that does, for each of <files> files,",
+    "  mkdir, open with create, attrset, attrget, lock, release, close, and",
+    "  delete, plus one readdir per ten files.  It reports the number of",
+    "  transactions per second.  Run it once with --store=berkeleydb and once",
+    "  with --store=log on the same disk to compare the stores.",
+    (const char *)0
+  };
+
+  /// Runs <code>func</code> in a transaction, retrying on deadlock.
+  template <typename FuncT>
+  void run_txn(StateStore *fs, FuncT func) {
+    while (true) {
+      StateTxnPtr txn = fs->start_transaction();
+      try {
+        func(*txn);
+        txn->commit();
+        return;
+      }
+      catch (Exception &e) {
+        txn->abort();
+        if (e.code() != Error::HYPERSPACE_BERKELEYDB_DEADLOCK &&
+            e.code() != Error::HYPERSPACE_STATEDB_DEADLOCK)
+          throw;
+        this_thread::sleep_for(Random::duration_millis(10));
+      }
+    }
+  }
+
+  void client(StateStore *fs, int thread_num, int files, size_t *txnsp) {
+    String dir = format("/bench%d", thread_num);
+    uint64_t session_id {};
+    size_t txns = 0;
+
+    run_txn(fs, [&](StateTxn &txn) {
+        session_id = fs->get_next_id_i64(txn, SESSION, true);
+        fs->create_session(txn, session_id, "127.0.0.1:0");
+        fs->mkdir(txn, dir);
+      });
+    txns++;
+
+    for (int i=0; i<files; i++) {
+      String fname = format("%s/file%d", dir.c_str(), i);
+      uint64_t handle {};
+      uint32_t ival;
+      uint64_t generation;
+
+      // open with create
+      run_txn(fs, [&](StateTxn &txn) {
+          fs->exists(txn, fname);
+          fs->create(txn, fname, false);
+          fs->set_xattr_i64(txn, fname, "lock.generation", 0);
+          fs->create_node(txn, fname);
+          handle = fs->get_next_id_i64(txn, HANDLE, true);
+          fs->create_handle(txn, handle, fname, 0x1F, 0, session_id, false, 0);
+          fs->add_session_handle(txn, session_id, handle);
+          fs->add_node_handle(txn, fname, handle);
+        });
+
+      // attrset
+      run_txn(fs, [&](StateTxn &txn) {
+          fs->set_xattr_i32(txn, fname, "value", (uint32_t)i);
+        });
+
+      // attrget
+      run_txn(fs, [&](StateTxn &txn) {
+          fs->get_xattr_i32(txn, fname, "value", &ival);
+        });
+
+      // lock
+      run_txn(fs, [&](StateTxn &txn) {
+          HT_ASSERT(fs->incr_attr(txn, fname, "lock.generation", &generation));
+          fs->set_node_cur_lock_mode(txn, fname, 2);
+          fs->set_node_exclusive_lock_handle(txn, fname, handle);
+          fs->set_handle_locked(txn, handle, true);
+        });
+
+      // release
+      run_txn(fs, [&](StateTxn &txn) {
+          fs->set_node_cur_lock_mode(txn, fname, 0);
+          fs->set_node_exclusive_lock_handle(txn, fname, 0);
+          fs->set_handle_locked(txn, handle, false);
+        });
+
+      // close
+      run_txn(fs, [&](StateTxn &txn) {
+          fs->delete_node_handle(txn, fname, handle);
+          fs->delete_session_handle(txn, session_id, handle);
+          fs->delete_handle(txn, handle);
+          fs->delete_node(txn, fname);
+        });
+
+      // delete
+      run_txn(fs, [&](StateTxn &txn) {
+          fs->unlink(txn, fname);
+        });
+      txns += 7;
+
+      if ((i % 10) == 9) {
+        run_txn(fs, [&](StateTxn &txn) {
+            vector<DirEntry> listing;
+            fs->get_directory_listing(txn, dir, listing);
+          });
+        txns++;
+      }
+    }
+
+    run_txn(fs, [&](StateTxn &txn) {
+        fs->unlink(txn, dir);
+        fs->delete_session(txn, session_id);
+      });
+    txns++;
+
+    *txnsp = txns;
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  String store = "log";
+  int thread_count = 16;
+  int files = 200;
+  String dir = format("/tmp/state_store_benchmark%d", (int)getpid());
+
+  for (int i=1; i<argc; i++) {
+    if (!strncmp(argv[i], "--store=", 8))
+      store = &argv[i][8];
+    else if (!strncmp(argv[i], "--threads=", 10))
+      thread_count = atoi(&argv[i][10]);
+    else if (!strncmp(argv[i], "--files=", 8))
+      files = atoi(&argv[i][8]);
+    else if (!strncmp(argv[i], "--dir=", 6))
+      dir = &argv[i][6];
+    else
+      Usage::dump_and_exit(usage);
+  }
+
+  if (store != "log" && store != "berkeleydb")
+    Usage::dump_and_exit(usage);
+
+  PropertiesPtr props = make_shared<Properties>();
+  props->set("Hyperspace.Checkpoint.Size", 1000000);
+  props->set("Hyperspace.LogGc.Interval", 3600000);
+  props->set("Hyperspace.LogGc.MaxUnusedLogs", 200);
+
+  FileUtils::mkdirs(dir);
+
+  try {
+    unique_ptr<StateStore> fs;
+    vector<size_t> txns(thread_count);
+    vector<thread> threads;
+
+    if (store == "log")
+      fs.reset(new LogStructuredFilesystem(props, dir));
+    else {
+      vector<Thread::id> thread_ids;
+      thread_ids.push_back(ThisThread::get_id());
+      fs.reset(new BerkeleyDbFilesystem(props, dir, thread_ids));
+    }
+
+    Stopwatch stopwatch;
+    for (int i=0; i<thread_count; i++)
+      threads.push_back(thread(client, fs.get(), i, files, &txns[i]));
+    for (auto &t : threads)
+      t.join();
+    stopwatch.stop();
+
+    size_t total = 0;
+    for (auto n : txns)
+      total += n;
+
+    cout << store << ": " << thread_count << " threads, " << total
+         << " transactions in " << stopwatch.elapsed() << " s, "
+         << (double)total / stopwatch.elapsed() << " transactions/s" << endl;
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  String command = String("/bin/rm -rf ") + dir;
+  HT_ASSERT(system(command.c_str()) == 0);
+
+  return 0;
+}
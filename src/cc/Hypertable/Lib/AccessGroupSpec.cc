@@ -46,7 +46,7 @@ namespace {
   bool desc_inited = false;
 
   PropertiesDesc
-  compressor_desc("  bmz|lzo|quicklz|zlib|snappy|none [compressor_options]\n\n"
+  compressor_desc("  bmz|lzo|quicklz|zlib|snappy|zstd|none [compressor_options]\n\n"
                   "compressor_options"),
     bloomfilter_desc("  rows|rows+cols|none [bloomfilter_options]\n\n"
                       "  Default bloom filter is defined by the config property:\n"
@@ -67,10 +67,13 @@ namespace {
       ("normal", "Normal setting for zlib")
       ("fp-len", i16()->default_value(19), "Minimum fingerprint length for bmz")
       ("offset", i16()->default_value(0), "Starting fingerprint offset for bmz")
+      ("level", i32()->default_value(3), "Compression level for zstd")
+      ("dict-size", i32()->default_value(16384), "Trained dictionary size "
+       "for zstd (0 disables dictionaries)")
       ;
     compressor_hidden_desc.add_options()
       ("compressor-type", str(), 
-       "Compressor type (bmz|lzo|quicklz|zlib|snappy|none)")
+       "Compressor type (bmz|lzo|quicklz|zlib|snappy|zstd|none)")
       ;
     compressor_pos_desc.add("compressor-type", 1);
 
@@ -130,6 +133,25 @@ namespace {
     }
   }
 
+  void validate_cell_cache(const std::string &cell_cache) {
+    if (cell_cache.empty())
+      return;
+    if (strcasecmp(cell_cache.c_str(), "map") &&
+        strcasecmp(cell_cache.c_str(), "skiplist"))
+      HT_THROWF(Error::SCHEMA_PARSE_ERROR, "Invalid cell cache spec - %s",
+                cell_cache.c_str());
+  }
+
+  void validate_key_encoding(const std::string &key_encoding) {
+    if (key_encoding.empty())
+      return;
+    if (strcasecmp(key_encoding.c_str(), "prefix") &&
+        strcasecmp(key_encoding.c_str(), "delta") &&
+        strcasecmp(key_encoding.c_str(), "columnar"))
+      HT_THROWF(Error::SCHEMA_PARSE_ERROR, "Invalid key encoding spec - %s",
+                key_encoding.c_str());
+  }
+
 } // local namespace
 
 
@@ -180,6 +202,26 @@ bool AccessGroupOptions::is_set_in_memory() const {
   return m_isset.test(IN_MEMORY);
 }
 
+void AccessGroupOptions::set_cell_cache(const std::string &cell_cache) {
+  validate_cell_cache(cell_cache);
+  m_cell_cache = cell_cache;
+  m_isset.set(CELL_CACHE);
+}
+
+bool AccessGroupOptions::is_set_cell_cache() const {
+  return m_isset.test(CELL_CACHE);
+}
+
+void AccessGroupOptions::set_key_encoding(const std::string &key_encoding) {
+  validate_key_encoding(key_encoding);
+  m_key_encoding = key_encoding;
+  m_isset.set(KEY_ENCODING);
+}
+
+bool AccessGroupOptions::is_set_key_encoding() const {
+  return m_isset.test(KEY_ENCODING);
+}
+
 void AccessGroupOptions::merge(const AccessGroupOptions &other) {
   if (!is_set_replication() && other.is_set_replication())
     set_replication(other.get_replication());
@@ -191,6 +233,10 @@ void AccessGroupOptions::merge(const AccessGroupOptions &other) {
     set_bloom_filter(other.get_bloom_filter());
   if (!is_set_in_memory() && other.is_set_in_memory())
     set_in_memory(other.get_in_memory());
+  if (!is_set_cell_cache() && other.is_set_cell_cache())
+    set_cell_cache(other.get_cell_cache());
+  if (!is_set_key_encoding() && other.is_set_key_encoding())
+    set_key_encoding(other.get_key_encoding());
 }
 
 namespace {
@@ -211,6 +257,10 @@ namespace {
         m_options->set_bloom_filter(content);
       else if (!strcasecmp(name, "InMemory"))
         m_options->set_in_memory(content_to_bool(name, content));
+      else if (!strcasecmp(name, "CellCache"))
+        m_options->set_cell_cache(content);
+      else if (!strcasecmp(name, "KeyEncoding"))
+        m_options->set_key_encoding(content);
       else if (!m_element_stack.empty())
         HT_THROWF(Error::SCHEMA_PARSE_ERROR,
                   "Unrecognized AccessGroup option element (%s)", name);
@@ -243,6 +293,12 @@ const std::string AccessGroupOptions::render_xml(const std::string &line_prefix)
   if (is_set_in_memory())
     xstr += format("%s<InMemory>%s</InMemory>\n",
                    line_prefix.c_str(), m_in_memory ? "true" : "false");
+  if (is_set_cell_cache())
+    xstr += format("%s<CellCache>%s</CellCache>\n",
+                   line_prefix.c_str(), m_cell_cache.c_str());
+  if (is_set_key_encoding())
+    xstr += format("%s<KeyEncoding>%s</KeyEncoding>\n",
+                   line_prefix.c_str(), m_key_encoding.c_str());
   return xstr;
 }
 
@@ -258,6 +314,10 @@ const std::string AccessGroupOptions::render_hql() const {
     hstr += format(" BLOOMFILTER \"%s\"", m_bloomfilter.c_str());
   if (is_set_in_memory())
     hstr += format(" IN_MEMORY %s", m_in_memory ? "true" : "false");
+  if (is_set_cell_cache())
+    hstr += format(" CELLCACHE \"%s\"", m_cell_cache.c_str());
+  if (is_set_key_encoding())
+    hstr += format(" KEYENCODING \"%s\"", m_key_encoding.c_str());
   return hstr;
 }
 
@@ -267,7 +327,9 @@ bool AccessGroupOptions::operator==(const AccessGroupOptions &other) const {
           m_blocksize == other.m_blocksize &&
           m_compressor == other.m_compressor &&
           m_bloomfilter == other.m_bloomfilter &&
-          m_in_memory == other.m_in_memory);
+          m_in_memory == other.m_in_memory &&
+          m_cell_cache == other.m_cell_cache &&
+          m_key_encoding == other.m_key_encoding);
 }
 
 
@@ -406,6 +468,28 @@ bool AccessGroupSpec::get_option_in_memory() const {
   return m_options.get_in_memory();
 }
 
+void AccessGroupSpec::set_option_cell_cache(const std::string &cell_cache) {
+  if (!m_options.is_set_cell_cache() ||
+      m_options.get_cell_cache() != cell_cache)
+    m_generation = 0;
+  m_options.set_cell_cache(cell_cache);
+}
+
+const std::string &AccessGroupSpec::get_option_cell_cache() const {
+  return m_options.get_cell_cache();
+}
+
+void AccessGroupSpec::set_option_key_encoding(const std::string &key_encoding) {
+  if (!m_options.is_set_key_encoding() ||
+      m_options.get_key_encoding() != key_encoding)
+    m_generation = 0;
+  m_options.set_key_encoding(key_encoding);
+}
+
+const std::string &AccessGroupSpec::get_option_key_encoding() const {
+  return m_options.get_key_encoding();
+}
+
 void AccessGroupSpec::set_default_max_versions(int32_t max_versions) {
   if (!m_defaults.is_set_max_versions() ||
       m_defaults.get_max_versions() != max_versions)
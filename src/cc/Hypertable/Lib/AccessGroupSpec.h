@@ -66,6 +66,10 @@ namespace Hypertable {
       BLOOMFILTER,
       /// <i>in memory</i> bit
       IN_MEMORY,
+      /// <i>cell cache</i> bit
+      CELL_CACHE,
+      /// <i>key encoding</i> bit
+      KEY_ENCODING,
       /// Total bit count
       MAX
     };
@@ -113,6 +117,7 @@ namespace Hypertable {
     ///   quicklz
     ///   zlib [--best|--9|--normal]
     ///   snappy
+    ///   zstd [--level &lt;int&gt;] [--dict-size &lt;int&gt;]
     ///   none
     /// </pre>
     /// @param compressor Compressor specification
@@ -178,6 +183,55 @@ namespace Hypertable {
     /// otherwise.
     bool is_set_in_memory() const;
 
+    /// Sets <i>cell cache</i> option.
+    /// Sets the CELL_CACHE bit of #m_isset, validates the specification given
+    /// in the <code>cell_cache</code> argument, and if it is valid, sets
+    /// #m_cell_cache to <code>cell_cache</code>.  The following cell cache
+    /// specifications are valid:
+    /// <pre>
+    ///   map
+    ///   skiplist
+    /// </pre>
+    /// @param cell_cache Cell cache specification
+    /// @throws Exception with code set to Error::SCHEMA_PARSE_ERROR
+    /// if cell cache specification is invalid
+    void set_cell_cache(const std::string &cell_cache);
+
+    /// Gets <i>cell cache</i> option.
+    /// @return <i>cell cache</i> option.
+    const std::string &get_cell_cache() const { return m_cell_cache; }
+
+    /// Checks if <i>cell cache</i> option is set.
+    /// This method returns the value of the CELL_CACHE bit of #m_isset.
+    /// @return <i>true</i> if <i>cell cache</i> option is set, <i>false</i>
+    /// otherwise.
+    bool is_set_cell_cache() const;
+
+    /// Sets <i>key encoding</i> option.
+    /// Sets the KEY_ENCODING bit of #m_isset, validates the specification
+    /// given in the <code>key_encoding</code> argument, and if it is valid,
+    /// sets #m_key_encoding to <code>key_encoding</code>.  The following key
+    /// encoding specifications are valid:
+    /// <pre>
+    ///   prefix
+    ///   delta
+    ///   columnar
+    /// </pre>
+    /// @param key_encoding Key encoding specification
+    /// @throws Exception with code set to Error::SCHEMA_PARSE_ERROR
+    /// if key encoding specification is invalid
+    void set_key_encoding(const std::string &key_encoding);
+
+    /// Gets <i>key encoding</i> option.
+    /// @return <i>key encoding</i> option.
+    const std::string &get_key_encoding() const { return m_key_encoding; }
+
+    /// Checks if <i>key encoding</i> option is set.
+    /// This method returns the value of the KEY_ENCODING bit of #m_isset.
+    /// @return <i>true</i> if <i>key encoding</i> option is set, <i>false</i>
+    /// otherwise.
+    bool is_set_key_encoding() const;
+
     /// Merges options from another AccessGroupOptions object.
     /// For each option that is not set, if the corresponding option in the
     /// <code>other</code> parameter is set, then the option is set to
@@ -311,6 +365,12 @@ namespace Hypertable {
     /// In memory
     bool m_in_memory {};
 
+    /// Cell cache specification
+    std::string m_cell_cache;
+
+    /// Key encoding specification
+    std::string m_key_encoding;
+
     /// Bit mask describing which options are set
     std::bitset<MAX> m_isset;
   };
@@ -418,6 +478,31 @@ namespace Hypertable {
     /// @return <i>in memory</i> option.
     bool get_option_in_memory() const;
 
+    /// Sets <i>cell cache</i> option.
+    /// Sets the <i>cell cache</i> option of the #m_options member to
+    /// <code>cell_cache</code> by calling AccessGroupOptions::set_cell_cache().
+    /// @param cell_cache Cell cache specification
+    /// @throws Exception with code set to Error::SCHEMA_PARSE_ERROR
+    /// if cell cache specification is invalid
+    void set_option_cell_cache(const std::string &cell_cache);
+
+    /// Gets <i>cell cache</i> option.
+    /// @return <i>cell cache</i> option.
+    const std::string &get_option_cell_cache() const;
+
+    /// Sets <i>key encoding</i> option.
+    /// Sets the <i>key encoding</i> option of the #m_options member to
+    /// <code>key_encoding</code> by calling
+    /// AccessGroupOptions::set_key_encoding().
+    /// @param key_encoding Key encoding specification
+    /// @throws Exception with code set to Error::SCHEMA_PARSE_ERROR
+    /// if key encoding specification is invalid
+    void set_option_key_encoding(const std::string &key_encoding);
+
+    /// Gets <i>key encoding</i> option.
+    /// @return <i>key encoding</i> option.
+    const std::string &get_option_key_encoding() const;
+
     /// Sets default <i>max versions</i> column family option.
     /// Sets <i>max versions</i> option in the column family default structure,
     /// #m_defaults, to <code>max_versions</code>
@@ -56,12 +56,34 @@ namespace Hypertable {
       LZO=3,      ///< LZO compression
       QUICKLZ=4,  ///< QuickLZ 1.5 compession
       SNAPPY=5,   ///< Snappy compression
-      COMPRESSION_TYPE_LIMIT=6  ///< Limit of compression types
+      ZSTD=6,     ///< Zstandard compression
+      COMPRESSION_TYPE_LIMIT=7  ///< Limit of compression types
     };
 
     /// Compression codec argument vector.
     typedef std::vector<String> Args;
 
+    /// Trained compression dictionary.
+    /// Codecs that support dictionaries derive from this class to hold the
+    /// dictionary in the form they use for compression and decompression, so
+    /// that a single dictionary can be shared by many codec instances.
+    class Dictionary {
+    public:
+      /// Destructor.
+      virtual ~Dictionary() { }
+
+      /// Returns serialized dictionary.
+      /// @return Dictionary bytes to be passed to load_dictionary()
+      virtual const String &data() const = 0;
+
+      /// Returns memory used by dictionary.
+      /// @return Memory used, in bytes
+      virtual size_t memory_used() const = 0;
+    };
+
+    /// Smart pointer to Dictionary
+    typedef std::shared_ptr<Dictionary> DictionaryPtr;
+
     /// Returns string mnemonic for compression type.
     /// @param algo Compression type (see BlockCompressionCodec::Type)
     /// @return %String mnemonic representing name of compression algorithm
@@ -97,6 +119,44 @@ namespace Hypertable {
                   arg.c_str());
     }
 
+    /// Returns amount of sample data wanted for training a dictionary.
+    /// Codecs that do not use dictionaries, or that have been configured not
+    /// to, return 0.
+    /// @return Number of sample bytes to pass to train_dictionary()
+    virtual size_t dictionary_training_size() { return 0; }
+
+    /// Trains a dictionary.
+    /// @param samples Sample blocks, back to back
+    /// @param sample_sizes Length of each sample block
+    /// @return Trained dictionary, or null if training failed
+    virtual DictionaryPtr train_dictionary(const uint8_t *samples,
+                                           const std::vector<size_t> &sample_sizes) {
+      return DictionaryPtr();
+    }
+
+    /// Loads a serialized dictionary.
+    /// @param data Dictionary bytes returned by Dictionary::data()
+    /// @param len Length of dictionary
+    /// @return Loaded dictionary
+    /// @throws Exception Code set to Error::BLOCK_COMPRESSOR_UNSUPPORTED_TYPE
+    /// if codec does not support dictionaries
+    virtual DictionaryPtr load_dictionary(const uint8_t *data, size_t len) {
+      HT_THROWF(Error::BLOCK_COMPRESSOR_UNSUPPORTED_TYPE, "%s codec does not "
+                "support dictionaries", get_compressor_name(get_type()));
+    }
+
+    /// Sets dictionary used by subsequent calls to deflate() and inflate().
+    /// @param dictionary Dictionary obtained from a codec of the same type, or
+    /// null to stop using a dictionary
+    /// @throws Exception Code set to Error::BLOCK_COMPRESSOR_UNSUPPORTED_TYPE
+    /// if <code>dictionary</code> is not null and codec does not support
+    /// dictionaries
+    virtual void set_dictionary(const DictionaryPtr &dictionary) {
+      if (dictionary)
+        HT_THROWF(Error::BLOCK_COMPRESSOR_UNSUPPORTED_TYPE, "%s codec does "
+                  "not support dictionaries", get_compressor_name(get_type()));
+    }
+
     /// Returns compression type enum.
     /// Returns the enum value that represents the compressoion type
     /// @see BlockCompressionCodec::Type
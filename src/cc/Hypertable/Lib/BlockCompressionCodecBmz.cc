@@ -93,8 +93,8 @@ BlockCompressionCodecBmz::deflate(const DynamicBuffer &input,
     header.set_data_length(inlen);
     header.set_data_zlength(outlen);
   }
-  header.set_data_checksum(fletcher32(output.base + headerlen,
-                                      header.get_data_zlength()));
+  header.set_data_checksum(header.compute_data_checksum(
+      output.base + headerlen, header.get_data_zlength()));
   output.ptr = output.base;
   header.encode(&output.ptr);
   output.ptr += header.get_data_zlength();
@@ -110,7 +110,8 @@ BlockCompressionCodecBmz::inflate(const DynamicBuffer &input,
   header.decode(&ip, &remain);
   HT_EXPECT(header.get_data_zlength() <= remain,
             Error::BLOCK_COMPRESSOR_BAD_HEADER);
-  HT_EXPECT(header.get_data_checksum() == fletcher32(ip, header.get_data_zlength()),
+  HT_EXPECT(header.get_data_checksum() ==
+            header.compute_data_checksum(ip, header.get_data_zlength()),
             Error::BLOCK_COMPRESSOR_CHECKSUM_MISMATCH);
 
   size_t outlen = header.get_data_length();
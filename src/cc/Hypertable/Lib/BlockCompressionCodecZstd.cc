@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for BlockCompressionCodecZstd.
+/// This file contains definitions for BlockCompressionCodecZstd, a class
+/// for compressing blocks using the Zstandard compression algorithm.
+
+#include <Common/Compat.h>
+
+#include "BlockCompressionCodecZstd.h"
+
+#include <Common/DynamicBuffer.h>
+#include <Common/Logger.h>
+
+#include <zdict.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+  /// Maximum size of a dictionary training sample
+  const size_t MAX_SAMPLE_SIZE = 4096;
+}
+
+#define _NEXT_ARG(_code_) do { \
+  ++it; \
+  HT_EXPECT(it != arg_end, Error::BLOCK_COMPRESSOR_INVALID_ARG); \
+  _code_; \
+} while (0)
+
+
+BlockCompressionCodecZstd::ZstdDictionary::ZstdDictionary(const void *data,
+                                                          size_t len)
+  : m_data((const char *)data, len) {
+  m_id = ZDICT_getDictID(m_data.data(), m_data.length());
+  if (m_id == 0)
+    HT_THROW(Error::BLOCK_COMPRESSOR_INIT_ERROR, "Invalid zstd dictionary");
+  m_ddict = ZSTD_createDDict(m_data.data(), m_data.length());
+  if (m_ddict == 0)
+    HT_THROW(Error::BLOCK_COMPRESSOR_INIT_ERROR,
+             "Unable to load zstd dictionary");
+}
+
+
+BlockCompressionCodecZstd::ZstdDictionary::~ZstdDictionary() {
+  ZSTD_freeDDict(m_ddict);
+}
+
+
+size_t BlockCompressionCodecZstd::ZstdDictionary::memory_used() const {
+  return sizeof(ZstdDictionary) + m_data.capacity() +
+    ZSTD_sizeof_DDict(m_ddict);
+}
+
+
+BlockCompressionCodecZstd::BlockCompressionCodecZstd(const Args &args) {
+  set_args(args);
+}
+
+
+BlockCompressionCodecZstd::~BlockCompressionCodecZstd() {
+  ZSTD_freeCDict(m_cdict);
+  ZSTD_freeCCtx(m_cctx);
+  ZSTD_freeDCtx(m_dctx);
+}
+
+
+void BlockCompressionCodecZstd::set_args(const Args &args) {
+  Args::const_iterator it = args.begin(), arg_end = args.end();
+
+  for (; it != arg_end; ++it) {
+    if (*it == "--level") {
+      _NEXT_ARG(m_level = atoi((*it).c_str()));
+      if (m_level < 1 || m_level > ZSTD_maxCLevel())
+        HT_THROWF(Error::BLOCK_COMPRESSOR_INVALID_ARG, "Invalid zstd "
+                  "compression level: %d", m_level);
+      // the compression dictionary is digested for a particular level
+      ZSTD_freeCDict(m_cdict);
+      m_cdict = 0;
+    }
+    else if (*it == "--dict-size")
+      _NEXT_ARG(m_dict_size = strtoul((*it).c_str(), 0, 0));
+    else
+      HT_THROWF(Error::BLOCK_COMPRESSOR_INVALID_ARG, "Unrecognized argument "
+                "to Zstd codec: '%s'", (*it).c_str());
+  }
+}
+
+
+void
+BlockCompressionCodecZstd::deflate(const DynamicBuffer &input,
+    DynamicBuffer &output, BlockHeader &header, size_t reserve) {
+  size_t avail_out = ZSTD_compressBound(input.fill());
+  size_t zlen;
+
+  if (m_cctx == 0 && (m_cctx = ZSTD_createCCtx()) == 0)
+    HT_THROW(Error::BLOCK_COMPRESSOR_INIT_ERROR,
+             "Unable to create zstd compression context");
+
+  output.clear();
+  output.reserve(header.encoded_length() + avail_out + reserve);
+
+  if (m_dictionary) {
+    if (m_cdict == 0) {
+      m_cdict = ZSTD_createCDict(m_dictionary->m_data.data(),
+                                 m_dictionary->m_data.length(), m_level);
+      if (m_cdict == 0)
+        HT_THROW(Error::BLOCK_COMPRESSOR_INIT_ERROR,
+                 "Unable to load zstd dictionary");
+    }
+    zlen = ZSTD_compress_usingCDict(m_cctx,
+                                    output.base + header.encoded_length(),
+                                    avail_out, input.base, input.fill(),
+                                    m_cdict);
+  }
+  else
+    zlen = ZSTD_compressCCtx(m_cctx, output.base + header.encoded_length(),
+                             avail_out, input.base, input.fill(), m_level);
+
+  if (ZSTD_isError(zlen))
+    HT_THROWF(Error::BLOCK_COMPRESSOR_DEFLATE_ERROR, "Compressed block "
+              "deflate error - %s", ZSTD_getErrorName(zlen));
+
+  /* check for an incompressible block */
+  if (zlen >= input.fill()) {
+    header.set_compression_type(NONE);
+    memcpy(output.base+header.encoded_length(), input.base, input.fill());
+    header.set_data_length(input.fill());
+    header.set_data_zlength(input.fill());
+  }
+  else {
+    header.set_compression_type(ZSTD);
+    header.set_data_length(input.fill());
+    header.set_data_zlength(zlen);
+  }
+
+  header.set_data_checksum(header.compute_data_checksum(
+      output.base + header.encoded_length(), header.get_data_zlength()));
+
+  output.ptr = output.base;
+  header.encode(&output.ptr);
+  output.ptr += header.get_data_zlength();
+}
+
+
+void
+BlockCompressionCodecZstd::inflate(const DynamicBuffer &input,
+    DynamicBuffer &output, BlockHeader &header) {
+  const uint8_t *msg_ptr = input.base;
+  size_t remaining = input.fill();
+
+  header.decode(&msg_ptr, &remaining);
+
+  if (header.get_data_zlength() > remaining)
+    HT_THROWF(Error::BLOCK_COMPRESSOR_BAD_HEADER, "Block decompression error, "
+              "header zlength = %lu, actual = %lu",
+              (Lu)header.get_data_zlength(), (Lu)remaining);
+
+  uint32_t checksum =
+    header.compute_data_checksum(msg_ptr, header.get_data_zlength());
+
+  if (checksum != header.get_data_checksum())
+    HT_THROWF(Error::BLOCK_COMPRESSOR_CHECKSUM_MISMATCH, "Compressed block "
+              "checksum mismatch header=%lx, computed=%lx",
+              (Lu)header.get_data_checksum(), (Lu)checksum);
+
+  try {
+    output.reserve(header.get_data_length());
+
+    // check compress bit
+    if (header.get_compression_type() == NONE)
+      memcpy(output.base, msg_ptr, header.get_data_length());
+    else {
+      size_t len;
+
+      if (m_dctx == 0 && (m_dctx = ZSTD_createDCtx()) == 0)
+        HT_THROW(Error::BLOCK_COMPRESSOR_INIT_ERROR,
+                 "Unable to create zstd decompression context");
+
+      // Frames compressed without a dictionary carry a dictionary ID of 0
+      // and must be decompressed without one
+      unsigned dict_id =
+        ZSTD_getDictID_fromFrame(msg_ptr, header.get_data_zlength());
+
+      if (dict_id != 0) {
+        if (!m_dictionary || m_dictionary->m_id != dict_id)
+          HT_THROWF(Error::BLOCK_COMPRESSOR_INFLATE_ERROR, "Compressed block "
+                    "requires zstd dictionary %u", dict_id);
+        len = ZSTD_decompress_usingDDict(m_dctx, output.base,
+                                         header.get_data_length(), msg_ptr,
+                                         header.get_data_zlength(),
+                                         m_dictionary->m_ddict);
+      }
+      else
+        len = ZSTD_decompressDCtx(m_dctx, output.base,
+                                  header.get_data_length(), msg_ptr,
+                                  header.get_data_zlength());
+
+      if (ZSTD_isError(len))
+        HT_THROWF(Error::BLOCK_COMPRESSOR_INFLATE_ERROR, "Compressed block "
+                  "inflate error - %s", ZSTD_getErrorName(len));
+
+      if (len != header.get_data_length())
+        HT_THROWF(Error::BLOCK_COMPRESSOR_INFLATE_ERROR, "Compressed block "
+                  "inflate error, expected %lu but only inflated to %lu bytes",
+                  (Lu)header.get_data_length(), (Lu)len);
+    }
+
+    output.ptr = output.base + header.get_data_length();
+  }
+  catch (Exception &e) {
+    output.free();
+    throw;
+  }
+}
+
+
+size_t BlockCompressionCodecZstd::dictionary_training_size() {
+  return m_dict_size * 100;
+}
+
+
+BlockCompressionCodec::DictionaryPtr
+BlockCompressionCodecZstd::train_dictionary(const uint8_t *samples,
+                                            const vector<size_t> &sample_sizes) {
+  vector<size_t> sizes;
+  size_t total = 0;
+
+  for (auto size : sample_sizes)
+    total += size;
+
+  // A dictionary trained on less data than this costs more space than it
+  // saves
+  if (m_dict_size == 0 || total < m_dict_size * 10)
+    return DictionaryPtr();
+
+  for (auto size : sample_sizes) {
+    for (; size > MAX_SAMPLE_SIZE; size -= MAX_SAMPLE_SIZE)
+      sizes.push_back(MAX_SAMPLE_SIZE);
+    if (size)
+      sizes.push_back(size);
+  }
+
+  String dictionary(m_dict_size, '\0');
+  size_t len = ZDICT_trainFromBuffer(&dictionary[0], dictionary.length(),
+                                     samples, sizes.data(), sizes.size());
+  if (ZDICT_isError(len)) {
+    HT_INFOF("Unable to train zstd dictionary from %u samples - %s",
+             (unsigned)sizes.size(), ZDICT_getErrorName(len));
+    return DictionaryPtr();
+  }
+
+  return make_shared<ZstdDictionary>(dictionary.data(), len);
+}
+
+
+BlockCompressionCodec::DictionaryPtr
+BlockCompressionCodecZstd::load_dictionary(const uint8_t *data, size_t len) {
+  return make_shared<ZstdDictionary>(data, len);
+}
+
+
+void BlockCompressionCodecZstd::set_dictionary(const DictionaryPtr &dictionary) {
+  auto zstd_dictionary = dynamic_pointer_cast<ZstdDictionary>(dictionary);
+  if (dictionary && !zstd_dictionary)
+    HT_THROW(Error::BLOCK_COMPRESSOR_INVALID_ARG, "Not a zstd dictionary");
+  if (zstd_dictionary.get() != m_dictionary.get()) {
+    ZSTD_freeCDict(m_cdict);
+    m_cdict = 0;
+    m_dictionary = zstd_dictionary;
+  }
+}
@@ -0,0 +1,192 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for BlockCompressionCodecZstd.
+/// This file contains declarations for BlockCompressionCodecZstd, a class
+/// for compressing blocks using the Zstandard compression algorithm.
+
+#ifndef Hypertable_Lib_BlockCompressionCodecZstd_h
+#define Hypertable_Lib_BlockCompressionCodecZstd_h
+
+#include <Hypertable/Lib/BlockCompressionCodec.h>
+
+#include <zstd.h>
+
+namespace Hypertable {
+
+  /// @addtogroup libHypertable
+  /// @{
+
+  /// Block compressor that uses the Zstandard algorithm.
+  /// This class provides a way to compress and decompress blocks of data using
+  /// the <i>zstd</i> algorithm, which decompresses at close to the speed of
+  /// Snappy with a compression ratio comparable to or better than ZLIB.  On
+  /// small blocks the ratio improves considerably with a dictionary trained
+  /// on similar data (see train_dictionary()).  Blocks compressed with a
+  /// dictionary record the dictionary ID in the frame header, and inflate()
+  /// only applies the dictionary to such blocks, so blocks compressed with
+  /// and without a dictionary can be decompressed by the same codec.
+  class BlockCompressionCodecZstd : public BlockCompressionCodec {
+
+  public:
+
+    /// Constructor.
+    /// @param args Arguments to control compression behavior
+    /// @throws Exception Code set to Error::BLOCK_COMPRESSOR_INVALID_ARG
+    BlockCompressionCodecZstd(const Args &args);
+
+    /// Destructor.
+    virtual ~BlockCompressionCodecZstd();
+
+    /// Sets arguments to control compression behavior.
+    /// The arguments accepted by this method are described in the following
+    /// table.
+    /// <table>
+    /// <tr>
+    /// <th>Argument</th><th>Description</th>
+    /// </tr>
+    /// <tr>
+    /// <td><code>--level &lt;int&gt;</code></td><td>Compression level, from
+    /// 1 (fastest) to ZSTD_maxCLevel() (best ratio), default 3</td>
+    /// </tr>
+    /// <tr>
+    /// <td><code>--dict-size &lt;int&gt;</code></td><td>Size of trained
+    /// dictionary in bytes, 0 disables dictionaries, default 16384</td>
+    /// </tr>
+    /// </table>
+    /// @param args Vector of arguments
+    /// @throws Exception Code set to Error::BLOCK_COMPRESSOR_INVALID_ARG
+    virtual void set_args(const Args &args);
+
+    /// Compresses a buffer using the zstd algorithm.
+    /// This method reserves enough space in <code>output</code> to hold the
+    /// serialized <code>header</code> followed by the compressed input followed
+    /// by <code>reserve</code> bytes.  If a dictionary has been set, the input
+    /// is compressed with it.  If the resulting compressed buffer is larger
+    /// than the input buffer, then the input buffer is copied directly to the
+    /// output buffer and the compression type is set to
+    /// BlockCompressionCodec::NONE.  Before serailizing <code>header</code>,
+    /// the <i>data_length</i>, <i>data_zlength</i>, <i>data_checksum</i>, and
+    /// <i>compression_type</i> fields are set appropriately.  The output buffer
+    /// is formatted as follows:
+    /// <table>
+    /// <tr>
+    /// <td>header</td><td>compressed data</td><td>reserve</td>
+    /// </tr>
+    /// </table>
+    /// @param input Input buffer
+    /// @param output Output buffer
+    /// @param header Block header populated by function
+    /// @param reserve Additional space to reserve at end of <code>output</code>
+    ///   buffer
+    virtual void deflate(const DynamicBuffer &input, DynamicBuffer &output,
+                         BlockHeader &header, size_t reserve=0);
+
+    /// Decompresses a buffer compressed with the zstd algorithm.
+    /// @see deflate() for description of input buffer %format
+    /// @param input Input buffer
+    /// @param output Output buffer
+    /// @param header Block header
+    /// @throws Exception Code set to Error::BLOCK_COMPRESSOR_INFLATE_ERROR if
+    /// the block was compressed with a dictionary other than the one set
+    virtual void inflate(const DynamicBuffer &input, DynamicBuffer &output,
+                         BlockHeader &header);
+
+    /// Returns amount of sample data wanted for training a dictionary.
+    /// Returns one hundred times the dictionary size, the amount of
+    /// training data recommended by the zstd documentation, or 0 if
+    /// dictionaries are disabled with <code>--dict-size 0</code>.
+    /// @return Number of sample bytes to pass to train_dictionary()
+    virtual size_t dictionary_training_size();
+
+    /// Trains a dictionary.
+    /// Samples larger than 4KB are split into 4KB pieces before training so
+    /// that a handful of full-size blocks still yields enough samples.
+    /// @param samples Sample blocks, back to back
+    /// @param sample_sizes Length of each sample block
+    /// @return Trained dictionary, or null if training failed
+    virtual DictionaryPtr train_dictionary(const uint8_t *samples,
+                                           const std::vector<size_t> &sample_sizes);
+
+    /// Loads a serialized dictionary.
+    /// @param data Dictionary bytes
+    /// @param len Length of dictionary
+    /// @return Loaded dictionary
+    /// @throws Exception Code set to Error::BLOCK_COMPRESSOR_INIT_ERROR if
+    /// the dictionary could not be loaded
+    virtual DictionaryPtr load_dictionary(const uint8_t *data, size_t len);
+
+    /// Sets dictionary used by deflate() and inflate().
+    /// @param dictionary Dictionary obtained from a zstd codec, or null
+    virtual void set_dictionary(const DictionaryPtr &dictionary);
+
+    /// Returns enum value representing compression type ZSTD.
+    /// Returns the enum value ZSTD
+    /// @see BlockCompressionCodec::ZSTD
+    /// @return Compression type (ZSTD)
+    virtual int get_type() { return ZSTD; }
+
+  private:
+
+    /// Zstd dictionary.
+    /// Holds the dictionary bytes and the digested decompression dictionary,
+    /// which is shared by all codecs the dictionary is set on.  The
+    /// compression dictionary depends on the compression level and is
+    /// digested by each codec that compresses with it.
+    class ZstdDictionary : public Dictionary {
+    public:
+      ZstdDictionary(const void *data, size_t len);
+      virtual ~ZstdDictionary();
+      const String &data() const override { return m_data; }
+      size_t memory_used() const override;
+      /// Serialized dictionary
+      String m_data;
+      /// Digested decompression dictionary
+      ZSTD_DDict *m_ddict {};
+      /// Dictionary ID
+      unsigned m_id {};
+    };
+
+    /// Compression context
+    ZSTD_CCtx *m_cctx {};
+
+    /// Decompression context
+    ZSTD_DCtx *m_dctx {};
+
+    /// Dictionary set with set_dictionary()
+    std::shared_ptr<ZstdDictionary> m_dictionary;
+
+    /// Compression dictionary digested from #m_dictionary at #m_level
+    ZSTD_CDict *m_cdict {};
+
+    /// Compression level
+    int m_level {3};
+
+    /// Trained dictionary size
+    size_t m_dict_size {16384};
+  };
+
+  /// @}
+
+}
+
+#endif // Hypertable_Lib_BlockCompressionCodecZstd_h
@@ -51,6 +51,8 @@ BlockHeader::BlockHeader(uint16_t version, const char *magic) :
   m_flags(0), m_data_length(0), m_data_zlength(0), m_data_checksum(0),
   m_compression_type((uint16_t)-1), m_version(version) {
   HT_ASSERT(version <= LatestVersion);
+  if (version > 0)
+    m_flags = CHECKSUM_CRC32C;
   if (magic)
     memcpy(m_magic, magic, 10);
   else
@@ -119,6 +121,9 @@ void BlockHeader::decode(const uint8_t **bufp, size_t *remainp) {
                 "Header checksum mismatch: %u (computed) != %u (stored)",
                 (unsigned)header_checksum_computed, (unsigned)header_checksum);
     m_flags = decode_i16(bufp, remainp);
+    if (get_checksum_type() > CHECKSUM_CRC32C)
+      HT_THROWF(Error::BLOCK_COMPRESSOR_BAD_HEADER,
+                "Unsupported checksum type (%d)", (int)get_checksum_type());
   }
 
   uint16_t header_length = decode_byte(bufp, remainp);
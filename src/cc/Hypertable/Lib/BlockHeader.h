@@ -28,6 +28,9 @@
 #ifndef HYPERTABLE_BLOCKHEADER_H
 #define HYPERTABLE_BLOCKHEADER_H
 
+#include <Common/Checksum.h>
+#include <Common/Logger.h>
+
 #include <utility>
 
 namespace Hypertable {
@@ -51,10 +54,15 @@ namespace Hypertable {
 
     static const uint16_t LatestVersion = 1;    
 
+    /// Flags bits holding the data checksum type (see ChecksumType)
+    static const uint16_t FLAGS_MASK_CHECKSUM_TYPE = 0x0003;
+
     /** Constructor.
      * Initializes #m_version to <code>version</code>, #m_magic with the first
      * ten bytes of <code>magic</code>, and initializes all other members to
-     * their default values.
+     * their default values.  Headers of version 1 and later select
+     * CHECKSUM_CRC32C as data checksum type; version 0 headers have no flags
+     * field and always use CHECKSUM_FLETCHER32.
      * @param version Version of block header to initialize
      * @param magic Pointer to magic character sequence
      */
@@ -106,8 +114,10 @@ namespace Hypertable {
     uint32_t get_data_zlength() { return m_data_zlength; }
 
     /** Sets the checksum field.
-     * The checksum field stores the fletcher32 checksum of the compressed data
+     * The checksum field stores the checksum of the compressed data, computed
+     * with the algorithm returned by get_checksum_type().
      * @param checksum Checksum of compressed data
+     * @see compute_data_checksum()
      */
     void
     set_data_checksum(uint32_t checksum) { m_data_checksum = checksum; }
@@ -137,6 +147,37 @@ namespace Hypertable {
      */
     uint16_t get_flags() { return m_flags; }
 
+    /** Sets the data checksum type.
+     * The type is stored in the flags field, so it can only be changed for
+     * headers of version 1 and later.
+     * @param type Checksum algorithm for the data checksum
+     */
+    void set_checksum_type(ChecksumType type) {
+      HT_ASSERT(m_version > 0 || type == CHECKSUM_FLETCHER32);
+      m_flags = (m_flags & ~FLAGS_MASK_CHECKSUM_TYPE) | (uint16_t)type;
+    }
+
+    /** Gets the data checksum type.
+     * Blocks written before the type was recorded have zero in these bits
+     * and therefore report CHECKSUM_FLETCHER32.
+     * @return Checksum algorithm for the data checksum
+     */
+    ChecksumType get_checksum_type() {
+      return (ChecksumType)(m_flags & FLAGS_MASK_CHECKSUM_TYPE);
+    }
+
+    /** Computes a data checksum.
+     * Computes the checksum of <code>data</code> with the algorithm
+     * returned by get_checksum_type().  Used both to fill in the data
+     * checksum field and to verify it.
+     * @param data Pointer to (compressed) data
+     * @param len Length of data
+     * @return Checksum of data
+     */
+    uint32_t compute_data_checksum(const void *data, size_t len) {
+      return checksum(get_checksum_type(), data, len);
+    }
+
     /** Computes and writes checksum field.
      * The checksum field is a two-byte field that is located immediately after
      * the ten-byte magic string in the serialized header format (see encode()).
@@ -169,7 +210,7 @@ namespace Hypertable {
      *   <td>int16</td><td>Header checksum</td>
      *   </tr>
      *   <tr>
-     *   <td>int16</td><td>Flags</td>
+     *   <td>int16</td><td>Flags (bits 0-1 hold the data checksum type)</td>
      *   </tr>
      *   <tr>
      *   <td>int8</td><td>Header length</td>
@@ -29,12 +29,15 @@
 
 #include <Hypertable/Lib/ScanSpec.h>
 
-#include <re2/re2.h>
+#include <Common/Error.h>
+#include <Common/MemoryCompare.h>
 
-#include <boost/shared_ptr.hpp>
+#include <re2/re2.h>
 
+#include <algorithm>
 #include <bitset>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace Hypertable {
@@ -45,8 +48,18 @@ namespace Hypertable {
   /// @{
 
   /// Cell predicate.
+  /// Holds the column predicates of a column family, any one of which must
+  /// match a cell for the cell to be returned.  Once all predicates have been
+  /// added, compile() flattens them into a form that is cheap to evaluate per
+  /// cell: predicates that test only the qualifier, or only the value, for an
+  /// exact or prefix match are gathered into sorted sets searched with binary
+  /// searches, and the remaining predicates are ordered by evaluation cost so
+  /// that the cheapest tests run first.
   class CellPredicate {
 
+    /// Kind of string test
+    enum MatchKind { MATCH_NONE, MATCH_EXACT, MATCH_PREFIX, MATCH_REGEX };
+
     struct CellPattern {
       CellPattern(const ColumnPredicate &cp, size_t id) : 
         qualifier_len(cp.column_qualifier_len), value_len(cp.value_len),
@@ -66,28 +79,39 @@ namespace Hypertable {
           ptr += cp.value_len;
           *ptr++ = 0;
         }
-      }
-      bool regex_qualifier_match(const char *str) {
-        if (!qualifier_regex) {
-          std::string pattern(qualifier, (size_t)qualifier_len);
-          qualifier_regex.reset(new RE2(pattern));
+
+        if (operation & ColumnPredicate::QUALIFIER_EXACT_MATCH)
+          qualifier_kind = MATCH_EXACT;
+        else if (operation & ColumnPredicate::QUALIFIER_PREFIX_MATCH)
+          qualifier_kind = MATCH_PREFIX;
+        else if (operation & ColumnPredicate::QUALIFIER_REGEX_MATCH) {
+          qualifier_kind = MATCH_REGEX;
+          qualifier_regex.reset(new RE2(std::string(qualifier, (size_t)qualifier_len)));
         }
-        return RE2::PartialMatch(str, *qualifier_regex);
-      }
-      bool regex_value_match(const char *str) {
-        if (!value_regex) {
-          std::string pattern(value, (size_t)value_len);
-          value_regex.reset(new RE2(pattern));
+
+        if (operation & ColumnPredicate::EXACT_MATCH)
+          value_kind = MATCH_EXACT;
+        else if (operation & ColumnPredicate::PREFIX_MATCH)
+          value_kind = MATCH_PREFIX;
+        else if (operation & ColumnPredicate::REGEX_MATCH) {
+          value_kind = MATCH_REGEX;
+          value_regex.reset(new RE2(std::string(value, (size_t)value_len)));
         }
-        return RE2::PartialMatch(str, *value_regex);
+      }
+      /// Returns estimated cost of evaluating the pattern
+      int cost() const {
+        static const int costs[] = { 0, 1, 2, 16 };
+        return costs[qualifier_kind] + costs[value_kind];
       }
       const char *qualifier {};
       const char *value {};
       uint32_t qualifier_len;
       uint32_t value_len;
       uint32_t operation;
-      boost::shared_ptr<RE2> value_regex;
-      boost::shared_ptr<RE2> qualifier_regex;
+      MatchKind qualifier_kind {MATCH_NONE};
+      MatchKind value_kind {MATCH_NONE};
+      std::shared_ptr<RE2> value_regex;
+      std::shared_ptr<RE2> qualifier_regex;
       std::shared_ptr<char> buffer;
       size_t id;
     };
@@ -95,6 +119,69 @@ namespace Hypertable {
     /// Smart pointer to CellPattern
     typedef std::shared_ptr<CellPattern> CellPatternPtr;
 
+    /// Set of exact strings and prefixes.
+    /// Exact strings and prefixes are kept in sorted vectors.  A string
+    /// matches if it is found in the exact strings, or if, for one of the
+    /// distinct prefix lengths, its leading bytes are found in the prefixes.
+    class StringMatchSet {
+    public:
+      bool empty() const { return m_exact.empty() && m_prefixes.empty(); }
+
+      void add(const char *str, size_t len, bool prefix) {
+        if (prefix) {
+          m_prefixes.push_back(std::string(str, len));
+          m_prefix_lengths.push_back(len);
+        }
+        else
+          m_exact.push_back(std::string(str, len));
+      }
+
+      void finalize() {
+        unique_sort(m_exact);
+        unique_sort(m_prefixes);
+        unique_sort(m_prefix_lengths);
+      }
+
+      bool match(const char *str, size_t len) const {
+        if (!m_exact.empty() && contains(m_exact, str, len))
+          return true;
+        for (auto prefix_len : m_prefix_lengths) {
+          if (prefix_len > len)
+            break;
+          if (contains(m_prefixes, str, prefix_len))
+            return true;
+        }
+        return false;
+      }
+
+    private:
+
+      template <typename T>
+      static void unique_sort(std::vector<T> &vec) {
+        std::sort(vec.begin(), vec.end());
+        vec.erase(std::unique(vec.begin(), vec.end()), vec.end());
+      }
+
+      static bool contains(const std::vector<std::string> &vec,
+                           const char *str, size_t len) {
+        auto lt = [len](const std::string &entry, const char *str) {
+          int cmp = memory_compare(entry.data(), str,
+                                   std::min(entry.length(), len));
+          return cmp < 0 || (cmp == 0 && entry.length() < len);
+        };
+        auto iter = std::lower_bound(vec.begin(), vec.end(), str, lt);
+        return iter != vec.end() && iter->length() == len &&
+          memory_compare(iter->data(), str, len) == 0;
+      }
+
+      /// Sorted exact strings
+      std::vector<std::string> m_exact;
+      /// Sorted prefixes
+      std::vector<std::string> m_prefixes;
+      /// Sorted distinct prefix lengths
+      std::vector<size_t> m_prefix_lengths;
+    };
+
   public:
 
     /// Default constructor.
@@ -111,6 +198,9 @@ namespace Hypertable {
     }
 
     /// Evaluates predicate for the given cell.
+    /// If compile() has been called, the qualifier and value sets are
+    /// searched first and then the remaining patterns are evaluated in order
+    /// of increasing cost.
     /// @param qualifier Cell column qualifier
     /// @param qualifier_len Cell column qualifier length
     /// @param value Cell value
@@ -120,7 +210,21 @@ namespace Hypertable {
                  const char* value, size_t value_len) {
       if (patterns.empty())
         return true;
-      for (auto & cp : patterns) {
+      if (!m_compiled) {
+        for (auto & cp : patterns) {
+          if (pattern_match(cp, qualifier, qualifier_len, value, value_len))
+            return true;
+        }
+        return false;
+      }
+      if (m_match_all)
+        return true;
+      if (!m_qualifier_set.empty() &&
+          m_qualifier_set.match(qualifier, qualifier_len))
+        return true;
+      if (!m_value_set.empty() && m_value_set.match(value, value_len))
+        return true;
+      for (auto & cp : m_program) {
         if (pattern_match(cp, qualifier, qualifier_len, value, value_len))
           return true;
       }
@@ -131,54 +235,64 @@ namespace Hypertable {
                        size_t qualifier_len, const char* value,
                        size_t value_len) {
 
-      // Qualifier match
-      if (cp->operation & ColumnPredicate::QUALIFIER_MATCH) {
-        if (cp->operation & ColumnPredicate::QUALIFIER_EXACT_MATCH) {
-          if (qualifier_len != cp->qualifier_len ||
-              memcmp(qualifier, cp->qualifier, qualifier_len))
-            return false;
-        }
-        else if (cp->operation & ColumnPredicate::QUALIFIER_PREFIX_MATCH) {
-          if (qualifier_len < cp->qualifier_len)
-            return false;
-          const char *p1 = qualifier;
-          const char *p2 = cp->qualifier;
-          const char *prefix_end = cp->qualifier + cp->qualifier_len;
-          for (; p2 < prefix_end; ++p1,++p2) {
-            if (*p1 != *p2)
-              break;
-          }
-          if (p2 != prefix_end)
-            return false;
-        }
-        else if (cp->operation & ColumnPredicate::QUALIFIER_REGEX_MATCH) {
-          if (!cp->regex_qualifier_match(qualifier))
-            return false;
-        }
-      }
+      // Test the cheaper of qualifier and value first
+      if (cp->value_kind < cp->qualifier_kind)
+        return string_match(cp->value_kind, cp->value, cp->value_len,
+                            cp->value_regex.get(), value, value_len) &&
+          string_match(cp->qualifier_kind, cp->qualifier, cp->qualifier_len,
+                       cp->qualifier_regex.get(), qualifier, qualifier_len);
 
-      // Value match
-      if (cp->operation & ColumnPredicate::VALUE_MATCH) {
-        if (cp->operation & ColumnPredicate::EXACT_MATCH) {
-          if (cp->value_len != value_len ||
-              memcmp(cp->value, value, cp->value_len))
-            return false;
-        }
-        else if (cp->operation & ColumnPredicate::PREFIX_MATCH) {
-          if (cp->value_len > value_len ||
-              memcmp(cp->value, value, cp->value_len))
-            return false;
-        }
-        else if (cp->operation & ColumnPredicate::REGEX_MATCH) {
-          if (!cp->regex_value_match(value))
-            return false;
-        }
-      }
-      return true;
+      return string_match(cp->qualifier_kind, cp->qualifier, cp->qualifier_len,
+                          cp->qualifier_regex.get(), qualifier, qualifier_len) &&
+        string_match(cp->value_kind, cp->value, cp->value_len,
+                     cp->value_regex.get(), value, value_len);
     }
 
     void add_column_predicate(const ColumnPredicate &column_predicate, size_t id) {
       patterns.push_back(std::make_shared<CellPattern>(column_predicate, id));
+      m_compiled = false;
+    }
+
+    /// Compiles the patterns for evaluation by matches().
+    /// Patterns without a test make the predicate match every cell.  Patterns
+    /// that test only the qualifier, or only the value, for an exact or
+    /// prefix match are added to #m_qualifier_set or #m_value_set.  The
+    /// remaining patterns are stored in #m_program in order of increasing
+    /// cost.
+    /// @throws Exception with code Error::BAD_SCAN_SPEC if a regular
+    /// expression is invalid
+    void compile() {
+      m_match_all = false;
+      m_qualifier_set = StringMatchSet();
+      m_value_set = StringMatchSet();
+      m_program.clear();
+      for (auto & cp : patterns) {
+        if (cp->qualifier_regex && !cp->qualifier_regex->ok())
+          HT_THROWF(Error::BAD_SCAN_SPEC, "Bad qualifier regexp '%s' - %s",
+                    cp->qualifier, cp->qualifier_regex->error().c_str());
+        if (cp->value_regex && !cp->value_regex->ok())
+          HT_THROWF(Error::BAD_SCAN_SPEC, "Bad value regexp '%s' - %s",
+                    cp->value, cp->value_regex->error().c_str());
+        if (cp->qualifier_kind == MATCH_NONE && cp->value_kind == MATCH_NONE)
+          m_match_all = true;
+        else if (cp->value_kind == MATCH_NONE &&
+                 cp->qualifier_kind != MATCH_REGEX)
+          m_qualifier_set.add(cp->qualifier, cp->qualifier_len,
+                              cp->qualifier_kind == MATCH_PREFIX);
+        else if (cp->qualifier_kind == MATCH_NONE &&
+                 cp->value_kind != MATCH_REGEX)
+          m_value_set.add(cp->value, cp->value_len,
+                          cp->value_kind == MATCH_PREFIX);
+        else
+          m_program.push_back(cp);
+      }
+      m_qualifier_set.finalize();
+      m_value_set.finalize();
+      std::stable_sort(m_program.begin(), m_program.end(),
+                       [](const CellPatternPtr &a, const CellPatternPtr &b) {
+                         return a->cost() < b->cost();
+                       });
+      m_compiled = true;
     }
 
     /// TTL cutoff time
@@ -195,8 +309,43 @@ namespace Hypertable {
 
   private:
 
+    /// Tests a qualifier or value against one pattern string.
+    static bool string_match(MatchKind kind, const char *pattern,
+                             size_t pattern_len, RE2 *regex,
+                             const char *str, size_t len) {
+      switch (kind) {
+      case MATCH_NONE:
+        return true;
+      case MATCH_EXACT:
+        return len == pattern_len &&
+          memory_compare(pattern, str, len) == 0;
+      case MATCH_PREFIX:
+        return len >= pattern_len &&
+          memory_compare(pattern, str, pattern_len) == 0;
+      case MATCH_REGEX:
+        return RE2::PartialMatch(re2::StringPiece(str, len), *regex);
+      }
+      return false;
+    }
+
     /// Vector of patterns used in predicate match
     std::vector<CellPatternPtr> patterns;
+
+    /// Patterns not covered by the sets, in order of increasing cost
+    std::vector<CellPatternPtr> m_program;
+
+    /// Qualifier exact and prefix matches
+    StringMatchSet m_qualifier_set;
+
+    /// Value exact and prefix matches
+    StringMatchSet m_value_set;
+
+    /// Flag indicating a pattern matches every cell
+    bool m_match_all {};
+
+    /// Flag indicating compile() has been called since the last pattern
+    /// was added
+    bool m_compiled {};
   };
 
   /// @}
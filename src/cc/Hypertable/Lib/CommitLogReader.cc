@@ -107,6 +107,7 @@ CommitLogReader::next_raw_block(CommitLogBlockInfo *infop,
                                format("%u", (*fragment_queue_iter)->num));
     m_last_fragment_fname = (*fragment_queue_iter)->block_stream->get_fname();
     m_last_fragment_id = (int32_t)toplevel_fragment_id(*fragment_queue_iter);
+    (*fragment_queue_iter)->revision = TIMESTAMP_MIN;
   }
 
   if (!(*fragment_queue_iter)->block_stream->next(infop, header)) {
@@ -114,7 +115,14 @@ CommitLogReader::next_raw_block(CommitLogBlockInfo *infop,
     delete info->block_stream;
     info->block_stream = 0;
 
-    if (m_revision == TIMESTAMP_MIN) {
+    if (m_deferred_revisions) {
+      // Blocks may still be inflating, so leave dropping the fragment to
+      // finish_blocks()
+      if (m_revision > info->revision)
+        info->revision = m_revision;
+      m_fragment_queue_offset++;
+    }
+    else if (m_revision == TIMESTAMP_MIN) {
       if (m_verbose)
         HT_INFOF("Skipping log fragment '%s/%u' because unable to read any "
                  " valid blocks", info->log_dir.c_str(), info->num);
@@ -209,6 +217,66 @@ CommitLogReader::next(const uint8_t **blockp, size_t *lenp,
 }
 
 
+bool
+CommitLogReader::next_block(DynamicBuffer &zblock,
+                            BlockHeaderCommitLog *header,
+                            CommitLogFileInfo **fragmentp) {
+  CommitLogBlockInfo binfo;
+
+  m_deferred_revisions = true;
+
+  while (next_raw_block(&binfo, header)) {
+
+    LogFragmentQueue::iterator iter = m_fragment_queue.begin() + m_fragment_queue_offset;
+
+    if (binfo.error == Error::OK) {
+      zblock.clear();
+      zblock.ensure(binfo.block_len);
+      zblock.add_unchecked(binfo.block_ptr, binfo.block_len);
+      *fragmentp = *iter;
+      return true;
+    }
+
+    HT_WARNF("Corruption detected in CommitLog fragment %s starting at "
+             "postion %lld for %lld bytes - %s",
+             (*iter)->block_stream->get_fname().c_str(),
+             (Lld)binfo.start_offset, (Lld)(binfo.end_offset
+             - binfo.start_offset), Error::get_text(binfo.error));
+  }
+
+  return false;
+}
+
+
+void CommitLogReader::block_inflated(CommitLogFileInfo *fragment,
+                                     int64_t revision) {
+  if (revision > fragment->revision)
+    fragment->revision = revision;
+  if (revision > m_latest_revision)
+    m_latest_revision = revision;
+}
+
+
+void CommitLogReader::finish_blocks() {
+  LogFragmentQueue::iterator iter = m_fragment_queue.begin();
+
+  while (iter != m_fragment_queue.end()) {
+    if ((*iter)->revision == TIMESTAMP_MIN) {
+      if (m_verbose)
+        HT_INFOF("Skipping log fragment '%s/%u' because unable to read any "
+                 " valid blocks", (*iter)->log_dir.c_str(), (*iter)->num);
+      iter = m_fragment_queue.erase(iter);
+    }
+    else
+      ++iter;
+  }
+  m_fragment_queue_offset = m_fragment_queue.size();
+
+  struct LtClfip swo;
+  sort(m_fragment_queue.begin(), m_fragment_queue.end(), swo);
+}
+
+
 void CommitLogReader::load_fragments(String log_dir, CommitLogFileInfo *parent) {
   vector<Filesystem::Dirent> listing;
   CommitLogFileInfo *fi;
@@ -66,12 +66,42 @@ namespace Hypertable {
     bool next(const uint8_t **blockp, size_t *lenp,
               BlockHeaderCommitLog *);
 
+    /// Reads next block without decompressing it.
+    /// Copies the next valid block, including its header, into
+    /// <code>zblock</code> so that it can be inflated later, possibly on
+    /// another thread.  Since the block may turn out to be corrupt, fragment
+    /// revisions are not advanced until the caller reports a successful
+    /// inflate with block_inflated().  Once all blocks have been read and
+    /// inflated, the caller must call finish_blocks().
+    /// @param zblock Receives compressed block
+    /// @param header Receives block header
+    /// @param fragmentp Receives fragment containing the block, to be passed
+    /// to block_inflated()
+    /// @return <i>false</i> if there are no more blocks, <i>true</i>
+    /// otherwise
+    bool next_block(DynamicBuffer &zblock, BlockHeaderCommitLog *header,
+                    CommitLogFileInfo **fragmentp);
+
+    /// Records a block returned by next_block() as successfully inflated.
+    /// Raises the revision of the block's fragment and the latest revision
+    /// of the log to the revision of the block.
+    /// @param fragment Fragment returned with the block by next_block()
+    /// @param revision Revision from the block header
+    void block_inflated(CommitLogFileInfo *fragment, int64_t revision);
+
+    /// Finishes reading blocks with next_block().
+    /// Drops the fragments from which no block was successfully inflated
+    /// and sorts the remaining fragments by revision, as next() does when
+    /// it reaches the end of the log.
+    void finish_blocks();
+
     void reset() {
       m_fragment_queue_offset = 0;
       m_block_buffer.clear();
       m_revision = TIMESTAMP_MIN;
       m_latest_revision = TIMESTAMP_MIN;
       m_error_map.clear();
+      m_deferred_revisions = false;
     }
 
     void get_linked_logs(StringSet &linked_logs) {
@@ -106,6 +136,9 @@ namespace Hypertable {
     std::string                 m_last_fragment_fname;
     int32_t                m_last_fragment_id {};
     bool                   m_verbose {};
+
+    /// Set by next_block() to leave fragment revisions to block_inflated()
+    bool                   m_deferred_revisions {};
   };
 
   /// Smart pointer to CommitLogReader
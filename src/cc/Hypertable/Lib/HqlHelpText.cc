@@ -360,6 +360,8 @@ namespace {
     "      | REPLICATION int",
     "      | COMPRESSOR compressor_spec",
     "      | BLOOMFILTER bloom_filter_spec",
+    "      | CELLCACHE cell_cache_spec",
+    "      | KEYENCODING key_encoding_spec",
     "",
     "    access_group_options:",
     "      column_family_option | access_group_option",
@@ -370,6 +372,7 @@ namespace {
     "      | quicklz",
     "      | snappy",
     "      | zlib [ zlib_options ]",
+    "      | zstd [ zstd_options ]",
     "      | none",
     "",
     "    bmz_options:",
@@ -381,6 +384,10 @@ namespace {
     "      | --best",
     "      | --normal",
     "",
+    "    zstd_options:",
+    "      --level int",
+    "      | --dict-size int",
+    "",
     "    bloom_filter_spec:",
     "      rows [ bloom_filter_options ]",
     "      | rows+cols [ bloom_filter_options ]",
@@ -530,6 +537,8 @@ namespace {
     "      | REPLICATION int",
     "      | COMPRESSOR compressor_spec",
     "      | BLOOMFILTER bloom_filter_spec",
+    "      | CELLCACHE cell_cache_spec",
+    "      | KEYENCODING key_encoding_spec",
     "",
     "    access_group_options:",
     "      column_family_option | access_group_option",
@@ -540,6 +549,7 @@ namespace {
     "      | quicklz",
     "      | snappy",
     "      | zlib [ zlib_options ]",
+    "      | zstd [ zstd_options ]",
     "      | none",
     "",
     "    bmz_options:",
@@ -551,6 +561,10 @@ namespace {
     "      | --best",
     "      | --normal",
     "",
+    "    zstd_options:",
+    "      --level int",
+    "      | --dict-size int",
+    "",
     "    bloom_filter_spec:",
     "      rows [ bloom_filter_options ]",
     "      | rows+cols [ bloom_filter_options ]",
@@ -762,6 +776,8 @@ namespace {
     "  * REPLICATION int",
     "  * COMPRESSOR compressor_spec",
     "  * BLOOMFILTER bloom_filter_spec",
+    "  * CELLCACHE cell_cache_spec",
+    "  * KEYENCODING key_encoding_spec",
     "",
     "Any of the column family options may be specified as access group options.",
     "Column family options specified as access group options are taken to be",
@@ -798,6 +814,27 @@ namespace {
     "NOTE: if the block, after compression, is not significantly reduced in",
     "size, then no compression will be performed on the block",
     "",
+    "The CELLCACHE option selects the in-memory data structure used for the cell",
+    "cache.  \"map\" (the default, unless overridden with the",
+    "Hypertable.RangeServer.AccessGroup.CellCache.DefaultType property) is a",
+    "balanced tree guarded by a mutex.  \"skiplist\" is a concurrent skiplist that",
+    "scanners can traverse without locking, which reduces contention between",
+    "updates and scans on frequently accessed ranges.",
+    "",
+    "The KEYENCODING option selects how keys are encoded within cell store",
+    "blocks.  \"prefix\" (the default, unless overridden with the",
+    "Hypertable.RangeServer.CellStore.DefaultKeyEncoding property) stores each",
+    "key as the suffix it does not share with the previous key.  \"delta\" does",
+    "the same for the row, column and flag, but stores the timestamp and revision",
+    "as variable length differences from those of the previous key, which",
+    "shrinks the keys of time series and counter data considerably.",
+    "\"columnar\" encodes keys as \"delta\" does, and also stores the keys, the",
+    "value lengths and the values of each block as three separate streams, so",
+    "that the values of access groups whose columns hold fixed-format data",
+    "(e.g. sensor readings) compress better.  Values are copied back next to",
+    "their keys when a block is read, so scans of these access groups cost",
+    "slightly more CPU.",
+    "",
     "An access group can consist of many on-disk cell stores.  A query for a single",
     "row key can result probing each cell store to see if data is present for that",
     "row even when most of the cell stores do not contain any data for that row.",
@@ -850,6 +887,7 @@ namespace {
     "  * quicklz",
     "  * zlib",
     "  * snappy",
+    "  * zstd",
     "  * none",
     "",
     "The default code is snappy for cell store blocks.  The following list ",
@@ -859,6 +897,9 @@ namespace {
     "  bmz --offset arg    Starting fingerprint offset (default = 0)",
     "  zlib -9 [ --best ]  Highest compression ratio (at the cost of speed)",
     "  zlib --normal       Normal compression ratio",
+    "  zstd --level arg    Compression level, 1 to 22 (default = 3)",
+    "  zstd --dict-size arg  Size of the dictionary trained for each cell",
+    "                      store, 0 to disable (default = 16384)",
     "",
     "Table Options",
     "-------------",
@@ -964,6 +1005,8 @@ namespace {
     "      | INTO FILE filename[.gz]",
     "      | DISPLAY_TIMESTAMPS",
     "      | KEYS_ONLY",
+    "      | AGGREGATE (COUNT | SUM | MIN | MAX)",
+    "          [BY (ROW | ROW_PREFIX length | COLUMN)]",
     "      | FS = '<char>'",
     "      | NO_CACHE",
     "      | NO_ESCAPE",
@@ -1091,6 +1134,21 @@ namespace {
     "the client.  The value data is not transferred back to the client, only",
     "the key data.",
     "",
+    "AGGREGATE (COUNT | SUM | MIN | MAX) [BY (ROW | ROW_PREFIX length | COLUMN)]",
+    "",
+    "The AGGREGATE option causes the RangeServers to return one cell per group",
+    "instead of the selected cells.  Cells are grouped by column family and by",
+    "row (BY ROW, the default), by the first <length> bytes of the row",
+    "(BY ROW_PREFIX), or not by row at all (BY COLUMN), in which case the row of",
+    "each output cell is empty.  The value of each output cell is the number of",
+    "cells in the group (COUNT), or the sum, minimum, or maximum of the integer",
+    "values in the group.  Counter columns contribute their counts and other",
+    "values that are not integers are ignored.  The aggregates are evaluated",
+    "after all other predicates and options, so for example the following",
+    "statement counts, per column family, the cells of the rows starting with 'com.':",
+    "",
+    "  SELECT * FROM crawldb WHERE ROW =^ 'com.' AGGREGATE COUNT BY ROW_PREFIX 4;",
+    "",
     "FS = '<char>'",
     "",
     "Set the field separator to character '<char>'.  By default the field separator",
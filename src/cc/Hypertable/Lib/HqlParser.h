@@ -1207,6 +1207,32 @@ namespace Hypertable {
       ParserState &state;
     };
 
+    struct set_cell_cache {
+      set_cell_cache(ParserState &state) : state(state) { }
+      void operator()(char const * str, char const *end) const {
+        std::string cell_cache = strip_quotes(str, end-str);
+        to_lower(cell_cache);
+        if (state.ag_spec)
+          state.ag_spec->set_option_cell_cache(cell_cache);
+        else
+          state.table_ag_defaults.set_cell_cache(cell_cache);
+      }
+      ParserState &state;
+    };
+
+    struct set_key_encoding {
+      set_key_encoding(ParserState &state) : state(state) { }
+      void operator()(char const * str, char const *end) const {
+        std::string key_encoding = strip_quotes(str, end-str);
+        to_lower(key_encoding);
+        if (state.ag_spec)
+          state.ag_spec->set_option_key_encoding(key_encoding);
+        else
+          state.table_ag_defaults.set_key_encoding(key_encoding);
+      }
+      ParserState &state;
+    };
+
     struct access_group_add_column_family {
       access_group_add_column_family(ParserState &state) : state(state) { }
       void operator()(char const *str, char const *end) const {
@@ -2182,6 +2208,32 @@ namespace Hypertable {
       ParserState &state;
     };
 
+    struct scan_set_aggregate {
+      scan_set_aggregate(ParserState &state, uint8_t function)
+        : state(state), function(function) { }
+      void operator()(char const *str, char const *end) const {
+        if (state.scan.builder.get().aggregate)
+          HT_THROW(Error::HQL_PARSE_ERROR,
+                   "SELECT AGGREGATE predicate multiply defined.");
+        state.scan.builder.set_aggregate(function);
+      }
+      ParserState &state;
+      uint8_t function;
+    };
+
+    struct scan_set_aggregate_row_prefix {
+      scan_set_aggregate_row_prefix(ParserState &state) : state(state) { }
+      void operator()(int ival) const {
+        state.scan.builder.set_aggregate(state.scan.builder.get().aggregate,
+                                         ival);
+      }
+      void operator()(char const *str, char const *end) const {
+        // BY COLUMN aggregates each column over all rows
+        state.scan.builder.set_aggregate(state.scan.builder.get().aggregate, 0);
+      }
+      ParserState &state;
+    };
+
     struct set_insert_timestamp {
       set_insert_timestamp(ParserState &state) : state(state) { }
       void operator()(char const *str, char const *end) const {
@@ -2591,6 +2643,13 @@ namespace Hypertable {
           Token RETURN_DELETES = as_lower_d["return_deletes"];
           Token SCAN_AND_FILTER_ROWS = as_lower_d["scan_and_filter_rows"];
           Token KEYS_ONLY    = as_lower_d["keys_only"];
+          Token AGGREGATE    = as_lower_d["aggregate"];
+          Token COUNT        = as_lower_d["count"];
+          Token SUM          = as_lower_d["sum"];
+          Token MIN          = as_lower_d["min"];
+          Token MAX          = as_lower_d["max"];
+          Token BY           = as_lower_d["by"];
+          Token ROW_PREFIX   = as_lower_d["row_prefix"];
           Token RANGE        = as_lower_d["range"];
           Token UPDATE       = as_lower_d["update"];
           Token SCANNER      = as_lower_d["scanner"];
@@ -2606,6 +2665,8 @@ namespace Hypertable {
           Token COMMIT       = as_lower_d["commit"];
           Token LOG          = as_lower_d["log"];
           Token BLOOMFILTER  = as_lower_d["bloomfilter"];
+          Token CELLCACHE    = as_lower_d["cellcache"];
+          Token KEYENCODING  = as_lower_d["keyencoding"];
           Token TRUE         = as_lower_d["true"];
           Token FALSE        = as_lower_d["false"];
           Token AND          = as_lower_d["and"];
@@ -3143,6 +3204,10 @@ namespace Hypertable {
             | COMPRESSOR >> *EQUAL >> string_literal[
                 set_compressor(self.state)]
             | bloom_filter_option
+            | CELLCACHE >> *EQUAL >> string_literal[
+                set_cell_cache(self.state)]
+            | KEYENCODING >> *EQUAL >> string_literal[
+                set_key_encoding(self.state)]
             ;
 
           bloom_filter_option
@@ -3313,6 +3378,14 @@ namespace Hypertable {
             | DISPLAY_REVISIONS[scan_set_display_revisions(self.state)]
             | RETURN_DELETES[scan_set_return_deletes(self.state)]
             | KEYS_ONLY[scan_set_keys_only(self.state)]
+            | AGGREGATE
+              >> (COUNT[scan_set_aggregate(self.state, ScanSpec::AGGREGATE_COUNT)]
+                  | SUM[scan_set_aggregate(self.state, ScanSpec::AGGREGATE_SUM)]
+                  | MIN[scan_set_aggregate(self.state, ScanSpec::AGGREGATE_MIN)]
+                  | MAX[scan_set_aggregate(self.state, ScanSpec::AGGREGATE_MAX)])
+              >> !(BY >> (ROW_PREFIX >> !EQUAL >> uint_p[scan_set_aggregate_row_prefix(self.state)]
+                          | COLUMN[scan_set_aggregate_row_prefix(self.state)]
+                          | ROW))
             | NO_CACHE[scan_set_no_cache(self.state)]
             | NOESCAPE[set_noescape(self.state)]
             | NO_ESCAPE[set_noescape(self.state)]
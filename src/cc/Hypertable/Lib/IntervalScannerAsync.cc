@@ -195,6 +195,8 @@ void IntervalScannerAsync::init(const ScanSpec &scan_spec) {
 
   m_scan_spec_builder.set_return_deletes(scan_spec.return_deletes);
   m_scan_spec_builder.set_keys_only(scan_spec.keys_only);
+  m_scan_spec_builder.set_aggregate(scan_spec.aggregate,
+                                    scan_spec.aggregate_row_prefix_length);
 
   // If offset or limit specified, defer readahead until outstanding result is
   // processed
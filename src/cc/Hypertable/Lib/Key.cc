@@ -21,6 +21,7 @@
 
 #include "Common/Compat.h"
 #include <cassert>
+#include <cstring>
 #include <iostream>
 
 #include "Key.h"
@@ -167,8 +168,9 @@ namespace Hypertable {
     control = *ptr++;
     row = (const char *)ptr;
 
-    while (ptr < end_ptr && *ptr != 0)
-      ptr++;
+    // memchr() finds the terminator a vector at a time
+    if ((ptr = (const uint8_t *)memchr(ptr, 0, end_ptr - ptr)) == 0)
+      ptr = end_ptr;
 
     row_len = ptr - (uint8_t *)row;
     assert(strlen(row) == row_len);
@@ -182,8 +184,8 @@ namespace Hypertable {
     column_family_code = *ptr++;
     column_qualifier = (const char *)ptr;
 
-    while (ptr < end_ptr && *ptr != 0)
-      ptr++;
+    if ((ptr = (const uint8_t *)memchr(ptr, 0, end_ptr - ptr)) == 0)
+      ptr = end_ptr;
 
     column_qualifier_len = ptr - (uint8_t *)column_qualifier;
     assert(strlen(column_qualifier) == column_qualifier_len);
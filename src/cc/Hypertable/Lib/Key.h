@@ -110,6 +110,34 @@ namespace Hypertable {
      */
     bool load(const SerializedKey& key);
 
+    /**
+     * Compares the serialized form of this key with that of another key.
+     * Gives the same result as <code>serial.compare(other.serial)</code>
+     * without decoding the key lengths again.  Both keys must have been
+     * loaded with load().
+     *
+     * @param other key to compare with
+     * @return Less than, equal to, or greater than zero if this key sorts
+     * before, equal to, or after <code>other</code>
+     */
+    int compare_serial(const Key &other) const {
+      const uint8_t *ptr1 = (const uint8_t *)row - 1;
+      const uint8_t *ptr2 = (const uint8_t *)other.row - 1;
+      int len1 = length - (ptr1 - serial.ptr);
+      int len2 = other.length - (ptr2 - other.serial.ptr);
+
+      if (*ptr1 != *ptr2) {
+        // Timestamp is only compared if both keys have one
+        if (*ptr1 >= 0x80 && *ptr1 != 0xD0)
+          len1 -= 8;
+        if (*ptr2 >= 0x80 && *ptr2 != 0xD0)
+          len2 -= 8;
+      }
+      int len = (len1 < len2) ? len1 : len2;
+      int cmp = memory_compare(ptr1+1, ptr2+1, len-1);
+      return (cmp==0) ? len1 - len2 : cmp;
+    }
+
     size_t len_row() const { return row_len; }
 
     size_t len_column_family() const {
@@ -25,14 +25,99 @@
 
 #include <Common/InetAddr.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
-#include <fstream>
-#include <iostream>
+#include <functional>
+#include <map>
+#include <thread>
 
 using namespace Hypertable;
 using namespace std;
 
+namespace {
+
+  /// Returns true if a range ending at <code>end_row</code> ends before
+  /// <code>row</code>.  An empty end row is the end of the table and a null
+  /// row sorts after every row.
+  inline bool ends_before(const string &end_row, const char *row) {
+    if (end_row.empty())
+      return false;
+    if (row == 0)
+      return true;
+    return strcmp(end_row.c_str(), row) < 0;
+  }
+
+  /// Returns index of the first chunk holding a value that doesn't end
+  /// before <code>row</code>, or the number of chunks if there is none
+  template <typename ChunksT>
+  size_t chunk_index(const ChunksT &chunks, const char *row) {
+    size_t lo = 0, hi = chunks.size();
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      if (ends_before(chunks[mid]->back()->end_row, row))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return lo;
+  }
+
+  template <typename ChunkT>
+  typename ChunkT::const_iterator
+  chunk_lower_bound(const ChunkT &chunk, const char *row) {
+    return std::lower_bound(chunk.begin(), chunk.end(), row,
+                            [](const typename ChunkT::value_type &value,
+                               const char *row) {
+                              return ends_before(value->end_row, row);
+                            });
+  }
+
+}
+
+/// Marks a lookup in progress for the lifetime of the object.  The reader
+/// count for the current epoch is only kept if the epoch didn't change
+/// while it was incremented, so synchronize() never misses a reader that
+/// went on to load a replaced pointer.
+class LocationCache::ReadGuard {
+public:
+  ReadGuard(LocationCache *cache) {
+    size_t stripe =
+      std::hash<std::thread::id>()(std::this_thread::get_id()) % READER_STRIPES;
+    while (true) {
+      uint64_t epoch = cache->m_epoch.load();
+      m_count = &cache->m_readers[stripe].count[epoch & 1];
+      m_count->fetch_add(1);
+      if (cache->m_epoch.load() == epoch)
+        break;
+      m_count->fetch_sub(1);
+    }
+  }
+  ~ReadGuard() {
+    m_count->fetch_sub(1);
+  }
+private:
+  std::atomic<size_t> *m_count;
+};
+
+LocationCache::LocationCache(uint32_t max_entries)
+  : m_max_entries(max_entries) {
+  for (auto &readers : m_readers) {
+    readers.count[0].store(0);
+    readers.count[1].store(0);
+  }
+  m_directory.store(new Directory());
+}
+
+LocationCache::~LocationCache() {
+  for (auto &table : m_tables)
+    delete table->snapshot.load();
+  delete m_directory.load();
+  for (AddressSet::iterator iter = m_addresses.begin();
+       iter != m_addresses.end(); ++iter)
+    delete *iter;
+}
+
 /**
  * Insert
  */
@@ -40,84 +125,48 @@ void
 LocationCache::insert(const char *table_name, RangeLocationInfo &range_loc_info,
                       bool pegged) {
   lock_guard<mutex> lock(m_mutex);
-  Value *newval = new Value;
-  LocationMap::iterator iter;
-  LocationCacheKey key;
+  ValuePtr newval = make_shared<Value>();
+  Retired retired;
 
   assert(table_name);
 
-  /*
-  HT_DEBUG_OUT << table_name << " start=" << start_row << " end=" << end_row
-      << " location=" << location << HT_END;
-  */
-
   newval->start_row = range_loc_info.start_row;
   newval->end_row = range_loc_info.end_row;
   newval->addrp = get_constant_address(range_loc_info.addr);
   newval->pegged = pegged;
 
-  key.table_name = m_strings.get(table_name);
-  key.end_row = (range_loc_info.end_row == "") ? 0 : newval->end_row.c_str();
-
-  // remove old entry
-  if ((iter = m_location_map.find(key)) != m_location_map.end())
-    remove((*iter).second);
-
-  // make room for the new entry
-  while (m_location_map.size() >= m_max_entries) {
-    if (m_tail->pegged)
-      move_to_head(m_tail);
-    else
-      remove(m_tail);
+  // make room for the new entry, unless it replaces an old one.  Eviction
+  // may drop the table's index, so it is looked up again afterwards.
+  if (m_entries >= m_max_entries) {
+    const char *row = newval->end_row.empty() ? 0 : newval->end_row.c_str();
+    TableIndex *table = find_table(m_directory.load(), table_name);
+    const Value *old = table ? lower_bound(table->snapshot.load(), row) : 0;
+    if (old == 0 || old->end_row != newval->end_row)
+      evict(retired);
   }
 
-  // add to head
-  if (m_head == 0) {
-    assert(m_tail == 0);
-    newval->next = newval->prev = 0;
-    m_head = m_tail = newval;
-  }
-  else {
-    m_head->next = newval;
-    newval->prev = m_head;
-    newval->next = 0;
-    m_head = newval;
-  }
+  TableIndex *table = get_table(table_name, retired);
 
-  // Insert the new entry into the map, recording an iterator to the entry
-  {
-    std::pair<LocationMap::iterator, bool> old_entry;
-    LocationMap::value_type map_value(key, newval);
-    old_entry = m_location_map.insert(map_value);
-    assert(old_entry.second);
-    newval->map_iter = old_entry.first;
-  }
+  newval->last_access.store(++m_clock);
 
-}
+  bool replaced {};
+  publish(table, add_value(table->snapshot.load(), newval, &replaced), retired);
+  if (!replaced)
+    m_entries++;
 
-/**
- *
- */
-LocationCache::~LocationCache() {
-  for (AddressSet::iterator iter = m_addresses.begin();
-       iter != m_addresses.end(); ++iter)
-    delete *iter;
-  for (LocationMap::iterator lm_it = m_location_map.begin();
-       lm_it != m_location_map.end(); ++lm_it)
-    delete (*lm_it).second;
+  reclaim(retired);
 }
 
-
 /**
  * Lookup
  */
 bool
 LocationCache::lookup(const char * table_name, const char *rowkey,
                       RangeLocationInfo *range_loc_infop, bool inclusive) {
-  lock_guard<mutex> lock(m_mutex);
+  ReadGuard guard(this);
 
-  Value* cacheval;
-  if (!lookup(table_name, rowkey, cacheval, inclusive))
+  const Value *cacheval = find(table_name, rowkey, inclusive);
+  if (cacheval == 0)
     return false;
 
   range_loc_infop->start_row = cacheval->start_row;
@@ -130,10 +179,10 @@ LocationCache::lookup(const char * table_name, const char *rowkey,
 bool
 LocationCache::lookup(const char * table_name, const char *rowkey,
                       RangeAddrInfo *range_addr_infop, bool inclusive) {
-  lock_guard<mutex> lock(m_mutex);
+  ReadGuard guard(this);
 
-  Value* cacheval;
-  if (!lookup(table_name, rowkey, cacheval, inclusive))
+  const Value *cacheval = find(table_name, rowkey, inclusive);
+  if (cacheval == 0)
     return false;
 
   range_addr_infop->addr = *cacheval->addrp;
@@ -143,140 +192,356 @@ LocationCache::lookup(const char * table_name, const char *rowkey,
 
 bool LocationCache::invalidate(const char *table_name, const char *rowkey) {
   lock_guard<mutex> lock(m_mutex);
-  LocationMap::iterator iter;
-  LocationCacheKey key;
+  Retired retired;
 
   assert(table_name);
 
-  //cout << table_name << " row=" << rowkey << endl << flush;
-
-  key.table_name = table_name;
-  key.end_row = rowkey;
-
-  if ((iter = m_location_map.lower_bound(key)) == m_location_map.end())
+  TableIndex *table = find_table(m_directory.load(), table_name);
+  if (table == 0)
     return false;
 
-  if (strcmp((*iter).first.table_name, table_name))
+  const Value *value = lower_bound(table->snapshot.load(), rowkey);
+  if (value == 0)
     return false;
 
-#if 0
-  if (rowkey && strcmp(rowkey, (*iter).second->start_row.c_str()) < 0)
-    return false;
-#endif
-  if ((rowkey == 0 && !(*iter).second->start_row.empty()) ||
-      (rowkey && strcmp(rowkey, (*iter).second->start_row.c_str()) < 0))
+  if ((rowkey == 0 && !value->start_row.empty()) ||
+      (rowkey && strcmp(rowkey, value->start_row.c_str()) < 0))
     return false;
 
-  remove((*iter).second);
+  publish(table, remove_value(table->snapshot.load(), value), retired);
+  m_entries--;
+  reclaim(retired);
   return true;
 }
 
 void LocationCache::invalidate_host(const string &hostname) {
   lock_guard<mutex> lock(m_mutex);
   CommAddress addr;
+  Retired retired;
 
   addr.set_proxy(hostname);
   const CommAddress *addrp = get_constant_address(addr);
 
-  LocationMap::iterator iter = m_location_map.begin();
-  Value *val = 0;
-  while (iter != m_location_map.end()) {
-    val = 0;
-    if (iter->second->addrp == addrp)
-      val = iter->second;
-    ++iter;
-    if (val)
-      remove(val);
+  // Collected first since publishing an empty index removes the table
+  map<TableIndex *, set<const Value *>> victims;
+  for (auto &table : m_tables) {
+    const TableSnapshot *snapshot = table->snapshot.load();
+    if (snapshot == 0)
+      continue;
+    for (auto &chunk : snapshot->chunks)
+      for (auto &value : *chunk)
+        if (value->addrp == addrp)
+          victims[table.get()].insert(value.get());
+  }
+
+  for (auto &entry : victims) {
+    publish(entry.first, remove_values(entry.first->snapshot.load(),
+                                       entry.second), retired);
+    m_entries -= entry.second.size();
   }
+
+  reclaim(retired);
 }
 
 
 void LocationCache::display(std::ostream &out) {
-  for (Value *value = m_head; value; value = value->prev)
+  lock_guard<mutex> lock(m_mutex);
+  vector<const Value *> values;
+
+  for (auto &table : m_tables) {
+    const TableSnapshot *snapshot = table->snapshot.load();
+    if (snapshot)
+      for (auto &chunk : snapshot->chunks)
+        for (auto &value : *chunk)
+          values.push_back(value.get());
+  }
+
+  stable_sort(values.begin(), values.end(),
+              [](const Value *v1, const Value *v2) {
+                return v1->last_access.load() > v2->last_access.load();
+              });
+
+  for (auto value : values)
     out << "DUMP: end=" << value->end_row << " start=" << value->start_row
         << endl;
 }
 
-bool LocationCache::lookup(const char * table_name, const char *rowkey,
-                           Value*& cacheval, bool inclusive) {
-  LocationMap::iterator iter;
-  LocationCacheKey key;
-
+const LocationCache::Value *
+LocationCache::find(const char *table_name, const char *rowkey,
+                    bool inclusive) {
   assert(table_name);
 
-  key.table_name = table_name;
-  key.end_row = rowkey;
-
-  if ((iter = m_location_map.lower_bound(key)) == m_location_map.end())
-    return false;
+  TableIndex *table = find_table(m_directory.load(), table_name);
+  if (table == 0)
+    return 0;
 
-  if (strcmp((*iter).first.table_name, table_name))
-    return false;
+  const Value *cacheval = lower_bound(table->snapshot.load(), rowkey);
+  if (cacheval == 0)
+    return 0;
 
   if (inclusive) {
-    if (strcmp(rowkey, (*iter).second->start_row.c_str()) < 0)
-      return false;
+    if (strcmp(rowkey, cacheval->start_row.c_str()) < 0)
+      return 0;
   }
   else {
-    if (strcmp(rowkey, (*iter).second->start_row.c_str()) <= 0)
-      return false;
+    if (strcmp(rowkey, cacheval->start_row.c_str()) <= 0)
+      return 0;
   }
 
-  cacheval = (*iter).second;
-  move_to_head(cacheval);
+  // Stamp with the writers' clock, writing only if the stamp is stale
+  uint64_t now = m_clock.load(memory_order_relaxed);
+  if (cacheval->last_access.load(memory_order_relaxed) != now)
+    cacheval->last_access.store(now, memory_order_relaxed);
 
-  return true;
+  return cacheval;
+}
+
+LocationCache::TableIndex *
+LocationCache::find_table(const Directory *directory, const char *table_name) {
+  auto iter = std::lower_bound(directory->tables.begin(),
+                               directory->tables.end(), table_name,
+                               [](const TableIndex *table, const char *name) {
+                                 return strcmp(table->name.c_str(), name) < 0;
+                               });
+  if (iter == directory->tables.end() || (*iter)->name != table_name)
+    return 0;
+  return *iter;
 }
 
+LocationCache::TableIndex *
+LocationCache::get_table(const char *table_name, Retired &retired) {
+  const Directory *directory = m_directory.load();
+  TableIndex *table = find_table(directory, table_name);
+  if (table)
+    return table;
+
+  m_tables.push_back(make_unique<TableIndex>());
+  table = m_tables.back().get();
+  table->name = table_name;
+
+  Directory *new_directory = new Directory(*directory);
+  auto iter = std::lower_bound(new_directory->tables.begin(),
+                               new_directory->tables.end(), table,
+                               [](const TableIndex *t1, const TableIndex *t2) {
+                                 return t1->name < t2->name;
+                               });
+  new_directory->tables.insert(iter, table);
+  m_directory.store(new_directory);
+  retired.directories.push_back(directory);
+  return table;
+}
 
 /**
- * MoveToHead
+ * Replaces the index of <code>table</code>.  If the new index is empty the
+ * table is removed from the directory and retired along with it, so that
+ * the cache doesn't keep an index for every table it has ever seen.
  */
-void LocationCache::move_to_head(Value *cacheval) {
+void LocationCache::publish(TableIndex *table, const TableSnapshot *snapshot,
+                            Retired &retired) {
+  const TableSnapshot *old_snapshot = table->snapshot.load();
+  table->snapshot.store(snapshot);
+  if (old_snapshot)
+    retired.snapshots.push_back(old_snapshot);
+  if (snapshot->size == 0)
+    remove_table(table, retired);
+}
 
-  if (m_head == cacheval)
-    return;
+void LocationCache::remove_table(TableIndex *table, Retired &retired) {
+  const Directory *directory = m_directory.load();
+  Directory *new_directory = new Directory(*directory);
+  auto &tables = new_directory->tables;
+  tables.erase(std::remove(tables.begin(), tables.end(), table), tables.end());
+  m_directory.store(new_directory);
+  retired.directories.push_back(directory);
+
+  auto iter = std::find_if(m_tables.begin(), m_tables.end(),
+                           [table](const unique_ptr<TableIndex> &t) {
+                             return t.get() == table;
+                           });
+  assert(iter != m_tables.end());
+  retired.tables.push_back(std::move(*iter));
+  m_tables.erase(iter);
+}
 
-  // unstich entry from cache
-  cacheval->next->prev = cacheval->prev;
-  if (cacheval->prev == 0)
-    m_tail = cacheval->next;
-  else
-    cacheval->prev->next = cacheval->next;
+/**
+ * Evicts the least recently used unpegged values.  Pegged values met along
+ * the way are stamped as just used, as if moved to the head of an LRU list.
+ */
+void LocationCache::evict(Retired &retired) {
+  struct Candidate {
+    const Value *value;
+    TableIndex *table;
+    uint64_t last_access;
+    size_t order;
+  };
+  vector<Candidate> values;
+  size_t pegged {};
+
+  // Access stamps only advance on insert, so ties are common and are
+  // broken by table and row order to keep eviction deterministic
+  values.reserve(m_entries);
+  for (auto &table : m_tables) {
+    const TableSnapshot *snapshot = table->snapshot.load();
+    if (snapshot)
+      for (auto &chunk : snapshot->chunks)
+        for (auto &value : *chunk) {
+          values.push_back({value.get(), table.get(),
+                value->last_access.load(memory_order_relaxed), values.size()});
+          if (value->pegged)
+            pegged++;
+        }
+  }
+
+  size_t target = std::max<size_t>(1, m_max_entries / EVICTION_DIVISOR);
+  size_t candidates = std::min(values.size(), target + pegged);
+  partial_sort(values.begin(), values.begin() + candidates, values.end(),
+               [](const Candidate &v1, const Candidate &v2) {
+                 if (v1.last_access != v2.last_access)
+                   return v1.last_access < v2.last_access;
+                 return v1.order < v2.order;
+               });
+
+  map<TableIndex *, set<const Value *>> victims;
+  size_t evicted {};
+  for (size_t i=0; i<candidates && evicted < target; i++) {
+    if (values[i].value->pegged)
+      values[i].value->last_access.store(++m_clock);
+    else {
+      victims[values[i].table].insert(values[i].value);
+      evicted++;
+    }
+  }
 
-  cacheval->next = 0;
-  cacheval->prev = m_head;
-  m_head->next = cacheval;
-  m_head = cacheval;
+  for (auto &entry : victims)
+    publish(entry.first, remove_values(entry.first->snapshot.load(),
+                                       entry.second), retired);
+  m_entries -= evicted;
 }
 
+void LocationCache::reclaim(Retired &retired) {
+  if (retired.snapshots.empty() && retired.directories.empty())
+    return;
+  synchronize();
+  for (auto snapshot : retired.snapshots)
+    delete snapshot;
+  for (auto directory : retired.directories)
+    delete directory;
+  for (auto &table : retired.tables)
+    delete table->snapshot.load();
+}
 
 /**
- * remove
+ * Waits for lookups that may be reading replaced structures.  Advancing the
+ * epoch sends new lookups to the other parity's counts, so the counts of
+ * the old parity drain to zero.
  */
-void LocationCache::remove(Value *cacheval) {
-  assert(cacheval);
-  if (m_tail == cacheval) {
-    m_tail = cacheval->next;
-    if (m_tail)
-      m_tail->prev = 0;
-    else {
-      assert (m_head == cacheval);
-      m_head = 0;
-    }
+void LocationCache::synchronize() {
+  uint64_t epoch = m_epoch.fetch_add(1);
+  for (auto &readers : m_readers) {
+    while (readers.count[epoch & 1].load() != 0)
+      this_thread::yield();
   }
-  else if (m_head == cacheval) {
-    m_head = m_head->prev;
-    m_head->next = 0;
+}
+
+const LocationCache::Value *
+LocationCache::lower_bound(const TableSnapshot *snapshot, const char *row) {
+  if (snapshot == 0)
+    return 0;
+  size_t i = chunk_index(snapshot->chunks, row);
+  if (i == snapshot->chunks.size())
+    return 0;
+  const Chunk &chunk = *snapshot->chunks[i];
+  return chunk_lower_bound(chunk, row)->get();
+}
+
+/**
+ * Returns copy of <code>snapshot</code> with <code>value</code> added,
+ * replacing the value with the same end row if there is one.  Only the
+ * chunk receiving the value is copied, and it is split in two if it grows
+ * past #CHUNK_SIZE.
+ */
+LocationCache::TableSnapshot *
+LocationCache::add_value(const TableSnapshot *snapshot, const ValuePtr &value,
+                         bool *replaced) {
+  const char *row = value->end_row.empty() ? 0 : value->end_row.c_str();
+  TableSnapshot *new_snapshot = snapshot ?
+    new TableSnapshot(*snapshot) : new TableSnapshot();
+  auto &chunks = new_snapshot->chunks;
+
+  *replaced = false;
+
+  size_t i {};
+  if (chunks.empty())
+    chunks.push_back(make_shared<Chunk>());
+  else
+    i = std::min(chunk_index(chunks, row), chunks.size() - 1);
+  auto chunk = make_shared<Chunk>(*chunks[i]);
+  auto iter = chunk->begin() + (chunk_lower_bound(*chunk, row) - chunk->cbegin());
+
+  if (iter != chunk->end() && (*iter)->end_row == value->end_row) {
+    *iter = value;
+    *replaced = true;
   }
   else {
-    cacheval->next->prev = cacheval->prev;
-    cacheval->prev->next = cacheval->next;
+    chunk->insert(iter, value);
+    new_snapshot->size++;
   }
-  m_location_map.erase(cacheval->map_iter);
-  delete cacheval;
+
+  chunks[i] = chunk;
+  if (chunk->size() > CHUNK_SIZE) {
+    size_t half = chunk->size() / 2;
+    auto upper = make_shared<Chunk>(chunk->begin() + half, chunk->end());
+    chunk->resize(half);
+    chunks.insert(chunks.begin() + i + 1, upper);
+  }
+
+  return new_snapshot;
+}
+
+LocationCache::TableSnapshot *
+LocationCache::remove_value(const TableSnapshot *snapshot, const Value *value) {
+  const char *row = value->end_row.empty() ? 0 : value->end_row.c_str();
+  TableSnapshot *new_snapshot = new TableSnapshot(*snapshot);
+  auto &chunks = new_snapshot->chunks;
+
+  size_t i = chunk_index(chunks, row);
+  assert(i < chunks.size());
+  auto chunk = make_shared<Chunk>(*chunks[i]);
+  auto iter = chunk->begin() + (chunk_lower_bound(*chunk, row) - chunk->cbegin());
+  assert(iter != chunk->end() && iter->get() == value);
+  chunk->erase(iter);
+  new_snapshot->size--;
+
+  if (chunk->empty())
+    chunks.erase(chunks.begin() + i);
+  else
+    chunks[i] = chunk;
+
+  return new_snapshot;
 }
 
+LocationCache::TableSnapshot *
+LocationCache::remove_values(const TableSnapshot *snapshot,
+                             const set<const Value *> &values) {
+  TableSnapshot *new_snapshot = new TableSnapshot();
+  shared_ptr<Chunk> chunk;
+
+  for (auto &old_chunk : snapshot->chunks) {
+    for (auto &value : *old_chunk) {
+      if (values.count(value.get()))
+        continue;
+      if (!chunk || chunk->size() == CHUNK_SIZE) {
+        chunk = make_shared<Chunk>();
+        chunk->reserve(CHUNK_SIZE);
+        new_snapshot->chunks.push_back(chunk);
+      }
+      chunk->push_back(value);
+      new_snapshot->size++;
+    }
+  }
+
+  return new_snapshot;
+}
 
 const CommAddress *LocationCache::get_constant_address(const CommAddress &addr) {
   AddressSet::iterator iter = m_addresses.find(&addr);
@@ -288,4 +553,3 @@ const CommAddress *LocationCache::get_constant_address(const CommAddress &addr)
   m_addresses.insert(new_addr);
   return new_addr;
 }
-
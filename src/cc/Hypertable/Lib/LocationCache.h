@@ -24,79 +24,53 @@
 
 #include "RangeLocationInfo.h"
 
-#include <Common/FlyweightString.h>
 #include <Common/InetAddr.h>
 #include <Common/StringExt.h>
 
-#include <cstring>
-#include <ostream>
-#include <map>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <mutex>
+#include <ostream>
 #include <set>
+#include <string>
+#include <vector>
 
 namespace Hypertable {
 
   /**
-   * Key type for Range location cache
-   */
-  struct LocationCacheKey {
-    const char *table_name;
-    const char *end_row;
-  };
-
-  /**
-   * Less than operator for LocationCacheKey
-   */
-  inline bool operator<(const LocationCacheKey &x, const LocationCacheKey &y) {
-    int cmp = strcmp(x.table_name, y.table_name);
-    if (cmp)
-      return cmp < 0;
-    if (y.end_row == 0)
-      return (x.end_row == 0) ? false : true;
-    else if (x.end_row == 0)
-      return false;
-    return strcmp(x.end_row, y.end_row) < 0;
-  }
-
-  /**
-   * Equality operator for LocationCacheKey
-   */
-  inline bool operator==(const LocationCacheKey &x, const LocationCacheKey &y) {
-    if (strcmp(x.table_name, y.table_name))
-      return false;
-    if (x.end_row == 0)
-      return (y.end_row == 0) ? true : false;
-    else if (y.end_row == 0)
-      return false;
-    return !strcmp(x.end_row, y.end_row);
-  }
-
-  /**
-   * Equality operator for LocationCacheKey
-   */
-  inline bool operator!=(const LocationCacheKey &x, const LocationCacheKey &y) {
-    return !(x == y);
-  }
-
-
-  /**
-   *  This class acts as a cache of Range location information.  It
+   * Cache of range location information.
+   * Lookups are lock-free.  Each table has its own index of cached ranges,
+   * ordered by end row and split into chunks of at most #CHUNK_SIZE
+   * entries, which is read through an atomic pointer and replaced
+   * copy-on-write by writers, so a writer copies one chunk and the table's
+   * chunk list rather than the whole cache.  Replaced indexes are freed once
+   * every lookup that could still be reading them has finished, tracked
+   * with two-phase reader counts spread over #READER_STRIPES cache lines.
+   * Writers serialize on a mutex.  Recency is recorded with a per-entry
+   * access stamp instead of a shared list.  The stamp is approximate: the
+   * clock only advances on insert, and a lookup copies it into the entry it
+   * finds only if the entry's stamp is stale, so lookups of hot entries
+   * write no shared memory.  When the cache is full the least recently used
+   * 1/#EVICTION_DIVISOR of the entries are evicted together so the cost of
+   * finding them is spread over many inserts.  A table's index is dropped
+   * once its last entry is removed.
    */
   class LocationCache {
   public:
-    /**
-     */
+
+    /// Cached range location.  Only #last_access changes once the value has
+    /// been published.
     struct Value {
-      struct Value *prev, *next;
-      std::map<LocationCacheKey, Value *>::iterator map_iter;
       std::string start_row;
       std::string end_row;
       const CommAddress *addrp;
       bool pegged;
+      /// Logical time of insert or last successful lookup
+      mutable std::atomic<uint64_t> last_access;
     };
 
-    LocationCache(uint32_t max_entries) : m_mutex(), m_location_map(),
-        m_head(0), m_tail(0), m_max_entries(max_entries) { return; }
+    LocationCache(uint32_t max_entries);
     ~LocationCache();
 
     void insert(const char * table_name, RangeLocationInfo &range_loc_info,
@@ -112,10 +86,74 @@ namespace Hypertable {
     void display(std::ostream &);
 
   private:
-    bool lookup(const char *table_name, const char *rowkey,
-                Value*& cacheval, bool inclusive);
-    void move_to_head(Value *cacheval);
-    void remove(Value *cacheval);
+
+    /// Maximum number of values in a chunk
+    static const size_t CHUNK_SIZE = 64;
+
+    /// Number of reader count stripes
+    static const size_t READER_STRIPES = 16;
+
+    /// Fraction of the capacity evicted at once when the cache is full
+    static const size_t EVICTION_DIVISOR = 64;
+
+    typedef std::shared_ptr<Value> ValuePtr;
+
+    /// Run of values sorted by end row
+    typedef std::vector<ValuePtr> Chunk;
+
+    typedef std::shared_ptr<const Chunk> ChunkPtr;
+
+    /// Immutable index of the cached ranges of one table
+    struct TableSnapshot {
+      std::vector<ChunkPtr> chunks;
+      size_t size {};
+    };
+
+    /// Cached ranges of one table
+    struct TableIndex {
+      std::string name;
+      std::atomic<const TableSnapshot *> snapshot {nullptr};
+    };
+
+    /// Immutable list of tables, sorted by name
+    struct Directory {
+      std::vector<TableIndex *> tables;
+    };
+
+    /// Reader counts for both epoch parities, one cache line per stripe
+    struct ReaderCounts {
+      std::atomic<size_t> count[2];
+      char padding[64 - 2*sizeof(std::atomic<size_t>)];
+    };
+
+    /// Structures replaced by a writer, freed by reclaim()
+    struct Retired {
+      std::vector<const TableSnapshot *> snapshots;
+      std::vector<const Directory *> directories;
+      std::vector<std::unique_ptr<TableIndex>> tables;
+    };
+
+    class ReadGuard;
+
+    const Value *find(const char *table_name, const char *rowkey,
+                      bool inclusive);
+    TableIndex *find_table(const Directory *directory, const char *table_name);
+    TableIndex *get_table(const char *table_name, Retired &retired);
+    void publish(TableIndex *table, const TableSnapshot *snapshot,
+                 Retired &retired);
+    void remove_table(TableIndex *table, Retired &retired);
+    void evict(Retired &retired);
+    void reclaim(Retired &retired);
+    void synchronize();
+
+    static const Value *lower_bound(const TableSnapshot *snapshot,
+                                    const char *row);
+    static TableSnapshot *add_value(const TableSnapshot *snapshot,
+                                    const ValuePtr &value, bool *replaced);
+    static TableSnapshot *remove_value(const TableSnapshot *snapshot,
+                                       const Value *value);
+    static TableSnapshot *remove_values(const TableSnapshot *snapshot,
+                                        const std::set<const Value *> &values);
 
     const CommAddress *get_constant_address(const CommAddress &addr);
 
@@ -126,16 +164,31 @@ namespace Hypertable {
       }
     };
 
-    typedef std::map<LocationCacheKey, Value *> LocationMap;
     typedef std::set<const CommAddress *, CommAddressPointerLt> AddressSet;
 
+    /// %Mutex serializing writers
     std::mutex m_mutex;
-    LocationMap    m_location_map;
+
+    /// Current table directory
+    std::atomic<const Directory *> m_directory {nullptr};
+
+    /// Indexes of tables with cached values
+    std::vector<std::unique_ptr<TableIndex>> m_tables;
+
+    /// Reader epoch, its low bit selects the reader counts in use
+    std::atomic<uint64_t> m_epoch {0};
+
+    /// Count of lookups in progress, by stripe and epoch parity
+    ReaderCounts m_readers[READER_STRIPES];
+
+    /// Logical clock for access stamps, advanced by inserts
+    std::atomic<uint64_t> m_clock {0};
+
+    /// Number of cached values
+    size_t m_entries {};
+
     AddressSet     m_addresses;
-    Value         *m_head;
-    Value         *m_tail;
     uint32_t       m_max_entries;
-    FlyweightString m_strings;
   };
 
   /// Smart pointer to LocationCache
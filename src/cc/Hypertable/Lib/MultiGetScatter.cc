@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for MultiGetScatter.
+/// This file contains the definitions for MultiGetScatter, a class that
+/// scatters the rows of a <i>multi get</i> across the ranges that hold them
+/// and gathers the results, retrying the rows of ranges that have split or
+/// moved.
+
+#include <Common/Compat.h>
+
+#include "MultiGetScatter.h"
+
+#include <AsyncComm/DispatchHandlerSynchronizer.h>
+#include <AsyncComm/Protocol.h>
+
+#include <Common/Error.h>
+#include <Common/StringExt.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <thread>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  /// Outstanding <i>multi get</i> request for the rows of one range.
+  struct Request {
+    RangeLocationInfo location;
+    vector<const char *> rows;
+    DispatchHandlerSynchronizer handler;
+  };
+
+}
+
+
+void MultiGetScatter::run(const vector<String> &rows,
+                          vector<ScanBlockPtr> &blocks) {
+
+  vector<String> sorted_rows(rows);
+  sort(sorted_rows.begin(), sorted_rows.end());
+  sorted_rows.erase(unique(sorted_rows.begin(), sorted_rows.end()),
+                    sorted_rows.end());
+
+  vector<const char *> pending;
+  pending.reserve(sorted_rows.size());
+  for (const auto &row : sorted_rows)
+    pending.push_back(row.c_str());
+
+  // Results, keyed by first row of request, so they are gathered in row order
+  map<const char *, ScanBlockPtr, LtCstr> results;
+  bool hard = false;
+  // Halved each time a server rejects a request as too large
+  size_t max_rows = pending.size();
+
+  while (!pending.empty()) {
+    vector<unique_ptr<Request>> requests;
+
+    // Scatter rows by range; since the rows are sorted, one lookup per range
+    auto iter = pending.begin();
+    while (iter != pending.end()) {
+      unique_ptr<Request> request(new Request());
+      m_target->locate(*iter, hard, &request->location);
+      do {
+        request->rows.push_back(*iter);
+        ++iter;
+      } while (iter != pending.end() && request->rows.size() < max_rows &&
+               strcmp(*iter, request->location.end_row.c_str()) <= 0);
+      requests.push_back(move(request));
+    }
+    pending.clear();
+    hard = false;
+
+    for (auto &request : requests) {
+      try {
+        m_target->send(request->location, request->rows, &request->handler);
+      }
+      catch (Exception &e) {
+        if (e.code() != Error::COMM_NOT_CONNECTED &&
+            e.code() != Error::COMM_BROKEN_CONNECTION &&
+            e.code() != Error::COMM_INVALID_PROXY)
+          HT_THROW2(e.code(), e, e.what());
+        // deliver the error through the handler so it is retried below
+        EventPtr event = make_shared<Event>(Event::ERROR, e.code());
+        request->handler.handle(event);
+      }
+    }
+
+    // Gather results, collecting the rows that need to be retried
+    int last_error = Error::OK;
+    String last_error_msg;
+    bool wait = false;
+    for (auto &request : requests) {
+      EventPtr event;
+      if (request->handler.wait_for_reply(event)) {
+        auto scan_block = make_shared<ScanBlock>();
+        int error = scan_block->load(event);
+        if (error != Error::OK)
+          HT_THROWF(error, "Problem loading multi get response for rows "
+                    "'%s'..'%s'", request->rows.front(),
+                    request->rows.back());
+        results[request->rows.front()] = scan_block;
+        continue;
+      }
+      int error = Protocol::response_code(event);
+      switch (error) {
+      case Error::RANGESERVER_GENERATION_MISMATCH:
+        m_target->refresh(event);
+        wait = true;
+        break;
+      case Error::RANGESERVER_RANGE_NOT_FOUND:
+      case Error::COMM_NOT_CONNECTED:
+      case Error::COMM_BROKEN_CONNECTION:
+      case Error::COMM_INVALID_PROXY:
+        m_target->invalidate(request->rows.front());
+        hard = true;
+        wait = true;
+        break;
+      case Error::RANGESERVER_RESPONSE_TOO_LARGE:
+        // Resend in smaller batches right away; a single row can't be split
+        if (request->rows.size() == 1)
+          HT_THROW(error, Protocol::string_format_message(event));
+        max_rows = min(max_rows, request->rows.size() / 2);
+        break;
+      default:
+        HT_THROW(error, Protocol::string_format_message(event));
+      }
+      last_error = error;
+      last_error_msg = Protocol::string_format_message(event);
+      pending.insert(pending.end(), request->rows.begin(),
+                     request->rows.end());
+    }
+
+    if (!pending.empty()) {
+      sort(pending.begin(), pending.end(), LtCstr());
+      if (!wait)
+        continue;
+      // wait a bit before trying again
+      if (m_timer.remaining() <= m_retry_wait_ms)
+        HT_THROWF(Error::REQUEST_TIMEOUT, "multi_get() - %s - %s",
+                  Error::get_text(last_error), last_error_msg.c_str());
+      this_thread::sleep_for(chrono::milliseconds(m_retry_wait_ms));
+    }
+  }
+
+  blocks.clear();
+  blocks.reserve(results.size());
+  for (auto &entry : results)
+    blocks.push_back(entry.second);
+}
@@ -0,0 +1,123 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for MultiGetScatter.
+/// This file contains the type declarations for MultiGetScatter, a class
+/// that scatters the rows of a <i>multi get</i> across the ranges that hold
+/// them and gathers the results, retrying the rows of ranges that have
+/// split or moved.
+
+#ifndef Hypertable_Lib_MultiGetScatter_h
+#define Hypertable_Lib_MultiGetScatter_h
+
+#include <Hypertable/Lib/RangeLocationInfo.h>
+#include <Hypertable/Lib/ScanBlock.h>
+
+#include <AsyncComm/DispatchHandler.h>
+#include <AsyncComm/Event.h>
+
+#include <Common/Timer.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Hypertable {
+
+  /// @addtogroup libHypertable
+  /// @{
+
+  /// Scatters the rows of a <i>multi get</i> across ranges.
+  /// The rows are sorted and grouped by the range that holds them, and one
+  /// request is sent for each range.  The rows of a request that fails
+  /// because its range has split, moved, or is unreachable are located
+  /// again, bypassing the location cache, and resent after a short wait
+  /// until the timer expires.  When a server rejects a request because its
+  /// response would be too large, that request's row count is halved and
+  /// the rows are resent at once, in requests no larger than that.
+  class MultiGetScatter {
+  public:
+
+    /// Destination of <i>multi get</i> requests.
+    class Target {
+    public:
+      virtual ~Target() { }
+
+      /// Locates the range holding a row.
+      /// @param row Row to locate
+      /// @param hard <i>true</i> if the location cache must not be consulted
+      /// @param location Address of location of range holding <code>row</code>
+      virtual void locate(const char *row, bool hard,
+                          RangeLocationInfo *location) = 0;
+
+      /// Invalidates the cached location of a row.
+      /// @param row Row whose location is stale
+      virtual void invalidate(const char *row) = 0;
+
+      /// Sends a <i>multi get</i> request for the rows of one range.
+      /// @param location Location of range
+      /// @param rows Sorted rows within range
+      /// @param handler Dispatch handler to receive response
+      virtual void send(const RangeLocationInfo &location,
+                        const std::vector<const char *> &rows,
+                        DispatchHandler *handler) = 0;
+
+      /// Handles a schema generation mismatch.
+      /// Refreshes the table schema so that the request can be resent, or
+      /// throws an exception if the schema may not be refreshed.
+      /// @param event Error event
+      virtual void refresh(EventPtr &event) = 0;
+    };
+
+    /// Constructor.
+    /// @param target Destination of requests
+    /// @param timer Timer bounding the whole operation
+    /// @param retry_wait_ms Time to wait before resending failed requests
+    MultiGetScatter(Target *target, Timer &timer,
+                    uint32_t retry_wait_ms = 1000)
+      : m_target(target), m_timer(timer), m_retry_wait_ms(retry_wait_ms) { }
+
+    /// Fetches rows.
+    /// Duplicate rows are fetched once.
+    /// @param rows Rows to fetch, in any order
+    /// @param blocks Scan blocks holding the cells of <code>rows</code>, in
+    /// row order
+    void run(const std::vector<std::string> &rows,
+             std::vector<ScanBlockPtr> &blocks);
+
+  private:
+
+    /// Destination of requests
+    Target *m_target;
+
+    /// Timer bounding the whole operation
+    Timer &m_timer;
+
+    /// Time to wait before resending failed requests
+    uint32_t m_retry_wait_ms;
+  };
+
+  /// @}
+
+}
+
+#endif // Hypertable_Lib_MultiGetScatter_h
@@ -42,6 +42,7 @@
 #include "Request/Parameters/GetStatistics.h"
 #include "Request/Parameters/Heapcheck.h"
 #include "Request/Parameters/LoadRange.h"
+#include "Request/Parameters/MultiGet.h"
 #include "Request/Parameters/PhantomCommitRanges.h"
 #include "Request/Parameters/PhantomLoad.h"
 #include "Request/Parameters/PhantomPrepareRanges.h"
@@ -286,6 +287,54 @@ Lib::RangeServer::Client::do_create_scanner(const CommAddress &addr,
 }
 
 
+void
+Lib::RangeServer::Client::multi_get(const CommAddress &addr,
+    const TableIdentifier &table, const RangeSpec &range,
+    const ScanSpec &scan_spec, const std::vector<const char *> &rows,
+    DispatchHandler *handler) {
+  CommHeader header(Protocol::COMMAND_MULTI_GET);
+  header.flags |= CommHeader::FLAGS_BIT_PROFILE;
+  if (table.is_system())
+    header.flags |= CommHeader::FLAGS_BIT_URGENT;
+  Request::Parameters::MultiGet params(table, range, scan_spec, rows);
+  CommBufPtr cbuf(new CommBuf(header, params.encoded_length()));
+  params.encode(cbuf->get_data_ptr_address());
+  send_message(addr, cbuf, handler, m_default_timeout_ms);
+}
+
+void
+Lib::RangeServer::Client::multi_get(const CommAddress &addr,
+    const TableIdentifier &table, const RangeSpec &range,
+    const ScanSpec &scan_spec, const std::vector<const char *> &rows,
+    DispatchHandler *handler, Timer &timer) {
+  CommHeader header(Protocol::COMMAND_MULTI_GET);
+  header.flags |= CommHeader::FLAGS_BIT_PROFILE;
+  if (table.is_system())
+    header.flags |= CommHeader::FLAGS_BIT_URGENT;
+  Request::Parameters::MultiGet params(table, range, scan_spec, rows);
+  CommBufPtr cbuf(new CommBuf(header, params.encoded_length()));
+  params.encode(cbuf->get_data_ptr_address());
+  send_message(addr, cbuf, handler, timer.remaining());
+}
+
+void
+Lib::RangeServer::Client::multi_get(const CommAddress &addr,
+    const TableIdentifier &table, const RangeSpec &range,
+    const ScanSpec &scan_spec, const std::vector<const char *> &rows,
+    ScanBlock &scan_block, Timer &timer) {
+  DispatchHandlerSynchronizer sync_handler;
+  EventPtr event;
+  multi_get(addr, table, range, scan_spec, rows, &sync_handler, timer);
+  if (!sync_handler.wait_for_reply(event))
+    HT_THROW(Hypertable::Protocol::response_code(event),
+             String("RangeServer multi_get() failure : ")
+             + Hypertable::Protocol::string_format_message(event));
+  else {
+    HT_ASSERT(scan_block.load(event) == Error::OK);
+  }
+}
+
+
 void
 Lib::RangeServer::Client::destroy_scanner(const CommAddress &addr, int32_t scanner_id,
                         DispatchHandler *handler) {
@@ -48,6 +48,7 @@
 
 #include <map>
 #include <memory>
+#include <vector>
 
 namespace Hypertable {
 namespace Lib {
@@ -203,6 +204,49 @@ namespace RangeServer {
                         const RangeSpec &range, const ScanSpec &scan_spec,
                         ScanBlock &scan_block, Timer &timer);
 
+    /** Issues a "multi get" request asynchronously.  The response is
+     * encoded like the response to a "create scanner" request and holds the
+     * cells of every requested row; the scanner ID is always zero.
+     * @param addr address of RangeServer
+     * @param table table identifier
+     * @param range range specification
+     * @param scan_spec scan specification (without row or cell intervals)
+     * @param rows rows to fetch, sorted and without duplicates
+     * @param handler response handler
+     */
+    void multi_get(const CommAddress &addr, const TableIdentifier &table,
+                   const RangeSpec &range, const ScanSpec &scan_spec,
+                   const std::vector<const char *> &rows,
+                   DispatchHandler *handler);
+
+    /** Issues a "multi get" request asynchronously with timer.
+     * @param addr address of RangeServer
+     * @param table table identifier
+     * @param range range specification
+     * @param scan_spec scan specification (without row or cell intervals)
+     * @param rows rows to fetch, sorted and without duplicates
+     * @param handler response handler
+     * @param timer timer
+     */
+    void multi_get(const CommAddress &addr, const TableIdentifier &table,
+                   const RangeSpec &range, const ScanSpec &scan_spec,
+                   const std::vector<const char *> &rows,
+                   DispatchHandler *handler, Timer &timer);
+
+    /** Issues a synchronous "multi get" request with timer.
+     * @param addr address of RangeServer
+     * @param table table identifier
+     * @param range range specification
+     * @param scan_spec scan specification (without row or cell intervals)
+     * @param rows rows to fetch, sorted and without duplicates
+     * @param scan_block block of return key/value pairs
+     * @param timer timer
+     */
+    void multi_get(const CommAddress &addr, const TableIdentifier &table,
+                   const RangeSpec &range, const ScanSpec &scan_spec,
+                   const std::vector<const char *> &rows,
+                   ScanBlock &scan_block, Timer &timer);
+
     /** Issues a "destroy scanner" request asynchronously.
      * @param addr address of RangeServer
      * @param scanner_id Scanner ID returned from a call to create_scanner.
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for MultiGet request parameters.
+/// This file contains definitions for MultiGet, a class for encoding and
+/// decoding paramters to the <i>multi get</i> %RangeServer function.
+
+#include <Common/Compat.h>
+
+#include "MultiGet.h"
+
+#include <Common/Logger.h>
+#include <Common/Serialization.h>
+
+using namespace Hypertable;
+using namespace Hypertable::Lib::RangeServer::Request::Parameters;
+
+uint8_t MultiGet::encoding_version() const {
+  return 1;
+}
+
+size_t MultiGet::encoded_length_internal() const {
+  size_t length = m_table.encoded_length() + m_range_spec.encoded_length() +
+    m_scan_spec.encoded_length() + 4;
+  for (auto row : m_rows)
+    length += Serialization::encoded_length_vstr(row);
+  return length;
+}
+
+/// @details
+/// Encoding is as follows:
+/// <table>
+/// <tr>
+/// <th>Encoding</th>
+/// <th>Description</th>
+/// </tr>
+/// <tr>
+/// <td>TableIdentifier</td>
+/// <td>%Table identifier</td>
+/// </tr>
+/// <tr>
+/// <td>RangeSpec</td>
+/// <td>%Range specification</td>
+/// </tr>
+/// <tr>
+/// <td>ScanSpec</td>
+/// <td>Scan specification</td>
+/// </tr>
+/// <tr>
+/// <td>i32</td>
+/// <td>Row count</td>
+/// </tr>
+/// <tr>
+/// <td>For each row ...</td>
+/// </tr>
+/// <tr>
+/// <td>vstr</td>
+/// <td>Row key</td>
+/// </tr>
+/// </table>
+void MultiGet::encode_internal(uint8_t **bufp) const {
+  m_table.encode(bufp);
+  m_range_spec.encode(bufp);
+  m_scan_spec.encode(bufp);
+  Serialization::encode_i32(bufp, m_rows.size());
+  for (auto row : m_rows)
+    Serialization::encode_vstr(bufp, row);
+}
+
+void MultiGet::decode_internal(uint8_t version, const uint8_t **bufp,
+                               size_t *remainp) {
+  m_table.decode(bufp, remainp);
+  m_range_spec.decode(bufp, remainp);
+  m_scan_spec.decode(bufp, remainp);
+  size_t count = (size_t)Serialization::decode_i32(bufp, remainp);
+  m_rows.clear();
+  m_rows.reserve(count);
+  for (size_t i=0; i<count; i++)
+    m_rows.push_back(Serialization::decode_vstr(bufp, remainp));
+}
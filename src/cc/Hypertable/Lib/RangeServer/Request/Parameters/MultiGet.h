@@ -0,0 +1,128 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for MultiGet request parameters.
+/// This file contains declarations for MultiGet, a class for encoding and
+/// decoding paramters to the <i>multi get</i> %RangeServer function.
+
+#ifndef Hypertable_Lib_RangeServer_Request_Parameters_MultiGet_h
+#define Hypertable_Lib_RangeServer_Request_Parameters_MultiGet_h
+
+#include <Hypertable/Lib/RangeSpec.h>
+#include <Hypertable/Lib/ScanSpec.h>
+#include <Hypertable/Lib/TableIdentifier.h>
+
+#include <Common/Serializable.h>
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace Hypertable {
+namespace Lib {
+namespace RangeServer {
+namespace Request {
+namespace Parameters {
+
+  /// @addtogroup libHypertableRangeServerRequestParameters
+  /// @{
+
+  /// %Request parameters for <i>multi get</i> function.
+  class MultiGet : public Serializable {
+  public:
+
+    /// Constructor.
+    /// Empty initialization for decoding.
+    MultiGet() {}
+
+    /// Constructor.
+    /// Initializes with parameters for encoding.
+    /// @param table %Table identifier
+    /// @param range_spec %Range specification
+    /// @param scan_spec Scan specification (without row or cell intervals)
+    /// @param rows Rows to fetch, sorted and without duplicates
+    MultiGet(const TableIdentifier &table, const RangeSpec &range_spec,
+             const ScanSpec &scan_spec, const std::vector<const char *> &rows)
+      : m_table(table), m_range_spec(range_spec), m_scan_spec(scan_spec),
+        m_rows(rows) {}
+
+    /// Gets table identifier
+    /// @return %Table identifier
+    const TableIdentifier &table() { return m_table; }
+
+    /// Gets range specification
+    /// @return %Range specification
+    const RangeSpec &range_spec() { return m_range_spec; }
+
+    /// Gets scan specification
+    /// @return Scan specification
+    const ScanSpec &scan_spec() { return m_scan_spec; }
+
+    /// Gets rows to fetch.
+    /// When decoded, the row pointers point into the decode buffer.
+    /// @return Sorted vector of rows
+    const std::vector<const char *> &rows() { return m_rows; }
+
+  private:
+
+    /// Returns encoding version.
+    /// @return Encoding version
+    uint8_t encoding_version() const override;
+
+    /// Returns internal serialized length.
+    /// @return Internal serialized length
+    /// @see encode_internal() for encoding format
+    size_t encoded_length_internal() const override;
+
+    /// Writes serialized representation of object to a buffer.
+    /// @param bufp Address of destination buffer pointer (advanced by call)
+    void encode_internal(uint8_t **bufp) const override;
+
+    /// Reads serialized representation of object from a buffer.
+    /// @param version Encoding version
+    /// @param bufp Address of destination buffer pointer (advanced by call)
+    /// @param remainp Address of integer holding amount of serialized object
+    /// remaining
+    /// @see encode_internal() for encoding format
+    void decode_internal(uint8_t version, const uint8_t **bufp,
+			 size_t *remainp) override;
+
+    /// %Table identifier
+    TableIdentifier m_table;
+
+    /// %Range specification
+    RangeSpec m_range_spec;
+
+    /// Scan specification
+    ScanSpec m_scan_spec;
+
+    /// Rows to fetch
+    std::vector<const char *> m_rows;
+
+  };
+
+  /// @}
+
+}}}}}
+
+#endif // Hypertable_Lib_RangeServer_Request_Parameters_MultiGet_h
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for ScanAggregateCombiner.
+/// This file contains the definitions for ScanAggregateCombiner, a class
+/// that combines the partial aggregates returned by the RangeServers for an
+/// aggregate scan.
+
+#include <Common/Compat.h>
+
+#include "ScanAggregateCombiner.h"
+
+#include <Hypertable/Lib/ScanSpec.h>
+
+#include <Common/Logger.h>
+#include <Common/String.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+using namespace Hypertable;
+using namespace Hypertable::Lib;
+using namespace std;
+
+namespace {
+
+  /// Parses the ASCII integer value of a partial aggregate.
+  bool aggregate_value(const Cell &cell, int64_t *valuep) {
+    char buf[32];
+    if (cell.value_len == 0 || cell.value_len >= sizeof(buf))
+      return false;
+    memcpy(buf, cell.value, cell.value_len);
+    buf[cell.value_len] = 0;
+    char *end;
+    errno = 0;
+    *valuep = strtoll(buf, &end, 10);
+    return errno == 0 && *end == 0;
+  }
+
+}
+
+
+void ScanAggregateCombiner::combine(Lib::ScanCells &cells) {
+  CellsBuilderPtr output = make_shared<CellsBuilder>();
+  Cells input;
+
+  cells.get(input);
+
+  for (auto &cell : input) {
+    if (!m_groups.empty() && m_row.compare(cell.row_key)) {
+      flush(*output);
+      m_groups.clear();
+    }
+    if (m_groups.empty())
+      m_row = cell.row_key;
+    add(cell);
+  }
+
+  if (cells.get_eos()) {
+    flush(*output);
+    m_groups.clear();
+  }
+
+  cells.set_cells(output);
+}
+
+
+void ScanAggregateCombiner::add(const Cell &cell) {
+  int64_t value;
+
+  if (!aggregate_value(cell, &value)) {
+    HT_WARNF("Ignoring bad partial aggregate '%s' for row '%s'",
+             String((const char *)cell.value, cell.value_len).c_str(),
+             cell.row_key);
+    return;
+  }
+
+  const char *family = cell.column_family ? cell.column_family : "";
+  auto iter = find_if(m_groups.begin(), m_groups.end(),
+                      [family](const Group &group) {
+                        return group.family == family;
+                      });
+
+  if (iter == m_groups.end()) {
+    Group group;
+    group.family = family;
+    group.value = value;
+    group.timestamp = cell.timestamp;
+    group.revision = cell.revision;
+    m_groups.push_back(group);
+    return;
+  }
+
+  switch (m_function) {
+  case ScanSpec::AGGREGATE_COUNT:
+  case ScanSpec::AGGREGATE_SUM:
+    iter->value += value;
+    break;
+  case ScanSpec::AGGREGATE_MIN:
+    iter->value = std::min(iter->value, value);
+    break;
+  case ScanSpec::AGGREGATE_MAX:
+    iter->value = std::max(iter->value, value);
+    break;
+  default:
+    break;
+  }
+  iter->timestamp = std::max(iter->timestamp, cell.timestamp);
+  iter->revision = std::max(iter->revision, cell.revision);
+}
+
+
+void ScanAggregateCombiner::flush(CellsBuilder &output) {
+  for (auto &group : m_groups) {
+    String value = format("%lld", (Lld)group.value);
+    Cell cell;
+    cell.row_key = m_row.c_str();
+    cell.column_family = group.family.c_str();
+    cell.column_qualifier = "";
+    cell.timestamp = group.timestamp;
+    cell.revision = group.revision;
+    cell.value = (const uint8_t *)value.c_str();
+    cell.value_len = value.length();
+    cell.flag = FLAG_INSERT;
+    output.add(cell);
+  }
+}
@@ -0,0 +1,116 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for ScanAggregateCombiner.
+/// This file contains the type declarations for ScanAggregateCombiner, a
+/// class that combines the partial aggregates returned by the RangeServers
+/// for an aggregate scan.
+
+#ifndef Hypertable_Lib_ScanAggregateCombiner_h
+#define Hypertable_Lib_ScanAggregateCombiner_h
+
+#include <Hypertable/Lib/ScanCells.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Hypertable {
+
+  /// @addtogroup libHypertable
+  /// @{
+
+  /// Combines partial aggregates of an aggregate scan.
+  /// Each RangeServer aggregates the part of a group that lies within one of
+  /// its ranges, so a group whose rows span ranges arrives as several
+  /// partial aggregate cells, one per range.  Partial aggregates of
+  /// different column families with the same group row are interleaved
+  /// (e.g. <code>(ab, cf1) (ab, cf2) (ab, cf1) (ab, cf2)</code> when rows
+  /// with prefix <code>ab</code> span two ranges), but since ranges are
+  /// scanned in row order, all of the partial aggregates with the same group
+  /// row arrive before any with a later one.  This class buffers the groups
+  /// of the current group row, keyed by column family, and emits one cell
+  /// per group once a later group row, or the end of the scan, arrives.
+  /// TableScannerAsync runs it over the cells of every scan callback, so
+  /// both synchronous and asynchronous scanners return combined aggregates.
+  class ScanAggregateCombiner {
+  public:
+
+    /// Constructor.
+    /// @param function Aggregate function of the scan
+    /// (ScanSpec::AGGREGATE_COUNT, etc.)
+    ScanAggregateCombiner(uint8_t function) : m_function(function) { }
+
+    /// Combines partial aggregates.
+    /// Replaces the cells of <code>cells</code> with the combined aggregates
+    /// of the group rows completed by them, in the order the groups first
+    /// appeared.  The groups of the last group row are held back until a
+    /// later group row arrives, unless <code>cells</code> is marked as the
+    /// end of the scan.
+    /// @param cells Partial aggregates returned by the RangeServers
+    void combine(Lib::ScanCells &cells);
+
+    /// Checks if groups are held back.
+    /// @return <i>true</i> if groups of a group row are held back
+    bool pending() const { return !m_groups.empty(); }
+
+  private:
+
+    /// Combined aggregate of one group
+    struct Group {
+      /// Column family
+      std::string family;
+      /// Aggregate
+      int64_t value {};
+      /// Largest timestamp of partial aggregates
+      int64_t timestamp {};
+      /// Largest revision of partial aggregates
+      uint64_t revision {};
+    };
+
+    /// Adds a partial aggregate to the group of its column family.
+    /// @param cell Partial aggregate of the current group row
+    void add(const Cell &cell);
+
+    /// Emits the groups of the current group row.
+    /// @param output Cells to which combined aggregates are added
+    void flush(CellsBuilder &output);
+
+    /// Aggregate function
+    uint8_t m_function;
+
+    /// Current group row
+    std::string m_row;
+
+    /// Groups of the current group row, in order of appearance
+    std::vector<Group> m_groups;
+  };
+
+  /// Smart pointer to ScanAggregateCombiner
+  typedef std::shared_ptr<ScanAggregateCombiner> ScanAggregateCombinerPtr;
+
+  /// @}
+
+}
+
+#endif // Hypertable_Lib_ScanAggregateCombiner_h
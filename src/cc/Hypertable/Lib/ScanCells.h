@@ -95,6 +95,12 @@ namespace Lib {
      */
     void add(Cell &cell, bool own = true);
 
+    /// Replaces the cells.
+    /// The scan blocks remain held, so <code>cells</code> may point into
+    /// them.
+    /// @param cells Replacement cells
+    void set_cells(CellsBuilderPtr &cells) { m_cells = cells; }
+
     /**
      * @param schema is the schema for the table being scanned
      * @param end_row the end_row of the scan for which we got these results
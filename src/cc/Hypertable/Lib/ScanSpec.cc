@@ -36,10 +36,29 @@ using namespace Hypertable;
 using namespace Hypertable::Lib;
 using namespace std;
 
+const char *ScanSpec::aggregate_name(uint8_t aggregate) {
+  switch (aggregate) {
+  case AGGREGATE_NONE:  return "NONE";
+  case AGGREGATE_COUNT: return "COUNT";
+  case AGGREGATE_SUM:   return "SUM";
+  case AGGREGATE_MIN:   return "MIN";
+  case AGGREGATE_MAX:   return "MAX";
+  default:
+    break;
+  }
+  return "UNKNOWN";
+}
+
 uint8_t ScanSpec::encoding_version() const {
+  if (aggregate != AGGREGATE_NONE || aggregate_row_prefix_length != -1)
+    return 2;
   return 1;
 }
 
+uint8_t ScanSpec::decoding_version() const {
+  return 2;
+}
+
 size_t ScanSpec::encoded_length_internal() const {
   size_t len = Serialization::encoded_length_vi32(row_offset) +
     Serialization::encoded_length_vi32(row_limit) +
@@ -62,6 +81,8 @@ size_t ScanSpec::encoded_length_internal() const {
     len += ci.encoded_length();
   for (auto &cp : column_predicates)
     len += cp.encoded_length();
+  if (encoding_version() >= 2)
+    len += 1 + Serialization::encoded_length_vi32(aggregate_row_prefix_length);
   return len + 8 + 8 + 5;
 }
 
@@ -97,6 +118,9 @@ size_t ScanSpec::encoded_length_internal() const {
 /// <tr><td>bool</td><td><i>scan and filter rows</i> flag</td></tr>
 /// <tr><td>bool</td><td><i>do not cache</i> flag</td></tr>
 /// <tr><td>bool</td><td><i>and column predicates</i> flag</td></tr>
+/// <tr><td>TableParts</td><td>Indices to rebuild</td></tr>
+/// <tr><td>i8</td><td>Aggregate function (version 2)</td></tr>
+/// <tr><td>vi32</td><td>Aggregate row prefix length (version 2)</td></tr>
 /// </table>
 void ScanSpec::encode_internal(uint8_t **bufp) const {
   Serialization::encode_vi32(bufp, row_offset);
@@ -123,6 +147,10 @@ void ScanSpec::encode_internal(uint8_t **bufp) const {
   Serialization::encode_bool(bufp, do_not_cache);
   Serialization::encode_bool(bufp, and_column_predicates);
   rebuild_indices.encode(bufp);
+  if (encoding_version() >= 2) {
+    Serialization::encode_i8(bufp, aggregate);
+    Serialization::encode_vi32(bufp, aggregate_row_prefix_length);
+  }
 }
 
 void ScanSpec::decode_internal(uint8_t version, const uint8_t **bufp,
@@ -161,6 +189,11 @@ void ScanSpec::decode_internal(uint8_t version, const uint8_t **bufp,
          do_not_cache = Serialization::decode_bool(bufp, remainp);
          and_column_predicates = Serialization::decode_bool(bufp, remainp);
          rebuild_indices.decode(bufp, remainp));
+  if (version >= 2) {
+    HT_TRY("decoding scan spec",
+           aggregate = Serialization::decode_i8(bufp, remainp);
+           aggregate_row_prefix_length = Serialization::decode_vi32(bufp, remainp));
+  }
 }
 
 const string ScanSpec::render_hql(const string &table) const {
@@ -294,6 +327,14 @@ const string ScanSpec::render_hql(const string &table) const {
   if (rebuild_indices)
     hql.append(format(" REBUILD_INDICES %s", rebuild_indices.to_string().c_str()));
 
+  if (aggregate) {
+    hql.append(format(" AGGREGATE %s", aggregate_name(aggregate)));
+    if (aggregate_row_prefix_length == 0)
+      hql.append(" BY COLUMN");
+    else if (aggregate_row_prefix_length > 0)
+      hql.append(format(" BY ROW_PREFIX %d", (int)aggregate_row_prefix_length));
+  }
+
   return hql;
 }
 
@@ -383,6 +424,11 @@ ostream &Hypertable::Lib::operator<<(ostream &os, const ScanSpec &scan_spec) {
   if (scan_spec.rebuild_indices)
     os << " rebuild_indices=" << scan_spec.rebuild_indices.to_string();
 
+  if (scan_spec.aggregate)
+    os << " aggregate=" << ScanSpec::aggregate_name(scan_spec.aggregate)
+       << " aggregate_row_prefix_length="
+       << scan_spec.aggregate_row_prefix_length;
+
   os << "}";
 
   return os;
@@ -402,7 +448,8 @@ ScanSpec::ScanSpec(CharArena &arena, const ScanSpec &ss)
     return_deletes(ss.return_deletes), keys_only(ss.keys_only),
     scan_and_filter_rows(ss.scan_and_filter_rows),
     do_not_cache(ss.do_not_cache), and_column_predicates(ss.and_column_predicates),
-    rebuild_indices(ss.rebuild_indices) {
+    rebuild_indices(ss.rebuild_indices), aggregate(ss.aggregate),
+    aggregate_row_prefix_length(ss.aggregate_row_prefix_length) {
   columns.reserve(ss.columns.size());
   row_intervals.reserve(ss.row_intervals.size());
   cell_intervals.reserve(ss.cell_intervals.size());
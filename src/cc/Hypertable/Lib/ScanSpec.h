@@ -55,6 +55,16 @@ namespace Lib {
   /// Scan predicate and control specification.
   class ScanSpec : public Serializable {
   public:
+
+    /// Aggregate functions evaluated by the RangeServer.
+    enum {
+      AGGREGATE_NONE = 0,
+      AGGREGATE_COUNT,
+      AGGREGATE_SUM,
+      AGGREGATE_MIN,
+      AGGREGATE_MAX
+    };
+
     ScanSpec() : time_interval(TIMESTAMP_MIN, TIMESTAMP_MAX) { }
     ScanSpec(CharArena &arena)
       : columns(CstrAlloc(arena)),
@@ -91,6 +101,8 @@ namespace Lib {
       scan_and_filter_rows = false;
       do_not_cache = false;
       and_column_predicates = false;
+      aggregate = AGGREGATE_NONE;
+      aggregate_row_prefix_length = -1;
     }
 
     /// Initialize another ScanSpec object with this copy sans the intervals.
@@ -118,10 +130,12 @@ namespace Lib {
       other.column_predicates = column_predicates;
       other.and_column_predicates = and_column_predicates;
       other.rebuild_indices = rebuild_indices;
+      other.aggregate = aggregate;
+      other.aggregate_row_prefix_length = aggregate_row_prefix_length;
     }
 
     bool cacheable() const {
-      if (do_not_cache || rebuild_indices)
+      if (do_not_cache || rebuild_indices || aggregate)
         return false;
       else if (row_intervals.size() == 1) {
         HT_ASSERT(row_intervals[0].start && row_intervals[0].end);
@@ -285,12 +299,36 @@ namespace Lib {
     bool and_column_predicates {};
     TableParts rebuild_indices;
 
+    /// Aggregate function (one of AGGREGATE_COUNT, AGGREGATE_SUM,
+    /// AGGREGATE_MIN, AGGREGATE_MAX) applied to the cells of each group, or
+    /// AGGREGATE_NONE to return the cells themselves.  Cells are grouped by
+    /// row (or row prefix) and column family.
+    uint8_t aggregate {};
+
+    /// Length of the row prefix by which cells are grouped for aggregation.
+    /// -1 groups cells by the full row key and 0 aggregates each column
+    /// family over all rows.
+    int32_t aggregate_row_prefix_length {-1};
+
+    /// Returns the name of an aggregate function.
+    /// @param aggregate Aggregate function
+    /// @return Name of <code>aggregate</code> (e.g. "COUNT")
+    static const char *aggregate_name(uint8_t aggregate);
+
   private:
 
     /// Returns encoding version.
+    /// Scan specifications that aggregate are encoded with version 2, which
+    /// older servers reject rather than returning unaggregated cells.  All
+    /// others are encoded with version 1, so plain scans stay readable by
+    /// older servers.
     /// @return Encoding version
     uint8_t encoding_version() const override;
 
+    /// Returns highest encoding version that can be decoded.
+    /// @return Encoding version of aggregate scan specifications
+    uint8_t decoding_version() const override;
+
     /// Returns internal serialized length.
     /// @return Internal serialized length
     /// @see encode_internal() for encoding format
@@ -386,6 +424,20 @@ namespace Lib {
      */
     void set_max_versions(uint32_t n) { m_scan_spec.max_versions = n; }
 
+    /**
+     * Sets the aggregate function evaluated by the RangeServers.  Instead of
+     * the matching cells, the scan returns one cell per group holding the
+     * aggregate, as an ASCII integer, of the group's cell values.
+     *
+     * @param aggregate aggregate function (ScanSpec::AGGREGATE_COUNT, etc.)
+     * @param row_prefix_length length of row prefix by which cells are
+     * grouped, -1 to group by full row, 0 to aggregate over all rows
+     */
+    void set_aggregate(uint8_t aggregate, int32_t row_prefix_length=-1) {
+      m_scan_spec.aggregate = aggregate;
+      m_scan_spec.aggregate_row_prefix_length = row_prefix_length;
+    }
+
     /**
      * Sets the regexp to filter rows by
      *
@@ -27,6 +27,10 @@
 #include "TableMutatorShared.h"
 #include "TableMutatorAsync.h"
 #include "ScanSpec.h"
+#include "MultiGetScatter.h"
+#include "ScanBlock.h"
+
+#include <Hypertable/Lib/RangeServer/Client.h>
 
 #include <AsyncComm/ApplicationQueue.h>
 
@@ -224,3 +228,103 @@ Table::create_scanner_async(ResultCallback *cb, const ScanSpec &scan_spec, uint3
                                 timeout_ms ? timeout_ms : m_timeout_ms, cb,
                                 flags);
 }
+
+namespace {
+
+  /// Sends the <i>multi get</i> requests of a Table to its RangeServers.
+  class MultiGetTarget : public MultiGetScatter::Target {
+  public:
+    MultiGetTarget(Table *table, TableIdentifierManaged &table_id,
+                   SchemaPtr &schema, Lib::RangeServer::Client &client,
+                   const ScanSpec &scan_spec, Timer &timer)
+      : m_table(table), m_table_id(table_id), m_schema(schema),
+        m_client(client), m_scan_spec(scan_spec), m_timer(timer) { }
+
+    void locate(const char *row, bool hard,
+                RangeLocationInfo *location) override {
+      m_table->get_range_locator()->find_loop(&m_table_id, row, location,
+                                              m_timer, hard);
+    }
+
+    void invalidate(const char *row) override {
+      m_table->get_range_locator()->invalidate(&m_table_id, row);
+    }
+
+    void send(const RangeLocationInfo &location,
+              const std::vector<const char *> &rows,
+              DispatchHandler *handler) override {
+      RangeSpec range(location.start_row.c_str(), location.end_row.c_str());
+      m_client.multi_get(location.addr, m_table_id, range, m_scan_spec, rows,
+                         handler, m_timer);
+    }
+
+    void refresh(EventPtr &event) override {
+      if (!m_table->auto_refresh())
+        HT_THROW(Hypertable::Protocol::response_code(event),
+                 Hypertable::Protocol::string_format_message(event));
+      m_table->refresh(m_table_id, m_schema);
+    }
+
+  private:
+    Table *m_table;
+    TableIdentifierManaged &m_table_id;
+    SchemaPtr &m_schema;
+    Lib::RangeServer::Client &m_client;
+    const ScanSpec &m_scan_spec;
+    Timer &m_timer;
+  };
+
+}
+
+void
+Table::multi_get(const ScanSpec &scan_spec, const std::vector<String> &rows,
+                 CellsBuilder &cells, uint32_t timeout_ms) {
+
+  if (!scan_spec.row_intervals.empty() || !scan_spec.cell_intervals.empty())
+    HT_THROW(Error::BAD_SCAN_SPEC,
+             "multi_get() does not accept row or cell intervals");
+
+  if (scan_spec.row_limit || scan_spec.cell_limit || scan_spec.row_offset ||
+      scan_spec.cell_offset)
+    HT_THROW(Error::BAD_SCAN_SPEC,
+             "multi_get() does not accept row or cell limits or offsets");
+
+  Timer timer(timeout_ms ? timeout_ms : m_timeout_ms, true);
+  Lib::RangeServer::Client client(m_comm, timer.duration());
+  TableIdentifierManaged table;
+  SchemaPtr schema;
+  std::vector<ScanBlockPtr> results;
+
+  get(table, schema);
+
+  MultiGetTarget target(this, table, schema, client, scan_spec, timer);
+  MultiGetScatter(&target, timer).run(rows, results);
+
+  // Copy the cells of every row into the result
+  SerializedKey serkey;
+  ByteString value;
+  Key key;
+  Cell cell;
+  for (auto &scan_block : results) {
+    while (scan_block->next(serkey, value)) {
+      if (!key.load(serkey))
+        HT_THROW(Error::BAD_KEY, "");
+      ColumnFamilySpec *cf_spec = schema->get_column_family(key.column_family_code);
+      cell.row_key = key.row;
+      cell.column_qualifier = key.column_qualifier;
+      if (cf_spec == 0) {
+        if (key.flag != FLAG_DELETE_ROW)
+          HT_THROWF(Error::BAD_KEY, "Unexpected column family code %d",
+                    (int)key.column_family_code);
+        cell.column_family = "";
+      }
+      else
+        cell.column_family = cf_spec->get_name().c_str();
+      cell.timestamp = key.timestamp;
+      cell.revision = key.revision;
+      cell.value_len = value.decode_length(&cell.value);
+      cell.flag = key.flag;
+      cells.add(cell);
+    }
+  }
+}
@@ -22,6 +22,7 @@
 #ifndef Hypertable_Lib_Table_h
 #define Hypertable_Lib_Table_h
 
+#include <Hypertable/Lib/Cells.h>
 #include <Hypertable/Lib/ClientObject.h>
 #include <Hypertable/Lib/NameIdMapper.h>
 #include <Hypertable/Lib/ScanSpec.h>
@@ -33,6 +34,8 @@
 #include <AsyncComm/ApplicationQueueInterface.h>
 
 #include <mutex>
+#include <string>
+#include <vector>
 
 namespace Hyperspace {
   class Session;
@@ -130,6 +133,26 @@ namespace Hypertable {
                                             uint32_t timeout_ms = 0,
                                             int32_t flags = 0);
 
+    /**
+     * Fetches the cells of a batch of rows.  The rows are sorted, duplicates
+     * are removed, and the batch is split by the range that holds each row.
+     * One <i>multi get</i> request is sent to each range, all requests are
+     * issued concurrently, and the results are gathered into
+     * <code>cells</code> in row order.  Requests for ranges that have moved
+     * or split are retried after relocating their rows, until
+     * <code>timeout_ms</code> expires.
+     *
+     * @param scan_spec scan specification supplying columns, versions,
+     *        time interval, and per-family cell limits; it must not contain
+     *        row or cell intervals, row or cell limits, or offsets
+     * @param rows rows to fetch
+     * @param cells builder to receive the cells of the fetched rows
+     * @param timeout_ms maximum time in milliseconds to allow for the call
+     */
+    void multi_get(const ScanSpec &scan_spec,
+                   const std::vector<std::string> &rows, CellsBuilder &cells,
+                   uint32_t timeout_ms = 0);
+
     void get_identifier(TableIdentifier *table_id_p) {
       std::lock_guard<std::mutex> lock(m_mutex);
       refresh_if_required();
@@ -103,6 +103,10 @@ bool TableScannerAsync::use_index(Table *table, const ScanSpec &primary_spec,
   if (!table->has_index_table() && !table->has_qualifier_index_table())
     return false;
 
+  // Aggregates are evaluated by the RangeServers over the primary table
+  if (primary_spec.aggregate)
+    return false;
+
   index_spec.set_keys_only(true);
   index_spec.set_start_time(primary_spec.time_interval.first);
   index_spec.set_end_time(primary_spec.time_interval.second);
@@ -419,6 +423,9 @@ void TableScannerAsync::init(Comm *comm, ApplicationQueueInterfacePtr &app_queue
   m_cb->increment_outstanding();
   m_cb->register_scanner(this);
 
+  if (scan_spec.aggregate)
+    m_combiner = make_shared<ScanAggregateCombiner>(scan_spec.aggregate);
+
   try {
     if (scan_spec.row_intervals.empty()) {
       if (scan_spec.cell_intervals.empty()) {
@@ -711,10 +718,18 @@ void TableScannerAsync::maybe_callback_ok(int scanner_id, bool next, bool do_cal
     eos = true;
   }
 
+  // Deliver the aggregates still held back by the combiner
+  if (eos && !do_callback && m_combiner && m_combiner->pending()) {
+    do_callback = true;
+    cells = make_shared<ScanCells>();
+  }
+
   if (do_callback) {
     if (eos)
       cells->set_eos();
     HT_ASSERT(cells != 0);
+    if (m_combiner)
+      m_combiner->combine(*cells);
     m_cb->scan_ok(this, cells);
   }
 
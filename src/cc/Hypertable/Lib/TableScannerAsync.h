@@ -31,6 +31,7 @@
 #include <Hypertable/Lib/ScanBlock.h>
 #include <Hypertable/Lib/Schema.h>
 #include <Hypertable/Lib/ResultCallback.h>
+#include <Hypertable/Lib/ScanAggregateCombiner.h>
 #include <Hypertable/Lib/Table.h>
 
 #include <AsyncComm/DispatchHandlerSynchronizer.h>
@@ -46,7 +47,13 @@ namespace Hypertable {
   /// @addtogroup libHypertable
   /// @{
 
-  /** Asynchronous table scanner. */
+  /** Asynchronous table scanner.
+   * If the scan specification carries an aggregate function, the
+   * RangeServers return partial aggregates computed over the part of each
+   * group that lies within a range, and the cells of every callback pass
+   * through a ScanAggregateCombiner that combines them into one cell per
+   * group.
+   */
   class TableScannerAsync : public ClientObject {
 
   public:
@@ -172,6 +179,7 @@ namespace Hypertable {
     Table              *m_table;
     bool                m_cancelled;
     bool                m_use_index;
+    ScanAggregateCombinerPtr m_combiner;
   };
 
   /// Smart pointer to TableScannerAsync
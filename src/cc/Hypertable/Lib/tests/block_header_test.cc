@@ -112,6 +112,7 @@ int main(int argc, char **argv) {
     after = BlockHeaderCellStore(0);
     after.decode(&decode_ptr, &remain);
 
+    HT_ASSERT(after.get_checksum_type() == CHECKSUM_FLETCHER32);
     HT_ASSERT(after.get_data_length() == 1000);
     HT_ASSERT(after.get_data_zlength() == 100);
     HT_ASSERT(after.get_data_checksum() == 42);
@@ -135,6 +136,39 @@ int main(int argc, char **argv) {
     after.decode(&decode_ptr, &remain);
 
     HT_ASSERT(before == after);
+    HT_ASSERT(after.get_checksum_type() == CHECKSUM_CRC32C);
+
+    // Version 1 with Fletcher data checksum, as written by older releases
+
+    encode_ptr = buffer;
+    before = BlockHeaderCellStore(1, "CELLSTORE-");
+    before.set_checksum_type(CHECKSUM_FLETCHER32);
+    before.set_compression_type(BlockCompressionCodec::SNAPPY);
+    before.set_data_length(1000);
+    before.set_data_zlength(100);
+    before.set_data_checksum(28);
+    before.encode(&encode_ptr);
+
+    remain = encode_ptr-buffer;
+    decode_ptr = buffer;
+    after = BlockHeaderCellStore(1);
+    after.decode(&decode_ptr, &remain);
+
+    HT_ASSERT(before == after);
+    HT_ASSERT(after.get_checksum_type() == CHECKSUM_FLETCHER32);
+  }
+
+  //
+  // Data checksum
+  //
+
+  {
+    const char *data = "123456789";
+    BlockHeaderCellStore header(1);
+    HT_ASSERT(header.compute_data_checksum(data, 9) == 0xE3069283);
+    header.set_checksum_type(CHECKSUM_FLETCHER32);
+    HT_ASSERT(header.compute_data_checksum(data, 9) == fletcher32(data, 9));
+    HT_ASSERT(BlockHeaderCellStore(0).get_checksum_type() == CHECKSUM_FLETCHER32);
   }
 
   return 0;
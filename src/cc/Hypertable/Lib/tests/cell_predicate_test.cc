@@ -0,0 +1,131 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+
+#include "Hypertable/Lib/CellPredicate.h"
+
+#include "Common/Error.h"
+#include "Common/Logger.h"
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *strings[] = {
+    "", "a", "ab", "abc", "abd", "b", "ba", "bab", "http://x", "https://y",
+    "foo123", "foo", "zzz", (const char *)0
+  };
+
+  /// Checks compiled and uncompiled evaluation agree for every combination
+  /// of the strings as qualifier and value.
+  void check(CellPredicate &predicate, const vector<pair<string,string>> &expected) {
+    CellPredicate uncompiled = predicate;
+    predicate.compile();
+    for (size_t i=0; strings[i]; i++) {
+      for (size_t j=0; strings[j]; j++) {
+        bool linear = uncompiled.matches(strings[i], strlen(strings[i]),
+                                         strings[j], strlen(strings[j]));
+        bool compiled = predicate.matches(strings[i], strlen(strings[i]),
+                                          strings[j], strlen(strings[j]));
+        if (linear != compiled) {
+          cout << "Mismatch for qualifier '" << strings[i] << "' value '"
+               << strings[j] << "'" << endl;
+          HT_ASSERT(linear == compiled);
+        }
+      }
+    }
+    for (auto &cell : expected)
+      HT_ASSERT(predicate.matches(cell.first.c_str(), cell.first.length(),
+                                  cell.second.c_str(), cell.second.length()));
+  }
+
+}
+
+int main(int argc, char **argv) {
+
+  try {
+    size_t id {};
+
+    // Qualifier exact and prefix matches
+    {
+      CellPredicate predicate;
+      predicate.add_column_predicate(ColumnPredicate("cf", "ab", ColumnPredicate::QUALIFIER_EXACT_MATCH, 0), id++);
+      predicate.add_column_predicate(ColumnPredicate("cf", "ba", ColumnPredicate::QUALIFIER_PREFIX_MATCH, 0), id++);
+      predicate.add_column_predicate(ColumnPredicate("cf", "foo", ColumnPredicate::QUALIFIER_EXACT_MATCH, 0), id++);
+      check(predicate, { {"ab", ""}, {"bab", ""}, {"foo", "x"} });
+      HT_ASSERT(!predicate.matches("abc", 3, "", 0));
+      HT_ASSERT(!predicate.matches("b", 1, "", 0));
+    }
+
+    // Value exact, prefix and regex matches
+    {
+      CellPredicate predicate;
+      predicate.add_column_predicate(ColumnPredicate("cf", 0, ColumnPredicate::PREFIX_MATCH, "http"), id++);
+      predicate.add_column_predicate(ColumnPredicate("cf", 0, ColumnPredicate::EXACT_MATCH, "zzz"), id++);
+      predicate.add_column_predicate(ColumnPredicate("cf", 0, ColumnPredicate::REGEX_MATCH, "^foo[0-9]+$"), id++);
+      check(predicate, { {"", "https://y"}, {"a", "zzz"}, {"a", "foo123"} });
+      HT_ASSERT(!predicate.matches("", 0, "foo", 3));
+    }
+
+    // Combined qualifier and value matches
+    {
+      CellPredicate predicate;
+      predicate.add_column_predicate(ColumnPredicate("cf", "a", ColumnPredicate::QUALIFIER_PREFIX_MATCH|ColumnPredicate::EXACT_MATCH, "b"), id++);
+      predicate.add_column_predicate(ColumnPredicate("cf", "^b.b$", ColumnPredicate::QUALIFIER_REGEX_MATCH|ColumnPredicate::PREFIX_MATCH, "foo"), id++);
+      check(predicate, { {"abd", "b"}, {"bab", "foo123"} });
+      HT_ASSERT(!predicate.matches("ba", 2, "foo", 3));
+    }
+
+    // Pattern without conditions matches every cell
+    {
+      CellPredicate predicate;
+      predicate.add_column_predicate(ColumnPredicate("cf", "zzz", ColumnPredicate::QUALIFIER_EXACT_MATCH, 0), id++);
+      predicate.add_column_predicate(ColumnPredicate("cf", 0, 0, 0), id++);
+      check(predicate, { {"a", "b"} });
+    }
+
+    // Invalid regular expression
+    {
+      CellPredicate predicate;
+      predicate.add_column_predicate(ColumnPredicate("cf", 0, ColumnPredicate::REGEX_MATCH, "(foo"), id++);
+      try {
+        predicate.compile();
+        HT_ASSERT(!"compile() did not throw");
+      }
+      catch (Exception &e) {
+        HT_ASSERT(e.code() == Error::BAD_SCAN_SPEC);
+      }
+    }
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+#include <Common/Compat.h>
+
+#include <Hypertable/Lib/LocationCache.h>
+
+#include <Common/Logger.h>
+#include <Common/Usage.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *usage[] = {
+    "usage: location_cache_stress_test [--count=<n>] [--readers=<n>]",
+    "",
+    "Runs lookups against a LocationCache from several threads while other",
+    "threads insert, invalidate, and evict entries, so that table indexes",
+    "and directories are replaced and reclaimed underneath the readers.",
+    "Every lookup result is checked against the row it was looked up for.",
+    0
+  };
+
+  const int TABLES = 8;
+  const int ROWS = 200;
+  const int HOSTS = 4;
+
+  /// Formats row <code>i</code>
+  string row(int i) {
+    char buf[16];
+    sprintf(buf, "r%04d", i);
+    return buf;
+  }
+
+  /// Returns location of range <code>i</code>, which ends at row
+  /// <code>i</code> (or the end of the table) and is served by host
+  /// <code>host</code>.
+  void make_range(int i, int host, RangeLocationInfo &info) {
+    info.start_row = i ? row(i-1) : "";
+    info.end_row = (i == ROWS) ? "" : row(i);
+    info.addr.set_proxy(string("h") + (char)('0' + host));
+  }
+
+  /// Checks that a lookup returned a whole range containing the row.
+  void check(const string &rowkey, RangeLocationInfo &info) {
+    HT_ASSERT(info.addr.proxy.size() == 2 && info.addr.proxy[0] == 'h');
+    HT_ASSERT(info.start_row < rowkey);
+    if (info.end_row.empty())
+      HT_ASSERT(info.start_row == row(ROWS-1));
+    else {
+      HT_ASSERT(rowkey <= info.end_row);
+      int i = atoi(info.end_row.c_str() + 1);
+      HT_ASSERT(info.start_row == (i ? row(i-1) : ""));
+    }
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  size_t count = 50000;
+  int readers = 4;
+
+  for (int i=1; i<argc; i++) {
+    if (!strncmp(argv[i], "--count=", 8))
+      count = (size_t)atoi(&argv[i][8]);
+    else if (!strncmp(argv[i], "--readers=", 10))
+      readers = atoi(&argv[i][10]);
+    else
+      Usage::dump_and_exit(usage);
+  }
+
+  // Smaller than the number of ranges so that inserts evict
+  LocationCache cache(TABLES * ROWS / 4);
+  atomic<bool> done {false};
+  atomic<size_t> hits {0};
+  vector<thread> threads;
+
+  for (int r=0; r<readers; r++) {
+    threads.push_back(thread([&cache, &done, &hits, r]() {
+          mt19937 gen(r);
+          RangeLocationInfo info;
+          size_t local_hits {};
+          while (!done.load()) {
+            int t = gen() % TABLES;
+            string rowkey = row(gen() % ROWS) + "a";
+            string table_name = string("t") + (char)('0' + t);
+            if (cache.lookup(table_name.c_str(), rowkey.c_str(), &info)) {
+              check(rowkey, info);
+              local_hits++;
+            }
+          }
+          hits += local_hits;
+        }));
+  }
+
+  // Inserts and invalidates ranges, and now and then drops a host or a
+  // whole table so that table indexes are removed and recreated
+  thread writer([&cache, count]() {
+      mt19937 gen(1000);
+      RangeLocationInfo info;
+      for (size_t i=0; i<count; i++) {
+        int t = gen() % TABLES;
+        string table_name = string("t") + (char)('0' + t);
+        int op = gen() % 100;
+        if (op < 80) {
+          make_range(gen() % (ROWS+1), gen() % HOSTS, info);
+          cache.insert(table_name.c_str(), info);
+        }
+        else if (op < 98) {
+          string rowkey = row(gen() % ROWS) + "a";
+          cache.invalidate(table_name.c_str(), rowkey.c_str());
+        }
+        else if (op < 99) {
+          for (int r=0; r<=ROWS; r++)
+            cache.invalidate(table_name.c_str(), (row(r) + "a").c_str());
+        }
+        else {
+          cache.invalidate_host(string("h") + (char)('0' + gen() % HOSTS));
+        }
+      }
+    });
+
+  writer.join();
+  done.store(true);
+  for (auto &t : threads)
+    t.join();
+
+  HT_ASSERT(hits.load() > 0);
+
+  return 0;
+}
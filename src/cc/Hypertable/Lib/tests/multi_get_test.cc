@@ -0,0 +1,372 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hypertable/Lib/Key.h>
+#include <Hypertable/Lib/MultiGetScatter.h>
+#include <Hypertable/Lib/RangeServer/Response/Parameters/CreateScanner.h>
+
+#include <Common/ByteString.h>
+#include <Common/DynamicBuffer.h>
+#include <Common/Error.h>
+#include <Common/Logger.h>
+#include <Common/Serialization.h>
+
+#include <cstring>
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  /// Range of the test table, holding rows in (start, end]
+  struct Range {
+    String start;
+    String end;
+    String server;
+  };
+
+  /// Appends the cell returned for a row, whose value is the row.
+  void append_cell(DynamicBuffer &cells, const char *row) {
+    create_key_and_append(cells, FLAG_INSERT, row, 1, "", 1, 1);
+    append_as_byte_string(cells, row, strlen(row));
+  }
+
+  /// Creates a response event.
+  EventPtr make_event(DynamicBuffer &dbuf) {
+    EventPtr event = make_shared<Event>(Event::MESSAGE);
+    uint8_t *payload = new uint8_t [dbuf.fill()];
+    memcpy(payload, dbuf.base, dbuf.fill());
+    event->payload = payload;
+    event->payload_len = dbuf.fill();
+    return event;
+  }
+
+  /// Simulated table whose ranges split and move.
+  /// Locations are cached as the RangeLocator would, so after the layout
+  /// changes, requests are sent to stale locations until they are
+  /// invalidated.  A server rejects a request for a range it does not hold
+  /// with RANGESERVER_RANGE_NOT_FOUND and otherwise returns one cell per
+  /// row, whose value is the row.  Responses larger than
+  /// <code>max_response</code> are rejected with
+  /// RANGESERVER_RESPONSE_TOO_LARGE.
+  class TestTarget : public MultiGetScatter::Target {
+  public:
+
+    void locate(const char *row, bool hard,
+                RangeLocationInfo *location) override {
+      if (!hard) {
+        for (auto &range : cache) {
+          if (contains(range, row)) {
+            set_location(range, location);
+            return;
+          }
+        }
+      }
+      for (auto &range : layout) {
+        if (contains(range, row)) {
+          cache.push_back(range);
+          set_location(range, location);
+          return;
+        }
+      }
+      HT_ASSERT(!"row not in layout");
+    }
+
+    void invalidate(const char *row) override {
+      for (auto iter = cache.begin(); iter != cache.end(); ++iter) {
+        if (contains(*iter, row)) {
+          cache.erase(iter);
+          return;
+        }
+      }
+    }
+
+    void send(const RangeLocationInfo &location,
+              const vector<const char *> &rows,
+              DispatchHandler *handler) override {
+      String server = location.addr.proxy;
+      requests.push_back(make_pair(server, rows.size()));
+
+      if (down.erase(server))
+        HT_THROWF(Error::COMM_NOT_CONNECTED, "%s down", server.c_str());
+
+      DynamicBuffer dbuf;
+      if (generation_mismatches) {
+        generation_mismatches--;
+        error_response(dbuf, Error::RANGESERVER_GENERATION_MISMATCH);
+      }
+      else if (lost || !holds(location))
+        error_response(dbuf, Error::RANGESERVER_RANGE_NOT_FOUND);
+      else if (corrupt) {
+        dbuf.ensure(4);
+        Serialization::encode_i32(&dbuf.ptr, Error::OK);
+      }
+      else {
+        DynamicBuffer cells;
+        const char *last_row {};
+        for (auto row : rows) {
+          HT_ASSERT(strcmp(row, location.start_row.c_str()) > 0 &&
+                    strcmp(row, location.end_row.c_str()) <= 0);
+          HT_ASSERT(!last_row || strcmp(last_row, row) < 0);
+          last_row = row;
+          append_cell(cells, row);
+        }
+        if (max_response && cells.fill() > max_response)
+          error_response(dbuf, Error::RANGESERVER_RESPONSE_TOO_LARGE);
+        else {
+          ProfileDataScanner profile_data;
+          Lib::RangeServer::Response::Parameters::CreateScanner
+            params(0, 0, 0, false, profile_data);
+          dbuf.ensure(8 + params.encoded_length() + cells.fill());
+          Serialization::encode_i32(&dbuf.ptr, Error::OK);
+          params.encode(&dbuf.ptr);
+          Serialization::encode_i32(&dbuf.ptr, cells.fill());
+          dbuf.add_unchecked(cells.base, cells.fill());
+        }
+      }
+      EventPtr event = make_event(dbuf);
+      handler->handle(event);
+    }
+
+    void refresh(EventPtr &event) override {
+      refreshes++;
+    }
+
+    /// Current ranges
+    vector<Range> layout;
+
+    /// Cached ranges
+    vector<Range> cache;
+
+    /// Servers that fail the next request sent to them
+    set<String> down;
+
+    /// Number of requests to fail with a generation mismatch
+    int generation_mismatches {};
+
+    /// Number of schema refreshes
+    int refreshes {};
+
+    /// If <i>true</i>, responses are truncated
+    bool corrupt {};
+
+    /// If <i>true</i>, no server holds any range
+    bool lost {};
+
+    /// Largest response, in bytes of cells, a server returns (0 for no limit)
+    size_t max_response {};
+
+    /// Server and number of rows of every request sent
+    vector<pair<String, size_t>> requests;
+
+  private:
+
+    bool contains(const Range &range, const char *row) {
+      return strcmp(row, range.start.c_str()) > 0 &&
+        strcmp(row, range.end.c_str()) <= 0;
+    }
+
+    void set_location(const Range &range, RangeLocationInfo *location) {
+      location->start_row = range.start;
+      location->end_row = range.end;
+      location->addr.set_proxy(range.server);
+    }
+
+    bool holds(const RangeLocationInfo &location) {
+      for (auto &range : layout) {
+        if (range.start == location.start_row &&
+            range.end == location.end_row &&
+            range.server == location.addr.proxy)
+          return true;
+      }
+      return false;
+    }
+
+    void error_response(DynamicBuffer &dbuf, int error) {
+      const char *message = Error::get_text(error);
+      dbuf.ensure(4 + Serialization::encoded_length_str16(message));
+      Serialization::encode_i32(&dbuf.ptr, error);
+      Serialization::encode_str16(&dbuf.ptr, message);
+    }
+  };
+
+  /// Checks that the scan blocks hold one cell for each of
+  /// <code>expected</code>, in order.
+  void check_blocks(vector<ScanBlockPtr> &blocks,
+                    const vector<String> &expected) {
+    SerializedKey serkey;
+    ByteString value;
+    Key key;
+    size_t i = 0;
+    for (auto &block : blocks) {
+      while (block->next(serkey, value)) {
+        HT_ASSERT(key.load(serkey));
+        HT_ASSERT(i < expected.size());
+        HT_ASSERT(expected[i] == key.row);
+        const uint8_t *data;
+        size_t len = value.decode_length(&data);
+        HT_ASSERT(expected[i] == String((const char *)data, len));
+        i++;
+      }
+    }
+    HT_ASSERT(i == expected.size());
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  vector<String> rows { "row35", "row05", "row25", "row15", "row05",
+                        "row45", "row25" };
+  vector<String> expected { "row05", "row15", "row25", "row35", "row45" };
+  vector<ScanBlockPtr> blocks;
+
+  try {
+
+    // Rows are scattered with one request per range and gathered in order
+    {
+      TestTarget target;
+      target.layout = { { "", "row10", "rs1" }, { "row10", "row20", "rs1" },
+                        { "row20", Key::END_ROW_MARKER, "rs2" } };
+      Timer timer(10000, true);
+      MultiGetScatter(&target, timer, 10).run(rows, blocks);
+      check_blocks(blocks, expected);
+      HT_ASSERT(target.requests.size() == 3);
+      HT_ASSERT(target.requests[2].second == 3);
+    }
+
+    // Ranges that split or moved after their locations were cached are
+    // relocated and retried
+    {
+      TestTarget target;
+      target.layout = { { "", "row10", "rs1" }, { "row10", "row20", "rs1" },
+                        { "row20", Key::END_ROW_MARKER, "rs2" } };
+      Timer timer(10000, true);
+      RangeLocationInfo location;
+      for (auto row : { "row05", "row15", "row25" })
+        target.locate(row, false, &location);
+
+      // split (row20..END] and move its upper half and (row10..row20]
+      target.layout = { { "", "row10", "rs1" }, { "row10", "row20", "rs3" },
+                        { "row20", "row30", "rs2" },
+                        { "row30", Key::END_ROW_MARKER, "rs3" } };
+
+      MultiGetScatter(&target, timer, 10).run(rows, blocks);
+      check_blocks(blocks, expected);
+      // 3 requests to the cached locations, then 3 to the new ones
+      HT_ASSERT(target.requests.size() == 6);
+      HT_ASSERT(target.requests[3] == make_pair(String("rs3"), (size_t)1));
+      HT_ASSERT(target.requests[4] == make_pair(String("rs2"), (size_t)1));
+      HT_ASSERT(target.requests[5] == make_pair(String("rs3"), (size_t)2));
+    }
+
+    // Unreachable servers and generation mismatches are retried
+    {
+      TestTarget target;
+      target.layout = { { "", "row20", "rs1" },
+                        { "row20", Key::END_ROW_MARKER, "rs2" } };
+      target.down.insert("rs2");
+      target.generation_mismatches = 1;
+      Timer timer(10000, true);
+      MultiGetScatter(&target, timer, 10).run(rows, blocks);
+      check_blocks(blocks, expected);
+      HT_ASSERT(target.refreshes == 1);
+      HT_ASSERT(target.requests.size() == 4);
+    }
+
+    // Requests whose response is too large are split until they fit
+    {
+      TestTarget target;
+      target.layout = { { "", Key::END_ROW_MARKER, "rs1" } };
+      DynamicBuffer cell;
+      append_cell(cell, "row05");
+      target.max_response = 2 * cell.fill();
+      Timer timer(10000, true);
+      MultiGetScatter(&target, timer, 10).run(rows, blocks);
+      check_blocks(blocks, expected);
+      // 5 rows, then halved to 2, 2 and 1
+      HT_ASSERT(target.requests.size() == 4);
+      HT_ASSERT(target.requests[0].second == 5);
+      HT_ASSERT(target.requests[1].second == 2);
+      HT_ASSERT(target.requests[2].second == 2);
+      HT_ASSERT(target.requests[3].second == 1);
+    }
+
+    // A single row whose response is too large is reported
+    {
+      TestTarget target;
+      target.layout = { { "", Key::END_ROW_MARKER, "rs1" } };
+      target.max_response = 1;
+      Timer timer(10000, true);
+      try {
+        MultiGetScatter(&target, timer, 10).run(rows, blocks);
+        HT_ASSERT(!"oversized row not reported");
+      }
+      catch (Exception &e) {
+        HT_ASSERT(e.code() == Error::RANGESERVER_RESPONSE_TOO_LARGE);
+      }
+      // 5 rows, then 2, 2 and 1, and the single row can't be split
+      HT_ASSERT(target.requests.size() == 4);
+    }
+
+    // A response that fails to load is reported, not asserted
+    {
+      TestTarget target;
+      target.layout = { { "", Key::END_ROW_MARKER, "rs1" } };
+      target.corrupt = true;
+      Timer timer(10000, true);
+      try {
+        MultiGetScatter(&target, timer, 10).run(rows, blocks);
+        HT_ASSERT(!"corrupt response not detected");
+      }
+      catch (Exception &e) {
+        HT_ASSERT(e.code() != Error::OK);
+      }
+    }
+
+    // Rows of a range that is never found time out
+    {
+      TestTarget target;
+      target.layout = { { "", Key::END_ROW_MARKER, "rs1" } };
+      target.lost = true;
+      Timer timer(200, true);
+      try {
+        MultiGetScatter(&target, timer, 50).run({ "row05" }, blocks);
+        HT_ASSERT(!"timeout not detected");
+      }
+      catch (Exception &e) {
+        HT_ASSERT(e.code() == Error::REQUEST_TIMEOUT);
+      }
+    }
+
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
@@ -83,5 +83,43 @@ int main(int argc, char **argv) {
   HT_ASSERT(fired==true);
   fired=false;
 
+  // plain scan specs keep encoding version 1, so older servers can read them
+  {
+    ScanSpecBuilder ssb;
+    ssb.add_column("a");
+    ssb.add_row_interval("a", true, "b", false);
+    ssb.set_max_versions(2);
+    uint8_t buf[256];
+    uint8_t *ptr = buf;
+    HT_ASSERT(ssb.get().encoded_length() < sizeof(buf));
+    ssb.get().encode(&ptr);
+    HT_ASSERT((size_t)(ptr - buf) == ssb.get().encoded_length());
+    HT_ASSERT(buf[0] == 1);
+    const uint8_t *dptr = buf;
+    size_t remain = ptr - buf;
+    ScanSpec decoded(&dptr, &remain);
+    HT_ASSERT(remain == 0);
+    HT_ASSERT(decoded.max_versions == 2);
+    HT_ASSERT(decoded.aggregate == ScanSpec::AGGREGATE_NONE);
+    HT_ASSERT(decoded.aggregate_row_prefix_length == -1);
+  }
+
+  // aggregate scan specs are encoded with version 2
+  {
+    ScanSpecBuilder ssb;
+    ssb.set_aggregate(ScanSpec::AGGREGATE_SUM, 3);
+    uint8_t buf[256];
+    uint8_t *ptr = buf;
+    ssb.get().encode(&ptr);
+    HT_ASSERT((size_t)(ptr - buf) == ssb.get().encoded_length());
+    HT_ASSERT(buf[0] == 2);
+    const uint8_t *dptr = buf;
+    size_t remain = ptr - buf;
+    ScanSpec decoded(&dptr, &remain);
+    HT_ASSERT(remain == 0);
+    HT_ASSERT(decoded.aggregate == ScanSpec::AGGREGATE_SUM);
+    HT_ASSERT(decoded.aggregate_row_prefix_length == 3);
+  }
+
   quick_exit(EXIT_SUCCESS);
 }
@@ -32,6 +32,7 @@
 #include <Hypertable/RangeServer/CellStoreFactory.h>
 #include <Hypertable/RangeServer/CellStoreReleaseCallback.h>
 #include <Hypertable/RangeServer/CellStoreV7.h>
+#include <Hypertable/RangeServer/CompactionPartition.h>
 #include <Hypertable/RangeServer/Config.h>
 #include <Hypertable/RangeServer/Global.h>
 #include <Hypertable/RangeServer/MaintenanceFlag.h>
@@ -44,6 +45,8 @@
 #include <Common/FailureInducer.h>
 #include <Common/md5.h>
 
+#include <boost/algorithm/string/join.hpp>
+
 #include <algorithm>
 #include <cassert>
 #include <cstdlib>
@@ -54,11 +57,28 @@
 using namespace Hypertable;
 using namespace std;
 
+namespace {
+
+  /// Checks if access group cell caches should be skiplist based.
+  /// Uses the access group's <i>cell cache</i> option if set, otherwise the
+  /// Hypertable.RangeServer.AccessGroup.CellCache.DefaultType property.
+  bool use_skip_list_cell_cache(AccessGroupSpec *ag_spec) {
+    string cell_cache = ag_spec->get_option_cell_cache();
+    if (cell_cache.empty()) {
+      assert(Config::properties); // requires Config::init* first
+      cell_cache =
+        Config::get_str("Hypertable.RangeServer.AccessGroup.CellCache.DefaultType");
+    }
+    return !strcasecmp(cell_cache.c_str(), "skiplist");
+  }
+
+}
+
 AccessGroup::AccessGroup(const TableIdentifier *identifier,
                          SchemaPtr &schema, AccessGroupSpec *ag_spec,
                          const RangeSpec *range, const Hints *hints)
   : m_identifier(*identifier), m_schema(schema), m_name(ag_spec->get_name()),
-    m_cell_cache_manager {make_shared<CellCacheManager>()},
+    m_cell_cache_manager {make_shared<CellCacheManager>(use_skip_list_cell_cache(ag_spec))},
     m_file_tracker(identifier, schema, range, ag_spec->get_name()),
     m_garbage_tracker(Config::properties, m_cell_cache_manager, ag_spec) {
 
@@ -108,6 +128,7 @@ void AccessGroup::update_schema(SchemaPtr &schema,
     m_cellstore_props = make_shared<Properties>();
     m_cellstore_props->set("compressor", ag_spec->get_option_compressor());
     m_cellstore_props->set("blocksize", ag_spec->get_option_blocksize());
+    m_cellstore_props->set("key-encoding", ag_spec->get_option_key_encoding());
     if (ag_spec->get_option_replication() != -1)
       m_cellstore_props->set("replication",
                              (int32_t)ag_spec->get_option_replication());
@@ -498,7 +519,7 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
   bool gc = false;
   bool cellstore_created = false;
   size_t merge_offset=0, merge_length=0;
-  String added_file;
+  vector<String> added_files;
 
   hints->ag_name = m_name;
   m_file_tracker.get_file_list(hints->files);
@@ -577,6 +598,8 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
     CellListScannerPtr scanner;
     MergeScannerAccessGroupPtr mscanner;
     ScanContextPtr scan_ctx;
+    vector<CompactionPartitionPtr> partitions;
+    vector<CellStorePtr> new_stores;
 
     {
       lock_guard<mutex> lock(m_mutex);
@@ -624,7 +647,7 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
                                                         MergeScannerAccessGroup::IS_COMPACTION |
                                                         MergeScannerAccessGroup::ACCUMULATE_COUNTERS);
         m_cell_cache_manager->add_immutable_scanner(mscanner.get(), scan_ctx.get());
-        filtered_cache = make_shared<CellCache>();
+        filtered_cache = m_cell_cache_manager->create_cache();
       }
       else if (merging) {
         mscanner = make_shared<MergeScannerAccessGroup>(m_table_name, scan_ctx.get(),
@@ -646,17 +669,58 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
         }
       }
       else if (major) {
-        mscanner = make_shared<MergeScannerAccessGroup>(m_table_name, scan_ctx.get(), 
-                                                        MergeScannerAccessGroup::IS_COMPACTION |
-                                                        MergeScannerAccessGroup::ACCUMULATE_COUNTERS);
-        m_cell_cache_manager->add_immutable_scanner(mscanner.get(), scan_ctx.get());
+        vector<String> partition_rows;
+        vector<int64_t> partition_weights;
+        select_compaction_partitions(partition_rows, partition_weights);
+        if (partition_rows.empty()) {
+          mscanner = make_shared<MergeScannerAccessGroup>(m_table_name, scan_ctx.get(), 
+                                                          MergeScannerAccessGroup::IS_COMPACTION |
+                                                          MergeScannerAccessGroup::ACCUMULATE_COUNTERS);
+          m_cell_cache_manager->add_immutable_scanner(mscanner.get(), scan_ctx.get());
+          for (size_t i=0; i<m_stores.size(); i++) {
+            HT_ASSERT(m_stores[i].cs);
+            mscanner->add_scanner(m_stores[i].cs->create_scanner(scan_ctx.get()));
+          }
+        }
+        else {
+          for (size_t i=0; i<=partition_rows.size(); i++) {
+            CompactionPartitionPtr partition =
+              make_shared<CompactionPartition>(m_table_name, m_schema,
+                                               i ? partition_rows[i-1] : "",
+                                               i < partition_rows.size() ? partition_rows[i] : "",
+                                               MergeScannerAccessGroup::IS_COMPACTION |
+                                               MergeScannerAccessGroup::ACCUMULATE_COUNTERS);
+            m_cell_cache_manager->add_immutable_scanner(partition->get_merge_scanner(),
+                                                        partition->get_scan_context());
+            for (size_t j=0; j<m_stores.size(); j++) {
+              HT_ASSERT(m_stores[j].cs);
+              partition->get_merge_scanner()->add_scanner(m_stores[j].cs->create_scanner(partition->get_scan_context()));
+            }
+            partitions.push_back(partition);
+          }
+        }
         for (size_t i=0; i<m_stores.size(); i++) {
-          HT_ASSERT(m_stores[i].cs);
-          mscanner->add_scanner(m_stores[i].cs->create_scanner(scan_ctx.get()));
           int divisor = (boost::any_cast<uint32_t>(m_stores[i].cs->get_trailer()->get("flags")) & CellStoreTrailerV7::SPLIT) ? 2: 1;
           max_num_entries += (boost::any_cast<int64_t>
               (m_stores[i].cs->get_trailer()->get("total_entries")))/divisor;
         }
+        // The first partition writes to cs_file, the rest get their own ids.
+        // Bloom filters are sized from each partition's share of the
+        // estimated cells plus some slack for estimation error.
+        if (!partitions.empty()) {
+          double total_weight {};
+          for (auto weight : partition_weights)
+            total_weight += weight;
+          for (size_t i=0; i<partitions.size(); i++) {
+            String fname = i == 0 ? cs_file :
+              format("%s/tables/%s/%s/%s/cs%d", Global::toplevel_dir.c_str(),
+                     m_identifier.id, m_name.c_str(), m_range_dir.c_str(),
+                     m_next_cs_id++);
+            partitions[i]->set_cellstore(make_shared<CellStoreV7>(Global::dfs.get(), m_schema),
+                                         fname,
+                                         (int64_t)((max_num_entries * 1.2 * partition_weights[i]) / total_weight));
+          }
+        }
       }
       else {
         scanner = m_cell_cache_manager->create_immutable_scanner(scan_ctx.get());
@@ -664,38 +728,64 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
       }
     }
 
-    cellstore->create(cs_file.c_str(), max_num_entries, cellstore_props, &m_identifier);
+    if (!partitions.empty()) {
+      uint32_t trailer_flags = CellStoreTrailerV6::MAJOR_COMPACTION;
+      if (maintenance_flags & MaintenanceFlag::SPLIT)
+        trailer_flags |= CellStoreTrailerV7::SPLIT;
+
+      HT_INFOF("Merging %s in %d partitions", m_full_name.c_str(),
+               (int)partitions.size());
 
-    if (mscanner) {
-      while (mscanner->get(key, value)) {
-        cellstore->add(key, value);
-        if (m_in_memory)
-          filtered_cache->add(key, value);
-        mscanner->forward();
+      CompactionPartition::run_all(partitions, cellstore_props, &m_identifier,
+                                   trailer_flags);
+
+      double total {}, output {};
+      for (auto &partition : partitions) {
+        total += (double)partition->get_merge_scanner()->get_input_bytes();
+        output += (double)partition->get_merge_scanner()->get_output_bytes();
+        new_stores.push_back(partition->get_cellstore());
       }
-      m_garbage_tracker.adjust_targets(now, mscanner.get());
+      m_garbage_tracker.adjust_targets(now, total, total - output);
+      partitions.clear();
+      cellstore = 0;
     }
     else {
-      while (scanner->get(key, value)) {
-        cellstore->add(key, value);
-        if (m_in_memory)
-          filtered_cache->add(key, value);
-        scanner->forward();
+      cellstore->create(cs_file.c_str(), max_num_entries, cellstore_props, &m_identifier);
+
+      if (mscanner) {
+        while (mscanner->get(key, value)) {
+          cellstore->add(key, value);
+          if (m_in_memory)
+            filtered_cache->add(key, value);
+          mscanner->forward();
+        }
+        m_garbage_tracker.adjust_targets(now, mscanner.get());
+      }
+      else {
+        while (scanner->get(key, value)) {
+          cellstore->add(key, value);
+          if (m_in_memory)
+            filtered_cache->add(key, value);
+          scanner->forward();
+        }
       }
-    }
 
-    CellStoreTrailerV7 *trailer = dynamic_cast<CellStoreTrailerV7 *>(cellstore->get_trailer());
+      CellStoreTrailerV7 *trailer = dynamic_cast<CellStoreTrailerV7 *>(cellstore->get_trailer());
 
-    if (major)
-      HT_ASSERT(mscanner);
+      if (major)
+        HT_ASSERT(mscanner);
 
-    if (major)
-      trailer->flags |= CellStoreTrailerV6::MAJOR_COMPACTION;
+      if (major)
+        trailer->flags |= CellStoreTrailerV6::MAJOR_COMPACTION;
 
-    if (maintenance_flags & MaintenanceFlag::SPLIT)
-      trailer->flags |= CellStoreTrailerV7::SPLIT;
+      if (maintenance_flags & MaintenanceFlag::SPLIT)
+        trailer->flags |= CellStoreTrailerV7::SPLIT;
 
-    cellstore->finalize(&m_identifier);
+      cellstore->finalize(&m_identifier);
+
+      new_stores.push_back(cellstore);
+      cellstore = 0;
+    }
 
     if (FailureInducer::enabled()) {
       if (MaintenanceFlag::split(maintenance_flags))
@@ -718,19 +808,21 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
       lock_guard<mutex> lock(m_mutex);
 
       if (merging) {
-        vector<CellStoreInfo> new_stores;
-        new_stores.reserve(m_stores.size() - (merge_length-1));
+        vector<CellStoreInfo> stores;
+        stores.reserve(m_stores.size() - (merge_length-1));
         for (size_t i=0; i<merge_offset; i++)
-          new_stores.push_back(m_stores[i]);
+          stores.push_back(m_stores[i]);
         for (size_t i=merge_offset; i<merge_offset+merge_length; i++)
           removed_files.push_back(m_stores[i].cs->get_filename());
-        if (cellstore->get_total_entries() > 0) {
-          new_stores.push_back(cellstore);
-          added_file = cellstore->get_filename();
+        for (auto &cs : new_stores) {
+          if (cs->get_total_entries() > 0) {
+            stores.push_back(cs);
+            added_files.push_back(cs->get_filename());
+          }
         }
         for (size_t i=merge_offset+merge_length; i<m_stores.size(); i++)
-          new_stores.push_back(m_stores[i]);
-        m_stores.swap(new_stores);
+          stores.push_back(m_stores[i]);
+        m_stores.swap(stores);
 
         // If cell cache was included in the merge, drop it
         if (m_end_merge)
@@ -762,15 +854,17 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
           }
         }
 
-        /** Add the new cell store to the table vector, or delete it if
-         * it contains no entries
+        /** Add the new cell stores to the table vector, or delete them if
+         * they contain no entries
          */
-        if (cellstore->get_total_entries() > 0) {
-          if (shadow_cache)
-            m_stores.push_back( CellStoreInfo(cellstore, shadow_cache, m_earliest_cached_revision_saved) );
-          else
-            m_stores.push_back(cellstore);
-          added_file = cellstore->get_filename();
+        for (auto &cs : new_stores) {
+          if (cs->get_total_entries() > 0) {
+            if (shadow_cache)
+              m_stores.push_back( CellStoreInfo(cs, shadow_cache, m_earliest_cached_revision_saved) );
+            else
+              m_stores.push_back(cs);
+            added_files.push_back(cs->get_filename());
+          }
         }
       }
 
@@ -778,8 +872,13 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
 
       // If compaction included CellCache, recompute latest stored revision
       if (!merging || m_end_merge) {
-        m_latest_stored_revision = boost::any_cast<int64_t>
-          (cellstore->get_trailer()->get("revision"));
+        m_latest_stored_revision = TIMESTAMP_MIN;
+        for (auto &cs : new_stores) {
+          int64_t revision = boost::any_cast<int64_t>
+            (cs->get_trailer()->get("revision"));
+          if (revision > m_latest_stored_revision)
+            m_latest_stored_revision = revision;
+        }
         if (m_latest_stored_revision >= m_earliest_cached_revision)
           HT_ERROR("Revision (clock) skew detected! May result in data loss.");
         m_cellcache_needs_compaction = false;
@@ -791,18 +890,21 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
       hints->disk_usage = m_disk_usage;
     }
 
-    if (cellstore->get_total_entries() == 0) {
-      String fname = cellstore->get_filename();
-      cellstore = 0;
-      try {
-        Global::dfs->remove(fname);
-      }
-      catch (Hypertable::Exception &e) {
-        HT_WARN_OUT << "Problem removing empty CellStore '" << fname << "' " << e << HT_END;
+    for (auto &cs : new_stores) {
+      if (cs->get_total_entries() == 0) {
+        String fname = cs->get_filename();
+        cs = 0;
+        try {
+          Global::dfs->remove(fname);
+        }
+        catch (Hypertable::Exception &e) {
+          HT_WARN_OUT << "Problem removing empty CellStore '" << fname << "' " << e << HT_END;
+        }
       }
     }
+    new_stores.clear();
 
-    m_file_tracker.update_live(added_file, removed_files, m_next_cs_id, total_index_entries);
+    m_file_tracker.update_live(added_files, removed_files, m_next_cs_id, total_index_entries);
     m_file_tracker.update_files_column();
     m_file_tracker.get_file_list(hints->files);
 
@@ -822,7 +924,7 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
     }
 
     HT_INFOF("Finished Compaction of %s(%s) to %s", m_range_name.c_str(),
-             m_name.c_str(), added_file.c_str());
+             m_name.c_str(), boost::algorithm::join(added_files, ",").c_str());
 
   }
   catch (Exception &e) {
@@ -874,7 +976,7 @@ void AccessGroup::purge_stored_cells_from_cache() {
   m_earliest_cached_revision = TIMESTAMP_MAX;
 
   CellCachePtr old_cell_cache = m_cell_cache_manager->active_cache();
-  m_cell_cache_manager->install_new_active_cache(make_shared<CellCache>());
+  m_cell_cache_manager->install_new_active_cache(m_cell_cache_manager->create_cache());
   
   lock_guard<CellCacheManager> ccm_lock(*m_cell_cache_manager);
   
@@ -929,7 +1031,7 @@ AccessGroup::shrink(String &split_row, bool drop_high, Hints *hints) {
 
     m_file_tracker.change_range(m_start_row, m_end_row);
 
-    m_cell_cache_manager->install_new_active_cache(make_shared<CellCache>());
+    m_cell_cache_manager->install_new_active_cache(m_cell_cache_manager->create_cache());
     {
       lock_guard<CellCacheManager> ccm_lock(*m_cell_cache_manager);
 
@@ -1205,6 +1307,35 @@ bool AccessGroup::find_merge_run(size_t *indexp, size_t *lenp) {
   return false;
 }
 
+
+void AccessGroup::select_compaction_partitions(vector<String> &rows,
+                                               vector<int64_t> &weights) {
+  rows.clear();
+  weights.clear();
+
+  if (m_in_memory || Global::compaction_partitions <= 1 ||
+      Global::cellstore_target_size_min <= 0)
+    return;
+
+  int64_t disk_usage {};
+  for (auto &csinfo : m_stores)
+    disk_usage += csinfo.cs->disk_usage();
+
+  size_t count = std::min((int64_t)Global::compaction_partitions,
+                          disk_usage / Global::cellstore_target_size_min);
+  if (count <= 1)
+    return;
+
+  StlArena arena(128000);
+  CellList::SplitRowDataMapT split_row_data =
+    CellList::SplitRowDataMapT(LtCstr(), CellList::SplitRowDataAlloc(arena));
+
+  for (auto &csinfo : m_stores)
+    csinfo.cs->split_row_estimate_data(split_row_data);
+
+  CompactionPartition::select_rows(split_row_data, count, rows, &weights);
+}
+
 namespace {
   struct LtCellStoreInfoTimestamp {
     bool operator()(const CellStoreInfo &x, const CellStoreInfo &y) const {
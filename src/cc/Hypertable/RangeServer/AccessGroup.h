@@ -247,6 +247,18 @@ namespace Hypertable {
 
     bool find_merge_run(size_t *indexp=0, size_t *lenp=0);
 
+    /// Chooses row boundaries for a parallel major compaction.
+    /// Returns no boundaries unless Global::compaction_partitions is greater
+    /// than one and the CellStores are large enough that each partition
+    /// would produce a CellStore of at least
+    /// Global::cellstore_target_size_min, so the results aren't immediately
+    /// picked up by a merging compaction.  Must be called with #m_mutex
+    /// locked.
+    /// @param rows Filled with partition boundary rows
+    /// @param weights Filled with estimated cell count of each partition
+    void select_compaction_partitions(std::vector<String> &rows,
+                                      std::vector<int64_t> &weights);
+
     /** Gets merging compaction information.
      * Determines whether or not a merging compaction is needed, and if so,
      * whether or not the "merge run" includes the end cell store (the one
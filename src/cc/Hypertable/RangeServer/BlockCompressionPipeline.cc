@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for BlockCompressionPipeline.
+/// This file contains type definitions for BlockCompressionPipeline, a
+/// class that compresses CellStore blocks on a pool of threads and hands
+/// them back in submission order.
+
+#include <Common/Compat.h>
+
+#include "BlockCompressionPipeline.h"
+
+#include <Hypertable/Lib/CompressorFactory.h>
+
+#include <Common/Error.h>
+#include <Common/Filesystem.h>
+#include <Common/Logger.h>
+
+#include <algorithm>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  /// Exchanges the memory held by two buffers.
+  void swap_buffers(DynamicBuffer &lhs, DynamicBuffer &rhs) {
+    std::swap(lhs.base, rhs.base);
+    std::swap(lhs.ptr, rhs.ptr);
+    std::swap(lhs.mark, rhs.mark);
+    std::swap(lhs.size, rhs.size);
+    std::swap(lhs.own, rhs.own);
+  }
+
+}
+
+
+BlockCompressionPipeline::BlockCompressionPipeline(BlockCompressionCodec::Type type,
+                                                   const BlockCompressionCodec::Args &args,
+                                                   size_t threads,
+                                                   size_t max_outstanding)
+  : m_max_outstanding(std::max(max_outstanding, (size_t)1)) {
+  threads = std::max(threads, (size_t)1);
+  for (size_t i=0; i<threads; i++)
+    m_codecs.push_back(unique_ptr<BlockCompressionCodec>(CompressorFactory::create_block_codec(type, args)));
+  for (auto &codec : m_codecs)
+    m_threads.push_back(thread(&BlockCompressionPipeline::worker, this,
+                               codec.get()));
+}
+
+
+BlockCompressionPipeline::~BlockCompressionPipeline() {
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_shutdown = true;
+    m_work_cond.notify_all();
+  }
+  for (auto &t : m_threads)
+    t.join();
+}
+
+
+void BlockCompressionPipeline::set_dictionary(const BlockCompressionCodec::DictionaryPtr &dictionary) {
+  lock_guard<mutex> lock(m_mutex);
+  HT_ASSERT(m_blocks.empty());
+  for (auto &codec : m_codecs)
+    codec->set_dictionary(dictionary);
+}
+
+
+void BlockCompressionPipeline::submit(DynamicBuffer &input, uint16_t version,
+                                      const char *magic) {
+  unique_ptr<Block> block;
+  lock_guard<mutex> lock(m_mutex);
+  HT_ASSERT(m_blocks.size() < m_max_outstanding);
+  if (m_free.empty())
+    block = make_unique<Block>();
+  else {
+    block = move(m_free.back());
+    m_free.pop_back();
+    block->input.clear();
+    block->done = false;
+  }
+  swap_buffers(block->input, input);
+  block->header = BlockHeaderCellStore(version, magic);
+  m_pending.push_back(block.get());
+  m_blocks.push_back(move(block));
+  m_work_cond.notify_one();
+}
+
+
+bool BlockCompressionPipeline::ready() {
+  lock_guard<mutex> lock(m_mutex);
+  return !m_blocks.empty() && m_blocks.front()->done;
+}
+
+
+bool BlockCompressionPipeline::full() {
+  lock_guard<mutex> lock(m_mutex);
+  return m_blocks.size() >= m_max_outstanding;
+}
+
+
+size_t BlockCompressionPipeline::outstanding() {
+  lock_guard<mutex> lock(m_mutex);
+  return m_blocks.size();
+}
+
+
+size_t BlockCompressionPipeline::pop(DynamicBuffer &output) {
+  unique_lock<mutex> lock(m_mutex);
+  HT_ASSERT(!m_blocks.empty());
+  m_done_cond.wait(lock, [this](){ return m_blocks.front()->done; });
+  unique_ptr<Block> block = move(m_blocks.front());
+  m_blocks.pop_front();
+
+  if (block->error != Error::OK)
+    HT_THROW(block->error, block->error_msg);
+
+  size_t uncompressed_length = block->input.fill();
+  output.free();
+  swap_buffers(output, block->output);
+  m_free.push_back(move(block));
+  return uncompressed_length;
+}
+
+
+void BlockCompressionPipeline::worker(BlockCompressionCodec *codec) {
+  unique_lock<mutex> lock(m_mutex);
+
+  while (true) {
+    m_work_cond.wait(lock, [this](){ return m_shutdown || !m_pending.empty(); });
+    if (m_shutdown)
+      break;
+
+    Block *block = m_pending.front();
+    m_pending.pop_front();
+    lock.unlock();
+
+    try {
+      codec->deflate(block->input, block->output, block->header,
+                     HT_DIRECT_IO_ALIGNMENT);
+    }
+    catch (Exception &e) {
+      block->error = e.code();
+      block->error_msg = e.what();
+    }
+
+    lock.lock();
+    block->done = true;
+    m_done_cond.notify_all();
+  }
+}
@@ -0,0 +1,167 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for BlockCompressionPipeline.
+/// This file contains type declarations for BlockCompressionPipeline, a
+/// class that compresses CellStore blocks on a pool of threads and hands
+/// them back in submission order.
+
+#ifndef Hypertable_RangeServer_BlockCompressionPipeline_h
+#define Hypertable_RangeServer_BlockCompressionPipeline_h
+
+#include <Hypertable/Lib/BlockCompressionCodec.h>
+#include <Hypertable/Lib/BlockHeaderCellStore.h>
+
+#include <Common/DynamicBuffer.h>
+#include <Common/String.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Hypertable {
+
+  /// @addtogroup RangeServer
+  /// @{
+
+  /// Compresses CellStore blocks on a pool of threads.
+  /// The CellStore writer hands each full block to submit() and keeps filling
+  /// the next one while worker threads compress it.  Compressed blocks are
+  /// retrieved with pop() in the order they were submitted, so the writer can
+  /// append them to the file and record their offsets in the block index.
+  /// The writer bounds memory use by popping the oldest block, which waits
+  /// for it to be compressed, whenever full() returns <i>true</i>.  Each
+  /// worker thread has its own codec, since codecs keep per-stream state.
+  class BlockCompressionPipeline {
+  public:
+
+    /// Constructor.
+    /// Creates <code>threads</code> worker threads, each with its own codec.
+    /// @param type Compression codec type
+    /// @param args Compression codec arguments
+    /// @param threads Number of worker threads
+    /// @param max_outstanding Maximum number of blocks held by the pipeline
+    BlockCompressionPipeline(BlockCompressionCodec::Type type,
+                             const BlockCompressionCodec::Args &args,
+                             size_t threads, size_t max_outstanding);
+
+    /// Destructor.
+    /// Stops the worker threads and discards blocks not yet popped.
+    ~BlockCompressionPipeline();
+
+    /// Sets dictionary on the codecs of all worker threads.
+    /// Must only be called when no blocks are outstanding.
+    /// @param dictionary Dictionary, or null to stop using one
+    void set_dictionary(const BlockCompressionCodec::DictionaryPtr &dictionary);
+
+    /// Submits a block for compression.
+    /// Takes the contents of <code>input</code> and leaves it holding an
+    /// empty buffer recycled from an earlier block, if there is one.  Must
+    /// not be called when full() returns <i>true</i>.
+    /// @param input Uncompressed block
+    /// @param version Block header version
+    /// @param magic Block header magic string
+    void submit(DynamicBuffer &input, uint16_t version, const char *magic);
+
+    /// Checks if the oldest outstanding block has been compressed.
+    /// @return <i>true</i> if pop() can return without waiting
+    bool ready();
+
+    /// Checks if the pipeline is full.
+    /// @return <i>true</i> if #m_max_outstanding blocks are outstanding
+    bool full();
+
+    /// Returns number of blocks submitted but not yet popped.
+    /// @return Number of outstanding blocks
+    size_t outstanding();
+
+    /// Removes the oldest outstanding block.
+    /// Waits for the block to be compressed and moves the compressed data
+    /// into <code>output</code>.  The buffer has room for padding the block
+    /// out to the direct I/O alignment.
+    /// @param output Receives the compressed block
+    /// @return Uncompressed length of the block
+    /// @throws Exception if the block could not be compressed
+    size_t pop(DynamicBuffer &output);
+
+  private:
+
+    /// Block moving through the pipeline.
+    struct Block {
+      /// Uncompressed data
+      DynamicBuffer input;
+      /// Compressed data
+      DynamicBuffer output;
+      /// Block header written by the codec
+      BlockHeaderCellStore header;
+      /// Set when a worker has finished with the block
+      bool done {};
+      /// Error code of failed compression
+      int error {};
+      /// Error message of failed compression
+      String error_msg;
+    };
+
+    /// Worker thread function.
+    /// @param codec Codec owned by this thread
+    void worker(BlockCompressionCodec *codec);
+
+    /// %Mutex protecting the members below
+    std::mutex m_mutex;
+
+    /// Signals workers that a block is available or the pipeline is shutting
+    /// down
+    std::condition_variable m_work_cond;
+
+    /// Signals the writer that a block has been compressed
+    std::condition_variable m_done_cond;
+
+    /// Outstanding blocks in submission order
+    std::deque<std::unique_ptr<Block>> m_blocks;
+
+    /// Blocks waiting for a worker
+    std::deque<Block *> m_pending;
+
+    /// Recycled blocks whose input buffers can be reused
+    std::vector<std::unique_ptr<Block>> m_free;
+
+    /// Codecs, one per worker thread
+    std::vector<std::unique_ptr<BlockCompressionCodec>> m_codecs;
+
+    /// Worker threads
+    std::vector<std::thread> m_threads;
+
+    /// Maximum number of outstanding blocks
+    size_t m_max_outstanding {};
+
+    /// Set to tell workers to exit
+    bool m_shutdown {};
+  };
+
+  /// @}
+
+}
+
+#endif // Hypertable_RangeServer_BlockCompressionPipeline_h
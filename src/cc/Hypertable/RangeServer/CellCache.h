@@ -88,9 +88,9 @@ namespace Hypertable {
     void lock()   { m_mutex.lock(); }
     void unlock() { m_mutex.unlock(); }
 
-    size_t size() { std::lock_guard<std::mutex> lock(m_mutex); return m_cell_map.size(); }
+    virtual size_t size() { std::lock_guard<std::mutex> lock(m_mutex); return m_cell_map.size(); }
 
-    bool empty() { std::lock_guard<std::mutex> lock(m_mutex); return m_cell_map.empty(); }
+    virtual bool empty() { std::lock_guard<std::mutex> lock(m_mutex); return m_cell_map.empty(); }
 
     /** Returns the amount of memory used by the CellCache.  This is the
      * summation of the lengths of all the keys and values in the map.
@@ -113,7 +113,7 @@ namespace Hypertable {
       return m_key_bytes + m_value_bytes;
     }
 
-    void add_statistics(Statistics &stats) {
+    virtual void add_statistics(Statistics &stats) {
       std::lock_guard<std::mutex> lock(m_mutex);
       stats.size += m_cell_map.size();
       stats.deletes += m_deletes;
@@ -128,7 +128,7 @@ namespace Hypertable {
       return m_deletes;
     }
 
-    void populate_key_set(KeySet &keys) {
+    virtual void populate_key_set(KeySet &keys) {
       Key key;
       for (CellMap::const_iterator iter = m_cell_map.begin();
 	   iter != m_cell_map.end(); ++iter) {
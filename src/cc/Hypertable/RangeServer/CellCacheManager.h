@@ -28,6 +28,7 @@
 #define Hypertable_RangeServer_CellCacheManager_h
 
 #include <Hypertable/RangeServer/CellCache.h>
+#include <Hypertable/RangeServer/CellCacheSkipList.h>
 #include <Hypertable/RangeServer/CellList.h>
 #include <Hypertable/RangeServer/CellListScanner.h>
 #include <Hypertable/RangeServer/MergeScannerAccessGroup.h>
@@ -56,8 +57,22 @@ namespace Hypertable {
   public:
 
     /// Constructor.
-    /// Initializes #m_active_cache with a newly allocated CellCache
-    CellCacheManager() : m_active_cache{new CellCache()} { }
+    /// Initializes #m_active_cache with a newly allocated cache of the type
+    /// selected by <code>skip_list</code>.
+    /// @param skip_list If <i>true</i>, caches are CellCacheSkipList
+    /// objects, otherwise they are (map based) CellCache objects
+    CellCacheManager(bool skip_list=false)
+      : m_skip_list(skip_list), m_active_cache{create_cache()} { }
+
+    /// Creates a new, empty cell cache.
+    /// Allocates a CellCacheSkipList if #m_skip_list is <i>true</i>,
+    /// otherwise a CellCache.
+    /// @return Newly allocated cell cache
+    CellCachePtr create_cache() {
+      if (m_skip_list)
+        return std::make_shared<CellCacheSkipList>();
+      return std::make_shared<CellCache>();
+    }
 
     /// Destructor.
     virtual ~CellCacheManager() { }
@@ -220,6 +235,9 @@ namespace Hypertable {
 
   private:
 
+    /// Flag indicating if caches are CellCacheSkipList objects
+    bool m_skip_list {};
+
     /// Active cache
     CellCachePtr m_active_cache;
 
@@ -23,6 +23,7 @@
 
 #include "CellCacheScanner.h"
 #include "Global.h"
+#include "ZeroCopyScanBlock.h"
 
 #include <Hypertable/Lib/Key.h>
 
@@ -223,3 +224,7 @@ void CellCacheScanner::load_entry_cache() {
 
 
 }
+
+void CellCacheScanner::pin_blocks(ZeroCopyScanBlock &block) {
+  block.pin_cell_cache(m_cell_cache_ptr);
+}
@@ -40,6 +40,8 @@ namespace Hypertable {
 
     virtual int64_t get_disk_read() { return 0; }
 
+    virtual void pin_blocks(ZeroCopyScanBlock &block);
+
     typedef std::map<const SerializedKey, uint32_t> CellCacheMap;
 
   private:
@@ -0,0 +1,112 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for CellCacheSkipList.
+/// This file contains type definitions for CellCacheSkipList, a CellCache
+/// whose cells are stored in a CellSkipList.
+
+#include <Common/Compat.h>
+
+#include "CellCacheSkipList.h"
+#include "CellCacheSkipListScanner.h"
+
+#include <Common/Logger.h>
+
+#include <cstring>
+
+using namespace Hypertable;
+using namespace std;
+
+
+void CellCacheSkipList::add(const Key &key, const ByteString value) {
+  uint8_t *ptr = m_arena.alloc(key.length + value.length());
+  SerializedKey new_key(ptr);
+
+  m_key_bytes += key.length;
+  m_value_bytes += value.length();
+
+  memcpy(ptr, key.serial.ptr, key.length);
+  value.write(ptr + key.length);
+
+  if (!m_skip_list.insert(new_key)) {
+    m_collisions++;
+    HT_WARNF("Collision detected key insert (row = %s)", new_key.row());
+  }
+  else if (key.flag <= FLAG_DELETE_CELL_VERSION)
+    m_deletes++;
+}
+
+
+void CellCacheSkipList::split_row_estimate_data(SplitRowDataMapT &split_row_data) {
+  const char *row, *last_row = 0;
+  int64_t last_count = 0;
+  for (CellSkipList::Node *node = m_skip_list.first(); node;
+       node = node->next(0)) {
+    row = node->key().row();
+    if (last_row == 0)
+      last_row = row;
+    if (strcmp(row, last_row) != 0) {
+      CstrToInt64MapT::iterator iter = split_row_data.find(last_row);
+      if (iter == split_row_data.end())
+        split_row_data[last_row] = last_count;
+      else
+        iter->second += last_count;
+      last_row = row;
+      last_count = 0;
+    }
+    last_count++;
+  }
+  if (last_count > 0) {
+    CstrToInt64MapT::iterator iter = split_row_data.find(last_row);
+    if (iter == split_row_data.end())
+      split_row_data[last_row] = last_count;
+    else
+      iter->second += last_count;
+  }
+}
+
+
+CellListScannerPtr CellCacheSkipList::create_scanner(ScanContext *scan_ctx) {
+  return make_shared<CellCacheSkipListScanner>(
+    static_pointer_cast<CellCacheSkipList>(shared_from_this()), scan_ctx);
+}
+
+
+void CellCacheSkipList::add_statistics(Statistics &stats) {
+  lock_guard<mutex> lock(m_mutex);
+  stats.size += m_skip_list.size();
+  stats.deletes += m_deletes;
+  stats.memory_used += m_arena.used();
+  stats.memory_allocated += m_arena.total();
+  stats.key_bytes += m_key_bytes;
+  stats.value_bytes += m_value_bytes;
+}
+
+
+void CellCacheSkipList::populate_key_set(KeySet &keys) {
+  Key key;
+  for (CellSkipList::Node *node = m_skip_list.first(); node;
+       node = node->next(0)) {
+    key.load(node->key());
+    keys.insert(key);
+  }
+}
@@ -0,0 +1,104 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for CellCacheSkipList.
+/// This file contains type declarations for CellCacheSkipList, a CellCache
+/// whose cells are stored in a CellSkipList.
+
+#ifndef Hypertable_RangeServer_CellCacheSkipList_h
+#define Hypertable_RangeServer_CellCacheSkipList_h
+
+#include <Hypertable/RangeServer/CellCache.h>
+#include <Hypertable/RangeServer/CellSkipList.h>
+
+#include <memory>
+
+namespace Hypertable {
+
+  /// @addtogroup RangeServer
+  /// @{
+
+  /// CellCache backed by a concurrent skiplist.
+  /// Inserts are still serialized with #lock, but scanners created with
+  /// create_scanner() traverse the skiplist without taking the cache mutex,
+  /// so they don't contend with the update pipeline.  Selected for an access
+  /// group with the <code>CELLCACHE "skiplist"</code> option.
+  class CellCacheSkipList : public CellCache {
+
+  public:
+
+    /// Constructor.
+    CellCacheSkipList() : m_skip_list(m_arena) { }
+
+    /// Destructor.
+    virtual ~CellCacheSkipList() { }
+
+    /// Adds a key/value pair.
+    /// Copies of the key and value are allocated from the arena and inserted
+    /// into the skiplist.  Requires the cache to be locked with #lock.
+    /// @param key key to be inserted
+    /// @param value value to inserted
+    void add(const Key &key, const ByteString value) override;
+
+    /// Adds a counter increment.
+    /// Unlike CellCache::add_counter(), the increment is not accumulated into
+    /// an existing entry, because scanners may be reading that entry without
+    /// the cache lock.  The increment is added as a cell of its own and is
+    /// summed with the others by the merge scanner, like increments that
+    /// reach a cell store before being accumulated.
+    /// @param key key to be inserted
+    /// @param value counter increment or reset
+    void add_counter(const Key &key, const ByteString value) override {
+      add(key, value);
+    }
+
+    void split_row_estimate_data(SplitRowDataMapT &split_row_data) override;
+
+    /// Creates a CellCacheSkipListScanner.
+    /// @param scan_ctx Scan context
+    /// @return New scanner
+    CellListScannerPtr create_scanner(ScanContext *scan_ctx) override;
+
+    size_t size() override { return m_skip_list.size(); }
+
+    bool empty() override { return m_skip_list.empty(); }
+
+    void add_statistics(Statistics &stats) override;
+
+    void populate_key_set(KeySet &keys) override;
+
+    friend class CellCacheSkipListScanner;
+
+  protected:
+
+    /// Skiplist holding cells
+    CellSkipList m_skip_list;
+  };
+
+  /// Shared smart pointer to CellCacheSkipList
+  typedef std::shared_ptr<CellCacheSkipList> CellCacheSkipListPtr;
+
+  /// @}
+
+}
+
+#endif // Hypertable_RangeServer_CellCacheSkipList_h
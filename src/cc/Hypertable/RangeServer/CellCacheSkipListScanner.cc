@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for CellCacheSkipListScanner.
+/// This file contains type definitions for CellCacheSkipListScanner, a
+/// scanner over a CellCacheSkipList.
+
+#include <Common/Compat.h>
+
+#include "CellCacheSkipListScanner.h"
+#include "ZeroCopyScanBlock.h"
+
+#include <Hypertable/Lib/Key.h>
+
+#include <Common/DynamicBuffer.h>
+
+#include <cstring>
+
+using namespace Hypertable;
+using namespace std;
+
+CellCacheSkipListScanner::CellCacheSkipListScanner(CellCacheSkipListPtr cellcache,
+                                                   ScanContext *scan_ctx)
+  : CellListScanner(scan_ctx), m_cell_cache(cellcache) {
+  CellSkipList &skip_list = m_cell_cache->m_skip_list;
+  DynamicBuffer current_buf;
+  Key current;
+
+  m_keys_only = (scan_ctx->spec) ? (scan_ctx->spec->keys_only && !scan_ctx->spec->value_regexp) : false;
+
+  current_buf.grow(scan_ctx->start_key.row_len +
+                   scan_ctx->start_key.column_qualifier_len +
+                   scan_ctx->end_key.row_len +
+                   scan_ctx->end_key.column_qualifier_len + 32);
+
+  /**
+   * If the scan starts in the middle of a row, gather the DELETE_ROW and
+   * (if the scan starts in the middle of a column family) DELETE_COLUMN_FAMILY
+   * records that precede the start key.  See CellCacheScanner.
+   */
+  if (scan_ctx->has_cell_interval) {
+    CellSkipList::Node *node;
+
+    create_key_and_append(current_buf, FLAG_DELETE_ROW,
+                          scan_ctx->start_key.row, 0,
+                          "", TIMESTAMP_MAX, 0);
+
+    current.serial.ptr = current_buf.base;
+
+    for (node = skip_list.lower_bound(current.serial); node;
+         node = node->next(0)) {
+      SerializedKey skey = node->key();
+      current.load(skey);
+      if (current.flag != FLAG_DELETE_ROW ||
+          strcmp(current.row, scan_ctx->start_key.row))
+        break;
+      m_deletes.insert(DeleteMap::value_type(skey, current.length));
+    }
+
+    if (scan_ctx->has_start_cf_qualifier) {
+
+      current_buf.clear();
+      create_key_and_append(current_buf, FLAG_DELETE_COLUMN_FAMILY,
+                            scan_ctx->start_key.row,
+                            scan_ctx->start_key.column_family_code,
+                            "", TIMESTAMP_MAX, 0);
+
+      current.serial.ptr = current_buf.base;
+
+      for (node = skip_list.lower_bound(current.serial); node;
+           node = node->next(0)) {
+        SerializedKey skey = node->key();
+        current.load(skey);
+        if (current.flag != FLAG_DELETE_COLUMN_FAMILY ||
+            current.column_family_code != scan_ctx->start_key.column_family_code ||
+            strcmp(current.row, scan_ctx->start_key.row))
+          break;
+        m_deletes.insert(DeleteMap::value_type(skey, current.length));
+      }
+    }
+  }
+
+  m_cur = skip_list.lower_bound(scan_ctx->start_serkey);
+
+  if (!m_deletes.empty()) {
+    m_in_deletes = true;
+    m_delete_iter = m_deletes.begin();
+    load(m_delete_iter->first, m_delete_iter->second);
+  }
+  else
+    skip_filtered();
+}
+
+
+bool CellCacheSkipListScanner::get(Key &key, ByteString &value) {
+  if (m_eos && !m_in_deletes)
+    return false;
+  memcpy(&key, &m_key, sizeof(key));
+  if (m_keys_only && !m_in_deletes)
+    value = (ByteString)0;
+  else
+    memcpy(&value, &m_value, sizeof(value));
+  return true;
+}
+
+
+void CellCacheSkipListScanner::forward() {
+
+  if (m_in_deletes) {
+    ++m_delete_iter;
+    if (m_delete_iter == m_deletes.end()) {
+      m_in_deletes = false;
+      skip_filtered();
+    }
+    else
+      load(m_delete_iter->first, m_delete_iter->second);
+    return;
+  }
+
+  if (m_eos)
+    return;
+
+  m_cur = m_cur->next(0);
+  skip_filtered();
+}
+
+
+void CellCacheSkipListScanner::skip_filtered() {
+  while (m_cur) {
+    SerializedKey skey = m_cur->key();
+    // Keys may be inserted ahead of any node looked up when the scanner was
+    // created, so the end of the scan is only known from the end key
+    if (skey >= m_scan_context_ptr->end_serkey)
+      break;
+    m_key.load(skey);
+    if (m_key.flag == FLAG_DELETE_ROW
+        || m_scan_context_ptr->family_mask[m_key.column_family_code]) {
+      m_value.ptr = m_key.serial.ptr + m_key.length;
+      return;
+    }
+    m_cur = m_cur->next(0);
+  }
+  m_eos = true;
+}
+
+
+void CellCacheSkipListScanner::load(const SerializedKey skey,
+                                    uint32_t value_offset) {
+  m_key.load(skey);
+  m_value.ptr = m_key.serial.ptr + value_offset;
+}
+
+
+void CellCacheSkipListScanner::pin_blocks(ZeroCopyScanBlock &block) {
+  block.pin_cell_cache(m_cell_cache);
+}
@@ -0,0 +1,101 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for CellCacheSkipListScanner.
+/// This file contains type declarations for CellCacheSkipListScanner, a
+/// scanner over a CellCacheSkipList.
+
+#ifndef Hypertable_RangeServer_CellCacheSkipListScanner_h
+#define Hypertable_RangeServer_CellCacheSkipListScanner_h
+
+#include "CellCacheSkipList.h"
+#include "CellListScanner.h"
+#include "ScanContext.h"
+
+#include <map>
+
+namespace Hypertable {
+
+  /// @addtogroup RangeServer
+  /// @{
+
+  /// Provides a scanning interface to a CellCacheSkipList.
+  /// Unlike CellCacheScanner, this scanner never takes the cell cache mutex.
+  /// It walks the bottom level of the skiplist directly, so there is no need
+  /// to copy entries into a local cache in batches.
+  class CellCacheSkipListScanner : public CellListScanner {
+  public:
+    CellCacheSkipListScanner(CellCacheSkipListPtr cellcache,
+                             ScanContext *scan_ctx);
+    virtual ~CellCacheSkipListScanner() { }
+    void forward() override;
+    bool get(Key &key, ByteString &value) override;
+
+    int64_t get_disk_read() override { return 0; }
+
+    void pin_blocks(ZeroCopyScanBlock &block) override;
+
+  private:
+
+    /// Positions scanner on first qualifying node at or after #m_cur.
+    void skip_filtered();
+
+    /// Loads key and value of a node into #m_key and #m_value.
+    /// @param skey Serialized key
+    /// @param value_offset Offset of value relative to <code>skey</code>
+    void load(const SerializedKey skey, uint32_t value_offset);
+
+    typedef std::map<const SerializedKey, uint32_t> DeleteMap;
+
+    /// Cell cache being scanned
+    CellCacheSkipListPtr m_cell_cache;
+
+    /// Current node
+    CellSkipList::Node *m_cur {};
+
+    /// Row and column family delete records preceding the scan start
+    DeleteMap m_deletes;
+
+    /// Current position in #m_deletes
+    DeleteMap::iterator m_delete_iter;
+
+    /// Current key
+    Key m_key;
+
+    /// Current value
+    ByteString m_value;
+
+    /// <i>true</i> if returning entries from #m_deletes
+    bool m_in_deletes {};
+
+    /// <i>true</i> if end of scan has been reached
+    bool m_eos {};
+
+    /// <i>true</i> if values should be suppressed
+    bool m_keys_only {};
+  };
+
+  /// @}
+
+}
+
+#endif // Hypertable_RangeServer_CellCacheSkipListScanner_h
@@ -43,6 +43,15 @@ namespace Hypertable {
     ScanContext *scan_context() { return m_scan_context_ptr; }
 
     virtual int64_t get_disk_read() = 0;
+
+    /// Pins memory referenced by the current key/value pair.
+    /// Scanners that return values pointing into memory that can be kept
+    /// alive (cached cell store blocks, cell cache arenas) register it with
+    /// <code>block</code> so the values can be referenced from a response
+    /// instead of copied.  The default implementation does nothing, which
+    /// causes values to be copied.
+    /// @param block Scan block to pin memory into
+    virtual void pin_blocks(ZeroCopyScanBlock &block) { }
     void add_disk_read(int64_t amount) { m_disk_read += amount; }
 
   protected:
@@ -0,0 +1,268 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for CellSkipList.
+/// This file contains type declarations for CellSkipList, an arena-backed
+/// skiplist of serialized keys that supports a single writer and any number
+/// of concurrent, lock-free readers.
+
+#ifndef Hypertable_RangeServer_CellSkipList_h
+#define Hypertable_RangeServer_CellSkipList_h
+
+#include <Hypertable/RangeServer/CellCacheAllocator.h>
+
+#include <Hypertable/Lib/SerializedKey.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace Hypertable {
+
+  /// @addtogroup RangeServer
+  /// @{
+
+  /// Arena-backed skiplist of serialized keys.
+  /// Each entry points to a serialized key that is immediately followed by its
+  /// value, both allocated from the owning CellCacheArena.  Modifications must
+  /// be serialized by the caller (e.g. with the CellCache mutex) but readers
+  /// may traverse the list concurrently without taking any lock.  Nodes are
+  /// published with release stores and read with acquire loads and are never
+  /// unlinked, so a node pointer obtained by a reader stays valid for the
+  /// lifetime of the arena.  Inserting a key that compares equal to an
+  /// existing key atomically swaps the key pointer of the existing node.
+  class CellSkipList {
+  public:
+
+    /// Maximum tower height
+    static const int MAX_HEIGHT = 12;
+
+    /// Skiplist node.
+    class Node {
+    public:
+      /// Constructor.
+      /// @param key Serialized key (followed by value)
+      Node(const uint8_t *key) : m_key(key) { }
+
+      /// Returns serialized key.
+      /// @return Serialized key
+      SerializedKey key() const {
+        return SerializedKey(m_key.load(std::memory_order_acquire));
+      }
+
+      /// Replaces serialized key.
+      /// @param key New serialized key (followed by value)
+      void set_key(const uint8_t *key) {
+        m_key.store(key, std::memory_order_release);
+      }
+
+      /// Returns offset of value relative to start of key.
+      /// The value immediately follows the serialized key, so its offset is
+      /// the encoded length of the key plus the size of the length prefix.
+      /// @return Value offset
+      uint32_t value_offset() const {
+        SerializedKey skey = key();
+        const uint8_t *ptr;
+        size_t len = skey.decode_length(&ptr);
+        return (uint32_t)((ptr - skey.ptr) + len);
+      }
+
+      /// Returns next node at a given level.
+      /// @param level Tower level
+      /// @return Next node at <code>level</code>
+      Node *next(int level) const {
+        return m_next[level].load(std::memory_order_acquire);
+      }
+
+      /// Sets next node at a given level.
+      /// @param level Tower level
+      /// @param node Next node
+      void set_next(int level, Node *node) {
+        m_next[level].store(node, std::memory_order_release);
+      }
+
+      /// Returns next node at a given level without a barrier.
+      /// Only safe to call from the writer.
+      /// @param level Tower level
+      /// @return Next node at <code>level</code>
+      Node *next_relaxed(int level) const {
+        return m_next[level].load(std::memory_order_relaxed);
+      }
+
+      /// Sets next node at a given level without a barrier.
+      /// Only safe to use on a node that has not yet been published.
+      /// @param level Tower level
+      /// @param node Next node
+      void set_next_relaxed(int level, Node *node) {
+        m_next[level].store(node, std::memory_order_relaxed);
+      }
+
+    private:
+      /// Serialized key followed by value
+      std::atomic<const uint8_t *> m_key;
+
+      /// Tower of next pointers, allocated to node height
+      std::atomic<Node *> m_next[1];
+    };
+
+    /// Constructor.
+    /// Allocates the head node from <code>arena</code>.
+    /// @param arena Arena from which to allocate nodes
+    CellSkipList(CellCacheArena &arena) : m_arena(arena) {
+      m_head = new_node(nullptr, MAX_HEIGHT);
+    }
+
+    /// Inserts a serialized key.
+    /// If an entry with a key equal to <code>key</code> already exists, its
+    /// key pointer is replaced with <code>key</code>.  Must not be called
+    /// concurrently with itself.
+    /// @param key Serialized key, immediately followed by value
+    /// @return <i>true</i> if a new node was inserted, <i>false</i> if an
+    /// existing entry was replaced
+    bool insert(const SerializedKey key) {
+      Node *prev[MAX_HEIGHT];
+      Node *x = find_greater_or_equal(key, prev);
+
+      if (x && x->key().compare(key) == 0) {
+        x->set_key(key.ptr);
+        return false;
+      }
+
+      int height = random_height();
+      int cur_height = m_height.load(std::memory_order_relaxed);
+      if (height > cur_height) {
+        for (int i=cur_height; i<height; i++)
+          prev[i] = m_head;
+        // Readers that observe the new height before the new node is linked
+        // will see nullptr from m_head at the upper levels and drop down.
+        m_height.store(height, std::memory_order_relaxed);
+      }
+
+      x = new_node(key.ptr, height);
+      for (int i=0; i<height; i++) {
+        x->set_next_relaxed(i, prev[i]->next_relaxed(i));
+        prev[i]->set_next(i, x);
+      }
+      m_size.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+
+    /// Returns first node.
+    /// @return First node or nullptr if list is empty
+    Node *first() const { return m_head->next(0); }
+
+    /// Returns first node whose key is greater than or equal to
+    /// <code>key</code>.
+    /// @param key Key to search for
+    /// @return First node >= <code>key</code> or nullptr if none
+    Node *lower_bound(const SerializedKey key) const {
+      return find_greater_or_equal(key, nullptr);
+    }
+
+    /// Returns number of entries.
+    /// @return Number of entries
+    size_t size() const { return m_size.load(std::memory_order_relaxed); }
+
+    /// Checks if list is empty.
+    /// @return <i>true</i> if list is empty, <i>false</i> otherwise
+    bool empty() const { return size() == 0; }
+
+  private:
+
+    /// Allocates and constructs a node from #m_arena.
+    /// The arena does not guarantee any alignment, so the allocation is
+    /// padded and the node is placed on the first suitably aligned address.
+    /// @param key Serialized key
+    /// @param height Tower height
+    /// @return Newly constructed node
+    Node *new_node(const uint8_t *key, int height) {
+      size_t len = sizeof(Node) + sizeof(std::atomic<Node *>) * (height - 1);
+      size_t align = alignof(Node);
+      uintptr_t base = (uintptr_t)m_arena.alloc(len + align - 1);
+      Node *node = new ((void *)((base + align - 1) & ~(uintptr_t)(align - 1)))
+        Node(key);
+      for (int i=0; i<height; i++)
+        node->set_next_relaxed(i, nullptr);
+      return node;
+    }
+
+    /// Computes random tower height.
+    /// Each level is populated with probability 1/4.
+    /// @return Random height between 1 and #MAX_HEIGHT
+    int random_height() {
+      int height = 1;
+      while (height < MAX_HEIGHT) {
+        m_random ^= m_random << 13;
+        m_random ^= m_random >> 17;
+        m_random ^= m_random << 5;
+        if ((m_random & 3) != 0)
+          break;
+        height++;
+      }
+      return height;
+    }
+
+    /// Finds first node greater than or equal to <code>key</code>.
+    /// If <code>prev</code> is not nullptr, it is populated with the
+    /// predecessor node at each level.
+    /// @param key Key to search for
+    /// @param prev Array of #MAX_HEIGHT predecessor nodes to populate
+    /// @return First node >= <code>key</code> or nullptr if none
+    Node *find_greater_or_equal(const SerializedKey key, Node **prev) const {
+      Node *x = m_head;
+      int level = m_height.load(std::memory_order_relaxed) - 1;
+      while (true) {
+        Node *next = x->next(level);
+        if (next && next->key().compare(key) < 0)
+          x = next;
+        else {
+          if (prev)
+            prev[level] = x;
+          if (level == 0)
+            return next;
+          level--;
+        }
+      }
+    }
+
+    /// Arena from which nodes are allocated
+    CellCacheArena &m_arena;
+
+    /// Head node
+    Node *m_head {};
+
+    /// Current maximum tower height
+    std::atomic<int> m_height {1};
+
+    /// Number of entries
+    std::atomic<size_t> m_size {};
+
+    /// Random number generator state (writer only)
+    uint32_t m_random {0xdeadbeef};
+  };
+
+  /// @}
+
+}
+
+#endif // Hypertable_RangeServer_CellSkipList_h
@@ -31,6 +31,7 @@
 #include <Hypertable/RangeServer/CellList.h>
 #include <Hypertable/RangeServer/CellListScannerBuffer.h>
 #include <Hypertable/RangeServer/CellStoreBlockIndexArray.h>
+#include <Hypertable/RangeServer/CellStoreBlockSummaries.h>
 #include <Hypertable/RangeServer/CellStoreTrailer.h>
 #include <Hypertable/RangeServer/KeyDecompressor.h>
 
@@ -158,6 +159,15 @@ namespace Hypertable {
      */
     virtual bool may_contain(ScanContext *scan_ctx) = 0;
 
+    /**
+     * Returns the per-block summaries of this cell store.  The summaries are
+     * loaded and purged along with the block index, so they may only be
+     * used while the block index reference count is held.
+     *
+     * @return Pointer to block summaries, or 0 if the cell store has none
+     */
+    virtual const CellStoreBlockSummaries *get_block_summaries() { return 0; }
+
     /**
      * Returns the disk used by this cell store.  If the cell store is opened
      * with a restricted range, then it returns an estimate of the disk used by
@@ -221,6 +231,15 @@ namespace Hypertable {
      */
     virtual KeyDecompressor *create_key_decompressor();
 
+    /**
+     * Checks if the data blocks of this cell store are stored in the
+     * columnar layout and must be converted with
+     * CellStoreBlockStreams::decode() after they are inflated
+     *
+     * @return <i>true</i> if data blocks are stored in the columnar layout
+     */
+    virtual bool has_value_streams() { return false; }
+
     /**
      * Sets the cell store files replaced by this CellStore
      */
@@ -325,6 +344,8 @@ namespace Hypertable {
     static const char DATA_BLOCK_MAGIC[10];
     static const char INDEX_FIXED_BLOCK_MAGIC[10];
     static const char INDEX_VARIABLE_BLOCK_MAGIC[10];
+    static const char INDEX_SUMMARY_BLOCK_MAGIC[10];
+    static const char DICTIONARY_BLOCK_MAGIC[10];
 
   protected:
 
@@ -36,11 +36,15 @@
 #include <Hypertable/Lib/PseudoTables.h>
 #include <Hypertable/Lib/SerializedKey.h>
 
+#include <Common/MemoryCompare.h>
 #include <Common/StaticBuffer.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <map>
+#include <vector>
 
 namespace Hypertable {
 
@@ -95,7 +99,18 @@ namespace Hypertable {
   };
 
   /**
-   *
+   * In-memory CellStore block index.
+   * Holds the in-scope entries of a CellStore block index in a sorted array
+   * whose keys point into a copy of the variable index section.  Since each
+   * probe of a binary search over that array touches a different key, the
+   * array is searched through a second, compact structure.  The comparable
+   * bytes shared by every key (#m_common_prefix_length) are factored out,
+   * the next eight bytes of each key are packed into a big-endian word
+   * (#m_prefixes), and the words are laid out in Eytzinger order
+   * (#m_eytzinger) so that a branch-free search walks down a complete
+   * binary tree stored breadth first, whose first levels stay in cache.
+   * Full key comparisons are only needed among the entries whose word
+   * equals that of the search key.
    */
   template <typename OffsetT>
   class CellStoreBlockIndexArray {
@@ -186,6 +201,8 @@ namespace Hypertable {
         m_middle_key = m_array[mid_point].key;
       }
 
+      build_search_index();
+
       // Free variable buf here to maintain original semantics
       variable.free();
 
@@ -373,7 +390,9 @@ namespace Hypertable {
     }
 
     size_t memory_used() {
-      return m_keydata.size + (m_array.size() * (sizeof(ElementT)));
+      return m_keydata.size + (m_array.size() * (sizeof(ElementT))) +
+        (m_prefixes.size() * sizeof(uint64_t)) +
+        (m_eytzinger.size() * (sizeof(uint64_t) + sizeof(uint32_t)));
     }
 
     int64_t disk_used() { return m_disk_used; }
@@ -396,13 +415,11 @@ namespace Hypertable {
     }
 
     iterator lower_bound(const SerializedKey& k) {
-      ElementT ee(k);
-      return iterator(std::lower_bound(m_array.begin(), m_array.end(), ee, LtT()));
+      return iterator(m_array.begin() + search(k, false));
     }
 
     iterator upper_bound(const SerializedKey& k) {
-      ElementT ee(k);
-      return iterator(std::upper_bound(m_array.begin(), m_array.end(), ee, LtT()));
+      return iterator(m_array.begin() + search(k, true));
     }
 
     void clear() {
@@ -410,15 +427,154 @@ namespace Hypertable {
       m_keydata.free();
       m_middle_key.ptr = 0;
       m_maximum_entries = (OffsetT)-1;
+      build_search_index();
     }
 
   private:
+
+    /** Returns the bytes of a key that are compared when ordering keys.
+     * @param key Serialized key
+     * @param ptrp Address of pointer set to the first comparable byte
+     * @return Number of comparable bytes
+     */
+    static size_t comparable_bytes(const SerializedKey &key,
+                                   const uint8_t **ptrp) {
+      size_t len = key.decode_length(ptrp);
+      (*ptrp)++;  // skip control byte
+      return len - 1;
+    }
+
+    /** Packs up to eight bytes into a word that orders like the bytes.
+     * Missing bytes are zero, so a shorter sequence never packs into a word
+     * greater than a longer one it is a prefix of.
+     * @param ptr Pointer to bytes
+     * @param len Number of bytes available
+     * @return Big-endian packed word
+     */
+    static uint64_t prefix_word(const uint8_t *ptr, size_t len) {
+      uint64_t word {};
+      for (size_t i=0; i<8; i++)
+        word = (word << 8) | (i < len ? ptr[i] : 0);
+      return word;
+    }
+
+    /** Builds #m_prefixes, #m_eytzinger and #m_eytzinger_index from
+     * #m_array.
+     */
+    void build_search_index() {
+      size_t n = m_array.size();
+      m_prefixes.clear();
+      m_eytzinger.clear();
+      m_eytzinger_index.clear();
+      m_common_prefix = 0;
+      m_common_prefix_length = 0;
+      if (n == 0)
+        return;
+
+      const uint8_t *first, *last;
+      size_t first_len = comparable_bytes(m_array.front().key, &first);
+      size_t last_len = comparable_bytes(m_array.back().key, &last);
+      size_t common = 0;
+      while (common < first_len && common < last_len &&
+             first[common] == last[common])
+        common++;
+      m_common_prefix = first;
+      m_common_prefix_length = common;
+
+      m_prefixes.resize(n);
+      for (size_t i=0; i<n; i++) {
+        const uint8_t *ptr;
+        size_t len = comparable_bytes(m_array[i].key, &ptr);
+        m_prefixes[i] = prefix_word(ptr + common, len - common);
+      }
+
+      m_eytzinger.resize(n + 1);
+      m_eytzinger_index.resize(n + 1);
+      size_t i = 0;
+      fill_eytzinger(i, 1);
+    }
+
+    /** Fills the subtree of the Eytzinger layout rooted at <code>k</code>
+     * with the sorted prefixes starting at <code>i</code>.
+     * @param i Index of next prefix to place, advanced past those placed
+     * @param k Eytzinger position of subtree root
+     */
+    void fill_eytzinger(size_t &i, size_t k) {
+      if (k < m_eytzinger.size()) {
+        fill_eytzinger(i, 2*k);
+        m_eytzinger[k] = m_prefixes[i];
+        m_eytzinger_index[k] = (uint32_t)i++;
+        fill_eytzinger(i, 2*k+1);
+      }
+    }
+
+    /** Finds the position of the first entry not less than, or with
+     * <code>upper</code> set greater than, a key.
+     * @param k Key to search for
+     * @param upper Find first entry greater than <code>k</code>
+     * @return Index into #m_array
+     */
+    size_t search(const SerializedKey &k, bool upper) {
+      size_t n = m_prefixes.size();
+      if (n == 0)
+        return 0;
+
+      const uint8_t *ptr;
+      size_t len = comparable_bytes(k, &ptr);
+      size_t common = m_common_prefix_length;
+      int cmp = memory_compare(ptr, m_common_prefix, std::min(len, common));
+      if (cmp < 0 || (cmp == 0 && len < common))
+        return 0;
+      if (cmp > 0)
+        return n;
+
+      uint64_t word = prefix_word(ptr + common, len - common);
+      size_t pos = 1;
+      const uint64_t *tree = m_eytzinger.data();
+      while (pos <= n) {
+        // The descendants four levels down are contiguous, fetch them early
+        __builtin_prefetch(tree + std::min(16*pos, n));
+        pos = 2*pos + (tree[pos] < word);
+      }
+      pos >>= __builtin_ffsll(~(long long)pos);
+      size_t i = pos ? m_eytzinger_index[pos] : n;
+      if (i == n || m_prefixes[i] != word)
+        return i;
+
+      // Entries whose word equals the key's are ordered by full comparison
+      size_t end = std::upper_bound(m_prefixes.begin() + i, m_prefixes.end(),
+                                    word) - m_prefixes.begin();
+      ElementT ee(k);
+      if (upper)
+        return std::upper_bound(m_array.begin() + i, m_array.begin() + end,
+                                ee, LtT()) - m_array.begin();
+      return std::lower_bound(m_array.begin() + i, m_array.begin() + end,
+                              ee, LtT()) - m_array.begin();
+    }
+
     ArrayT m_array;
     StaticBuffer m_keydata;
     SerializedKey m_middle_key;
     OffsetT m_end_of_last_block;
     OffsetT m_disk_used;
     OffsetT m_maximum_entries;
+
+    /// Comparable bytes of the first key, the first
+    /// #m_common_prefix_length of which all keys share
+    const uint8_t *m_common_prefix {};
+
+    /// Number of comparable bytes shared by all keys
+    size_t m_common_prefix_length {};
+
+    /// Packed bytes following the common prefix of each key, in #m_array
+    /// order
+    std::vector<uint64_t> m_prefixes;
+
+    /// #m_prefixes in Eytzinger order, starting at position 1
+    std::vector<uint64_t> m_eytzinger;
+
+    /// Index into #m_array of each #m_eytzinger entry
+    std::vector<uint32_t> m_eytzinger_index;
   };
 
   /** @}*/
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for CellStoreBlockStreams.
+/// This file contains the method definitions for CellStoreBlockStreams, a
+/// class that converts CellStore data blocks between the interleaved cell
+/// layout and the columnar layout, in which keys, value lengths and values
+/// are stored as separate streams.
+
+#include <Common/Compat.h>
+
+#include "CellStoreBlockStreams.h"
+
+#include <Common/Error.h>
+#include <Common/Logger.h>
+#include <Common/Serialization.h>
+
+using namespace Hypertable;
+using namespace Hypertable::Serialization;
+
+namespace {
+
+  /// Replaces the contents of one buffer with those of another.
+  /// @param dst Buffer to replace
+  /// @param src Buffer whose memory is handed over to <code>dst</code>
+  void take(DynamicBuffer &dst, DynamicBuffer &src) {
+    size_t fill;
+    if (dst.own)
+      delete [] dst.base;
+    dst.size = src.size;
+    dst.base = dst.mark = src.release(&fill);
+    dst.ptr = dst.base + fill;
+    dst.own = true;
+  }
+
+}
+
+
+void CellStoreBlockStreams::encode(DynamicBuffer &buf) {
+  DynamicBuffer keys(buf.fill());
+  DynamicBuffer lengths;
+  DynamicBuffer values(buf.fill());
+  const uint8_t *ptr = buf.base;
+  const uint8_t *end = buf.ptr;
+  size_t remaining = buf.fill();
+  uint32_t cells = 0;
+
+  while (ptr < end) {
+    const uint8_t *key = ptr;
+    uint32_t len = decode_vi32(&ptr, &remaining);
+    HT_ASSERT(len <= remaining);
+    ptr += len;
+    remaining -= len;
+    keys.add_unchecked(key, ptr - key);
+
+    len = decode_vi32(&ptr, &remaining);
+    HT_ASSERT(len <= remaining);
+    lengths.ensure(5);
+    encode_vi32(&lengths.ptr, len);
+    values.add_unchecked(ptr, len);
+    ptr += len;
+    remaining -= len;
+    cells++;
+  }
+
+  DynamicBuffer streams(15 + keys.fill() + lengths.fill() + values.fill());
+  encode_vi32(&streams.ptr, cells);
+  encode_vi32(&streams.ptr, keys.fill());
+  encode_vi32(&streams.ptr, lengths.fill());
+  streams.add_unchecked(keys.base, keys.fill());
+  streams.add_unchecked(lengths.base, lengths.fill());
+  streams.add_unchecked(values.base, values.fill());
+  take(buf, streams);
+}
+
+
+void CellStoreBlockStreams::decode(DynamicBuffer &buf) {
+  const uint8_t *ptr = buf.base;
+  size_t remaining = buf.fill();
+
+  uint32_t cells = decode_vi32(&ptr, &remaining);
+  uint32_t keys_length = decode_vi32(&ptr, &remaining);
+  uint32_t lengths_length = decode_vi32(&ptr, &remaining);
+  if ((size_t)keys_length + lengths_length > remaining)
+    HT_THROWF(Error::BLOCK_COMPRESSOR_TRUNCATED, "Columnar block streams "
+              "(%u + %u bytes) overrun block (%u bytes)", (unsigned)keys_length,
+              (unsigned)lengths_length, (unsigned)remaining);
+
+  const uint8_t *key = ptr;
+  size_t keys_remaining = keys_length;
+  const uint8_t *length = key + keys_length;
+  size_t lengths_remaining = lengths_length;
+  const uint8_t *value = length + lengths_length;
+  size_t values_remaining = remaining - keys_length - lengths_length;
+
+  // The cell layout holds the same bytes, without the stream header
+  DynamicBuffer cells_buf(remaining);
+
+  for (uint32_t i=0; i<cells; i++) {
+    const uint8_t *key_end = key;
+    uint32_t len = decode_vi32(&key_end, &keys_remaining);
+    if (len > keys_remaining)
+      HT_THROWF(Error::BLOCK_COMPRESSOR_TRUNCATED, "Key %u of columnar block "
+                "overruns key stream", (unsigned)i);
+    key_end += len;
+    keys_remaining -= len;
+    cells_buf.add_unchecked(key, key_end - key);
+    key = key_end;
+
+    const uint8_t *length_start = length;
+    len = decode_vi32(&length, &lengths_remaining);
+    if (len > values_remaining)
+      HT_THROWF(Error::BLOCK_COMPRESSOR_TRUNCATED, "Value %u of columnar block "
+                "overruns value stream", (unsigned)i);
+    cells_buf.add_unchecked(length_start, length - length_start);
+    cells_buf.add_unchecked(value, len);
+    value += len;
+    values_remaining -= len;
+  }
+
+  if (keys_remaining || lengths_remaining || values_remaining)
+    HT_THROWF(Error::BLOCK_COMPRESSOR_TRUNCATED, "Columnar block streams "
+              "hold more than %u cells", (unsigned)cells);
+
+  take(buf, cells_buf);
+}
@@ -0,0 +1,74 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for CellStoreBlockStreams.
+/// This file contains the type declarations for CellStoreBlockStreams, a
+/// class that converts CellStore data blocks between the interleaved cell
+/// layout and the columnar layout, in which keys, value lengths and values
+/// are stored as separate streams.
+
+#ifndef Hypertable_RangeServer_CellStoreBlockStreams_h
+#define Hypertable_RangeServer_CellStoreBlockStreams_h
+
+#include <Common/DynamicBuffer.h>
+
+namespace Hypertable {
+
+  /// @addtogroup RangeServer
+  /// @{
+
+  /// Converts data blocks to and from the columnar layout.
+  /// An uncompressed data block holds, for each cell, a compressed key
+  /// followed by the value as a ByteString.  Access groups with the
+  /// "columnar" key encoding store their blocks with the keys, the value
+  /// lengths and the value data gathered into separate streams, so that the
+  /// block compressor sees similar bytes next to each other:
+  /// <pre>
+  ///   vi32   number of cells
+  ///   vi32   length of key stream
+  ///   vi32   length of value length stream
+  ///   bytes  key stream, the compressed keys back to back
+  ///   bytes  value length stream, a vi32 for each value
+  ///   bytes  value stream, the value data back to back
+  /// </pre>
+  /// The keys must be KeyCompressionType::DELTA keys, which start with their
+  /// own length.  Blocks are converted back to the cell layout as they are
+  /// read, copying the values, so the scanners and the block cache only ever
+  /// see the cell layout.
+  class CellStoreBlockStreams {
+  public:
+
+    /// Converts a block from the cell layout to the columnar layout.
+    /// @param buf Block to convert, replaced with the converted block
+    static void encode(DynamicBuffer &buf);
+
+    /// Converts a block from the columnar layout to the cell layout.
+    /// @param buf Block to convert, replaced with the converted block
+    /// @throws Exception if the block is malformed
+    static void decode(DynamicBuffer &buf);
+  };
+
+  /// @}
+
+}
+
+#endif // Hypertable_RangeServer_CellStoreBlockStreams_h
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for CellStoreBlockSummaries.
+/// This file contains the method definitions for CellStoreBlockSummaries, a
+/// class holding per-block summaries (zone maps) of a CellStore that let
+/// scans skip blocks without reading them.
+
+#include <Common/Compat.h>
+
+#include "CellStoreBlockSummaries.h"
+
+#include <Hypertable/RangeServer/ScanContext.h>
+
+#include <Common/Error.h>
+#include <Common/Serialization.h>
+
+#include <algorithm>
+
+using namespace Hypertable;
+using namespace Hypertable::Serialization;
+using namespace std;
+
+namespace {
+  /// Serialized length of one summary
+  const size_t SUMMARY_ENCODED_LENGTH = 5*8 + 4*8 + 4;
+}
+
+bool
+CellStoreBlockSummaries::Summary::excluded(const ScanContext *scan_ctx) const {
+
+  if (revision_min > scan_ctx->revision)
+    return true;
+
+  if (timestamp_max < scan_ctx->time_interval.first)
+    return true;
+
+  if ((flags & DELETES) == 0 &&
+      timestamp_min >= scan_ctx->time_interval.second)
+    return true;
+
+  // Row deletes pass the column family check regardless of family
+  if (flags & ROW_DELETES)
+    return false;
+
+  for (size_t i=0; i<4; i++) {
+    uint64_t bits = families[i];
+    while (bits) {
+      size_t family = (i << 6) + __builtin_ctzll(bits);
+      if (scan_ctx->family_mask[family])
+        return false;
+      bits &= bits - 1;
+    }
+  }
+  return true;
+}
+
+const CellStoreBlockSummaries::Summary *
+CellStoreBlockSummaries::find(int64_t offset) const {
+  auto iter = lower_bound(m_summaries.begin(), m_summaries.end(), offset,
+                          [](const Summary &summary, int64_t offset) {
+                            return summary.offset < offset;
+                          });
+  if (iter == m_summaries.end() || iter->offset != offset)
+    return nullptr;
+  return &(*iter);
+}
+
+size_t
+CellStoreBlockSummaries::excluded_count(const ScanContext *scan_ctx) const {
+  size_t count {};
+  for (auto &summary : m_summaries) {
+    if (summary.excluded(scan_ctx))
+      count++;
+  }
+  return count;
+}
+
+void CellStoreBlockSummaries::encode(DynamicBuffer &buf) const {
+  buf.ensure(4 + m_summaries.size()*SUMMARY_ENCODED_LENGTH);
+  encode_i32(&buf.ptr, (uint32_t)m_summaries.size());
+  for (auto &summary : m_summaries) {
+    encode_i64(&buf.ptr, summary.offset);
+    encode_i64(&buf.ptr, summary.timestamp_min);
+    encode_i64(&buf.ptr, summary.timestamp_max);
+    encode_i64(&buf.ptr, summary.revision_min);
+    encode_i64(&buf.ptr, summary.revision_max);
+    for (size_t i=0; i<4; i++)
+      encode_i64(&buf.ptr, summary.families[i]);
+    encode_i32(&buf.ptr, summary.flags);
+  }
+}
+
+void CellStoreBlockSummaries::decode(const uint8_t **bufp, size_t *remainingp) {
+  uint32_t count = decode_i32(bufp, remainingp);
+  if (*remainingp < (size_t)count * SUMMARY_ENCODED_LENGTH)
+    HT_THROWF(Error::RANGESERVER_CORRUPT_CELLSTORE, "Block summaries truncated,"
+              " %u summaries in %lu bytes", (unsigned)count,
+              (unsigned long)*remainingp);
+  m_summaries.clear();
+  m_summaries.reserve(count);
+  for (uint32_t i=0; i<count; i++) {
+    Summary summary;
+    summary.offset = decode_i64(bufp, remainingp);
+    summary.timestamp_min = decode_i64(bufp, remainingp);
+    summary.timestamp_max = decode_i64(bufp, remainingp);
+    summary.revision_min = decode_i64(bufp, remainingp);
+    summary.revision_max = decode_i64(bufp, remainingp);
+    for (size_t j=0; j<4; j++)
+      summary.families[j] = decode_i64(bufp, remainingp);
+    summary.flags = decode_i32(bufp, remainingp);
+    m_summaries.push_back(summary);
+  }
+}
@@ -0,0 +1,176 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for CellStoreBlockSummaries.
+/// This file contains the type declarations for CellStoreBlockSummaries, a
+/// class holding per-block summaries (zone maps) of a CellStore that let
+/// scans skip blocks without reading them.
+
+#ifndef Hypertable_RangeServer_CellStoreBlockSummaries_h
+#define Hypertable_RangeServer_CellStoreBlockSummaries_h
+
+#include <Hypertable/Lib/Key.h>
+#include <Hypertable/Lib/KeySpec.h>
+
+#include <Common/DynamicBuffer.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace Hypertable {
+
+  class ScanContext;
+
+  /// @addtogroup RangeServer
+  /// @{
+
+  /// Per-block summaries of a CellStore.
+  /// Each summary records the column families, the timestamp and revision
+  /// ranges, and the presence of delete records for the cells of one data
+  /// block.  They are written to the CellStore right after the variable
+  /// block index and are loaded and purged along with the block index.
+  class CellStoreBlockSummaries {
+  public:
+
+    /// Summary flags
+    enum Flags {
+      /// Block contains a row delete, which applies to every column family
+      ROW_DELETES = 1,
+      /// Block contains a delete record of any kind
+      DELETES = 2
+    };
+
+    /// Summary of the cells in one data block
+    class Summary {
+    public:
+
+      /// Adds a cell to the summary.
+      /// @param key Key of cell
+      void add(const Key &key) {
+        if (key.timestamp < timestamp_min)
+          timestamp_min = key.timestamp;
+        if (key.timestamp > timestamp_max)
+          timestamp_max = key.timestamp;
+        if (key.revision < revision_min)
+          revision_min = key.revision;
+        if (key.revision > revision_max)
+          revision_max = key.revision;
+        if (key.flag != FLAG_INSERT) {
+          flags |= DELETES;
+          if (key.flag == FLAG_DELETE_ROW)
+            flags |= ROW_DELETES;
+        }
+        families[key.column_family_code >> 6] |=
+          (uint64_t)1 << (key.column_family_code & 63);
+      }
+
+      /// Checks if a scan can skip the block.
+      /// Mirrors the filters applied by CellStoreScannerInterval and
+      /// MergeScannerAccessGroup: a block is excluded if every cell in it
+      /// is newer than the scan revision, older than the start of the scan
+      /// time interval, or belongs to a column family the scan does not
+      /// select.  Inserts past the end of the time interval are dropped by
+      /// the merge scanner but deletes are not, so the end of the interval
+      /// only excludes blocks without deletes.
+      /// @param scan_ctx Scan context
+      /// @return <i>true</i> if no cell of the block can appear in the scan
+      bool excluded(const ScanContext *scan_ctx) const;
+
+      /// File offset of block
+      int64_t offset {};
+
+      /// Smallest cell timestamp
+      int64_t timestamp_min {TIMESTAMP_MAX};
+
+      /// Largest cell timestamp
+      int64_t timestamp_max {TIMESTAMP_MIN};
+
+      /// Smallest cell revision
+      int64_t revision_min {TIMESTAMP_MAX};
+
+      /// Largest cell revision
+      int64_t revision_max {TIMESTAMP_MIN};
+
+      /// Bit set of column family codes present in block
+      uint64_t families[4] {};
+
+      /// Summary flags (see Flags)
+      uint32_t flags {};
+    };
+
+    /// Appends a summary.
+    /// Summaries are added in block order, so offsets are ascending.
+    /// @param summary Summary to add
+    void add(const Summary &summary) { m_summaries.push_back(summary); }
+
+    /// Returns the summaries.
+    /// @return Reference to summary vector
+    std::vector<Summary> &summaries() { return m_summaries; }
+
+    /// Looks up the summary of a block.
+    /// @param offset File offset of block
+    /// @return Pointer to summary of block at <code>offset</code>, or
+    /// <i>nullptr</i> if there is none
+    const Summary *find(int64_t offset) const;
+
+    /// Counts the blocks a scan can skip.
+    /// @param scan_ctx Scan context
+    /// @return Number of blocks for which Summary::excluded() holds
+    size_t excluded_count(const ScanContext *scan_ctx) const;
+
+    /// Returns the number of summaries.
+    /// @return Number of summaries
+    size_t size() const { return m_summaries.size(); }
+
+    /// Serializes the summaries.
+    /// @param buf Buffer to append serialized summaries to
+    void encode(DynamicBuffer &buf) const;
+
+    /// Deserializes summaries written by encode().
+    /// @param bufp Address of pointer to serialized summaries (advanced)
+    /// @param remainingp Address of count of bytes remaining (decremented)
+    void decode(const uint8_t **bufp, size_t *remainingp);
+
+    /// Returns memory used by the summaries.
+    /// @return Memory used, in bytes
+    int64_t memory_used() const {
+      return m_summaries.capacity() * sizeof(Summary);
+    }
+
+    /// Checks if there are no summaries.
+    /// @return <i>true</i> if there are no summaries
+    bool empty() const { return m_summaries.empty(); }
+
+    /// Frees the summaries.
+    void clear() { std::vector<Summary>().swap(m_summaries); }
+
+  private:
+
+    /// Summaries in block order
+    std::vector<Summary> m_summaries;
+  };
+
+  /// @}
+
+}
+
+#endif // Hypertable_RangeServer_CellStoreBlockSummaries_h
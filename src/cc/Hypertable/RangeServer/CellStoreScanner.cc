@@ -41,7 +41,7 @@ using namespace Hypertable;
 using namespace std;
 
 template <typename IndexT>
-CellStoreScanner<IndexT>::CellStoreScanner(CellStorePtr &&cellstore, ScanContext *scan_ctx, IndexT *index) :
+CellStoreScanner<IndexT>::CellStoreScanner(CellStorePtr &&cellstore, ScanContext *scan_ctx, IndexT *index, bool skip_blocks) :
   CellListScanner(scan_ctx), m_cellstore(cellstore), m_decrement_blockindex_refcount(index!=0) {
   SerializedKey start_key, end_key;
 
@@ -134,10 +134,13 @@ CellStoreScanner<IndexT>::CellStoreScanner(CellStorePtr &&cellstore, ScanContext
       readahead =  readahead || (!strcmp(scan_ctx->end_key.row, Key::END_ROW_MARKER));
     }
 
-    // dont do readahead for single row scans
-    if (scan_ctx->single_row)
+    // dont do readahead for single row scans or scans that skip blocks
+    if (scan_ctx->single_row || skip_blocks)
       readahead = false;
 
+    if (scan_ctx->force_readahead)
+      readahead = true;
+
     if (readahead)
       m_interval_scanners[m_interval_max++] = make_unique<CellStoreScannerIntervalReadahead<IndexT>>(cellstore, index, start_key, end_key, scan_ctx);
     else {
@@ -194,6 +197,13 @@ int64_t CellStoreScanner<IndexT>::get_disk_read() {
 
 
 
+template <typename IndexT>
+void CellStoreScanner<IndexT>::pin_blocks(ZeroCopyScanBlock &block) {
+  for (size_t i=m_interval_index; i<m_interval_max; i++)
+    m_interval_scanners[i]->pin_blocks(block);
+}
+
+
 template <typename IndexT>
 void CellStoreScanner<IndexT>::forward() {
   if (m_eos)
@@ -46,12 +46,20 @@ namespace Hypertable {
   class CellStoreScanner : public CellListScanner {
   public:
 
+    /// Constructor.
+    /// @param cellstore Cell store to scan
+    /// @param scan_ctx Scan context
+    /// @param indexp Block index, or 0 if the scan doesn't need one
+    /// @param skip_blocks Scan through the block index instead of reading
+    /// ahead, so that blocks excluded by the cell store block summaries are
+    /// skipped
     CellStoreScanner(CellStorePtr &&cellstore, ScanContext *scan_ctx,
-                     IndexT *indexp=0);
+                     IndexT *indexp=0, bool skip_blocks=false);
     virtual ~CellStoreScanner();
     void forward() override;
     bool get(Key &key, ByteString &value) override;
     int64_t get_disk_read() override;
+    void pin_blocks(ZeroCopyScanBlock &block) override;
 
   private:
     CellStorePtr m_cellstore;
@@ -27,6 +27,8 @@
 
 namespace Hypertable {
 
+  class ZeroCopyScanBlock;
+
   class CellStoreScannerInterval {
   public:
     CellStoreScannerInterval() : m_disk_read(0) { }
@@ -34,6 +36,7 @@ namespace Hypertable {
     virtual bool get(Key &key, ByteString &value) = 0;
     virtual ~CellStoreScannerInterval() { }
     int64_t get_disk_read() { return m_disk_read; }
+    virtual void pin_blocks(ZeroCopyScanBlock &block) { }
 
   protected:
     struct BlockInfo {
@@ -31,6 +31,8 @@
 
 #include <Hypertable/RangeServer/Global.h>
 #include <Hypertable/RangeServer/CellStoreBlockIndexArray.h>
+#include <Hypertable/RangeServer/CellStoreBlockStreams.h>
+#include <Hypertable/RangeServer/ZeroCopyScanBlock.h>
 
 #include <Hypertable/Lib/BlockHeaderCellStore.h>
 
@@ -41,11 +43,23 @@
 #include <Common/Error.h>
 #include <Common/System.h>
 
+#include <atomic>
 #include <cassert>
 #include <utility>
+#include <vector>
 
 using namespace Hypertable;
 
+namespace {
+
+  /// Maximum number of blocks read by one preadv request
+  const size_t MAX_PREFETCH_BLOCKS = 16;
+
+  /// Cleared once the filesystem rejects a preadv request
+  std::atomic<bool> preadv_supported {true};
+
+}
+
 template <typename IndexT>
 CellStoreScannerIntervalBlockIndex<IndexT>::CellStoreScannerIntervalBlockIndex(CellStorePtr &cellstore,
   IndexT *index, SerializedKey start_key, SerializedKey end_key, ScanContext *scan_ctx) :
@@ -56,9 +70,11 @@ CellStoreScannerIntervalBlockIndex<IndexT>::CellStoreScannerIntervalBlockIndex(C
   m_file_id = m_cellstore->get_file_id();
   m_zcodec = m_cellstore->create_block_compression_codec();
   m_key_decompressor = m_cellstore->create_key_decompressor();
+  m_value_streams = m_cellstore->has_value_streams();
 
   m_end_row = (m_end_key) ? m_end_key.row() : Key::END_ROW_MARKER;
   m_fd = m_cellstore->get_fd();
+  m_summaries = m_cellstore->get_block_summaries();
 
   if (m_start_key && (m_iter = m_index->lower_bound(m_start_key)) == m_index->end())
     return;
@@ -104,12 +120,8 @@ CellStoreScannerIntervalBlockIndex<IndexT>::CellStoreScannerIntervalBlockIndex(C
 
 template <typename IndexT>
 CellStoreScannerIntervalBlockIndex<IndexT>::~CellStoreScannerIntervalBlockIndex() {
-  if (m_block.base != 0) {
-    if (m_cached)
-      Global::block_cache->checkin(m_file_id, m_block.offset);
-    else
-      delete [] m_block.base;
-  }
+  if (m_block.base != 0 && m_cached)
+    Global::block_cache->checkin(m_file_id, m_block.offset);
   delete m_zcodec;
   delete m_key_decompressor;
 }
@@ -191,7 +203,7 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
     if (m_cached)
       Global::block_cache->checkin(m_file_id, m_block.offset);
     else
-      delete [] m_block.base;
+      m_block_buffer.reset();
     memset(&m_block, 0, sizeof(m_block));
     ++m_iter;
 
@@ -202,6 +214,19 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
     }
   }
 
+  // Skip blocks whose summaries show they hold no cells for this scan
+  if (m_block.base == 0 && m_summaries) {
+    const CellStoreBlockSummaries::Summary *summary;
+    while (m_iter != m_index->end() &&
+           (summary = m_summaries->find(m_iter.value())) != 0 &&
+           summary->excluded(m_scan_ctx)) {
+      // The index key is the last key of the block
+      if (m_end_key && !(m_iter.key() < m_end_key))
+        return false;
+      ++m_iter;
+    }
+  }
+
   if (m_block.base == 0 && m_iter != m_index->end()) {
     DynamicBuffer expand_buf;
     uint32_t len;
@@ -240,20 +265,8 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
 				           (uint8_t **)&buf.base, &len)) {
 
 	  /** Read compressed block **/
-          DispatchHandlerSynchronizer sync_handler;
-	  Global::dfs->pread(m_fd, m_block.zlength, m_block.offset, second_try, &sync_handler);
-          if (!sync_handler.wait_for_reply(event))
-            HT_THROW(Protocol::response_code(event.get()),
-                     Protocol::string_format_message(event).c_str());
-          {
-            uint32_t length;
-            uint64_t off;
-            const void *data;
-            Global::dfs->decode_response_read(event, &data, &off, &length);
-            buf.base = (uint8_t *)data;
-            buf.own = false;
-          }
-
+          buf.base = (uint8_t *)read_block(second_try, event);
+          buf.own = false;
 	  checked_out = false;
 	}
 	else {
@@ -277,6 +290,9 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
           HT_THROW(Error::BLOCK_COMPRESSOR_BAD_MAGIC,
                    "Error inflating cell store block - magic string mismatch");
 
+        if (m_value_streams)
+          CellStoreBlockStreams::decode(expand_buf);
+
         /** Insert or checkin compressed block into cache  **/
         if (Global::block_cache && Global::block_cache->compressed()) {
           if (checked_out)
@@ -311,6 +327,9 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
       m_cached = Global::block_cache && !Global::block_cache->compressed() &&
           Global::block_cache->insert(m_file_id, m_block.offset,
 				      (uint8_t *)m_block.base, len, EventPtr(), true);
+      if (!m_cached)
+        m_block_buffer.reset((uint8_t *)m_block.base,
+                             std::default_delete<uint8_t[]>());
     }
     else
       m_cached = true;
@@ -319,11 +338,124 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
     m_block.end = m_block.base + len;
     m_cur_value.ptr = m_key_decompressor->add(m_block.base);
 
+    if (m_scan_ctx->zero_copy_block)
+      pin_blocks(*m_scan_ctx->zero_copy_block);
+
     return true;
   }
   return false;
 }
 
+template <typename IndexT>
+const uint8_t *
+CellStoreScannerIntervalBlockIndex<IndexT>::read_block(bool verify_checksum,
+                                                       EventPtr &event) {
+
+  // Batch the reads of the blocks of sparse row lookups
+  if (!verify_checksum && m_rowset.size() > 1 && preadv_supported &&
+      m_prefetched.find(m_block.offset) == m_prefetched.end()) {
+    m_prefetched.clear();
+    prefetch_blocks();
+  }
+
+  auto iter = m_prefetched.find(m_block.offset);
+  if (iter != m_prefetched.end()) {
+    const uint8_t *data = iter->second.data;
+    bool complete = iter->second.length == m_block.zlength;
+    event = iter->second.event;
+    m_prefetched.erase(iter);
+    if (!verify_checksum && complete)
+      return data;
+  }
+
+  DispatchHandlerSynchronizer sync_handler;
+  Global::dfs->pread(m_fd, m_block.zlength, m_block.offset, verify_checksum,
+                     &sync_handler);
+  if (!sync_handler.wait_for_reply(event))
+    HT_THROW(Protocol::response_code(event.get()),
+             Protocol::string_format_message(event).c_str());
+
+  uint32_t length;
+  uint64_t off;
+  const void *data;
+  Global::dfs->decode_response_read(event, &data, &off, &length);
+  return (const uint8_t *)data;
+}
+
+template <typename IndexT>
+void CellStoreScannerIntervalBlockIndex<IndexT>::prefetch_blocks() {
+  std::vector<Filesystem::Extent> extents;
+
+  extents.push_back(Filesystem::Extent(m_block.offset, m_block.zlength));
+
+  IndexIteratorT iter = m_iter;
+  for (const char *row : m_rowset) {
+    if (extents.size() == MAX_PREFETCH_BLOCKS || strcmp(row, m_end_row) > 0)
+      break;
+    while (iter != m_index->end() && strcmp(row, iter.key().row()) > 0)
+      ++iter;
+    if (iter == m_index->end())
+      break;
+    int64_t offset = iter.value();
+    if (offset <= (int64_t)extents.back().offset)
+      continue;
+    if (Global::block_cache && Global::block_cache->contains(m_file_id, offset))
+      continue;
+    if (m_summaries) {
+      const CellStoreBlockSummaries::Summary *summary = m_summaries->find(offset);
+      if (summary && summary->excluded(m_scan_ctx))
+        continue;
+    }
+    IndexIteratorT next = iter;
+    ++next;
+    int64_t end = (next == m_index->end()) ?
+      m_index->end_of_last_block() : next.value();
+    extents.push_back(Filesystem::Extent(offset, end - offset));
+  }
+
+  if (extents.size() == 1)
+    return;
+
+  try {
+    DispatchHandlerSynchronizer sync_handler;
+    EventPtr event;
+    Global::dfs->preadv(m_fd, extents, false, &sync_handler);
+    if (!sync_handler.wait_for_reply(event))
+      HT_THROW(Protocol::response_code(event.get()),
+               Protocol::string_format_message(event).c_str());
+
+    std::vector<Filesystem::Extent> extents_read;
+    std::vector<const void *> buffers;
+    Global::dfs->decode_response_preadv(event, extents_read, buffers);
+    for (size_t i=0; i<extents_read.size(); i++) {
+      PrefetchedBlock &block = m_prefetched[extents_read[i].offset];
+      block.event = event;
+      block.data = (const uint8_t *)buffers[i];
+      block.length = extents_read[i].length;
+    }
+  }
+  catch (Exception &e) {
+    // Brokers that predate preadv reject it
+    if (e.code() == Error::NOT_IMPLEMENTED || e.code() == Error::PROTOCOL_ERROR)
+      preadv_supported = false;
+    else
+      HT_WARN_OUT << "Error reading " << extents.size() << " blocks of cell "
+                  << "store " << m_cellstore->get_filename() << " : " << e
+                  << HT_END;
+    m_prefetched.clear();
+  }
+}
+
+template <typename IndexT>
+void CellStoreScannerIntervalBlockIndex<IndexT>::pin_blocks(ZeroCopyScanBlock &block) {
+  if (m_block.base == 0)
+    return;
+  if (m_cached)
+    block.pin_cached_block(m_file_id, m_block.offset, m_block.base, m_block.end);
+  else
+    block.pin_buffer(m_block_buffer, m_block.base, m_block.end);
+}
+
 namespace Hypertable {
   template class CellStoreScannerIntervalBlockIndex<CellStoreBlockIndexArray<uint32_t> >;
   template class CellStoreScannerIntervalBlockIndex<CellStoreBlockIndexArray<int64_t> >;
@@ -32,8 +32,13 @@
 #include <Hypertable/RangeServer/CellStoreScannerInterval.h>
 #include <Hypertable/RangeServer/ScanContext.h>
 
+#include <AsyncComm/Event.h>
+
 #include <Common/DynamicBuffer.h>
 
+#include <map>
+#include <memory>
+
 namespace Hypertable {
 
   class BlockCompressionCodec;
@@ -54,15 +59,41 @@ namespace Hypertable {
     virtual ~CellStoreScannerIntervalBlockIndex();
     virtual void forward();
     virtual bool get(Key &key, ByteString &value);
+    void pin_blocks(ZeroCopyScanBlock &block) override;
 
   private:
 
     bool fetch_next_block(bool eob=false);
 
+    /// Reads the compressed block described by #m_block.
+    /// Returns the block from #m_prefetched if it is there, otherwise
+    /// reads it with a single pread.
+    /// @param verify_checksum Have the filesystem verify checksums
+    /// @param event Receives the response event holding the block
+    /// @return Pointer to compressed block
+    const uint8_t *read_block(bool verify_checksum, EventPtr &event);
+
+    /// Reads the blocks of upcoming rowset rows in one request.
+    /// Starting with the block described by #m_block, collects the blocks
+    /// holding the rows in #m_rowset that are not in the block cache, up to
+    /// a limit, and reads them with a single preadv into #m_prefetched.
+    void prefetch_blocks();
+
+    /// Compressed block read ahead by prefetch_blocks()
+    struct PrefetchedBlock {
+      /// Response event holding the block
+      EventPtr event;
+      /// Pointer to compressed block
+      const uint8_t *data {};
+      /// Length of compressed block
+      uint32_t length {};
+    };
+
     CellStorePtr          m_cellstore;
     IndexT               *m_index {};
     IndexIteratorT        m_iter;
     BlockInfo             m_block;
+    std::shared_ptr<uint8_t> m_block_buffer;
     Key                   m_key;
     SerializedKey         m_cur_key;
     ByteString            m_cur_value;
@@ -72,12 +103,15 @@ namespace Hypertable {
     DynamicBuffer         m_key_buf;
     BlockCompressionCodec *m_zcodec {};
     KeyDecompressor      *m_key_decompressor {};
+    bool                  m_value_streams {};
     int32_t               m_fd {-1};
     bool                  m_cached {};
     bool                  m_check_for_range_end {};
     int                   m_file_id {};
     ScanContext          *m_scan_ctx {};
+    const CellStoreBlockSummaries *m_summaries {};
     ScanContext::CstrRowSet& m_rowset;
+    std::map<int64_t, PrefetchedBlock> m_prefetched;
   };
 
   /// @}
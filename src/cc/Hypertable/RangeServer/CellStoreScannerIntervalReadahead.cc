@@ -29,7 +29,9 @@
 #include "CellStoreScannerIntervalReadahead.h"
 
 #include <Hypertable/RangeServer/CellStoreBlockIndexArray.h>
+#include <Hypertable/RangeServer/CellStoreBlockStreams.h>
 #include <Hypertable/RangeServer/Global.h>
+#include <Hypertable/RangeServer/ZeroCopyScanBlock.h>
 
 #include <Hypertable/Lib/BlockHeaderCellStore.h>
 
@@ -55,6 +57,7 @@ CellStoreScannerIntervalReadahead<IndexT>::CellStoreScannerIntervalReadahead(Cel
   memset(&m_block, 0, sizeof(m_block));
   m_zcodec = m_cellstore->create_block_compression_codec();
   m_key_decompressor = m_cellstore->create_key_decompressor();
+  m_value_streams = m_cellstore->has_value_streams();
 
   uint16_t csversion = boost::any_cast<uint16_t>(cellstore->get_trailer()->get("version"));
   if (csversion >= 4)
@@ -149,7 +152,6 @@ CellStoreScannerIntervalReadahead<IndexT>::~CellStoreScannerIntervalReadahead()
   try {
     if (m_fd != -1)
       Global::dfs->close(m_fd);
-    delete [] m_block.base;
     delete m_zcodec;
     delete m_key_decompressor;
   }
@@ -238,7 +240,7 @@ bool CellStoreScannerIntervalReadahead<IndexT>::fetch_next_block_readahead(bool
 
   // If we're at the end of the current block, deallocate and move to next
   if (m_block.base != 0 && eob) {
-    delete [] m_block.base;
+    m_block_buffer.reset();
     memset(&m_block, 0, sizeof(m_block));
   }
 
@@ -286,6 +288,9 @@ bool CellStoreScannerIntervalReadahead<IndexT>::fetch_next_block_readahead(bool
       if (!header.check_magic(CellStore::DATA_BLOCK_MAGIC))
         HT_THROW(Error::BLOCK_COMPRESSOR_BAD_MAGIC,
                  "Error inflating cell store block - magic string mismatch");
+
+      if (m_value_streams)
+        CellStoreBlockStreams::decode(expand_buf);
     }
     catch (Exception &e) {
       HT_ERROR_OUT <<"Error reading cell store ( fd=" << m_fd << " file="
@@ -298,16 +303,28 @@ bool CellStoreScannerIntervalReadahead<IndexT>::fetch_next_block_readahead(bool
     size_t fill;
     m_block.base = expand_buf.release(&fill);
     len = fill;
+    m_block_buffer.reset((uint8_t *)m_block.base,
+                         std::default_delete<uint8_t[]>());
 
     m_key_decompressor->reset();
     m_block.end = m_block.base + len;
     m_cur_value.ptr = m_key_decompressor->add(m_block.base);
 
+    if (m_scan_ctx->zero_copy_block)
+      pin_blocks(*m_scan_ctx->zero_copy_block);
+
     return true;
   }
   return false;
 }
 
+template <typename IndexT>
+void CellStoreScannerIntervalReadahead<IndexT>::pin_blocks(ZeroCopyScanBlock &block) {
+  if (m_block.base == 0)
+    return;
+  block.pin_buffer(m_block_buffer, m_block.base, m_block.end);
+}
+
 namespace Hypertable {
   template class CellStoreScannerIntervalReadahead<CellStoreBlockIndexArray<uint32_t> >;
   template class CellStoreScannerIntervalReadahead<CellStoreBlockIndexArray<int64_t> >;
@@ -34,6 +34,8 @@
 
 #include <Common/DynamicBuffer.h>
 
+#include <memory>
+
 namespace Hypertable {
 
   class BlockCompressionCodec;
@@ -54,6 +56,7 @@ namespace Hypertable {
     virtual ~CellStoreScannerIntervalReadahead();
     virtual void forward();
     virtual bool get(Key &key, ByteString &value);
+    void pin_blocks(ZeroCopyScanBlock &block) override;
 
   private:
 
@@ -61,11 +64,13 @@ namespace Hypertable {
 
     CellStorePtr           m_cellstore;
     BlockInfo              m_block;
+    std::shared_ptr<uint8_t> m_block_buffer;
     Key                    m_key;
     SerializedKey          m_end_key;
     ByteString             m_cur_value;
     BlockCompressionCodec *m_zcodec {};
     KeyDecompressor       *m_key_decompressor {};
+    bool                   m_value_streams {};
     int32_t                m_fd {-1};
     int64_t                m_offset {};
     int64_t                m_end_offset {};
@@ -221,6 +221,14 @@ void CellStoreTrailerV7::display(std::ostream &os) {
     os << " 64BIT_INDEX";
   if (flags & MAJOR_COMPACTION)
     os << " MAJOR_COMPACTION";
+  if (flags & BLOCKED_BLOOM_FILTER)
+    os << " BLOCKED_BLOOM_FILTER";
+  if (flags & BLOCK_SUMMARIES)
+    os << " BLOCK_SUMMARIES";
+  if (flags & DICTIONARY)
+    os << " DICTIONARY";
+  if (flags & VALUE_STREAMS)
+    os << " VALUE_STREAMS";
   os << " )";
   os << ", alignment=" << alignment;
   os << ", compression_ratio=" << compression_ratio;
@@ -271,6 +279,12 @@ void CellStoreTrailerV7::display_multiline(std::ostream &os) {
     os << "  flags: 64BIT_INDEX\n";
   else
     os << "  flags=" << flags << "\n";
+  if (flags & BLOCKED_BLOOM_FILTER)
+    os << "  bloom_filter_layout=BLOCKED\n";
+  if (flags & BLOCK_SUMMARIES)
+    os << "  block_summaries=YES\n";
+  if (flags & DICTIONARY)
+    os << "  dictionary=YES\n";
   os << "  alignment=" << alignment << "\n";
   os << "  compression_ratio: " << compression_ratio << "\n";
   os << "  compression_type: " << compression_type << "\n";
@@ -87,7 +87,11 @@ namespace Hypertable {
 
     enum Flags { INDEX_64BIT = 1,
                  MAJOR_COMPACTION = 2,
-                 SPLIT = 4
+                 SPLIT = 4,
+                 BLOCKED_BLOOM_FILTER = 8,
+                 BLOCK_SUMMARIES = 16,
+                 DICTIONARY = 32,
+                 VALUE_STREAMS = 64
     };
 
     boost::any get(const String& prop) {
@@ -120,6 +124,7 @@ namespace Hypertable {
       else if (prop == "alignment")             return alignment;
       else if (prop == "compression_ratio")     return compression_ratio;
       else if (prop == "compression_type")      return compression_type;
+      else if (prop == "key_compression_scheme") return key_compression_scheme;
       else if (prop == "block_header_version")  return block_header_version;
       else if (prop == "bloom_filter_mode")     return bloom_filter_mode;
       else if (prop == "bloom_filter_hash_count") return bloom_filter_hash_count;
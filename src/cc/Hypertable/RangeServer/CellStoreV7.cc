@@ -47,6 +47,7 @@
 #include "Hypertable/Lib/Schema.h"
 
 #include "CellStoreV7.h"
+#include "CellStoreBlockStreams.h"
 #include "CellStoreInfo.h"
 #include "CellStoreTrailerV7.h"
 #include "CellStoreScanner.h"
@@ -54,7 +55,9 @@
 #include "FileBlockCache.h"
 #include "Global.h"
 #include "Config.h"
+#include "KeyCompressorDelta.h"
 #include "KeyCompressorPrefix.h"
+#include "KeyDecompressorDelta.h"
 #include "KeyDecompressorPrefix.h"
 
 using namespace std;
@@ -93,15 +96,29 @@ CellStoreV7::~CellStoreV7() {
 
   Global::memory_tracker->subtract( sizeof(CellStoreV7) + sizeof(CellStoreInfo) + m_index_stats.bloom_filter_memory + m_index_stats.block_index_memory );
 
+  if (m_dictionary)
+    Global::memory_tracker->subtract(m_dictionary->memory_used());
 }
 
 
 BlockCompressionCodec *CellStoreV7::create_block_compression_codec() {
-  return CompressorFactory::create_block_codec(
+  BlockCompressionCodec::DictionaryPtr dictionary;
+  {
+    lock_guard<mutex> lock(m_mutex);
+    if ((m_trailer.flags & CellStoreTrailerV7::DICTIONARY) && !m_dictionary)
+      load_dictionary();
+    dictionary = m_dictionary;
+  }
+  BlockCompressionCodec *codec = CompressorFactory::create_block_codec(
       (BlockCompressionCodec::Type)m_trailer.compression_type);
+  if (dictionary)
+    codec->set_dictionary(dictionary);
+  return codec;
 }
 
 KeyDecompressor *CellStoreV7::create_key_decompressor() {
+  if (m_trailer.key_compression_scheme == KeyCompressionType::DELTA)
+    return new KeyDecompressorDelta();
   return new KeyDecompressorPrefix();
 }
 
@@ -143,18 +160,55 @@ void CellStoreV7::populate_index_pseudo_table_scanner(CellListScannerBuffer *sca
 CellListScannerPtr CellStoreV7::create_scanner(ScanContext *scan_ctx) {
   bool need_index =  m_restricted_range || scan_ctx->restricted_range ||
     scan_ctx->single_row || scan_ctx->has_cell_interval;
+  bool skip_blocks {};
 
-  if (need_index) {
+  // Block summaries are only consulted while they are resident, so that an
+  // unrestricted scan never loads a purged index just to read them
+  if (need_index || m_summaries_resident) {
     lock_guard<mutex> lock(m_mutex);
-    m_index_stats.block_index_access_counter = ++Global::access_counter;
-    if (m_index_stats.block_index_memory == 0)
-      load_block_index();
-    m_index_refcount++;
+    if (!need_index && !m_block_summaries.empty())
+      need_index = skip_blocks = should_skip_blocks(scan_ctx);
+    if (need_index) {
+      if (m_index_stats.block_index_memory == 0)
+        load_block_index();
+      m_index_stats.block_index_access_counter = ++Global::access_counter;
+      m_index_refcount++;
+    }
   }
 
   if (m_64bit_index)
-    return make_shared<CellStoreScanner<CellStoreBlockIndexArray<int64_t>>>(shared_from_this(), scan_ctx, need_index ? &m_index_map64 : 0);
-  return make_shared<CellStoreScanner<CellStoreBlockIndexArray<uint32_t>>>(shared_from_this(), scan_ctx, need_index ? &m_index_map32 : 0);
+    return make_shared<CellStoreScanner<CellStoreBlockIndexArray<int64_t>>>(shared_from_this(), scan_ctx, need_index ? &m_index_map64 : 0, skip_blocks);
+  return make_shared<CellStoreScanner<CellStoreBlockIndexArray<uint32_t>>>(shared_from_this(), scan_ctx, need_index ? &m_index_map32 : 0, skip_blocks);
+}
+
+
+bool CellStoreV7::should_skip_blocks(ScanContext *scan_ctx) {
+  SkipDecision decision;
+
+  // Revisions past the store revision exclude the same blocks
+  decision.revision = std::min(scan_ctx->revision, m_trailer.revision);
+  decision.time_interval = scan_ctx->time_interval;
+  for (size_t i=0; i<256; i++) {
+    if (scan_ctx->family_mask[i])
+      decision.families[i >> 6] |= 1ULL << (i & 63);
+  }
+
+  for (auto &cached : m_skip_decisions) {
+    if (cached.revision == decision.revision &&
+        cached.time_interval == decision.time_interval &&
+        !memcmp(cached.families, decision.families, sizeof(decision.families)))
+      return cached.skip_blocks;
+  }
+
+  // Scan through the block index instead of reading ahead if the block
+  // summaries rule out at least a quarter of the blocks
+  size_t excluded = m_block_summaries.excluded_count(scan_ctx);
+  decision.skip_blocks = excluded*4 >= m_block_summaries.size();
+
+  if (m_skip_decisions.size() == SKIP_DECISION_CACHE_SIZE)
+    m_skip_decisions.erase(m_skip_decisions.begin());
+  m_skip_decisions.push_back(decision);
+  return decision.skip_blocks;
 }
 
 namespace {
@@ -180,8 +234,7 @@ CellStoreV7::create(const char *fname, size_t max_entries,
                     PropertiesPtr &props, const TableIdentifier *table_id) {
   int64_t blocksize = props->get("blocksize", 0);
   String compressor = props->get("compressor", String());
-
-  m_key_compressor = make_shared<KeyCompressorPrefix>();
+  String key_encoding = props->get("key-encoding", String());
 
   assert(Config::properties); // requires Config::init* first
   int32_t replication = get_replication(props, table_id);
@@ -192,6 +245,12 @@ CellStoreV7::create(const char *fname, size_t max_entries,
   if (compressor.empty())
     compressor = Config::get_str("Hypertable.RangeServer.CellStore"
                                  ".DefaultCompressor");
+  if (key_encoding.empty())
+    key_encoding = Config::get_str("Hypertable.RangeServer.CellStore"
+                                   ".DefaultKeyEncoding");
+  m_write_block_summaries =
+    Config::get_bool("Hypertable.RangeServer.CellStore.BlockSummaries");
+
   if (!props->has("bloom-filter-mode")) {
     // probably not called from AccessGroup
     AccessGroupOptions::parse_bloom_filter(Config::get_str("Hypertable.RangeServer"
@@ -215,6 +274,21 @@ CellStoreV7::create(const char *fname, size_t max_entries,
   m_trailer.blocksize = blocksize;
   m_uncompressed_blocksize = blocksize;
 
+  if (!strcasecmp(key_encoding.c_str(), "delta") ||
+      !strcasecmp(key_encoding.c_str(), "columnar")) {
+    m_trailer.key_compression_scheme = KeyCompressionType::DELTA;
+    m_key_compressor = make_shared<KeyCompressorDelta>();
+    // Columnar blocks rely on delta keys carrying their own length
+    if (!strcasecmp(key_encoding.c_str(), "columnar")) {
+      m_trailer.flags |= CellStoreTrailerV7::VALUE_STREAMS;
+      m_write_value_streams = true;
+    }
+  }
+  else {
+    m_trailer.key_compression_scheme = KeyCompressionType::PREFIX;
+    m_key_compressor = make_shared<KeyCompressorPrefix>();
+  }
+
   // set up the "column_ttl" vector
   HT_ASSERT(m_schema);
   ColumnFamilySpecs &column_family_specs = m_schema->get_column_families();
@@ -240,6 +314,21 @@ CellStoreV7::create(const char *fname, size_t max_entries,
       (BlockCompressionCodec::Type)m_trailer.compression_type,
       m_compressor_args);
 
+  // Data blocks are held back until there is enough data to train the
+  // dictionary they are compressed with
+  m_dictionary_training_size = m_compressor->dictionary_training_size();
+
+  int32_t compression_threads = Config::get_i32("Hypertable.RangeServer"
+                                                ".CellStore.Compression.Threads");
+  if (compression_threads > 0 &&
+      m_trailer.compression_type != BlockCompressionCodec::NONE) {
+    int32_t max_outstanding = Config::get_i32("Hypertable.RangeServer"
+                                              ".CellStore.Compression.MaxOutstanding");
+    m_compression_pipeline = make_unique<BlockCompressionPipeline>(
+        (BlockCompressionCodec::Type)m_trailer.compression_type,
+        m_compressor_args, compression_threads, max_outstanding);
+  }
+
   uint32_t oflags = Filesystem::OPEN_FLAG_DIRECTIO|Filesystem::OPEN_FLAG_OVERWRITE;
   m_fd = m_filesys->create(m_filename, oflags, -1, replication, -1);
 
@@ -263,6 +352,8 @@ CellStoreV7::create(const char *fname, size_t max_entries,
     }
     else
       m_filter_false_positive_prob = props->get_f64("false-positive");
+    if (Config::get_bool("Hypertable.RangeServer.CellStore.BloomFilter.Blocked"))
+      m_bloom_filter_layout = BLOOM_FILTER_LAYOUT_BLOCKED;
     m_bloom_filter_items = new BloomFilterItems(); // aproximator items
   }
   HT_DEBUG_OUT <<"bloom-filter-mode="<< m_bloom_filter_mode
@@ -280,11 +371,13 @@ void CellStoreV7::create_bloom_filter(bool is_approx) {
   try {
     if (m_filter_false_positive_prob != 0.0)
       m_bloom_filter = new BloomFilterWithChecksum(m_trailer.filter_items_estimate,
-                                                   m_filter_false_positive_prob);
+                                                   m_filter_false_positive_prob,
+                                                   m_bloom_filter_layout);
     else
       m_bloom_filter = new BloomFilterWithChecksum(m_trailer.filter_items_estimate,
                                                    m_bloom_bits_per_item,
-                                                   m_trailer.bloom_filter_hash_count);
+                                                   m_trailer.bloom_filter_hash_count,
+                                                   m_bloom_filter_layout);
   }
   catch(Exception &e) {
     HT_FATAL_OUT << "Error creating new BloomFilter for CellStore '"
@@ -365,10 +458,16 @@ void CellStoreV7::load_bloom_filter() {
                << m_filename <<"' with "<< m_trailer.filter_items_estimate
                << " items"<< HT_END;
   try {
+    // Stores written without the BLOCKED_BLOOM_FILTER flag use the
+    // classic layout
+    BloomFilterLayout layout =
+      (m_trailer.flags & CellStoreTrailerV7::BLOCKED_BLOOM_FILTER) ?
+      BLOOM_FILTER_LAYOUT_BLOCKED : BLOOM_FILTER_LAYOUT_CLASSIC;
     m_bloom_filter = new BloomFilterWithChecksum(m_trailer.filter_items_actual,
                                                  m_trailer.filter_items_actual,
                                                  m_trailer.filter_length,
-                                                 m_trailer.bloom_filter_hash_count);
+                                                 m_trailer.bloom_filter_hash_count,
+                                                 layout);
   }
   catch(Exception &e) {
     HT_FATAL_OUT << "Error loading BloomFilter for CellStore '"
@@ -432,6 +531,9 @@ uint64_t CellStoreV7::purge_indexes() {
         m_index_map64.clear();
       else
         m_index_map32.clear();
+      m_block_summaries.clear();
+      m_skip_decisions.clear();
+      m_summaries_resident = false;
       m_index_stats.block_index_memory = 0;
     }
   }
@@ -444,8 +546,6 @@ uint64_t CellStoreV7::purge_indexes() {
 
 
 void CellStoreV7::add(const Key &key, const ByteString value) {
-  EventPtr event_ptr;
-  DynamicBuffer zbuf;
 
   if (key.revision > m_trailer.revision)
     m_trailer.revision = key.revision;
@@ -458,51 +558,30 @@ void CellStoreV7::add(const Key &key, const ByteString value) {
   }
 
   if (m_buffer.fill() > (size_t)m_uncompressed_blocksize) {
-    BlockHeaderCellStore header(BLOCK_HEADER_VERSION, DATA_BLOCK_MAGIC);
 
-    m_index_builder.add_entry(m_key_compressor, m_offset);
-
-    m_uncompressed_data += (float)m_buffer.fill();
-    m_compressor->deflate(m_buffer, zbuf, header, HT_DIRECT_IO_ALIGNMENT);
-    m_compressed_data += (float)zbuf.fill();
-    m_buffer.clear();
-
-    uint64_t llval = ((uint64_t)m_trailer.blocksize
-        * (uint64_t)m_uncompressed_data) / (uint64_t)m_compressed_data;
-    m_uncompressed_blocksize = (int64_t)llval;
-
-    if (m_outstanding_appends >= MAX_APPENDS_OUTSTANDING) {
-      if (!m_sync_handler.wait_for_reply(event_ptr)) {
-        if (event_ptr->type == Event::MESSAGE)
-          HT_THROWF(Hypertable::Protocol::response_code(event_ptr),
-             "Problem writing to FS file '%s' : %s", m_filename.c_str(),
-             Hypertable::Protocol::string_format_message(event_ptr).c_str());
-        HT_THROWF(event_ptr->error,
-                  "Problem writing to FS file '%s'", m_filename.c_str());
-      }
-      m_outstanding_appends--;
-    }
+    m_index_builder.add_key(m_key_compressor);
 
-    if (!HT_IO_ALIGNED(zbuf.fill())) {
-      memset(zbuf.ptr, 0, HT_IO_ALIGNMENT_PADDING(zbuf.fill()));
-      zbuf.ptr += HT_IO_ALIGNMENT_PADDING(zbuf.fill());
+    if (m_write_block_summaries) {
+      m_block_summaries.add(m_block_summary);
+      m_block_summary = CellStoreBlockSummaries::Summary();
     }
 
-    size_t zlen = zbuf.fill();
-    StaticBuffer send_buf(zbuf);
+    if (m_write_value_streams)
+      CellStoreBlockStreams::encode(m_buffer);
+
+    if (m_dictionary_training_size)
+      hold_data_block();
+    else
+      write_data_block(m_buffer);
 
-    try { m_filesys->append(m_fd, send_buf, Filesystem::Flags::NONE, &m_sync_handler); }
-    catch (Exception &e) {
-      HT_THROW2F(e.code(), e, "Problem writing to FS file '%s'",
-                 m_filename.c_str());
-    }
-    m_outstanding_appends++;
-    m_offset += zlen;
     m_key_compressor->reset();
   }
 
   m_key_compressor->add(key);
 
+  if (m_write_block_summaries)
+    m_block_summary.add(key);
+
   size_t key_len = m_key_compressor->length();
   size_t value_len = value.length();
 
@@ -563,34 +642,31 @@ void CellStoreV7::finalize(TableIdentifier *table_identifier) {
   int64_t index_memory = 0;
 
   if (m_buffer.fill() > 0) {
-    BlockHeaderCellStore header(BLOCK_HEADER_VERSION, DATA_BLOCK_MAGIC);
 
-    m_index_builder.add_entry(m_key_compressor, m_offset);
+    m_index_builder.add_key(m_key_compressor);
 
-    m_uncompressed_data += (float)m_buffer.fill();
-    m_compressor->deflate(m_buffer, zbuf, header, HT_DIRECT_IO_ALIGNMENT);
-    m_compressed_data += (float)zbuf.fill();
+    if (m_write_block_summaries)
+      m_block_summaries.add(m_block_summary);
 
-    if (!HT_IO_ALIGNED(zbuf.fill())) {
-      memset(zbuf.ptr, 0, HT_IO_ALIGNMENT_PADDING(zbuf.fill()));
-      zbuf.ptr += HT_IO_ALIGNMENT_PADDING(zbuf.fill());
-    }
-    zlen = zbuf.fill();
-    send_buf = zbuf;
+    if (m_write_value_streams)
+      CellStoreBlockStreams::encode(m_buffer);
 
-    if (m_outstanding_appends >= MAX_APPENDS_OUTSTANDING) {
-      if (!m_sync_handler.wait_for_reply(event_ptr))
-        HT_THROWF(Protocol::response_code(event_ptr),
-                  "Problem finalizing CellStore file '%s' : %s",
-                  m_filename.c_str(),
-                  Protocol::string_format_message(event_ptr).c_str());
-      m_outstanding_appends--;
-    }
+    if (m_dictionary_training_size)
+      hold_data_block();
+    else
+      write_data_block(m_buffer);
+  }
 
-    m_filesys->append(m_fd, send_buf, Filesystem::Flags::NONE, &m_sync_handler);
+  // Stores smaller than the training size train on all of their data
+  if (m_dictionary_training_size)
+    train_dictionary();
 
-    m_outstanding_appends++;
-    m_offset += zlen;
+  if (m_compression_pipeline) {
+    while (m_compression_pipeline->outstanding() > 0) {
+      size_t uncompressed_length = m_compression_pipeline->pop(zbuf);
+      append_block(zbuf, uncompressed_length);
+    }
+    m_compression_pipeline.reset();
   }
 
   m_key_compressor = 0;
@@ -603,7 +679,9 @@ void CellStoreV7::finalize(TableIdentifier *table_identifier) {
   else
     m_trailer.compression_ratio = m_compressed_data / m_uncompressed_data;
 
-  m_trailer.key_compression_scheme = KeyCompressionType::PREFIX;
+  // The index is loaded before the dictionary, so it is written without it
+  if (m_dictionary)
+    m_compressor->set_dictionary(BlockCompressionCodec::DictionaryPtr());
 
   /**
    * Chop the Index buffers down to the exact length
@@ -639,9 +717,6 @@ void CellStoreV7::finalize(TableIdentifier *table_identifier) {
     m_compressor->deflate(m_index_builder.variable_buf(), zbuf, header, HT_DIRECT_IO_ALIGNMENT);
   }
 
-  delete m_compressor;
-  m_compressor = 0;
-
   if (!HT_IO_ALIGNED(zbuf.fill())) {
     memset(zbuf.ptr, 0, HT_IO_ALIGNMENT_PADDING(zbuf.fill()));
     zbuf.ptr += HT_IO_ALIGNMENT_PADDING(zbuf.fill());
@@ -654,6 +729,65 @@ void CellStoreV7::finalize(TableIdentifier *table_identifier) {
   m_outstanding_appends++;
   m_offset += zlen;
 
+  /**
+   * Write block summaries.  They follow the variable index inside the
+   * [var_index_offset, filter_offset) region, which readers that predate
+   * them inflate the variable index from and otherwise ignore.
+   */
+  if (m_write_block_summaries) {
+    DynamicBuffer summary_buf;
+    m_block_summaries.encode(summary_buf);
+    {
+      BlockHeaderCellStore header(BLOCK_HEADER_VERSION, INDEX_SUMMARY_BLOCK_MAGIC);
+      m_compressor->deflate(summary_buf, zbuf, header, HT_DIRECT_IO_ALIGNMENT);
+    }
+
+    if (!HT_IO_ALIGNED(zbuf.fill())) {
+      memset(zbuf.ptr, 0, HT_IO_ALIGNMENT_PADDING(zbuf.fill()));
+      zbuf.ptr += HT_IO_ALIGNMENT_PADDING(zbuf.fill());
+    }
+    zlen = zbuf.fill();
+    send_buf = zbuf;
+
+    m_filesys->append(m_fd, send_buf, Filesystem::Flags::NONE, &m_sync_handler);
+
+    m_outstanding_appends++;
+    m_offset += zlen;
+
+    m_trailer.flags |= CellStoreTrailerV7::BLOCK_SUMMARIES;
+    index_memory += m_block_summaries.memory_used();
+  }
+
+  /**
+   * Write dictionary.  It follows the variable index and block summaries.
+   */
+  if (m_dictionary) {
+    const String &data = m_dictionary->data();
+    DynamicBuffer dictionary_buf(data.length());
+    dictionary_buf.add_unchecked(data.data(), data.length());
+    {
+      BlockHeaderCellStore header(BLOCK_HEADER_VERSION, DICTIONARY_BLOCK_MAGIC);
+      m_compressor->deflate(dictionary_buf, zbuf, header, HT_DIRECT_IO_ALIGNMENT);
+    }
+
+    if (!HT_IO_ALIGNED(zbuf.fill())) {
+      memset(zbuf.ptr, 0, HT_IO_ALIGNMENT_PADDING(zbuf.fill()));
+      zbuf.ptr += HT_IO_ALIGNMENT_PADDING(zbuf.fill());
+    }
+    zlen = zbuf.fill();
+    send_buf = zbuf;
+
+    m_filesys->append(m_fd, send_buf, Filesystem::Flags::NONE, &m_sync_handler);
+
+    m_outstanding_appends++;
+    m_offset += zlen;
+
+    m_trailer.flags |= CellStoreTrailerV7::DICTIONARY;
+  }
+
+  delete m_compressor;
+  m_compressor = 0;
+
   // write filter_offset
   m_trailer.filter_offset = m_offset;
 
@@ -671,6 +805,8 @@ void CellStoreV7::finalize(TableIdentifier *table_identifier) {
       m_trailer.filter_items_actual = m_bloom_filter->get_items_actual();
       m_trailer.bloom_filter_mode = m_bloom_filter_mode;
       m_trailer.bloom_filter_hash_count = m_bloom_filter->get_num_hashes();
+      if (m_bloom_filter->get_layout() == BLOOM_FILTER_LAYOUT_BLOCKED)
+        m_trailer.flags |= CellStoreTrailerV7::BLOCKED_BLOOM_FILTER;
       m_bloom_filter->serialize(send_buf);
       m_filesys->append(m_fd, send_buf, Filesystem::Flags::NONE, &m_sync_handler);
       m_outstanding_appends++;
@@ -728,7 +864,7 @@ void CellStoreV7::finalize(TableIdentifier *table_identifier) {
                        m_index_builder.variable_buf(),
                        m_trailer.fix_index_offset);
     m_trailer.index_entries = m_index_map64.index_entries();
-    index_memory = m_index_map64.memory_used();
+    index_memory += m_index_map64.memory_used();
     m_trailer.flags |= CellStoreTrailerV7::INDEX_64BIT;
     m_disk_usage = m_index_map64.disk_used();
     fraction_covered = m_index_map64.fraction_covered();
@@ -739,7 +875,7 @@ void CellStoreV7::finalize(TableIdentifier *table_identifier) {
                        m_index_builder.variable_buf(),
                        m_trailer.fix_index_offset);
     m_trailer.index_entries = m_index_map32.index_entries();
-    index_memory = m_index_map32.memory_used();
+    index_memory += m_index_map32.memory_used();
     m_disk_usage = m_index_map32.disk_used();
     fraction_covered = m_index_map32.fraction_covered();
     m_block_count = m_index_map32.index_entries();
@@ -800,11 +936,124 @@ void CellStoreV7::finalize(TableIdentifier *table_identifier) {
   m_column_ttl = 0;
 
   Global::memory_tracker->add( sizeof(CellStoreV7) + sizeof(CellStoreInfo) + m_index_stats.block_index_memory + m_index_stats.bloom_filter_memory );
+
+  if (m_dictionary)
+    Global::memory_tracker->add(m_dictionary->memory_used());
+}
+
+
+void CellStoreV7::append_block(DynamicBuffer &zbuf,
+                               size_t uncompressed_length) {
+  EventPtr event_ptr;
+
+  m_index_builder.add_offset(m_offset);
+
+  if (m_write_block_summaries)
+    m_block_summaries.summaries()[m_blocks_appended++].offset = m_offset;
+
+  m_uncompressed_data += (float)uncompressed_length;
+  m_compressed_data += (float)zbuf.fill();
+
+  uint64_t llval = ((uint64_t)m_trailer.blocksize
+      * (uint64_t)m_uncompressed_data) / (uint64_t)m_compressed_data;
+  m_uncompressed_blocksize = (int64_t)llval;
+
+  if (m_outstanding_appends >= MAX_APPENDS_OUTSTANDING) {
+    if (!m_sync_handler.wait_for_reply(event_ptr)) {
+      if (event_ptr->type == Event::MESSAGE)
+        HT_THROWF(Hypertable::Protocol::response_code(event_ptr),
+           "Problem writing to FS file '%s' : %s", m_filename.c_str(),
+           Hypertable::Protocol::string_format_message(event_ptr).c_str());
+      HT_THROWF(event_ptr->error,
+                "Problem writing to FS file '%s'", m_filename.c_str());
+    }
+    m_outstanding_appends--;
+  }
+
+  if (!HT_IO_ALIGNED(zbuf.fill())) {
+    memset(zbuf.ptr, 0, HT_IO_ALIGNMENT_PADDING(zbuf.fill()));
+    zbuf.ptr += HT_IO_ALIGNMENT_PADDING(zbuf.fill());
+  }
+
+  size_t zlen = zbuf.fill();
+  StaticBuffer send_buf(zbuf);
+
+  try { m_filesys->append(m_fd, send_buf, Filesystem::Flags::NONE, &m_sync_handler); }
+  catch (Exception &e) {
+    HT_THROW2F(e.code(), e, "Problem writing to FS file '%s'",
+               m_filename.c_str());
+  }
+  m_outstanding_appends++;
+  m_offset += zlen;
+}
+
+
+void CellStoreV7::write_data_block(DynamicBuffer &buf) {
+  DynamicBuffer zbuf;
+
+  if (m_compression_pipeline) {
+    // Append blocks that are already compressed and make room for this one
+    while (m_compression_pipeline->full() || m_compression_pipeline->ready()) {
+      size_t uncompressed_length = m_compression_pipeline->pop(zbuf);
+      append_block(zbuf, uncompressed_length);
+    }
+    m_compression_pipeline->submit(buf, BLOCK_HEADER_VERSION,
+                                   DATA_BLOCK_MAGIC);
+    buf.reserve(m_trailer.blocksize*4);
+  }
+  else {
+    BlockHeaderCellStore header(BLOCK_HEADER_VERSION, DATA_BLOCK_MAGIC);
+    m_compressor->deflate(buf, zbuf, header, HT_DIRECT_IO_ALIGNMENT);
+    append_block(zbuf, buf.fill());
+    buf.clear();
+  }
+}
+
+
+void CellStoreV7::hold_data_block() {
+  m_training_data.add(m_buffer.base, m_buffer.fill());
+  m_training_sizes.push_back(m_buffer.fill());
+  m_buffer.clear();
+  if (m_training_data.fill() >= m_dictionary_training_size)
+    train_dictionary();
 }
 
 
-void CellStoreV7::IndexBuilder::add_entry(KeyCompressorPtr &key_compressor,
-                                          int64_t offset) {
+void CellStoreV7::train_dictionary() {
+  m_dictionary_training_size = 0;
+
+  m_dictionary = m_compressor->train_dictionary(m_training_data.base,
+                                                m_training_sizes);
+  if (m_dictionary) {
+    m_compressor->set_dictionary(m_dictionary);
+    if (m_compression_pipeline)
+      m_compression_pipeline->set_dictionary(m_dictionary);
+  }
+
+  DynamicBuffer buf;
+  const uint8_t *ptr = m_training_data.base;
+  for (auto size : m_training_sizes) {
+    buf.clear();
+    buf.reserve(size);
+    buf.add_unchecked(ptr, size);
+    ptr += size;
+    write_data_block(buf);
+  }
+
+  m_training_data.free();
+  m_training_sizes.clear();
+}
+
+
+void CellStoreV7::IndexBuilder::add_key(KeyCompressorPtr &key_compressor) {
+  size_t key_len = key_compressor->length_uncompressed();
+  m_variable.ensure(key_len);
+  key_compressor->write_uncompressed(m_variable.ptr);
+  m_variable.ptr += key_len;
+}
+
+
+void CellStoreV7::IndexBuilder::add_offset(int64_t offset) {
 
   // switch to 64-bit offsets if offset being added is >= 2^32
   if (!m_bigint && offset >= 4294967296LL) {
@@ -823,13 +1072,7 @@ void CellStoreV7::IndexBuilder::add_entry(KeyCompressorPtr &key_compressor,
     m_bigint = true;
   }
 
-  // Add key to variable buffer
-  size_t key_len = key_compressor->length_uncompressed();
-  m_variable.ensure(key_len);
-  key_compressor->write_uncompressed(m_variable.ptr);
-  m_variable.ptr += key_len;
-
-    // Serialize offset into fix index buffer
+  // Serialize offset into fix index buffer
   if (m_bigint) {
     m_fixed.ensure(8);
     memcpy(m_fixed.ptr, &offset, 8);
@@ -892,6 +1135,10 @@ CellStoreV7::open(const String &fname, const String &start_row,
   // This is necessary to get m_disk_usage and m_block_count set properly
   load_block_index();
 
+  // Data blocks can't be read without the dictionary
+  if (m_trailer.flags & CellStoreTrailerV7::DICTIONARY)
+    load_dictionary();
+
   Global::memory_tracker->add( sizeof(CellStoreV7) + sizeof(CellStoreInfo) );
 
 }
@@ -909,7 +1156,8 @@ CellStoreV7::rescope(const String &start_row, const String &end_row) {
     Global::memory_tracker->subtract( m_index_stats.block_index_memory );
     if (m_64bit_index) {
       m_index_map64.rescope(m_start_row, m_end_row);
-      m_index_stats.block_index_memory = m_index_map64.memory_used();
+      m_index_stats.block_index_memory = m_index_map64.memory_used() +
+        m_block_summaries.memory_used();
       m_disk_usage = m_index_map64.disk_used() + 
         (int64_t)((double)(m_file_length-m_trailer.fix_index_offset) *
 		  m_index_map64.fraction_covered());
@@ -917,7 +1165,8 @@ CellStoreV7::rescope(const String &start_row, const String &end_row) {
     }
     else {
       m_index_map32.rescope(m_start_row, m_end_row);
-      m_index_stats.block_index_memory = m_index_map32.memory_used();
+      m_index_stats.block_index_memory = m_index_map32.memory_used() +
+        m_block_summaries.memory_used();
       m_disk_usage = m_index_map32.disk_used() + 
         (int64_t)((double)(m_file_length-m_trailer.fix_index_offset) *
 		  m_index_map32.fraction_covered());
@@ -941,7 +1190,9 @@ void CellStoreV7::load_block_index() {
 
   HT_ASSERT(m_index_stats.block_index_memory == 0);
 
-  unique_ptr<BlockCompressionCodec> compressor(create_block_compression_codec());
+  // The index is written without the dictionary
+  unique_ptr<BlockCompressionCodec> compressor(CompressorFactory::create_block_codec(
+      (BlockCompressionCodec::Type)m_trailer.compression_type));
 
   amount = index_amount = m_trailer.filter_offset - m_trailer.fix_index_offset;
 
@@ -980,6 +1231,33 @@ void CellStoreV7::load_block_index() {
 
     if (!header.check_magic(INDEX_VARIABLE_BLOCK_MAGIC))
       HT_THROW(Error::BLOCK_COMPRESSOR_BAD_MAGIC, m_filename);
+
+    // Offset (from var_index_offset) of the block following the one last
+    // inflated
+    size_t next_offset = header.encoded_length() + header.get_data_zlength();
+    if (!HT_IO_ALIGNED(next_offset))
+      next_offset += HT_IO_ALIGNMENT_PADDING(next_offset);
+
+    /** inflate block summaries, which follow the variable index **/
+    if (m_trailer.flags & CellStoreTrailerV7::BLOCK_SUMMARIES) {
+      DynamicBuffer sbuf(0, false);
+      DynamicBuffer summary_buf;
+      if ((int64_t)next_offset >= amount)
+        HT_THROWF(Error::RANGESERVER_CORRUPT_CELLSTORE, "Missing block "
+                  "summaries in CellStore '%s'", m_filename.c_str());
+      sbuf.base = vbuf.base + next_offset;
+      sbuf.ptr = vbuf.ptr;
+
+      compressor->inflate(sbuf, summary_buf, header);
+
+      if (!header.check_magic(INDEX_SUMMARY_BLOCK_MAGIC))
+        HT_THROW(Error::BLOCK_COMPRESSOR_BAD_MAGIC, m_filename);
+
+      const uint8_t *ptr = summary_buf.base;
+      size_t remaining = summary_buf.fill();
+      m_block_summaries.decode(&ptr, &remaining);
+      m_skip_decisions.clear();
+    }
   }
   catch (Exception &e) {
     String msg;
@@ -1006,7 +1284,8 @@ void CellStoreV7::load_block_index() {
     m_index_map64.load(m_index_builder.fixed_buf(),
                        m_index_builder.variable_buf(),
                        m_trailer.fix_index_offset, m_start_row, m_end_row);
-    m_index_stats.block_index_memory = m_index_map64.memory_used();
+    m_index_stats.block_index_memory = m_index_map64.memory_used() +
+      m_block_summaries.memory_used();
     m_disk_usage = m_index_map64.disk_used() + 
       (int64_t)((double)(m_file_length-m_trailer.fix_index_offset) *
 		m_index_map64.fraction_covered());
@@ -1016,7 +1295,8 @@ void CellStoreV7::load_block_index() {
     m_index_map32.load(m_index_builder.fixed_buf(),
                        m_index_builder.variable_buf(),
                        m_trailer.fix_index_offset, m_start_row, m_end_row);
-    m_index_stats.block_index_memory = m_index_map32.memory_used();
+    m_index_stats.block_index_memory = m_index_map32.memory_used() +
+      m_block_summaries.memory_used();
     m_disk_usage = m_index_map32.disk_used() + 
       (int64_t)((double)(m_file_length-m_trailer.fix_index_offset) *
 		m_index_map32.fraction_covered());
@@ -1025,10 +1305,74 @@ void CellStoreV7::load_block_index() {
 
   m_index_builder.release_fixed_buf();
 
+  m_summaries_resident = !m_block_summaries.empty();
+
   Global::memory_tracker->add( m_index_stats.block_index_memory );
 }
 
 
+void CellStoreV7::load_dictionary() {
+  BlockHeaderCellStore header(BLOCK_HEADER_VERSION);
+  DynamicBuffer buf(HT_DIRECT_IO_ALIGNMENT);
+  const uint8_t *ptr;
+  size_t remaining;
+  size_t len;
+
+  HT_ASSERT(!m_dictionary);
+
+  // The dictionary is the last block in the [var_index_offset,
+  // filter_offset) region, following the variable index and block
+  // summaries, so skip them by reading just their headers
+  int64_t offset = m_trailer.var_index_offset;
+  int preceding = (m_trailer.flags & CellStoreTrailerV7::BLOCK_SUMMARIES) ? 2 : 1;
+  for (int i=0; i<preceding; i++) {
+    if (offset + HT_DIRECT_IO_ALIGNMENT > m_trailer.filter_offset)
+      HT_THROWF(Error::RANGESERVER_CORRUPT_CELLSTORE, "Missing "
+                "dictionary in CellStore '%s'", m_filename.c_str());
+    len = m_filesys->pread(m_fd, buf.base, HT_DIRECT_IO_ALIGNMENT, offset, false);
+    if (len != HT_DIRECT_IO_ALIGNMENT)
+      HT_THROWF(Error::FSBROKER_IO_ERROR, "Error loading dictionary for "
+                "CellStore '%s' : tried to read %lld but only got %lld",
+                m_filename.c_str(), (Lld)HT_DIRECT_IO_ALIGNMENT, (Lld)len);
+    ptr = buf.base;
+    remaining = len;
+    header.decode(&ptr, &remaining);
+    offset += header.encoded_length() + header.get_data_zlength();
+    if (!HT_IO_ALIGNED(offset))
+      offset += HT_IO_ALIGNMENT_PADDING(offset);
+  }
+
+  if (offset >= m_trailer.filter_offset)
+    HT_THROWF(Error::RANGESERVER_CORRUPT_CELLSTORE, "Missing dictionary in "
+              "CellStore '%s'", m_filename.c_str());
+
+  int64_t amount = m_trailer.filter_offset - offset;
+  DynamicBuffer dbuf(amount);
+  DynamicBuffer dictionary_buf;
+
+  len = m_filesys->pread(m_fd, dbuf.base, amount, offset, false);
+  if ((int64_t)len != amount)
+    HT_THROWF(Error::FSBROKER_IO_ERROR, "Error loading dictionary for "
+              "CellStore '%s' : tried to read %lld but only got %lld",
+              m_filename.c_str(), (Lld)amount, (Lld)len);
+  dbuf.ptr = dbuf.base + len;
+
+  unique_ptr<BlockCompressionCodec> compressor(CompressorFactory::create_block_codec(
+      (BlockCompressionCodec::Type)m_trailer.compression_type));
+
+  compressor->inflate(dbuf, dictionary_buf, header);
+
+  if (!header.check_magic(DICTIONARY_BLOCK_MAGIC))
+    HT_THROW(Error::BLOCK_COMPRESSOR_BAD_MAGIC, m_filename);
+
+  m_bytes_read += amount;
+
+  m_dictionary = compressor->load_dictionary(dictionary_buf.base,
+                                             dictionary_buf.fill());
+  Global::memory_tracker->add(m_dictionary->memory_used());
+}
+
+
 bool CellStoreV7::may_contain(ScanContext *scan_ctx) {
 
   if (m_bloom_filter_mode == BLOOM_FILTER_DISABLED)
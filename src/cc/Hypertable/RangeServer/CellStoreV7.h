@@ -28,8 +28,10 @@
 #ifndef Hypertable_RangeServer_CellStoreV7_h
 #define Hypertable_RangeServer_CellStoreV7_h
 
+#include "BlockCompressionPipeline.h"
 #include "CellStore.h"
 #include "CellStoreBlockIndexArray.h"
+#include "CellStoreBlockSummaries.h"
 #include "CellStoreTrailerV7.h"
 #include "KeyCompressor.h"
 
@@ -42,7 +44,9 @@
 #include <Common/BloomFilterWithChecksum.h>
 #include <Common/DynamicBuffer.h>
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -63,7 +67,12 @@ namespace Hypertable {
     class IndexBuilder {
     public:
       IndexBuilder() : m_bigint(false) { }
-      void add_entry(KeyCompressorPtr &key_compressor, int64_t offset);
+      void add_entry(KeyCompressorPtr &key_compressor, int64_t offset) {
+        add_key(key_compressor);
+        add_offset(offset);
+      }
+      void add_key(KeyCompressorPtr &key_compressor);
+      void add_offset(int64_t offset);
       DynamicBuffer &fixed_buf() { return m_fixed; }
       DynamicBuffer &variable_buf() { return m_variable; }
       bool big_int() { return m_bigint; }
@@ -91,6 +100,10 @@ namespace Hypertable {
     virtual void rescope(const String &start_row, const String &end_row);
     virtual int64_t get_blocksize() { return m_trailer.blocksize; }
     bool may_contain(ScanContext *scan_ctx) override;
+
+    const CellStoreBlockSummaries *get_block_summaries() override {
+      return m_block_summaries.empty() ? 0 : &m_block_summaries;
+    }
     virtual uint64_t disk_usage() { return m_disk_usage; }
     virtual float compression_ratio() { return m_trailer.compression_ratio; }
     virtual void split_row_estimate_data(SplitRowDataMapT &split_row_data);
@@ -112,6 +125,9 @@ namespace Hypertable {
     CellListScannerPtr create_scanner(ScanContext *scan_ctx) override;
     virtual BlockCompressionCodec *create_block_compression_codec();
     virtual KeyDecompressor *create_key_decompressor();
+    bool has_value_streams() override {
+      return (m_trailer.flags & CellStoreTrailerV7::VALUE_STREAMS) != 0;
+    }
     virtual void display_block_info();
     virtual int64_t end_of_last_block() { return m_trailer.fix_index_offset; }
 
@@ -155,8 +171,69 @@ namespace Hypertable {
     void create_bloom_filter(bool is_approx = false);
     void load_bloom_filter();
     void load_block_index();
+
+    /// Loads the compression dictionary of data blocks.
+    /// It is loaded independently of the block index, which may be purged,
+    /// and kept for the lifetime of the store.  Called from open() and,
+    /// with #m_mutex locked, from create_block_compression_codec().
+    void load_dictionary();
+
     void load_replaced_files();
 
+    /// Appends a compressed data block to the file.
+    /// Records the block offset in the block index, updates the compression
+    /// statistics, pads the block to the direct I/O alignment and issues an
+    /// asynchronous append, first waiting for an earlier append to complete
+    /// if MAX_APPENDS_OUTSTANDING are in flight.
+    /// @param zbuf Compressed block
+    /// @param uncompressed_length Uncompressed length of block
+    void append_block(DynamicBuffer &zbuf, size_t uncompressed_length);
+
+    /// Compresses a data block and appends it to the file.
+    /// Submits the block to #m_compression_pipeline, first appending blocks
+    /// that are already compressed, or compresses and appends it directly if
+    /// there is no pipeline.  <code>buf</code> is left empty and ready to be
+    /// filled with the next block.
+    /// @param buf Uncompressed block
+    void write_data_block(DynamicBuffer &buf);
+
+    /// Holds back the block in #m_buffer for dictionary training.
+    /// Moves the block to #m_training_data and calls train_dictionary() once
+    /// #m_dictionary_training_size bytes are held.
+    void hold_data_block();
+
+    /// Trains a dictionary from the held back blocks and writes them.
+    /// If training succeeds, the dictionary is set on #m_compressor and
+    /// #m_compression_pipeline before the held back blocks are written.
+    /// Dictionary training is turned off afterwards.
+    void train_dictionary();
+
+    /// Block skipping decision for an unrestricted scan.
+    struct SkipDecision {
+      /// Column families selected by the scan, one bit per family
+      uint64_t families[4] {};
+      /// Scan revision, capped at the store revision
+      int64_t revision {};
+      /// Scan time interval
+      std::pair<int64_t, int64_t> time_interval;
+      /// <i>true</i> if the scan skips blocks
+      bool skip_blocks {};
+    };
+
+    /// Maximum number of decisions kept in #m_skip_decisions
+    static const size_t SKIP_DECISION_CACHE_SIZE = 8;
+
+    /// Decides whether an unrestricted scan skips blocks.
+    /// A scan skips blocks, scanning through the block index instead of
+    /// reading ahead, if the block summaries exclude at least a quarter of
+    /// the blocks.  Decisions are cached in #m_skip_decisions so that
+    /// repeated scans with the same column families, revision and time
+    /// interval don't walk the summaries again.  Must be called with
+    /// #m_mutex locked and #m_block_summaries loaded.
+    /// @param scan_ctx Scan context
+    /// @return <i>true</i> if the scan should skip blocks
+    bool should_skip_blocks(ScanContext *scan_ctx);
+
     typedef BlobHashSet<> BloomFilterItems;
 
     Filesystem *m_filesys;
@@ -166,6 +243,8 @@ namespace Hypertable {
     bool m_64bit_index {};
     CellStoreTrailerV7 m_trailer;
     BlockCompressionCodec *m_compressor {};
+    /// Compresses data blocks off the writer thread (null if disabled)
+    std::unique_ptr<BlockCompressionPipeline> m_compression_pipeline;
     DynamicBuffer m_buffer;
     IndexBuilder m_index_builder;
     DispatchHandlerSynchronizer m_sync_handler;
@@ -184,10 +263,29 @@ namespace Hypertable {
     int64_t m_max_approx_items {};
     float m_bloom_bits_per_item {};
     float m_filter_false_positive_prob {};
+    BloomFilterLayout m_bloom_filter_layout {BLOOM_FILTER_LAYOUT_CLASSIC};
     KeyCompressorPtr m_key_compressor;
     bool m_restricted_range;
     int64_t *m_column_ttl {};
     bool m_replaced_files_loaded {};
+    /// Write per-block summaries
+    bool m_write_block_summaries {};
+    /// Write data blocks in the columnar layout of CellStoreBlockStreams
+    bool m_write_value_streams {};
+    /// Summary of the block being filled
+    CellStoreBlockSummaries::Summary m_block_summary;
+    /// Number of data blocks appended, for setting summary offsets
+    size_t m_blocks_appended {};
+    /// Amount of block data to hold back for training a dictionary (0 once
+    /// the dictionary has been trained or if the codec does not use one)
+    size_t m_dictionary_training_size {};
+    /// Data blocks held back for dictionary training, back to back
+    DynamicBuffer m_training_data;
+    /// Lengths of blocks in #m_training_data
+    std::vector<size_t> m_training_sizes;
+    /// Dictionary set on data block codecs (null if none), read with
+    /// #m_mutex locked once the store is open
+    BlockCompressionCodec::DictionaryPtr m_dictionary;
 
     // Member that require mutex protection
 
@@ -199,6 +297,17 @@ namespace Hypertable {
 
     /// 64-bit block index
     CellStoreBlockIndexArray<int64_t> m_index_map64;
+
+    /// Per-block summaries, loaded and purged with the block index
+    CellStoreBlockSummaries m_block_summaries;
+
+    /// Recent block skipping decisions of unrestricted scans, cleared with
+    /// #m_block_summaries
+    std::vector<SkipDecision> m_skip_decisions;
+
+    /// Set while #m_block_summaries is loaded, so that create_scanner() can
+    /// check for it without taking #m_mutex
+    std::atomic<bool> m_summaries_resident {};
   };
 
   /** @}*/
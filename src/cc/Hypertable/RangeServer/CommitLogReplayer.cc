@@ -0,0 +1,355 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for CommitLogReplayer.
+/// This file contains type definitions for CommitLogReplayer, a class that
+/// replays a commit log into ranges using pools of threads for block
+/// decompression and for adding cells to ranges.
+
+#include <Common/Compat.h>
+
+#include "CommitLogReplayer.h"
+
+#include <Hypertable/Lib/CompressorFactory.h>
+#include <Hypertable/Lib/Key.h>
+
+#include <Common/ByteString.h>
+#include <Common/Error.h>
+#include <Common/Logger.h>
+#include <Common/Stopwatch.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  /// Adds replayed cells to a Range.
+  class RangeDestination : public CommitLogReplayer::Destination {
+  public:
+    RangeDestination(RangePtr &range) : m_range(range) { }
+
+    void add(const vector<const uint8_t *> &cells) override {
+      Key key;
+      SerializedKey skey;
+      ByteString value;
+      lock_guard<Range> lock(*m_range);
+      for (auto cell : cells) {
+        skey.ptr = cell;
+        key.load(skey);
+        value.ptr = cell + skey.length();
+        m_range->add(key, value);
+      }
+    }
+
+  private:
+    /// %Range receiving the cells
+    RangePtr m_range;
+  };
+
+}
+
+CommitLogReplayer::CommitLogReplayer(size_t inflate_threads,
+                                     size_t add_threads,
+                                     TableIdDecoder decoder)
+  : m_decoder(decoder) {
+  inflate_threads = std::max(inflate_threads, (size_t)1);
+  add_threads = std::max(add_threads, (size_t)1);
+  m_max_outstanding = 4 * inflate_threads;
+  for (size_t i=0; i<inflate_threads; i++)
+    m_inflate_threads.push_back(thread(&CommitLogReplayer::inflate_worker, this));
+  for (size_t i=0; i<add_threads; i++)
+    m_add_rings.push_back(make_unique<BoundedRing<AddBatch *>>(64));
+  for (size_t i=0; i<add_threads; i++)
+    m_add_threads.push_back(thread(&CommitLogReplayer::add_worker, this, i));
+}
+
+
+CommitLogReplayer::~CommitLogReplayer() {
+  stop();
+}
+
+
+void CommitLogReplayer::replay(TableInfoMap &replay_map,
+                               CommitLogReader *log_reader) {
+  TableInfoPtr table_info;
+  String skipped_table;
+  map<Range *, DestinationPtr> destinations;
+
+  replay([&](const TableIdentifier &table, const char *row,
+             DestinationPtr &dest, String &start_row, String &end_row) {
+           if (skipped_table == table.id)
+             return false;
+           if (!table_info || strcmp(table_info->identifier().id, table.id)) {
+             if (!replay_map.lookup(table.id, table_info)) {
+               table_info.reset();
+               skipped_table = table.id;
+               return false;
+             }
+             skipped_table.clear();
+           }
+           RangePtr range;
+           if (!table_info->find_containing_range(row, range, start_row,
+                                                  end_row))
+             return false;
+           DestinationPtr &range_dest = destinations[range.get()];
+           if (!range_dest)
+             range_dest = make_shared<RangeDestination>(range);
+           dest = range_dest;
+           return true;
+         }, log_reader);
+}
+
+
+void CommitLogReplayer::replay(Locator locator, CommitLogReader *log_reader) {
+  Stopwatch total_timer;
+  Stopwatch read_timer(false);
+  Stopwatch dispatch_timer(false);
+  unsigned long block_count {};
+  bool eof {};
+
+  try {
+    while (true) {
+
+      // Keep the inflate threads busy
+      while (!eof) {
+        {
+          lock_guard<mutex> lock(m_mutex);
+          if (m_blocks.size() >= m_max_outstanding)
+            break;
+        }
+        unique_ptr<Block> block = make_unique<Block>();
+        read_timer.start();
+        eof = !log_reader->next_block(block->zblock, &block->header,
+                                      &block->fragment);
+        read_timer.stop();
+        if (!eof) {
+          lock_guard<mutex> lock(m_mutex);
+          m_pending.push_back(block.get());
+          m_blocks.push_back(move(block));
+          m_work_cond.notify_one();
+        }
+      }
+
+      unique_ptr<Block> block = pop_block();
+      if (!block)
+        break;
+
+      if (block->error != Error::OK) {
+        HT_ERRORF("Inflate error in commit log '%s' block with revision %lld "
+                  "- %s", log_reader->get_log_dir().c_str(),
+                  (Lld)block->header.get_revision(), block->error_msg.c_str());
+        continue;
+      }
+
+      log_reader->block_inflated(block->fragment,
+                                 block->header.get_revision());
+
+      dispatch_timer.start();
+      dispatch(locator, block.get());
+      dispatch_timer.stop();
+      block_count++;
+    }
+
+    log_reader->finish_blocks();
+
+    // Wait for the add threads to drain their rings
+    for (auto &ring : m_add_rings)
+      ring->push(0);
+    for (auto &t : m_add_threads)
+      t.join();
+    m_add_threads.clear();
+  }
+  catch (...) {
+    stop();
+    throw;
+  }
+
+  if (m_add_error != Error::OK)
+    HT_THROW(m_add_error, m_add_error_msg);
+
+  lock_guard<mutex> lock(m_mutex);
+  HT_INFOF("Replayed %lu blocks of updates from '%s' in %.3fs (read %.3fs, "
+           "inflate %.3fs on %d threads, dispatch %.3fs, add %.3fs on %d "
+           "threads)", block_count, log_reader->get_log_dir().c_str(),
+           total_timer.elapsed(), read_timer.elapsed(), m_inflate_time,
+           (int)m_inflate_threads.size(), dispatch_timer.elapsed(),
+           m_add_time, (int)m_add_rings.size());
+}
+
+
+unique_ptr<CommitLogReplayer::Block> CommitLogReplayer::pop_block() {
+  unique_lock<mutex> lock(m_mutex);
+  if (m_blocks.empty())
+    return unique_ptr<Block>();
+  m_done_cond.wait(lock, [this](){ return m_blocks.front()->done; });
+  unique_ptr<Block> block = move(m_blocks.front());
+  m_blocks.pop_front();
+  return block;
+}
+
+
+void CommitLogReplayer::dispatch(Locator &locator, Block *block) {
+  const uint8_t *ptr = block->data->base;
+  const uint8_t *end = block->data->ptr;
+  size_t len = block->data->fill();
+  TableIdentifier table_id;
+  vector<unique_ptr<AddBatch>> batches(m_add_rings.size());
+  Run *run {};
+  Key key;
+  SerializedKey skey;
+  ByteString value;
+  DestinationPtr dest;
+  String start_row, end_row;
+
+  m_decoder(&ptr, &len, &table_id);
+
+  while (ptr < end) {
+    const uint8_t *cell = ptr;
+
+    // extract the key
+    skey.ptr = ptr;
+    key.load(skey);
+    ptr += skey.length();
+    if (ptr > end)
+      HT_THROW(Error::REQUEST_TRUNCATED, "Problem decoding key");
+    // extract the value
+    value.ptr = ptr;
+    ptr += value.length();
+    if (ptr > end)
+      HT_THROW(Error::REQUEST_TRUNCATED, "Problem decoding value");
+
+    if (run == 0 ||
+        start_row.compare(key.row) >= 0 || end_row.compare(key.row) < 0) {
+      run = 0;
+      if (!locator(table_id, key.row, dest, start_row, end_row))
+        continue;
+      size_t part = partition(dest.get());
+      if (!batches[part]) {
+        batches[part] = make_unique<AddBatch>();
+        batches[part]->data = block->data;
+      }
+      batches[part]->runs.push_back(Run());
+      run = &batches[part]->runs.back();
+      run->dest = dest;
+    }
+
+    run->cells.push_back(cell);
+  }
+
+  for (size_t part=0; part<batches.size(); part++) {
+    if (batches[part]) {
+      m_add_rings[part]->push(batches[part].get());
+      batches[part].release();
+    }
+  }
+}
+
+
+void CommitLogReplayer::inflate_worker() {
+  map<uint16_t, unique_ptr<BlockCompressionCodec>> codecs;
+  unique_lock<mutex> lock(m_mutex);
+
+  while (true) {
+    m_work_cond.wait(lock, [this](){ return m_shutdown || !m_pending.empty(); });
+    if (m_shutdown)
+      break;
+
+    Block *block = m_pending.front();
+    m_pending.pop_front();
+    lock.unlock();
+
+    Stopwatch stopwatch;
+    try {
+      uint16_t ztype = block->header.get_compression_type();
+      if (ztype >= BlockCompressionCodec::COMPRESSION_TYPE_LIMIT)
+        HT_THROWF(Error::BLOCK_COMPRESSOR_UNSUPPORTED_TYPE,
+                  "Invalid compression type '%d'", (int)ztype);
+      unique_ptr<BlockCompressionCodec> &codec = codecs[ztype];
+      if (!codec)
+        codec.reset(CompressorFactory::create_block_codec((BlockCompressionCodec::Type)ztype));
+      block->data = make_shared<DynamicBuffer>();
+      codec->inflate(block->zblock, *block->data, block->header);
+      block->zblock.free();
+    }
+    catch (Exception &e) {
+      block->error = e.code();
+      block->error_msg = e.what();
+    }
+    stopwatch.stop();
+
+    lock.lock();
+    m_inflate_time += stopwatch.elapsed();
+    block->done = true;
+    m_done_cond.notify_all();
+  }
+}
+
+
+void CommitLogReplayer::add_worker(size_t part) {
+  AddBatch *batch;
+  Stopwatch stopwatch(false);
+
+  while (m_add_rings[part]->pop(batch) && batch) {
+    unique_ptr<AddBatch> holder(batch);
+    stopwatch.start();
+    try {
+      for (auto &run : batch->runs)
+        run.dest->add(run.cells);
+    }
+    catch (Exception &e) {
+      lock_guard<mutex> lock(m_mutex);
+      if (m_add_error == Error::OK) {
+        m_add_error = e.code();
+        m_add_error_msg = e.what();
+      }
+    }
+    stopwatch.stop();
+  }
+
+  lock_guard<mutex> lock(m_mutex);
+  m_add_time += stopwatch.elapsed();
+}
+
+
+void CommitLogReplayer::stop() {
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_shutdown = true;
+    m_work_cond.notify_all();
+  }
+  for (auto &ring : m_add_rings)
+    ring->close();
+  for (auto &t : m_inflate_threads)
+    t.join();
+  m_inflate_threads.clear();
+  for (auto &t : m_add_threads)
+    t.join();
+  m_add_threads.clear();
+  AddBatch *batch;
+  for (auto &ring : m_add_rings) {
+    while (ring->try_pop(batch))
+      delete batch;
+  }
+}
@@ -0,0 +1,245 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for CommitLogReplayer.
+/// This file contains type declarations for CommitLogReplayer, a class that
+/// replays a commit log into ranges using pools of threads for block
+/// decompression and for adding cells to ranges.
+
+#ifndef Hypertable_RangeServer_CommitLogReplayer_h
+#define Hypertable_RangeServer_CommitLogReplayer_h
+
+#include <Hypertable/RangeServer/Range.h>
+#include <Hypertable/RangeServer/TableInfoMap.h>
+
+#include <Hypertable/Lib/BlockCompressionCodec.h>
+#include <Hypertable/Lib/BlockHeaderCommitLog.h>
+#include <Hypertable/Lib/CommitLogReader.h>
+#include <Hypertable/Lib/TableIdentifier.h>
+
+#include <Common/BoundedRing.h>
+#include <Common/DynamicBuffer.h>
+#include <Common/String.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Hypertable {
+
+  /// @addtogroup RangeServer
+  /// @{
+
+  /// Replays a commit log into ranges on pools of threads.
+  /// The calling thread reads compressed blocks from the log in order and
+  /// hands them to inflate threads, keeping up to #m_max_outstanding blocks
+  /// in flight.  It takes the inflated blocks back in log order, reports
+  /// them to the log reader so that fragment revisions only advance past
+  /// blocks that were successfully inflated, looks up the range of each
+  /// cell, and queues runs of cells on the add thread that owns the range.
+  /// Each range is owned by one add thread, chosen by partition(), so the
+  /// cells of a range are added in log order while different ranges
+  /// populate their cell caches in parallel.  The time spent in each phase
+  /// is logged when the replay finishes.
+  class CommitLogReplayer {
+  public:
+
+    /// Decodes the table identifier at the start of a commit log block
+    typedef std::function<void(const uint8_t **bufp, size_t *remainp,
+                               TableIdentifier *tid)> TableIdDecoder;
+
+    /// Receiver of the cells replayed into one range.
+    class Destination {
+    public:
+      virtual ~Destination() { }
+
+      /// Adds cells to the range.
+      /// Called on an add thread, with the cells in log order.
+      /// @param cells Pointers to the serialized key of each cell, followed
+      /// by its value
+      virtual void add(const std::vector<const uint8_t *> &cells) = 0;
+    };
+
+    /// Smart pointer to Destination
+    typedef std::shared_ptr<Destination> DestinationPtr;
+
+    /// Finds the destination of a row.
+    /// Called on the replay thread.  Sets <code>dest</code> to the
+    /// destination for the range of <code>table</code> containing
+    /// <code>row</code>, which must be the same object for every row of the
+    /// range, and sets <code>start_row</code> and <code>end_row</code> to the
+    /// range boundaries.  Returns <i>false</i> if the row is not replayed.
+    typedef std::function<bool(const TableIdentifier &table, const char *row,
+                               DestinationPtr &dest, String &start_row,
+                               String &end_row)> Locator;
+
+    /// Constructor.
+    /// Starts the inflate and add threads.
+    /// @param inflate_threads Number of block inflate threads
+    /// @param add_threads Number of range add threads
+    /// @param decoder Table identifier decoder
+    CommitLogReplayer(size_t inflate_threads, size_t add_threads,
+                      TableIdDecoder decoder);
+
+    /// Destructor.
+    /// Stops the threads.
+    ~CommitLogReplayer();
+
+    /// Replays a commit log.
+    /// Adds each cell in the log to the range in <code>replay_map</code>
+    /// that contains it, skipping cells of unknown tables or rows.
+    /// @param replay_map Map of ranges being replayed
+    /// @param log_reader Commit log reader
+    /// @throws Exception if a block is truncated or a cell can't be added
+    void replay(TableInfoMap &replay_map, CommitLogReader *log_reader);
+
+    /// Replays a commit log into the destinations found by a locator.
+    /// @param locator Finds the destination of each cell
+    /// @param log_reader Commit log reader
+    /// @throws Exception if a block is truncated or a cell can't be added
+    void replay(Locator locator, CommitLogReader *log_reader);
+
+  private:
+
+    /// Commit log block moving through the inflate threads.
+    struct Block {
+      /// Compressed block
+      DynamicBuffer zblock;
+      /// Inflated block, shared with the add batches referencing it
+      std::shared_ptr<DynamicBuffer> data;
+      /// Block header
+      BlockHeaderCommitLog header;
+      /// Log fragment containing the block
+      CommitLogFileInfo *fragment {};
+      /// Set when an inflate thread has finished with the block
+      bool done {};
+      /// Error code of failed decompression
+      int error {};
+      /// Error message of failed decompression
+      String error_msg;
+    };
+
+    /// Cells of one block to be added to one range, in log order.
+    struct Run {
+      /// Destination receiving the cells
+      DestinationPtr dest;
+      /// Pointers to the serialized key of each cell, followed by its value
+      std::vector<const uint8_t *> cells;
+    };
+
+    /// Runs of one block for the ranges owned by one add thread.
+    struct AddBatch {
+      /// Inflated block holding the cells
+      std::shared_ptr<DynamicBuffer> data;
+      /// Runs of cells
+      std::vector<Run> runs;
+    };
+
+    /// Removes the oldest block, waiting for it to be inflated.
+    /// @return Oldest block
+    std::unique_ptr<Block> pop_block();
+
+    /// Looks up the ranges of the cells in a block and queues them on the
+    /// add threads.
+    /// @param locator Finds the destination of each cell
+    /// @param block Inflated block
+    void dispatch(Locator &locator, Block *block);
+
+    /// Inflate thread function.
+    void inflate_worker();
+
+    /// Add thread function.
+    /// @param part Partition handled by this thread
+    void add_worker(size_t part);
+
+    /// Stops the threads, discarding queued work.
+    void stop();
+
+    /// Returns the add thread that owns a destination.
+    /// @param dest Destination
+    /// @return Index into #m_add_rings
+    size_t partition(Destination *dest) const {
+      uint64_t h = (uint64_t)(uintptr_t)dest;
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      return h % m_add_rings.size();
+    }
+
+    /// Table identifier decoder
+    TableIdDecoder m_decoder;
+
+    /// %Mutex protecting the members below
+    std::mutex m_mutex;
+
+    /// Signals inflate threads that a block is available or the replayer is
+    /// stopping
+    std::condition_variable m_work_cond;
+
+    /// Signals the replay thread that a block has been inflated
+    std::condition_variable m_done_cond;
+
+    /// Outstanding blocks in log order
+    std::deque<std::unique_ptr<Block>> m_blocks;
+
+    /// Blocks waiting for an inflate thread
+    std::deque<Block *> m_pending;
+
+    /// Maximum number of outstanding blocks
+    size_t m_max_outstanding {};
+
+    /// Seconds spent inflating, summed over the inflate threads
+    double m_inflate_time {};
+
+    /// Seconds spent adding cells, summed over the add threads
+    double m_add_time {};
+
+    /// Error code of the first failed add
+    int m_add_error {};
+
+    /// Error message of the first failed add
+    String m_add_error_msg;
+
+    /// Set to tell threads to exit
+    bool m_shutdown {};
+
+    /// Inflate threads
+    std::vector<std::thread> m_inflate_threads;
+
+    /// Input rings of the add threads
+    std::vector<std::unique_ptr<BoundedRing<AddBatch *>>> m_add_rings;
+
+    /// Add threads
+    std::vector<std::thread> m_add_threads;
+  };
+
+  /// @}
+
+}
+
+#endif // Hypertable_RangeServer_CommitLogReplayer_h
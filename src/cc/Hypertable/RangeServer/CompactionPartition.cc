@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for CompactionPartition.
+/// This file contains type definitions for CompactionPartition, a class
+/// that merges one row interval of a parallel major compaction into its own
+/// CellStore.
+
+#include <Common/Compat.h>
+
+#include "CompactionPartition.h"
+
+#include <Hypertable/RangeServer/CellStoreTrailerV7.h>
+#include <Hypertable/RangeServer/Global.h>
+
+#include <Hypertable/Lib/Key.h>
+
+#include <Common/ByteString.h>
+#include <Common/Error.h>
+#include <Common/Logger.h>
+
+#include <cstring>
+#include <thread>
+
+using namespace Hypertable;
+using namespace std;
+
+CompactionPartition::CompactionPartition(String &table_name,
+                                         SchemaPtr &schema,
+                                         const String &start_row,
+                                         const String &end_row,
+                                         uint32_t flags) {
+  // Same context as a serial compaction, restricted to the interval
+  m_scan_ctx = make_shared<ScanContext>(schema);
+  m_scan_ctx->set_row_interval(start_row, end_row);
+  m_scan_ctx->force_readahead = true;
+  m_mscanner = make_shared<MergeScannerAccessGroup>(table_name,
+                                                    m_scan_ctx.get(), flags);
+}
+
+
+void CompactionPartition::run(PropertiesPtr &props,
+                              TableIdentifier *identifier,
+                              uint32_t trailer_flags) {
+  Key key;
+  ByteString value;
+
+  try {
+    m_cellstore->create(m_filename.c_str(), m_max_entries, props, identifier);
+
+    while (m_mscanner->get(key, value)) {
+      m_cellstore->add(key, value);
+      m_mscanner->forward();
+    }
+
+    CellStoreTrailerV7 *trailer =
+      dynamic_cast<CellStoreTrailerV7 *>(m_cellstore->get_trailer());
+    trailer->flags |= trailer_flags;
+
+    m_cellstore->finalize(identifier);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << m_filename << " " << e << HT_END;
+    m_error = e.code();
+    m_error_msg = e.what();
+  }
+}
+
+
+void CompactionPartition::run_all(vector<CompactionPartitionPtr> &partitions,
+                                  PropertiesPtr &props,
+                                  TableIdentifier *identifier,
+                                  uint32_t trailer_flags) {
+  vector<thread> threads;
+
+  threads.reserve(partitions.size());
+  for (auto &partition : partitions)
+    threads.push_back(thread(&CompactionPartition::run, partition.get(),
+                             ref(props), identifier, trailer_flags));
+
+  for (auto &t : threads)
+    t.join();
+
+  for (auto &partition : partitions) {
+    if (partition->m_error == Error::OK)
+      continue;
+    int error = partition->m_error;
+    String error_msg = partition->m_error_msg;
+    for (auto &p : partitions) {
+      try {
+        Global::dfs->remove(p->m_filename);
+      }
+      catch (Exception &e) {
+      }
+    }
+    HT_THROW(error, error_msg);
+  }
+}
+
+
+void CompactionPartition::select_rows(CellList::SplitRowDataMapT &split_row_data,
+                                      size_t count, vector<String> &rows,
+                                      vector<int64_t> *weights) {
+  int64_t total {};
+  int64_t cumulative {};
+  int64_t last_cumulative {};
+
+  rows.clear();
+  if (weights)
+    weights->clear();
+
+  for (auto &entry : split_row_data)
+    total += entry.second;
+
+  // Each boundary splits what's left evenly among the remaining partitions,
+  // so a row holding a large share of the cells doesn't starve the rest
+  size_t remaining = count;
+  for (auto &entry : split_row_data) {
+    if (remaining <= 1)
+      break;
+    cumulative += entry.second;
+    if (cumulative < last_cumulative + (total - last_cumulative) / (int64_t)remaining)
+      continue;
+    // Don't end a partition on the last row, it would leave the next empty
+    if (cumulative == total)
+      break;
+    rows.push_back(entry.first);
+    if (weights)
+      weights->push_back(cumulative - last_cumulative);
+    last_cumulative = cumulative;
+    remaining--;
+  }
+
+  if (weights)
+    weights->push_back(total - last_cumulative);
+}
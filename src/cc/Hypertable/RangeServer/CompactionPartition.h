@@ -0,0 +1,180 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for CompactionPartition.
+/// This file contains type declarations for CompactionPartition, a class
+/// that merges one row interval of a parallel major compaction into its own
+/// CellStore.
+
+#ifndef Hypertable_RangeServer_CompactionPartition_h
+#define Hypertable_RangeServer_CompactionPartition_h
+
+#include <Hypertable/RangeServer/CellList.h>
+#include <Hypertable/RangeServer/CellStore.h>
+#include <Hypertable/RangeServer/MergeScannerAccessGroup.h>
+#include <Hypertable/RangeServer/ScanContext.h>
+
+#include <Hypertable/Lib/Schema.h>
+#include <Hypertable/Lib/TableIdentifier.h>
+
+#include <Common/Properties.h>
+#include <Common/String.h>
+
+#include <memory>
+#include <vector>
+
+namespace Hypertable {
+
+  /// @addtogroup RangeServer
+  /// @{
+
+  class CompactionPartition;
+
+  /// Smart pointer to CompactionPartition
+  typedef std::shared_ptr<CompactionPartition> CompactionPartitionPtr;
+
+  /// One row interval of a parallel major compaction.
+  /// A major compaction of a large access group can be split on row
+  /// boundaries into partitions that are merged concurrently.  Since a merge
+  /// never combines cells from different rows, each partition yields exactly
+  /// the cells the serial merge would have produced for its interval, and the
+  /// partition's CellStore can be installed alongside the others.  The
+  /// partition owns the scan context and merge scanner for its interval; the
+  /// caller adds the CellCache and CellStore scanners to the merge scanner
+  /// before calling run_all().
+  class CompactionPartition {
+  public:
+
+    /// Constructor.
+    /// Sets up a scan context like the one of a serial major compaction,
+    /// restricted to rows in the interval
+    /// (<code>start_row</code>, <code>end_row</code>].  An empty
+    /// <code>start_row</code> starts at the beginning of the key space and an
+    /// empty <code>end_row</code> runs to the end.  Cell store scanners
+    /// created with the scan context read ahead rather than going through the
+    /// block cache.
+    /// @param table_name Table name
+    /// @param schema Access group schema
+    /// @param start_row Start row (exclusive)
+    /// @param end_row End row (inclusive)
+    /// @param flags MergeScannerAccessGroup flags
+    CompactionPartition(String &table_name, SchemaPtr &schema,
+                        const String &start_row, const String &end_row,
+                        uint32_t flags);
+
+    /// Returns scan context for creating scanners over the interval.
+    /// @return Scan context
+    ScanContext *get_scan_context() { return m_scan_ctx.get(); }
+
+    /// Returns merge scanner to which interval scanners are added.
+    /// @return Merge scanner
+    MergeScannerAccessGroup *get_merge_scanner() { return m_mscanner.get(); }
+
+    /// Sets the CellStore to be written.
+    /// @param cellstore CellStore object (not yet created)
+    /// @param filename Name of CellStore file
+    /// @param max_entries Estimate of number of cells, used to size the bloom
+    /// filter
+    void set_cellstore(CellStorePtr cellstore, const String &filename,
+                       int64_t max_entries) {
+      m_cellstore = cellstore;
+      m_filename = filename;
+      m_max_entries = max_entries;
+    }
+
+    /// Returns the CellStore written by run().
+    /// @return CellStore
+    CellStorePtr get_cellstore() { return m_cellstore; }
+
+    /// Returns name of CellStore file.
+    /// @return Name of CellStore file
+    const String &get_filename() { return m_filename; }
+
+    /// Merges the partition into its CellStore.
+    /// Creates the CellStore, adds every cell returned by the merge scanner,
+    /// ORs <code>trailer_flags</code> into the trailer flags, and finalizes
+    /// the CellStore.  Exceptions are caught and recorded so they can be
+    /// rethrown on the compaction thread by run_all().
+    /// @param props CellStore properties
+    /// @param identifier Table identifier
+    /// @param trailer_flags Flags to set in the CellStore trailer
+    void run(PropertiesPtr &props, TableIdentifier *identifier,
+             uint32_t trailer_flags);
+
+    /// Runs partitions concurrently.
+    /// Runs each partition on its own thread and waits for all of them to
+    /// finish.  If any partition fails, the CellStore files of all partitions
+    /// are removed and the first error is thrown.
+    /// @param partitions Partitions to run
+    /// @param props CellStore properties
+    /// @param identifier Table identifier
+    /// @param trailer_flags Flags to set in each CellStore trailer
+    static void run_all(std::vector<CompactionPartitionPtr> &partitions,
+                        PropertiesPtr &props, TableIdentifier *identifier,
+                        uint32_t trailer_flags);
+
+    /// Chooses partition boundary rows.
+    /// Walks the row estimates collected from CellStore block indexes with
+    /// CellList::split_row_estimate_data() and picks up to
+    /// <code>count</code>-1 rows that divide the estimated cells into
+    /// <code>count</code> roughly equal parts.  A row holding a large share of
+    /// the cells can make its partition oversized, in which case the cells
+    /// after it are divided evenly among the remaining partitions.  Boundaries are strictly increasing,
+    /// so fewer are returned if the data has too few distinct rows.
+    /// @param split_row_data Row estimates
+    /// @param count Desired number of partitions
+    /// @param rows Filled with boundary rows
+    /// @param weights If non-null, filled with the estimated number of cells
+    /// in each of the <code>rows.size()+1</code> partitions
+    static void select_rows(CellList::SplitRowDataMapT &split_row_data,
+                            size_t count, std::vector<String> &rows,
+                            std::vector<int64_t> *weights=nullptr);
+
+  private:
+
+    /// Scan context
+    ScanContextPtr m_scan_ctx;
+
+    /// Merge scanner
+    MergeScannerAccessGroupPtr m_mscanner;
+
+    /// CellStore being written
+    CellStorePtr m_cellstore;
+
+    /// Name of CellStore file
+    String m_filename;
+
+    /// Cell count estimate passed to CellStore::create()
+    int64_t m_max_entries {};
+
+    /// Error code of exception caught in run()
+    int m_error {};
+
+    /// Message of exception caught in run()
+    String m_error_msg;
+  };
+
+  /// @}
+
+}
+
+#endif // Hypertable_RangeServer_CompactionPartition_h
@@ -38,6 +38,7 @@
 #include <Hypertable/RangeServer/Request/Handler/Heapcheck.h>
 #include <Hypertable/RangeServer/Request/Handler/LoadRange.h>
 #include <Hypertable/RangeServer/Request/Handler/MetadataSync.h>
+#include <Hypertable/RangeServer/Request/Handler/MultiGet.h>
 #include <Hypertable/RangeServer/Request/Handler/PhantomCommitRanges.h>
 #include <Hypertable/RangeServer/Request/Handler/PhantomLoad.h>
 #include <Hypertable/RangeServer/Request/Handler/PhantomPrepareRanges.h>
@@ -113,6 +114,10 @@ void ConnectionHandler::handle(EventPtr &event) {
         handler = new Request::Handler::CreateScanner(m_comm,
             m_range_server, event);
         break;
+      case Lib::RangeServer::Protocol::COMMAND_MULTI_GET:
+        handler = new Request::Handler::MultiGet(m_comm,
+            m_range_server, event);
+        break;
       case Lib::RangeServer::Protocol::COMMAND_DESTROY_SCANNER:
         handler = new Request::Handler::DestroyScanner(m_comm,
             m_range_server, event);
@@ -19,6 +19,12 @@
  * 02110-1301, USA.
  */
 
+
+/// @file
+/// Definitions for FileBlockCache.
+/// This file contains type definitions for FileBlockCache, a sharded cache
+/// of CellStore blocks with scan-resistant (2Q) eviction.
+
 #include <Common/Compat.h>
 
 #include "FileBlockCache.h"
@@ -32,53 +38,123 @@ using namespace std;
 
 atomic<int> FileBlockCache::ms_next_file_id {0};
 
+namespace {
+
+  /// Fraction of a shard's limit reserved for the probationary queue is
+  /// 1/PROBATIONARY_DIVISOR
+  const int64_t PROBATIONARY_DIVISOR = 4;
+
+  /// Ghost keys are remembered for blocks totalling up to
+  /// 1/GHOST_DIVISOR of a shard's limit
+  const int64_t GHOST_DIVISOR = 2;
+
+}
+
+FileBlockCache::FileBlockCache(int64_t min_memory, int64_t max_memory,
+                               bool compressed, size_t shards)
+  : m_compressed(compressed) {
+  HT_ASSERT(min_memory <= max_memory);
+  size_t count = 1;
+  while (count*2 <= shards)
+    count *= 2;
+  while (count > 1 && max_memory / (int64_t)count < MIN_SHARD_MEMORY)
+    count /= 2;
+  m_shards.reserve(count);
+  for (size_t i=0; i<count; i++) {
+    int64_t shard_min = min_memory / count;
+    int64_t shard_max = max_memory / count;
+    if (i == 0) {
+      shard_min += min_memory % count;
+      shard_max += max_memory % count;
+    }
+    m_shards.push_back(unique_ptr<Shard>(new Shard(shard_min, shard_max)));
+  }
+}
+
+
 FileBlockCache::~FileBlockCache() {
-  lock_guard<mutex> lock(m_mutex);
-  for (BlockCache::const_iterator iter = m_cache.begin();
-       iter != m_cache.end(); ++iter)
-    if (!iter->event)
-      delete [] (*iter).block;
-  m_cache.clear();
+  m_shards.clear();
 }
 
+
+FileBlockCache::Shard::~Shard() {
+  lock_guard<std::mutex> lock(mutex);
+  for (auto queue : { &probationary, &protected_lru }) {
+    for (BlockCache::const_iterator iter = queue->begin();
+         iter != queue->end(); ++iter)
+      if (!iter->event)
+        delete [] (*iter).block;
+    queue->clear();
+  }
+}
+
+
 bool
 FileBlockCache::checkout(int file_id, uint64_t file_offset, uint8_t **blockp,
                          uint32_t *lengthp) {
-  lock_guard<mutex> lock(m_mutex);
-  HashIndex &hash_index = m_cache.get<1>();
+  int64_t key = make_key(file_id, file_offset);
+  Shard &s = shard(key);
+  lock_guard<mutex> lock(s.mutex);
   HashIndex::iterator iter;
 
-  m_accesses++;
+  s.accesses++;
 
-  if ((iter = hash_index.find(make_key(file_id, file_offset))) == hash_index.end())
+  BlockCache *queue = s.find(key, &iter);
+  if (queue == nullptr)
     return false;
 
-  BlockCacheEntry entry = *iter;
-  entry.ref_count++;
+  if (queue == &s.protected_lru) {
+    // Move to most recently used position
+    HashIndex &hash_index = s.protected_lru.get<1>();
+    hash_index.modify(iter, IncrementRefCount());
+    s.protected_lru.relocate(s.protected_lru.end(),
+                             s.protected_lru.project<0>(iter));
+  }
+  else {
+    // Second reference, promote from probationary queue
+    BlockCacheEntry entry = *iter;
+    entry.ref_count++;
+    s.probationary.get<1>().erase(iter);
+    s.probationary_bytes -= entry.length;
+    pair<Sequence::iterator, bool> insert_result = s.protected_lru.push_back(entry);
+    assert(insert_result.second);
+    iter = s.protected_lru.project<1>(insert_result.first);
+  }
 
-  hash_index.erase(iter);
+  *blockp = (*iter).block;
+  *lengthp = (*iter).length;
 
-  pair<Sequence::iterator, bool> insert_result = m_cache.push_back(entry);
-  assert(insert_result.second);
+  s.hits++;
+  return true;
+}
 
-  *blockp = (*insert_result.first).block;
-  *lengthp = (*insert_result.first).length;
 
-  m_hits++;
+bool FileBlockCache::pin(int file_id, uint64_t file_offset) {
+  int64_t key = make_key(file_id, file_offset);
+  Shard &s = shard(key);
+  lock_guard<mutex> lock(s.mutex);
+  HashIndex::iterator iter;
+
+  BlockCache *queue = s.find(key, &iter);
+  if (queue == nullptr)
+    return false;
+
+  queue->get<1>().modify(iter, IncrementRefCount());
   return true;
 }
 
 
 void FileBlockCache::checkin(int file_id, uint64_t file_offset) {
-  lock_guard<mutex> lock(m_mutex);
-  HashIndex &hash_index = m_cache.get<1>();
+  int64_t key = make_key(file_id, file_offset);
+  Shard &s = shard(key);
+  lock_guard<mutex> lock(s.mutex);
   HashIndex::iterator iter;
 
-  iter = hash_index.find(make_key(file_id, file_offset));
+  BlockCache *queue = s.find(key, &iter);
 
-  assert(iter != hash_index.end() && (*iter).ref_count > 0);
+  assert(queue && (*iter).ref_count > 0);
 
-  hash_index.modify(iter, DecrementRefCount());
+  queue->get<1>().modify(iter, DecrementRefCount());
 }
 
 
@@ -86,19 +162,21 @@ bool
 FileBlockCache::insert(int file_id, uint64_t file_offset,
 		       uint8_t *block, uint32_t length,
                        const EventPtr &event, bool checkout) {
-  lock_guard<mutex> lock(m_mutex);
-  HashIndex &hash_index = m_cache.get<1>();
+  int64_t key = make_key(file_id, file_offset);
+  Shard &s = shard(key);
+  lock_guard<mutex> lock(s.mutex);
+  HashIndex::iterator iter;
 
-  if (hash_index.find(make_key(file_id, file_offset)) != hash_index.end())
+  if (s.find(key, &iter))
     return false;
 
-  if (m_available < length)
-    make_room(length);
+  if (s.available < length)
+    s.make_room(length);
 
-  if (m_available < length) {
-    if ((length-m_available) <= (m_max_memory-m_limit)) {
-      m_limit += (length-m_available);
-      m_available += (length-m_available);
+  if (s.available < length) {
+    if ((length-s.available) <= (s.max_memory-s.limit)) {
+      s.limit += (length-s.available);
+      s.available += (length-s.available);
     }
     else
       return false;
@@ -109,23 +187,38 @@ FileBlockCache::insert(int file_id, uint64_t file_offset,
   entry.length = length;
   entry.ref_count = checkout ? 1 : 0;
 
-  pair<Sequence::iterator, bool> insert_result = m_cache.push_back(entry);
+  // A block evicted from the probationary queue that is being read back in
+  // is part of the working set, so it goes straight to the protected queue
+  auto &ghost_index = s.ghosts.get<1>();
+  auto ghost_iter = ghost_index.find(key);
+  pair<Sequence::iterator, bool> insert_result;
+  if (ghost_iter != ghost_index.end()) {
+    s.ghost_bytes -= ghost_iter->length;
+    ghost_index.erase(ghost_iter);
+    insert_result = s.protected_lru.push_back(entry);
+  }
+  else {
+    insert_result = s.probationary.push_back(entry);
+    s.probationary_bytes += length;
+  }
   assert(insert_result.second);
   (void)insert_result;
 
-  m_available -= length;
+  s.available -= length;
 
   return true;
 }
 
 
 bool FileBlockCache::contains(int file_id, uint64_t file_offset) {
-  lock_guard<mutex> lock(m_mutex);
-  HashIndex &hash_index = m_cache.get<1>();
-  m_accesses++;
+  int64_t key = make_key(file_id, file_offset);
+  Shard &s = shard(key);
+  lock_guard<mutex> lock(s.mutex);
+  HashIndex::iterator iter;
+  s.accesses++;
 
-  if (hash_index.find(make_key(file_id, file_offset)) != hash_index.end()) {
-    m_hits++;
+  if (s.find(key, &iter)) {
+    s.hits++;
     return true;
   }
   else
@@ -134,55 +227,166 @@ bool FileBlockCache::contains(int file_id, uint64_t file_offset) {
 
 
 void FileBlockCache::increase_limit(int64_t amount) {
-  lock_guard<mutex> lock(m_mutex);
-  int64_t adjusted_amount = amount;
-  if ((m_max_memory-m_limit) < amount)
-    adjusted_amount = m_max_memory - m_limit;
-  m_limit += adjusted_amount;
-  m_available += adjusted_amount;
+  // Shards that hit their maximum pass the remainder on to the next shard
+  int64_t remaining = amount;
+  for (size_t i=0; i<m_shards.size() && remaining > 0; i++) {
+    Shard &s = *m_shards[i];
+    lock_guard<mutex> lock(s.mutex);
+    int64_t adjusted_amount = remaining / (int64_t)(m_shards.size() - i);
+    if (i == m_shards.size() - 1)
+      adjusted_amount = remaining;
+    if ((s.max_memory-s.limit) < adjusted_amount)
+      adjusted_amount = s.max_memory - s.limit;
+    s.limit += adjusted_amount;
+    s.available += adjusted_amount;
+    remaining -= adjusted_amount;
+  }
 }
 
 
 int64_t FileBlockCache::decrease_limit(int64_t amount) {
-  lock_guard<mutex> lock(m_mutex);
+  // Shards that can't shrink by their share pass the remainder on to the
+  // next shard
   int64_t memory_freed = 0;
-  if (m_available < amount) {
-    if (amount > (m_limit - m_min_memory))
-      amount = m_limit - m_min_memory;
-    memory_freed = make_room(amount);
-    if (m_available < amount)
-      amount = m_available;
-  }
-  m_available -= amount;
-  m_limit -= amount;
+  int64_t remaining = amount;
+  for (size_t i=0; i<m_shards.size() && remaining > 0; i++) {
+    Shard &s = *m_shards[i];
+    lock_guard<mutex> lock(s.mutex);
+    int64_t share = remaining / (int64_t)(m_shards.size() - i);
+    if (i == m_shards.size() - 1)
+      share = remaining;
+    if (s.available < share) {
+      if (share > (s.limit - s.min_memory))
+        share = s.limit - s.min_memory;
+      memory_freed += s.make_room(share);
+      if (s.available < share)
+        share = s.available;
+    }
+    s.available -= share;
+    s.limit -= share;
+    remaining -= share;
+  }
   return memory_freed;
 }
 
 
-int64_t FileBlockCache::make_room(int64_t amount) {
-  BlockCache::iterator iter = m_cache.begin();
+int64_t FileBlockCache::get_limit() {
+  int64_t limit = 0;
+  for (auto &s : m_shards) {
+    lock_guard<mutex> lock(s->mutex);
+    limit += s->limit;
+  }
+  return limit;
+}
+
+
+void FileBlockCache::cap_memory_use() {
+  for (auto &s : m_shards) {
+    lock_guard<mutex> lock(s->mutex);
+    int64_t memory_used = s->limit - s->available;
+    if (memory_used > s->min_memory) {
+      s->limit -= s->available;
+      s->available = 0;
+    }
+    else {
+      s->limit = s->min_memory;
+      s->available = s->limit - memory_used;
+    }
+  }
+}
+
+
+int64_t FileBlockCache::memory_used() {
+  int64_t memory_used = 0;
+  for (auto &s : m_shards) {
+    lock_guard<mutex> lock(s->mutex);
+    memory_used += s->limit - s->available;
+  }
+  return memory_used;
+}
+
+
+int64_t FileBlockCache::available() {
+  int64_t available = 0;
+  for (auto &s : m_shards) {
+    lock_guard<mutex> lock(s->mutex);
+    available += s->available;
+  }
+  return available;
+}
+
+
+FileBlockCache::BlockCache *
+FileBlockCache::Shard::find(int64_t key, HashIndex::iterator *iterp) {
+  for (auto queue : { &protected_lru, &probationary }) {
+    HashIndex &hash_index = queue->get<1>();
+    if ((*iterp = hash_index.find(key)) != hash_index.end())
+      return queue;
+  }
+  return nullptr;
+}
+
+
+int64_t FileBlockCache::Shard::make_room(int64_t amount) {
   int64_t amount_freed = 0;
-  while (iter != m_cache.end()) {
+  while (available < amount) {
+    int64_t freed = 0;
+    // Drain the probationary queue first while it holds more than its
+    // share, so blocks touched once are evicted before the working set
+    if (probationary_bytes > limit / PROBATIONARY_DIVISOR ||
+        protected_lru.empty())
+      freed = evict_one(probationary);
+    if (freed == 0)
+      freed = evict_one(protected_lru);
+    if (freed == 0)
+      freed = evict_one(probationary);
+    if (freed == 0)
+      break;
+    amount_freed += freed;
+  }
+  return amount_freed;
+}
+
+
+int64_t FileBlockCache::Shard::evict_one(BlockCache &queue) {
+  for (BlockCache::iterator iter = queue.begin(); iter != queue.end(); ++iter) {
     if ((*iter).ref_count == 0) {
-      m_available += (*iter).length;
-      amount_freed += (*iter).length;
+      int64_t length = (*iter).length;
+      available += length;
+      if (&queue == &probationary) {
+        probationary_bytes -= length;
+        remember(iter->key(), length);
+      }
       if (!iter->event)
         delete [] iter->block;
-      iter = m_cache.erase(iter);
-      if (m_available >= amount)
-	break;
+      queue.erase(iter);
+      return length;
     }
-    else
-      ++iter;
   }
-  return amount_freed;
+  return 0;
+}
+
+
+void FileBlockCache::Shard::remember(int64_t key, uint32_t length) {
+  pair<GhostCache::iterator, bool> insert_result =
+    ghosts.push_back(GhostEntry(key, length));
+  if (insert_result.second)
+    ghost_bytes += length;
+  while (ghost_bytes > limit / GHOST_DIVISOR && !ghosts.empty()) {
+    ghost_bytes -= ghosts.front().length;
+    ghosts.pop_front();
+  }
 }
 
+
 void FileBlockCache::get_stats(uint64_t *max_memoryp, uint64_t *available_memoryp,
                                uint64_t *accessesp, uint64_t *hitsp) {
-  lock_guard<mutex> lock(m_mutex);
-  *max_memoryp = m_limit;
-  *available_memoryp = m_available;
-  *accessesp = m_accesses;
-  *hitsp = m_hits;
+  *max_memoryp = *available_memoryp = *accessesp = *hitsp = 0;
+  for (auto &s : m_shards) {
+    lock_guard<mutex> lock(s->mutex);
+    *max_memoryp += s->limit;
+    *available_memoryp += s->available;
+    *accessesp += s->accesses;
+    *hitsp += s->hits;
+  }
 }
@@ -19,6 +19,12 @@
  * 02110-1301, USA.
  */
 
+
+/// @file
+/// Declarations for FileBlockCache.
+/// This file contains type declarations for FileBlockCache, a sharded cache
+/// of CellStore blocks with scan-resistant (2Q) eviction.
+
 #ifndef Hypertable_RangeServer_FileBlockCache_h
 #define Hypertable_RangeServer_FileBlockCache_h
 
@@ -28,24 +34,55 @@
 
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/identity.hpp>
+#include <boost/multi_index/member.hpp>
 #include <boost/multi_index/mem_fun.hpp>
 #include <boost/multi_index/sequenced_index.hpp>
 
 #include <atomic>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 namespace Hypertable {
   using namespace boost::multi_index;
 
+  /// @addtogroup RangeServer
+  /// @{
+
+  /// Cache of CellStore blocks keyed by (file ID, file offset).
+  /// The cache is split into a power-of-two number of independently locked
+  /// shards so that concurrent scanners touching different blocks don't
+  /// serialize on a single mutex.  The memory limit is divided evenly among
+  /// the shards.  Within each shard blocks are managed with the 2Q policy:
+  /// newly inserted blocks enter a FIFO probationary queue (<i>A1in</i>) and
+  /// are only promoted to the protected LRU queue (<i>Am</i>) when they are
+  /// referenced again, either while still resident or shortly after eviction
+  /// as recorded by a queue of ghost keys (<i>A1out</i>).  Blocks read once
+  /// by a large sequential scan therefore cycle through the probationary
+  /// queue without displacing the working set of point lookups.
   class FileBlockCache {
 
     static std::atomic<int> ms_next_file_id;
 
   public:
-    FileBlockCache(int64_t min_memory, int64_t max_memory, bool compressed)
-      : m_min_memory(min_memory), m_max_memory(max_memory), m_limit(max_memory),
-	m_available(max_memory), m_accesses(0), m_hits(0), m_compressed(compressed)
-    { HT_ASSERT(min_memory <= max_memory); }
+
+    /// Default number of shards
+    static const size_t DEFAULT_SHARDS = 16;
+
+    /// Smallest maximum memory a shard is given.  The shard count is reduced
+    /// until each shard can hold at least this much.
+    static const int64_t MIN_SHARD_MEMORY = 8 * 1024 * 1024;
+
+    /// Constructor.
+    /// @param min_memory Minimum memory limit
+    /// @param max_memory Maximum memory limit
+    /// @param compressed <i>true</i> if cache holds compressed blocks
+    /// @param shards Requested number of shards (rounded down to a power of
+    /// two and reduced so each shard gets at least #MIN_SHARD_MEMORY)
+    FileBlockCache(int64_t min_memory, int64_t max_memory, bool compressed,
+                   size_t shards=DEFAULT_SHARDS);
+
     ~FileBlockCache();
 
     bool compressed() { return m_compressed; }
@@ -53,11 +90,25 @@ namespace Hypertable {
     bool checkout(int file_id, uint64_t file_offset, uint8_t **blockp,
                   uint32_t *lengthp);
     void checkin(int file_id, uint64_t file_offset);
+
+    /// Adds a reference to a block that is already checked out.
+    /// Unlike checkout(), this does not count as an access and leaves the
+    /// block where it is in the eviction queues, so holding a block for the
+    /// duration of a send does not promote it out of the probationary queue.
+    /// The reference is released with checkin().
+    /// @param file_id File ID of block
+    /// @param file_offset File offset of block
+    /// @return <i>true</i> if block is in the cache, <i>false</i> otherwise
+    bool pin(int file_id, uint64_t file_offset);
     bool insert(int file_id, uint64_t file_offset,
 		uint8_t *block, uint32_t length, 
                 const EventPtr &event, bool checkout);
     bool contains(int file_id, uint64_t file_offset);
 
+    /// Raises the memory limit.
+    /// The amount is spread evenly over the shards, none of which is raised
+    /// above its share of max_memory.
+    /// @param amount Amount to raise limit by
     void increase_limit(int64_t amount);
 
     /**
@@ -70,37 +121,21 @@ namespace Hypertable {
      */
     int64_t decrease_limit(int64_t amount);
 
-    int64_t get_limit() {
-      std::lock_guard<std::mutex> lock(m_mutex);
-      return m_limit;
-    }
+    int64_t get_limit();
 
     /**
      * Sets limit to memory currently used, it will not reduce the limit
      * below min_memory
      */
-    void cap_memory_use() {
-      std::lock_guard<std::mutex> lock(m_mutex);
-      int64_t memory_used = m_limit - m_available;
-      if (memory_used > m_min_memory) {
-        m_limit -= m_available;
-        m_available = 0;
-      }
-      else {
-        m_limit = m_min_memory;
-        m_available = m_limit - memory_used;
-      }
-    }
+    void cap_memory_use();
 
-    int64_t memory_used() {
-      std::lock_guard<std::mutex> lock(m_mutex);
-      return (int64_t)(m_limit - m_available);
-    }
+    int64_t memory_used();
 
-    int64_t available() {
-      std::lock_guard<std::mutex> lock(m_mutex);
-      return m_available;
-    }
+    int64_t available();
+
+    /// Returns the number of shards.
+    /// @return Number of shards
+    size_t shards() { return m_shards.size(); }
 
     static int get_next_file_id() {
       return ++ms_next_file_id;
@@ -109,8 +144,6 @@ namespace Hypertable {
                    uint64_t *accessesp, uint64_t *hitsp);
   private:
 
-    int64_t make_room(int64_t amount);
-
     inline static int64_t make_key(int file_id, uint64_t file_offset) {
       HT_ASSERT(file_id < 268435456LL);        // Can't be larger than 2^28
       HT_ASSERT(file_offset < 68719476736LL);  // Can't be larger than 2^36
@@ -138,6 +171,12 @@ namespace Hypertable {
       }
     };
 
+    struct IncrementRefCount {
+      void operator()(BlockCacheEntry &entry) {
+        entry.ref_count++;
+      }
+    };
+
     struct HashI64 {
       std::size_t operator()(int64_t x) const {
         return (std::size_t)((x >> 32) * 31) ^ (std::size_t)x;
@@ -156,17 +195,79 @@ namespace Hypertable {
     typedef BlockCache::nth_index<0>::type Sequence;
     typedef BlockCache::nth_index<1>::type HashIndex;
 
-    std::mutex m_mutex;
-    BlockCache    m_cache;
-    int64_t      m_min_memory;
-    int64_t      m_max_memory;
-    int64_t      m_limit;
-    int64_t      m_available;
-    uint64_t     m_accesses;
-    uint64_t     m_hits;
+    /// Key of a block recently evicted from the probationary queue
+    struct GhostEntry {
+      GhostEntry(int64_t k, uint32_t len) : key(k), length(len) { }
+      int64_t key;
+      uint32_t length;
+    };
+
+    typedef boost::multi_index_container<
+      GhostEntry,
+      indexed_by<
+        sequenced<>,
+        hashed_unique<member<GhostEntry, int64_t, &GhostEntry::key>, HashI64>
+      >
+    > GhostCache;
+
+    /// One independently locked partition of the cache.
+    class Shard {
+    public:
+      Shard(int64_t min_memory, int64_t max_memory)
+        : min_memory(min_memory), max_memory(max_memory), limit(max_memory),
+          available(max_memory) { }
+
+      ~Shard();
+
+      /// Looks up an entry in either queue.
+      /// @param key Block key
+      /// @param iterp Address of iterator set to matching entry
+      /// @return Queue holding entry, or nullptr if not cached
+      BlockCache *find(int64_t key, HashIndex::iterator *iterp);
+
+      /// Evicts unreferenced blocks until <code>amount</code> bytes are
+      /// available.
+      /// @param amount Target available memory
+      /// @return Amount of memory freed
+      int64_t make_room(int64_t amount);
+
+      /// Evicts the first unreferenced block of a queue.
+      /// @param queue Queue to evict from
+      /// @return Amount of memory freed (zero if all blocks are referenced)
+      int64_t evict_one(BlockCache &queue);
+
+      /// Records the key of a block evicted from #probationary.
+      void remember(int64_t key, uint32_t length);
+
+      std::mutex mutex;
+      /// Blocks referenced once (A1in)
+      BlockCache probationary;
+      /// Blocks referenced more than once (Am)
+      BlockCache protected_lru;
+      /// Keys recently evicted from #probationary (A1out)
+      GhostCache ghosts;
+      int64_t probationary_bytes {};
+      int64_t ghost_bytes {};
+      int64_t min_memory;
+      int64_t max_memory;
+      int64_t limit;
+      int64_t available;
+      uint64_t accesses {};
+      uint64_t hits {};
+    };
+
+    /// Returns shard that owns a block key.
+    Shard &shard(int64_t key) {
+      uint64_t h = (uint64_t)key * 0x9E3779B97F4A7C15ULL;
+      return *m_shards[(size_t)(h >> 32) & (m_shards.size()-1)];
+    }
+
+    std::vector<std::unique_ptr<Shard>> m_shards;
     bool         m_compressed;
   };
 
+  /// @}
+
 }
 
 #endif // Hypertable_RangeServer_FileBlockCache_h
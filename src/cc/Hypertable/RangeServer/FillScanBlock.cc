@@ -19,106 +19,171 @@
  * 02110-1301, USA.
  */
 
+
 #include "Common/Compat.h"
 #include "FillScanBlock.h"
 
+#include <Hypertable/RangeServer/ZeroCopyScanBlock.h>
+
 namespace Hypertable {
 
-  bool
-  FillScanBlock(MergeScannerRangePtr &scanner, DynamicBuffer &dbuf,
-                uint32_t *cell_count, int64_t buffer_size) {
-    Key key;
-    ByteString value;
-    size_t value_len;
-    bool more = true;
-    size_t limit = buffer_size;
-    size_t remaining = buffer_size;
-    uint8_t *ptr;
-    ScanContext *scan_context = scanner->scan_context();
-    bool keys_only = scan_context->spec->keys_only;
-    char numbuf[24];
-    DynamicBuffer counter_value;
-    bool counter;
-    String empty_value("");
-
-    assert(dbuf.base == 0);
-
-    while ((more = scanner->get(key, value))) {
-      counter = false;
-
-      if (cell_count)
-        (*cell_count)++;
-
-      if (keys_only) {
-        value.ptr = 0;
-        counter_value.clear();
-        value_len = 0;
+  namespace {
+
+    /// Writes scan results into a contiguous DynamicBuffer.
+    class DynamicBufferWriter {
+    public:
+      DynamicBufferWriter(DynamicBuffer &dbuf) : m_dbuf(dbuf) {
+        assert(dbuf.base == 0);
+      }
+      bool started() { return m_dbuf.base != 0; }
+      void start(size_t limit) {
+        m_dbuf.reserve(4 + limit);
+        // skip encoded length
+        m_dbuf.ptr = m_dbuf.base + 4;
       }
-      else {
-        counter = scan_context->cell_predicates[key.column_family_code].counter &&
-          (key.flag == FLAG_INSERT);
-
-        if (counter) {
-          const uint8_t *decode;
-          int64_t count;
-          size_t remain = value.decode_length(&decode);
-          // value must be encoded 64 bit int followed by '=' character
-          if (remain != 9)
-            HT_FATAL_OUT << "Expected counter to be encoded 64 bit int but remain=" << remain
-              << " ,key=" << key << " ,value="<< value.str() << HT_END;
-
-          count = Serialization::decode_i64(&decode, &remain);
-          HT_ASSERT(*decode == '=');
-          //convert counter to ascii
-          sprintf(numbuf, "%lld", (Lld) count);
-          value_len = strlen(numbuf);
+      void add(const uint8_t *ptr, size_t len) { m_dbuf.add_unchecked(ptr, len); }
+      void add_value(const uint8_t *ptr, size_t len) { m_dbuf.add_unchecked(ptr, len); }
+      void finish() {
+        uint8_t *ptr = m_dbuf.base;
+        Serialization::encode_i32(&ptr, m_dbuf.fill() - 4);
+      }
+    private:
+      DynamicBuffer &m_dbuf;
+    };
+
+    /// Writes scan results into a ZeroCopyScanBlock.
+    class ZeroCopyWriter {
+    public:
+      ZeroCopyWriter(ScanContext *scan_ctx, ZeroCopyScanBlock &block)
+        : m_scan_ctx(scan_ctx), m_block(block) {
+        m_scan_ctx->zero_copy_block = &m_block;
+      }
+      ~ZeroCopyWriter() { m_scan_ctx->zero_copy_block = nullptr; }
+      bool started() { return m_started; }
+      void start(size_t limit) { m_block.reserve(limit); m_started = true; }
+      void add(const uint8_t *ptr, size_t len) { m_block.add(ptr, len); }
+      void add_value(const uint8_t *ptr, size_t len) { m_block.add_value(ptr, len); }
+      void finish() { m_block.finalize(); }
+    private:
+      ScanContext *m_scan_ctx;
+      ZeroCopyScanBlock &m_block;
+      bool m_started {};
+    };
+
+    template <typename ScannerT, typename WriterT>
+    bool fill_scan_block(ScannerT *scanner, WriterT &writer,
+                         uint32_t *cell_count, int64_t buffer_size) {
+      Key key;
+      ByteString value;
+      size_t value_len;
+      bool more = true;
+      size_t limit = buffer_size;
+      size_t remaining = buffer_size;
+      ScanContext *scan_context = scanner->scan_context();
+      // Aggregate cells carry ASCII values, which are returned even with KEYS_ONLY
+      bool aggregate = scan_context->spec->aggregate != 0;
+      bool keys_only = scan_context->spec->keys_only && !aggregate;
+      char numbuf[24];
+      DynamicBuffer counter_value;
+      bool counter;
+      String empty_value("");
+
+      while ((more = scanner->get(key, value))) {
+        counter = false;
+
+        if (cell_count)
+          (*cell_count)++;
+
+        if (keys_only) {
+          value.ptr = 0;
           counter_value.clear();
-          append_as_byte_string(counter_value, numbuf, value_len);
-          value_len = counter_value.fill();
+          value_len = 0;
+        }
+        else {
+          counter = !aggregate &&
+            scan_context->cell_predicates[key.column_family_code].counter &&
+            (key.flag == FLAG_INSERT);
+
+          if (counter) {
+            const uint8_t *decode;
+            int64_t count;
+            size_t remain = value.decode_length(&decode);
+            // value must be encoded 64 bit int followed by '=' character
+            if (remain != 9)
+              HT_FATAL_OUT << "Expected counter to be encoded 64 bit int but remain=" << remain
+                << " ,key=" << key << " ,value="<< value.str() << HT_END;
+
+            count = Serialization::decode_i64(&decode, &remain);
+            HT_ASSERT(*decode == '=');
+            //convert counter to ascii
+            sprintf(numbuf, "%lld", (Lld) count);
+            value_len = strlen(numbuf);
+            counter_value.clear();
+            append_as_byte_string(counter_value, numbuf, value_len);
+            value_len = counter_value.fill();
+          }
+          else
+            value_len = value.length();
         }
-        else
-          value_len = value.length();
-      }
 
-      if (value.ptr == 0) {
-        value.ptr = (const uint8_t *)empty_value.c_str();
-        value_len = 1;
-      }
+        if (value.ptr == 0) {
+          value.ptr = (const uint8_t *)empty_value.c_str();
+          value_len = 1;
+        }
 
-      if (dbuf.base == 0) {
-        if (key.length + value_len > limit) {
-          limit = key.length + value_len;
-          remaining = limit;
+        if (!writer.started()) {
+          if (key.length + value_len > limit) {
+            limit = key.length + value_len;
+            remaining = limit;
+          }
+          writer.start(limit);
         }
-        dbuf.reserve(4 + limit);
-        // skip encoded length
-        dbuf.ptr = dbuf.base + 4;
-      }
-      if (key.length + value_len <= remaining) {
+        if (key.length + value_len <= remaining) {
 
-        dbuf.add_unchecked(key.serial.ptr, key.length);
+          writer.add(key.serial.ptr, key.length);
 
-        if (counter)
-          dbuf.add_unchecked(counter_value.base, value_len);
-        else
-          dbuf.add_unchecked(value.ptr, value_len);
+          if (counter)
+            writer.add(counter_value.base, value_len);
+          else
+            writer.add_value(value.ptr, value_len);
 
-        remaining -= (key.length + value_len);
-        scanner->forward();
+          remaining -= (key.length + value_len);
+          scanner->forward();
+        }
+        else
+          break;
       }
-      else
-        break;
-    }
 
-    if (dbuf.base == 0) {
-      dbuf.reserve(4);
-      dbuf.ptr = dbuf.base + 4;
+      if (!writer.started())
+        writer.start(0);
+
+      writer.finish();
+
+      return more;
     }
 
-    ptr = dbuf.base;
-    Serialization::encode_i32(&ptr, dbuf.fill() - 4);
+  }
 
-    return more;
+  bool
+  FillScanBlock(MergeScannerRangePtr &scanner, DynamicBuffer &dbuf,
+                uint32_t *cell_count, int64_t buffer_size) {
+    DynamicBufferWriter writer(dbuf);
+    if (scanner->aggregator())
+      return fill_scan_block(scanner->aggregator(), writer, cell_count,
+                             buffer_size);
+    return fill_scan_block(scanner.get(), writer, cell_count, buffer_size);
+  }
+
+  bool
+  FillScanBlock(MergeScannerRangePtr &scanner, ZeroCopyScanBlock &block,
+                uint32_t *cell_count, int64_t buffer_size) {
+    ZeroCopyWriter writer(scanner->scan_context(), block);
+    // Pin blocks loaded while filling previous scan blocks
+    scanner->pin_blocks(block);
+    if (scanner->aggregator())
+      return fill_scan_block(scanner->aggregator(), writer, cell_count,
+                             buffer_size);
+    return fill_scan_block(scanner.get(), writer, cell_count, buffer_size);
   }
 
 }
@@ -34,6 +34,8 @@
 
 namespace Hypertable {
 
+  class ZeroCopyScanBlock;
+
   /// @addtogroup RangeServer
   /// @{
 
@@ -43,7 +45,9 @@ namespace Hypertable {
   /// <code>buffer_size</code>.  If the KEYS_ONLY predicate is specified in the
   /// scan specification, then an empty value is encoded for each key/value
   /// pair.  For each key representing a COUNTER, the value is an encoded
-  /// 64-bit integer and is converted to an ASCII value.
+  /// 64-bit integer and is converted to an ASCII value.  If the scan
+  /// aggregates, the aggregate cells of the scanner's ScanAggregator are
+  /// returned instead.
   /// @param scanner Scanner frome which results are to be obtained
   /// @param dbuf Buffer to hold encoded results
   /// @param cell_count Address of variable to hold number of cells in the scan
@@ -54,6 +58,20 @@ namespace Hypertable {
   bool FillScanBlock(MergeScannerRangePtr &scanner, DynamicBuffer &dbuf,
                      uint32_t *cell_count, int64_t buffer_size);
 
+  /// Fills a block of scan results without copying large values.
+  /// Behaves like the DynamicBuffer version, but pins the memory referenced
+  /// by <code>scanner</code> into <code>block</code> and records values that
+  /// lie in pinned memory as references instead of copying them.
+  /// @param scanner Scanner frome which results are to be obtained
+  /// @param block Scan block to hold results
+  /// @param cell_count Address of variable to hold number of cells in the scan
+  /// block.
+  /// @param buffer_size Target size of scan block
+  /// @return <i>true</i> if there are more results to be pulled from the
+  /// scanner when this function returns, <i>false</i> otherwise.
+  bool FillScanBlock(MergeScannerRangePtr &scanner, ZeroCopyScanBlock &block,
+                     uint32_t *cell_count, int64_t buffer_size);
+
   /// @}
 
 }
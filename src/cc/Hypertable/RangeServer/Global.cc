@@ -75,6 +75,7 @@ namespace Hypertable {
   std::string            Global::toplevel_dir;
   int32_t                Global::metrics_interval = 0;
   int32_t                Global::merge_cellstore_run_length_threshold = 0;
+  int32_t                Global::compaction_partitions = 1;
   bool                   Global::ignore_clock_skew_errors = false;
   ConnectionManagerPtr   Global::conn_manager;
   std::vector<MetaLog::EntityTaskPtr>  Global::work_queue;
@@ -0,0 +1,108 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Serialization.h"
+
+#include "KeyCompressorDelta.h"
+
+#include <algorithm>
+
+using namespace Hypertable;
+
+
+void KeyCompressorDelta::reset() {
+  m_compressed_key.clear();
+  m_uncompressed_key.clear();
+  m_text = 0;
+  m_text_length = 0;
+  m_last_timestamp = 0;
+  m_last_revision = 0;
+}
+
+void KeyCompressorDelta::add(const Key &key) {
+  HT_ASSERT(key.serial.ptr);
+  const uint8_t *text = (const uint8_t *)key.row;
+  const uint8_t *text_end = key.flag_ptr + 1;
+  size_t text_length = text_end - text;
+  uint64_t timestamp_delta {}, revision_delta {};
+  size_t delta_bytes = 0;
+
+  // Timestamp and revision are compared as they are serialized
+  const uint8_t *ptr = text_end;
+  if (key.control & Key::HAVE_TIMESTAMP) {
+    uint64_t timestamp = Key::decode_ts64(&ptr, false);
+    timestamp_delta = encode_delta(timestamp, m_last_timestamp);
+    delta_bytes += Serialization::encoded_length_vi64(timestamp_delta);
+    m_last_timestamp = timestamp;
+  }
+  if (stores_revision(key.control)) {
+    uint64_t revision = Key::decode_ts64(&ptr, false);
+    revision_delta = encode_delta(revision, m_last_revision);
+    delta_bytes += Serialization::encoded_length_vi64(revision_delta);
+    m_last_revision = revision;
+  }
+  HT_ASSERT(ptr == key.serial.ptr + key.length);
+
+  uint32_t matching = 0;
+  size_t n = std::min(text_length, m_text_length);
+  while (matching < n && m_text[matching] == text[matching])
+    matching++;
+
+  size_t suffix_length = text_length - matching;
+  uint32_t total_bytes = 1 + Serialization::encoded_length_vi32(matching) +
+    delta_bytes + suffix_length;
+
+  m_compressed_key.clear();
+  m_compressed_key.ensure(5 + total_bytes);
+  Serialization::encode_vi32(&m_compressed_key.ptr, total_bytes);
+  *m_compressed_key.ptr++ = key.control;
+  Serialization::encode_vi32(&m_compressed_key.ptr, matching);
+  if (key.control & Key::HAVE_TIMESTAMP)
+    Serialization::encode_vi64(&m_compressed_key.ptr, timestamp_delta);
+  if (stores_revision(key.control))
+    Serialization::encode_vi64(&m_compressed_key.ptr, revision_delta);
+  m_compressed_key.add_unchecked(text + matching, suffix_length);
+
+  // Keep a copy of the key, which holds the text the next key is matched
+  // against
+  m_uncompressed_key.clear();
+  m_uncompressed_key.ensure(key.length);
+  m_uncompressed_key.add_unchecked(key.serial.ptr, key.length);
+  m_text = m_uncompressed_key.base + (text - key.serial.ptr);
+  m_text_length = text_length;
+}
+
+size_t KeyCompressorDelta::length() {
+  return m_compressed_key.fill();
+}
+
+size_t KeyCompressorDelta::length_uncompressed() {
+  return m_uncompressed_key.fill();
+}
+
+void KeyCompressorDelta::write(uint8_t *buf) {
+  memcpy(buf, m_compressed_key.base, m_compressed_key.fill());
+}
+
+void KeyCompressorDelta::write_uncompressed(uint8_t *buf) {
+  memcpy(buf, m_uncompressed_key.base, m_uncompressed_key.fill());
+}
@@ -0,0 +1,85 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef Hypertable_RangeServer_KeyCompressorDelta_h
+#define Hypertable_RangeServer_KeyCompressorDelta_h
+
+#include "KeyCompressor.h"
+
+namespace Hypertable {
+
+  /// Key compressor for KeyCompressionType::DELTA.
+  /// The row, column family, qualifier and flag are prefix coded against the
+  /// previous key in the block, as with KeyCompressorPrefix.  The timestamp
+  /// and revision, which KeyCompressorPrefix stores as eight bytes each, are
+  /// stored as zigzag varint deltas from the timestamp and revision of the
+  /// previous key that has one, so the keys of time series data, which
+  /// differ little in timestamp and revision, shrink to a byte or two per
+  /// field.  A compressed key has the following format:
+  /// <pre>
+  ///   vi32   length of remainder of key
+  ///   byte   control
+  ///   vi32   number of leading bytes shared with previous key
+  ///   vi64   zigzag timestamp delta (if control has HAVE_TIMESTAMP)
+  ///   vi64   zigzag revision delta (if stored separately from timestamp)
+  ///   bytes  remainder of row, column family, qualifier and flag
+  /// </pre>
+  class KeyCompressorDelta : public KeyCompressor {
+  public:
+    virtual void reset();
+    virtual void add(const Key &key);
+    virtual size_t length();
+    virtual size_t length_uncompressed();
+    virtual void write(uint8_t *buf);
+    virtual void write_uncompressed(uint8_t *buf);
+
+    /// Checks if a serialized key stores a revision after its timestamp.
+    /// @param control Key control byte
+    /// @return <i>true</i> if the key stores a revision
+    static bool stores_revision(uint8_t control) {
+      if ((control & Key::HAVE_TIMESTAMP) && (control & Key::REV_IS_TS))
+        return false;
+      return (control & Key::HAVE_REVISION) != 0;
+    }
+
+    /// Zigzag encodes the difference between two values.
+    static uint64_t encode_delta(uint64_t value, uint64_t last) {
+      int64_t delta = (int64_t)(value - last);
+      return ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+    }
+
+    /// Decodes a zigzag encoded difference.
+    static uint64_t decode_delta(uint64_t delta, uint64_t last) {
+      return last + ((delta >> 1) ^ (0 - (delta & 1)));
+    }
+
+  private:
+    DynamicBuffer m_compressed_key;
+    DynamicBuffer m_uncompressed_key;
+    const uint8_t *m_text {};
+    size_t m_text_length {};
+    uint64_t m_last_timestamp {};
+    uint64_t m_last_revision {};
+  };
+
+}
+
+#endif // Hypertable_RangeServer_KeyCompressorDelta_h
@@ -0,0 +1,112 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Serialization.h"
+
+#include "KeyCompressorDelta.h"
+#include "KeyDecompressorDelta.h"
+
+#include <cstring>
+
+using namespace Hypertable;
+
+
+namespace {
+  /// Space reserved ahead of the control byte for the key length
+  const size_t LENGTH_RESERVE = 5;
+}
+
+
+void KeyDecompressorDelta::reset() {
+  m_bufs[0].clear();
+  m_bufs[1].clear();
+  m_current_text = 0;
+  m_current_text_length = 0;
+  m_last_timestamp = 0;
+  m_last_revision = 0;
+  m_serialized_key.ptr = 0;
+  m_first = false;
+}
+
+const uint8_t *KeyDecompressorDelta::add(const uint8_t *next_base) {
+  int next = m_first ? 1 : 0;
+  const uint8_t *next_ptr;
+  SerializedKey serkey(next_base);
+  size_t remaining = serkey.decode_length(&next_ptr);
+  uint8_t control = *next_ptr++;
+  remaining--;
+  uint32_t matching = Serialization::decode_vi32(&next_ptr, &remaining);
+  size_t field_bytes = 0;
+
+  if (control & Key::HAVE_TIMESTAMP) {
+    m_last_timestamp = KeyCompressorDelta::decode_delta(
+        Serialization::decode_vi64(&next_ptr, &remaining), m_last_timestamp);
+    field_bytes += 8;
+  }
+  if (KeyCompressorDelta::stores_revision(control)) {
+    m_last_revision = KeyCompressorDelta::decode_delta(
+        Serialization::decode_vi64(&next_ptr, &remaining), m_last_revision);
+    field_bytes += 8;
+  }
+
+  HT_ASSERT(matching <= m_current_text_length);
+
+  // Text prefix comes from the current key, which lives in the other buffer
+  DynamicBuffer &buf = m_bufs[next];
+  size_t text_length = matching + remaining;
+  size_t needed = LENGTH_RESERVE + 1 + text_length + field_bytes;
+  if (needed > buf.size)
+    buf.grow(needed);
+  uint8_t *base = buf.base + LENGTH_RESERVE + 1;
+  if (matching)
+    memcpy(base, m_current_text, matching);
+  memcpy(base + matching, next_ptr, remaining);
+  buf.ptr = base + text_length;
+  if (control & Key::HAVE_TIMESTAMP)
+    Key::encode_ts64(&buf.ptr, m_last_timestamp, false);
+  if (KeyCompressorDelta::stores_revision(control))
+    Key::encode_ts64(&buf.ptr, m_last_revision, false);
+
+  // Write length and control byte immediately ahead of the key data
+  uint8_t length_buf[LENGTH_RESERVE];
+  uint8_t *length_ptr = length_buf;
+  Serialization::encode_vi32(&length_ptr, 1 + text_length + field_bytes);
+  size_t length_len = length_ptr - length_buf;
+  base[-1] = control;
+  memcpy(base - 1 - length_len, length_buf, length_len);
+
+  m_serialized_key.ptr = base - 1 - length_len;
+  m_current_text = base;
+  m_current_text_length = text_length;
+  m_first = !m_first;
+  return next_ptr + remaining;
+}
+
+
+bool KeyDecompressorDelta::less_than(SerializedKey serialized_key) {
+  return m_serialized_key < serialized_key;
+}
+
+
+void KeyDecompressorDelta::load(Key &key) {
+  key.load(m_serialized_key);
+}
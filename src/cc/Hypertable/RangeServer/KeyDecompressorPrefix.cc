@@ -24,19 +24,29 @@
 
 #include "KeyDecompressorPrefix.h"
 
+#include <algorithm>
+#include <cstring>
+
 using namespace Hypertable;
 
 
+namespace {
+  /// Space reserved ahead of the control byte for the key length
+  const size_t LENGTH_RESERVE = 5;
+}
+
+
 void KeyDecompressorPrefix::reset() {
   m_bufs[0].clear();
   m_bufs[1].clear();
   m_current_base = 0;
+  m_current_length = 0;
+  m_last_matching = 0;
   m_serialized_key.ptr = 0;
   m_first = false;
 }
 
 const uint8_t *KeyDecompressorPrefix::add(const uint8_t *next_base) {
-  int current = m_first ? 0 : 1;
   int next = m_first ? 1 : 0;
   const uint8_t *next_ptr;
   SerializedKey serkey(next_base);
@@ -45,18 +55,34 @@ const uint8_t *KeyDecompressorPrefix::add(const uint8_t *next_base) {
   size_t remaining = next_length - 1;
   uint32_t matching = Serialization::decode_vi32(&next_ptr, &remaining);
 
-  HT_ASSERT(matching <= m_bufs[current].fill());
-  m_bufs[next].clear();
-  m_bufs[next].ensure(8+matching+remaining);
-
-  Serialization::encode_vi32(&m_bufs[next].ptr, 1+matching+remaining);
-  *(m_bufs[next].ptr)++ = control;
-  if (matching)
-    memcpy(m_bufs[next].ptr, m_current_base, matching);
-  m_current_base = m_bufs[next].ptr;
-  m_bufs[next].ptr += matching;
-  m_bufs[next].add_unchecked(next_ptr, remaining);
-  m_serialized_key.ptr = m_bufs[next].base;
+  HT_ASSERT(matching <= m_current_length);
+
+  // The buffer being reused holds the key before the current one, which
+  // shares the first m_last_matching bytes with the current key, so only the
+  // rest of the prefix has to be copied
+  DynamicBuffer &buf = m_bufs[next];
+  size_t needed = LENGTH_RESERVE + 1 + matching + remaining;
+  if (needed > buf.size)
+    buf.grow(needed);
+  uint8_t *base = buf.base + LENGTH_RESERVE + 1;
+  size_t valid = std::min(m_last_matching, (size_t)matching);
+  if (matching > valid)
+    memcpy(base + valid, m_current_base + valid, matching - valid);
+  memcpy(base + matching, next_ptr, remaining);
+  buf.ptr = base + matching + remaining;
+
+  // Write length and control byte immediately ahead of the key data
+  uint8_t length_buf[LENGTH_RESERVE];
+  uint8_t *length_ptr = length_buf;
+  Serialization::encode_vi32(&length_ptr, 1+matching+remaining);
+  size_t length_len = length_ptr - length_buf;
+  base[-1] = control;
+  memcpy(base - 1 - length_len, length_buf, length_len);
+
+  m_serialized_key.ptr = base - 1 - length_len;
+  m_current_base = base;
+  m_current_length = matching + remaining;
+  m_last_matching = matching;
   m_first = !m_first;
   return next_ptr + remaining;
 }
@@ -35,8 +35,10 @@ namespace Hypertable {
   private:
     SerializedKey m_serialized_key;
     DynamicBuffer m_bufs[2];
-    const uint8_t *m_current_base;
-    bool m_first;
+    const uint8_t *m_current_base {};
+    size_t m_current_length {};
+    size_t m_last_matching {};
+    bool m_first {};
   };
 
 }
@@ -387,6 +387,12 @@ int64_t MergeScannerAccessGroup::get_disk_read() {
 }
 
 
+void MergeScannerAccessGroup::pin_blocks(ZeroCopyScanBlock &block) {
+  for (auto &scanner : m_scanners)
+    scanner->pin_blocks(block);
+}
+
+
 void MergeScannerAccessGroup::initialize() {
   ScannerState sstate;
 
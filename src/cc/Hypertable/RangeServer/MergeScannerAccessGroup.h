@@ -99,7 +99,7 @@ namespace Hypertable {
 
     struct LtScannerState {
       bool operator()(const ScannerState &ss1, const ScannerState &ss2) const {
-        return ss1.key.serial > ss2.key.serial;
+        return ss1.key.compare_serial(ss2.key) > 0;
       }
     };
 
@@ -155,6 +155,10 @@ namespace Hypertable {
     void add_disk_read(int64_t amount) { m_disk_read += amount; }
     int64_t get_disk_read();
 
+    /// Pins memory referenced by the scanners in #m_scanners.
+    /// @param block Scan block to pin memory into
+    void pin_blocks(ZeroCopyScanBlock &block);
+
   private:
 
     void initialize();
@@ -48,6 +48,9 @@ MergeScannerRange::MergeScannerRange(const string &table_id, ScanContextPtr &sca
     m_row_offset = scan_ctx->spec->row_offset;
     m_cell_offset = scan_ctx->spec->cell_offset;
 
+    if (scan_ctx->spec->aggregate)
+      m_aggregator = make_unique<ScanAggregator>(scan_ctx.get(), this);
+
     if (scan_ctx->spec->rebuild_indices) {
       bool has_index = false;
       bool has_qualifier_index = false;
@@ -337,3 +340,8 @@ int64_t MergeScannerRange::get_disk_read() {
     amount += (int64_t)scanner->get_disk_read();
   return amount;
 }
+
+void MergeScannerRange::pin_blocks(ZeroCopyScanBlock &block) {
+  for (auto scanner : m_scanners)
+    scanner->pin_blocks(block);
+}
@@ -29,6 +29,7 @@
 
 #include <Hypertable/RangeServer/MergeScannerAccessGroup.h>
 #include <Hypertable/RangeServer/IndexUpdater.h>
+#include <Hypertable/RangeServer/ScanAggregator.h>
 
 #include <Common/ByteString.h>
 #include <Common/DynamicBuffer.h>
@@ -90,8 +91,20 @@ namespace Hypertable {
 
     int64_t get_disk_read();
 
+    /// Pins memory referenced by the current results of all scanners.
+    /// Calls MergeScannerAccessGroup::pin_blocks() on each scanner in
+    /// #m_scanners.
+    /// @param block Scan block to pin memory into
+    void pin_blocks(ZeroCopyScanBlock &block);
+
     ScanContext *scan_context() { return m_scan_context.get(); }
 
+    /// Returns aggregator for an aggregate scan.
+    /// The aggregator pulls cells from this scanner and returns the aggregate
+    /// cells in their place.
+    /// @return Aggregator, or nullptr if the scan does not aggregate
+    ScanAggregator *aggregator() { return m_aggregator.get(); }
+
   private:
 
     void initialize();
@@ -104,7 +117,7 @@ namespace Hypertable {
 
     struct LtScannerState {
       bool operator()(const ScannerState &ss1, const ScannerState &ss2) const {
-        return ss1.key.serial > ss2.key.serial;
+        return ss1.key.compare_serial(ss2.key) > 0;
       }
     };
 
@@ -118,6 +131,9 @@ namespace Hypertable {
     /// Index updater for <i>rebuild indices</i> scan
     IndexUpdaterPtr m_index_updater;
 
+    /// Aggregator for an aggregate scan
+    std::unique_ptr<ScanAggregator> m_aggregator;
+
     /// Flag indicating scan is finished
     bool m_done {};
 
@@ -27,6 +27,7 @@
 
 #include "RangeServer.h"
 
+#include <Hypertable/RangeServer/CommitLogReplayer.h>
 #include <Hypertable/RangeServer/FillScanBlock.h>
 #include <Hypertable/RangeServer/Global.h>
 #include <Hypertable/RangeServer/GroupCommit.h>
@@ -59,6 +60,7 @@
 #include <Hypertable/Lib/RangeServerRecovery/ReceiverPlan.h>
 
 #include <FsBroker/Lib/Client.h>
+#include <FsBroker/Lib/ShortCircuitClient.h>
 
 #include <Common/FailureInducer.h>
 #include <Common/FileUtils.h>
@@ -66,6 +68,7 @@
 #include <Common/ScopeGuard.h>
 #include <Common/Status.h>
 #include <Common/StatusPersister.h>
+#include <Common/Stopwatch.h>
 #include <Common/StringExt.h>
 #include <Common/SystemInfo.h>
 #include <Common/md5.h>
@@ -145,6 +148,13 @@ Apps::RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_
   Global::cellstore_target_size_max = cfg.get_i64("CellStore.TargetSize.Maximum");
   Global::pseudo_tables = PseudoTables::instance();
   m_scanner_buffer_size = cfg.get_i64("Scanner.BufferSize");
+  m_zero_copy_min_value_size = cfg.get_i32("Scanner.ZeroCopy.MinValueSize");
+  m_multi_get_max_response_size = cfg.get_i64("MultiGet.MaxResponseSize");
+  if (cfg.get_i64("Scanner.Sharing.MaxMemory") > 0) {
+    m_shared_scan_map =
+      make_shared<SharedScanMap>(cfg.get_i64("Scanner.Sharing.MaxMemory"));
+    m_shared_scan_max_memory = cfg.get_i64("Scanner.Sharing.ScanMaxMemory");
+  }
   port = cfg.get_i16("Port");
 
   m_control_file_check_interval = cfg.get_i32("ControlFile.CheckInterval");
@@ -176,6 +186,7 @@ Apps::RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_
   Global::toplevel_dir = String("/") + Global::toplevel_dir;
 
   Global::merge_cellstore_run_length_threshold = cfg.get_i32("CellStore.Merge.RunLengthThreshold");
+  Global::compaction_partitions = cfg.get_i32("Maintenance.Compaction.Partitions");
   Global::ignore_clock_skew_errors = cfg.get_bool("IgnoreClockSkewErrors");
 
   int64_t interval = (int64_t)cfg.get_i32("Maintenance.Interval");
@@ -243,7 +254,8 @@ Apps::RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_
 
   if (block_cache_max > 0)
     Global::block_cache = new FileBlockCache(block_cache_min, block_cache_max,
-                        cfg.get_bool("BlockCache.Compressed"));
+                        cfg.get_bool("BlockCache.Compressed"),
+                        (size_t)std::max(1, cfg.get_i32("BlockCache.Shards")));
 
   int64_t query_cache_memory = cfg.get_i64("QueryCache.MaxMemory");
   if (query_cache_memory > 0) {
@@ -258,7 +270,11 @@ Apps::RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_
 
   Global::memory_tracker = new MemoryTracker(Global::block_cache, m_query_cache);
 
-  FsBroker::Lib::ClientPtr dfsclient = std::make_shared<FsBroker::Lib::Client>(conn_mgr, props);
+  FsBroker::Lib::ClientPtr dfsclient;
+  if (props->get_bool("FsBroker.ShortCircuit"))
+    dfsclient = std::make_shared<FsBroker::Lib::ShortCircuitClient>(conn_mgr, props);
+  else
+    dfsclient = std::make_shared<FsBroker::Lib::Client>(conn_mgr, props);
 
   int dfs_timeout;
   if (props->has("FsBroker.Timeout"))
@@ -1051,6 +1067,21 @@ Apps::RangeServer::replay_load_range(TableInfoMap &replay_map,
 
 void Apps::RangeServer::replay_log(TableInfoMap &replay_map,
                              CommitLogReaderPtr &log_reader) {
+  int32_t add_threads =
+    m_props->get_i32("Hypertable.RangeServer.CommitLog.Replay.Threads");
+
+  if (add_threads > 0) {
+    int32_t inflate_threads =
+      m_props->get_i32("Hypertable.RangeServer.CommitLog.Replay.InflateThreads");
+    CommitLogReplayer replayer(std::max(inflate_threads, 1), add_threads,
+                               [this](const uint8_t **bufp, size_t *remainp,
+                                      TableIdentifier *tid) {
+                                 decode_table_id(bufp, remainp, tid);
+                               });
+    replayer.replay(replay_map, log_reader.get());
+    return;
+  }
+
   BlockHeaderCommitLog header;
   TableIdentifier table_id;
   TableInfoPtr table_info;
@@ -1062,6 +1093,7 @@ void Apps::RangeServer::replay_log(TableInfoMap &replay_map,
   unsigned long block_count = 0;
   uint8_t *base;
   size_t len;
+  Stopwatch stopwatch;
 
   while (log_reader->next((const uint8_t **)&base, &len, &header)) {
 
@@ -1123,8 +1155,8 @@ void Apps::RangeServer::replay_log(TableInfoMap &replay_map,
     block_count++;
   }
 
-  HT_INFOF("Replayed %lu blocks of updates from '%s'", block_count,
-           log_reader->get_log_dir().c_str());
+  HT_INFOF("Replayed %lu blocks of updates from '%s' in %.3fs", block_count,
+           log_reader->get_log_dir().c_str(), stopwatch.elapsed());
 }
 
 void
@@ -1515,26 +1547,79 @@ Apps::RangeServer::create_scanner(Response::Callback::CreateScanner *cb,
       }
     }
     std::set<uint8_t> columns;
-    scan_ctx = make_shared<ScanContext>(range->get_scan_revision(cb->event()->header.timeout_ms),
-                               &scan_spec, &range_spec, schema, &columns);
-    scan_ctx->timeout_ms = cb->event()->header.timeout_ms;
-
-    range->create_scanner(scan_ctx, scanner);
+    int64_t scan_revision =
+      range->get_scan_revision(cb->event()->header.timeout_ms);
+    String shared_scan_key;
+    SharedScanCursorPtr cursor;
+
+    // Join an identical scan of this range that is already in progress
+    if (m_shared_scan_map && !table.is_system() &&
+        !(cache_key && m_query_cache)) {
+      shared_scan_key = SharedScanMap::key(table, range_spec, scan_revision,
+                                           scan_spec);
+      cursor = m_shared_scan_map->join(shared_scan_key);
+    }
+
+    if (!cursor) {
+      scan_ctx = make_shared<ScanContext>(scan_revision, &scan_spec,
+                                          &range_spec, schema, &columns);
+      scan_ctx->timeout_ms = cb->event()->header.timeout_ms;
+
+      range->create_scanner(scan_ctx, scanner);
+
+      // Offer the scan to identical scanners, once its specs no longer
+      // reference this request.  If it can't be offered, it runs unshared.
+      if (!shared_scan_key.empty()) {
+        scan_ctx->deep_copy_specs();
+        SharedScanPtr shared_scan =
+          make_shared<SharedScan>(scanner, m_scanner_buffer_size,
+                                  m_shared_scan_max_memory);
+        cursor = shared_scan->attach();
+        if (m_shared_scan_map->insert(shared_scan_key, shared_scan))
+          scanner.reset();
+        else
+          cursor.reset();
+      }
+    }
 
     range->decrement_scan_counter();
     decrement_needed = false;
 
     uint32_t cell_count {};
+    ZeroCopyScanBlockPtr zero_copy_block;
+    SharedScan::Block shared_block;
+    int64_t output_cells {};
+    int32_t skipped_rows {}, skipped_cells {};
+
+    if (cursor) {
+      cursor->fetch(shared_block, profile_data);
+      more = shared_block.more;
+      cell_count = shared_block.cell_count;
+      output_cells = profile_data.cells_returned;
+      cursor->scan()->get_skipped(&skipped_rows, &skipped_cells);
+    }
+    else {
+      // Results that may go into the query cache need a contiguous buffer
+      if (m_zero_copy_min_value_size > 0 &&
+          !(cache_key && m_query_cache && !table.is_metadata())) {
+        zero_copy_block =
+          make_shared<ZeroCopyScanBlock>(m_zero_copy_min_value_size);
+        more = FillScanBlock(scanner, *zero_copy_block, &cell_count,
+                             m_scanner_buffer_size);
+      }
+      else
+        more = FillScanBlock(scanner, rbuf, &cell_count, m_scanner_buffer_size);
 
-    more = FillScanBlock(scanner, rbuf, &cell_count, m_scanner_buffer_size);
+      profile_data.cells_scanned = scanner->get_input_cells();
+      profile_data.cells_returned = scanner->get_output_cells();
+      profile_data.bytes_scanned = scanner->get_input_bytes();
+      profile_data.bytes_returned = scanner->get_output_bytes();
+      profile_data.disk_read = scanner->get_disk_read();
 
-    profile_data.cells_scanned = scanner->get_input_cells();
-    profile_data.cells_returned = scanner->get_output_cells();
-    profile_data.bytes_scanned = scanner->get_input_bytes();
-    profile_data.bytes_returned = scanner->get_output_bytes();
-    profile_data.disk_read = scanner->get_disk_read();
-
-    int64_t output_cells = scanner->get_output_cells();
+      output_cells = scanner->get_output_cells();
+      skipped_rows = scanner->get_skipped_rows();
+      skipped_cells = scanner->get_skipped_cells();
+    }
 
     {
       lock_guard<LoadStatistics> lock(*Global::load_statistics);
@@ -1550,16 +1635,20 @@ Apps::RangeServer::create_scanner(Response::Callback::CreateScanner *cb,
                            profile_data.disk_read);
     }
 
-    int skipped_rows = scanner->get_skipped_rows();
-    int skipped_cells = scanner->get_skipped_cells();
-
     if (more) {
-      scan_ctx->deep_copy_specs();
-      id = m_scanner_map.put(scanner, range, table, profile_data);
+      if (cursor)
+        id = m_scanner_map.put(cursor, range, table, profile_data);
+      else {
+        // Specs of scans offered for sharing have already been copied
+        if (shared_scan_key.empty())
+          scan_ctx->deep_copy_specs();
+        id = m_scanner_map.put(scanner, range, table, profile_data);
+      }
     }
     else {
       id = 0;
       scanner.reset();
+      cursor.reset();
     }
 
     //HT_INFOF("scanner=%d cell_count=%d %s", (int)id, (int)cell_count, profile_data.to_string().c_str());
@@ -1572,7 +1661,14 @@ Apps::RangeServer::create_scanner(Response::Callback::CreateScanner *cb,
     /**
      *  Send back data
      */
-    if (cache_key && m_query_cache && !table.is_metadata() && !more) {
+    if (shared_block.data) {
+      if ((error = cb->response(id, skipped_rows, skipped_cells, more,
+                                profile_data, shared_block.data,
+                                shared_block.length)) != Error::OK) {
+        HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
+      }
+    }
+    else if (cache_key && m_query_cache && !table.is_metadata() && !more) {
       const char *cache_row_key = scan_spec.cache_key();
       char *row_key_ptr, *tablename_ptr;
       uint8_t *buffer = new uint8_t [ rbuf.fill() + strlen(cache_row_key) + strlen(table.id) + 2 ];
@@ -1589,6 +1685,12 @@ Apps::RangeServer::create_scanner(Response::Callback::CreateScanner *cb,
         HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
       }
     }
+    else if (zero_copy_block) {
+      if ((error = cb->response(id, skipped_rows, skipped_cells, more,
+                                profile_data, zero_copy_block)) != Error::OK) {
+        HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
+      }
+    }
     else {
       StaticBuffer ext(rbuf);
       if ((error = cb->response(id, skipped_rows, skipped_cells, more,
@@ -1612,6 +1714,182 @@ Apps::RangeServer::create_scanner(Response::Callback::CreateScanner *cb,
   }
 }
 
+/// @details
+/// Fetches the cells of a sorted batch of rows from a single range in one
+/// request.  The batch is read with a single <i>scan and filter rows</i>
+/// scan whose row set holds every row, so cell store scanners seek from one
+/// row's index block to the next and skip the blocks in between, and a
+/// batch of a single row is checked against the cell store bloom filters.
+/// The cells of every row are returned in one scan block with a scanner ID
+/// of zero, so no scanner state is kept between requests.  Since a batch
+/// holds an arbitrary subset of the requested rows, row and cell limits and
+/// offsets are rejected.  If a row does not lie within the range (e.g. the
+/// range has split), the request fails with RANGESERVER_RANGE_NOT_FOUND so
+/// that the client relocates the batch.
+void
+Apps::RangeServer::multi_get(Response::Callback::CreateScanner *cb,
+        const TableIdentifier &table, const RangeSpec &range_spec,
+        const ScanSpec &scan_spec, const std::vector<const char *> &rows) {
+  int error = Error::OK;
+  TableInfoPtr table_info;
+  RangePtr range;
+  SchemaPtr schema;
+  ProfileDataScanner profile_data;
+  bool decrement_needed=false;
+
+  if (!m_log_replay_barrier->wait(cb->event()->deadline(), table, range_spec))
+    return;
+
+  try {
+    DynamicBuffer rbuf;
+    int skipped_rows {};
+    int skipped_cells {};
+
+    if (!scan_spec.row_intervals.empty() || !scan_spec.cell_intervals.empty())
+      HT_THROW(Error::RANGESERVER_BAD_SCAN_SPEC,
+               "multi get does not accept row or cell intervals");
+
+    if (scan_spec.row_limit || scan_spec.cell_limit || scan_spec.row_offset ||
+        scan_spec.cell_offset)
+      HT_THROW(Error::RANGESERVER_BAD_SCAN_SPEC,
+               "multi get does not accept row or cell limits or offsets");
+
+    if (!m_context->live_map->lookup(table.id, table_info))
+      HT_THROW(Error::TABLE_NOT_FOUND, table.id);
+
+    if (!table_info->get_range(range_spec, range))
+      HT_THROWF(Error::RANGESERVER_RANGE_NOT_FOUND, "(a) %s[%s..%s]",
+                table.id, range_spec.start_row, range_spec.end_row);
+
+    schema = table_info->get_schema();
+
+    // verify schema
+    if (schema->get_generation() != table.generation) {
+      HT_THROWF(Error::RANGESERVER_GENERATION_MISMATCH,
+                "RangeServer Schema generation for table '%s'"
+                " is %lld but supplied is %lld",
+                table.id, (Lld)schema->get_generation(),
+                (Lld)table.generation);
+    }
+
+    range->deferred_initialization(cb->event()->header.timeout_ms);
+
+    if (!range->increment_scan_counter())
+      HT_THROWF(Error::RANGESERVER_RANGE_NOT_FOUND,
+                "Range %s[%s..%s] dropped or relinquished",
+                table.id, range_spec.start_row, range_spec.end_row);
+
+    decrement_needed = true;
+
+    String start_row, end_row;
+    range->get_boundary_rows(start_row, end_row);
+
+    // Check to see if range just shrunk
+    if (strcmp(start_row.c_str(), range_spec.start_row) ||
+        strcmp(end_row.c_str(), range_spec.end_row))
+      HT_THROWF(Error::RANGESERVER_RANGE_NOT_FOUND, "(b) %s[%s..%s]",
+                table.id, range_spec.start_row, range_spec.end_row);
+
+    if (rows.empty())
+      HT_THROW(Error::RANGESERVER_BAD_SCAN_SPEC, "multi get without rows");
+
+    const char *last_row {};
+    for (auto row : rows) {
+      // The row set of the scan context relies on sorted, unique rows
+      if (last_row && strcmp(last_row, row) >= 0)
+        HT_THROWF(Error::RANGESERVER_BAD_SCAN_SPEC, "multi get rows not "
+                  "sorted and unique ('%s' follows '%s')", row, last_row);
+      last_row = row;
+      if (strcmp(row, start_row.c_str()) <= 0 ||
+          strcmp(row, end_row.c_str()) > 0)
+        HT_THROWF(Error::RANGESERVER_RANGE_NOT_FOUND,
+                  "(c) row '%s' not in %s[%s..%s]", row, table.id,
+                  range_spec.start_row, range_spec.end_row);
+    }
+
+    // Leave room for the encoded length of the block
+    rbuf.reserve(4 + m_scanner_buffer_size);
+    rbuf.ptr = rbuf.base + 4;
+
+    ScanSpec rows_spec;
+    scan_spec.base_copy(rows_spec);
+    rows_spec.scan_and_filter_rows = true;
+    rows_spec.row_intervals.reserve(rows.size());
+    for (auto row : rows)
+      rows_spec.row_intervals.push_back(RowInterval(row, true, row, true));
+
+    int64_t revision = range->get_scan_revision(cb->event()->header.timeout_ms);
+    std::set<uint8_t> columns;
+    ScanContextPtr scan_ctx;
+    MergeScannerRangePtr scanner;
+    bool more = true;
+
+    scan_ctx = make_shared<ScanContext>(revision, &rows_spec, &range_spec,
+                                        schema, &columns);
+    scan_ctx->timeout_ms = cb->event()->header.timeout_ms;
+
+    range->create_scanner(scan_ctx, scanner);
+
+    while (more) {
+      DynamicBuffer block;
+      more = FillScanBlock(scanner, block, 0, m_scanner_buffer_size);
+      rbuf.add(block.base + 4, block.fill() - 4);
+      if ((int64_t)rbuf.fill() - 4 > m_multi_get_max_response_size)
+        HT_THROWF(Error::RANGESERVER_RESPONSE_TOO_LARGE, "multi get of %d "
+                  "rows exceeds %lld bytes", (int)rows.size(),
+                  (Lld)m_multi_get_max_response_size);
+    }
+
+    profile_data.cells_scanned = scanner->get_input_cells();
+    profile_data.cells_returned = scanner->get_output_cells();
+    profile_data.bytes_scanned = scanner->get_input_bytes();
+    profile_data.bytes_returned = scanner->get_output_bytes();
+    profile_data.disk_read = scanner->get_disk_read();
+    skipped_rows = scanner->get_skipped_rows();
+    skipped_cells = scanner->get_skipped_cells();
+
+    range->decrement_scan_counter();
+    decrement_needed = false;
+
+    {
+      uint8_t *ptr = rbuf.base;
+      Serialization::encode_i32(&ptr, rbuf.fill() - 4);
+    }
+
+    {
+      lock_guard<LoadStatistics> lock(*Global::load_statistics);
+      Global::load_statistics->add_scan_data(1,
+                                             profile_data.cells_scanned,
+                                             profile_data.cells_returned,
+                                             profile_data.bytes_scanned,
+                                             profile_data.bytes_returned);
+      range->add_read_data(profile_data.cells_scanned,
+                           profile_data.cells_returned,
+                           profile_data.bytes_scanned,
+                           profile_data.bytes_returned,
+                           profile_data.disk_read);
+    }
+
+    StaticBuffer ext(rbuf);
+    if ((error = cb->response(0, skipped_rows, skipped_cells, false,
+                              profile_data, ext)) != Error::OK)
+      HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
+  }
+  catch (Hypertable::Exception &e) {
+    int error;
+    if (decrement_needed)
+      range->decrement_scan_counter();
+    if (e.code() == Error::RANGESERVER_RANGE_NOT_FOUND ||
+        e.code() == Error::RANGESERVER_GENERATION_MISMATCH ||
+        e.code() == Error::RANGESERVER_RESPONSE_TOO_LARGE)
+      HT_INFOF("%s - %s", Error::get_text(e.code()), e.what());
+    else
+      HT_ERROR_OUT << e << HT_END;
+    if ((error = cb->error(e.code(), e.what())) != Error::OK)
+      HT_ERRORF("Problem sending error response - %s", Error::get_text(error));
+  }
+}
+
 void
 Apps::RangeServer::destroy_scanner(ResponseCallback *cb, int32_t scanner_id) {
   HT_DEBUGF("destroying scanner id=%u", scanner_id);
@@ -1625,6 +1903,7 @@ Apps::RangeServer::fetch_scanblock(Response::Callback::CreateScanner *cb,
   String errmsg;
   int error = Error::OK;
   MergeScannerRangePtr scanner;
+  SharedScanCursorPtr cursor;
   RangePtr range;
   bool more = true;
   DynamicBuffer rbuf;
@@ -1638,7 +1917,8 @@ Apps::RangeServer::fetch_scanblock(Response::Callback::CreateScanner *cb,
 
   try {
 
-    if (!m_scanner_map.get(scanner_id, scanner, range, scanner_table, &profile_data_before))
+    if (!m_scanner_map.get(scanner_id, scanner, cursor, range, scanner_table,
+                           &profile_data_before))
       HT_THROW(Error::RANGESERVER_INVALID_SCANNER_ID,
                format("scanner ID %d", scanner_id));
 
@@ -1659,25 +1939,53 @@ Apps::RangeServer::fetch_scanblock(Response::Callback::CreateScanner *cb,
     }
 
     uint32_t cell_count {};
+    ZeroCopyScanBlockPtr zero_copy_block;
+    SharedScan::Block shared_block;
+    int64_t output_cells {};
 
-    more = FillScanBlock(scanner, rbuf, &cell_count, m_scanner_buffer_size);
+    if (cursor) {
+      // Shared scans report the profile data of this block only
+      cursor->fetch(shared_block, profile_data);
+      more = shared_block.more;
+      cell_count = shared_block.cell_count;
+      output_cells = profile_data.cells_returned;
 
-    profile_data.cells_scanned = scanner->get_input_cells();
-    profile_data.cells_returned = scanner->get_output_cells();
-    profile_data.bytes_scanned = scanner->get_input_bytes();
-    profile_data.bytes_returned = scanner->get_output_bytes();
-    profile_data.disk_read = scanner->get_disk_read();
+      if (!more) {
+        m_scanner_map.remove(scanner_id);
+        cursor.reset();
+      }
+      else {
+        profile_data_before += profile_data;
+        m_scanner_map.update_profile_data(scanner_id, profile_data_before);
+      }
+    }
+    else {
+      if (m_zero_copy_min_value_size > 0) {
+        zero_copy_block =
+          make_shared<ZeroCopyScanBlock>(m_zero_copy_min_value_size);
+        more = FillScanBlock(scanner, *zero_copy_block, &cell_count,
+                             m_scanner_buffer_size);
+      }
+      else
+        more = FillScanBlock(scanner, rbuf, &cell_count, m_scanner_buffer_size);
 
-    int64_t output_cells = scanner->get_output_cells();
+      profile_data.cells_scanned = scanner->get_input_cells();
+      profile_data.cells_returned = scanner->get_output_cells();
+      profile_data.bytes_scanned = scanner->get_input_bytes();
+      profile_data.bytes_returned = scanner->get_output_bytes();
+      profile_data.disk_read = scanner->get_disk_read();
 
-    if (!more) {
-      m_scanner_map.remove(scanner_id);
-      scanner.reset();
-    }
-    else
-      m_scanner_map.update_profile_data(scanner_id, profile_data);
+      output_cells = scanner->get_output_cells();
 
-    profile_data -= profile_data_before;
+      if (!more) {
+        m_scanner_map.remove(scanner_id);
+        scanner.reset();
+      }
+      else
+        m_scanner_map.update_profile_data(scanner_id, profile_data);
+
+      profile_data -= profile_data_before;
+    }
 
     //HT_INFOF("scanner=%d cell_count=%d %s", (int)scanner_id, (int)cell_count, profile_data.to_string().c_str());
 
@@ -1698,7 +2006,27 @@ Apps::RangeServer::fetch_scanblock(Response::Callback::CreateScanner *cb,
     /**
      *  Send back data
      */
-    {
+    if (shared_block.data) {
+      error = cb->response(scanner_id, 0, 0, more, profile_data,
+                           shared_block.data, shared_block.length);
+      if (error != Error::OK)
+        HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
+
+      HT_DEBUGF("Successfully fetched %u bytes (%lld k/v pairs) of shared "
+                "scan data", (unsigned)shared_block.length-4,
+                (Lld)output_cells);
+    }
+    else if (zero_copy_block) {
+      error = cb->response(scanner_id, 0, 0, more, profile_data,
+                           zero_copy_block);
+      if (error != Error::OK)
+        HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
+
+      HT_DEBUGF("Successfully fetched %u bytes (%lld k/v pairs, %u bytes "
+                "uncopied) of scan data", (unsigned)zero_copy_block->size()-4,
+                (Lld)output_cells, (unsigned)zero_copy_block->referenced());
+    }
+    else {
       StaticBuffer ext(rbuf);
       error = cb->response(scanner_id, 0, 0, more, profile_data, ext);
       if (error != Error::OK)
@@ -3676,6 +4004,9 @@ void Apps::RangeServer::do_maintenance() {
     // Purge expired scanners
     m_scanner_map.purge_expired(m_scanner_ttl);
 
+    if (m_shared_scan_map)
+      m_shared_scan_map->purge();
+
     // Set Low Memory mode
     bool low_memory_mode = m_timer_handler->low_memory_mode();
     m_maintenance_scheduler->set_low_memory_mode(low_memory_mode);
@@ -43,6 +43,7 @@
 #include <Hypertable/RangeServer/Response/Callback/Status.h>
 #include <Hypertable/RangeServer/Response/Callback/Update.h>
 #include <Hypertable/RangeServer/ScannerMap.h>
+#include <Hypertable/RangeServer/SharedScanMap.h>
 #include <Hypertable/RangeServer/TableInfo.h>
 #include <Hypertable/RangeServer/TableInfoMap.h>
 #include <Hypertable/RangeServer/TimerHandler.h>
@@ -104,6 +105,9 @@ namespace Apps {
                         const TableIdentifier &,
                         const  RangeSpec &, const ScanSpec &,
                         QueryCache::Key *);
+    void multi_get(Response::Callback::CreateScanner *,
+                   const TableIdentifier &, const RangeSpec &,
+                   const ScanSpec &, const std::vector<const char *> &rows);
     void destroy_scanner(ResponseCallback *cb, int32_t scanner_id);
     void fetch_scanblock(Response::Callback::CreateScanner *, int32_t scanner_id);
     void load_range(ResponseCallback *, const TableIdentifier &,
@@ -328,6 +332,13 @@ namespace Apps {
     GroupCommitTimerHandlerPtr m_group_commit_timer_handler;
     QueryCachePtr m_query_cache;
     int64_t m_scanner_buffer_size {};
+    int32_t m_zero_copy_min_value_size {};
+    /// Size after which a multi get response is rejected
+    int64_t m_multi_get_max_response_size {};
+    /// Joinable shared scans, null if scan sharing is disabled
+    SharedScanMapPtr m_shared_scan_map;
+    /// Block memory after which a shared scan can no longer be joined
+    int64_t m_shared_scan_max_memory {};
     time_t m_last_metrics_update {};
     time_t m_next_metrics_update {};
     double m_loadavg_accum {};
@@ -66,3 +66,19 @@ int CreateScanner::response(int32_t id, int32_t skipped_rows,
   return m_comm->send_response(m_event->addr, cbuf);
 }
 
+
+int CreateScanner::response(int32_t id, int32_t skipped_rows,
+                            int32_t skipped_cells, bool more,
+                            ProfileDataScanner &profile_data,
+                            ZeroCopyScanBlockPtr &block) {
+  CommHeader header;
+  header.initialize_from_request_header(m_event->header);
+  Lib::RangeServer::Response::Parameters::CreateScanner params(id, skipped_rows,
+                                                               skipped_cells, more,
+                                                               profile_data);
+  CommBufPtr cbuf(new CommBuf(header, 4+params.encoded_length()));
+  cbuf->append_i32(Error::OK);
+  params.encode(cbuf->get_data_ptr_address());
+  block->append_to(cbuf.get());
+  return m_comm->send_response(m_event->addr, cbuf);
+}
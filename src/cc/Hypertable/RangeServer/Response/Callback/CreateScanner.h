@@ -22,6 +22,8 @@
 #ifndef Hypertable_RangeServer_Response_Callback_CreateScanner_h
 #define Hypertable_RangeServer_Response_Callback_CreateScanner_h
 
+#include <Hypertable/RangeServer/ZeroCopyScanBlock.h>
+
 #include <Hypertable/Lib/ProfileDataScanner.h>
 
 #include <AsyncComm/ResponseCallback.h>
@@ -48,6 +50,13 @@ namespace Callback {
     int response(int32_t id, int32_t skipped_rows, int32_t skipped_cells,
                  bool more, ProfileDataScanner &profile_data,
                  boost::shared_array<uint8_t> &ext_buffer, uint32_t ext_len);
+
+    /// Sends a response whose scan block references pinned memory.
+    /// The segments of <code>block</code> are appended to the response
+    /// without being copied.
+    int response(int32_t id, int32_t skipped_rows, int32_t skipped_cells,
+                 bool more, ProfileDataScanner &profile_data,
+                 ZeroCopyScanBlockPtr &block);
   };
 
   /// @}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for ScanAggregator.
+/// This file contains the method definitions for ScanAggregator, a class that
+/// evaluates the aggregate function of a scan over the cells returned by a
+/// range scan.
+
+#include <Common/Compat.h>
+
+#include "ScanAggregator.h"
+
+#include <Hypertable/RangeServer/MergeScannerRange.h>
+#include <Hypertable/RangeServer/ScanContext.h>
+
+#include <Common/Logger.h>
+#include <Common/Serialization.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+using namespace Hypertable;
+using namespace std;
+
+ScanAggregator::ScanAggregator(ScanContext *scan_ctx, MergeScannerRange *input)
+  : m_scan_context(scan_ctx), m_input(input),
+    m_function(scan_ctx->spec->aggregate),
+    m_row_prefix_length(scan_ctx->spec->aggregate_row_prefix_length) {
+  HT_ASSERT(m_function != ScanSpec::AGGREGATE_NONE);
+}
+
+bool ScanAggregator::add(const Key &key, const ByteString &value) {
+
+  if (key.flag != FLAG_INSERT)
+    return true;
+
+  size_t row_len = strlen(key.row);
+  if (m_row_prefix_length >= 0 && (size_t)m_row_prefix_length < row_len)
+    row_len = m_row_prefix_length;
+
+  if (!m_have_row) {
+    m_row.assign(key.row, row_len);
+    m_have_row = true;
+  }
+  else if (row_len != m_row.length() ||
+           memcmp(key.row, m_row.c_str(), row_len)) {
+    complete_row();
+    return false;
+  }
+
+  int64_t val {};
+  if (m_function != ScanSpec::AGGREGATE_COUNT &&
+      !decode_value(key, value, &val))
+    return true;
+
+  Accumulator &acc = m_accumulators[key.column_family_code];
+  if (acc.count == 0) {
+    m_families.push_back(key.column_family_code);
+    acc.value = val;
+  }
+  else {
+    switch (m_function) {
+    case ScanSpec::AGGREGATE_SUM:
+      acc.value += val;
+      break;
+    case ScanSpec::AGGREGATE_MIN:
+      acc.value = std::min(acc.value, val);
+      break;
+    case ScanSpec::AGGREGATE_MAX:
+      acc.value = std::max(acc.value, val);
+      break;
+    default:
+      break;
+    }
+  }
+  acc.count++;
+  acc.timestamp = std::max(acc.timestamp, key.timestamp);
+  acc.revision = std::max(acc.revision, key.revision);
+  return true;
+}
+
+void ScanAggregator::finish() {
+  if (m_have_row)
+    complete_row();
+  m_finished = true;
+}
+
+bool ScanAggregator::get(Key &key, ByteString &value) {
+
+  while (m_next == m_cells.size()) {
+    if (m_input == nullptr || m_finished)
+      return false;
+    Key input_key;
+    ByteString input_value;
+    if (!m_input->get(input_key, input_value))
+      finish();
+    else if (add(input_key, input_value))
+      m_input->forward();
+  }
+
+  const uint8_t *ptr = m_buf.base + m_cells[m_next];
+  key.load(SerializedKey(ptr));
+  value.ptr = ptr + key.length;
+  return true;
+}
+
+bool ScanAggregator::decode_value(const Key &key, const ByteString &value,
+                                  int64_t *result) {
+  const uint8_t *ptr;
+  size_t len = value.decode_length(&ptr);
+
+  if (m_scan_context->cell_predicates[key.column_family_code].counter) {
+    // value must be encoded 64 bit int followed by '=' character
+    if (len != 9)
+      return false;
+    *result = Serialization::decode_i64(&ptr, &len);
+    return true;
+  }
+
+  char buf[32];
+  if (len == 0 || len >= sizeof(buf))
+    return false;
+  memcpy(buf, ptr, len);
+  buf[len] = 0;
+  char *end;
+  errno = 0;
+  *result = strtoll(buf, &end, 10);
+  return errno == 0 && end == buf + len;
+}
+
+void ScanAggregator::complete_row() {
+  char numbuf[24];
+
+  // Start over once all previously completed cells have been returned
+  if (m_next == m_cells.size()) {
+    m_buf.clear();
+    m_cells.clear();
+    m_next = 0;
+  }
+
+  sort(m_families.begin(), m_families.end());
+
+  for (auto family : m_families) {
+    Accumulator &acc = m_accumulators[family];
+    int64_t result = (m_function == ScanSpec::AGGREGATE_COUNT) ?
+      acc.count : acc.value;
+    size_t len = sprintf(numbuf, "%lld", (Lld)result);
+    m_cells.push_back(m_buf.fill());
+    create_key_and_append(m_buf, FLAG_INSERT, m_row.c_str(), family, "",
+                          acc.timestamp, acc.revision);
+    append_as_byte_string(m_buf, numbuf, len);
+    acc = Accumulator();
+  }
+
+  m_families.clear();
+  m_have_row = false;
+}
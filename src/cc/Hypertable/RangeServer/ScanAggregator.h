@@ -0,0 +1,171 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for ScanAggregator.
+/// This file contains the type declarations for ScanAggregator, a class that
+/// evaluates the aggregate function of a scan over the cells returned by a
+/// range scan.
+
+#ifndef Hypertable_RangeServer_ScanAggregator_h
+#define Hypertable_RangeServer_ScanAggregator_h
+
+#include <Hypertable/Lib/Key.h>
+
+#include <Common/ByteString.h>
+#include <Common/DynamicBuffer.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Hypertable {
+
+  class MergeScannerRange;
+  class ScanContext;
+
+  /// @addtogroup RangeServer
+  /// @{
+
+  /// Evaluates the aggregate function of a scan.
+  /// When the scan specification carries an aggregate function
+  /// (ScanSpec::aggregate), the cells that survive all of the filters, offsets
+  /// and limits of the range scan are grouped by row, or by row prefix, and
+  /// column family, and each group is replaced by a single cell holding the
+  /// aggregate of its values.  The aggregate cell has the group row as its
+  /// row key, an empty column qualifier, the largest timestamp and revision
+  /// of the group, and the aggregate as an ASCII integer as its value.
+  /// COUNT counts the insert cells of a group.  SUM, MIN and MAX operate on
+  /// the decoded value of counter columns and on values of other columns that
+  /// parse completely as integers; other values are ignored and a group
+  /// without any integer values produces no cell.  Since cells arrive in key
+  /// order, a group is complete as soon as a cell of a different group row
+  /// arrives, so only the groups of one row are buffered at a time.  Each
+  /// range produces partial aggregates for the groups that span ranges, which
+  /// are combined by the client (see ScanAggregateCombiner).
+  class ScanAggregator {
+  public:
+
+    /// Constructor.
+    /// @param scan_ctx Scan context holding the scan specification
+    /// @param input Range scanner from which cells are pulled, or nullptr if
+    /// cells are supplied with add() and finish()
+    ScanAggregator(ScanContext *scan_ctx, MergeScannerRange *input=nullptr);
+
+    /// Adds a cell to the current group.
+    /// If <code>key</code> belongs to a different group row than the
+    /// current one, completes the groups of the current row, which become
+    /// available through get(), and returns <i>false</i> without adding the
+    /// cell.  The caller adds the cell again once the completed groups have
+    /// been consumed.  Cells other than inserts are ignored.
+    /// @param key Key of cell
+    /// @param value Value of cell
+    /// @return <i>true</i> if the cell was consumed, <i>false</i> otherwise
+    bool add(const Key &key, const ByteString &value);
+
+    /// Completes the groups of the current row at the end of the input.
+    void finish();
+
+    /// Gets the next aggregate cell.
+    /// Returns completed aggregate cells and, when a range scanner was
+    /// supplied to the constructor, pulls cells from it until a group row is
+    /// complete.  The key and value remain valid until forward() moves past
+    /// the last aggregate cell of the row.
+    /// @param key Address of key of next aggregate cell
+    /// @param value Address of value of next aggregate cell
+    /// @return <i>true</i> if an aggregate cell was returned, <i>false</i>
+    /// at the end of the scan
+    bool get(Key &key, ByteString &value);
+
+    /// Moves to the next aggregate cell.
+    void forward() { m_next++; }
+
+    /// Returns scan context.
+    /// @return Scan context
+    ScanContext *scan_context() { return m_scan_context; }
+
+  private:
+
+    /// Accumulated state of one group
+    struct Accumulator {
+      /// Aggregate of the values
+      int64_t value {};
+      /// Number of values aggregated
+      int64_t count {};
+      /// Largest timestamp of the group
+      int64_t timestamp {TIMESTAMP_MIN};
+      /// Largest revision of the group
+      int64_t revision {TIMESTAMP_MIN};
+    };
+
+    /// Decodes the value of a cell as an integer.
+    /// @param key Key of cell
+    /// @param value Value of cell
+    /// @param result Address of variable to hold integer value
+    /// @return <i>true</i> if the value is an integer, <i>false</i> otherwise
+    bool decode_value(const Key &key, const ByteString &value,
+                      int64_t *result);
+
+    /// Serializes the aggregate cells of the current group row into #m_buf.
+    void complete_row();
+
+    /// Scan context
+    ScanContext *m_scan_context;
+
+    /// Range scanner supplying cells, or nullptr
+    MergeScannerRange *m_input;
+
+    /// Aggregate function
+    uint8_t m_function;
+
+    /// Group row prefix length (-1 for full row)
+    int32_t m_row_prefix_length;
+
+    /// Row key (or row prefix) of current group row
+    std::string m_row;
+
+    /// Flag indicating if a group row is being accumulated
+    bool m_have_row {};
+
+    /// Flag indicating if the input has been exhausted
+    bool m_finished {};
+
+    /// Accumulators indexed by column family code
+    Accumulator m_accumulators[256];
+
+    /// Column family codes with groups in the current row
+    std::vector<uint8_t> m_families;
+
+    /// Serialized aggregate cells
+    DynamicBuffer m_buf;
+
+    /// Offsets of the aggregate cells in #m_buf
+    std::vector<size_t> m_cells;
+
+    /// Index of next aggregate cell to return
+    size_t m_next {};
+  };
+
+  /// @}
+
+}
+
+#endif // Hypertable_RangeServer_ScanAggregator_h
@@ -344,24 +344,8 @@ ScanContext::initialize(int64_t rev, const ScanSpec *ss,
           tmp_str.c_str(), TIMESTAMP_MAX, revision);
     }
   }
-  else {
-    if (start_inclusive || start_key.row_len == 0)
-      create_key_and_append(dbuf, 0, start_key.row, 0, "", TIMESTAMP_MAX, revision);
-    else {
-      tmp_str = start_key.row;
-      tmp_str.append(1, 1);
-      create_key_and_append(dbuf, 0, tmp_str.c_str(), 0, "", TIMESTAMP_MAX, revision);
-    }
-    start_serkey.ptr = dbuf.base;
-    end_serkey.ptr = dbuf.ptr;
-    if (!end_inclusive)
-      create_key_and_append(dbuf, 0, end_key.row, 0, "", TIMESTAMP_MAX, revision);
-    else {
-      tmp_str = end_key.row;
-      tmp_str.append(1, 1);
-      create_key_and_append(dbuf, 0, tmp_str.c_str(), 0, "", TIMESTAMP_MAX, revision);
-    }
-  }
+  else
+    append_row_interval_keys();
 
   /** Get row, value regexps and row set **/
   if (spec) {
@@ -398,5 +382,56 @@ ScanContext::initialize(int64_t rev, const ScanSpec *ss,
         cell_predicates[cf_spec->get_id()].indexed = cf_spec->get_value_index() || cf_spec->get_qualifier_index();
       }
     }
+
+    // Flatten column predicates for per-cell evaluation
+    for (auto &cell_predicate : cell_predicates)
+      cell_predicate.compile();
+  }
+}
+
+
+void ScanContext::set_row_interval(const String &start, const String &end) {
+  HT_ASSERT(spec == 0);
+
+  start_row = start;
+  start_inclusive = start.empty();
+  if (end.empty())
+    end_row = Key::END_ROW_MARKER;
+  else
+    end_row = end;
+  end_inclusive = true;
+  single_row = false;
+  restricted_range = !(start_row == "" && end_row == Key::END_ROW_MARKER);
+
+  start_key.row = start_row.c_str();
+  start_key.row_len = start_row.length();
+
+  end_key.row = end_row.c_str();
+  end_key.row_len = end_row.length();
+
+  dbuf.clear();
+  dbuf.reserve(start_row.length() + end_row.length() + 64);
+  append_row_interval_keys();
+}
+
+
+void ScanContext::append_row_interval_keys() {
+  String tmp_str;
+
+  if (start_inclusive || start_key.row_len == 0)
+    create_key_and_append(dbuf, 0, start_key.row, 0, "", TIMESTAMP_MAX, revision);
+  else {
+    tmp_str = start_key.row;
+    tmp_str.append(1, 1);
+    create_key_and_append(dbuf, 0, tmp_str.c_str(), 0, "", TIMESTAMP_MAX, revision);
+  }
+  start_serkey.ptr = dbuf.base;
+  end_serkey.ptr = dbuf.ptr;
+  if (!end_inclusive)
+    create_key_and_append(dbuf, 0, end_key.row, 0, "", TIMESTAMP_MAX, revision);
+  else {
+    tmp_str = end_key.row;
+    tmp_str.append(1, 1);
+    create_key_and_append(dbuf, 0, tmp_str.c_str(), 0, "", TIMESTAMP_MAX, revision);
   }
 }
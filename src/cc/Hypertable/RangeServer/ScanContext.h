@@ -46,6 +46,8 @@ namespace Hypertable {
 
   using namespace std;
 
+  class ZeroCopyScanBlock;
+
   /**
    * Scan context information
    */
@@ -75,6 +77,13 @@ namespace Hypertable {
     typedef std::set<const char *, LtCstr, CstrAlloc> CstrRowSet;
     CstrRowSet rowset;
     uint32_t timeout_ms;
+    /// Scan block being filled, if any.  Cell store scanners pin each block
+    /// they load into it so values can be sent without being copied.
+    ZeroCopyScanBlock *zero_copy_block {};
+    /// Read cell stores with readahead even when the row interval is
+    /// restricted.  Set for compaction partitions so interior intervals
+    /// don't go through the block cache.
+    bool force_readahead {};
 
     /**
      * Constructor.
@@ -132,6 +141,19 @@ namespace Hypertable {
       }
     }
 
+    /**
+     * Restricts the scan to a row interval.  Sets up the start and end keys
+     * to cover the rows in the interval (<code>start</code>,
+     * <code>end</code>], leaving the family_mask and cell_predicates as they
+     * are.  An empty <code>start</code> starts at the beginning of the key
+     * space and an empty <code>end</code> runs to the end.  Only meant for
+     * contexts constructed without a scan specification.
+     *
+     * @param start start row (exclusive)
+     * @param end end row (inclusive)
+     */
+    void set_row_interval(const String &start, const String &end);
+
     void deep_copy_specs() {
       scan_spec_builder = *spec;
       spec = &scan_spec_builder.get();
@@ -157,6 +179,12 @@ namespace Hypertable {
      */
     void initialize(int64_t rev, const ScanSpec *ss, const RangeSpec *range,
                     SchemaPtr &sp, std::set<uint8_t> *columns=0);
+
+    /**
+     * Appends the serialized start and end keys of a row interval to dbuf
+     * and points start_serkey and end_serkey at them.
+     */
+    void append_row_interval_keys();
     /**
      * Disable copy ctor and assignment op
      */
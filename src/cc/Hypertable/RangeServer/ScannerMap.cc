@@ -52,11 +52,28 @@ int32_t ScannerMap::put(MergeScannerRangePtr &scanner, RangePtr &range,
 }
 
 
+int32_t ScannerMap::put(SharedScanCursorPtr &cursor, RangePtr &range,
+                        const TableIdentifier &table,
+                        ProfileDataScanner &profile_data) {
+  lock_guard<mutex> lock(m_mutex);
+  ScanInfo scaninfo;
+  scaninfo.cursor = cursor;
+  scaninfo.range = range;
+  scaninfo.last_access_millis = get_timestamp_millis();
+  scaninfo.table= table;
+  scaninfo.profile_data = profile_data;
+  int32_t id = ++ms_next_id;
+  m_scanner_map[id] = scaninfo;
+  return id;
+}
+
+
 
 /**
  */
 bool
-ScannerMap::get(int32_t id, MergeScannerRangePtr &scanner, RangePtr &range,
+ScannerMap::get(int32_t id, MergeScannerRangePtr &scanner,
+                SharedScanCursorPtr &cursor, RangePtr &range,
                 TableIdentifierManaged &table,ProfileDataScanner *profile_data){
   lock_guard<mutex> lock(m_mutex);
   auto iter = m_scanner_map.find(id);
@@ -64,6 +81,7 @@ ScannerMap::get(int32_t id, MergeScannerRangePtr &scanner, RangePtr &range,
     return false;
   (*iter).second.last_access_millis = get_timestamp_millis();
   scanner = (*iter).second.scanner;
+  cursor = (*iter).second.cursor;
   range = (*iter).second.range;
   table = (*iter).second.table;
   *profile_data = (*iter).second.profile_data;
@@ -91,6 +109,7 @@ void ScannerMap::purge_expired(int32_t max_idle_millis) {
                "milliseconds", (*iter).first, max_idle_millis);
       ++iter;
       (*tmp_iter).second.scanner = 0;
+      (*tmp_iter).second.cursor = 0;
       (*tmp_iter).second.range = 0;
       m_scanner_map.erase(tmp_iter);
     }
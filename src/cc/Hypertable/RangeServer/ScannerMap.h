@@ -29,6 +29,7 @@
 
 #include <Hypertable/RangeServer/MergeScannerRange.h>
 #include <Hypertable/RangeServer/Range.h>
+#include <Hypertable/RangeServer/SharedScan.h>
 
 #include <Hypertable/Lib/ProfileDataScanner.h>
 
@@ -59,20 +60,36 @@ namespace Hypertable {
     int32_t put(MergeScannerRangePtr &scanner, RangePtr &range,
                  const TableIdentifier &table, ProfileDataScanner &profile_data);
 
+    /**
+     * This method computes a unique scanner ID and puts the given shared scan
+     * cursor and range pointers into a map using the scanner ID as the key.
+     *
+     * @param cursor smart pointer to shared scan cursor
+     * @param range smart pointer to range object
+     * @param table table identifier for this scanner
+     * @param profile_data Scanner profile data
+     * @return unique scanner ID
+     */
+    int32_t put(SharedScanCursorPtr &cursor, RangePtr &range,
+                const TableIdentifier &table, ProfileDataScanner &profile_data);
+
     /**
      * This method retrieves the scanner and range mapped to the given scanner
      * id.  It also updates the 'last_access_millis' member of this scanner map
-     * entry.
+     * entry.  Scanners attached to a shared scan are returned as a cursor,
+     * with <code>scanner</code> set to null.
      *
      * @param id scanner id
      * @param scanner smart pointer to returned scanner object
+     * @param cursor smart pointer to returned shared scan cursor
      * @param range smart pointer to returned range object
      * @param table reference to (managed) table identifier
      * @param profile_data Pointer to profile data structure populated by this
      * function
      * @return true if found, false if not
      */
-    bool get(int32_t id, MergeScannerRangePtr &scanner, RangePtr &range,
+    bool get(int32_t id, MergeScannerRangePtr &scanner,
+             SharedScanCursorPtr &cursor, RangePtr &range,
              TableIdentifierManaged &table, ProfileDataScanner *profile_data);
 
     /**
@@ -127,6 +144,8 @@ namespace Hypertable {
     struct ScanInfo {
       /// Scanner
       MergeScannerRangePtr scanner;
+      /// Shared scan cursor
+      SharedScanCursorPtr cursor;
       /// Range
       RangePtr range;
       /// Last access time in milliseconds since epoch
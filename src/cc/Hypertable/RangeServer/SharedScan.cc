@@ -0,0 +1,226 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for SharedScan.
+/// This file contains definitions for SharedScan, a range scan whose scan
+/// blocks are shared by all scanners created with the same scan
+/// specification at the same revision.
+
+#include <Common/Compat.h>
+
+#include "SharedScan.h"
+
+#include <Hypertable/RangeServer/FillScanBlock.h>
+#include <Hypertable/RangeServer/Global.h>
+
+#include <Common/DynamicBuffer.h>
+#include <Common/Error.h>
+#include <Common/Logger.h>
+
+using namespace Hypertable;
+using namespace std;
+
+SharedScan::SharedScan(MergeScannerRangePtr &scanner, int64_t buffer_size,
+                       int64_t max_memory)
+  : m_scanner(scanner), m_buffer_size(buffer_size),
+    m_max_memory(max_memory) {
+}
+
+
+SharedScan::~SharedScan() {
+  if (m_memory)
+    Global::memory_tracker->subtract(m_memory);
+}
+
+
+SharedScanCursorPtr SharedScan::attach() {
+  lock_guard<mutex> lock(m_mutex);
+  if (!m_joinable)
+    return SharedScanCursorPtr();
+  HT_ASSERT(m_first == 0);
+  m_positions[0]++;
+  return make_shared<SharedScanCursor>(shared_from_this());
+}
+
+
+void SharedScan::fetch(SharedScanCursor *cursor, Block &block,
+                       ProfileDataScanner &profile_data) {
+  unique_lock<mutex> lock(m_mutex);
+  int64_t position = cursor->m_position;
+
+  HT_ASSERT(position >= m_first);
+
+  while (position >= m_first + (int64_t)m_blocks.size()) {
+
+    if (m_error != Error::OK)
+      HT_THROW(m_error, m_error_message);
+
+    if (m_filling) {
+      m_cond.wait(lock);
+      continue;
+    }
+
+    // Fill next block with the mutex released so that scanners replaying
+    // earlier blocks are not held up
+    HT_ASSERT(m_scanner);
+    m_filling = true;
+    lock.unlock();
+
+    DynamicBuffer dbuf;
+    ProfileDataScanner scanner_profile_data;
+    int32_t skipped_rows {}, skipped_cells {};
+    uint32_t cell_count {};
+    bool more;
+    try {
+      more = FillScanBlock(m_scanner, dbuf, &cell_count, m_buffer_size);
+    }
+    catch (Exception &e) {
+      // The scanner is left in an unknown state, so fail the rest of the scan
+      lock.lock();
+      m_error = e.code();
+      m_error_message = e.what();
+      m_joinable = false;
+      m_filling = false;
+      m_cond.notify_all();
+      throw;
+    }
+    scanner_profile_data.cells_scanned = m_scanner->get_input_cells();
+    scanner_profile_data.cells_returned = m_scanner->get_output_cells();
+    scanner_profile_data.bytes_scanned = m_scanner->get_input_bytes();
+    scanner_profile_data.bytes_returned = m_scanner->get_output_bytes();
+    scanner_profile_data.disk_read = m_scanner->get_disk_read();
+    skipped_rows = m_scanner->get_skipped_rows();
+    skipped_cells = m_scanner->get_skipped_cells();
+    if (!more)
+      m_scanner.reset();
+
+    size_t length;
+    block.data.reset(dbuf.release(&length));
+    block.length = length;
+    block.cell_count = cell_count;
+    block.more = more;
+
+    lock.lock();
+
+    profile_data = scanner_profile_data;
+    profile_data -= m_profile_data;
+    m_profile_data = scanner_profile_data;
+
+    if (position == 0) {
+      m_skipped_rows = skipped_rows;
+      m_skipped_cells = skipped_cells;
+    }
+
+    m_blocks.push_back(block);
+    m_memory += block.length;
+    Global::memory_tracker->add(block.length);
+    if (m_memory > m_max_memory)
+      m_joinable = false;
+    m_filling = false;
+    m_cond.notify_all();
+
+    int64_t next = more ? position + 1 : -1;
+    move(position, next);
+    cursor->m_position = next;
+    trim();
+    return;
+  }
+
+  // Replay buffered block
+  block = m_blocks[position - m_first];
+  profile_data = ProfileDataScanner();
+  profile_data.cells_returned = block.cell_count;
+  profile_data.bytes_returned = block.length;
+
+  int64_t next = block.more ? position + 1 : -1;
+  move(position, next);
+  cursor->m_position = next;
+  trim();
+}
+
+
+void SharedScan::get_skipped(int32_t *skipped_rowsp, int32_t *skipped_cellsp) {
+  lock_guard<mutex> lock(m_mutex);
+  *skipped_rowsp = m_skipped_rows;
+  *skipped_cellsp = m_skipped_cells;
+}
+
+
+bool SharedScan::joinable() {
+  lock_guard<mutex> lock(m_mutex);
+  return m_joinable;
+}
+
+
+void SharedScan::set_unjoinable() {
+  lock_guard<mutex> lock(m_mutex);
+  m_joinable = false;
+  trim();
+}
+
+
+int64_t SharedScan::memory_used() {
+  lock_guard<mutex> lock(m_mutex);
+  return m_memory;
+}
+
+
+void SharedScan::detach(SharedScanCursor *cursor) {
+  MergeScannerRangePtr scanner;
+  {
+    lock_guard<mutex> lock(m_mutex);
+    move(cursor->m_position, -1);
+    if (m_positions.empty()) {
+      // Nobody left to read from the scan, so release everything now rather
+      // than when the map entry is purged
+      m_joinable = false;
+      scanner.swap(m_scanner);
+    }
+    trim();
+  }
+}
+
+
+void SharedScan::move(int64_t from, int64_t to) {
+  if (from >= 0) {
+    auto iter = m_positions.find(from);
+    HT_ASSERT(iter != m_positions.end());
+    if (--iter->second == 0)
+      m_positions.erase(iter);
+  }
+  if (to >= 0)
+    m_positions[to]++;
+}
+
+
+void SharedScan::trim() {
+  if (m_joinable)
+    return;
+  int64_t min_position = m_positions.empty() ?
+    m_first + (int64_t)m_blocks.size() : m_positions.begin()->first;
+  while (m_first < min_position && !m_blocks.empty()) {
+    m_memory -= m_blocks.front().length;
+    Global::memory_tracker->subtract(m_blocks.front().length);
+    m_blocks.pop_front();
+    m_first++;
+  }
+}
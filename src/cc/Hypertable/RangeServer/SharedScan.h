@@ -0,0 +1,244 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for SharedScan.
+/// This file contains declarations for SharedScan, a range scan whose scan
+/// blocks are shared by all scanners created with the same scan
+/// specification at the same revision, and SharedScanCursor, the position
+/// of one of those scanners within it.
+
+#ifndef Hypertable_RangeServer_SharedScan_h
+#define Hypertable_RangeServer_SharedScan_h
+
+#include <Hypertable/RangeServer/MergeScannerRange.h>
+
+#include <Hypertable/Lib/ProfileDataScanner.h>
+
+#include <boost/shared_array.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace Hypertable {
+
+  /// @addtogroup RangeServer
+  /// @{
+
+  class SharedScanCursor;
+
+  /// Range scan shared by identical scanners.
+  /// Scanners created with the same scan specification on the same range at
+  /// the same scan revision return identical scan blocks.  A SharedScan runs
+  /// one MergeScannerRange for all of them: the first scanner to ask for a
+  /// block fills it with FillScanBlock() and the others replay it.  Blocks
+  /// are kept so that a scanner joining later can replay the blocks it
+  /// missed, until the buffered blocks exceed the per-scan memory limit.
+  /// The memory of buffered blocks is accounted in Global::memory_tracker.
+  /// From then on no scanner can join and blocks are dropped once every
+  /// attached scanner has fetched them.  Only one block is filled at a time;
+  /// scanners asking for a block that is being filled wait for it, while
+  /// scanners replaying earlier blocks proceed.
+  class SharedScan : public std::enable_shared_from_this<SharedScan> {
+  public:
+
+    /// Scan block.
+    struct Block {
+      /// Encoded scan block, as filled by FillScanBlock()
+      boost::shared_array<uint8_t> data;
+      /// Length of #data
+      uint32_t length {};
+      /// Number of cells in block
+      uint32_t cell_count {};
+      /// <i>true</i> if more blocks follow
+      bool more {};
+    };
+
+    /// Constructor.
+    /// @param scanner Scanner from which blocks are filled
+    /// @param buffer_size Size of scan blocks (see FillScanBlock())
+    /// @param max_memory Amount of block memory after which no more scanners
+    /// may join
+    SharedScan(MergeScannerRangePtr &scanner, int64_t buffer_size,
+               int64_t max_memory);
+
+    /// Destructor.
+    /// Removes the memory of buffered blocks from Global::memory_tracker.
+    ~SharedScan();
+
+    /// Attaches a scanner positioned at the first block.
+    /// @return Cursor for new scanner, or null if the first block has been
+    /// dropped
+    std::shared_ptr<SharedScanCursor> attach();
+
+    /// Fetches block at cursor position and advances cursor.
+    /// If the block has not been filled yet, fills it, or waits for another
+    /// scanner that is filling it.  If filling a block fails, the error is
+    /// thrown to every scanner that asks for a block not yet filled.  When
+    /// filling, <code>profile_data</code> is set to the work done by the
+    /// underlying scanner; when replaying, only the cells and bytes returned
+    /// are set.
+    /// @param cursor Cursor returned by attach()
+    /// @param block Block to hold fetched block
+    /// @param profile_data Profile data for this fetch
+    void fetch(SharedScanCursor *cursor, Block &block,
+               ProfileDataScanner &profile_data);
+
+    /// Gets skipped rows and cells of the first block.
+    /// Scanners that join replay the first block and report the rows and
+    /// cells its scanner skipped for the row and cell offsets of the scan
+    /// specification.
+    /// @param skipped_rowsp Address of variable to hold skipped rows
+    /// @param skipped_cellsp Address of variable to hold skipped cells
+    void get_skipped(int32_t *skipped_rowsp, int32_t *skipped_cellsp);
+
+    /// Checks if scanners may still join.
+    /// @return <i>true</i> if the first block is still buffered
+    bool joinable();
+
+    /// Stops scanners from joining.
+    /// Blocks are dropped from then on once every attached scanner has
+    /// fetched them.
+    void set_unjoinable();
+
+    /// Returns memory used by buffered blocks.
+    /// @return Memory used by buffered blocks
+    int64_t memory_used();
+
+  private:
+
+    friend class SharedScanCursor;
+
+    /// Detaches scanner.
+    /// Called by cursor destructor.
+    /// @param cursor Cursor of scanner
+    void detach(SharedScanCursor *cursor);
+
+    /// Moves cursor from one position to another.
+    /// @param from Current position
+    /// @param to New position, or -1 when the cursor is detached
+    void move(int64_t from, int64_t to);
+
+    /// Drops blocks that no attached scanner will fetch.
+    /// Keeps all blocks while scanners may still join.
+    void trim();
+
+    /// %Mutex serializing access to members
+    std::mutex m_mutex;
+
+    /// Signaled when a block has been filled
+    std::condition_variable m_cond;
+
+    /// Scanner from which blocks are filled, reset when exhausted
+    MergeScannerRangePtr m_scanner;
+
+    /// Size of scan blocks
+    int64_t m_buffer_size;
+
+    /// Memory limit for joining
+    int64_t m_max_memory;
+
+    /// Buffered blocks
+    std::deque<Block> m_blocks;
+
+    /// Position of first buffered block
+    int64_t m_first {};
+
+    /// Number of attached scanners at each position
+    std::map<int64_t, int32_t> m_positions;
+
+    /// Memory used by buffered blocks
+    int64_t m_memory {};
+
+    /// Profile data of underlying scanner after last fill
+    ProfileDataScanner m_profile_data;
+
+    /// Rows skipped by first block
+    int32_t m_skipped_rows {};
+
+    /// Cells skipped by first block
+    int32_t m_skipped_cells {};
+
+    /// Error code of failed fill, or Error::OK
+    int m_error {};
+
+    /// Error message of failed fill
+    std::string m_error_message;
+
+    /// <i>true</i> if a block is being filled
+    bool m_filling {};
+
+    /// <i>true</i> if scanners may join
+    bool m_joinable {true};
+  };
+
+  /// Smart pointer to SharedScan
+  typedef std::shared_ptr<SharedScan> SharedScanPtr;
+
+  /// Position of a scanner within a SharedScan.
+  /// Detaches the scanner from the scan when destroyed.
+  class SharedScanCursor {
+  public:
+
+    /// Constructor.
+    /// @param scan Shared scan
+    SharedScanCursor(SharedScanPtr scan) : m_scan(scan) { }
+
+    /// Destructor.
+    /// Detaches from #m_scan.
+    ~SharedScanCursor() { m_scan->detach(this); }
+
+    /// Fetches next block.
+    /// @see SharedScan::fetch()
+    /// @param block Block to hold fetched block
+    /// @param profile_data Profile data for this fetch
+    void fetch(SharedScan::Block &block, ProfileDataScanner &profile_data) {
+      m_scan->fetch(this, block, profile_data);
+    }
+
+    /// Gets shared scan.
+    /// @return Shared scan
+    SharedScanPtr &scan() { return m_scan; }
+
+  private:
+
+    friend class SharedScan;
+
+    /// Shared scan
+    SharedScanPtr m_scan;
+
+    /// Position of next block to fetch, or -1 after last block
+    int64_t m_position {};
+  };
+
+  /// Smart pointer to SharedScanCursor
+  typedef std::shared_ptr<SharedScanCursor> SharedScanCursorPtr;
+
+  /// @}
+
+}
+
+#endif // Hypertable_RangeServer_SharedScan_h
@@ -0,0 +1,105 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+/// @file
+/// Definitions for SharedScanMap.
+/// This file contains definitions for SharedScanMap, a map of the shared
+/// scans that new scanners may join.
+
+#include <Common/Compat.h>
+
+#include "SharedScanMap.h"
+
+#include <Common/Serialization.h>
+
+#include <cstring>
+
+using namespace Hypertable;
+using namespace std;
+
+String SharedScanMap::key(const TableIdentifier &table,
+                          const RangeSpec &range_spec, int64_t revision,
+                          const ScanSpec &scan_spec) {
+  size_t start_len = strlen(range_spec.start_row);
+  size_t end_len = strlen(range_spec.end_row);
+  size_t length = strlen(table.id) + 1 + 8 + start_len + 1 + end_len + 1 +
+    8 + scan_spec.encoded_length();
+  String key(length, '\0');
+  uint8_t *base = (uint8_t *)&key[0];
+  uint8_t *ptr = base;
+  memcpy(ptr, table.id, strlen(table.id) + 1);
+  ptr += strlen(table.id) + 1;
+  Serialization::encode_i64(&ptr, table.generation);
+  memcpy(ptr, range_spec.start_row, start_len + 1);
+  ptr += start_len + 1;
+  memcpy(ptr, range_spec.end_row, end_len + 1);
+  ptr += end_len + 1;
+  Serialization::encode_i64(&ptr, revision);
+  scan_spec.encode(&ptr);
+  HT_ASSERT((size_t)(ptr - base) == length);
+  return key;
+}
+
+
+SharedScanCursorPtr SharedScanMap::join(const String &key) {
+  lock_guard<mutex> lock(m_mutex);
+  auto iter = m_map.find(key);
+  if (iter == m_map.end())
+    return SharedScanCursorPtr();
+  SharedScanCursorPtr cursor = iter->second->attach();
+  if (!cursor)
+    m_map.erase(iter);
+  return cursor;
+}
+
+
+bool SharedScanMap::insert(const String &key, SharedScanPtr &scan) {
+  lock_guard<mutex> lock(m_mutex);
+  int64_t memory = 0;
+  auto iter = m_map.begin();
+  while (iter != m_map.end()) {
+    if (!iter->second->joinable())
+      iter = m_map.erase(iter);
+    else {
+      memory += iter->second->memory_used();
+      ++iter;
+    }
+  }
+  if (memory + scan->memory_used() > m_max_memory ||
+      !m_map.insert(make_pair(key, scan)).second) {
+    scan->set_unjoinable();
+    return false;
+  }
+  return true;
+}
+
+
+void SharedScanMap::purge() {
+  lock_guard<mutex> lock(m_mutex);
+  auto iter = m_map.begin();
+  while (iter != m_map.end()) {
+    if (!iter->second->joinable())
+      iter = m_map.erase(iter);
+    else
+      ++iter;
+  }
+}
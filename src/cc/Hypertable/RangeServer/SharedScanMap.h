@@ -0,0 +1,109 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+/// @file
+/// Declarations for SharedScanMap.
+/// This file contains declarations for SharedScanMap, a map of the shared
+/// scans that new scanners may join.
+
+#ifndef Hypertable_RangeServer_SharedScanMap_h
+#define Hypertable_RangeServer_SharedScanMap_h
+
+#include <Hypertable/RangeServer/SharedScan.h>
+
+#include <Hypertable/Lib/RangeSpec.h>
+#include <Hypertable/Lib/ScanSpec.h>
+#include <Hypertable/Lib/TableIdentifier.h>
+
+#include <Common/String.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace Hypertable {
+
+  /// @addtogroup RangeServer
+  /// @{
+
+  /// Map of joinable shared scans.
+  /// Scans are keyed by table, range, scan revision, and scan specification,
+  /// so a scanner only joins a scan that returns exactly the cells it would
+  /// have returned itself.  Scans that can no longer be joined are dropped
+  /// when looked up or purged; scanners already attached to them continue
+  /// unaffected.
+  class SharedScanMap {
+  public:
+
+    /// Constructor.
+    /// @param max_memory Limit on block memory of joinable scans
+    SharedScanMap(int64_t max_memory) : m_max_memory(max_memory) { }
+
+    /// Builds key identifying a scan.
+    /// @param table %Table identifier
+    /// @param range_spec %Range specification
+    /// @param revision Scan revision
+    /// @param scan_spec Scan specification
+    /// @return Key of scan
+    static String key(const TableIdentifier &table, const RangeSpec &range_spec,
+                      int64_t revision, const ScanSpec &scan_spec);
+
+    /// Joins a scan.
+    /// @param key Key of scan
+    /// @return Cursor positioned at first block of scan, or null if no
+    /// joinable scan exists for <code>key</code>
+    SharedScanCursorPtr join(const String &key);
+
+    /// Inserts a scan.
+    /// The scan is not inserted if a joinable scan with the same key exists
+    /// or if the block memory of joinable scans exceeds the limit.  A scan
+    /// that is not inserted is made unjoinable, so that its blocks are
+    /// dropped as soon as its scanners have fetched them.
+    /// @param key Key of scan
+    /// @param scan Scan to insert
+    /// @return <i>true</i> if inserted, <i>false</i> otherwise
+    bool insert(const String &key, SharedScanPtr &scan);
+
+    /// Removes scans that can no longer be joined.
+    void purge();
+
+  private:
+
+    /// %Mutex serializing access to members
+    std::mutex m_mutex;
+
+    /// Limit on block memory of joinable scans
+    int64_t m_max_memory;
+
+    /// Joinable scans
+    std::unordered_map<String, SharedScanPtr> m_map;
+  };
+
+  /// Smart pointer to SharedScanMap
+  typedef std::shared_ptr<SharedScanMap> SharedScanMapPtr;
+
+  /// @}
+
+}
+
+#endif // Hypertable_RangeServer_SharedScanMap_h
@@ -27,6 +27,7 @@
 
 #include <AsyncComm/Clock.h>
 
+#include <atomic>
 #include <vector>
 
 namespace Hypertable {
@@ -59,7 +60,10 @@ namespace Hypertable {
     uint32_t total_updates {};
     uint32_t total_added {};
     uint32_t total_syncs {};
-    uint64_t total_bytes_added {};
+    /// Bytes added to ranges, summed by the stage 3 threads
+    std::atomic<uint64_t> total_bytes_added {0};
+    /// Number of stage 3 partitions that have yet to add their updates
+    std::atomic<uint32_t> pending_partitions {0};
   };
 
   /// @}
@@ -41,9 +41,11 @@
 #include <Common/Logger.h>
 #include <Common/Serialization.h>
 
+#include <algorithm>
 #include <chrono>
 #include <set>
 #include <thread>
+#include <vector>
 
 using namespace Hypertable;
 using namespace Hypertable::RangeServer;
@@ -58,10 +60,16 @@ UpdatePipeline::UpdatePipeline(ContextPtr &context, QueryCachePtr &query_cache,
   m_maintenance_pause_interval = m_context->props->get_i32("Hypertable.RangeServer.Testing.MaintenanceNeeded.PauseInterval");
   m_update_delay = m_context->props->get_i32("Hypertable.RangeServer.UpdateDelay", 0);
   m_max_clock_skew = m_context->props->get_i32("Hypertable.RangeServer.ClockSkew.Max");
-  m_threads.reserve(3);
+  int32_t add_threads = std::max(m_context->props->get_i32("Hypertable.RangeServer.UpdatePipeline.Threads"), 1);
+  size_t capacity = std::max(m_context->props->get_i32("Hypertable.RangeServer.UpdatePipeline.QueueCapacity"), 1);
+  m_commit_ring = make_unique<BoundedRing<UpdateContext *>>(capacity);
+  for (int32_t i=0; i<add_threads; i++)
+    m_add_rings.push_back(make_unique<BoundedRing<UpdateContext *>>(capacity));
+  m_threads.reserve(2 + add_threads);
   m_threads.push_back( thread(&UpdatePipeline::qualify_and_transform, this) );
   m_threads.push_back( thread(&UpdatePipeline::commit, this) );
-  m_threads.push_back( thread(&UpdatePipeline::add_and_respond, this) );
+  for (size_t i=0; i<m_add_rings.size(); i++)
+    m_threads.push_back( thread(&UpdatePipeline::add_and_respond, this, i) );
 }
 
 void UpdatePipeline::add(UpdateContext *uc) {
@@ -73,10 +81,14 @@ void UpdatePipeline::add(UpdateContext *uc) {
 
 
 void UpdatePipeline::shutdown() {
-  m_shutdown = true;
-  m_qualify_queue_cond.notify_all();
-  m_commit_queue_cond.notify_all();
-  m_response_queue_cond.notify_all();
+  {
+    lock_guard<mutex> lock(m_qualify_queue_mutex);
+    m_shutdown = true;
+    m_qualify_queue_cond.notify_all();
+  }
+  m_commit_ring->close();
+  for (auto &ring : m_add_rings)
+    ring->close();
   for (std::thread &t : m_threads)
     t.join();
 }
@@ -504,12 +516,8 @@ void UpdatePipeline::qualify_and_transform() {
     uc->last_revision = m_last_revision;
 
     // Enqueue update
-    {
-      lock_guard<std::mutex> lock(m_commit_queue_mutex);
-      m_commit_queue.push_back(uc);
-      m_commit_queue_cond.notify_all();
-      m_commit_queue_count++;
-    }
+    if (!m_commit_ring->push(uc))
+      return;
   }
 }
 
@@ -525,16 +533,8 @@ void UpdatePipeline::commit() {
   while (true) {
 
     // Dequeue next update
-    {
-      unique_lock<std::mutex> lock(m_commit_queue_mutex);
-      m_commit_queue_cond.wait(lock, [this](){
-          return !m_commit_queue.empty() || m_shutdown; });
-      if (m_shutdown)
-        return;
-      uc = m_commit_queue.front();
-      m_commit_queue.pop_front();
-      m_commit_queue_count--;
-    }
+    if (!m_commit_ring->pop(uc))
+      return;
 
     committed_transfer_data = 0;
     log_needs_syncing = false;
@@ -596,7 +596,7 @@ void UpdatePipeline::commit() {
 
     bool do_sync = false;
     if (log_needs_syncing) {
-      if (m_commit_queue_count > 0 && coalesce_amount < m_update_coalesce_limit) {
+      if (!m_commit_ring->empty() && coalesce_amount < m_update_coalesce_limit) {
         coalesce_queue.push_back(uc);
         continue;
       }
@@ -633,41 +633,56 @@ void UpdatePipeline::commit() {
       }
     }
 
-    // Enqueue update
-    {
-      lock_guard<std::mutex> lock(m_response_queue_mutex);
-      coalesce_queue.push_back(uc);
-      while (!coalesce_queue.empty()) {
-        uc = coalesce_queue.front();
-        coalesce_queue.pop_front();
-        m_response_queue.push_back(uc);
+    // Pass updates to stage 3
+    coalesce_queue.push_back(uc);
+    while (!coalesce_queue.empty()) {
+      uc = coalesce_queue.front();
+      coalesce_queue.pop_front();
+      dispatch(uc);
+    }
+    coalesce_amount = 0;
+  }
+}
+
+void UpdatePipeline::dispatch(UpdateContext *uc) {
+  vector<bool> involved(m_add_rings.size());
+  uint32_t count {};
+
+  for (UpdateRecTable *table_update : uc->updates) {
+    for (auto iter = table_update->range_map.begin(); iter != table_update->range_map.end(); ++iter) {
+      size_t part = partition((*iter).first);
+      if (!involved[part]) {
+        involved[part] = true;
+        count++;
       }
-      coalesce_amount = 0;
-      m_response_queue_cond.notify_all();
     }
   }
+
+  if (count == 0) {
+    involved[0] = true;
+    count = 1;
+  }
+
+  // uc may be deleted by a stage 3 thread once the last push is done
+  uc->pending_partitions = count;
+  for (size_t i=0; i<involved.size(); i++) {
+    if (involved[i] && !m_add_rings[i]->push(uc))
+      return;
+  }
 }
 
-void UpdatePipeline::add_and_respond() {
+void UpdatePipeline::add_and_respond(size_t part) {
   UpdateContext *uc;
   SerializedKey key;
-  int error = Error::OK;
 
   while (true) {
 
     // Dequeue next update
-    {
-      unique_lock<std::mutex> lock(m_response_queue_mutex);
-      m_response_queue_cond.wait(lock, [this](){
-          return !m_response_queue.empty() || m_shutdown; });
-      if (m_shutdown)
-        return;
-      uc = m_response_queue.front();
-      m_response_queue.pop_front();
-    }
+    if (!m_add_rings[part]->pop(uc))
+      return;
 
     /**
-     *  Insert updates into Ranges
+     *  Insert updates into this partition's Ranges
      */
     for (UpdateRecTable *table_update : uc->updates) {
 
@@ -676,6 +691,9 @@ void UpdatePipeline::add_and_respond() {
         ByteString value;
         Key key_comps;
 
+        if (partition((*iter).first) != part)
+          continue;
+
         for (UpdateRecRange &update : (*iter).second->updates) {
           Range *rangep = (*iter).first;
           lock_guard<Range> lock(*rangep);
@@ -734,92 +752,99 @@ void UpdatePipeline::add_and_respond() {
       }
     }
 
-    // Decrement usage counters for all referenced ranges
-    for (UpdateRecTable *table_update : uc->updates) {
-      for (auto iter = table_update->range_map.begin(); iter != table_update->range_map.end(); ++iter) {
-        if ((*iter).second->range_blocked)
-          (*iter).first->decrement_update_counter();
-      }
+    // The last partition to finish sends the response
+    if (--uc->pending_partitions == 0)
+      respond(uc);
+  }
+}
+
+void UpdatePipeline::respond(UpdateContext *uc) {
+  int error = Error::OK;
+
+  // Decrement usage counters for all referenced ranges
+  for (UpdateRecTable *table_update : uc->updates) {
+    for (auto iter = table_update->range_map.begin(); iter != table_update->range_map.end(); ++iter) {
+      if ((*iter).second->range_blocked)
+        (*iter).first->decrement_update_counter();
     }
+  }
 
-    /**
-     * wait for these ranges to complete maintenance
-     */
-    bool maintenance_needed = false;
-    for (UpdateRecTable *table_update : uc->updates) {
+  /**
+   * wait for these ranges to complete maintenance
+   */
+  bool maintenance_needed = false;
+  for (UpdateRecTable *table_update : uc->updates) {
 
-      /*
-       * If any of the newly updated ranges needs maintenance,
-       * schedule immediately
-       */
-      for (auto iter = table_update->range_map.begin(); iter != table_update->range_map.end(); ++iter) {
-        if ((*iter).first->need_maintenance() &&
-            !Global::maintenance_queue->contains((*iter).first)) {
-          maintenance_needed = true;
-          HT_MAYBE_FAIL_X("metadata-update-and-respond", (*iter).first->is_metadata());
-          if (m_timer_handler)
-            m_timer_handler->schedule_immediate_maintenance();
-          break;
-        }
+    /*
+     * If any of the newly updated ranges needs maintenance,
+     * schedule immediately
+     */
+    for (auto iter = table_update->range_map.begin(); iter != table_update->range_map.end(); ++iter) {
+      if ((*iter).first->need_maintenance() &&
+          !Global::maintenance_queue->contains((*iter).first)) {
+        maintenance_needed = true;
+        HT_MAYBE_FAIL_X("metadata-update-and-respond", (*iter).first->is_metadata());
+        if (m_timer_handler)
+          m_timer_handler->schedule_immediate_maintenance();
+        break;
       }
+    }
 
-      for (UpdateRequest *request : table_update->requests) {
+    for (UpdateRequest *request : table_update->requests) {
 	Response::Callback::Update cb(m_context->comm, request->event);
 
-        if (table_update->error != Error::OK) {
-          if ((error = cb.error(table_update->error, table_update->error_msg)) != Error::OK)
-            HT_ERRORF("Problem sending error response - %s", Error::get_text(error));
-          continue;
-        }
+      if (table_update->error != Error::OK) {
+        if ((error = cb.error(table_update->error, table_update->error_msg)) != Error::OK)
+          HT_ERRORF("Problem sending error response - %s", Error::get_text(error));
+        continue;
+      }
 
-        if (request->error == Error::OK) {
-          /**
-           * Send back response
-           */
-          if (!request->send_back_vector.empty()) {
-            StaticBuffer ext(new uint8_t [request->send_back_vector.size() * 16],
-                             request->send_back_vector.size() * 16);
-            uint8_t *ptr = ext.base;
-            for (size_t i=0; i<request->send_back_vector.size(); i++) {
-              Serialization::encode_i32(&ptr, request->send_back_vector[i].error);
-              Serialization::encode_i32(&ptr, request->send_back_vector[i].count);
-              Serialization::encode_i32(&ptr, request->send_back_vector[i].offset);
-              Serialization::encode_i32(&ptr, request->send_back_vector[i].len);
-              /*
-                HT_INFOF("Sending back error %x, count %d, offset %d, len %d, table id %s",
-                request->send_back_vector[i].error, request->send_back_vector[i].count,
-                request->send_back_vector[i].offset, request->send_back_vector[i].len,
-                table_update->id.id);
-              */
-            }
-            if ((error = cb.response(ext)) != Error::OK)
-              HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
-          }
-          else {
-            if ((error = cb.response_ok()) != Error::OK)
-              HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
+      if (request->error == Error::OK) {
+        /**
+         * Send back response
+         */
+        if (!request->send_back_vector.empty()) {
+          StaticBuffer ext(new uint8_t [request->send_back_vector.size() * 16],
+                           request->send_back_vector.size() * 16);
+          uint8_t *ptr = ext.base;
+          for (size_t i=0; i<request->send_back_vector.size(); i++) {
+            Serialization::encode_i32(&ptr, request->send_back_vector[i].error);
+            Serialization::encode_i32(&ptr, request->send_back_vector[i].count);
+            Serialization::encode_i32(&ptr, request->send_back_vector[i].offset);
+            Serialization::encode_i32(&ptr, request->send_back_vector[i].len);
+            /*
+              HT_INFOF("Sending back error %x, count %d, offset %d, len %d, table id %s",
+              request->send_back_vector[i].error, request->send_back_vector[i].count,
+              request->send_back_vector[i].offset, request->send_back_vector[i].len,
+              table_update->id.id);
+            */
           }
+          if ((error = cb.response(ext)) != Error::OK)
+            HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
         }
         else {
-          if ((error = cb.error(request->error, "")) != Error::OK)
-            HT_ERRORF("Problem sending error response - %s", Error::get_text(error));
+          if ((error = cb.response_ok()) != Error::OK)
+            HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
         }
       }
-
+      else {
+        if ((error = cb.error(request->error, "")) != Error::OK)
+          HT_ERRORF("Problem sending error response - %s", Error::get_text(error));
+      }
     }
 
-    {
-      lock_guard<LoadStatistics> lock(*Global::load_statistics);
-      Global::load_statistics->add_update_data(uc->total_updates, uc->total_added, uc->total_bytes_added, uc->total_syncs);
-    }
+  }
 
-    delete uc;
+  {
+    lock_guard<LoadStatistics> lock(*Global::load_statistics);
+    Global::load_statistics->add_update_data(uc->total_updates, uc->total_added, uc->total_bytes_added, uc->total_syncs);
+  }
 
-    // For testing
-    if (m_maintenance_pause_interval > 0 && maintenance_needed)
-      this_thread::sleep_for(chrono::milliseconds(m_maintenance_pause_interval));
+  delete uc;
 
-  }
+  // For testing
+  if (m_maintenance_pause_interval > 0 && maintenance_needed)
+    this_thread::sleep_for(chrono::milliseconds(m_maintenance_pause_interval));
 }
 
 
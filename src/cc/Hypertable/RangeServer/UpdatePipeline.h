@@ -34,14 +34,17 @@
 
 #include <Hypertable/Lib/KeySpec.h>
 
+#include <Common/BoundedRing.h>
 #include <Common/ByteString.h>
 #include <Common/DynamicBuffer.h>
 #include <Common/Filesystem.h>
 
 #include <condition_variable>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 namespace Hypertable {
 
@@ -49,6 +52,12 @@ namespace Hypertable {
   /// @{
 
   /// Three-staged, multithreaded update pipeline.
+  /// Stage 1 qualifies updates and assigns revision numbers, and stage 2
+  /// writes them to the commit log in that order, each on a single thread.
+  /// Stage 3, which adds the committed updates to their ranges, runs on
+  /// #m_add_rings.size() threads.  Each range is assigned to one stage 3
+  /// thread by partition(), so updates to a range are added in commit order.
+  /// The stages are connected by bounded lock-free rings.
   class UpdatePipeline {
   public:
 
@@ -63,7 +72,11 @@ namespace Hypertable {
     ///     <code>Hypertable.RangeServer.UpdateDelay</code> property.
     ///   - Sets #m_max_clock_skew to the value of the
     ///     <code>Hypertable.RangeServer.ClockSkew.Max</code> property.
-    ///   - Creates and starts the three pipeline threads using
+    ///   - Creates #m_commit_ring and one ring in #m_add_rings for each of
+    ///     the <code>Hypertable.RangeServer.UpdatePipeline.Threads</code>
+    ///     stage 3 threads, with capacity
+    ///     <code>Hypertable.RangeServer.UpdatePipeline.QueueCapacity</code>.
+    ///   - Creates and starts the pipeline threads using
     ///     qualify_and_transform(), commit(), and add_and_respond() as the
     ///     thread functions, respectively.
     /// @param context %Range server context
@@ -79,8 +92,9 @@ namespace Hypertable {
     void add(UpdateContext *uc);
 
     /// Shuts down the pipeline
-    /// Sets #m_shutdown to <i>true</i>, signals the three pipeline condition
-    /// variables, and performs a join on each pipeline thread.
+    /// Sets #m_shutdown to <i>true</i>, signals #m_qualify_queue_cond,
+    /// closes the inter-stage rings, and performs a join on each pipeline
+    /// thread.
     void shutdown();
 
   private:
@@ -93,30 +107,55 @@ namespace Hypertable {
     ///     this range server.
     ///   - Transforms each key with a call to transform_key().
     ///   - Buffers the key/value pairs for downstream processing.
-    ///   - Adds the UpdateContext objects to #m_commit_queue and signals
-    ///     #m_commit_queue_cond.
+    ///   - Pushes the UpdateContext objects onto #m_commit_ring.
     void qualify_and_transform();
 
     /// Thread function for stage 2 of update pipeline.
-    /// For each UpdateContext object on the input queue #m_commit_queue, this
+    /// For each UpdateContext object on the input ring #m_commit_ring, this
     /// function does the following:
     ///   - Writes the key/value pairs that were buffered in the previous stage
     ///     to the appropriate
     ///     commit log (or transfer log) <b>without</b> calling sync().
     ///   - Once either #m_update_coalesce_limit amount of updates has been
-    ///     collected or when #m_qualify_queue becomes empty, sync() is called
+    ///     collected or when #m_commit_ring becomes empty, sync() is called
     ///     on the commit (or transfer) log.
-    ///   - Adds the UpdateContext objects to #m_response_queue and signals
-    ///     #m_response_queue_cond.
+    ///   - Passes the UpdateContext objects to stage 3 with dispatch().
     void commit();
 
+    /// Passes a committed update to stage 3.
+    /// Sets the <code>pending_partitions</code> count of <code>uc</code> to
+    /// the number of stage 3 partitions its ranges fall in and pushes it onto
+    /// the ring of each of those partitions.  An update with no ranges is
+    /// pushed onto the ring of partition 0 so that a response gets sent.
+    /// @param uc Update context
+    void dispatch(UpdateContext *uc);
+
     /// Thread function for stage 3 of update pipeline.
-    /// For each UpdateContext object on the input queue #m_response_queue, this
-    /// function does the following:
-    ///   - Adds the key/value pairs that were commited in the previous state to
-    ///     their appropriate ranges
-    ///   - Sends back a response to the originating requests
-    void add_and_respond();
+    /// For each UpdateContext object on the input ring
+    /// <code>m_add_rings[part]</code>, this function adds the key/value
+    /// pairs that were committed in the previous stage to those of their
+    /// ranges that belong to partition <code>part</code>.  The thread that
+    /// finishes an update last calls respond() for it.
+    /// @param part Partition handled by this thread
+    void add_and_respond(size_t part);
+
+    /// Completes an update once it has been added to all of its ranges.
+    /// Decrements the update counters of the ranges, schedules maintenance
+    /// if needed, sends back a response to the originating requests, and
+    /// deletes <code>uc</code>.
+    /// @param uc Update context
+    void respond(UpdateContext *uc);
+
+    /// Returns stage 3 partition of a range.
+    /// @param range %Range
+    /// @return Index into #m_add_rings
+    size_t partition(Range *range) const {
+      uint64_t h = (uint64_t)(uintptr_t)range;
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      return h % m_add_rings.size();
+    }
 
     void transform_key(ByteString &bskey, DynamicBuffer *dest_bufp,
                        int64_t revision, int64_t *revisionp,
@@ -143,26 +182,11 @@ namespace Hypertable {
     /// Stage 1 input queue
     std::list<UpdateContext *> m_qualify_queue;
 
-    /// %Mutex protecting stage 2 input queue
-    std::mutex m_commit_queue_mutex;
-
-    /// Condition variable signaling addition to stage 2 input queue
-    std::condition_variable m_commit_queue_cond;
-
-    /// Count of objects in stage 2 input queue
-    int32_t m_commit_queue_count {};
-
-    /// Stage 2 input queue
-    std::list<UpdateContext *> m_commit_queue;
-
-    /// %Mutex protecting stage 3 input queue
-    std::mutex m_response_queue_mutex;
-
-    /// Condition variable signaling addition to stage 3 input queue
-    std::condition_variable m_response_queue_cond;
+    /// Stage 2 input ring
+    std::unique_ptr<BoundedRing<UpdateContext *>> m_commit_ring;
 
-    /// Stage 3 input queue
-    std::list<UpdateContext *> m_response_queue;
+    /// Stage 3 input rings, one per partition
+    std::vector<std::unique_ptr<BoundedRing<UpdateContext *>>> m_add_rings;
 
     /// Update pipeline threads
     std::vector<std::thread> m_threads;
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+/// @file
+/// Definitions for ZeroCopyScanBlock.
+/// This file contains type definitions for ZeroCopyScanBlock, a block of scan
+/// results whose large values are sent straight out of cell store blocks and
+/// cell cache memory instead of being copied into the response.
+
+#include <Common/Compat.h>
+
+#include "ZeroCopyScanBlock.h"
+
+#include <Hypertable/RangeServer/Global.h>
+
+#include <Common/Logger.h>
+#include <Common/Serialization.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Hypertable;
+using namespace std;
+
+ZeroCopyScanBlock::ZeroCopyScanBlock(size_t min_segment_size)
+  : m_min_segment_size(min_segment_size) { }
+
+
+ZeroCopyScanBlock::~ZeroCopyScanBlock() {
+  for (auto &block : m_cached_blocks)
+    Global::block_cache->checkin(block.first, block.second);
+}
+
+
+void ZeroCopyScanBlock::pin_cached_block(int file_id, int64_t offset,
+                                         const uint8_t *base,
+                                         const uint8_t *end) {
+  if (m_ranges.count(base) || !Global::block_cache ||
+      !Global::block_cache->pin(file_id, offset))
+    return;
+  m_cached_blocks.push_back(make_pair(file_id, offset));
+  add_range(base, end);
+}
+
+
+void ZeroCopyScanBlock::pin_buffer(std::shared_ptr<uint8_t> buffer,
+                                   const uint8_t *base, const uint8_t *end) {
+  if (buffer && add_range(base, end))
+    m_buffers.push_back(buffer);
+}
+
+
+void ZeroCopyScanBlock::pin_cell_cache(CellCachePtr cell_cache) {
+  if (find(m_cell_caches.begin(), m_cell_caches.end(), cell_cache) !=
+      m_cell_caches.end())
+    return;
+  m_cell_caches.push_back(cell_cache);
+  lock_guard<CellCache> lock(*cell_cache);
+  cell_cache->arena().for_each_page([this](const uint8_t *base,
+                                           const uint8_t *end) {
+      add_range(base, end);
+    });
+}
+
+
+bool ZeroCopyScanBlock::is_pinned(const uint8_t *ptr, size_t len) {
+  if (ptr >= m_last_base && ptr + len <= m_last_end)
+    return true;
+  auto iter = m_ranges.upper_bound(ptr);
+  if (iter == m_ranges.begin())
+    return false;
+  --iter;
+  if (ptr + len > iter->second)
+    return false;
+  m_last_base = iter->first;
+  m_last_end = iter->second;
+  return true;
+}
+
+
+void ZeroCopyScanBlock::reserve(size_t len) {
+  m_copy.reserve(4 + len);
+  m_copy.ptr = m_copy.base + 4;
+  m_segments.clear();
+  m_segments.push_back({nullptr, 0, 4});
+  m_size = 4;
+  m_referenced = 0;
+}
+
+
+void ZeroCopyScanBlock::add(const uint8_t *ptr, size_t len) {
+  Segment &last = m_segments.back();
+  if (last.ptr == nullptr && last.offset + last.length == m_copy.fill())
+    last.length += len;
+  else
+    m_segments.push_back({nullptr, m_copy.fill(), len});
+  m_copy.add(ptr, len);
+  m_size += len;
+}
+
+
+void ZeroCopyScanBlock::add_value(const uint8_t *ptr, size_t len) {
+  if (len < m_min_segment_size || !is_pinned(ptr, len)) {
+    add(ptr, len);
+    return;
+  }
+  m_segments.push_back({ptr, 0, len});
+  m_size += len;
+  m_referenced += len;
+}
+
+
+void ZeroCopyScanBlock::finalize() {
+  uint8_t *ptr = m_copy.base;
+  Serialization::encode_i32(&ptr, m_size - 4);
+}
+
+
+void ZeroCopyScanBlock::append_to(CommBuf *cbuf) {
+  for (auto &segment : m_segments)
+    cbuf->append_segment(segment_base(segment), segment.length);
+  cbuf->add_hold(shared_from_this());
+}
+
+
+void ZeroCopyScanBlock::copy_to(DynamicBuffer &dbuf) {
+  dbuf.reserve(m_size);
+  for (auto &segment : m_segments)
+    dbuf.add_unchecked(segment_base(segment), segment.length);
+}
+
+
+bool ZeroCopyScanBlock::add_range(const uint8_t *base, const uint8_t *end) {
+  return m_ranges.insert(make_pair(base, end)).second;
+}
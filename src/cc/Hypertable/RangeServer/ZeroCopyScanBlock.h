@@ -0,0 +1,194 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+/// @file
+/// Declarations for ZeroCopyScanBlock.
+/// This file contains type declarations for ZeroCopyScanBlock, a block of scan
+/// results whose large values are sent straight out of cell store blocks and
+/// cell cache memory instead of being copied into the response.
+
+#ifndef Hypertable_RangeServer_ZeroCopyScanBlock_h
+#define Hypertable_RangeServer_ZeroCopyScanBlock_h
+
+#include <Hypertable/RangeServer/CellCache.h>
+
+#include <AsyncComm/CommBuf.h>
+
+#include <Common/DynamicBuffer.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace Hypertable {
+
+  /// @addtogroup RangeServer
+  /// @{
+
+  /// Block of scan results assembled as a list of memory segments.
+  /// Keys and small values are copied into an internal buffer as they are in
+  /// FillScanBlock(), but values of at least the minimum segment size that lie
+  /// in pinned memory are recorded as references.  Memory is pinned by the
+  /// scanners through CellListScanner::pin_blocks(): cached cell store blocks
+  /// are held with FileBlockCache::pin(), privately read blocks and cell
+  /// caches by reference count.  The pins are released when the block is
+  /// destroyed, which happens once the CommBuf built by append_to() has been
+  /// written to the socket.  The serialized form (32-bit length followed by
+  /// key/value pairs) is identical to the one produced by FillScanBlock().
+  class ZeroCopyScanBlock
+    : public std::enable_shared_from_this<ZeroCopyScanBlock> {
+  public:
+
+    /// Constructor.
+    /// @param min_segment_size Smallest value that will be referenced rather
+    /// than copied
+    ZeroCopyScanBlock(size_t min_segment_size);
+
+    /// Destructor.
+    /// Checks in blocks pinned with pin_cached_block().
+    ~ZeroCopyScanBlock();
+
+    /// Pins a block checked out of Global::block_cache.
+    /// @param file_id File ID of block
+    /// @param offset File offset of block
+    /// @param base Beginning of uncompressed block
+    /// @param end End of uncompressed block
+    void pin_cached_block(int file_id, int64_t offset, const uint8_t *base,
+                          const uint8_t *end);
+
+    /// Pins a privately owned block.
+    /// @param buffer Shared pointer owning block memory
+    /// @param base Beginning of block
+    /// @param end End of block
+    void pin_buffer(std::shared_ptr<uint8_t> buffer, const uint8_t *base,
+                    const uint8_t *end);
+
+    /// Pins the pages of a cell cache arena.
+    /// Pages allocated after this call are not covered, so values added to the
+    /// cache concurrently are copied.
+    /// @param cell_cache Cell cache to pin
+    void pin_cell_cache(CellCachePtr cell_cache);
+
+    /// Checks if a memory region lies within pinned memory.
+    /// @param ptr Beginning of region
+    /// @param len Length of region
+    /// @return <i>true</i> if region is pinned, <i>false</i> otherwise
+    bool is_pinned(const uint8_t *ptr, size_t len);
+
+    /// Begins a new block.
+    /// Reserves the 32-bit length field and space for <code>len</code> bytes
+    /// of copied data.
+    /// @param len Amount of data to reserve
+    void reserve(size_t len);
+
+    /// Appends a copy of a memory region.
+    /// @param ptr Beginning of region
+    /// @param len Length of region
+    void add(const uint8_t *ptr, size_t len);
+
+    /// Appends a value.
+    /// The value is referenced if it is at least the minimum segment size and
+    /// lies in pinned memory, otherwise it is copied.
+    /// @param ptr Beginning of value
+    /// @param len Length of value
+    void add_value(const uint8_t *ptr, size_t len);
+
+    /// Writes the length field at the beginning of the block.
+    void finalize();
+
+    /// Returns serialized size of block, including the length field.
+    size_t size() const { return m_size; }
+
+    /// Returns number of bytes that are referenced rather than copied.
+    size_t referenced() const { return m_referenced; }
+
+    /// Appends the block to a CommBuf as a list of segments.
+    /// The CommBuf holds a reference to this object until it is destroyed.
+    /// @param cbuf CommBuf to append to
+    void append_to(CommBuf *cbuf);
+
+    /// Copies the serialized block into a contiguous buffer.
+    /// @param dbuf Buffer to copy into
+    void copy_to(DynamicBuffer &dbuf);
+
+  private:
+
+    /// Segment of serialized block.
+    /// If #ptr is null, the segment lies in #m_copy at #offset.
+    struct Segment {
+      const uint8_t *ptr;
+      size_t offset;
+      size_t length;
+    };
+
+    /// Returns pointer to beginning of segment
+    const uint8_t *segment_base(const Segment &segment) const {
+      return segment.ptr ? segment.ptr : m_copy.base + segment.offset;
+    }
+
+    /// Records a pinned memory region
+    bool add_range(const uint8_t *base, const uint8_t *end);
+
+    /// Smallest value that is referenced rather than copied
+    size_t m_min_segment_size;
+
+    /// Buffer holding copied data
+    DynamicBuffer m_copy;
+
+    /// Segments of serialized block
+    std::vector<Segment> m_segments;
+
+    /// Pinned memory regions (beginning to end)
+    std::map<const uint8_t *, const uint8_t *> m_ranges;
+
+    /// Beginning of most recently matched region
+    const uint8_t *m_last_base {};
+
+    /// End of most recently matched region
+    const uint8_t *m_last_end {};
+
+    /// File ID and offset of blocks pinned in block cache
+    std::vector<std::pair<int, int64_t>> m_cached_blocks;
+
+    /// Privately owned blocks
+    std::vector<std::shared_ptr<uint8_t>> m_buffers;
+
+    /// Pinned cell caches
+    std::vector<CellCachePtr> m_cell_caches;
+
+    /// Serialized size of block
+    size_t m_size {};
+
+    /// Number of bytes referenced rather than copied
+    size_t m_referenced {};
+  };
+
+  /// Shared smart pointer to ZeroCopyScanBlock
+  typedef std::shared_ptr<ZeroCopyScanBlock> ZeroCopyScanBlockPtr;
+
+  /// @}
+
+}
+
+#endif // Hypertable_RangeServer_ZeroCopyScanBlock_h
@@ -22,10 +22,12 @@
 #include <Common/Compat.h>
 
 #include <Hypertable/RangeServer/CellStore.h>
+#include <Hypertable/RangeServer/CellStoreBlockStreams.h>
 #include <Hypertable/RangeServer/CellStoreFactory.h>
 #include <Hypertable/RangeServer/CellStoreTrailerV7.h>
 #include <Hypertable/RangeServer/Config.h>
 #include <Hypertable/RangeServer/Global.h>
+#include <Hypertable/RangeServer/KeyDecompressorDelta.h>
 #include <Hypertable/RangeServer/KeyDecompressorPrefix.h>
 
 #include "Hypertable/Lib/BlockHeaderCellStore.h"
@@ -42,6 +44,7 @@
 #include <Common/BloomFilterWithChecksum.h>
 #include <Common/ByteString.h>
 #include <Common/Checksum.h>
+#include <Common/Filesystem.h>
 #include <Common/InetAddr.h>
 #include <Common/Init.h>
 #include <Common/Logger.h>
@@ -95,7 +98,8 @@ namespace {
 
   class State {
   public:
-    State() : block_index_is_bad(false), bloom_filter_is_bad(false) { }
+    State() : block_index_is_bad(false), bloom_filter_is_bad(false),
+              value_streams(false) { }
     String fname;
     uint8_t *base;
     uint8_t *end;
@@ -107,6 +111,7 @@ namespace {
     KeyDecompressor *key_decompressor;
     bool block_index_is_bad;
     bool bloom_filter_is_bad;
+    bool value_streams;
     uint16_t block_header_format;
   };
 
@@ -116,6 +121,10 @@ namespace {
     { 'I','d','x','F','i','x','-','-','-','-' };
   const char INDEX_VARIABLE_BLOCK_MAGIC[10] =
     { 'I','d','x','V','a','r','-','-','-','-' };
+  const char INDEX_SUMMARY_BLOCK_MAGIC[10]  =
+    { 'I','d','x','S','u','m','-','-','-','-' };
+  const char DICTIONARY_BLOCK_MAGIC[10]     =
+    { 'D','i','c','t','-','-','-','-','-','-' };
 
   void load_file(const String &fname, State &state) {
     int64_t length = Global::dfs->length(fname.c_str());
@@ -156,7 +165,14 @@ namespace {
 
     uint16_t compression_type = boost::any_cast<uint16_t>(state.trailer->get("compression_type"));
     state.compressor = CompressorFactory::create_block_codec((BlockCompressionCodec::Type)compression_type);
-    state.key_decompressor = new KeyDecompressorPrefix();
+    boost::any key_compression_scheme = state.trailer->get("key_compression_scheme");
+    if (!key_compression_scheme.empty() &&
+        boost::any_cast<uint16_t>(key_compression_scheme) == KeyCompressionType::DELTA)
+      state.key_decompressor = new KeyDecompressorDelta();
+    else
+      state.key_decompressor = new KeyDecompressorPrefix();
+    uint32_t flags = boost::any_cast<uint32_t>(state.trailer->get("flags"));
+    state.value_streams = (flags & CellStoreTrailerV7::VALUE_STREAMS) != 0;
   }
   
 
@@ -221,6 +237,32 @@ namespace {
       state.index_block_info[i].rowkey = (char *)key.row();
     }
 
+    // The data blocks are compressed with the dictionary that follows the
+    // variable index and block summaries
+    if (flags & CellStoreTrailerV7::DICTIONARY) {
+      DynamicBuffer block_buf;
+      int64_t offset = var_index_offset;
+      while (!header.check_magic(DICTIONARY_BLOCK_MAGIC)) {
+        if (!header.check_magic(INDEX_VARIABLE_BLOCK_MAGIC) &&
+            !header.check_magic(INDEX_SUMMARY_BLOCK_MAGIC)) {
+          cout << "corrupt block summaries" << endl;
+          quick_exit(EXIT_FAILURE);
+        }
+        offset += header.encoded_length() + header.get_data_zlength();
+        if (!HT_IO_ALIGNED(offset))
+          offset += HT_IO_ALIGNMENT_PADDING(offset);
+        if (offset >= filter_offset) {
+          cout << "missing dictionary" << endl;
+          quick_exit(EXIT_FAILURE);
+        }
+        input_buf.base = state.base + offset;
+        input_buf.ptr = state.base + filter_offset;
+        block_buf.clear();
+        state.compressor->inflate(input_buf, block_buf, header);
+      }
+      state.compressor->set_dictionary(state.compressor->load_dictionary(block_buf.base, block_buf.fill()));
+    }
+
   }
 
   void read_bloom_filter(State &state) {
@@ -229,6 +271,7 @@ namespace {
     int64_t filter_items_actual = boost::any_cast<int64_t>(state.trailer->get("filter_items_actual"));
     uint8_t bloom_filter_hash_count = boost::any_cast<uint8_t>(state.trailer->get("bloom_filter_hash_count"));
     uint8_t bloom_filter_mode = boost::any_cast<uint8_t>(state.trailer->get("bloom_filter_mode"));
+    uint32_t flags = boost::any_cast<uint32_t>(state.trailer->get("flags"));
 
     if ((BloomFilterMode)bloom_filter_mode == BLOOM_FILTER_DISABLED) {
       state.bloom_filter = 0;
@@ -242,8 +285,12 @@ namespace {
 
     HT_ASSERT((BloomFilterMode)bloom_filter_mode == BLOOM_FILTER_ROWS);
 
+    BloomFilterLayout layout =
+      (flags & CellStoreTrailerV7::BLOCKED_BLOOM_FILTER) ?
+      BLOOM_FILTER_LAYOUT_BLOCKED : BLOOM_FILTER_LAYOUT_CLASSIC;
     state.bloom_filter = new BloomFilterWithChecksum(filter_items_actual, filter_items_actual,
-                                                     filter_length, bloom_filter_hash_count);
+                                                     filter_length, bloom_filter_hash_count,
+                                                     layout);
     memcpy(state.bloom_filter->base(), state.base+filter_offset, state.bloom_filter->total_size());
     try {
       state.bloom_filter->validate(state.fname);
@@ -295,6 +342,9 @@ namespace {
       input_buf.ptr += header.get_data_zlength() + extra;
       state.compressor->inflate(input_buf, expand_buf, header);
 
+      if (state.value_streams)
+        CellStoreBlockStreams::decode(expand_buf);
+
       // call functor
       if (!op(sequence, offset, expand_buf))
         return false;
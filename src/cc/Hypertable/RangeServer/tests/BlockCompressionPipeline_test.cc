@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hypertable/RangeServer/BlockCompressionPipeline.h>
+#include <Hypertable/RangeServer/CellStore.h>
+
+#include <Hypertable/Lib/BlockHeaderCellStore.h>
+#include <Hypertable/Lib/CompressorFactory.h>
+
+#include <Common/DynamicBuffer.h>
+#include <Common/Init.h>
+#include <Common/Logger.h>
+#include <Common/Random.h>
+#include <Common/Stopwatch.h>
+#include <Common/Usage.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *usage[] = {
+    "usage: BlockCompressionPipeline_test [--blocks=<n>] [--threads=<n>]",
+    "                                     [--codec=<spec>]",
+    "",
+    "  This program compresses a sequence of CellStore blocks inline and with",
+    "  a BlockCompressionPipeline, verifies that the pipeline returns blocks",
+    "  in submission order with output identical to inline compression and",
+    "  that each block inflates to its input, and reports the throughput of",
+    "  both methods.  Codecs that use a dictionary are given one trained on",
+    "  the first blocks.",
+    (const char *)0
+  };
+
+  const char *words[] = {
+    "hypertable", "range", "server", "cell", "store", "block", "index",
+    "compaction", "bloom", "filter", "commit", "log", "master", "table",
+    "row", "column", "family", "qualifier", "timestamp", "revision"
+  };
+
+  /// Fills buf with blocksize bytes of moderately compressible text
+  void fill_block(DynamicBuffer &buf, size_t blocksize) {
+    char numbuf[16];
+    buf.clear();
+    buf.reserve(blocksize);
+    while (buf.fill() < blocksize) {
+      const char *word = words[Random::number32() % (sizeof(words)/sizeof(char *))];
+      size_t len = std::min(strlen(word), blocksize - buf.fill());
+      buf.add_unchecked(word, len);
+      if (buf.fill() < blocksize && Random::number32() % 4 == 0) {
+        sprintf(numbuf, "%u", (unsigned)Random::number32());
+        len = std::min(strlen(numbuf), blocksize - buf.fill());
+        buf.add_unchecked(numbuf, len);
+      }
+    }
+  }
+
+  void verify_block(BlockCompressionCodec *codec, DynamicBuffer &zbuf,
+                    DynamicBuffer &expected) {
+    BlockHeaderCellStore header;
+    DynamicBuffer input(0, false);
+    DynamicBuffer output;
+    input.base = zbuf.base;
+    input.ptr = zbuf.ptr;
+    input.size = zbuf.size;
+    codec->inflate(input, output, header);
+    HT_ASSERT(header.check_magic(CellStore::DATA_BLOCK_MAGIC));
+    HT_ASSERT(output.fill() == expected.fill());
+    HT_ASSERT(memcmp(output.base, expected.base, expected.fill()) == 0);
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  size_t block_count = 2000;
+  size_t threads = 4;
+  size_t blocksize = 64*1024;
+  String codec_spec = "zlib";
+
+  for (int i=1; i<argc; i++) {
+    if (!strncmp(argv[i], "--blocks=", 9))
+      block_count = (size_t)atoi(&argv[i][9]);
+    else if (!strncmp(argv[i], "--threads=", 10))
+      threads = (size_t)atoi(&argv[i][10]);
+    else if (!strncmp(argv[i], "--codec=", 8))
+      codec_spec = &argv[i][8];
+    else if (!strcmp(argv[i], "--help"))
+      Usage::dump_and_exit(usage);
+  }
+
+  try {
+    BlockCompressionCodec::Args args;
+    BlockCompressionCodec::Type type =
+      CompressorFactory::parse_block_codec_spec(codec_spec, args);
+    unique_ptr<BlockCompressionCodec>
+      codec(CompressorFactory::create_block_codec(type, args));
+    vector<DynamicBuffer> blocks(block_count);
+    vector<DynamicBuffer> inline_output(block_count);
+    DynamicBuffer buf;
+    size_t input_bytes {}, compressed_bytes {};
+
+    for (auto &block : blocks) {
+      fill_block(block, blocksize + Random::number32() % 1024);
+      input_bytes += block.fill();
+    }
+
+    // Train a dictionary on the first blocks, as the CellStore writer does
+    BlockCompressionCodec::DictionaryPtr dictionary;
+    if (codec->dictionary_training_size()) {
+      DynamicBuffer samples;
+      vector<size_t> sample_sizes;
+      for (auto &block : blocks) {
+        if (samples.fill() >= codec->dictionary_training_size())
+          break;
+        samples.add(block.base, block.fill());
+        sample_sizes.push_back(block.fill());
+      }
+      dictionary = codec->train_dictionary(samples.base, sample_sizes);
+      HT_ASSERT(dictionary);
+      codec->set_dictionary(dictionary);
+    }
+
+    // Inline compression
+    Stopwatch inline_timer;
+    for (size_t i=0; i<block_count; i++) {
+      BlockHeaderCellStore header(1, CellStore::DATA_BLOCK_MAGIC);
+      codec->deflate(blocks[i], inline_output[i], header,
+                     HT_DIRECT_IO_ALIGNMENT);
+      compressed_bytes += inline_output[i].fill();
+    }
+    inline_timer.stop();
+
+    // Pipelined compression, popping blocks as they're ready the way the
+    // CellStore writer does
+    DynamicBuffer zbuf;
+    size_t popped {};
+    Stopwatch pipeline_timer;
+    {
+      BlockCompressionPipeline pipeline(type, args, threads, 2*threads);
+      if (dictionary)
+        pipeline.set_dictionary(dictionary);
+      for (size_t i=0; i<=block_count; i++) {
+        while ((i == block_count && pipeline.outstanding() > 0) ||
+               pipeline.full() || pipeline.ready()) {
+          size_t uncompressed_length = pipeline.pop(zbuf);
+          HT_ASSERT(uncompressed_length == blocks[popped].fill());
+          HT_ASSERT(zbuf.fill() == inline_output[popped].fill());
+          HT_ASSERT(memcmp(zbuf.base, inline_output[popped].base,
+                           zbuf.fill()) == 0);
+          popped++;
+        }
+        if (i == block_count)
+          break;
+        buf.clear();
+        buf.reserve(blocks[i].fill());
+        buf.add_unchecked(blocks[i].base, blocks[i].fill());
+        pipeline.submit(buf, 1, CellStore::DATA_BLOCK_MAGIC);
+      }
+    }
+    pipeline_timer.stop();
+    HT_ASSERT(popped == block_count);
+
+    // Verify with a codec that loads the dictionary the way readers do
+    unique_ptr<BlockCompressionCodec>
+      reader_codec(CompressorFactory::create_block_codec(type));
+    if (dictionary)
+      reader_codec->set_dictionary(reader_codec->load_dictionary(
+          (const uint8_t *)dictionary->data().data(),
+          dictionary->data().length()));
+    for (size_t i=0; i<block_count; i++)
+      verify_block(reader_codec.get(), inline_output[i], blocks[i]);
+
+    double mb = (double)input_bytes / (1024.0*1024.0);
+    cout << block_count << " blocks, " << input_bytes << " bytes compressed to "
+         << compressed_bytes << " bytes with " << codec_spec << endl;
+    cout << "inline:   " << mb / inline_timer.elapsed() << " MB/s" << endl;
+    cout << "pipeline: " << mb / pipeline_timer.elapsed() << " MB/s ("
+         << threads << " threads)" << endl;
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
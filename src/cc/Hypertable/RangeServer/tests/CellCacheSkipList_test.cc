@@ -0,0 +1,347 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hypertable/RangeServer/CellCache.h>
+#include <Hypertable/RangeServer/CellCacheSkipList.h>
+#include <Hypertable/RangeServer/Global.h>
+#include <Hypertable/RangeServer/MemoryTracker.h>
+#include <Hypertable/RangeServer/ScanContext.h>
+
+#include <Hypertable/Lib/Key.h>
+#include <Hypertable/Lib/RangeSpec.h>
+#include <Hypertable/Lib/ScanSpec.h>
+#include <Hypertable/Lib/Schema.h>
+
+#include <Common/Config.h>
+#include <Common/DynamicBuffer.h>
+#include <Common/Init.h>
+#include <Common/Random.h>
+#include <Common/Serialization.h>
+#include <Common/Stopwatch.h>
+#include <Common/Usage.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *usage[] = {
+    "usage: CellCacheSkipList_test [--count=<n>] [--readers=<n>]",
+    "",
+    "  This program verifies that CellCacheSkipList returns the same cells",
+    "  as the map based CellCache, that concurrent scanners see a sorted",
+    "  stream that stays within the scanned row interval while a writer is",
+    "  inserting, that counter increments added while scanners read them",
+    "  sum to the same totals, and reports insert and scan throughput of",
+    "  both implementations.",
+    (const char *)0
+  };
+
+  const char *schema_str =
+  "<Schema>\n"
+  "  <AccessGroup name=\"default\">\n"
+  "    <ColumnFamily id=\"1\">\n"
+  "      <Name>tag</Name>\n"
+  "    </ColumnFamily>\n"
+  "  </AccessGroup>\n"
+  "</Schema>";
+
+  void generate_keys(DynamicBuffer &dbuf, vector<Key> &keys, size_t count) {
+    char rowbuf[32], qualbuf[16];
+    vector<size_t> offsets;
+    offsets.reserve(count);
+    for (size_t i=0; i<count; i++) {
+      sprintf(rowbuf, "row%012u", (unsigned)Random::number32());
+      sprintf(qualbuf, "q%u", (unsigned)(i % 8));
+      offsets.push_back(dbuf.fill());
+      create_key_and_append(dbuf, FLAG_INSERT, rowbuf, 1, qualbuf,
+                            (int64_t)i+1, (int64_t)i+1);
+    }
+    // dbuf may have been reallocated, so resolve pointers after the fact
+    keys.resize(count);
+    for (size_t i=0; i<count; i++)
+      keys[i].load(SerializedKey(dbuf.base + offsets[i]));
+  }
+
+  double insert_keys(CellCachePtr &cache, vector<Key> &keys,
+                     ByteString value) {
+    Stopwatch stopwatch;
+    for (auto &key : keys) {
+      cache->lock();
+      cache->add(key, value);
+      cache->unlock();
+    }
+    stopwatch.stop();
+    return stopwatch.elapsed();
+  }
+
+  size_t scan(CellCachePtr &cache, ScanContext *scan_ctx,
+              vector<SerializedKey> *result) {
+    Key key;
+    ByteString value;
+    size_t count {};
+    CellListScannerPtr scanner = cache->create_scanner(scan_ctx);
+    while (scanner->get(key, value)) {
+      if (result)
+        result->push_back(key.serial);
+      count++;
+      scanner->forward();
+    }
+    return count;
+  }
+
+  /// Adds <code>count</code> increments of one to each of a few counters,
+  /// while readers check that every counter value they see is well formed
+  void test_counters(CellCachePtr &cache, ScanContext *scan_ctx,
+                     size_t count, int readers, vector<int64_t> &totals) {
+    const char *rows[] = { "counter-a", "counter-b", "counter-c" };
+    atomic<bool> done {};
+    vector<thread> threads;
+    for (int i=0; i<readers; i++)
+      threads.push_back(thread([&]() {
+            Key key;
+            ByteString val;
+            while (!done) {
+              CellListScannerPtr scanner = cache->create_scanner(scan_ctx);
+              while (scanner->get(key, val)) {
+                const uint8_t *ptr = val.ptr;
+                size_t remaining = 8;
+                HT_ASSERT(*ptr++ == 8);
+                int64_t n = (int64_t)Serialization::decode_i64(&ptr, &remaining);
+                HT_ASSERT(n > 0 && n <= (int64_t)count);
+                scanner->forward();
+              }
+            }
+          }));
+    uint8_t valuebuf[16];
+    valuebuf[0] = 8;
+    uint8_t *ptr = &valuebuf[1];
+    Serialization::encode_i64(&ptr, 1);
+    DynamicBuffer kbuf;
+    Key key;
+    for (size_t i=0; i<count; i++) {
+      for (auto row : rows) {
+        kbuf.clear();
+        create_key_and_append(kbuf, FLAG_INSERT, row, 1, "",
+                              (int64_t)i+1, (int64_t)i+1);
+        key.load(SerializedKey(kbuf.base));
+        cache->lock();
+        cache->add_counter(key, ByteString(valuebuf));
+        cache->unlock();
+      }
+    }
+    done = true;
+    for (auto &t : threads)
+      t.join();
+
+    // Sum each counter as the merge scanner would
+    Key key2;
+    ByteString val;
+    totals.clear();
+    CellListScannerPtr scanner = cache->create_scanner(scan_ctx);
+    const char *last_row = nullptr;
+    while (scanner->get(key2, val)) {
+      if (last_row == nullptr || strcmp(last_row, key2.row)) {
+        totals.push_back(0);
+        last_row = key2.row;
+      }
+      const uint8_t *vptr = val.ptr + 1;
+      size_t remaining = 8;
+      totals.back() += (int64_t)Serialization::decode_i64(&vptr, &remaining);
+      scanner->forward();
+    }
+  }
+
+  void report(const char *label, size_t count, double elapsed) {
+    cout << label << ": " << count << " cells in " << elapsed << "s ("
+         << (size_t)((double)count / elapsed) << " cells/s)" << endl;
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  size_t count = 200000;
+  int readers = 4;
+
+  for (int i=1; i<argc; i++) {
+    if (!strncmp(argv[i], "--count=", 8))
+      count = (size_t)atoi(&argv[i][8]);
+    else if (!strncmp(argv[i], "--readers=", 10))
+      readers = atoi(&argv[i][10]);
+    else if (!strcmp(argv[i], "--help"))
+      Usage::dump_and_exit(usage);
+  }
+
+  try {
+    Config::init(0, 0);
+    Global::memory_tracker = new MemoryTracker(0, 0);
+    Global::cell_cache_scanner_cache_size = 1024;
+
+    SchemaPtr schema(Schema::new_instance(schema_str));
+    ScanContextPtr scan_ctx = make_shared<ScanContext>(schema);
+
+    DynamicBuffer dbuf(count * 48);
+    vector<Key> keys;
+    generate_keys(dbuf, keys, count);
+
+    const char *value_str = "All work and no play makes jack a dull boy.";
+    uint8_t valuebuf[64];
+    uint8_t *uptr = valuebuf;
+    Serialization::encode_vi32(&uptr, strlen(value_str));
+    strcpy((char *)uptr, value_str);
+    ByteString value(valuebuf);
+
+    CellCachePtr map_cache = make_shared<CellCache>();
+    CellCachePtr skip_cache = make_shared<CellCacheSkipList>();
+
+    report("map insert", count, insert_keys(map_cache, keys, value));
+    report("skiplist insert", count, insert_keys(skip_cache, keys, value));
+
+    vector<SerializedKey> map_result, skip_result;
+    Stopwatch stopwatch;
+    scan(map_cache, scan_ctx.get(), &map_result);
+    stopwatch.stop();
+    report("map scan", map_result.size(), stopwatch.elapsed());
+
+    stopwatch.reset();
+    stopwatch.start();
+    scan(skip_cache, scan_ctx.get(), &skip_result);
+    stopwatch.stop();
+    report("skiplist scan", skip_result.size(), stopwatch.elapsed());
+
+    HT_ASSERT(map_cache->size() == skip_cache->size());
+    HT_ASSERT(map_result.size() == skip_result.size());
+    for (size_t i=0; i<map_result.size(); i++)
+      HT_ASSERT(map_result[i] == skip_result[i]);
+
+    // Concurrent scans against a cache receiving inserts
+    DynamicBuffer dbuf2(count * 48);
+    vector<Key> keys2;
+    generate_keys(dbuf2, keys2, count);
+    for (auto type : { "map", "skiplist" }) {
+      CellCachePtr cache = strcmp(type, "map") ? skip_cache : map_cache;
+      atomic<bool> done {};
+      atomic<size_t> scanned {};
+      vector<thread> threads;
+      stopwatch.reset();
+      stopwatch.start();
+      for (int i=0; i<readers; i++)
+        threads.push_back(thread([&]() {
+              Key key;
+              ByteString val;
+              while (!done) {
+                SerializedKey last;
+                CellListScannerPtr scanner = cache->create_scanner(scan_ctx.get());
+                while (scanner->get(key, val)) {
+                  HT_ASSERT(last.ptr == 0 || last < key.serial);
+                  last = key.serial;
+                  scanned++;
+                  scanner->forward();
+                }
+              }
+            }));
+      double elapsed = insert_keys(cache, keys2, value);
+      done = true;
+      for (auto &t : threads)
+        t.join();
+      stopwatch.stop();
+      cout << type << " concurrent: " << count << " inserts in " << elapsed
+           << "s, " << scanned << " cells scanned by " << readers
+           << " readers (" << (size_t)((double)scanned / stopwatch.elapsed())
+           << " cells/s)" << endl;
+    }
+    HT_ASSERT(map_cache->size() == skip_cache->size());
+
+    // Concurrent scans of a row interval against a cache receiving inserts
+    // on both sides of it
+    {
+      ScanSpecBuilder ssbuilder;
+      ssbuilder.add_row_interval("row001000000000", true,
+                                 "row002000000000", false);
+      RangeSpec range("", Key::END_ROW_MARKER);
+      ScanContextPtr interval_ctx =
+        make_shared<ScanContext>(TIMESTAMP_MAX, &(ssbuilder.get()), &range,
+                                 schema);
+      CellCachePtr cache = make_shared<CellCacheSkipList>();
+      DynamicBuffer dbuf3(count * 48);
+      vector<Key> keys3;
+      generate_keys(dbuf3, keys3, count);
+      atomic<bool> done {};
+      atomic<size_t> scanned {};
+      vector<thread> threads;
+      for (int i=0; i<readers; i++)
+        threads.push_back(thread([&]() {
+              Key key;
+              ByteString val;
+              while (!done) {
+                CellListScannerPtr scanner =
+                  cache->create_scanner(interval_ctx.get());
+                while (scanner->get(key, val)) {
+                  HT_ASSERT(strcmp(key.row, "row001000000000") >= 0);
+                  HT_ASSERT(strcmp(key.row, "row002000000000") < 0);
+                  scanned++;
+                  scanner->forward();
+                }
+              }
+            }));
+      insert_keys(cache, keys3, value);
+      done = true;
+      for (auto &t : threads)
+        t.join();
+      size_t expected = 0;
+      for (auto &key : keys3)
+        if (strcmp(key.row, "row001000000000") >= 0 &&
+            strcmp(key.row, "row002000000000") < 0)
+          expected++;
+      HT_ASSERT(scan(cache, interval_ctx.get(), 0) == expected);
+    }
+
+    // Counter increments read concurrently
+    {
+      vector<int64_t> map_totals, skip_totals;
+      CellCachePtr map_counters = make_shared<CellCache>();
+      CellCachePtr skip_counters = make_shared<CellCacheSkipList>();
+      size_t increments = count / 10;
+      test_counters(map_counters, scan_ctx.get(), increments, readers,
+                    map_totals);
+      test_counters(skip_counters, scan_ctx.get(), increments, readers,
+                    skip_totals);
+      HT_ASSERT(map_totals.size() == 3 && map_totals == skip_totals);
+      for (auto total : skip_totals)
+        HT_ASSERT(total == (int64_t)increments);
+    }
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hypertable/RangeServer/CellStoreBlockIndexArray.h>
+
+#include <Hypertable/Lib/Key.h>
+#include <Hypertable/Lib/SerializedKey.h>
+
+#include <Common/DynamicBuffer.h>
+#include <Common/Logger.h>
+#include <Common/Random.h>
+#include <Common/Stopwatch.h>
+#include <Common/Usage.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *usage[] = {
+    "usage: CellStoreBlockIndexArray_test [--entries=<n>] [--seeks=<n>]",
+    "",
+    "  This program loads a CellStore block index of <entries> entries, checks",
+    "  that lower_bound() and upper_bound() agree with a plain binary search",
+    "  of the index entries for keys in, between, before and after them, and",
+    "  reports the seek rate of both.",
+    (const char *)0
+  };
+
+  const int64_t BLOCK_SIZE = 65536;
+
+  /// Generates the keys and offsets of a block index, one entry per block
+  void generate_index(size_t count, DynamicBuffer &fixed,
+                      DynamicBuffer &variable) {
+    char rowbuf[64], qualbuf[32];
+    uint32_t row = 0;
+
+    fixed.reserve(count * sizeof(int64_t));
+    variable.reserve(count * 64);
+    for (size_t i=0; i<count; i++) {
+      row += 1 + Random::number32() % 16;
+      sprintf(rowbuf, "com.example.www/%08u/index.html", (unsigned)row);
+      sprintf(qualbuf, "q%02u", (unsigned)(Random::number32() % 100));
+      create_key_and_append(variable, FLAG_INSERT, rowbuf, 1, qualbuf,
+                            (int64_t)i, (int64_t)i);
+      int64_t offset = (int64_t)i * BLOCK_SIZE;
+      fixed.add_unchecked(&offset, sizeof(offset));
+    }
+  }
+
+  /// Generates probe keys: copies of index keys, keys just before and after
+  /// them, and keys before the first and after the last
+  void generate_probes(vector<SerializedKey> &keys, size_t count,
+                       DynamicBuffer &probes, vector<size_t> &offsets) {
+    char rowbuf[64];
+    Key key;
+
+    probes.reserve(count * 64);
+    for (size_t i=0; i<count; i++) {
+      offsets.push_back(probes.fill());
+      key.load(keys[Random::number32() % keys.size()]);
+      switch (Random::number32() % 5) {
+      case 0:
+        create_key_and_append(probes, key.flag, key.row,
+                              key.column_family_code, key.column_qualifier,
+                              key.timestamp, key.revision);
+        break;
+      case 1:
+        sprintf(rowbuf, "%s0", key.row);
+        create_key_and_append(probes, FLAG_INSERT, rowbuf, 1, "", 0, 0);
+        break;
+      case 2:
+        create_key_and_append(probes, FLAG_INSERT, key.row, 0, "", 0, 0);
+        break;
+      case 3:
+        create_key_and_append(probes, FLAG_INSERT, "com.example", 1, "", 0, 0);
+        break;
+      default:
+        create_key_and_append(probes, FLAG_INSERT, "zzz", 1, "", 0, 0);
+        break;
+      }
+    }
+  }
+
+  typedef CellStoreBlockIndexArray<int64_t> IndexT;
+  typedef CellStoreBlockIndexElementArray<int64_t> ElementT;
+  typedef LtCellStoreBlockIndexElementArray<int64_t> LtT;
+
+  /// Returns offset of iterator position, or -1 for end
+  int64_t offset_of(IndexT &index, IndexT::iterator iter) {
+    return (iter == index.end()) ? -1 : iter.value();
+  }
+
+  int64_t offset_of(vector<ElementT> &elements,
+                    vector<ElementT>::iterator iter) {
+    return (iter == elements.end()) ? -1 : iter->offset;
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  size_t entry_count = 1000000;
+  size_t seek_count = 1000000;
+
+  for (int i=1; i<argc; i++) {
+    if (!strncmp(argv[i], "--entries=", 10))
+      entry_count = (size_t)atoi(&argv[i][10]);
+    else if (!strncmp(argv[i], "--seeks=", 8))
+      seek_count = (size_t)atoi(&argv[i][8]);
+    else if (!strcmp(argv[i], "--help"))
+      Usage::dump_and_exit(usage);
+  }
+
+  try {
+    DynamicBuffer fixed, variable;
+    DynamicBuffer probes;
+    vector<size_t> probe_offsets;
+    vector<SerializedKey> probe_keys;
+    IndexT index;
+
+    generate_index(entry_count, fixed, variable);
+    index.load(fixed, variable, (int64_t)entry_count * BLOCK_SIZE);
+    HT_ASSERT(index.index_entries() == (int64_t)entry_count);
+
+    // Plain sorted array of the loaded entries, searched as the index used
+    // to be
+    vector<ElementT> elements;
+    vector<SerializedKey> keys;
+    for (IndexT::iterator iter = index.begin(); iter != index.end(); ++iter) {
+      ElementT element(iter.key());
+      element.offset = iter.value();
+      elements.push_back(element);
+      keys.push_back(iter.key());
+    }
+
+    generate_probes(keys, seek_count, probes, probe_offsets);
+    for (auto offset : probe_offsets)
+      probe_keys.push_back(SerializedKey(probes.base + offset));
+
+    for (auto &key : probe_keys) {
+      ElementT ee(key);
+      HT_ASSERT(offset_of(index, index.lower_bound(key)) ==
+                offset_of(elements, std::lower_bound(elements.begin(),
+                                                     elements.end(), ee, LtT())));
+      HT_ASSERT(offset_of(index, index.upper_bound(key)) ==
+                offset_of(elements, std::upper_bound(elements.begin(),
+                                                     elements.end(), ee, LtT())));
+    }
+
+    int64_t checksum {}, expected_checksum {};
+    Stopwatch binary_timer;
+    for (auto &key : probe_keys) {
+      ElementT ee(key);
+      expected_checksum += offset_of(elements,
+                                     std::lower_bound(elements.begin(),
+                                                      elements.end(), ee, LtT()));
+    }
+    binary_timer.stop();
+
+    Stopwatch index_timer;
+    for (auto &key : probe_keys)
+      checksum += offset_of(index, index.lower_bound(key));
+    index_timer.stop();
+    HT_ASSERT(checksum == expected_checksum);
+
+    cout << entry_count << " index entries, " << index.memory_used()
+         << " bytes" << endl;
+    cout << "binary search: " << (double)seek_count / binary_timer.elapsed()
+         << " seeks/s" << endl;
+    cout << "index search:  " << (double)seek_count / index_timer.elapsed()
+         << " seeks/s" << endl;
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hypertable/RangeServer/CellStoreBlockSummaries.h>
+#include <Hypertable/RangeServer/ScanContext.h>
+
+#include <Hypertable/Lib/Key.h>
+
+#include <Common/DynamicBuffer.h>
+#include <Common/Logger.h>
+#include <Common/Random.h>
+#include <Common/Usage.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *usage[] = {
+    "usage: CellStoreBlockSummaries_test [--blocks=<n>]",
+    "",
+    "  This program checks that CellStore block summaries exclude blocks by",
+    "  scan revision, time interval and column family exactly when the merge",
+    "  scanner would drop every cell of the block, and that summaries of",
+    "  <blocks> random blocks survive an encode/decode round trip.",
+    (const char *)0
+  };
+
+  Key make_key(uint8_t flag, uint8_t family, int64_t timestamp,
+               int64_t revision) {
+    Key key;
+    key.flag = flag;
+    key.column_family_code = family;
+    key.timestamp = timestamp;
+    key.revision = revision;
+    return key;
+  }
+
+  void reset_scan(ScanContext &scan_ctx) {
+    scan_ctx.revision = TIMESTAMP_MAX;
+    scan_ctx.time_interval.first = TIMESTAMP_MIN;
+    scan_ctx.time_interval.second = TIMESTAMP_MAX;
+    for (size_t i=0; i<256; i++)
+      scan_ctx.family_mask[i] = true;
+  }
+
+  void test_excluded() {
+    ScanContext scan_ctx;
+    CellStoreBlockSummaries::Summary summary;
+
+    summary.add(make_key(FLAG_INSERT, 3, 1000, 10));
+    summary.add(make_key(FLAG_INSERT, 200, 2000, 20));
+
+    reset_scan(scan_ctx);
+    HT_ASSERT(!summary.excluded(&scan_ctx));
+
+    // Revision
+    scan_ctx.revision = 9;
+    HT_ASSERT(summary.excluded(&scan_ctx));
+    scan_ctx.revision = 10;
+    HT_ASSERT(!summary.excluded(&scan_ctx));
+
+    // Time interval [first, second)
+    reset_scan(scan_ctx);
+    scan_ctx.time_interval.first = 2001;
+    HT_ASSERT(summary.excluded(&scan_ctx));
+    scan_ctx.time_interval.first = 2000;
+    HT_ASSERT(!summary.excluded(&scan_ctx));
+    reset_scan(scan_ctx);
+    scan_ctx.time_interval.second = 1000;
+    HT_ASSERT(summary.excluded(&scan_ctx));
+    scan_ctx.time_interval.second = 1001;
+    HT_ASSERT(!summary.excluded(&scan_ctx));
+
+    // Column families
+    reset_scan(scan_ctx);
+    for (size_t i=0; i<256; i++)
+      scan_ctx.family_mask[i] = false;
+    HT_ASSERT(summary.excluded(&scan_ctx));
+    scan_ctx.family_mask[200] = true;
+    HT_ASSERT(!summary.excluded(&scan_ctx));
+    scan_ctx.family_mask[200] = false;
+    scan_ctx.family_mask[4] = true;
+    HT_ASSERT(summary.excluded(&scan_ctx));
+
+    // Deletes past the end of the time interval still apply
+    summary.add(make_key(FLAG_DELETE_CELL, 4, 3000, 30));
+    reset_scan(scan_ctx);
+    scan_ctx.time_interval.second = 1000;
+    HT_ASSERT(!summary.excluded(&scan_ctx));
+
+    // Row deletes apply to every column family
+    for (size_t i=0; i<256; i++)
+      scan_ctx.family_mask[i] = false;
+    scan_ctx.time_interval.second = TIMESTAMP_MAX;
+    scan_ctx.family_mask[7] = true;
+    HT_ASSERT(summary.excluded(&scan_ctx));
+    summary.add(make_key(FLAG_DELETE_ROW, 0, 3000, 30));
+    HT_ASSERT(!summary.excluded(&scan_ctx));
+
+    // ... but not to cells older than the time interval
+    scan_ctx.time_interval.first = 3001;
+    HT_ASSERT(summary.excluded(&scan_ctx));
+  }
+
+  void test_encode(size_t block_count) {
+    CellStoreBlockSummaries summaries, decoded;
+    DynamicBuffer buf;
+    int64_t offset {};
+
+    for (size_t i=0; i<block_count; i++) {
+      CellStoreBlockSummaries::Summary summary;
+      size_t cells = 1 + Random::number32() % 100;
+      for (size_t j=0; j<cells; j++) {
+        uint8_t flag = (Random::number32() % 20) ? FLAG_INSERT :
+          (uint8_t)(Random::number32() % 4);
+        summary.add(make_key(flag, (uint8_t)Random::number32(),
+                             (int64_t)Random::number64(),
+                             (int64_t)Random::number64()));
+      }
+      summary.offset = offset;
+      offset += 512 * (1 + Random::number32() % 200);
+      summaries.add(summary);
+    }
+
+    summaries.encode(buf);
+
+    const uint8_t *ptr = buf.base;
+    size_t remaining = buf.fill();
+    decoded.decode(&ptr, &remaining);
+    HT_ASSERT(remaining == 0);
+    HT_ASSERT(decoded.size() == block_count);
+
+    for (size_t i=0; i<block_count; i++) {
+      auto &expected = summaries.summaries()[i];
+      auto &actual = decoded.summaries()[i];
+      HT_ASSERT(actual.offset == expected.offset);
+      HT_ASSERT(actual.timestamp_min == expected.timestamp_min);
+      HT_ASSERT(actual.timestamp_max == expected.timestamp_max);
+      HT_ASSERT(actual.revision_min == expected.revision_min);
+      HT_ASSERT(actual.revision_max == expected.revision_max);
+      HT_ASSERT(!memcmp(actual.families, expected.families,
+                        sizeof(expected.families)));
+      HT_ASSERT(actual.flags == expected.flags);
+      HT_ASSERT(decoded.find(expected.offset) == &actual);
+      HT_ASSERT(decoded.find(expected.offset + 1) == 0);
+    }
+
+    ScanContext scan_ctx;
+    reset_scan(scan_ctx);
+    HT_ASSERT(decoded.excluded_count(&scan_ctx) == 0);
+    scan_ctx.revision = TIMESTAMP_MIN;
+    HT_ASSERT(decoded.excluded_count(&scan_ctx) == block_count);
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  size_t block_count = 10000;
+
+  for (int i=1; i<argc; i++) {
+    if (!strncmp(argv[i], "--blocks=", 9))
+      block_count = (size_t)atoi(&argv[i][9]);
+    else if (!strcmp(argv[i], "--help"))
+      Usage::dump_and_exit(usage);
+  }
+
+  try {
+    test_excluded();
+    test_encode(block_count);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
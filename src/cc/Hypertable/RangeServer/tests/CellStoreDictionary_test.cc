@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include "../CellStoreFactory.h"
+#include "../CellStoreTrailerV7.h"
+#include "../CellStoreV7.h"
+#include "../Global.h"
+
+#include <Hypertable/Lib/Key.h>
+#include <Hypertable/Lib/Schema.h>
+
+#include <FsBroker/Lib/Client.h>
+
+#include <AsyncComm/ConnectionManager.h>
+#include <AsyncComm/ReactorFactory.h>
+
+#include <Common/ByteString.h>
+#include <Common/Config.h>
+#include <Common/DynamicBuffer.h>
+#include <Common/Init.h>
+#include <Common/InetAddr.h>
+#include <Common/Serialization.h>
+#include <Common/Usage.h>
+
+#include <cstring>
+#include <vector>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *usage[] = {
+    "usage: CellStoreDictionary_test",
+    "",
+    "  This program writes a CellStore compressed with zstd and a trained",
+    "  dictionary, without block summaries, re-opens it and reads it back",
+    "  through the readahead scanner and, after its indexes are purged,",
+    "  through the block index scanner.  It does so once with the default",
+    "  key encoding and once with the columnar key encoding, whose blocks",
+    "  hold keys and values in separate streams.",
+    (const char *)0
+  };
+
+  const char *schema_str =
+  "<Schema>\n"
+  "  <AccessGroup name=\"default\">\n"
+  "    <ColumnFamily id=\"1\">\n"
+  "      <Name>reading</Name>\n"
+  "    </ColumnFamily>\n"
+  "  </AccessGroup>\n"
+  "</Schema>";
+
+  const size_t ROWS = 20000;
+
+  String row_key(size_t i) {
+    return format("sensor%06u", (unsigned)i);
+  }
+
+  String value(size_t i) {
+    return format("{\"sensor\": %u, \"status\": \"ok\", \"celsius\": %u.%u, "
+                  "\"firmware\": \"v2.%u\"}", (unsigned)i,
+                  (unsigned)(i * 7919 % 40), (unsigned)(i % 10),
+                  (unsigned)(i % 3));
+  }
+
+  /// Scans the store, checking that every cell comes back.
+  void check_scan(CellStorePtr &cs, SchemaPtr &schema, const char *start_row,
+                  const char *end_row, size_t first, size_t last) {
+    RangeSpec range("", Key::END_ROW_MARKER);
+    ScanSpecBuilder ssbuilder;
+    if (start_row)
+      ssbuilder.add_row_interval(start_row, true, end_row, true);
+    ScanContextPtr scan_ctx =
+      make_shared<ScanContext>(TIMESTAMP_MAX, &ssbuilder.get(), &range,
+                               schema);
+    CellListScannerPtr scanner = cs->create_scanner(scan_ctx.get());
+    Key key;
+    ByteString bsvalue;
+    size_t i = first;
+    while (scanner->get(key, bsvalue)) {
+      HT_ASSERT(i <= last);
+      HT_ASSERT(row_key(i) == key.row);
+      const uint8_t *data;
+      size_t len = bsvalue.decode_length(&data);
+      HT_ASSERT(value(i) == String((const char *)data, len));
+      i++;
+      scanner->forward();
+    }
+    HT_ASSERT(i == last + 1);
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  try {
+    struct sockaddr_in addr;
+    FsBroker::Lib::ClientPtr client;
+    TableIdentifier table_id("0");
+
+    Config::init(argc, argv);
+
+    if (Config::has("help"))
+      Usage::dump_and_exit(usage);
+
+    ReactorFactory::initialize(2);
+
+    InetAddr::initialize(&addr, "localhost",
+                         Config::properties->get_i16("FsBroker.Port"));
+
+    ConnectionManagerPtr conn_mgr = make_shared<ConnectionManager>();
+    client = std::make_shared<FsBroker::Lib::Client>(conn_mgr, addr, 15000);
+
+    Global::dfs = client;
+
+    if (!client->wait_for_connection(15000)) {
+      HT_ERROR("Unable to connect to DFS");
+      return 1;
+    }
+
+    Global::memory_tracker = new MemoryTracker(0, 0);
+
+    Config::properties->set("Hypertable.RangeServer.CellStore.BlockSummaries",
+                            false);
+
+    String testdir = "/CellStoreDictionary_test";
+    client->mkdirs(testdir);
+
+    SchemaPtr schema(Schema::new_instance(schema_str));
+
+    for (const char *key_encoding : { "prefix", "columnar" }) {
+      String csname = testdir + "/" + key_encoding;
+
+      PropertiesPtr cs_props = make_shared<Properties>();
+      cs_props->set("compressor", String("zstd --dict-size 4096"));
+      cs_props->set("blocksize", 4096);
+      cs_props->set("key-encoding", String(key_encoding));
+
+      {
+        CellStorePtr cs = make_shared<CellStoreV7>(Global::dfs.get(), schema);
+        cs->create(csname.c_str(), 0, cs_props, &table_id);
+
+        DynamicBuffer dbuf;
+        for (size_t i=0; i<ROWS; i++) {
+          String row = row_key(i);
+          String val = value(i);
+          Key key;
+          SerializedKey serkey;
+          ByteString bsvalue;
+
+          dbuf.clear();
+          create_key_and_append(dbuf, FLAG_INSERT, row.c_str(), 1, "",
+                                (int64_t)i + 1, (int64_t)i + 1);
+          size_t key_length = dbuf.fill();
+          append_as_byte_string(dbuf, val.c_str(), val.length());
+          serkey.ptr = dbuf.base;
+          key.load(serkey);
+          bsvalue.ptr = dbuf.base + key_length;
+          cs->add(key, bsvalue);
+        }
+
+        cs->finalize(&table_id);
+      }
+
+      CellStorePtr cs = CellStoreFactory::open(csname, "", Key::END_ROW_MARKER);
+
+      CellStoreTrailerV7 *trailer =
+        dynamic_cast<CellStoreTrailerV7 *>(cs->get_trailer());
+      HT_ASSERT(trailer);
+      HT_ASSERT(trailer->flags & CellStoreTrailerV7::DICTIONARY);
+      HT_ASSERT(!(trailer->flags & CellStoreTrailerV7::BLOCK_SUMMARIES));
+      HT_ASSERT(cs->has_value_streams() == !strcmp(key_encoding, "columnar"));
+
+      // Unrestricted scan, read ahead without the block index
+      check_scan(cs, schema, 0, 0, 0, ROWS - 1);
+
+      // The dictionary outlives the purged block index
+      cs->purge_indexes();
+      check_scan(cs, schema, "sensor012345", "sensor012399", 12345, 12399);
+      cs->purge_indexes();
+      check_scan(cs, schema, 0, 0, 0, ROWS - 1);
+    }
+
+    client->rmdir(testdir);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
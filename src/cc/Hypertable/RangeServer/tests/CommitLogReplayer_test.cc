@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include "../CommitLogReplayer.h"
+
+#include <Hypertable/Lib/CommitLog.h>
+#include <Hypertable/Lib/CommitLogReader.h>
+#include <Hypertable/Lib/Key.h>
+#include <Hypertable/Lib/TableIdentifier.h>
+
+#include <FsBroker/Lib/Client.h>
+
+#include <AsyncComm/ConnectionManager.h>
+#include <AsyncComm/ReactorFactory.h>
+
+#include <Common/ByteString.h>
+#include <Common/Config.h>
+#include <Common/DynamicBuffer.h>
+#include <Common/Init.h>
+#include <Common/InetAddr.h>
+#include <Common/StaticBuffer.h>
+#include <Common/Usage.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *usage[] = {
+    "usage: CommitLogReplayer_test",
+    "",
+    "  This program tests the CommitLogReplayer.  It writes a commit log",
+    "  with several fragments, corrupts some of its blocks, and replays it",
+    "  on multiple inflate and add threads.  It checks that the cells of",
+    "  every intact block reach their range in log order, that corrupt",
+    "  blocks are skipped, and that fragment revisions only reflect the",
+    "  blocks that were successfully inflated.",
+    (const char *)0
+  };
+
+  const char *log_dir = "/test/CommitLogReplayer";
+
+  /// Number of rows per range
+  const int ROWS_PER_RANGE = 25;
+
+  /// Number of ranges
+  const int RANGES = 8;
+
+  /// Destination recording the rows and revisions of the cells it receives.
+  class TestDestination : public CommitLogReplayer::Destination {
+  public:
+    void add(const vector<const uint8_t *> &cells) override {
+      Key key;
+      SerializedKey skey;
+      for (auto cell : cells) {
+        skey.ptr = cell;
+        key.load(skey);
+        rows.push_back(key.row);
+        revisions.push_back(key.revision);
+      }
+    }
+    vector<String> rows;
+    vector<int64_t> revisions;
+  };
+
+  typedef std::shared_ptr<TestDestination> TestDestinationPtr;
+
+  /// Writes one block of cells to the commit log.
+  /// The block holds <code>count</code> cells of table <code>table</code>,
+  /// with rows chosen at random and revisions taken from
+  /// <code>*revisionp</code>.  The block revision is that of its last cell.
+  int64_t write_block(CommitLog *log, const char *table, int count,
+                      int64_t *revisionp,
+                      map<int64_t, String> *written) {
+    TableIdentifier table_id(table);
+    DynamicBuffer dbuf;
+    char row[32];
+
+    dbuf.ensure(table_id.encoded_length());
+    table_id.encode(&dbuf.ptr);
+
+    for (int i=0; i<count; i++) {
+      int64_t revision = ++*revisionp;
+      sprintf(row, "row%05d", (int)(random() % (RANGES * ROWS_PER_RANGE)));
+      create_key_and_append(dbuf, FLAG_INSERT, row, 1, "", revision, revision);
+      append_as_byte_string(dbuf, "value", 5);
+      if (written)
+        (*written)[revision] = row;
+    }
+
+    int error = log->write(0, dbuf, *revisionp, Filesystem::Flags::FLUSH);
+    if (error != Error::OK)
+      HT_THROW(error, "Problem writing to commit log");
+    return *revisionp;
+  }
+
+  /// Corrupts the last byte of the payload of a block.
+  /// Rewrites fragment <code>fname</code> with the byte at
+  /// <code>offset</code> flipped, so that the block header is intact but
+  /// the payload checksum fails when the block is inflated.
+  void corrupt_byte(FilesystemPtr &fs, const String &fname, int64_t offset) {
+    int64_t length = fs->length(fname);
+    StaticBuffer buf(length);
+    int fd = fs->open(fname, 0);
+    HT_ASSERT(fs->read(fd, buf.base, length) == (size_t)length);
+    fs->close(fd);
+    buf.base[offset] ^= 0xff;
+    fd = fs->create(fname, Filesystem::OPEN_FLAG_OVERWRITE, -1, -1, -1);
+    fs->append(fd, buf, Filesystem::Flags::FLUSH);
+    fs->close(fd);
+  }
+
+  /// Writes a block to be corrupted once the log is closed.
+  /// @return Offset of the last byte of the block payload
+  int64_t write_corrupt_block(FilesystemPtr &fs, CommitLog *log,
+                              int64_t *revisionp) {
+    String fname = log->get_current_fragment_file();
+    write_block(log, "1", 10, revisionp, 0);
+    return fs->length(fname) - 1;
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  try {
+    struct sockaddr_in addr;
+    FsBroker::Lib::ClientPtr client;
+
+    Config::init(argc, argv);
+
+    if (Config::has("help"))
+      Usage::dump_and_exit(usage);
+
+    ReactorFactory::initialize(2);
+
+    InetAddr::initialize(&addr, "localhost",
+                         Config::properties->get_i16("FsBroker.Port"));
+
+    ConnectionManagerPtr conn_mgr = make_shared<ConnectionManager>();
+    client = std::make_shared<FsBroker::Lib::Client>(conn_mgr, addr, 15000);
+
+    if (!client->wait_for_connection(15000)) {
+      HT_ERROR("Unable to connect to DFS");
+      return 1;
+    }
+
+    FilesystemPtr fs = client;
+    map<int64_t, String> written;
+    int64_t revision = 1000;
+    String fname;
+    vector<int64_t> offsets;
+
+    srandom(1);
+
+    if (client->exists(log_dir))
+      client->rmdir(log_dir);
+    client->mkdirs(log_dir);
+
+    Config::properties->set("Hypertable.CommitLog.RollLimit", (int64_t)1000000000);
+
+    // Fragment 0: intact blocks, some of a table that is not replayed
+    int64_t fragment0_revision;
+    {
+      CommitLog log(fs, log_dir, false);
+      for (int i=0; i<20; i++)
+        write_block(&log, "1", 50, &revision, &written);
+      write_block(&log, "2", 50, &revision, 0);
+      fragment0_revision = write_block(&log, "1", 50, &revision, &written);
+    }
+
+    // Fragment 1: a single corrupt block, so the fragment must be dropped
+    {
+      CommitLog log(fs, log_dir, false);
+      fname = log.get_current_fragment_file();
+      offsets.push_back(write_corrupt_block(fs, &log, &revision));
+    }
+    corrupt_byte(fs, fname, offsets.back());
+
+    // Fragment 2: intact blocks with a corrupt one in the middle and one
+    // at the end, which has the highest revision in the log
+    int64_t fragment2_revision;
+    {
+      CommitLog log(fs, log_dir, false);
+      fname = log.get_current_fragment_file();
+      offsets.clear();
+      for (int i=0; i<10; i++)
+        write_block(&log, "1", 50, &revision, &written);
+      offsets.push_back(write_corrupt_block(fs, &log, &revision));
+      for (int i=0; i<10; i++)
+        fragment2_revision = write_block(&log, "1", 50, &revision, &written);
+      offsets.push_back(write_corrupt_block(fs, &log, &revision));
+    }
+    for (auto offset : offsets)
+      corrupt_byte(fs, fname, offset);
+
+    CommitLogReplayer replayer(3, 4,
+                               [](const uint8_t **bufp, size_t *remainp,
+                                  TableIdentifier *tid) {
+                                 tid->decode(bufp, remainp);
+                               });
+
+    vector<TestDestinationPtr> destinations;
+    for (int i=0; i<RANGES; i++)
+      destinations.push_back(make_shared<TestDestination>());
+
+    CommitLogReader reader(fs, log_dir);
+
+    // Table "2" and the rows of the last range are not replayed
+    replayer.replay([&destinations](const TableIdentifier &table,
+                                    const char *row,
+                                    CommitLogReplayer::DestinationPtr &dest,
+                                    String &start_row, String &end_row) {
+                      if (strcmp(table.id, "1"))
+                        return false;
+                      int n = atoi(row + 3) / ROWS_PER_RANGE;
+                      if (n == RANGES - 1)
+                        return false;
+                      start_row = n ? format("row%05d", n * ROWS_PER_RANGE - 1) : "";
+                      end_row = format("row%05d", (n + 1) * ROWS_PER_RANGE - 1);
+                      dest = destinations[n];
+                      return true;
+                    }, &reader);
+
+    // Each range received exactly the cells of the intact blocks in its
+    // rows, in log order
+    map<int64_t, String> expected;
+    for (auto &entry : written) {
+      if (atoi(entry.second.c_str() + 3) / ROWS_PER_RANGE != RANGES - 1)
+        expected.insert(entry);
+    }
+    size_t received = 0;
+    for (int i=0; i<RANGES; i++) {
+      TestDestinationPtr &dest = destinations[i];
+      for (size_t j=0; j<dest->revisions.size(); j++) {
+        if (j > 0)
+          HT_ASSERT(dest->revisions[j-1] < dest->revisions[j]);
+        auto iter = expected.find(dest->revisions[j]);
+        HT_ASSERT(iter != expected.end());
+        HT_ASSERT(iter->second == dest->rows[j]);
+        HT_ASSERT(atoi(dest->rows[j].c_str() + 3) / ROWS_PER_RANGE == i);
+      }
+      received += dest->revisions.size();
+    }
+    HT_ASSERT(destinations[RANGES-1]->revisions.empty());
+    HT_ASSERT(received == expected.size());
+
+    // The fragment with no intact block was dropped, and the revisions of
+    // the others ignore the corrupt blocks
+    LogFragmentQueue &fragments = reader.fragment_queue();
+    HT_ASSERT(fragments.size() == 2);
+    HT_ASSERT(fragments[0]->num == 0);
+    HT_ASSERT(fragments[0]->revision == fragment0_revision);
+    HT_ASSERT(fragments[1]->num == 2);
+    HT_ASSERT(fragments[1]->revision == fragment2_revision);
+    HT_ASSERT(reader.get_latest_revision() == fragment2_revision);
+
+    client->rmdir(log_dir);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
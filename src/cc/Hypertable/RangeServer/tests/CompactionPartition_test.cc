@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hypertable/RangeServer/CellCache.h>
+#include <Hypertable/RangeServer/CompactionPartition.h>
+#include <Hypertable/RangeServer/Global.h>
+#include <Hypertable/RangeServer/MemoryTracker.h>
+#include <Hypertable/RangeServer/MergeScannerAccessGroup.h>
+#include <Hypertable/RangeServer/ScanContext.h>
+
+#include <Hypertable/Lib/Key.h>
+#include <Hypertable/Lib/Schema.h>
+
+#include <Common/Config.h>
+#include <Common/DynamicBuffer.h>
+#include <Common/Init.h>
+#include <Common/Random.h>
+#include <Common/Serialization.h>
+#include <Common/Usage.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *usage[] = {
+    "usage: CompactionPartition_test [--rows=<n>] [--partitions=<n>]",
+    "",
+    "  This program verifies that CompactionPartition::select_rows() divides",
+    "  row estimates evenly, and that merging a CellCache in row partitions",
+    "  produces exactly the cells of a single compaction merge, including",
+    "  delete handling, version limits, counter accumulation and cells of",
+    "  column families missing from the schema.",
+    (const char *)0
+  };
+
+  const char *schema_str =
+  "<Schema>\n"
+  "  <AccessGroup name=\"default\">\n"
+  "    <ColumnFamily id=\"1\">\n"
+  "      <Name>tag</Name>\n"
+  "      <MaxVersions>2</MaxVersions>\n"
+  "    </ColumnFamily>\n"
+  "    <ColumnFamily id=\"2\">\n"
+  "      <Name>count</Name>\n"
+  "      <Counter>true</Counter>\n"
+  "    </ColumnFamily>\n"
+  "  </AccessGroup>\n"
+  "</Schema>";
+
+  const uint32_t compaction_flags = MergeScannerAccessGroup::IS_COMPACTION |
+    MergeScannerAccessGroup::ACCUMULATE_COUNTERS;
+
+  void test_select_rows() {
+    StlArena arena(128000);
+    CellList::SplitRowDataMapT split_row_data =
+      CellList::SplitRowDataMapT(LtCstr(), CellList::SplitRowDataAlloc(arena));
+    vector<String> row_strs;
+    vector<String> rows;
+    vector<int64_t> weights;
+    char rowbuf[32];
+
+    for (int i=0; i<1000; i++) {
+      sprintf(rowbuf, "row%04d", i);
+      row_strs.push_back(rowbuf);
+    }
+    for (auto &row : row_strs)
+      split_row_data[row.c_str()] = 10;
+
+    CompactionPartition::select_rows(split_row_data, 4, rows, &weights);
+    HT_ASSERT(rows.size() == 3);
+    HT_ASSERT(rows[0] == "row0249" && rows[1] == "row0499" && rows[2] == "row0749");
+    HT_ASSERT(weights.size() == 4);
+    for (auto weight : weights)
+      HT_ASSERT(weight == 2500);
+
+    CompactionPartition::select_rows(split_row_data, 1, rows, &weights);
+    HT_ASSERT(rows.empty());
+    HT_ASSERT(weights.size() == 1 && weights[0] == 10000);
+
+    // A dominant row ends an oversized partition and the remaining rows are
+    // divided among the other partitions
+    split_row_data[row_strs[10].c_str()] = 100000;
+    CompactionPartition::select_rows(split_row_data, 8, rows, &weights);
+    HT_ASSERT(rows.size() == 7);
+    HT_ASSERT(rows[0] == "row0010");
+    HT_ASSERT(weights.size() == 8 && weights[0] == 100100);
+    int64_t total {};
+    for (size_t i=0; i<rows.size(); i++) {
+      if (i > 0)
+        HT_ASSERT(rows[i-1] < rows[i]);
+    }
+    for (auto weight : weights)
+      total += weight;
+    HT_ASSERT(total == 109990);
+
+    // Single row
+    split_row_data.clear();
+    split_row_data[row_strs[0].c_str()] = 50;
+    CompactionPartition::select_rows(split_row_data, 4, rows, &weights);
+    HT_ASSERT(rows.empty());
+    HT_ASSERT(weights.size() == 1 && weights[0] == 50);
+  }
+
+  void append_cell(DynamicBuffer &dbuf, vector<size_t> &offsets,
+                   uint8_t flag, const char *row, uint8_t cf,
+                   const char *qualifier, int64_t revision,
+                   const void *value, size_t value_len) {
+    offsets.push_back(dbuf.fill());
+    create_key_and_append(dbuf, flag, row, cf, qualifier, revision, revision);
+    append_as_byte_string(dbuf, value, value_len);
+  }
+
+  /// Fills cache with random cells, row deletes, cell deletes and counters
+  void populate(CellCachePtr &cache, size_t row_count) {
+    DynamicBuffer dbuf(row_count * 512);
+    vector<size_t> offsets;
+    char rowbuf[32], qualbuf[16];
+    const char *value = "All work and no play makes jack a dull boy.";
+    uint8_t counter[8];
+    uint8_t *ptr = counter;
+    int64_t revision = 1;
+
+    // Counter values are encoded 64 bit integers
+    Serialization::encode_i64(&ptr, 3);
+
+    for (size_t i=0; i<row_count; i++) {
+      sprintf(rowbuf, "row%08u", (unsigned)Random::number32());
+      size_t versions = 1 + Random::number32() % 4;
+      for (size_t j=0; j<versions; j++) {
+        sprintf(qualbuf, "q%u", (unsigned)(Random::number32() % 3));
+        append_cell(dbuf, offsets, FLAG_INSERT, rowbuf, 1, qualbuf,
+                    revision++, value, strlen(value));
+        append_cell(dbuf, offsets, FLAG_INSERT, rowbuf, 2, "",
+                    revision++, counter, sizeof(counter));
+      }
+      // Cells of a family the schema no longer lists are kept by a
+      // compaction, so partitions must keep them too
+      if (Random::number32() % 16 == 0)
+        append_cell(dbuf, offsets, FLAG_INSERT, rowbuf, 3, "",
+                    revision++, value, strlen(value));
+      switch (Random::number32() % 8) {
+      case 0:
+        append_cell(dbuf, offsets, FLAG_DELETE_ROW, rowbuf, 0, "",
+                    revision++, "", 0);
+        break;
+      case 1:
+        append_cell(dbuf, offsets, FLAG_DELETE_CELL, rowbuf, 1, "q0",
+                    revision++, "", 0);
+        break;
+      }
+    }
+
+    Key key;
+    cache->lock();
+    for (auto offset : offsets) {
+      key.load(SerializedKey(dbuf.base + offset));
+      cache->add(key, ByteString(key.serial.ptr + key.length));
+    }
+    cache->unlock();
+  }
+
+  /// Appends serialized cells returned by mscanner to output
+  void drain(MergeScannerAccessGroup *mscanner, DynamicBuffer &output,
+             size_t *cells) {
+    Key key;
+    ByteString value;
+    while (mscanner->get(key, value)) {
+      output.add(key.serial.ptr, key.length);
+      output.ensure(value.length());
+      value.write(output.ptr);
+      output.ptr += value.length();
+      (*cells)++;
+      mscanner->forward();
+    }
+  }
+
+  void test_partitioned_merge(size_t row_count, size_t partitions) {
+    String table_name("1");
+    SchemaPtr schema(Schema::new_instance(schema_str));
+    CellCachePtr cache = make_shared<CellCache>();
+
+    populate(cache, row_count);
+
+    // Serial merge
+    DynamicBuffer serial_output;
+    size_t serial_cells {};
+    ScanContextPtr scan_ctx = make_shared<ScanContext>(schema);
+    MergeScannerAccessGroupPtr mscanner =
+      make_shared<MergeScannerAccessGroup>(table_name, scan_ctx.get(),
+                                           compaction_flags);
+    mscanner->add_scanner(cache->create_scanner(scan_ctx.get()));
+    drain(mscanner.get(), serial_output, &serial_cells);
+
+    // Partitioned merge
+    StlArena arena(128000);
+    CellList::SplitRowDataMapT split_row_data =
+      CellList::SplitRowDataMapT(LtCstr(), CellList::SplitRowDataAlloc(arena));
+    cache->split_row_estimate_data(split_row_data);
+    vector<String> rows;
+    CompactionPartition::select_rows(split_row_data, partitions, rows);
+    HT_ASSERT(rows.size() == partitions - 1);
+
+    DynamicBuffer partitioned_output;
+    size_t partitioned_cells {};
+    for (size_t i=0; i<=rows.size(); i++) {
+      CompactionPartition partition(table_name, schema,
+                                    i ? rows[i-1] : "",
+                                    i < rows.size() ? rows[i] : "",
+                                    compaction_flags);
+      partition.get_merge_scanner()->add_scanner(cache->create_scanner(partition.get_scan_context()));
+      drain(partition.get_merge_scanner(), partitioned_output,
+            &partitioned_cells);
+    }
+
+    cout << row_count << " rows, " << cache->size() << " cells merged to "
+         << serial_cells << " cells (" << partitions << " partitions)" << endl;
+
+    HT_ASSERT(serial_cells < cache->size());
+    HT_ASSERT(partitioned_cells == serial_cells);
+    HT_ASSERT(partitioned_output.fill() == serial_output.fill());
+    HT_ASSERT(memcmp(partitioned_output.base, serial_output.base,
+                     serial_output.fill()) == 0);
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  size_t rows = 20000;
+  size_t partitions = 8;
+
+  for (int i=1; i<argc; i++) {
+    if (!strncmp(argv[i], "--rows=", 7))
+      rows = (size_t)atoi(&argv[i][7]);
+    else if (!strncmp(argv[i], "--partitions=", 13))
+      partitions = (size_t)atoi(&argv[i][13]);
+    else if (!strcmp(argv[i], "--help"))
+      Usage::dump_and_exit(usage);
+  }
+
+  try {
+    Config::init(0, 0);
+    Global::cell_cache_scanner_cache_size = 1024;
+    Global::memory_tracker = new MemoryTracker(0, 0);
+
+    test_select_rows();
+    test_partitioned_merge(rows, partitions);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
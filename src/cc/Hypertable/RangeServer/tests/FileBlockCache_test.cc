@@ -19,14 +19,15 @@
  * 02110-1301, USA.
  */
 
+
 #include "Common/Compat.h"
 #include <cstdlib>
 #include <cstdio>
 #include <iostream>
 #include <list>
 #include <set>
+#include <thread>
 #include <vector>
-#include <set>
 
 extern "C" {
 #include <limits.h>
@@ -55,17 +56,6 @@ namespace {
     uint32_t file_offset;
     uint32_t length;
   };
-  struct LtBufferRecord {
-    bool operator()(const struct BufferRecord &br1,
-                    const struct BufferRecord &br2) const {
-      if (br1.file_id == br2.file_id) {
-        if (br1.file_offset == br2.file_offset)
-          return br1.length < br2.length;
-        return br1.file_offset < br2.file_offset;
-      }
-      return br1.file_id < br2.file_id;
-    }
-  };
 }
 
 #define TOTAL_ALLOC_LIMIT 100000000
@@ -73,10 +63,96 @@ namespace {
 #define MAX_FILE_ID 10
 #define MAX_FILE_OFFSET 100
 
+#define SCAN_BLOCK_SIZE 65536
+#define HOT_BLOCKS 200
+#define SCAN_BLOCKS 10000
+
+namespace {
+
+  /// Checks out a block, inserting it if it isn't cached.
+  void access(FileBlockCache *cache, int file_id, uint32_t file_offset,
+              uint32_t length) {
+    uint8_t *block;
+    if (cache->checkout(file_id, file_offset, &block, &length))
+      cache->checkin(file_id, file_offset);
+    else {
+      block = new uint8_t [ length ];
+      if (cache->insert(file_id, file_offset, block, length, EventPtr(), true))
+        cache->checkin(file_id, file_offset);
+      else
+        delete [] block;
+    }
+  }
+
+  /**
+   * Verifies that a working set accessed more than once survives a
+   * sequential scan of many blocks that are each read only once.
+   */
+  bool test_scan_resistance(uint64_t cache_memory) {
+    FileBlockCache cache(cache_memory, cache_memory, false);
+    int hot_blocks = std::min((int)(cache_memory / SCAN_BLOCK_SIZE / 5), HOT_BLOCKS);
+
+    for (int pass=0; pass<3; pass++)
+      for (int i=0; i<hot_blocks; i++)
+        access(&cache, 1, i, SCAN_BLOCK_SIZE);
+
+    for (int i=0; i<SCAN_BLOCKS; i++)
+      access(&cache, 2, i, SCAN_BLOCK_SIZE);
+
+    for (int i=0; i<hot_blocks; i++) {
+      if (!cache.contains(1, i)) {
+        HT_ERRORF("hot block (id=1, offset=%d) evicted by scan", i);
+        return false;
+      }
+    }
+
+    if (cache.memory_used() > cache.get_limit()) {
+      HT_ERROR("memory used exceeds limit after scan");
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Hammers the cache from several threads and checks that the memory
+   * accounting and statistics are consistent afterwards.
+   */
+  bool test_concurrent(uint64_t cache_memory, int threads,
+                       vector<BufferRecord> &input_data) {
+    FileBlockCache cache(cache_memory, cache_memory, false);
+    vector<thread> workers;
+    for (int t=0; t<threads; t++)
+      workers.push_back(thread([&cache, &input_data, t]() {
+            unsigned int seed = (unsigned int)t;
+            for (int i=0; i<50000; i++) {
+              BufferRecord &rec = input_data[rand_r(&seed) % input_data.size()];
+              access(&cache, rec.file_id, rec.file_offset, rec.length);
+            }
+          }));
+    for (auto &worker : workers)
+      worker.join();
+
+    uint64_t max_memory, available_memory, accesses, hits;
+    cache.get_stats(&max_memory, &available_memory, &accesses, &hits);
+    if (accesses != (uint64_t)threads * 50000 || hits > accesses) {
+      HT_ERRORF("bad statistics (accesses=%llu, hits=%llu)",
+                (Llu)accesses, (Llu)hits);
+      return false;
+    }
+    if ((int64_t)max_memory != cache.get_limit() ||
+        (int64_t)(max_memory - available_memory) != cache.memory_used() ||
+        cache.memory_used() > cache.get_limit()) {
+      HT_ERROR("inconsistent memory accounting after concurrent access");
+      return false;
+    }
+    return true;
+  }
+
+}
+
 int main(int argc, char **argv) {
   FileBlockCache *cache;
   vector<BufferRecord> input_data;
-  list<BufferRecord> history;
   BufferRecord rec;
   unsigned long seed = (unsigned long)getpid();
   uint64_t total_alloc = 0;
@@ -86,7 +162,6 @@ int main(int argc, char **argv) {
   uint8_t *block;
   uint32_t length;
   int index;
-  set<BufferRecord, LtBufferRecord> lru;
 
   System::initialize(System::locate_install_dir(argv[0]));
 
@@ -97,7 +172,7 @@ int main(int argc, char **argv) {
       total_memory = std::max((int64_t)strtoll(&argv[i][15], 0, 0), (int64_t)(TARGET_BUFSIZE * 2));
   }
   uint64_t cache_memory = total_memory / 2;
-  cache = new FileBlockCache(cache_memory, cache_memory, false);
+  cache = new FileBlockCache(0, cache_memory, false);
 
   srandom(seed);
 
@@ -111,14 +186,17 @@ int main(int argc, char **argv) {
     }
   }
 
-  cout << "FileBlockCache_test SEED = " << seed << ", total-memory = " << total_memory << endl;
+  cout << "FileBlockCache_test SEED = " << seed << ", total-memory = "
+       << total_memory << ", shards = " << cache->shards() << endl;
 
   while (total_alloc < total_memory) {
     index = (int)(random() % (MAX_FILE_ID*MAX_FILE_OFFSET));
     file_id = input_data[index].file_id;
     file_offset = input_data[index].file_offset;
-    if (cache->checkout(file_id, file_offset, &block, &length))
+    if (cache->checkout(file_id, file_offset, &block, &length)) {
+      HT_ASSERT(length == input_data[index].length);
       cache->checkin(file_id, file_offset);
+    }
     else {
       length = input_data[index].length;
       block = new uint8_t [ length ];
@@ -126,55 +204,44 @@ int main(int argc, char **argv) {
                 Error::FAILED_EXPECTATION);
       total_alloc += length;
       cache->checkin(file_id, file_offset);
-    }
-    history.push_front(input_data[index]);
-  }
-
-  /**
-   * Now verify that our idea of LRU is actually in the cache
-   */
-  total_alloc = 0;
-  list<BufferRecord>::iterator history_iter = history.begin();
-  while (total_alloc < total_memory) {
-    rec.file_id = (*history_iter).file_id;
-    rec.file_offset = (*history_iter).file_offset;
-    rec.length = (*history_iter).length;
-    if (lru.find(rec) == lru.end()) {
-      if (total_alloc + rec.length > cache_memory)
-        break;
-      lru.insert(rec);
-      total_alloc += rec.length;
-      if (!cache->contains(rec.file_id, rec.file_offset)) {
-        HT_ERRORF("computed LRU does not match cache's (id=%d, offset=%u)",
-                  rec.file_id, rec.file_offset);
+      /**
+       * A block that was just inserted must be resident
+       */
+      if (!cache->contains(file_id, file_offset)) {
+        HT_ERRORF("inserted block missing from cache (id=%d, offset=%u)",
+                  file_id, file_offset);
         return 1;
       }
     }
-    ++history_iter;
+    if (cache->memory_used() > cache->get_limit()) {
+      HT_ERROR("memory used exceeds limit");
+      return 1;
+    }
   }
 
   /**
-   * Now verify that all of the remaining items that
-   * should *not* be in our LRU are, indeed, not in the cache
+   * Shrink and grow the limit and verify memory accounting
    */
-  if (cache->contains(rec.file_id, rec.file_offset)) {
-    HT_ERROR("computed LRU does not match cache's");
+  int64_t limit = cache->get_limit();
+  int64_t freed = cache->decrease_limit(limit / 2);
+  if (cache->get_limit() != limit - limit / 2 ||
+      cache->memory_used() > cache->get_limit() || freed < 0) {
+    HT_ERROR("decrease_limit accounting error");
     return 1;
   }
-  while (history_iter != history.end()) {
-    rec.file_id = (*history_iter).file_id;
-    rec.file_offset = (*history_iter).file_offset;
-    rec.length = (*history_iter).length;
-    if (lru.find(rec) == lru.end()) {
-      if (cache->contains(rec.file_id, rec.file_offset)) {
-        HT_ERROR("computed LRU does not match cache's");
-        return 1;
-      }
-    }
-    ++history_iter;
+  cache->increase_limit(limit);
+  if (cache->get_limit() != (int64_t)cache_memory) {
+    HT_ERROR("increase_limit did not restore limit to max memory");
+    return 1;
   }
 
   delete cache;
 
+  if (!test_scan_resistance(cache_memory))
+    return 1;
+
+  if (!test_concurrent(cache_memory / 4, 8, input_data))
+    return 1;
+
   return 0;
 }
@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hypertable/RangeServer/CellStoreBlockStreams.h>
+#include <Hypertable/RangeServer/KeyCompressorDelta.h>
+#include <Hypertable/RangeServer/KeyCompressorPrefix.h>
+#include <Hypertable/RangeServer/KeyDecompressorDelta.h>
+#include <Hypertable/RangeServer/KeyDecompressorPrefix.h>
+
+#include <Hypertable/Lib/Key.h>
+#include <Hypertable/Lib/SerializedKey.h>
+
+#include <Common/ByteString.h>
+#include <Common/DynamicBuffer.h>
+#include <Common/Logger.h>
+#include <Common/Random.h>
+#include <Common/Stopwatch.h>
+#include <Common/Usage.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *usage[] = {
+    "usage: KeyCompressorDelta_test [--count=<n>] [--blocksize=<n>]",
+    "",
+    "  This program writes generated keys into CellStore blocks with",
+    "  KeyCompressorPrefix and KeyCompressorDelta, verifies that the matching",
+    "  decompressors rebuild every key exactly, and reports the size of the",
+    "  blocks and the time to decode them.  The keys resemble telemetry data:",
+    "  a few columns per sensor row, one cell per sample with timestamps a",
+    "  few seconds apart, with and without explicit revisions, in both time",
+    "  orders, plus keys without a timestamp.  The delta blocks are also",
+    "  converted to the columnar layout of CellStoreBlockStreams and back.",
+    (const char *)0
+  };
+
+  /// Generates count sorted keys, followed by an 8 byte value each
+  void generate_keys(size_t count, DynamicBuffer &keys,
+                     vector<size_t> &offsets) {
+    char rowbuf[32];
+    const char *qualifiers[] = { "cpu", "disk", "mem" };
+    int64_t revision = 1400000000000000000LL;
+    int64_t base = 1400000000000000000LL;
+
+    keys.clear();
+    offsets.clear();
+    for (uint32_t row = 0; offsets.size() < count; row++) {
+      sprintf(rowbuf, "host%06u.example.com", (unsigned)row);
+      for (uint8_t cf=1; cf<=4 && offsets.size() < count; cf++) {
+        for (auto qualifier : qualifiers) {
+          int64_t timestamp = base + (Random::number32() % 1000) * 1000000000LL;
+          bool chronological = (cf == 3);
+          size_t samples = 1 + Random::number32() % 16;
+          for (size_t i=0; i<samples && offsets.size() < count; i++) {
+            offsets.push_back(keys.fill());
+            if (cf == 4)
+              create_key_and_append(keys, FLAG_INSERT, rowbuf, cf, qualifier,
+                                    TIMESTAMP_NULL, revision++);
+            else if (cf == 2)
+              create_key_and_append(keys, FLAG_INSERT, rowbuf, cf, qualifier,
+                                    timestamp, timestamp, !chronological);
+            else
+              create_key_and_append(keys, FLAG_INSERT, rowbuf, cf, qualifier,
+                                    timestamp, revision++, !chronological);
+            uint64_t value = Random::number32() % 100000;
+            append_as_byte_string(keys, &value, sizeof(value));
+            timestamp += chronological ? 5000000000LL : -5000000000LL;
+          }
+        }
+      }
+    }
+  }
+
+  /// Checks the uncompressed copy of the last key added to a block, which
+  /// CellStoreV7 writes into the block index
+  void verify_last_key(KeyCompressor &compressor, const Key &key) {
+    uint8_t uncompressed[256];
+    HT_ASSERT(compressor.length_uncompressed() == key.length);
+    compressor.write_uncompressed(uncompressed);
+    HT_ASSERT(memcmp(uncompressed, key.serial.ptr, key.length) == 0);
+  }
+
+  /// Writes keys and values into blocks as CellStoreV7::add() does
+  template <typename CompressorT>
+  void build_blocks(DynamicBuffer &keys, vector<size_t> &offsets,
+                    size_t blocksize, DynamicBuffer &data,
+                    vector<size_t> &block_offsets) {
+    CompressorT compressor;
+    Key key;
+
+    data.clear();
+    block_offsets.clear();
+    size_t block_start = 0;
+    for (auto offset : offsets) {
+      if (block_offsets.empty() || data.fill() - block_start > blocksize) {
+        if (!block_offsets.empty())
+          verify_last_key(compressor, key);
+        block_start = data.fill();
+        block_offsets.push_back(block_start);
+        compressor.reset();
+      }
+      key.load(SerializedKey(keys.base + offset));
+      compressor.add(key);
+      ByteString value(keys.base + offset + key.length);
+      data.ensure(compressor.length() + value.length());
+      compressor.write(data.ptr);
+      data.ptr += compressor.length();
+      data.add_unchecked(value.ptr, value.length());
+    }
+    verify_last_key(compressor, key);
+    block_offsets.push_back(data.fill());
+  }
+
+  template <typename DecompressorT>
+  void verify_blocks(DynamicBuffer &keys, vector<size_t> &offsets,
+                     DynamicBuffer &data, vector<size_t> &block_offsets) {
+    DecompressorT decompressor;
+    size_t next = 0;
+    Key key;
+
+    for (size_t i=0; i+1<block_offsets.size(); i++) {
+      const uint8_t *ptr = data.base + block_offsets[i];
+      const uint8_t *end = data.base + block_offsets[i+1];
+      decompressor.reset();
+      while (ptr < end) {
+        SerializedKey expected(keys.base + offsets[next++]);
+        ptr = decompressor.add(ptr);
+        decompressor.load(key);
+        HT_ASSERT(key.length == expected.length());
+        HT_ASSERT(memcmp(key.serial.ptr, expected.ptr, expected.length()) == 0);
+        HT_ASSERT(!decompressor.less_than(expected));
+        ByteString value(ptr);
+        HT_ASSERT(memcmp(value.ptr, expected.ptr + expected.length(),
+                         value.length()) == 0);
+        ptr += value.length();
+      }
+      HT_ASSERT(ptr == end);
+    }
+    HT_ASSERT(next == offsets.size());
+  }
+
+  /// Converts each block to the columnar layout and back, checking that
+  /// it comes back unchanged and that a truncated columnar block is
+  /// rejected.  Returns the total size of the columnar blocks.
+  size_t verify_streams(DynamicBuffer &data, vector<size_t> &block_offsets) {
+    size_t total = 0;
+    for (size_t i=0; i+1<block_offsets.size(); i++) {
+      size_t length = block_offsets[i+1] - block_offsets[i];
+      DynamicBuffer block(length);
+      block.add_unchecked(data.base + block_offsets[i], length);
+      CellStoreBlockStreams::encode(block);
+      total += block.fill();
+
+      DynamicBuffer truncated(block.fill());
+      truncated.add_unchecked(block.base, block.fill() - 1);
+      try {
+        CellStoreBlockStreams::decode(truncated);
+        HT_ASSERT(!"truncated columnar block not detected");
+      }
+      catch (Exception &e) {
+      }
+
+      CellStoreBlockStreams::decode(block);
+      HT_ASSERT(block.fill() == length);
+      HT_ASSERT(memcmp(block.base, data.base + block_offsets[i], length) == 0);
+    }
+    return total;
+  }
+
+  template <typename DecompressorT>
+  double time_decode(DynamicBuffer &data, vector<size_t> &block_offsets,
+                     size_t iterations) {
+    DecompressorT decompressor;
+    Key key;
+    Stopwatch stopwatch;
+    for (size_t i=0; i<iterations; i++) {
+      for (size_t j=0; j+1<block_offsets.size(); j++) {
+        const uint8_t *ptr = data.base + block_offsets[j];
+        const uint8_t *end = data.base + block_offsets[j+1];
+        decompressor.reset();
+        while (ptr < end) {
+          ptr = decompressor.add(ptr);
+          decompressor.load(key);
+          ptr += ByteString(ptr).length();
+        }
+      }
+    }
+    stopwatch.stop();
+    return stopwatch.elapsed();
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  size_t count = 200000;
+  size_t blocksize = 65536;
+
+  for (int i=1; i<argc; i++) {
+    if (!strncmp(argv[i], "--count=", 8))
+      count = (size_t)atoi(&argv[i][8]);
+    else if (!strncmp(argv[i], "--blocksize=", 12))
+      blocksize = (size_t)atoi(&argv[i][12]);
+    else
+      Usage::dump_and_exit(usage);
+  }
+
+  try {
+    DynamicBuffer keys(count * 64);
+    DynamicBuffer prefix_data(count * 64);
+    DynamicBuffer delta_data(count * 64);
+    vector<size_t> offsets, prefix_blocks, delta_blocks;
+
+    generate_keys(count, keys, offsets);
+
+    build_blocks<KeyCompressorPrefix>(keys, offsets, blocksize, prefix_data,
+                                      prefix_blocks);
+    verify_blocks<KeyDecompressorPrefix>(keys, offsets, prefix_data,
+                                         prefix_blocks);
+
+    build_blocks<KeyCompressorDelta>(keys, offsets, blocksize, delta_data,
+                                     delta_blocks);
+    verify_blocks<KeyDecompressorDelta>(keys, offsets, delta_data,
+                                        delta_blocks);
+    size_t columnar_size = verify_streams(delta_data, delta_blocks);
+
+    cout << count << " cells, " << keys.fill() << " bytes" << endl;
+    cout << "prefix: " << prefix_data.fill() << " bytes in "
+         << prefix_blocks.size()-1 << " blocks, decode "
+         << (double)(count*10) /
+            time_decode<KeyDecompressorPrefix>(prefix_data, prefix_blocks, 10)
+         << " keys/s" << endl;
+    cout << "delta: " << delta_data.fill() << " bytes in "
+         << delta_blocks.size()-1 << " blocks, decode "
+         << (double)(count*10) /
+            time_decode<KeyDecompressorDelta>(delta_data, delta_blocks, 10)
+         << " keys/s" << endl;
+    cout << "columnar: " << columnar_size << " bytes" << endl;
+
+    HT_ASSERT(delta_data.fill() < prefix_data.fill());
+  }
+  catch (Exception &e) {
+    HT_FATAL_OUT << e << HT_END;
+  }
+
+  return 0;
+}
@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hypertable/RangeServer/KeyDecompressorPrefix.h>
+
+#include <Hypertable/Lib/Key.h>
+#include <Hypertable/Lib/SerializedKey.h>
+
+#include <Common/DynamicBuffer.h>
+#include <Common/Logger.h>
+#include <Common/MemoryCompare.h>
+#include <Common/Random.h>
+#include <Common/Serialization.h>
+#include <Common/Stopwatch.h>
+#include <Common/Usage.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <queue>
+#include <vector>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *usage[] = {
+    "usage: KeyDecompressorPrefix_test [--count=<n>] [--runs=<n>]",
+    "",
+    "  This program checks each memory_compare() implementation supported by",
+    "  the CPU against memcmp(), verifies that KeyDecompressorPrefix rebuilds",
+    "  the keys of a generated CellStore block exactly, and reports the time",
+    "  to decode the block and to merge <runs> sorted key runs through a heap",
+    "  ordered as MergeScannerAccessGroup orders it, before and after keys",
+    "  were compared with Key::compare_serial(), for each memory_compare()",
+    "  implementation.",
+    (const char *)0
+  };
+
+  const char *implementations[] = { "scalar", "sse2", "avx2" };
+
+  int sign(int value) {
+    return (value > 0) - (value < 0);
+  }
+
+  void test_memory_compare() {
+    uint8_t buf1[256], buf2[256];
+
+    for (auto name : implementations) {
+      if (!set_memory_compare_implementation(name)) {
+        cout << name << " not supported" << endl;
+        continue;
+      }
+      for (int i=0; i<200000; i++) {
+        size_t len = Random::number32() % 160;
+        size_t offset = Random::number32() % 16;
+        for (size_t j=0; j<len+offset; j++)
+          buf1[j] = buf2[j] = (uint8_t)Random::number32();
+        if (len && Random::number32() % 4) {
+          size_t pos = offset + Random::number32() % len;
+          buf2[pos] = (uint8_t)Random::number32();
+        }
+        int expected = sign(memcmp(buf1+offset, buf2+offset, len));
+        HT_ASSERT(sign(memory_compare(buf1+offset, buf2+offset, len)) == expected);
+        HT_ASSERT(sign(memory_compare(buf2+offset, buf1+offset, len)) == -expected);
+      }
+    }
+  }
+
+  /// Generates count sorted keys, several columns per row
+  void generate_keys(size_t count, DynamicBuffer &keys, vector<size_t> &offsets) {
+    char rowbuf[32], qualbuf[32];
+    int64_t revision = 1;
+    uint32_t row = 0;
+
+    keys.clear();
+    offsets.clear();
+    while (offsets.size() < count) {
+      row += 1 + Random::number32() % 8;
+      sprintf(rowbuf, "com.example.www/%08u/index.html", (unsigned)row);
+      for (uint8_t cf=1; cf<=3 && offsets.size() < count; cf++) {
+        sprintf(qualbuf, "q%02u", (unsigned)(Random::number32() % 100));
+        offsets.push_back(keys.fill());
+        create_key_and_append(keys, FLAG_INSERT, rowbuf, cf, qualbuf,
+                              revision, revision);
+        revision++;
+      }
+    }
+  }
+
+  /// Writes each key with the longest prefix it shares with the previous
+  /// key, followed by a small value
+  void build_block(DynamicBuffer &keys, vector<size_t> &offsets,
+                   DynamicBuffer &block) {
+    const uint8_t *last {};
+    size_t last_len {};
+    const char *value = "v";
+
+    block.clear();
+    for (auto offset : offsets) {
+      const uint8_t *ptr;
+      size_t len = SerializedKey(keys.base + offset).decode_length(&ptr);
+      uint8_t control = *ptr++;
+      len--;
+      uint32_t matching = 0;
+      while (matching < len && matching < last_len &&
+             ptr[matching] == last[matching])
+        matching++;
+      size_t suffix_len = len - matching;
+      block.ensure(16 + suffix_len);
+      Serialization::encode_vi32(&block.ptr, 1 +
+          Serialization::encoded_length_vi32(matching) + suffix_len);
+      *block.ptr++ = control;
+      Serialization::encode_vi32(&block.ptr, matching);
+      block.add_unchecked(ptr + matching, suffix_len);
+      append_as_byte_string(block, value, 1);
+      last = ptr;
+      last_len = len;
+    }
+  }
+
+  void test_decompressor(DynamicBuffer &keys, vector<size_t> &offsets,
+                         DynamicBuffer &block) {
+    KeyDecompressorPrefix decompressor;
+    const uint8_t *ptr = block.base;
+    Key key;
+
+    decompressor.reset();
+    for (auto offset : offsets) {
+      SerializedKey expected(keys.base + offset);
+      ptr = decompressor.add(ptr);
+      decompressor.load(key);
+      HT_ASSERT(key.serial == expected);
+      HT_ASSERT(key.length == expected.length());
+      HT_ASSERT(memcmp(key.serial.ptr, expected.ptr, expected.length()) == 0);
+      HT_ASSERT(!decompressor.less_than(expected));
+      ptr += ByteString(ptr).length();
+    }
+    HT_ASSERT(ptr == block.ptr);
+  }
+
+  /// Decompressor that copies the whole shared prefix for every key, as
+  /// KeyDecompressorPrefix used to, for comparison
+  class CopyingKeyDecompressor {
+  public:
+    void reset() {
+      m_bufs[0].clear();
+      m_bufs[1].clear();
+      m_current_base = 0;
+      m_first = false;
+    }
+    const uint8_t *add(const uint8_t *next_base) {
+      int current = m_first ? 0 : 1;
+      int next = m_first ? 1 : 0;
+      const uint8_t *next_ptr;
+      SerializedKey serkey(next_base);
+      size_t next_length = serkey.decode_length(&next_ptr);
+      uint8_t control = *next_ptr++;
+      size_t remaining = next_length - 1;
+      uint32_t matching = Serialization::decode_vi32(&next_ptr, &remaining);
+      HT_ASSERT(matching <= m_bufs[current].fill());
+      m_bufs[next].clear();
+      m_bufs[next].ensure(8+matching+remaining);
+      Serialization::encode_vi32(&m_bufs[next].ptr, 1+matching+remaining);
+      *(m_bufs[next].ptr)++ = control;
+      if (matching)
+        memcpy(m_bufs[next].ptr, m_current_base, matching);
+      m_current_base = m_bufs[next].ptr;
+      m_bufs[next].ptr += matching;
+      m_bufs[next].add_unchecked(next_ptr, remaining);
+      m_serialized_key.ptr = m_bufs[next].base;
+      m_first = !m_first;
+      return next_ptr + remaining;
+    }
+    void load(Key &key) { key.load(m_serialized_key); }
+  private:
+    SerializedKey m_serialized_key;
+    DynamicBuffer m_bufs[2];
+    const uint8_t *m_current_base {};
+    bool m_first {};
+  };
+
+  template <typename DecompressorT>
+  double time_decode(DynamicBuffer &block, size_t iterations) {
+    DecompressorT decompressor;
+    Key key;
+    Stopwatch stopwatch;
+    for (size_t i=0; i<iterations; i++) {
+      const uint8_t *ptr = block.base;
+      decompressor.reset();
+      while (ptr < block.ptr) {
+        ptr = decompressor.add(ptr);
+        decompressor.load(key);
+        ptr += ByteString(ptr).length();
+      }
+    }
+    stopwatch.stop();
+    return stopwatch.elapsed();
+  }
+
+  struct HeapEntry {
+    Key key;
+    size_t run;
+    size_t index;
+  };
+
+  /// Orders the heap as MergeScannerAccessGroup used to
+  struct GtSerializedKey {
+    bool operator()(const HeapEntry &e1, const HeapEntry &e2) const {
+      return e1.key.serial > e2.key.serial;
+    }
+  };
+
+  /// Orders the heap as MergeScannerAccessGroup does
+  struct GtKey {
+    bool operator()(const HeapEntry &e1, const HeapEntry &e2) const {
+      return e1.key.compare_serial(e2.key) > 0;
+    }
+  };
+
+  /// Merges runs the way MergeScannerAccessGroup merges its scanners
+  template <typename CompareT>
+  double time_merge(DynamicBuffer &keys, vector<vector<size_t>> &runs,
+                    size_t expected_count) {
+    priority_queue<HeapEntry, vector<HeapEntry>, CompareT> heap;
+    SerializedKey last;
+    HeapEntry entry;
+    size_t count {};
+    Stopwatch stopwatch;
+
+    for (size_t i=0; i<runs.size(); i++) {
+      if (!runs[i].empty()) {
+        entry.key.load(SerializedKey(keys.base + runs[i][0]));
+        entry.run = i;
+        entry.index = 0;
+        heap.push(entry);
+      }
+    }
+    while (!heap.empty()) {
+      entry = heap.top();
+      heap.pop();
+      HT_ASSERT(last.ptr == 0 || last <= entry.key.serial);
+      last = entry.key.serial;
+      count++;
+      if (++entry.index < runs[entry.run].size()) {
+        entry.key.load(SerializedKey(keys.base + runs[entry.run][entry.index]));
+        heap.push(entry);
+      }
+    }
+    stopwatch.stop();
+    HT_ASSERT(count == expected_count);
+    return stopwatch.elapsed();
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  size_t count = 200000;
+  size_t run_count = 8;
+
+  for (int i=1; i<argc; i++) {
+    if (!strncmp(argv[i], "--count=", 8))
+      count = (size_t)atoi(&argv[i][8]);
+    else if (!strncmp(argv[i], "--runs=", 7))
+      run_count = (size_t)atoi(&argv[i][7]);
+    else if (!strcmp(argv[i], "--help"))
+      Usage::dump_and_exit(usage);
+  }
+
+  try {
+    const char *default_implementation = memory_compare_implementation();
+    DynamicBuffer keys(count * 64);
+    DynamicBuffer block(count * 32);
+    vector<size_t> offsets;
+
+    cout << "memory_compare implementation: " << default_implementation
+         << endl;
+
+    test_memory_compare();
+
+    generate_keys(count, keys, offsets);
+    build_block(keys, offsets, block);
+    test_decompressor(keys, offsets, block);
+
+    cout << count << " keys, " << keys.fill() << " bytes prefix compressed to "
+         << block.fill() << " bytes" << endl;
+    cout << "decode (copying prefix): "
+         << (double)(count*10) / time_decode<CopyingKeyDecompressor>(block, 10)
+         << " keys/s" << endl;
+    cout << "decode: "
+         << (double)(count*10) / time_decode<KeyDecompressorPrefix>(block, 10)
+         << " keys/s" << endl;
+
+    // Deal keys round robin into runs so every merge step compares keys
+    // with long common prefixes
+    vector<vector<size_t>> runs(run_count);
+    for (size_t i=0; i<offsets.size(); i++)
+      runs[i % run_count].push_back(offsets[i]);
+
+    set_memory_compare_implementation("scalar");
+    cout << "merge (SerializedKey compare, memcmp): "
+         << (double)count / time_merge<GtSerializedKey>(keys, runs, count)
+         << " keys/s" << endl;
+    for (auto name : implementations) {
+      if (!set_memory_compare_implementation(name))
+        continue;
+      cout << "merge (Key compare, " << name << "): "
+           << (double)count / time_merge<GtKey>(keys, runs, count)
+           << " keys/s" << endl;
+    }
+    set_memory_compare_implementation(default_implementation);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hypertable/RangeServer/ScanAggregator.h>
+#include <Hypertable/RangeServer/ScanContext.h>
+
+#include <Hypertable/Lib/Key.h>
+#include <Hypertable/Lib/ScanAggregateCombiner.h>
+#include <Hypertable/Lib/ScanCells.h>
+
+#include <Common/ByteString.h>
+#include <Common/DynamicBuffer.h>
+#include <Common/Logger.h>
+#include <Common/Serialization.h>
+#include <Common/String.h>
+#include <Common/Usage.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *usage[] = {
+    "usage: ScanAggregator_test",
+    "",
+    "  This program checks that ScanAggregator groups cells by row, row prefix",
+    "  and column family and computes COUNT, SUM, MIN and MAX over ASCII and",
+    "  counter values, and that ScanAggregateCombiner combines the partial",
+    "  aggregates of groups that span ranges into the aggregates of a scan",
+    "  over a single range.",
+    (const char *)0
+  };
+
+  const uint8_t COUNTER_FAMILY = 2;
+
+  struct Result {
+    string row;
+    uint8_t family;
+    string value;
+    int64_t timestamp;
+  };
+
+  void add_cell(DynamicBuffer &buf, const char *row, uint8_t family,
+                const char *qualifier, int64_t timestamp, const char *value) {
+    create_key_and_append(buf, FLAG_INSERT, row, family, qualifier,
+                          timestamp, timestamp);
+    append_as_byte_string(buf, value);
+  }
+
+  void add_counter(DynamicBuffer &buf, const char *row, int64_t timestamp,
+                   int64_t count) {
+    uint8_t encoded[9];
+    uint8_t *ptr = encoded;
+    Serialization::encode_i64(&ptr, count);
+    *ptr = '=';
+    create_key_and_append(buf, FLAG_INSERT, row, COUNTER_FAMILY, "",
+                          timestamp, timestamp);
+    append_as_byte_string(buf, encoded, sizeof(encoded));
+  }
+
+  void drain(ScanAggregator &aggregator, vector<Result> &results) {
+    Key key;
+    ByteString value;
+    while (aggregator.get(key, value)) {
+      const uint8_t *ptr;
+      size_t len = value.decode_length(&ptr);
+      HT_ASSERT(key.flag == FLAG_INSERT);
+      HT_ASSERT(*key.column_qualifier == 0);
+      results.push_back({key.row, key.column_family_code,
+            string((const char *)ptr, len), key.timestamp});
+      aggregator.forward();
+    }
+  }
+
+  vector<Result> aggregate(uint8_t function, int32_t row_prefix_length,
+                           DynamicBuffer &input) {
+    ScanSpec spec;
+    spec.aggregate = function;
+    spec.aggregate_row_prefix_length = row_prefix_length;
+    ScanContext scan_ctx;
+    scan_ctx.spec = &spec;
+    scan_ctx.cell_predicates[COUNTER_FAMILY].counter = true;
+
+    ScanAggregator aggregator(&scan_ctx);
+    vector<Result> results;
+    Key key;
+    ByteString value;
+    const uint8_t *ptr = input.base;
+    while (ptr < input.ptr) {
+      key.load(SerializedKey(ptr));
+      value.ptr = ptr + key.length;
+      while (!aggregator.add(key, value))
+        drain(aggregator, results);
+      ptr = value.ptr + value.length();
+    }
+    aggregator.finish();
+    drain(aggregator, results);
+    return results;
+  }
+
+  /// Aggregates the input split into ranges ending at the given rows.
+  /// The partial aggregates of each range are delivered to a
+  /// ScanAggregateCombiner in a callback of their own, as TableScannerAsync
+  /// does when the ranges are scanned.
+  vector<Result> aggregate_ranges(uint8_t function, int32_t row_prefix_length,
+                                  DynamicBuffer &input,
+                                  const vector<string> &end_rows) {
+    vector<DynamicBuffer> ranges(end_rows.size() + 1);
+    size_t range = 0;
+    Key key;
+    const uint8_t *ptr = input.base;
+    while (ptr < input.ptr) {
+      key.load(SerializedKey(ptr));
+      ByteString value(ptr + key.length);
+      const uint8_t *end = value.ptr + value.length();
+      while (range < end_rows.size() && end_rows[range] < key.row)
+        range++;
+      ranges[range].add(ptr, end - ptr);
+      ptr = end;
+    }
+
+    ScanAggregateCombiner combiner(function);
+    vector<Result> results;
+    for (size_t i=0; i<ranges.size(); i++) {
+      Lib::ScanCells cells;
+      for (auto &partial : aggregate(function, row_prefix_length, ranges[i])) {
+        String family = format("%d", (int)partial.family);
+        Cell cell(partial.row.c_str(), family.c_str(), "",
+                  partial.timestamp, partial.timestamp,
+                  (uint8_t *)partial.value.c_str(), partial.value.length(),
+                  FLAG_INSERT);
+        cells.add(cell);
+      }
+      if (i == ranges.size() - 1)
+        cells.set_eos();
+      combiner.combine(cells);
+      Cells combined;
+      cells.get(combined);
+      for (auto &cell : combined)
+        results.push_back({cell.row_key, (uint8_t)atoi(cell.column_family),
+              string((const char *)cell.value, cell.value_len),
+              cell.timestamp});
+    }
+    HT_ASSERT(!combiner.pending());
+    return results;
+  }
+
+  void check(const vector<Result> &results, size_t i, const char *row,
+             uint8_t family, const char *value) {
+    HT_ASSERT(i < results.size());
+    if (results[i].row != row || results[i].family != family ||
+        results[i].value != value) {
+      cout << "Result " << i << " is (" << results[i].row << ", "
+           << (int)results[i].family << ", " << results[i].value
+           << "), expected (" << row << ", " << (int)family << ", "
+           << value << ")" << endl;
+      HT_ASSERT(!"unexpected aggregate");
+    }
+  }
+
+  void load_input(DynamicBuffer &buf) {
+    add_cell(buf, "apple", 1, "a", 3000, "10");
+    add_cell(buf, "apple", 1, "b", 1000, "-3");
+    add_cell(buf, "apple", 1, "c", 2000, "pie");
+    add_counter(buf, "apple", 1000, 5);
+    add_cell(buf, "apricot", 1, "", 1000, "7");
+    add_counter(buf, "apricot", 4000, 20);
+    add_cell(buf, "banana", 1, "", 1000, "banana");
+    add_cell(buf, "banana", 3, "", 1000, "2");
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+
+  if (argc > 1)
+    Usage::dump_and_exit(usage);
+
+  try {
+    DynamicBuffer input;
+    vector<Result> results;
+
+    load_input(input);
+
+    // COUNT by row
+    results = aggregate(ScanSpec::AGGREGATE_COUNT, -1, input);
+    HT_ASSERT(results.size() == 6);
+    check(results, 0, "apple", 1, "3");
+    HT_ASSERT(results[0].timestamp == 3000);
+    check(results, 1, "apple", COUNTER_FAMILY, "1");
+    check(results, 2, "apricot", 1, "1");
+    check(results, 3, "apricot", COUNTER_FAMILY, "1");
+    check(results, 4, "banana", 1, "1");
+    check(results, 5, "banana", 3, "1");
+
+    // SUM by row prefix; non-integer values are ignored
+    results = aggregate(ScanSpec::AGGREGATE_SUM, 2, input);
+    HT_ASSERT(results.size() == 3);
+    check(results, 0, "ap", 1, "14");
+    check(results, 1, "ap", COUNTER_FAMILY, "25");
+    HT_ASSERT(results[1].timestamp == 4000);
+    check(results, 2, "ba", 3, "2");
+
+    // MIN and MAX by column
+    results = aggregate(ScanSpec::AGGREGATE_MIN, 0, input);
+    HT_ASSERT(results.size() == 3);
+    check(results, 0, "", 1, "-3");
+    check(results, 1, "", COUNTER_FAMILY, "5");
+    check(results, 2, "", 3, "2");
+
+    results = aggregate(ScanSpec::AGGREGATE_MAX, 0, input);
+    HT_ASSERT(results.size() == 3);
+    check(results, 0, "", 1, "10");
+    check(results, 1, "", COUNTER_FAMILY, "20");
+    check(results, 2, "", 3, "2");
+
+    // Prefix longer than the rows groups by full row
+    results = aggregate(ScanSpec::AGGREGATE_COUNT, 100, input);
+    HT_ASSERT(results.size() == 6);
+    check(results, 2, "apricot", 1, "1");
+
+    // Groups of two column families spanning two ranges arrive as
+    // interleaved partial aggregates and are combined per family
+    results = aggregate_ranges(ScanSpec::AGGREGATE_SUM, 2, input, {"apple"});
+    HT_ASSERT(results.size() == 3);
+    check(results, 0, "ap", 1, "14");
+    check(results, 1, "ap", COUNTER_FAMILY, "25");
+    HT_ASSERT(results[1].timestamp == 4000);
+    check(results, 2, "ba", 3, "2");
+
+    // Any split into ranges gives the aggregates of a single range
+    vector<vector<string>> splits { {"apple"}, {"apricot"},
+        {"apple", "apricot"}, {"apple", "apricot", "banana"} };
+    for (uint8_t function : { ScanSpec::AGGREGATE_COUNT,
+          ScanSpec::AGGREGATE_SUM, ScanSpec::AGGREGATE_MIN,
+          ScanSpec::AGGREGATE_MAX }) {
+      for (int32_t row_prefix_length : { -1, 0, 1, 2 }) {
+        vector<Result> expected = aggregate(function, row_prefix_length, input);
+        for (auto &end_rows : splits) {
+          results = aggregate_ranges(function, row_prefix_length, input,
+                                     end_rows);
+          HT_ASSERT(results.size() == expected.size());
+          for (size_t i=0; i<expected.size(); i++) {
+            check(results, i, expected[i].row.c_str(), expected[i].family,
+                  expected[i].value.c_str());
+            HT_ASSERT(results[i].timestamp == expected[i].timestamp);
+          }
+        }
+      }
+    }
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,310 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hypertable/RangeServer/CellCacheSkipList.h>
+#include <Hypertable/RangeServer/FillScanBlock.h>
+#include <Hypertable/RangeServer/Global.h>
+#include <Hypertable/RangeServer/MergeScannerAccessGroup.h>
+#include <Hypertable/RangeServer/MergeScannerRange.h>
+#include <Hypertable/RangeServer/ScanContext.h>
+#include <Hypertable/RangeServer/SharedScan.h>
+#include <Hypertable/RangeServer/SharedScanMap.h>
+
+#include <Hypertable/Lib/Key.h>
+#include <Hypertable/Lib/RangeSpec.h>
+#include <Hypertable/Lib/ScanSpec.h>
+#include <Hypertable/Lib/Schema.h>
+#include <Hypertable/Lib/TableIdentifier.h>
+
+#include <Common/Config.h>
+#include <Common/DynamicBuffer.h>
+#include <Common/Init.h>
+#include <Common/Usage.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *usage[] = {
+    "usage: SharedScan_test [--count=<n>] [--threads=<n>]",
+    "",
+    "  This program verifies that scanners attached to a SharedScan, both",
+    "  from the start and after joining a scan in progress, receive exactly",
+    "  the scan blocks of a private scan while the cells are scanned once,",
+    "  and that a scan over its memory limit, or one that could not be",
+    "  inserted into the map, can no longer be joined and drops the blocks",
+    "  every scanner has fetched.  Buffered blocks must be accounted in the",
+    "  memory tracker.",
+    (const char *)0
+  };
+
+  const char *schema_str =
+  "<Schema>\n"
+  "  <AccessGroup name=\"default\">\n"
+  "    <ColumnFamily id=\"1\">\n"
+  "      <Name>tag</Name>\n"
+  "    </ColumnFamily>\n"
+  "  </AccessGroup>\n"
+  "</Schema>";
+
+  String table_id("1");
+
+  const int64_t BUFFER_SIZE = 64 * 1024;
+
+  MergeScannerRangePtr create_scanner(CellCachePtr &cache,
+                                      ScanContextPtr &scan_ctx) {
+    MergeScannerRangePtr scanner =
+      make_shared<MergeScannerRange>(table_id, scan_ctx);
+    MergeScannerAccessGroup *ag =
+      new MergeScannerAccessGroup(table_id, scan_ctx.get());
+    ag->add_scanner(cache->create_scanner(scan_ctx.get()));
+    scanner->add_scanner(ag);
+    return scanner;
+  }
+
+  /// Fetches all blocks of a cursor, concatenated into <code>dbuf</code>
+  void read_all(SharedScanCursorPtr cursor, DynamicBuffer *dbuf,
+                ProfileDataScanner *profile_data) {
+    SharedScan::Block block;
+    ProfileDataScanner block_profile_data;
+    do {
+      cursor->fetch(block, block_profile_data);
+      dbuf->add(block.data.get(), block.length);
+      *profile_data += block_profile_data;
+    } while (block.more);
+  }
+
+  void verify(DynamicBuffer &expected, DynamicBuffer &dbuf) {
+    HT_ASSERT(dbuf.fill() == expected.fill());
+    HT_ASSERT(memcmp(dbuf.base, expected.base, expected.fill()) == 0);
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  size_t count = 20000;
+  size_t threads = 8;
+
+  for (int i=1; i<argc; i++) {
+    if (!strncmp(argv[i], "--count=", 8))
+      count = (size_t)atoi(&argv[i][8]);
+    else if (!strncmp(argv[i], "--threads=", 10))
+      threads = (size_t)atoi(&argv[i][10]);
+    else
+      Usage::dump_and_exit(usage);
+  }
+
+  try {
+    Config::init(0, 0);
+    Global::cell_cache_scanner_cache_size = 1024;
+    Global::memory_tracker = new MemoryTracker(0, 0);
+
+    SchemaPtr schema(Schema::new_instance(schema_str));
+    RangeSpec range("", Key::END_ROW_MARKER);
+    ScanSpecBuilder ssbuilder;
+    ScanContextPtr scan_ctx =
+      make_shared<ScanContext>(TIMESTAMP_MAX, &(ssbuilder.get()), &range,
+                               schema);
+    TableIdentifier table(table_id.c_str());
+
+    CellCachePtr cache = make_shared<CellCacheSkipList>();
+    DynamicBuffer kbuf, vbuf;
+    char rowbuf[32];
+    Key key;
+    for (size_t i=0; i<count; i++) {
+      sprintf(rowbuf, "row%012u", (unsigned)i);
+      kbuf.clear();
+      create_key_and_append(kbuf, FLAG_INSERT, rowbuf, 1, "q",
+                            (int64_t)i+1, (int64_t)i+1);
+      key.load(SerializedKey(kbuf.base));
+      vbuf.clear();
+      append_as_byte_string(vbuf, rowbuf, strlen(rowbuf));
+      cache->lock();
+      cache->add(key, ByteString(vbuf.base));
+      cache->unlock();
+    }
+
+    // Blocks of a private scan
+    DynamicBuffer expected;
+    int64_t expected_cells_scanned;
+    size_t expected_blocks = 0;
+    {
+      MergeScannerRangePtr scanner = create_scanner(cache, scan_ctx);
+      bool more;
+      do {
+        DynamicBuffer rbuf;
+        more = FillScanBlock(scanner, rbuf, 0, BUFFER_SIZE);
+        expected.add(rbuf.base, rbuf.fill());
+        expected_blocks++;
+      } while (more);
+      expected_cells_scanned = scanner->get_input_cells();
+    }
+    HT_ASSERT(expected_blocks > 4);
+
+    // Memory tracked for the cell cache, to which shared scans add blocks
+    int64_t tracked = Global::memory_tracker->balance();
+
+    String shared_scan_key =
+      SharedScanMap::key(table, range, TIMESTAMP_MAX, ssbuilder.get());
+
+    // Concurrent scanners, half of them joining through the map
+    {
+      SharedScanMap map(1024*1024*1024);
+      MergeScannerRangePtr scanner = create_scanner(cache, scan_ctx);
+      SharedScanPtr scan =
+        make_shared<SharedScan>(scanner, BUFFER_SIZE, 1024*1024*1024);
+      scanner.reset();
+      HT_ASSERT(map.insert(shared_scan_key, scan));
+      vector<DynamicBuffer> results(threads);
+      vector<ProfileDataScanner> profile_data(threads);
+      vector<thread> workers;
+      for (size_t i=0; i<threads; i++) {
+        SharedScanCursorPtr cursor =
+          (i % 2) ? map.join(shared_scan_key) : scan->attach();
+        HT_ASSERT(cursor);
+        workers.emplace_back(read_all, cursor, &results[i], &profile_data[i]);
+      }
+      for (auto &worker : workers)
+        worker.join();
+      int64_t cells_scanned = 0;
+      for (size_t i=0; i<threads; i++) {
+        verify(expected, results[i]);
+        cells_scanned += profile_data[i].cells_scanned;
+      }
+      HT_ASSERT(cells_scanned == expected_cells_scanned);
+      // All scanners are done, so the scan is released
+      HT_ASSERT(!scan->joinable() && scan->memory_used() == 0);
+      HT_ASSERT(Global::memory_tracker->balance() == tracked);
+      HT_ASSERT(!map.join(shared_scan_key));
+    }
+
+    // Scan with the key of a scan already in the map
+    {
+      SharedScanMap map(1024*1024*1024);
+      MergeScannerRangePtr scanner = create_scanner(cache, scan_ctx);
+      SharedScanPtr scan =
+        make_shared<SharedScan>(scanner, BUFFER_SIZE, 1024*1024*1024);
+      scanner = create_scanner(cache, scan_ctx);
+      SharedScanPtr duplicate =
+        make_shared<SharedScan>(scanner, BUFFER_SIZE, 1024*1024*1024);
+      scanner.reset();
+      SharedScanCursorPtr cursor = duplicate->attach();
+      HT_ASSERT(map.insert(shared_scan_key, scan));
+      HT_ASSERT(!map.insert(shared_scan_key, duplicate));
+      HT_ASSERT(scan->joinable() && !duplicate->joinable());
+      // Blocks of the scan that was not inserted are dropped once fetched
+      SharedScan::Block block;
+      ProfileDataScanner profile_data;
+      cursor->fetch(block, profile_data);
+      HT_ASSERT(duplicate->memory_used() == 0);
+      HT_ASSERT(Global::memory_tracker->balance() == tracked);
+    }
+
+    // Scanner joining after the leader has read part of the scan
+    {
+      SharedScanMap map(1024*1024*1024);
+      MergeScannerRangePtr scanner = create_scanner(cache, scan_ctx);
+      SharedScanPtr scan =
+        make_shared<SharedScan>(scanner, BUFFER_SIZE, 1024*1024*1024);
+      scanner.reset();
+      SharedScanCursorPtr leader = scan->attach();
+      SharedScan::Block block;
+      ProfileDataScanner profile_data;
+      DynamicBuffer leader_result, joiner_result;
+      for (size_t i=0; i<expected_blocks/2; i++) {
+        leader->fetch(block, profile_data);
+        leader_result.add(block.data.get(), block.length);
+      }
+      HT_ASSERT(map.insert(shared_scan_key, scan));
+      ProfileDataScanner joiner_profile_data;
+      read_all(map.join(shared_scan_key), &joiner_result, &joiner_profile_data);
+      verify(expected, joiner_result);
+      do {
+        leader->fetch(block, profile_data);
+        leader_result.add(block.data.get(), block.length);
+        // Blocks filled by the joiner are replayed without scanning
+        HT_ASSERT(profile_data.cells_scanned == 0);
+      } while (block.more);
+      verify(expected, leader_result);
+      // Blocks are kept while the scan can be joined
+      HT_ASSERT(Global::memory_tracker->balance() ==
+                tracked + scan->memory_used());
+    }
+    HT_ASSERT(Global::memory_tracker->balance() == tracked);
+
+    // Scan over its memory limit
+    {
+      SharedScanMap map(1024*1024*1024);
+      MergeScannerRangePtr scanner = create_scanner(cache, scan_ctx);
+      SharedScanPtr scan =
+        make_shared<SharedScan>(scanner, BUFFER_SIZE, 2*BUFFER_SIZE);
+      scanner.reset();
+      SharedScanCursorPtr leader = scan->attach();
+      SharedScanCursorPtr follower = scan->attach();
+      HT_ASSERT(map.insert(shared_scan_key, scan));
+      SharedScan::Block block;
+      ProfileDataScanner profile_data;
+      DynamicBuffer leader_result, follower_result;
+      for (size_t i=0; i<3; i++) {
+        leader->fetch(block, profile_data);
+        leader_result.add(block.data.get(), block.length);
+      }
+      HT_ASSERT(!scan->joinable());
+      HT_ASSERT(!map.join(shared_scan_key));
+      HT_ASSERT(!scan->attach());
+      // Follower still gets every block, which are dropped behind it
+      int64_t memory_used = scan->memory_used();
+      for (size_t i=0; i<3; i++) {
+        follower->fetch(block, profile_data);
+        follower_result.add(block.data.get(), block.length);
+      }
+      HT_ASSERT(scan->memory_used() < memory_used);
+      HT_ASSERT(Global::memory_tracker->balance() ==
+                tracked + scan->memory_used());
+      do {
+        leader->fetch(block, profile_data);
+        leader_result.add(block.data.get(), block.length);
+      } while (block.more);
+      verify(expected, leader_result);
+      ProfileDataScanner follower_profile_data;
+      read_all(follower, &follower_result, &follower_profile_data);
+      verify(expected, follower_result);
+      HT_ASSERT(scan->memory_used() == 0);
+      HT_ASSERT(Global::memory_tracker->balance() == tracked);
+    }
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hypertable/RangeServer/CellCacheSkipList.h>
+#include <Hypertable/RangeServer/FillScanBlock.h>
+#include <Hypertable/RangeServer/Global.h>
+#include <Hypertable/RangeServer/MemoryTracker.h>
+#include <Hypertable/RangeServer/MergeScannerAccessGroup.h>
+#include <Hypertable/RangeServer/MergeScannerRange.h>
+#include <Hypertable/RangeServer/ScanContext.h>
+#include <Hypertable/RangeServer/ZeroCopyScanBlock.h>
+
+#include <Hypertable/Lib/Key.h>
+#include <Hypertable/Lib/RangeSpec.h>
+#include <Hypertable/Lib/ScanSpec.h>
+#include <Hypertable/Lib/Schema.h>
+
+#include <AsyncComm/CommBuf.h>
+#include <AsyncComm/CommHeader.h>
+
+#include <Common/Config.h>
+#include <Common/DynamicBuffer.h>
+#include <Common/Init.h>
+#include <Common/Serialization.h>
+#include <Common/Stopwatch.h>
+#include <Common/Usage.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+}
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *usage[] = {
+    "usage: ZeroCopyScanBlock_test [--count=<n>] [--value-size=<n>] [--iterations=<n>]",
+    "",
+    "  This program verifies that scan blocks built with ZeroCopyScanBlock",
+    "  serialize to the same bytes as the copying FillScanBlock, that their",
+    "  segments survive partial writes, and reports scan MB/s of a cell cache",
+    "  pushed through a socket with and without copying.",
+    (const char *)0
+  };
+
+  const char *schema_str =
+  "<Schema>\n"
+  "  <AccessGroup name=\"default\">\n"
+  "    <ColumnFamily id=\"1\">\n"
+  "      <Name>tag</Name>\n"
+  "    </ColumnFamily>\n"
+  "  </AccessGroup>\n"
+  "</Schema>";
+
+  String table_id("1");
+
+  const int64_t BUFFER_SIZE = 1024 * 1024;
+
+  const size_t MIN_SEGMENT_SIZE = 4096;
+
+  MergeScannerRangePtr create_scanner(CellCachePtr &cache,
+                                      ScanContextPtr &scan_ctx) {
+    MergeScannerRangePtr scanner =
+      make_shared<MergeScannerRange>(table_id, scan_ctx);
+    MergeScannerAccessGroup *ag =
+      new MergeScannerAccessGroup(table_id, scan_ctx.get());
+    ag->add_scanner(cache->create_scanner(scan_ctx.get()));
+    scanner->add_scanner(ag);
+    return scanner;
+  }
+
+  /// Writes a CommBuf to a socket, a few iovecs at a time
+  void write_comm_buf(int fd, CommBuf *cbuf, int max_iovecs) {
+    iovec vec[64];
+    ssize_t towrite, nwritten;
+    cbuf->write_header_and_reset();
+    do {
+      int count = cbuf->fill_iovec(vec, max_iovecs, &towrite);
+      nwritten = writev(fd, vec, count);
+      HT_ASSERT(nwritten > 0);
+    } while (!cbuf->advance(nwritten));
+  }
+
+  /// Reads everything written to <code>fd</code> into <code>dbuf</code>
+  void drain(int fd, DynamicBuffer *dbuf, size_t *total) {
+    uint8_t buf[65536];
+    ssize_t nread;
+    while ((nread = read(fd, buf, sizeof(buf))) > 0) {
+      if (dbuf)
+        dbuf->add(buf, nread);
+      *total += nread;
+    }
+  }
+
+  void test_serialization(CellCachePtr &cache, ScanContextPtr &scan_ctx) {
+    MergeScannerRangePtr copy_scanner = create_scanner(cache, scan_ctx);
+    MergeScannerRangePtr zero_copy_scanner = create_scanner(cache, scan_ctx);
+    size_t referenced {};
+    bool more;
+
+    do {
+      DynamicBuffer rbuf;
+      more = FillScanBlock(copy_scanner, rbuf, 0, BUFFER_SIZE);
+
+      ZeroCopyScanBlockPtr block =
+        make_shared<ZeroCopyScanBlock>(MIN_SEGMENT_SIZE);
+      HT_ASSERT(FillScanBlock(zero_copy_scanner, *block, 0, BUFFER_SIZE)
+                == more);
+      HT_ASSERT(scan_ctx->zero_copy_block == nullptr);
+
+      DynamicBuffer flat;
+      block->copy_to(flat);
+      HT_ASSERT(flat.fill() == rbuf.fill() && block->size() == rbuf.fill());
+      HT_ASSERT(memcmp(flat.base, rbuf.base, rbuf.fill()) == 0);
+      referenced += block->referenced();
+
+      // Send through a socket a few iovecs at a time
+      int fds[2];
+      HT_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+      DynamicBuffer received;
+      size_t total {};
+      thread reader(drain, fds[1], &received, &total);
+      CommHeader header(1);
+      CommBufPtr cbuf = make_shared<CommBuf>(header, 4);
+      cbuf->append_i32(42);
+      block->append_to(cbuf.get());
+      block.reset();
+      write_comm_buf(fds[0], cbuf.get(), 3);
+      size_t total_len = cbuf->header.total_len;
+      cbuf.reset();
+      close(fds[0]);
+      reader.join();
+      close(fds[1]);
+      HT_ASSERT(total == total_len);
+      size_t offset = total_len - rbuf.fill();
+      HT_ASSERT(memcmp(received.base + offset, rbuf.base, rbuf.fill()) == 0);
+    } while (more);
+
+    HT_ASSERT(referenced > 0);
+  }
+
+  double scan(CellCachePtr &cache, ScanContextPtr &scan_ctx, bool zero_copy,
+              size_t *bytes) {
+    int fds[2];
+    HT_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    size_t total {};
+    thread reader(drain, fds[1], nullptr, &total);
+    MergeScannerRangePtr scanner = create_scanner(cache, scan_ctx);
+    Stopwatch stopwatch;
+    bool more;
+    do {
+      CommHeader header(1);
+      CommBufPtr cbuf;
+      if (zero_copy) {
+        ZeroCopyScanBlockPtr block =
+          make_shared<ZeroCopyScanBlock>(MIN_SEGMENT_SIZE);
+        more = FillScanBlock(scanner, *block, 0, BUFFER_SIZE);
+        cbuf = make_shared<CommBuf>(header, 4);
+        cbuf->append_i32(Error::OK);
+        block->append_to(cbuf.get());
+      }
+      else {
+        DynamicBuffer rbuf;
+        more = FillScanBlock(scanner, rbuf, 0, BUFFER_SIZE);
+        StaticBuffer ext(rbuf);
+        cbuf = make_shared<CommBuf>(header, 4, ext);
+        cbuf->append_i32(Error::OK);
+      }
+      write_comm_buf(fds[0], cbuf.get(), 64);
+    } while (more);
+    close(fds[0]);
+    reader.join();
+    close(fds[1]);
+    stopwatch.stop();
+    *bytes = total;
+    return stopwatch.elapsed();
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  size_t count = 20000;
+  size_t value_size = 16384;
+  int iterations = 3;
+
+  for (int i=1; i<argc; i++) {
+    if (!strncmp(argv[i], "--count=", 8))
+      count = (size_t)atoi(&argv[i][8]);
+    else if (!strncmp(argv[i], "--value-size=", 13))
+      value_size = (size_t)atoi(&argv[i][13]);
+    else if (!strncmp(argv[i], "--iterations=", 13))
+      iterations = atoi(&argv[i][13]);
+    else if (!strcmp(argv[i], "--help"))
+      Usage::dump_and_exit(usage);
+  }
+
+  try {
+    Config::init(0, 0);
+    Global::cell_cache_scanner_cache_size = 1024;
+    Global::memory_tracker = new MemoryTracker(0, 0);
+
+    SchemaPtr schema(Schema::new_instance(schema_str));
+    RangeSpec range("", Key::END_ROW_MARKER);
+    ScanSpecBuilder ssbuilder;
+    ScanContextPtr scan_ctx =
+      make_shared<ScanContext>(TIMESTAMP_MAX, &(ssbuilder.get()), &range,
+                               schema);
+
+    // Every eighth value is small and must be copied
+    CellCachePtr cache = make_shared<CellCacheSkipList>();
+    DynamicBuffer kbuf, vbuf;
+    vector<uint8_t> value_data(value_size, 'v');
+    char rowbuf[32];
+    Key key;
+    for (size_t i=0; i<count; i++) {
+      sprintf(rowbuf, "row%012u", (unsigned)i);
+      kbuf.clear();
+      create_key_and_append(kbuf, FLAG_INSERT, rowbuf, 1, "q",
+                            (int64_t)i+1, (int64_t)i+1);
+      key.load(SerializedKey(kbuf.base));
+      vbuf.clear();
+      value_data[0] = (uint8_t)i;
+      append_as_byte_string(vbuf, value_data.data(),
+                            (i % 8) ? value_size : 16);
+      cache->lock();
+      cache->add(key, ByteString(vbuf.base));
+      cache->unlock();
+    }
+
+    test_serialization(cache, scan_ctx);
+
+    for (auto zero_copy : { false, true }) {
+      double elapsed {};
+      size_t bytes {}, total {};
+      for (int i=0; i<iterations; i++) {
+        elapsed += scan(cache, scan_ctx, zero_copy, &bytes);
+        total += bytes;
+      }
+      cout << (zero_copy ? "zero-copy" : "copy") << " scan: " << total
+           << " bytes in " << elapsed << "s ("
+           << (double)total / (elapsed * 1024.0 * 1024.0) << " MB/s)" << endl;
+    }
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
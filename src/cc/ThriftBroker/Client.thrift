@@ -178,6 +178,27 @@ struct ColumnPredicate {
   4: optional string value
 }
 
+/**
+ * Aggregate function evaluated by the RangeServers for a scan
+ *
+ *  NONE: return the cells themselves
+ *
+ *  COUNT: number of cells in each group
+ *
+ *  SUM: sum of the integer values in each group
+ *
+ *  MIN: minimum of the integer values in each group
+ *
+ *  MAX: maximum of the integer values in each group
+ */
+enum AggregateFunction {
+  NONE  = 0,
+  COUNT = 1,
+  SUM   = 2,
+  MIN   = 3,
+  MAX   = 4
+}
+
 /** Specifies options for a scan
  *
  * <dl>
@@ -228,6 +249,16 @@ struct ColumnPredicate {
  *
  *   <dt>cell_offset</dt>
  *   <dd>Specifies number of cells to be skipped</dd>
+ *
+ *   <dt>aggregate</dt>
+ *   <dd>Specifies an AggregateFunction; instead of the matching cells, one
+ *   cell per group holding the aggregate as an ASCII integer is returned.
+ *   Cells are grouped by row (or row prefix) and column family</dd>
+ *
+ *   <dt>aggregate_row_prefix_length</dt>
+ *   <dd>Specifies the length of the row prefix by which cells are grouped;
+ *   -1 groups by full row and 0 aggregates each column family over all
+ *   rows</dd>
  * </dl>
  */
 struct ScanSpec {
@@ -250,6 +281,8 @@ struct ScanSpec {
   17:optional list<ColumnPredicate> column_predicates
   18:optional bool do_not_cache = 0
   19:optional bool and_column_predicates = 0
+  20:optional i32 aggregate = 0
+  21:optional i32 aggregate_row_prefix_length = -1
 }
 
 
@@ -49,8 +49,10 @@
 #include <Common/System.h>
 #include <Common/Time.h>
 
+#include <concurrency/PosixThreadFactory.h>
 #include <concurrency/ThreadManager.h>
 #include <protocol/TBinaryProtocol.h>
+#include <server/TNonblockingServer.h>
 #include <server/TThreadedServer.h>
 #include <transport/TBufferTransports.h>
 #include <transport/TServerSocket.h>
@@ -266,6 +268,26 @@ cell_str_to_num(const std::string &from, const char *label,
   return value;
 }
 
+uint8_t
+convert_aggregate(int32_t aggregate) {
+  switch (aggregate) {
+  case ThriftGen::AggregateFunction::NONE:
+    return Hypertable::ScanSpec::AGGREGATE_NONE;
+  case ThriftGen::AggregateFunction::COUNT:
+    return Hypertable::ScanSpec::AGGREGATE_COUNT;
+  case ThriftGen::AggregateFunction::SUM:
+    return Hypertable::ScanSpec::AGGREGATE_SUM;
+  case ThriftGen::AggregateFunction::MIN:
+    return Hypertable::ScanSpec::AGGREGATE_MIN;
+  case ThriftGen::AggregateFunction::MAX:
+    return Hypertable::ScanSpec::AGGREGATE_MAX;
+  default:
+    break;
+  }
+  HT_THROWF(Error::BAD_SCAN_SPEC, "Invalid aggregate function %d",
+            (int)aggregate);
+}
+
 void
 convert_scan_spec(const ThriftGen::ScanSpec &tss, Hypertable::ScanSpec &hss) {
   if (tss.__isset.row_limit)
@@ -313,6 +335,12 @@ convert_scan_spec(const ThriftGen::ScanSpec &tss, Hypertable::ScanSpec &hss) {
   if (tss.__isset.and_column_predicates)
     hss.and_column_predicates = tss.and_column_predicates;
 
+  if (tss.__isset.aggregate)
+    hss.aggregate = convert_aggregate(tss.aggregate);
+
+  if (tss.__isset.aggregate_row_prefix_length)
+    hss.aggregate_row_prefix_length = tss.aggregate_row_prefix_length;
+
   // shallow copy
   const char *start_row;
   const char *end_row;
@@ -405,6 +433,11 @@ convert_scan_spec(const ThriftGen::ScanSpec &tss, Hypertable::ScanSpecBuilder &s
   if (tss.__isset.and_column_predicates)
     ssb.set_and_column_predicates(tss.and_column_predicates);
 
+  if (tss.__isset.aggregate)
+    ssb.set_aggregate(convert_aggregate(tss.aggregate),
+                      tss.__isset.aggregate_row_prefix_length ?
+                      tss.aggregate_row_prefix_length : -1);
+
   // columns
   ssb.reserve_columns(tss.columns.size());
   for (auto & col : tss.columns)
@@ -3053,6 +3086,9 @@ void HqlCallback<ResultT, CellT>::on_finish(TableMutatorPtr &m) {
 
 namespace {
   Context *g_context = 0;
+
+  /// Worker pool of the nonblocking server (null in threaded mode)
+  boost::shared_ptr<concurrency::ThreadManager> g_thread_manager;
 }
 
 class ServerHandlerFactory {
@@ -3129,8 +3165,30 @@ public:
   virtual void releaseHandler( ::Hypertable::ThriftGen::ClientServiceIf *service) {
     ServerHandler* serverHandler = dynamic_cast<ServerHandler*>(service);
     g_metrics_handler->connection_decrement();
+    // The nonblocking server releases handlers on its I/O threads.  Releasing
+    // the last reference closes the peer's scanners and flushes its mutators,
+    // so hand that to a worker rather than stall every connection served by
+    // the I/O thread.
+    if (g_thread_manager) {
+      g_thread_manager->add(boost::shared_ptr<concurrency::Runnable>(
+                              new ReleaseHandlerTask(serverHandler)));
+      return;
+    }
     return ServerHandlerFactory::releaseHandler(serverHandler);
   }
+
+private:
+
+  /// Releases a handler on a worker thread
+  class ReleaseHandlerTask : public concurrency::Runnable {
+  public:
+    ReleaseHandlerTask(ServerHandler *handler) : m_handler(handler) { }
+    void run() override {
+      ServerHandlerFactory::releaseHandler(m_handler);
+    }
+  private:
+    ServerHandler *m_handler;
+  };
 };
 
 
@@ -3168,23 +3226,62 @@ int main(int argc, char **argv) {
     boost::shared_ptr<HqlServiceIfFactory> hql_service_factory(new ThriftBrokerIfFactory());
     boost::shared_ptr<TProcessorFactory> hql_service_processor_factory(new HqlServiceProcessorFactory(hql_service_factory));
 
-    boost::shared_ptr<TServerTransport> serverTransport;
+    String server_mode = get_str("ThriftBroker.Server");
+
+    if (server_mode == "nonblocking") {
+      // Connections are multiplexed over a few event-driven I/O threads and
+      // requests are run on a bounded pool of workers, so idle connections
+      // cost a socket and a buffer instead of a thread.  Requests on one
+      // connection are still processed one at a time.
+      int32_t workers = get_i32("ThriftBroker.Workers");
+      int32_t io_threads = get_i32("ThriftBroker.IOThreads");
+
+      // TNonblockingServer has no per-connection socket timeout
+      if (has("thrift-timeout"))
+        HT_WARN("ThriftBroker.Timeout is ignored by the nonblocking server, "
+                "idle connections are never closed");
+
+      g_thread_manager =
+        concurrency::ThreadManager::newSimpleThreadManager(workers);
+      g_thread_manager->threadFactory(
+        boost::shared_ptr<concurrency::PosixThreadFactory>(
+          new concurrency::PosixThreadFactory()));
+      g_thread_manager->start();
+
+      TNonblockingServer server(hql_service_processor_factory,
+                                protocolFactory, port, g_thread_manager);
+      server.setNumIOThreads(io_threads);
+
+      HT_INFOF("Starting the nonblocking server (%d I/O threads, %d workers)...",
+               (int)io_threads, (int)workers);
+
+      server.serve();
 
-    if (has("thrift-timeout")) {
-      int timeout_ms = get_i32("thrift-timeout");
-      serverTransport.reset( new TServerSocket(port, timeout_ms, timeout_ms) );
+      g_thread_manager->stop();
+      g_thread_manager.reset();
     }
-    else
-      serverTransport.reset( new TServerSocket(port) );
+    else if (server_mode == "threaded") {
+      boost::shared_ptr<TServerTransport> serverTransport;
+
+      if (has("thrift-timeout")) {
+        int timeout_ms = get_i32("thrift-timeout");
+        serverTransport.reset( new TServerSocket(port, timeout_ms, timeout_ms) );
+      }
+      else
+        serverTransport.reset( new TServerSocket(port) );
 
-    boost::shared_ptr<TTransportFactory> transportFactory(new TFramedTransportFactory());
+      boost::shared_ptr<TTransportFactory> transportFactory(new TFramedTransportFactory());
 
-    TThreadedServer server(hql_service_processor_factory, serverTransport,
-                           transportFactory, protocolFactory);
+      TThreadedServer server(hql_service_processor_factory, serverTransport,
+                             transportFactory, protocolFactory);
 
-    HT_INFO("Starting the server...");
+      HT_INFO("Starting the server...");
 
-    server.serve();
+      server.serve();
+    }
+    else
+      HT_THROWF(Error::CONFIG_BAD_VALUE, "Unrecognized ThriftBroker.Server "
+                "value '%s'", server_mode.c_str());
 
     g_metrics_handler->start_collecting();
     g_metrics_handler.reset();
@@ -35,6 +35,22 @@ const char* _kColumnPredicateOperationNames[] = {
 };
 const std::map<int, const char*> _ColumnPredicateOperation_VALUES_TO_NAMES(::apache::thrift::TEnumIterator(8, _kColumnPredicateOperationValues, _kColumnPredicateOperationNames), ::apache::thrift::TEnumIterator(-1, NULL, NULL));
 
+int _kAggregateFunctionValues[] = {
+  AggregateFunction::NONE,
+  AggregateFunction::COUNT,
+  AggregateFunction::SUM,
+  AggregateFunction::MIN,
+  AggregateFunction::MAX
+};
+const char* _kAggregateFunctionNames[] = {
+  "NONE",
+  "COUNT",
+  "SUM",
+  "MIN",
+  "MAX"
+};
+const std::map<int, const char*> _AggregateFunction_VALUES_TO_NAMES(::apache::thrift::TEnumIterator(5, _kAggregateFunctionValues, _kAggregateFunctionNames), ::apache::thrift::TEnumIterator(-1, NULL, NULL));
+
 int _kKeyFlagValues[] = {
   KeyFlag::DELETE_ROW,
   KeyFlag::DELETE_CF,
@@ -737,6 +753,16 @@ void ScanSpec::__set_and_column_predicates(const bool val) {
 __isset.and_column_predicates = true;
 }
 
+void ScanSpec::__set_aggregate(const int32_t val) {
+  this->aggregate = val;
+__isset.aggregate = true;
+}
+
+void ScanSpec::__set_aggregate_row_prefix_length(const int32_t val) {
+  this->aggregate_row_prefix_length = val;
+__isset.aggregate_row_prefix_length = true;
+}
+
 const char* ScanSpec::ascii_fingerprint = "4EE9E1400F577912865B8356468C09E0";
 const uint8_t ScanSpec::binary_fingerprint[16] = {0x4E,0xE9,0xE1,0x40,0x0F,0x57,0x79,0x12,0x86,0x5B,0x83,0x56,0x46,0x8C,0x09,0xE0};
 
@@ -960,6 +986,22 @@ uint32_t ScanSpec::read(::apache::thrift::protocol::TProtocol* iprot) {
           xfer += iprot->skip(ftype);
         }
         break;
+      case 20:
+        if (ftype == ::apache::thrift::protocol::T_I32) {
+          xfer += iprot->readI32(this->aggregate);
+          this->__isset.aggregate = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 21:
+        if (ftype == ::apache::thrift::protocol::T_I32) {
+          xfer += iprot->readI32(this->aggregate_row_prefix_length);
+          this->__isset.aggregate_row_prefix_length = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
       default:
         xfer += iprot->skip(ftype);
         break;
@@ -1104,6 +1146,16 @@ uint32_t ScanSpec::write(::apache::thrift::protocol::TProtocol* oprot) const {
     xfer += oprot->writeBool(this->and_column_predicates);
     xfer += oprot->writeFieldEnd();
   }
+  if (this->__isset.aggregate) {
+    xfer += oprot->writeFieldBegin("aggregate", ::apache::thrift::protocol::T_I32, 20);
+    xfer += oprot->writeI32(this->aggregate);
+    xfer += oprot->writeFieldEnd();
+  }
+  if (this->__isset.aggregate_row_prefix_length) {
+    xfer += oprot->writeFieldBegin("aggregate_row_prefix_length", ::apache::thrift::protocol::T_I32, 21);
+    xfer += oprot->writeI32(this->aggregate_row_prefix_length);
+    xfer += oprot->writeFieldEnd();
+  }
   xfer += oprot->writeFieldStop();
   xfer += oprot->writeStructEnd();
   oprot->decrementRecursionDepth();
@@ -1131,6 +1183,8 @@ void swap(ScanSpec &a, ScanSpec &b) {
   swap(a.column_predicates, b.column_predicates);
   swap(a.do_not_cache, b.do_not_cache);
   swap(a.and_column_predicates, b.and_column_predicates);
+  swap(a.aggregate, b.aggregate);
+  swap(a.aggregate_row_prefix_length, b.aggregate_row_prefix_length);
   swap(a.__isset, b.__isset);
 }
 
@@ -1154,6 +1208,8 @@ ScanSpec::ScanSpec(const ScanSpec& other30) {
   column_predicates = other30.column_predicates;
   do_not_cache = other30.do_not_cache;
   and_column_predicates = other30.and_column_predicates;
+  aggregate = other30.aggregate;
+  aggregate_row_prefix_length = other30.aggregate_row_prefix_length;
   __isset = other30.__isset;
 }
 ScanSpec& ScanSpec::operator=(const ScanSpec& other31) {
@@ -1176,6 +1232,8 @@ ScanSpec& ScanSpec::operator=(const ScanSpec& other31) {
   column_predicates = other31.column_predicates;
   do_not_cache = other31.do_not_cache;
   and_column_predicates = other31.and_column_predicates;
+  aggregate = other31.aggregate;
+  aggregate_row_prefix_length = other31.aggregate_row_prefix_length;
   __isset = other31.__isset;
   return *this;
 }
@@ -1201,6 +1259,8 @@ std::ostream& operator<<(std::ostream& out, const ScanSpec& obj) {
   out << ", " << "column_predicates="; (obj.__isset.column_predicates ? (out << to_string(obj.column_predicates)) : (out << "<null>"));
   out << ", " << "do_not_cache="; (obj.__isset.do_not_cache ? (out << to_string(obj.do_not_cache)) : (out << "<null>"));
   out << ", " << "and_column_predicates="; (obj.__isset.and_column_predicates ? (out << to_string(obj.and_column_predicates)) : (out << "<null>"));
+  out << ", " << "aggregate="; (obj.__isset.aggregate ? (out << to_string(obj.aggregate)) : (out << "<null>"));
+  out << ", " << "aggregate_row_prefix_length="; (obj.__isset.aggregate_row_prefix_length ? (out << to_string(obj.aggregate_row_prefix_length)) : (out << "<null>"));
   out << ")";
   return out;
 }
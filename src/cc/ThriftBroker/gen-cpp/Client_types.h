@@ -34,6 +34,18 @@ struct ColumnPredicateOperation {
 
 extern const std::map<int, const char*> _ColumnPredicateOperation_VALUES_TO_NAMES;
 
+struct AggregateFunction {
+  enum type {
+    NONE = 0,
+    COUNT = 1,
+    SUM = 2,
+    MIN = 3,
+    MAX = 4
+  };
+};
+
+extern const std::map<int, const char*> _AggregateFunction_VALUES_TO_NAMES;
+
 struct KeyFlag {
   enum type {
     DELETE_ROW = 0,
@@ -361,7 +373,7 @@ class ColumnPredicate {
 void swap(ColumnPredicate &a, ColumnPredicate &b);
 
 typedef struct _ScanSpec__isset {
-  _ScanSpec__isset() : row_intervals(false), cell_intervals(false), return_deletes(true), versions(true), row_limit(true), start_time(false), end_time(false), columns(false), keys_only(true), cell_limit(true), cell_limit_per_family(true), row_regexp(false), value_regexp(false), scan_and_filter_rows(true), row_offset(true), cell_offset(true), column_predicates(false), do_not_cache(true), and_column_predicates(true) {}
+  _ScanSpec__isset() : row_intervals(false), cell_intervals(false), return_deletes(true), versions(true), row_limit(true), start_time(false), end_time(false), columns(false), keys_only(true), cell_limit(true), cell_limit_per_family(true), row_regexp(false), value_regexp(false), scan_and_filter_rows(true), row_offset(true), cell_offset(true), column_predicates(false), do_not_cache(true), and_column_predicates(true), aggregate(true), aggregate_row_prefix_length(true) {}
   bool row_intervals :1;
   bool cell_intervals :1;
   bool return_deletes :1;
@@ -381,6 +393,8 @@ typedef struct _ScanSpec__isset {
   bool column_predicates :1;
   bool do_not_cache :1;
   bool and_column_predicates :1;
+  bool aggregate :1;
+  bool aggregate_row_prefix_length :1;
 } _ScanSpec__isset;
 
 class ScanSpec {
@@ -391,7 +405,7 @@ class ScanSpec {
 
   ScanSpec(const ScanSpec&);
   ScanSpec& operator=(const ScanSpec&);
-  ScanSpec() : return_deletes(false), versions(0), row_limit(0), start_time(0), end_time(0), keys_only(false), cell_limit(0), cell_limit_per_family(0), row_regexp(), value_regexp(), scan_and_filter_rows(false), row_offset(0), cell_offset(0), do_not_cache(false), and_column_predicates(false) {
+  ScanSpec() : return_deletes(false), versions(0), row_limit(0), start_time(0), end_time(0), keys_only(false), cell_limit(0), cell_limit_per_family(0), row_regexp(), value_regexp(), scan_and_filter_rows(false), row_offset(0), cell_offset(0), do_not_cache(false), and_column_predicates(false), aggregate(0), aggregate_row_prefix_length(-1) {
   }
 
   virtual ~ScanSpec() throw();
@@ -414,6 +428,8 @@ class ScanSpec {
   std::vector<ColumnPredicate>  column_predicates;
   bool do_not_cache;
   bool and_column_predicates;
+  int32_t aggregate;
+  int32_t aggregate_row_prefix_length;
 
   _ScanSpec__isset __isset;
 
@@ -455,6 +471,10 @@ class ScanSpec {
 
   void __set_and_column_predicates(const bool val);
 
+  void __set_aggregate(const int32_t val);
+
+  void __set_aggregate_row_prefix_length(const int32_t val);
+
   bool operator == (const ScanSpec & rhs) const
   {
     if (__isset.row_intervals != rhs.__isset.row_intervals)
@@ -533,6 +553,14 @@ class ScanSpec {
       return false;
     else if (__isset.and_column_predicates && !(and_column_predicates == rhs.and_column_predicates))
       return false;
+    if (__isset.aggregate != rhs.__isset.aggregate)
+      return false;
+    else if (__isset.aggregate && !(aggregate == rhs.aggregate))
+      return false;
+    if (__isset.aggregate_row_prefix_length != rhs.__isset.aggregate_row_prefix_length)
+      return false;
+    else if (__isset.aggregate_row_prefix_length && !(aggregate_row_prefix_length == rhs.aggregate_row_prefix_length))
+      return false;
     return true;
   }
   bool operator != (const ScanSpec &rhs) const {
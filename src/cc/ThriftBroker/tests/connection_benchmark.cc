@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <ThriftBroker/Client.h>
+
+#include <Common/Logger.h>
+#include <Common/Stopwatch.h>
+#include <Common/Usage.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *usage[] = {
+    "usage: connection_benchmark [options]",
+    "",
+    "  --host=<name>         ThriftBroker host (default localhost)",
+    "  --port=<n>            ThriftBroker port (default 15867)",
+    "  --connections=<n>     Number of connections held open (default 1000)",
+    "  --active=<n>          Number of connections issuing requests (default 16)",
+    "  --requests=<n>        Requests issued per active connection (default 1000)",
+    "  --broker-pid=<pid>    Report the thread count of this process",
+    "",
+    "  This program measures how the ThriftBroker scales with the number of",
+    "  open connections.  It opens <connections> connections, issues one",
+    "  request on each so the broker sets up its per-connection state, and",
+    "  then issues <requests> namespace_exists() requests on each of <active>",
+    "  connections concurrently while the others sit idle.  It reports the",
+    "  connection setup time, request throughput and latency percentiles, and",
+    "  the broker thread count before and after the connections were opened",
+    "  when --broker-pid is given.  Compare a broker started with",
+    "  ThriftBroker.Server=threaded against one started with",
+    "  ThriftBroker.Server=nonblocking.  The open file limit (ulimit -n) of",
+    "  both this program and the broker must exceed <connections>.",
+    (const char *)0
+  };
+
+  /// Returns the thread count of a process, or -1 if it can't be read
+  int thread_count(int pid) {
+    if (pid <= 0)
+      return -1;
+    ifstream in(string("/proc/") + to_string(pid) + "/status");
+    string line;
+    while (getline(in, line)) {
+      if (!line.compare(0, 8, "Threads:"))
+        return atoi(line.c_str() + 8);
+    }
+    return -1;
+  }
+
+  void issue_requests(Thrift::Client *client, size_t requests,
+                      vector<double> &latencies) {
+    latencies.reserve(requests);
+    for (size_t i=0; i<requests; i++) {
+      Stopwatch stopwatch;
+      client->namespace_exists("sys");
+      stopwatch.stop();
+      latencies.push_back(stopwatch.elapsed());
+    }
+  }
+
+  double percentile(vector<double> &sorted, double p) {
+    if (sorted.empty())
+      return 0.0;
+    size_t i = (size_t)(p * (sorted.size() - 1));
+    return sorted[i];
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  string host = "localhost";
+  int port = 15867;
+  size_t connections = 1000;
+  size_t active = 16;
+  size_t requests = 1000;
+  int broker_pid = 0;
+
+  for (int i=1; i<argc; i++) {
+    if (!strncmp(argv[i], "--host=", 7))
+      host = &argv[i][7];
+    else if (!strncmp(argv[i], "--port=", 7))
+      port = atoi(&argv[i][7]);
+    else if (!strncmp(argv[i], "--connections=", 14))
+      connections = (size_t)atoi(&argv[i][14]);
+    else if (!strncmp(argv[i], "--active=", 9))
+      active = (size_t)atoi(&argv[i][9]);
+    else if (!strncmp(argv[i], "--requests=", 11))
+      requests = (size_t)atoi(&argv[i][11]);
+    else if (!strncmp(argv[i], "--broker-pid=", 13))
+      broker_pid = atoi(&argv[i][13]);
+    else
+      Usage::dump_and_exit(usage);
+  }
+
+  active = std::min(active, connections);
+
+  try {
+    vector<unique_ptr<Thrift::Client>> clients;
+    int threads_before = thread_count(broker_pid);
+
+    Stopwatch setup_timer;
+    for (size_t i=0; i<connections; i++) {
+      clients.push_back(make_unique<Thrift::Client>(host, port));
+      clients.back()->namespace_exists("sys");
+    }
+    setup_timer.stop();
+
+    int threads_open = thread_count(broker_pid);
+
+    vector<vector<double>> latencies(active);
+    vector<thread> threads;
+    Stopwatch request_timer;
+    for (size_t i=0; i<active; i++)
+      threads.push_back(thread(issue_requests, clients[i].get(), requests,
+                               std::ref(latencies[i])));
+    for (auto &t : threads)
+      t.join();
+    request_timer.stop();
+
+    vector<double> all;
+    for (auto &l : latencies)
+      all.insert(all.end(), l.begin(), l.end());
+    sort(all.begin(), all.end());
+
+    cout << connections << " connections opened in "
+         << setup_timer.elapsed() << " s" << endl;
+    cout << active << " active connections: "
+         << (double)all.size() / request_timer.elapsed() << " requests/s"
+         << endl;
+    cout << "latency (ms): p50=" << percentile(all, 0.5)*1000.0
+         << " p99=" << percentile(all, 0.99)*1000.0
+         << " max=" << percentile(all, 1.0)*1000.0 << endl;
+    if (broker_pid > 0)
+      cout << "broker threads: " << threads_before << " before, "
+           << threads_open << " with connections open" << endl;
+
+    clients.clear();
+  }
+  catch (ThriftGen::ClientException &e) {
+    HT_ERROR_OUT << e.message << HT_END;
+    return 1;
+  }
+  catch (std::exception &e) {
+    HT_ERROR_OUT << e.what() << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
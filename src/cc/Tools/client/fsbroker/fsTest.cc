@@ -132,6 +132,28 @@ namespace {
     HT_ASSERT(strcmp(buf, magic) == 0);
     client->close(fd);
   }
+
+  void test_preadv(FsBroker::Lib::ClientPtr &client, const string &testdir) {
+    vector<Filesystem::Extent> extents;
+    extents.push_back(Filesystem::Extent(1000, 4096));
+    extents.push_back(Filesystem::Extent(5096, 100));
+    extents.push_back(Filesystem::Extent(100000, 777));
+    extents.push_back(Filesystem::Extent(0, 512));
+    size_t total = 0;
+    for (auto &extent : extents)
+      total += extent.length;
+    vector<uint8_t> preadv_buf(total), pread_buf(total);
+    int fd = client->open(testdir + "/output.a", 0);
+    HT_ASSERT(client->preadv(fd, extents, preadv_buf.data(), false) == total);
+    uint8_t *ptr = pread_buf.data();
+    for (auto &extent : extents) {
+      HT_ASSERT(client->pread(fd, ptr, extent.length, extent.offset, false) ==
+                extent.length);
+      ptr += extent.length;
+    }
+    HT_ASSERT(preadv_buf == pread_buf);
+    client->close(fd);
+  }
 }
 
 
@@ -171,6 +193,8 @@ int main(int argc, char **argv) {
 
     test_rename(client, testdir);
 
+    test_preadv(client, testdir);
+
     client->rmdir(testdir);
   }
   catch (Exception &e) {
@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <FsBroker/Lib/ShortCircuitClient.h>
+
+#include <AsyncComm/ConnectionManager.h>
+#include <AsyncComm/DispatchHandler.h>
+#include <AsyncComm/Protocol.h>
+#include <AsyncComm/ReactorFactory.h>
+
+#include <Common/Config.h>
+#include <Common/Error.h>
+#include <Common/Init.h>
+#include <Common/Logger.h>
+#include <Common/StaticBuffer.h>
+#include <Common/Usage.h>
+
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <unistd.h>
+}
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+  const char *usage[] = {
+    "usage: shortCircuitTest",
+    "",
+    "  This program tests the short-circuit FS broker client.  It writes a",
+    "  file with asynchronous appends, checks that the responses are",
+    "  delivered off the calling thread in the order the appends were",
+    "  issued, reads the file back through the broker, and then reads it",
+    "  with synchronous and asynchronous preads and preadvs, with and",
+    "  without checksum verification and direct i/o.  It assumes the local",
+    "  broker is listening on FsBroker.Port and that FsBroker.Local.Root",
+    "  names its root directory.",
+    (const char *)0
+  };
+
+  /// Handler collecting response events.
+  class ResponseCollector : public DispatchHandler {
+  public:
+    void handle(EventPtr &event) override {
+      lock_guard<mutex> lock(m_mutex);
+      HT_ASSERT(this_thread::get_id() != m_caller);
+      m_events.push_back(event);
+      m_cond.notify_all();
+    }
+    vector<EventPtr> &wait_for(size_t count) {
+      unique_lock<mutex> lock(m_mutex);
+      m_cond.wait(lock, [this, count](){ return m_events.size() >= count; });
+      return m_events;
+    }
+  private:
+    mutex m_mutex;
+    condition_variable m_cond;
+    vector<EventPtr> m_events;
+    thread::id m_caller {this_thread::get_id()};
+  };
+
+  const int CHUNKS = 200;
+
+  String chunk(int i) {
+    return format("chunk %05d of the short-circuit test file\n", i);
+  }
+
+  void test_append(FsBroker::Lib::ClientPtr &client,
+                   FsBroker::Lib::ClientPtr &sc_client, const String &fname,
+                   String &contents) {
+    ResponseCollector collector;
+    int fd = sc_client->create(fname, Filesystem::OPEN_FLAG_OVERWRITE,
+                               -1, -1, -1);
+    for (int i=0; i<CHUNKS; i++) {
+      String data = chunk(i);
+      StaticBuffer buf(data.length());
+      memcpy(buf.base, data.c_str(), data.length());
+      sc_client->append(fd, buf, Filesystem::Flags::NONE, &collector);
+      contents += data;
+    }
+    sc_client->close(fd, &collector);
+
+    // Appends complete in the order they were issued, followed by the close
+    vector<EventPtr> &events = collector.wait_for(CHUNKS + 1);
+    uint64_t expected_offset {};
+    for (int i=0; i<CHUNKS; i++) {
+      uint64_t offset;
+      uint32_t amount;
+      sc_client->decode_response_append(events[i], &offset, &amount);
+      HT_ASSERT(offset == expected_offset);
+      HT_ASSERT(amount == chunk(i).length());
+      expected_offset += amount;
+    }
+    HT_ASSERT(Protocol::response_code(events[CHUNKS]) == Error::OK);
+
+    // The broker sees the same file
+    HT_ASSERT(client->length(fname, false) == (int64_t)contents.length());
+    vector<char> buf(contents.length());
+    fd = client->open(fname, 0);
+    HT_ASSERT(client->read(fd, buf.data(), buf.size()) == buf.size());
+    client->close(fd);
+    HT_ASSERT(String(buf.data(), buf.size()) == contents);
+  }
+
+  void test_read(FsBroker::Lib::ClientPtr &sc_client, const String &fname,
+                 const String &contents, uint32_t flags) {
+    vector<Filesystem::Extent> extents;
+    extents.push_back(Filesystem::Extent(1000, 4096));
+    extents.push_back(Filesystem::Extent(5096, 100));
+    extents.push_back(Filesystem::Extent(7, 777));
+    extents.push_back(Filesystem::Extent(contents.length() - 10, 512));
+
+    int fd = sc_client->open(fname, flags);
+
+    // Synchronous reads into unaligned buffers
+    vector<char> buf(8192);
+    for (auto verify_checksum : { false, true }) {
+      for (auto &extent : extents) {
+        size_t nread = sc_client->pread(fd, buf.data() + 1, extent.length,
+                                        extent.offset, verify_checksum);
+        HT_ASSERT(String(buf.data() + 1, nread) ==
+                  contents.substr(extent.offset, extent.length));
+      }
+    }
+
+    // Asynchronous reads
+    ResponseCollector collector;
+    for (auto &extent : extents)
+      sc_client->pread(fd, extent.length, extent.offset, true, &collector);
+    sc_client->preadv(fd, extents, false, &collector);
+
+    vector<EventPtr> &events = collector.wait_for(extents.size() + 1);
+    for (size_t i=0; i<extents.size(); i++) {
+      const void *data;
+      uint64_t offset;
+      uint32_t length;
+      sc_client->decode_response_pread(events[i], &data, &offset, &length);
+      HT_ASSERT(offset == extents[i].offset);
+      HT_ASSERT(String((const char *)data, length) ==
+                contents.substr(extents[i].offset, extents[i].length));
+    }
+
+    vector<Filesystem::Extent> extents_read;
+    vector<const void *> buffers;
+    sc_client->decode_response_preadv(events.back(), extents_read, buffers);
+    HT_ASSERT(extents_read.size() == extents.size());
+    for (size_t i=0; i<extents.size(); i++)
+      HT_ASSERT(String((const char *)buffers[i], extents_read[i].length) ==
+                contents.substr(extents[i].offset, extents[i].length));
+
+    sc_client->close(fd);
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  try {
+    ConnectionManagerPtr conn_mgr;
+    FsBroker::Lib::ClientPtr client, sc_client, sc_directio_client;
+
+    Config::init(argc, argv);
+
+    if (Config::has("help"))
+      Usage::dump_and_exit(usage);
+
+    ReactorFactory::initialize(2);
+
+    conn_mgr = make_shared<ConnectionManager>();
+    client = make_shared<FsBroker::Lib::Client>(conn_mgr, Config::properties);
+
+    if (!client->wait_for_connection(15000)) {
+      HT_ERROR("Unable to connect to DFS");
+      return 1;
+    }
+
+    sc_client = make_shared<FsBroker::Lib::ShortCircuitClient>(conn_mgr,
+                                                               Config::properties);
+
+    Config::properties->set("FsBroker.Local.DirectIO", true);
+    sc_directio_client =
+      make_shared<FsBroker::Lib::ShortCircuitClient>(conn_mgr,
+                                                     Config::properties);
+
+    String testdir = format("/shortCircuitTest%d", (int)getpid());
+    String fname = testdir + "/file";
+    String contents;
+
+    client->mkdirs(testdir);
+
+    test_append(client, sc_client, fname, contents);
+
+    test_read(sc_client, fname, contents, 0);
+
+    test_read(sc_directio_client, fname, contents,
+              Filesystem::OPEN_FLAG_DIRECTIO);
+
+    client->rmdir(testdir);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}